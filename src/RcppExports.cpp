@@ -11,9 +11,26 @@ Rcpp::Rostream<true>&  Rcpp::Rcout = Rcpp::Rcpp_cout_get();
 Rcpp::Rostream<false>& Rcpp::Rcerr = Rcpp::Rcpp_cerr_get();
 #endif
 
+// benchmark_hot_paths
+Rcpp::DataFrame benchmark_hot_paths(const int n, const int p, const int num_categories, const double density, const int reps, const int threads, const int seed);
+RcppExport SEXP _bgms_benchmark_hot_paths(SEXP nSEXP, SEXP pSEXP, SEXP num_categoriesSEXP, SEXP densitySEXP, SEXP repsSEXP, SEXP threadsSEXP, SEXP seedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const int >::type n(nSEXP);
+    Rcpp::traits::input_parameter< const int >::type p(pSEXP);
+    Rcpp::traits::input_parameter< const int >::type num_categories(num_categoriesSEXP);
+    Rcpp::traits::input_parameter< const double >::type density(densitySEXP);
+    Rcpp::traits::input_parameter< const int >::type reps(repsSEXP);
+    Rcpp::traits::input_parameter< const int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< const int >::type seed(seedSEXP);
+    rcpp_result_gen = Rcpp::wrap(benchmark_hot_paths(n, p, num_categories, density, reps, threads, seed));
+    return rcpp_result_gen;
+END_RCPP
+}
 // run_bgmCompare_parallel
-Rcpp::List run_bgmCompare_parallel(const arma::imat& observations, int num_groups, const std::vector<arma::imat>& counts_per_category, const std::vector<arma::imat>& blume_capel_stats, const std::vector<arma::mat>& pairwise_stats, const arma::ivec& num_categories, double main_alpha, double main_beta, double pairwise_scale, const arma::mat& pairwise_scaling_factors, double difference_scale, double difference_selection_alpha, double difference_selection_beta, double difference_selection_alpha_between, double difference_selection_beta_between, double difference_dirichlet_alpha, double difference_lambda, const std::string& difference_prior, int iter, int warmup, bool na_impute, const arma::imat& missing_data_indices, const arma::uvec& is_ordinal_variable, const arma::ivec& baseline_category, bool difference_selection, bool main_difference_selection, const arma::imat& main_effect_indices, const arma::imat& pairwise_effect_indices, double target_accept, int nuts_max_depth, bool learn_mass_matrix, const arma::mat& projection, const arma::ivec& group_membership, const arma::imat& group_indices, const arma::imat& interaction_index_matrix, const arma::mat& inclusion_probability, int num_chains, int nThreads, int seed, const std::string& update_method, int progress_type, const std::string& interaction_prior_type_str, const std::string& threshold_prior_type_str, double threshold_scale, SEXP progress_callback);
-RcppExport SEXP _bgms_run_bgmCompare_parallel(SEXP observationsSEXP, SEXP num_groupsSEXP, SEXP counts_per_categorySEXP, SEXP blume_capel_statsSEXP, SEXP pairwise_statsSEXP, SEXP num_categoriesSEXP, SEXP main_alphaSEXP, SEXP main_betaSEXP, SEXP pairwise_scaleSEXP, SEXP pairwise_scaling_factorsSEXP, SEXP difference_scaleSEXP, SEXP difference_selection_alphaSEXP, SEXP difference_selection_betaSEXP, SEXP difference_selection_alpha_betweenSEXP, SEXP difference_selection_beta_betweenSEXP, SEXP difference_dirichlet_alphaSEXP, SEXP difference_lambdaSEXP, SEXP difference_priorSEXP, SEXP iterSEXP, SEXP warmupSEXP, SEXP na_imputeSEXP, SEXP missing_data_indicesSEXP, SEXP is_ordinal_variableSEXP, SEXP baseline_categorySEXP, SEXP difference_selectionSEXP, SEXP main_difference_selectionSEXP, SEXP main_effect_indicesSEXP, SEXP pairwise_effect_indicesSEXP, SEXP target_acceptSEXP, SEXP nuts_max_depthSEXP, SEXP learn_mass_matrixSEXP, SEXP projectionSEXP, SEXP group_membershipSEXP, SEXP group_indicesSEXP, SEXP interaction_index_matrixSEXP, SEXP inclusion_probabilitySEXP, SEXP num_chainsSEXP, SEXP nThreadsSEXP, SEXP seedSEXP, SEXP update_methodSEXP, SEXP progress_typeSEXP, SEXP interaction_prior_type_strSEXP, SEXP threshold_prior_type_strSEXP, SEXP threshold_scaleSEXP, SEXP progress_callbackSEXP) {
+Rcpp::List run_bgmCompare_parallel(const arma::imat& observations, int num_groups, const std::vector<arma::imat>& counts_per_category, const std::vector<arma::imat>& blume_capel_stats, const std::vector<arma::mat>& pairwise_stats, const arma::ivec& num_categories, double main_alpha, double main_beta, double pairwise_scale, const arma::mat& pairwise_scaling_factors, double difference_scale, double difference_selection_alpha, double difference_selection_beta, double difference_selection_alpha_between, double difference_selection_beta_between, double difference_dirichlet_alpha, double difference_lambda, const std::string& difference_prior, int iter, int warmup, bool na_impute, const arma::imat& missing_data_indices, const arma::uvec& is_ordinal_variable, const arma::ivec& baseline_category, bool difference_selection, bool main_difference_selection, const arma::imat& main_effect_indices, const arma::imat& pairwise_effect_indices, double target_accept, int nuts_max_depth, bool learn_mass_matrix, const arma::mat& projection, const arma::ivec& group_membership, const arma::imat& group_indices, const arma::imat& interaction_index_matrix, const arma::mat& inclusion_probability, int num_chains, int nThreads, int seed, const std::string& update_method, int progress_type, const std::string& interaction_prior_type_str, const std::string& threshold_prior_type_str, double threshold_scale, SEXP progress_callback, const Rcpp::Nullable<Rcpp::List> settings);
+RcppExport SEXP _bgms_run_bgmCompare_parallel(SEXP observationsSEXP, SEXP num_groupsSEXP, SEXP counts_per_categorySEXP, SEXP blume_capel_statsSEXP, SEXP pairwise_statsSEXP, SEXP num_categoriesSEXP, SEXP main_alphaSEXP, SEXP main_betaSEXP, SEXP pairwise_scaleSEXP, SEXP pairwise_scaling_factorsSEXP, SEXP difference_scaleSEXP, SEXP difference_selection_alphaSEXP, SEXP difference_selection_betaSEXP, SEXP difference_selection_alpha_betweenSEXP, SEXP difference_selection_beta_betweenSEXP, SEXP difference_dirichlet_alphaSEXP, SEXP difference_lambdaSEXP, SEXP difference_priorSEXP, SEXP iterSEXP, SEXP warmupSEXP, SEXP na_imputeSEXP, SEXP missing_data_indicesSEXP, SEXP is_ordinal_variableSEXP, SEXP baseline_categorySEXP, SEXP difference_selectionSEXP, SEXP main_difference_selectionSEXP, SEXP main_effect_indicesSEXP, SEXP pairwise_effect_indicesSEXP, SEXP target_acceptSEXP, SEXP nuts_max_depthSEXP, SEXP learn_mass_matrixSEXP, SEXP projectionSEXP, SEXP group_membershipSEXP, SEXP group_indicesSEXP, SEXP interaction_index_matrixSEXP, SEXP inclusion_probabilitySEXP, SEXP num_chainsSEXP, SEXP nThreadsSEXP, SEXP seedSEXP, SEXP update_methodSEXP, SEXP progress_typeSEXP, SEXP interaction_prior_type_strSEXP, SEXP threshold_prior_type_strSEXP, SEXP threshold_scaleSEXP, SEXP progress_callbackSEXP, SEXP settingsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -62,7 +79,65 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< const std::string& >::type threshold_prior_type_str(threshold_prior_type_strSEXP);
     Rcpp::traits::input_parameter< double >::type threshold_scale(threshold_scaleSEXP);
     Rcpp::traits::input_parameter< SEXP >::type progress_callback(progress_callbackSEXP);
-    rcpp_result_gen = Rcpp::wrap(run_bgmCompare_parallel(observations, num_groups, counts_per_category, blume_capel_stats, pairwise_stats, num_categories, main_alpha, main_beta, pairwise_scale, pairwise_scaling_factors, difference_scale, difference_selection_alpha, difference_selection_beta, difference_selection_alpha_between, difference_selection_beta_between, difference_dirichlet_alpha, difference_lambda, difference_prior, iter, warmup, na_impute, missing_data_indices, is_ordinal_variable, baseline_category, difference_selection, main_difference_selection, main_effect_indices, pairwise_effect_indices, target_accept, nuts_max_depth, learn_mass_matrix, projection, group_membership, group_indices, interaction_index_matrix, inclusion_probability, num_chains, nThreads, seed, update_method, progress_type, interaction_prior_type_str, threshold_prior_type_str, threshold_scale, progress_callback));
+    Rcpp::traits::input_parameter< const Rcpp::Nullable<Rcpp::List> >::type settings(settingsSEXP);
+    rcpp_result_gen = Rcpp::wrap(run_bgmCompare_parallel(observations, num_groups, counts_per_category, blume_capel_stats, pairwise_stats, num_categories, main_alpha, main_beta, pairwise_scale, pairwise_scaling_factors, difference_scale, difference_selection_alpha, difference_selection_beta, difference_selection_alpha_between, difference_selection_beta_between, difference_dirichlet_alpha, difference_lambda, difference_prior, iter, warmup, na_impute, missing_data_indices, is_ordinal_variable, baseline_category, difference_selection, main_difference_selection, main_effect_indices, pairwise_effect_indices, target_accept, nuts_max_depth, learn_mass_matrix, projection, group_membership, group_indices, interaction_index_matrix, inclusion_probability, num_chains, nThreads, seed, update_method, progress_type, interaction_prior_type_str, threshold_prior_type_str, threshold_scale, progress_callback, settings));
+    return rcpp_result_gen;
+END_RCPP
+}
+// test_bgmcompare_residuals
+Rcpp::List test_bgmcompare_residuals(const arma::imat& observations, int num_groups, const std::vector<arma::imat>& counts_per_category, const std::vector<arma::imat>& blume_capel_stats, const std::vector<arma::mat>& pairwise_stats, const arma::ivec& num_categories, const arma::uvec& is_ordinal_variable, const arma::ivec& baseline_category, const arma::imat& main_effect_indices, const arma::imat& pairwise_effect_indices, const arma::mat& projection, const arma::ivec& group_membership, const arma::imat& group_indices, const arma::imat& interaction_index_matrix, const arma::mat& pairwise_scaling_factors, const arma::mat& inclusion_probability, const int iterations, const int seed);
+RcppExport SEXP _bgms_test_bgmcompare_residuals(SEXP observationsSEXP, SEXP num_groupsSEXP, SEXP counts_per_categorySEXP, SEXP blume_capel_statsSEXP, SEXP pairwise_statsSEXP, SEXP num_categoriesSEXP, SEXP is_ordinal_variableSEXP, SEXP baseline_categorySEXP, SEXP main_effect_indicesSEXP, SEXP pairwise_effect_indicesSEXP, SEXP projectionSEXP, SEXP group_membershipSEXP, SEXP group_indicesSEXP, SEXP interaction_index_matrixSEXP, SEXP pairwise_scaling_factorsSEXP, SEXP inclusion_probabilitySEXP, SEXP iterationsSEXP, SEXP seedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::imat& >::type observations(observationsSEXP);
+    Rcpp::traits::input_parameter< int >::type num_groups(num_groupsSEXP);
+    Rcpp::traits::input_parameter< const std::vector<arma::imat>& >::type counts_per_category(counts_per_categorySEXP);
+    Rcpp::traits::input_parameter< const std::vector<arma::imat>& >::type blume_capel_stats(blume_capel_statsSEXP);
+    Rcpp::traits::input_parameter< const std::vector<arma::mat>& >::type pairwise_stats(pairwise_statsSEXP);
+    Rcpp::traits::input_parameter< const arma::ivec& >::type num_categories(num_categoriesSEXP);
+    Rcpp::traits::input_parameter< const arma::uvec& >::type is_ordinal_variable(is_ordinal_variableSEXP);
+    Rcpp::traits::input_parameter< const arma::ivec& >::type baseline_category(baseline_categorySEXP);
+    Rcpp::traits::input_parameter< const arma::imat& >::type main_effect_indices(main_effect_indicesSEXP);
+    Rcpp::traits::input_parameter< const arma::imat& >::type pairwise_effect_indices(pairwise_effect_indicesSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type projection(projectionSEXP);
+    Rcpp::traits::input_parameter< const arma::ivec& >::type group_membership(group_membershipSEXP);
+    Rcpp::traits::input_parameter< const arma::imat& >::type group_indices(group_indicesSEXP);
+    Rcpp::traits::input_parameter< const arma::imat& >::type interaction_index_matrix(interaction_index_matrixSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type pairwise_scaling_factors(pairwise_scaling_factorsSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type inclusion_probability(inclusion_probabilitySEXP);
+    Rcpp::traits::input_parameter< const int >::type iterations(iterationsSEXP);
+    Rcpp::traits::input_parameter< const int >::type seed(seedSEXP);
+    rcpp_result_gen = Rcpp::wrap(test_bgmcompare_residuals(observations, num_groups, counts_per_category, blume_capel_stats, pairwise_stats, num_categories, is_ordinal_variable, baseline_category, main_effect_indices, pairwise_effect_indices, projection, group_membership, group_indices, interaction_index_matrix, pairwise_scaling_factors, inclusion_probability, iterations, seed));
+    return rcpp_result_gen;
+END_RCPP
+}
+// test_cholesky_rank_update
+SEXP test_cholesky_rank_update(arma::mat R, const arma::mat& U, const int num_updates, const bool sequential);
+RcppExport SEXP _bgms_test_cholesky_rank_update(SEXP RSEXP, SEXP USEXP, SEXP num_updatesSEXP, SEXP sequentialSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< arma::mat >::type R(RSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type U(USEXP);
+    Rcpp::traits::input_parameter< const int >::type num_updates(num_updatesSEXP);
+    Rcpp::traits::input_parameter< const bool >::type sequential(sequentialSEXP);
+    rcpp_result_gen = Rcpp::wrap(test_cholesky_rank_update(R, U, num_updates, sequential));
+    return rcpp_result_gen;
+END_RCPP
+}
+// test_compact_scores
+Rcpp::List test_compact_scores(const arma::imat& x, const arma::vec& v, const arma::mat& B, const int set_value, const int panel_rows);
+RcppExport SEXP _bgms_test_compact_scores(SEXP xSEXP, SEXP vSEXP, SEXP BSEXP, SEXP set_valueSEXP, SEXP panel_rowsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::imat& >::type x(xSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type v(vSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type B(BSEXP);
+    Rcpp::traits::input_parameter< const int >::type set_value(set_valueSEXP);
+    Rcpp::traits::input_parameter< const int >::type panel_rows(panel_rowsSEXP);
+    rcpp_result_gen = Rcpp::wrap(test_compact_scores(x, v, B, set_value, panel_rows));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -98,6 +173,62 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// rcpp_vector_exp
+Rcpp::NumericVector rcpp_vector_exp(const arma::vec& x);
+RcppExport SEXP _bgms_rcpp_vector_exp(SEXP xSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::vec& >::type x(xSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_vector_exp(x));
+    return rcpp_result_gen;
+END_RCPP
+}
+// rcpp_vector_log
+Rcpp::NumericVector rcpp_vector_log(const arma::vec& x);
+RcppExport SEXP _bgms_rcpp_vector_log(SEXP xSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::vec& >::type x(xSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_vector_log(x));
+    return rcpp_result_gen;
+END_RCPP
+}
+// get_simd_explog_isa
+Rcpp::String get_simd_explog_isa();
+RcppExport SEXP _bgms_get_simd_explog_isa() {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    rcpp_result_gen = Rcpp::wrap(get_simd_explog_isa());
+    return rcpp_result_gen;
+END_RCPP
+}
+// test_categorical
+Rcpp::List test_categorical(const arma::mat& log_weights, const arma::vec& uniforms);
+RcppExport SEXP _bgms_test_categorical(SEXP log_weightsSEXP, SEXP uniformsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::mat& >::type log_weights(log_weightsSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type uniforms(uniformsSEXP);
+    rcpp_result_gen = Rcpp::wrap(test_categorical(log_weights, uniforms));
+    return rcpp_result_gen;
+END_RCPP
+}
+// benchmark_explog_kernels
+Rcpp::DataFrame benchmark_explog_kernels(const int n, const int reps);
+RcppExport SEXP _bgms_benchmark_explog_kernels(SEXP nSEXP, SEXP repsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const int >::type n(nSEXP);
+    Rcpp::traits::input_parameter< const int >::type reps(repsSEXP);
+    rcpp_result_gen = Rcpp::wrap(benchmark_explog_kernels(n, reps));
+    return rcpp_result_gen;
+END_RCPP
+}
 // ggm_test_logp_and_gradient
 Rcpp::List ggm_test_logp_and_gradient(const arma::vec& theta, const arma::mat& suf_stat, int n, const arma::imat& edge_indicators, double pairwise_scale);
 RcppExport SEXP _bgms_ggm_test_logp_and_gradient(SEXP thetaSEXP, SEXP suf_statSEXP, SEXP nSEXP, SEXP edge_indicatorsSEXP, SEXP pairwise_scaleSEXP) {
@@ -125,6 +256,20 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// benchmark_ggm_gradient
+Rcpp::DataFrame benchmark_ggm_gradient(const Rcpp::IntegerVector& p_values, const double density, const int reps, const int seed);
+RcppExport SEXP _bgms_benchmark_ggm_gradient(SEXP p_valuesSEXP, SEXP densitySEXP, SEXP repsSEXP, SEXP seedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::IntegerVector& >::type p_values(p_valuesSEXP);
+    Rcpp::traits::input_parameter< const double >::type density(densitySEXP);
+    Rcpp::traits::input_parameter< const int >::type reps(repsSEXP);
+    Rcpp::traits::input_parameter< const int >::type seed(seedSEXP);
+    rcpp_result_gen = Rcpp::wrap(benchmark_ggm_gradient(p_values, density, reps, seed));
+    return rcpp_result_gen;
+END_RCPP
+}
 // sample_ggm_prior
 Rcpp::List sample_ggm_prior(int p, int n_samples, int n_warmup, double pairwise_scale, const std::string& interaction_prior_type, const std::string& scale_prior_type, double gamma_shape, double gamma_rate, double step_size, int max_depth, int seed, bool verbose, Rcpp::Nullable<Rcpp::IntegerMatrix> edge_indicators_nullable, double delta);
 RcppExport SEXP _bgms_sample_ggm_prior(SEXP pSEXP, SEXP n_samplesSEXP, SEXP n_warmupSEXP, SEXP pairwise_scaleSEXP, SEXP interaction_prior_typeSEXP, SEXP scale_prior_typeSEXP, SEXP gamma_shapeSEXP, SEXP gamma_rateSEXP, SEXP step_sizeSEXP, SEXP max_depthSEXP, SEXP seedSEXP, SEXP verboseSEXP, SEXP edge_indicators_nullableSEXP, SEXP deltaSEXP) {
@@ -149,6 +294,63 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// ggm_test_impute_missing
+Rcpp::List ggm_test_impute_missing(const arma::mat& observations, const arma::imat& missing_index, int sweeps, int seed);
+RcppExport SEXP _bgms_ggm_test_impute_missing(SEXP observationsSEXP, SEXP missing_indexSEXP, SEXP sweepsSEXP, SEXP seedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::mat& >::type observations(observationsSEXP);
+    Rcpp::traits::input_parameter< const arma::imat& >::type missing_index(missing_indexSEXP);
+    Rcpp::traits::input_parameter< int >::type sweeps(sweepsSEXP);
+    Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
+    rcpp_result_gen = Rcpp::wrap(ggm_test_impute_missing(observations, missing_index, sweeps, seed));
+    return rcpp_result_gen;
+END_RCPP
+}
+// ggm_test_sparse_cholesky
+Rcpp::List ggm_test_sparse_cholesky(const arma::mat& precision, const arma::imat& edge_indicators, const arma::imat& pairs, const arma::ivec& w_index, const arma::vec& w_values, int sigma);
+RcppExport SEXP _bgms_ggm_test_sparse_cholesky(SEXP precisionSEXP, SEXP edge_indicatorsSEXP, SEXP pairsSEXP, SEXP w_indexSEXP, SEXP w_valuesSEXP, SEXP sigmaSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::mat& >::type precision(precisionSEXP);
+    Rcpp::traits::input_parameter< const arma::imat& >::type edge_indicators(edge_indicatorsSEXP);
+    Rcpp::traits::input_parameter< const arma::imat& >::type pairs(pairsSEXP);
+    Rcpp::traits::input_parameter< const arma::ivec& >::type w_index(w_indexSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type w_values(w_valuesSEXP);
+    Rcpp::traits::input_parameter< int >::type sigma(sigmaSEXP);
+    rcpp_result_gen = Rcpp::wrap(ggm_test_sparse_cholesky(precision, edge_indicators, pairs, w_index, w_values, sigma));
+    return rcpp_result_gen;
+END_RCPP
+}
+// test_packed_indicator_trace
+Rcpp::List test_packed_indicator_trace(const arma::imat& draws);
+RcppExport SEXP _bgms_test_packed_indicator_trace(SEXP drawsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::imat& >::type draws(drawsSEXP);
+    rcpp_result_gen = Rcpp::wrap(test_packed_indicator_trace(draws));
+    return rcpp_result_gen;
+END_RCPP
+}
+// test_logz_kernels
+Rcpp::List test_logz_kernels(const arma::vec& residual, const arma::vec& main_param, const int num_cats, const bool ordinal, const int ref, const arma::vec& weights);
+RcppExport SEXP _bgms_test_logz_kernels(SEXP residualSEXP, SEXP main_paramSEXP, SEXP num_catsSEXP, SEXP ordinalSEXP, SEXP refSEXP, SEXP weightsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::vec& >::type residual(residualSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type main_param(main_paramSEXP);
+    Rcpp::traits::input_parameter< const int >::type num_cats(num_catsSEXP);
+    Rcpp::traits::input_parameter< const bool >::type ordinal(ordinalSEXP);
+    Rcpp::traits::input_parameter< const int >::type ref(refSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type weights(weightsSEXP);
+    rcpp_result_gen = Rcpp::wrap(test_logz_kernels(residual, main_param, num_cats, ordinal, ref, weights));
+    return rcpp_result_gen;
+END_RCPP
+}
 // compute_ess_cpp
 Rcpp::NumericVector compute_ess_cpp(Rcpp::NumericVector array3d);
 RcppExport SEXP _bgms_compute_ess_cpp(SEXP array3dSEXP) {
@@ -171,6 +373,30 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// compute_ess_chains_cpp
+Rcpp::NumericVector compute_ess_chains_cpp(Rcpp::List chains, bool param_rows);
+RcppExport SEXP _bgms_compute_ess_chains_cpp(SEXP chainsSEXP, SEXP param_rowsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::List >::type chains(chainsSEXP);
+    Rcpp::traits::input_parameter< bool >::type param_rows(param_rowsSEXP);
+    rcpp_result_gen = Rcpp::wrap(compute_ess_chains_cpp(chains, param_rows));
+    return rcpp_result_gen;
+END_RCPP
+}
+// compute_rhat_chains_cpp
+Rcpp::NumericVector compute_rhat_chains_cpp(Rcpp::List chains, bool param_rows);
+RcppExport SEXP _bgms_compute_rhat_chains_cpp(SEXP chainsSEXP, SEXP param_rowsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::List >::type chains(chainsSEXP);
+    Rcpp::traits::input_parameter< bool >::type param_rows(param_rowsSEXP);
+    rcpp_result_gen = Rcpp::wrap(compute_rhat_chains_cpp(chains, param_rows));
+    return rcpp_result_gen;
+END_RCPP
+}
 // compute_indicator_ess_cpp
 Rcpp::NumericMatrix compute_indicator_ess_cpp(Rcpp::NumericVector array3d);
 RcppExport SEXP _bgms_compute_indicator_ess_cpp(SEXP array3dSEXP) {
@@ -182,6 +408,41 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// compute_indicator_ess_packed_cpp
+Rcpp::NumericMatrix compute_indicator_ess_packed_cpp(Rcpp::List traces);
+RcppExport SEXP _bgms_compute_indicator_ess_packed_cpp(SEXP tracesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::List >::type traces(tracesSEXP);
+    rcpp_result_gen = Rcpp::wrap(compute_indicator_ess_packed_cpp(traces));
+    return rcpp_result_gen;
+END_RCPP
+}
+// compute_file_diagnostics_cpp
+Rcpp::List compute_file_diagnostics_cpp(Rcpp::CharacterVector paths, double memory_mb);
+RcppExport SEXP _bgms_compute_file_diagnostics_cpp(SEXP pathsSEXP, SEXP memory_mbSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::CharacterVector >::type paths(pathsSEXP);
+    Rcpp::traits::input_parameter< double >::type memory_mb(memory_mbSEXP);
+    rcpp_result_gen = Rcpp::wrap(compute_file_diagnostics_cpp(paths, memory_mb));
+    return rcpp_result_gen;
+END_RCPP
+}
+// compute_indicator_ess_files_cpp
+Rcpp::NumericMatrix compute_indicator_ess_files_cpp(Rcpp::CharacterVector paths, double memory_mb);
+RcppExport SEXP _bgms_compute_indicator_ess_files_cpp(SEXP pathsSEXP, SEXP memory_mbSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::CharacterVector >::type paths(pathsSEXP);
+    Rcpp::traits::input_parameter< double >::type memory_mb(memory_mbSEXP);
+    rcpp_result_gen = Rcpp::wrap(compute_indicator_ess_files_cpp(paths, memory_mb));
+    return rcpp_result_gen;
+END_RCPP
+}
 // mixed_test_logp_and_gradient
 Rcpp::List mixed_test_logp_and_gradient(const arma::vec& params, const arma::imat& discrete_observations, const arma::mat& continuous_observations, const arma::ivec& num_categories, const arma::uvec& is_ordinal_variable, const arma::ivec& baseline_category, const arma::imat& edge_indicators, double pairwise_scale, double main_alpha, double main_beta, std::string interaction_prior_type, std::string threshold_prior_type, double threshold_scale, std::string means_prior_type, double means_scale, std::string diagonal_prior_type, double diagonal_shape, double diagonal_rate);
 RcppExport SEXP _bgms_mixed_test_logp_and_gradient(SEXP paramsSEXP, SEXP discrete_observationsSEXP, SEXP continuous_observationsSEXP, SEXP num_categoriesSEXP, SEXP is_ordinal_variableSEXP, SEXP baseline_categorySEXP, SEXP edge_indicatorsSEXP, SEXP pairwise_scaleSEXP, SEXP main_alphaSEXP, SEXP main_betaSEXP, SEXP interaction_prior_typeSEXP, SEXP threshold_prior_typeSEXP, SEXP threshold_scaleSEXP, SEXP means_prior_typeSEXP, SEXP means_scaleSEXP, SEXP diagonal_prior_typeSEXP, SEXP diagonal_shapeSEXP, SEXP diagonal_rateSEXP) {
@@ -316,6 +577,23 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// mixed_test_ggm_ratio
+Rcpp::List mixed_test_ggm_ratio(const arma::imat& discrete_observations, const arma::mat& continuous_observations, const arma::ivec& num_categories, const arma::uvec& is_ordinal_variable, const arma::ivec& baseline_category, int iterations, int seed);
+RcppExport SEXP _bgms_mixed_test_ggm_ratio(SEXP discrete_observationsSEXP, SEXP continuous_observationsSEXP, SEXP num_categoriesSEXP, SEXP is_ordinal_variableSEXP, SEXP baseline_categorySEXP, SEXP iterationsSEXP, SEXP seedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::imat& >::type discrete_observations(discrete_observationsSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type continuous_observations(continuous_observationsSEXP);
+    Rcpp::traits::input_parameter< const arma::ivec& >::type num_categories(num_categoriesSEXP);
+    Rcpp::traits::input_parameter< const arma::uvec& >::type is_ordinal_variable(is_ordinal_variableSEXP);
+    Rcpp::traits::input_parameter< const arma::ivec& >::type baseline_category(baseline_categorySEXP);
+    Rcpp::traits::input_parameter< int >::type iterations(iterationsSEXP);
+    Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
+    rcpp_result_gen = Rcpp::wrap(mixed_test_ggm_ratio(discrete_observations, continuous_observations, num_categories, is_ordinal_variable, baseline_category, iterations, seed));
+    return rcpp_result_gen;
+END_RCPP
+}
 // compute_conditional_ggm
 Rcpp::List compute_conditional_ggm(const arma::mat& observations, const arma::ivec& predict_vars, const arma::mat& precision);
 RcppExport SEXP _bgms_compute_conditional_ggm(SEXP observationsSEXP, SEXP predict_varsSEXP, SEXP precisionSEXP) {
@@ -346,6 +624,24 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// compute_conditional_probs_draws
+Rcpp::List compute_conditional_probs_draws(const arma::imat& observations, const arma::ivec& predict_vars, const arma::mat& pairwise_samples, const arma::mat& main_samples, const arma::ivec& draw_indices, const arma::ivec& num_categories, const Rcpp::StringVector& variable_type, const arma::ivec& baseline_category);
+RcppExport SEXP _bgms_compute_conditional_probs_draws(SEXP observationsSEXP, SEXP predict_varsSEXP, SEXP pairwise_samplesSEXP, SEXP main_samplesSEXP, SEXP draw_indicesSEXP, SEXP num_categoriesSEXP, SEXP variable_typeSEXP, SEXP baseline_categorySEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::imat& >::type observations(observationsSEXP);
+    Rcpp::traits::input_parameter< const arma::ivec& >::type predict_vars(predict_varsSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type pairwise_samples(pairwise_samplesSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type main_samples(main_samplesSEXP);
+    Rcpp::traits::input_parameter< const arma::ivec& >::type draw_indices(draw_indicesSEXP);
+    Rcpp::traits::input_parameter< const arma::ivec& >::type num_categories(num_categoriesSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::StringVector& >::type variable_type(variable_typeSEXP);
+    Rcpp::traits::input_parameter< const arma::ivec& >::type baseline_category(baseline_categorySEXP);
+    rcpp_result_gen = Rcpp::wrap(compute_conditional_probs_draws(observations, predict_vars, pairwise_samples, main_samples, draw_indices, num_categories, variable_type, baseline_category));
+    return rcpp_result_gen;
+END_RCPP
+}
 // compute_conditional_mixed
 Rcpp::List compute_conditional_mixed(const arma::imat& x_observations, const arma::mat& y_observations, const arma::ivec& predict_vars, const arma::mat& pairwise_disc, const arma::mat& pairwise_cross, const arma::mat& pairwise_cont, const arma::mat& mux, const arma::vec& muy, const arma::ivec& num_categories, const Rcpp::StringVector& variable_type, const arma::ivec& baseline_category);
 RcppExport SEXP _bgms_compute_conditional_mixed(SEXP x_observationsSEXP, SEXP y_observationsSEXP, SEXP predict_varsSEXP, SEXP pairwise_discSEXP, SEXP pairwise_crossSEXP, SEXP pairwise_contSEXP, SEXP muxSEXP, SEXP muySEXP, SEXP num_categoriesSEXP, SEXP variable_typeSEXP, SEXP baseline_categorySEXP) {
@@ -367,9 +663,31 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// compute_conditional_mixed_draws
+Rcpp::List compute_conditional_mixed_draws(const arma::imat& x_observations, const arma::mat& y_observations, const arma::ivec& predict_vars, const arma::mat& mux_samples, const arma::mat& disc_samples, const arma::mat& muy_samples, const arma::mat& cont_samples, const arma::mat& cross_samples, const arma::ivec& draw_indices, const arma::ivec& num_categories, const Rcpp::StringVector& variable_type, const arma::ivec& baseline_category);
+RcppExport SEXP _bgms_compute_conditional_mixed_draws(SEXP x_observationsSEXP, SEXP y_observationsSEXP, SEXP predict_varsSEXP, SEXP mux_samplesSEXP, SEXP disc_samplesSEXP, SEXP muy_samplesSEXP, SEXP cont_samplesSEXP, SEXP cross_samplesSEXP, SEXP draw_indicesSEXP, SEXP num_categoriesSEXP, SEXP variable_typeSEXP, SEXP baseline_categorySEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::imat& >::type x_observations(x_observationsSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type y_observations(y_observationsSEXP);
+    Rcpp::traits::input_parameter< const arma::ivec& >::type predict_vars(predict_varsSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type mux_samples(mux_samplesSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type disc_samples(disc_samplesSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type muy_samples(muy_samplesSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type cont_samples(cont_samplesSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type cross_samples(cross_samplesSEXP);
+    Rcpp::traits::input_parameter< const arma::ivec& >::type draw_indices(draw_indicesSEXP);
+    Rcpp::traits::input_parameter< const arma::ivec& >::type num_categories(num_categoriesSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::StringVector& >::type variable_type(variable_typeSEXP);
+    Rcpp::traits::input_parameter< const arma::ivec& >::type baseline_category(baseline_categorySEXP);
+    rcpp_result_gen = Rcpp::wrap(compute_conditional_mixed_draws(x_observations, y_observations, predict_vars, mux_samples, disc_samples, muy_samples, cont_samples, cross_samples, draw_indices, num_categories, variable_type, baseline_category));
+    return rcpp_result_gen;
+END_RCPP
+}
 // sample_omrf_gibbs
-IntegerMatrix sample_omrf_gibbs(int num_states, int num_variables, IntegerVector num_categories, NumericMatrix pairwise, NumericMatrix main, int iter, int seed);
-RcppExport SEXP _bgms_sample_omrf_gibbs(SEXP num_statesSEXP, SEXP num_variablesSEXP, SEXP num_categoriesSEXP, SEXP pairwiseSEXP, SEXP mainSEXP, SEXP iterSEXP, SEXP seedSEXP) {
+IntegerMatrix sample_omrf_gibbs(int num_states, int num_variables, IntegerVector num_categories, NumericMatrix pairwise, NumericMatrix main, int iter, int seed, bool colored, int nThreads);
+RcppExport SEXP _bgms_sample_omrf_gibbs(SEXP num_statesSEXP, SEXP num_variablesSEXP, SEXP num_categoriesSEXP, SEXP pairwiseSEXP, SEXP mainSEXP, SEXP iterSEXP, SEXP seedSEXP, SEXP coloredSEXP, SEXP nThreadsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -380,13 +698,15 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< NumericMatrix >::type main(mainSEXP);
     Rcpp::traits::input_parameter< int >::type iter(iterSEXP);
     Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
-    rcpp_result_gen = Rcpp::wrap(sample_omrf_gibbs(num_states, num_variables, num_categories, pairwise, main, iter, seed));
+    Rcpp::traits::input_parameter< bool >::type colored(coloredSEXP);
+    Rcpp::traits::input_parameter< int >::type nThreads(nThreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(sample_omrf_gibbs(num_states, num_variables, num_categories, pairwise, main, iter, seed, colored, nThreads));
     return rcpp_result_gen;
 END_RCPP
 }
 // sample_bcomrf_gibbs
-IntegerMatrix sample_bcomrf_gibbs(int num_states, int num_variables, IntegerVector num_categories, NumericMatrix pairwise, NumericMatrix main, StringVector variable_type_r, IntegerVector baseline_category, int iter, int seed);
-RcppExport SEXP _bgms_sample_bcomrf_gibbs(SEXP num_statesSEXP, SEXP num_variablesSEXP, SEXP num_categoriesSEXP, SEXP pairwiseSEXP, SEXP mainSEXP, SEXP variable_type_rSEXP, SEXP baseline_categorySEXP, SEXP iterSEXP, SEXP seedSEXP) {
+IntegerMatrix sample_bcomrf_gibbs(int num_states, int num_variables, IntegerVector num_categories, NumericMatrix pairwise, NumericMatrix main, StringVector variable_type_r, IntegerVector baseline_category, int iter, int seed, bool colored, int nThreads);
+RcppExport SEXP _bgms_sample_bcomrf_gibbs(SEXP num_statesSEXP, SEXP num_variablesSEXP, SEXP num_categoriesSEXP, SEXP pairwiseSEXP, SEXP mainSEXP, SEXP variable_type_rSEXP, SEXP baseline_categorySEXP, SEXP iterSEXP, SEXP seedSEXP, SEXP coloredSEXP, SEXP nThreadsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -399,7 +719,9 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< IntegerVector >::type baseline_category(baseline_categorySEXP);
     Rcpp::traits::input_parameter< int >::type iter(iterSEXP);
     Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
-    rcpp_result_gen = Rcpp::wrap(sample_bcomrf_gibbs(num_states, num_variables, num_categories, pairwise, main, variable_type_r, baseline_category, iter, seed));
+    Rcpp::traits::input_parameter< bool >::type colored(coloredSEXP);
+    Rcpp::traits::input_parameter< int >::type nThreads(nThreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(sample_bcomrf_gibbs(num_states, num_variables, num_categories, pairwise, main, variable_type_r, baseline_category, iter, seed, colored, nThreads));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -440,7 +762,7 @@ BEGIN_RCPP
 END_RCPP
 }
 // run_ggm_simulation_parallel
-Rcpp::List run_ggm_simulation_parallel(const arma::mat& pairwise_samples, const arma::mat& main_samples, const arma::ivec& draw_indices, int num_states, int num_variables, const arma::vec& means, int nThreads, int seed, int progress_type);
+Rcpp::NumericVector run_ggm_simulation_parallel(const arma::mat& pairwise_samples, const arma::mat& main_samples, const arma::ivec& draw_indices, int num_states, int num_variables, const arma::vec& means, int nThreads, int seed, int progress_type);
 RcppExport SEXP _bgms_run_ggm_simulation_parallel(SEXP pairwise_samplesSEXP, SEXP main_samplesSEXP, SEXP draw_indicesSEXP, SEXP num_statesSEXP, SEXP num_variablesSEXP, SEXP meansSEXP, SEXP nThreadsSEXP, SEXP seedSEXP, SEXP progress_typeSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
@@ -459,8 +781,8 @@ BEGIN_RCPP
 END_RCPP
 }
 // sample_mixed_mrf_gibbs
-Rcpp::List sample_mixed_mrf_gibbs(int num_states, NumericMatrix pairwise_disc_r, NumericMatrix pairwise_cross_r, NumericMatrix pairwise_cont_r, NumericMatrix mux_r, NumericVector muy_r, IntegerVector num_categories_r, Rcpp::StringVector variable_type_r, IntegerVector baseline_category_r, int iter, int seed);
-RcppExport SEXP _bgms_sample_mixed_mrf_gibbs(SEXP num_statesSEXP, SEXP pairwise_disc_rSEXP, SEXP pairwise_cross_rSEXP, SEXP pairwise_cont_rSEXP, SEXP mux_rSEXP, SEXP muy_rSEXP, SEXP num_categories_rSEXP, SEXP variable_type_rSEXP, SEXP baseline_category_rSEXP, SEXP iterSEXP, SEXP seedSEXP) {
+Rcpp::List sample_mixed_mrf_gibbs(int num_states, NumericMatrix pairwise_disc_r, NumericMatrix pairwise_cross_r, NumericMatrix pairwise_cont_r, NumericMatrix mux_r, NumericVector muy_r, IntegerVector num_categories_r, Rcpp::StringVector variable_type_r, IntegerVector baseline_category_r, int iter, int seed, bool vectorized);
+RcppExport SEXP _bgms_sample_mixed_mrf_gibbs(SEXP num_statesSEXP, SEXP pairwise_disc_rSEXP, SEXP pairwise_cross_rSEXP, SEXP pairwise_cont_rSEXP, SEXP mux_rSEXP, SEXP muy_rSEXP, SEXP num_categories_rSEXP, SEXP variable_type_rSEXP, SEXP baseline_category_rSEXP, SEXP iterSEXP, SEXP seedSEXP, SEXP vectorizedSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -475,13 +797,14 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< IntegerVector >::type baseline_category_r(baseline_category_rSEXP);
     Rcpp::traits::input_parameter< int >::type iter(iterSEXP);
     Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
-    rcpp_result_gen = Rcpp::wrap(sample_mixed_mrf_gibbs(num_states, pairwise_disc_r, pairwise_cross_r, pairwise_cont_r, mux_r, muy_r, num_categories_r, variable_type_r, baseline_category_r, iter, seed));
+    Rcpp::traits::input_parameter< bool >::type vectorized(vectorizedSEXP);
+    rcpp_result_gen = Rcpp::wrap(sample_mixed_mrf_gibbs(num_states, pairwise_disc_r, pairwise_cross_r, pairwise_cont_r, mux_r, muy_r, num_categories_r, variable_type_r, baseline_category_r, iter, seed, vectorized));
     return rcpp_result_gen;
 END_RCPP
 }
 // run_mixed_simulation_parallel
-Rcpp::List run_mixed_simulation_parallel(const arma::mat& mux_samples, const arma::mat& disc_samples, const arma::mat& muy_samples, const arma::mat& cont_samples, const arma::mat& cross_samples, const arma::ivec& draw_indices, int num_states, int p, int q, const arma::ivec& num_categories, const Rcpp::StringVector& variable_type_r, const arma::ivec& baseline_category, int iter, int nThreads, int seed, int progress_type);
-RcppExport SEXP _bgms_run_mixed_simulation_parallel(SEXP mux_samplesSEXP, SEXP disc_samplesSEXP, SEXP muy_samplesSEXP, SEXP cont_samplesSEXP, SEXP cross_samplesSEXP, SEXP draw_indicesSEXP, SEXP num_statesSEXP, SEXP pSEXP, SEXP qSEXP, SEXP num_categoriesSEXP, SEXP variable_type_rSEXP, SEXP baseline_categorySEXP, SEXP iterSEXP, SEXP nThreadsSEXP, SEXP seedSEXP, SEXP progress_typeSEXP) {
+Rcpp::List run_mixed_simulation_parallel(const arma::mat& mux_samples, const arma::mat& disc_samples, const arma::mat& muy_samples, const arma::mat& cont_samples, const arma::mat& cross_samples, const arma::ivec& draw_indices, int num_states, int p, int q, const arma::ivec& num_categories, const Rcpp::StringVector& variable_type_r, const arma::ivec& baseline_category, int iter, int nThreads, int seed, int progress_type, bool vectorized);
+RcppExport SEXP _bgms_run_mixed_simulation_parallel(SEXP mux_samplesSEXP, SEXP disc_samplesSEXP, SEXP muy_samplesSEXP, SEXP cont_samplesSEXP, SEXP cross_samplesSEXP, SEXP draw_indicesSEXP, SEXP num_statesSEXP, SEXP pSEXP, SEXP qSEXP, SEXP num_categoriesSEXP, SEXP variable_type_rSEXP, SEXP baseline_categorySEXP, SEXP iterSEXP, SEXP nThreadsSEXP, SEXP seedSEXP, SEXP progress_typeSEXP, SEXP vectorizedSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -501,7 +824,143 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< int >::type nThreads(nThreadsSEXP);
     Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
     Rcpp::traits::input_parameter< int >::type progress_type(progress_typeSEXP);
-    rcpp_result_gen = Rcpp::wrap(run_mixed_simulation_parallel(mux_samples, disc_samples, muy_samples, cont_samples, cross_samples, draw_indices, num_states, p, q, num_categories, variable_type_r, baseline_category, iter, nThreads, seed, progress_type));
+    Rcpp::traits::input_parameter< bool >::type vectorized(vectorizedSEXP);
+    rcpp_result_gen = Rcpp::wrap(run_mixed_simulation_parallel(mux_samples, disc_samples, muy_samples, cont_samples, cross_samples, draw_indices, num_states, p, q, num_categories, variable_type_r, baseline_category, iter, nThreads, seed, progress_type, vectorized));
+    return rcpp_result_gen;
+END_RCPP
+}
+// test_nuts_engines
+Rcpp::List test_nuts_engines(const arma::vec& scales, const double step_size, const int iterations, const int max_depth, const int seed, const double quartic, const bool reuse_start);
+RcppExport SEXP _bgms_test_nuts_engines(SEXP scalesSEXP, SEXP step_sizeSEXP, SEXP iterationsSEXP, SEXP max_depthSEXP, SEXP seedSEXP, SEXP quarticSEXP, SEXP reuse_startSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::vec& >::type scales(scalesSEXP);
+    Rcpp::traits::input_parameter< const double >::type step_size(step_sizeSEXP);
+    Rcpp::traits::input_parameter< const int >::type iterations(iterationsSEXP);
+    Rcpp::traits::input_parameter< const int >::type max_depth(max_depthSEXP);
+    Rcpp::traits::input_parameter< const int >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< const double >::type quartic(quarticSEXP);
+    Rcpp::traits::input_parameter< const bool >::type reuse_start(reuse_startSEXP);
+    rcpp_result_gen = Rcpp::wrap(test_nuts_engines(scales, step_size, iterations, max_depth, seed, quartic, reuse_start));
+    return rcpp_result_gen;
+END_RCPP
+}
+// test_nuts_metric
+Rcpp::List test_nuts_metric(const arma::mat& cov, const std::string& metric, const int rank, const arma::uvec& active);
+RcppExport SEXP _bgms_test_nuts_metric(SEXP covSEXP, SEXP metricSEXP, SEXP rankSEXP, SEXP activeSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::mat& >::type cov(covSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type metric(metricSEXP);
+    Rcpp::traits::input_parameter< const int >::type rank(rankSEXP);
+    Rcpp::traits::input_parameter< const arma::uvec& >::type active(activeSEXP);
+    rcpp_result_gen = Rcpp::wrap(test_nuts_metric(cov, metric, rank, active));
+    return rcpp_result_gen;
+END_RCPP
+}
+// test_omrf_logp_and_gradient
+Rcpp::List test_omrf_logp_and_gradient(const arma::imat& observations, const arma::ivec& num_categories, const arma::uvec& is_ordinal, const arma::ivec& baseline_category, const arma::vec& parameters, const int num_threads, const bool compress, const std::string& gradient_backend);
+RcppExport SEXP _bgms_test_omrf_logp_and_gradient(SEXP observationsSEXP, SEXP num_categoriesSEXP, SEXP is_ordinalSEXP, SEXP baseline_categorySEXP, SEXP parametersSEXP, SEXP num_threadsSEXP, SEXP compressSEXP, SEXP gradient_backendSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::imat& >::type observations(observationsSEXP);
+    Rcpp::traits::input_parameter< const arma::ivec& >::type num_categories(num_categoriesSEXP);
+    Rcpp::traits::input_parameter< const arma::uvec& >::type is_ordinal(is_ordinalSEXP);
+    Rcpp::traits::input_parameter< const arma::ivec& >::type baseline_category(baseline_categorySEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type parameters(parametersSEXP);
+    Rcpp::traits::input_parameter< const int >::type num_threads(num_threadsSEXP);
+    Rcpp::traits::input_parameter< const bool >::type compress(compressSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type gradient_backend(gradient_backendSEXP);
+    rcpp_result_gen = Rcpp::wrap(test_omrf_logp_and_gradient(observations, num_categories, is_ordinal, baseline_category, parameters, num_threads, compress, gradient_backend));
+    return rcpp_result_gen;
+END_RCPP
+}
+// test_omrf_sparse_gradient
+Rcpp::List test_omrf_sparse_gradient(const arma::imat& observations, const arma::ivec& num_categories, const arma::uvec& is_ordinal, const arma::ivec& baseline_category, const arma::imat& edge_indicators, const arma::vec& parameters);
+RcppExport SEXP _bgms_test_omrf_sparse_gradient(SEXP observationsSEXP, SEXP num_categoriesSEXP, SEXP is_ordinalSEXP, SEXP baseline_categorySEXP, SEXP edge_indicatorsSEXP, SEXP parametersSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::imat& >::type observations(observationsSEXP);
+    Rcpp::traits::input_parameter< const arma::ivec& >::type num_categories(num_categoriesSEXP);
+    Rcpp::traits::input_parameter< const arma::uvec& >::type is_ordinal(is_ordinalSEXP);
+    Rcpp::traits::input_parameter< const arma::ivec& >::type baseline_category(baseline_categorySEXP);
+    Rcpp::traits::input_parameter< const arma::imat& >::type edge_indicators(edge_indicatorsSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type parameters(parametersSEXP);
+    rcpp_result_gen = Rcpp::wrap(test_omrf_sparse_gradient(observations, num_categories, is_ordinal, baseline_category, edge_indicators, parameters));
+    return rcpp_result_gen;
+END_RCPP
+}
+// test_omrf_gpu_gradient
+Rcpp::List test_omrf_gpu_gradient(const arma::imat& observations, const arma::ivec& num_categories, const arma::uvec& is_ordinal, const arma::ivec& baseline_category, const arma::mat& parameter_sets);
+RcppExport SEXP _bgms_test_omrf_gpu_gradient(SEXP observationsSEXP, SEXP num_categoriesSEXP, SEXP is_ordinalSEXP, SEXP baseline_categorySEXP, SEXP parameter_setsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::imat& >::type observations(observationsSEXP);
+    Rcpp::traits::input_parameter< const arma::ivec& >::type num_categories(num_categoriesSEXP);
+    Rcpp::traits::input_parameter< const arma::uvec& >::type is_ordinal(is_ordinalSEXP);
+    Rcpp::traits::input_parameter< const arma::ivec& >::type baseline_category(baseline_categorySEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type parameter_sets(parameter_setsSEXP);
+    rcpp_result_gen = Rcpp::wrap(test_omrf_gpu_gradient(observations, num_categories, is_ordinal, baseline_category, parameter_sets));
+    return rcpp_result_gen;
+END_RCPP
+}
+// test_omrf_batched_gradient
+Rcpp::List test_omrf_batched_gradient(const arma::imat& observations, const arma::ivec& num_categories, const arma::uvec& is_ordinal, const arma::ivec& baseline_category, const arma::mat& parameter_sets, const int num_threads, const bool compress);
+RcppExport SEXP _bgms_test_omrf_batched_gradient(SEXP observationsSEXP, SEXP num_categoriesSEXP, SEXP is_ordinalSEXP, SEXP baseline_categorySEXP, SEXP parameter_setsSEXP, SEXP num_threadsSEXP, SEXP compressSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::imat& >::type observations(observationsSEXP);
+    Rcpp::traits::input_parameter< const arma::ivec& >::type num_categories(num_categoriesSEXP);
+    Rcpp::traits::input_parameter< const arma::uvec& >::type is_ordinal(is_ordinalSEXP);
+    Rcpp::traits::input_parameter< const arma::ivec& >::type baseline_category(baseline_categorySEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type parameter_sets(parameter_setsSEXP);
+    Rcpp::traits::input_parameter< const int >::type num_threads(num_threadsSEXP);
+    Rcpp::traits::input_parameter< const bool >::type compress(compressSEXP);
+    rcpp_result_gen = Rcpp::wrap(test_omrf_batched_gradient(observations, num_categories, is_ordinal, baseline_category, parameter_sets, num_threads, compress));
+    return rcpp_result_gen;
+END_RCPP
+}
+// test_omrf_impute_missing
+Rcpp::List test_omrf_impute_missing(const arma::imat& observations, const arma::imat& missing_index, const arma::ivec& num_categories, const arma::uvec& is_ordinal, const arma::ivec& baseline_category, const arma::mat& main_effects, const arma::mat& pairwise_effects, const int sweeps, const int seed);
+RcppExport SEXP _bgms_test_omrf_impute_missing(SEXP observationsSEXP, SEXP missing_indexSEXP, SEXP num_categoriesSEXP, SEXP is_ordinalSEXP, SEXP baseline_categorySEXP, SEXP main_effectsSEXP, SEXP pairwise_effectsSEXP, SEXP sweepsSEXP, SEXP seedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::imat& >::type observations(observationsSEXP);
+    Rcpp::traits::input_parameter< const arma::imat& >::type missing_index(missing_indexSEXP);
+    Rcpp::traits::input_parameter< const arma::ivec& >::type num_categories(num_categoriesSEXP);
+    Rcpp::traits::input_parameter< const arma::uvec& >::type is_ordinal(is_ordinalSEXP);
+    Rcpp::traits::input_parameter< const arma::ivec& >::type baseline_category(baseline_categorySEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type main_effects(main_effectsSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type pairwise_effects(pairwise_effectsSEXP);
+    Rcpp::traits::input_parameter< const int >::type sweeps(sweepsSEXP);
+    Rcpp::traits::input_parameter< const int >::type seed(seedSEXP);
+    rcpp_result_gen = Rcpp::wrap(test_omrf_impute_missing(observations, missing_index, num_categories, is_ordinal, baseline_category, main_effects, pairwise_effects, sweeps, seed));
+    return rcpp_result_gen;
+END_RCPP
+}
+// test_omrf_log_normalizer_cache
+Rcpp::List test_omrf_log_normalizer_cache(const arma::imat& observations, const arma::ivec& num_categories, const arma::uvec& is_ordinal, const arma::ivec& baseline_category, const int iterations, const int seed, const bool edge_selection, const bool delayed_acceptance, const bool block_main_effects);
+RcppExport SEXP _bgms_test_omrf_log_normalizer_cache(SEXP observationsSEXP, SEXP num_categoriesSEXP, SEXP is_ordinalSEXP, SEXP baseline_categorySEXP, SEXP iterationsSEXP, SEXP seedSEXP, SEXP edge_selectionSEXP, SEXP delayed_acceptanceSEXP, SEXP block_main_effectsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::imat& >::type observations(observationsSEXP);
+    Rcpp::traits::input_parameter< const arma::ivec& >::type num_categories(num_categoriesSEXP);
+    Rcpp::traits::input_parameter< const arma::uvec& >::type is_ordinal(is_ordinalSEXP);
+    Rcpp::traits::input_parameter< const arma::ivec& >::type baseline_category(baseline_categorySEXP);
+    Rcpp::traits::input_parameter< const int >::type iterations(iterationsSEXP);
+    Rcpp::traits::input_parameter< const int >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< const bool >::type edge_selection(edge_selectionSEXP);
+    Rcpp::traits::input_parameter< const bool >::type delayed_acceptance(delayed_acceptanceSEXP);
+    Rcpp::traits::input_parameter< const bool >::type block_main_effects(block_main_effectsSEXP);
+    rcpp_result_gen = Rcpp::wrap(test_omrf_log_normalizer_cache(observations, num_categories, is_ordinal, baseline_category, iterations, seed, edge_selection, delayed_acceptance, block_main_effects));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -553,6 +1012,22 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// test_parameter_prior_batch
+Rcpp::List test_parameter_prior_batch(const std::string& type, const arma::vec& x, const arma::vec& scale_factors, double scale, double alpha, double beta);
+RcppExport SEXP _bgms_test_parameter_prior_batch(SEXP typeSEXP, SEXP xSEXP, SEXP scale_factorsSEXP, SEXP scaleSEXP, SEXP alphaSEXP, SEXP betaSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::string& >::type type(typeSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type x(xSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type scale_factors(scale_factorsSEXP);
+    Rcpp::traits::input_parameter< double >::type scale(scaleSEXP);
+    Rcpp::traits::input_parameter< double >::type alpha(alphaSEXP);
+    Rcpp::traits::input_parameter< double >::type beta(betaSEXP);
+    rcpp_result_gen = Rcpp::wrap(test_parameter_prior_batch(type, x, scale_factors, scale, alpha, beta));
+    return rcpp_result_gen;
+END_RCPP
+}
 // ggm_test_logp_and_gradient_prior
 Rcpp::List ggm_test_logp_and_gradient_prior(const arma::vec& theta, const arma::mat& suf_stat, int n, const arma::imat& edge_indicators, const std::string& interaction_prior_type, double interaction_scale, double interaction_alpha, double interaction_beta, const std::string& diagonal_prior_type, double diagonal_shape, double diagonal_rate);
 RcppExport SEXP _bgms_ggm_test_logp_and_gradient_prior(SEXP thetaSEXP, SEXP suf_statSEXP, SEXP nSEXP, SEXP edge_indicatorsSEXP, SEXP interaction_prior_typeSEXP, SEXP interaction_scaleSEXP, SEXP interaction_alphaSEXP, SEXP interaction_betaSEXP, SEXP diagonal_prior_typeSEXP, SEXP diagonal_shapeSEXP, SEXP diagonal_rateSEXP) {
@@ -574,9 +1049,81 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// test_edge_prior_toggles
+Rcpp::List test_edge_prior_toggles(const std::string& type, int p, int num_updates, int toggles_per_update, int seed);
+RcppExport SEXP _bgms_test_edge_prior_toggles(SEXP typeSEXP, SEXP pSEXP, SEXP num_updatesSEXP, SEXP toggles_per_updateSEXP, SEXP seedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::string& >::type type(typeSEXP);
+    Rcpp::traits::input_parameter< int >::type p(pSEXP);
+    Rcpp::traits::input_parameter< int >::type num_updates(num_updatesSEXP);
+    Rcpp::traits::input_parameter< int >::type toggles_per_update(toggles_per_updateSEXP);
+    Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
+    rcpp_result_gen = Rcpp::wrap(test_edge_prior_toggles(type, p, num_updates, toggles_per_update, seed));
+    return rcpp_result_gen;
+END_RCPP
+}
+// test_sbm_allocations
+Rcpp::List test_sbm_allocations(const arma::imat& indicators, const arma::uvec& allocations, int num_sweeps, int seed, double dirichlet_alpha, double lambda, double alpha, double beta, double alpha_between, double beta_between);
+RcppExport SEXP _bgms_test_sbm_allocations(SEXP indicatorsSEXP, SEXP allocationsSEXP, SEXP num_sweepsSEXP, SEXP seedSEXP, SEXP dirichlet_alphaSEXP, SEXP lambdaSEXP, SEXP alphaSEXP, SEXP betaSEXP, SEXP alpha_betweenSEXP, SEXP beta_betweenSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::imat& >::type indicators(indicatorsSEXP);
+    Rcpp::traits::input_parameter< const arma::uvec& >::type allocations(allocationsSEXP);
+    Rcpp::traits::input_parameter< int >::type num_sweeps(num_sweepsSEXP);
+    Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< double >::type dirichlet_alpha(dirichlet_alphaSEXP);
+    Rcpp::traits::input_parameter< double >::type lambda(lambdaSEXP);
+    Rcpp::traits::input_parameter< double >::type alpha(alphaSEXP);
+    Rcpp::traits::input_parameter< double >::type beta(betaSEXP);
+    Rcpp::traits::input_parameter< double >::type alpha_between(alpha_betweenSEXP);
+    Rcpp::traits::input_parameter< double >::type beta_between(beta_betweenSEXP);
+    rcpp_result_gen = Rcpp::wrap(test_sbm_allocations(indicators, allocations, num_sweeps, seed, dirichlet_alpha, lambda, alpha, beta, alpha_between, beta_between));
+    return rcpp_result_gen;
+END_RCPP
+}
+// test_rng_fills
+Rcpp::List test_rng_fills(const int seed, const int n);
+RcppExport SEXP _bgms_test_rng_fills(SEXP seedSEXP, SEXP nSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const int >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< const int >::type n(nSEXP);
+    rcpp_result_gen = Rcpp::wrap(test_rng_fills(seed, n));
+    return rcpp_result_gen;
+END_RCPP
+}
+// test_polya_gamma
+Rcpp::NumericMatrix test_polya_gamma(const Rcpp::NumericVector& psi, const int n, const int seed);
+RcppExport SEXP _bgms_test_polya_gamma(SEXP psiSEXP, SEXP nSEXP, SEXP seedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::NumericVector& >::type psi(psiSEXP);
+    Rcpp::traits::input_parameter< const int >::type n(nSEXP);
+    Rcpp::traits::input_parameter< const int >::type seed(seedSEXP);
+    rcpp_result_gen = Rcpp::wrap(test_polya_gamma(psi, n, seed));
+    return rcpp_result_gen;
+END_RCPP
+}
+// benchmark_rng_fills
+Rcpp::DataFrame benchmark_rng_fills(const int n, const int reps);
+RcppExport SEXP _bgms_benchmark_rng_fills(SEXP nSEXP, SEXP repsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const int >::type n(nSEXP);
+    Rcpp::traits::input_parameter< const int >::type reps(repsSEXP);
+    rcpp_result_gen = Rcpp::wrap(benchmark_rng_fills(n, reps));
+    return rcpp_result_gen;
+END_RCPP
+}
 // sample_ggm
-Rcpp::List sample_ggm(const Rcpp::List& inputFromR, const arma::mat& prior_inclusion_prob, const arma::imat& initial_edge_indicators, const int no_iter, const int no_warmup, const int no_chains, const bool edge_selection, const std::string& sampler_type, const int seed, const int no_threads, const int progress_type, SEXP progress_callback, const std::string& edge_prior, const double beta_bernoulli_alpha, const double beta_bernoulli_beta, const double beta_bernoulli_alpha_between, const double beta_bernoulli_beta_between, const double dirichlet_alpha, const double lambda, const double target_acceptance, const int max_tree_depth, const bool na_impute, const Rcpp::Nullable<Rcpp::IntegerMatrix> missing_index_nullable, const double delta);
-RcppExport SEXP _bgms_sample_ggm(SEXP inputFromRSEXP, SEXP prior_inclusion_probSEXP, SEXP initial_edge_indicatorsSEXP, SEXP no_iterSEXP, SEXP no_warmupSEXP, SEXP no_chainsSEXP, SEXP edge_selectionSEXP, SEXP sampler_typeSEXP, SEXP seedSEXP, SEXP no_threadsSEXP, SEXP progress_typeSEXP, SEXP progress_callbackSEXP, SEXP edge_priorSEXP, SEXP beta_bernoulli_alphaSEXP, SEXP beta_bernoulli_betaSEXP, SEXP beta_bernoulli_alpha_betweenSEXP, SEXP beta_bernoulli_beta_betweenSEXP, SEXP dirichlet_alphaSEXP, SEXP lambdaSEXP, SEXP target_acceptanceSEXP, SEXP max_tree_depthSEXP, SEXP na_imputeSEXP, SEXP missing_index_nullableSEXP, SEXP deltaSEXP) {
+Rcpp::List sample_ggm(const Rcpp::List& inputFromR, const arma::mat& prior_inclusion_prob, const arma::imat& initial_edge_indicators, const int no_iter, const int no_warmup, const int no_chains, const bool edge_selection, const std::string& sampler_type, const int seed, const int no_threads, const int progress_type, SEXP progress_callback, const std::string& edge_prior, const double beta_bernoulli_alpha, const double beta_bernoulli_beta, const double beta_bernoulli_alpha_between, const double beta_bernoulli_beta_between, const double dirichlet_alpha, const double lambda, const double target_acceptance, const int max_tree_depth, const bool na_impute, const Rcpp::Nullable<Rcpp::IntegerMatrix> missing_index_nullable, const double delta, const Rcpp::Nullable<Rcpp::List> settings);
+RcppExport SEXP _bgms_sample_ggm(SEXP inputFromRSEXP, SEXP prior_inclusion_probSEXP, SEXP initial_edge_indicatorsSEXP, SEXP no_iterSEXP, SEXP no_warmupSEXP, SEXP no_chainsSEXP, SEXP edge_selectionSEXP, SEXP sampler_typeSEXP, SEXP seedSEXP, SEXP no_threadsSEXP, SEXP progress_typeSEXP, SEXP progress_callbackSEXP, SEXP edge_priorSEXP, SEXP beta_bernoulli_alphaSEXP, SEXP beta_bernoulli_betaSEXP, SEXP beta_bernoulli_alpha_betweenSEXP, SEXP beta_bernoulli_beta_betweenSEXP, SEXP dirichlet_alphaSEXP, SEXP lambdaSEXP, SEXP target_acceptanceSEXP, SEXP max_tree_depthSEXP, SEXP na_imputeSEXP, SEXP missing_index_nullableSEXP, SEXP deltaSEXP, SEXP settingsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -604,13 +1151,14 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< const bool >::type na_impute(na_imputeSEXP);
     Rcpp::traits::input_parameter< const Rcpp::Nullable<Rcpp::IntegerMatrix> >::type missing_index_nullable(missing_index_nullableSEXP);
     Rcpp::traits::input_parameter< const double >::type delta(deltaSEXP);
-    rcpp_result_gen = Rcpp::wrap(sample_ggm(inputFromR, prior_inclusion_prob, initial_edge_indicators, no_iter, no_warmup, no_chains, edge_selection, sampler_type, seed, no_threads, progress_type, progress_callback, edge_prior, beta_bernoulli_alpha, beta_bernoulli_beta, beta_bernoulli_alpha_between, beta_bernoulli_beta_between, dirichlet_alpha, lambda, target_acceptance, max_tree_depth, na_impute, missing_index_nullable, delta));
+    Rcpp::traits::input_parameter< const Rcpp::Nullable<Rcpp::List> >::type settings(settingsSEXP);
+    rcpp_result_gen = Rcpp::wrap(sample_ggm(inputFromR, prior_inclusion_prob, initial_edge_indicators, no_iter, no_warmup, no_chains, edge_selection, sampler_type, seed, no_threads, progress_type, progress_callback, edge_prior, beta_bernoulli_alpha, beta_bernoulli_beta, beta_bernoulli_alpha_between, beta_bernoulli_beta_between, dirichlet_alpha, lambda, target_acceptance, max_tree_depth, na_impute, missing_index_nullable, delta, settings));
     return rcpp_result_gen;
 END_RCPP
 }
 // sample_mixed_mrf
-Rcpp::List sample_mixed_mrf(const Rcpp::List& inputFromR, const arma::mat& prior_inclusion_prob, const arma::imat& initial_edge_indicators, const int no_iter, const int no_warmup, const int no_chains, const bool edge_selection, const int seed, const int no_threads, const int progress_type, SEXP progress_callback, const std::string& edge_prior, const double beta_bernoulli_alpha, const double beta_bernoulli_beta, const double beta_bernoulli_alpha_between, const double beta_bernoulli_beta_between, const double dirichlet_alpha, const double lambda, const std::string& sampler_type, const double target_acceptance, const int max_tree_depth, const bool na_impute, const Rcpp::Nullable<Rcpp::IntegerMatrix> missing_index_discrete_nullable, const Rcpp::Nullable<Rcpp::IntegerMatrix> missing_index_continuous_nullable, const double delta);
-RcppExport SEXP _bgms_sample_mixed_mrf(SEXP inputFromRSEXP, SEXP prior_inclusion_probSEXP, SEXP initial_edge_indicatorsSEXP, SEXP no_iterSEXP, SEXP no_warmupSEXP, SEXP no_chainsSEXP, SEXP edge_selectionSEXP, SEXP seedSEXP, SEXP no_threadsSEXP, SEXP progress_typeSEXP, SEXP progress_callbackSEXP, SEXP edge_priorSEXP, SEXP beta_bernoulli_alphaSEXP, SEXP beta_bernoulli_betaSEXP, SEXP beta_bernoulli_alpha_betweenSEXP, SEXP beta_bernoulli_beta_betweenSEXP, SEXP dirichlet_alphaSEXP, SEXP lambdaSEXP, SEXP sampler_typeSEXP, SEXP target_acceptanceSEXP, SEXP max_tree_depthSEXP, SEXP na_imputeSEXP, SEXP missing_index_discrete_nullableSEXP, SEXP missing_index_continuous_nullableSEXP, SEXP deltaSEXP) {
+Rcpp::List sample_mixed_mrf(const Rcpp::List& inputFromR, const arma::mat& prior_inclusion_prob, const arma::imat& initial_edge_indicators, const int no_iter, const int no_warmup, const int no_chains, const bool edge_selection, const int seed, const int no_threads, const int progress_type, SEXP progress_callback, const std::string& edge_prior, const double beta_bernoulli_alpha, const double beta_bernoulli_beta, const double beta_bernoulli_alpha_between, const double beta_bernoulli_beta_between, const double dirichlet_alpha, const double lambda, const std::string& sampler_type, const double target_acceptance, const int max_tree_depth, const bool na_impute, const Rcpp::Nullable<Rcpp::IntegerMatrix> missing_index_discrete_nullable, const Rcpp::Nullable<Rcpp::IntegerMatrix> missing_index_continuous_nullable, const double delta, const Rcpp::Nullable<Rcpp::List> settings);
+RcppExport SEXP _bgms_sample_mixed_mrf(SEXP inputFromRSEXP, SEXP prior_inclusion_probSEXP, SEXP initial_edge_indicatorsSEXP, SEXP no_iterSEXP, SEXP no_warmupSEXP, SEXP no_chainsSEXP, SEXP edge_selectionSEXP, SEXP seedSEXP, SEXP no_threadsSEXP, SEXP progress_typeSEXP, SEXP progress_callbackSEXP, SEXP edge_priorSEXP, SEXP beta_bernoulli_alphaSEXP, SEXP beta_bernoulli_betaSEXP, SEXP beta_bernoulli_alpha_betweenSEXP, SEXP beta_bernoulli_beta_betweenSEXP, SEXP dirichlet_alphaSEXP, SEXP lambdaSEXP, SEXP sampler_typeSEXP, SEXP target_acceptanceSEXP, SEXP max_tree_depthSEXP, SEXP na_imputeSEXP, SEXP missing_index_discrete_nullableSEXP, SEXP missing_index_continuous_nullableSEXP, SEXP deltaSEXP, SEXP settingsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -639,13 +1187,14 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< const Rcpp::Nullable<Rcpp::IntegerMatrix> >::type missing_index_discrete_nullable(missing_index_discrete_nullableSEXP);
     Rcpp::traits::input_parameter< const Rcpp::Nullable<Rcpp::IntegerMatrix> >::type missing_index_continuous_nullable(missing_index_continuous_nullableSEXP);
     Rcpp::traits::input_parameter< const double >::type delta(deltaSEXP);
-    rcpp_result_gen = Rcpp::wrap(sample_mixed_mrf(inputFromR, prior_inclusion_prob, initial_edge_indicators, no_iter, no_warmup, no_chains, edge_selection, seed, no_threads, progress_type, progress_callback, edge_prior, beta_bernoulli_alpha, beta_bernoulli_beta, beta_bernoulli_alpha_between, beta_bernoulli_beta_between, dirichlet_alpha, lambda, sampler_type, target_acceptance, max_tree_depth, na_impute, missing_index_discrete_nullable, missing_index_continuous_nullable, delta));
+    Rcpp::traits::input_parameter< const Rcpp::Nullable<Rcpp::List> >::type settings(settingsSEXP);
+    rcpp_result_gen = Rcpp::wrap(sample_mixed_mrf(inputFromR, prior_inclusion_prob, initial_edge_indicators, no_iter, no_warmup, no_chains, edge_selection, seed, no_threads, progress_type, progress_callback, edge_prior, beta_bernoulli_alpha, beta_bernoulli_beta, beta_bernoulli_alpha_between, beta_bernoulli_beta_between, dirichlet_alpha, lambda, sampler_type, target_acceptance, max_tree_depth, na_impute, missing_index_discrete_nullable, missing_index_continuous_nullable, delta, settings));
     return rcpp_result_gen;
 END_RCPP
 }
 // sample_omrf
-Rcpp::List sample_omrf(const Rcpp::List& inputFromR, const arma::mat& prior_inclusion_prob, const arma::imat& initial_edge_indicators, const int no_iter, const int no_warmup, const int no_chains, const bool edge_selection, const std::string& sampler_type, const int seed, const int no_threads, const int progress_type, SEXP progress_callback, const std::string& edge_prior, const bool na_impute, const Rcpp::Nullable<Rcpp::IntegerMatrix> missing_index_nullable, const double beta_bernoulli_alpha, const double beta_bernoulli_beta, const double beta_bernoulli_alpha_between, const double beta_bernoulli_beta_between, const double dirichlet_alpha, const double lambda, const double target_acceptance, const int max_tree_depth, const Rcpp::Nullable<Rcpp::NumericMatrix> pairwise_scaling_factors_nullable);
-RcppExport SEXP _bgms_sample_omrf(SEXP inputFromRSEXP, SEXP prior_inclusion_probSEXP, SEXP initial_edge_indicatorsSEXP, SEXP no_iterSEXP, SEXP no_warmupSEXP, SEXP no_chainsSEXP, SEXP edge_selectionSEXP, SEXP sampler_typeSEXP, SEXP seedSEXP, SEXP no_threadsSEXP, SEXP progress_typeSEXP, SEXP progress_callbackSEXP, SEXP edge_priorSEXP, SEXP na_imputeSEXP, SEXP missing_index_nullableSEXP, SEXP beta_bernoulli_alphaSEXP, SEXP beta_bernoulli_betaSEXP, SEXP beta_bernoulli_alpha_betweenSEXP, SEXP beta_bernoulli_beta_betweenSEXP, SEXP dirichlet_alphaSEXP, SEXP lambdaSEXP, SEXP target_acceptanceSEXP, SEXP max_tree_depthSEXP, SEXP pairwise_scaling_factors_nullableSEXP) {
+Rcpp::List sample_omrf(const Rcpp::List& inputFromR, const arma::mat& prior_inclusion_prob, const arma::imat& initial_edge_indicators, const int no_iter, const int no_warmup, const int no_chains, const bool edge_selection, const std::string& sampler_type, const int seed, const int no_threads, const int progress_type, SEXP progress_callback, const std::string& edge_prior, const bool na_impute, const Rcpp::Nullable<Rcpp::IntegerMatrix> missing_index_nullable, const double beta_bernoulli_alpha, const double beta_bernoulli_beta, const double beta_bernoulli_alpha_between, const double beta_bernoulli_beta_between, const double dirichlet_alpha, const double lambda, const double target_acceptance, const int max_tree_depth, const Rcpp::Nullable<Rcpp::NumericMatrix> pairwise_scaling_factors_nullable, const Rcpp::Nullable<Rcpp::List> settings);
+RcppExport SEXP _bgms_sample_omrf(SEXP inputFromRSEXP, SEXP prior_inclusion_probSEXP, SEXP initial_edge_indicatorsSEXP, SEXP no_iterSEXP, SEXP no_warmupSEXP, SEXP no_chainsSEXP, SEXP edge_selectionSEXP, SEXP sampler_typeSEXP, SEXP seedSEXP, SEXP no_threadsSEXP, SEXP progress_typeSEXP, SEXP progress_callbackSEXP, SEXP edge_priorSEXP, SEXP na_imputeSEXP, SEXP missing_index_nullableSEXP, SEXP beta_bernoulli_alphaSEXP, SEXP beta_bernoulli_betaSEXP, SEXP beta_bernoulli_alpha_betweenSEXP, SEXP beta_bernoulli_beta_betweenSEXP, SEXP dirichlet_alphaSEXP, SEXP lambdaSEXP, SEXP target_acceptanceSEXP, SEXP max_tree_depthSEXP, SEXP pairwise_scaling_factors_nullableSEXP, SEXP settingsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -673,10 +1222,92 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< const double >::type target_acceptance(target_acceptanceSEXP);
     Rcpp::traits::input_parameter< const int >::type max_tree_depth(max_tree_depthSEXP);
     Rcpp::traits::input_parameter< const Rcpp::Nullable<Rcpp::NumericMatrix> >::type pairwise_scaling_factors_nullable(pairwise_scaling_factors_nullableSEXP);
-    rcpp_result_gen = Rcpp::wrap(sample_omrf(inputFromR, prior_inclusion_prob, initial_edge_indicators, no_iter, no_warmup, no_chains, edge_selection, sampler_type, seed, no_threads, progress_type, progress_callback, edge_prior, na_impute, missing_index_nullable, beta_bernoulli_alpha, beta_bernoulli_beta, beta_bernoulli_alpha_between, beta_bernoulli_beta_between, dirichlet_alpha, lambda, target_acceptance, max_tree_depth, pairwise_scaling_factors_nullable));
+    Rcpp::traits::input_parameter< const Rcpp::Nullable<Rcpp::List> >::type settings(settingsSEXP);
+    rcpp_result_gen = Rcpp::wrap(sample_omrf(inputFromR, prior_inclusion_prob, initial_edge_indicators, no_iter, no_warmup, no_chains, edge_selection, sampler_type, seed, no_threads, progress_type, progress_callback, edge_prior, na_impute, missing_index_nullable, beta_bernoulli_alpha, beta_bernoulli_beta, beta_bernoulli_alpha_between, beta_bernoulli_beta_between, dirichlet_alpha, lambda, target_acceptance, max_tree_depth, pairwise_scaling_factors_nullable, settings));
     return rcpp_result_gen;
 END_RCPP
 }
+// omrf_gpu_backend_available
+bool omrf_gpu_backend_available();
+RcppExport SEXP _bgms_omrf_gpu_backend_available() {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    rcpp_result_gen = Rcpp::wrap(omrf_gpu_backend_available());
+    return rcpp_result_gen;
+END_RCPP
+}
+// sample_omrf_batch
+Rcpp::List sample_omrf_batch(const Rcpp::List& inputs, const Rcpp::IntegerVector& seeds, const int no_iter, const int no_warmup, const int no_chains, const bool edge_selection, const std::string& sampler_type, const int no_threads, const int progress_type, SEXP progress_callback, const std::string& edge_prior, const double beta_bernoulli_alpha, const double beta_bernoulli_beta, const double beta_bernoulli_alpha_between, const double beta_bernoulli_beta_between, const double dirichlet_alpha, const double lambda, const double target_acceptance, const int max_tree_depth, const Rcpp::Nullable<Rcpp::List> settings);
+RcppExport SEXP _bgms_sample_omrf_batch(SEXP inputsSEXP, SEXP seedsSEXP, SEXP no_iterSEXP, SEXP no_warmupSEXP, SEXP no_chainsSEXP, SEXP edge_selectionSEXP, SEXP sampler_typeSEXP, SEXP no_threadsSEXP, SEXP progress_typeSEXP, SEXP progress_callbackSEXP, SEXP edge_priorSEXP, SEXP beta_bernoulli_alphaSEXP, SEXP beta_bernoulli_betaSEXP, SEXP beta_bernoulli_alpha_betweenSEXP, SEXP beta_bernoulli_beta_betweenSEXP, SEXP dirichlet_alphaSEXP, SEXP lambdaSEXP, SEXP target_acceptanceSEXP, SEXP max_tree_depthSEXP, SEXP settingsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::List& >::type inputs(inputsSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::IntegerVector& >::type seeds(seedsSEXP);
+    Rcpp::traits::input_parameter< const int >::type no_iter(no_iterSEXP);
+    Rcpp::traits::input_parameter< const int >::type no_warmup(no_warmupSEXP);
+    Rcpp::traits::input_parameter< const int >::type no_chains(no_chainsSEXP);
+    Rcpp::traits::input_parameter< const bool >::type edge_selection(edge_selectionSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type sampler_type(sampler_typeSEXP);
+    Rcpp::traits::input_parameter< const int >::type no_threads(no_threadsSEXP);
+    Rcpp::traits::input_parameter< const int >::type progress_type(progress_typeSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type progress_callback(progress_callbackSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type edge_prior(edge_priorSEXP);
+    Rcpp::traits::input_parameter< const double >::type beta_bernoulli_alpha(beta_bernoulli_alphaSEXP);
+    Rcpp::traits::input_parameter< const double >::type beta_bernoulli_beta(beta_bernoulli_betaSEXP);
+    Rcpp::traits::input_parameter< const double >::type beta_bernoulli_alpha_between(beta_bernoulli_alpha_betweenSEXP);
+    Rcpp::traits::input_parameter< const double >::type beta_bernoulli_beta_between(beta_bernoulli_beta_betweenSEXP);
+    Rcpp::traits::input_parameter< const double >::type dirichlet_alpha(dirichlet_alphaSEXP);
+    Rcpp::traits::input_parameter< const double >::type lambda(lambdaSEXP);
+    Rcpp::traits::input_parameter< const double >::type target_acceptance(target_acceptanceSEXP);
+    Rcpp::traits::input_parameter< const int >::type max_tree_depth(max_tree_depthSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::Nullable<Rcpp::List> >::type settings(settingsSEXP);
+    rcpp_result_gen = Rcpp::wrap(sample_omrf_batch(inputs, seeds, no_iter, no_warmup, no_chains, edge_selection, sampler_type, no_threads, progress_type, progress_callback, edge_prior, beta_bernoulli_alpha, beta_bernoulli_beta, beta_bernoulli_alpha_between, beta_bernoulli_beta_between, dirichlet_alpha, lambda, target_acceptance, max_tree_depth, settings));
+    return rcpp_result_gen;
+END_RCPP
+}
+// test_chunked_file_sink
+int test_chunked_file_sink(const std::string& path, const arma::mat& draws, const double buffer_bytes, const bool as_integer);
+RcppExport SEXP _bgms_test_chunked_file_sink(SEXP pathSEXP, SEXP drawsSEXP, SEXP buffer_bytesSEXP, SEXP as_integerSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::string& >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type draws(drawsSEXP);
+    Rcpp::traits::input_parameter< const double >::type buffer_bytes(buffer_bytesSEXP);
+    Rcpp::traits::input_parameter< const bool >::type as_integer(as_integerSEXP);
+    rcpp_result_gen = Rcpp::wrap(test_chunked_file_sink(path, draws, buffer_bytes, as_integer));
+    return rcpp_result_gen;
+END_RCPP
+}
+// sampler_session_extend
+Rcpp::List sampler_session_extend(SEXP session, const int no_iter, const int no_warmup, const int progress_type, SEXP progress_callback);
+RcppExport SEXP _bgms_sampler_session_extend(SEXP sessionSEXP, SEXP no_iterSEXP, SEXP no_warmupSEXP, SEXP progress_typeSEXP, SEXP progress_callbackSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type session(sessionSEXP);
+    Rcpp::traits::input_parameter< const int >::type no_iter(no_iterSEXP);
+    Rcpp::traits::input_parameter< const int >::type no_warmup(no_warmupSEXP);
+    Rcpp::traits::input_parameter< const int >::type progress_type(progress_typeSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type progress_callback(progress_callbackSEXP);
+    rcpp_result_gen = Rcpp::wrap(sampler_session_extend(session, no_iter, no_warmup, progress_type, progress_callback));
+    return rcpp_result_gen;
+END_RCPP
+}
+// sampler_session_update_data
+void sampler_session_update_data(SEXP session, const Rcpp::Nullable<Rcpp::IntegerVector> remove, const Rcpp::Nullable<Rcpp::IntegerMatrix> append);
+RcppExport SEXP _bgms_sampler_session_update_data(SEXP sessionSEXP, SEXP removeSEXP, SEXP appendSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type session(sessionSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::Nullable<Rcpp::IntegerVector> >::type remove(removeSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::Nullable<Rcpp::IntegerMatrix> >::type append(appendSEXP);
+    sampler_session_update_data(session, remove, append);
+    return R_NilValue;
+END_RCPP
+}
 // compute_Vn_mfm_sbm
 arma::vec compute_Vn_mfm_sbm(arma::uword num_variables, double dirichlet_alpha, arma::uword t_max, double lambda);
 RcppExport SEXP _bgms_compute_Vn_mfm_sbm(SEXP num_variablesSEXP, SEXP dirichlet_alphaSEXP, SEXP t_maxSEXP, SEXP lambdaSEXP) {
@@ -691,41 +1322,106 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// write_score_file_cpp
+void write_score_file_cpp(const std::string& path, const Rcpp::IntegerMatrix& scores);
+RcppExport SEXP _bgms_write_score_file_cpp(SEXP pathSEXP, SEXP scoresSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::string& >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::IntegerMatrix& >::type scores(scoresSEXP);
+    write_score_file_cpp(path, scores);
+    return R_NilValue;
+END_RCPP
+}
+// score_file_summary
+Rcpp::List score_file_summary(const std::string& path);
+RcppExport SEXP _bgms_score_file_summary(SEXP pathSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::string& >::type path(pathSEXP);
+    rcpp_result_gen = Rcpp::wrap(score_file_summary(path));
+    return rcpp_result_gen;
+END_RCPP
+}
 
 static const R_CallMethodDef CallEntries[] = {
-    {"_bgms_run_bgmCompare_parallel", (DL_FUNC) &_bgms_run_bgmCompare_parallel, 45},
+    {"_bgms_benchmark_hot_paths", (DL_FUNC) &_bgms_benchmark_hot_paths, 7},
+    {"_bgms_run_bgmCompare_parallel", (DL_FUNC) &_bgms_run_bgmCompare_parallel, 46},
+    {"_bgms_test_bgmcompare_residuals", (DL_FUNC) &_bgms_test_bgmcompare_residuals, 18},
+    {"_bgms_test_cholesky_rank_update", (DL_FUNC) &_bgms_test_cholesky_rank_update, 4},
+    {"_bgms_test_compact_scores", (DL_FUNC) &_bgms_test_compact_scores, 5},
     {"_bgms_get_explog_switch", (DL_FUNC) &_bgms_get_explog_switch, 0},
     {"_bgms_rcpp_ieee754_exp", (DL_FUNC) &_bgms_rcpp_ieee754_exp, 1},
     {"_bgms_rcpp_ieee754_log", (DL_FUNC) &_bgms_rcpp_ieee754_log, 1},
+    {"_bgms_rcpp_vector_exp", (DL_FUNC) &_bgms_rcpp_vector_exp, 1},
+    {"_bgms_rcpp_vector_log", (DL_FUNC) &_bgms_rcpp_vector_log, 1},
+    {"_bgms_get_simd_explog_isa", (DL_FUNC) &_bgms_get_simd_explog_isa, 0},
+    {"_bgms_test_categorical", (DL_FUNC) &_bgms_test_categorical, 2},
+    {"_bgms_benchmark_explog_kernels", (DL_FUNC) &_bgms_benchmark_explog_kernels, 2},
     {"_bgms_ggm_test_logp_and_gradient", (DL_FUNC) &_bgms_ggm_test_logp_and_gradient, 5},
     {"_bgms_ggm_test_forward_map", (DL_FUNC) &_bgms_ggm_test_forward_map, 2},
+    {"_bgms_benchmark_ggm_gradient", (DL_FUNC) &_bgms_benchmark_ggm_gradient, 4},
     {"_bgms_sample_ggm_prior", (DL_FUNC) &_bgms_sample_ggm_prior, 14},
+    {"_bgms_ggm_test_impute_missing", (DL_FUNC) &_bgms_ggm_test_impute_missing, 4},
+    {"_bgms_ggm_test_sparse_cholesky", (DL_FUNC) &_bgms_ggm_test_sparse_cholesky, 6},
+    {"_bgms_test_packed_indicator_trace", (DL_FUNC) &_bgms_test_packed_indicator_trace, 1},
+    {"_bgms_test_logz_kernels", (DL_FUNC) &_bgms_test_logz_kernels, 6},
     {"_bgms_compute_ess_cpp", (DL_FUNC) &_bgms_compute_ess_cpp, 1},
     {"_bgms_compute_rhat_cpp", (DL_FUNC) &_bgms_compute_rhat_cpp, 1},
+    {"_bgms_compute_ess_chains_cpp", (DL_FUNC) &_bgms_compute_ess_chains_cpp, 2},
+    {"_bgms_compute_rhat_chains_cpp", (DL_FUNC) &_bgms_compute_rhat_chains_cpp, 2},
     {"_bgms_compute_indicator_ess_cpp", (DL_FUNC) &_bgms_compute_indicator_ess_cpp, 1},
+    {"_bgms_compute_indicator_ess_packed_cpp", (DL_FUNC) &_bgms_compute_indicator_ess_packed_cpp, 1},
+    {"_bgms_compute_file_diagnostics_cpp", (DL_FUNC) &_bgms_compute_file_diagnostics_cpp, 2},
+    {"_bgms_compute_indicator_ess_files_cpp", (DL_FUNC) &_bgms_compute_indicator_ess_files_cpp, 2},
     {"_bgms_mixed_test_logp_and_gradient", (DL_FUNC) &_bgms_mixed_test_logp_and_gradient, 18},
     {"_bgms_mixed_test_logp_and_gradient_full", (DL_FUNC) &_bgms_mixed_test_logp_and_gradient_full, 20},
     {"_bgms_mixed_test_project_position", (DL_FUNC) &_bgms_mixed_test_project_position, 14},
     {"_bgms_mixed_test_project_momentum", (DL_FUNC) &_bgms_mixed_test_project_momentum, 15},
     {"_bgms_mixed_test_leapfrog_constrained", (DL_FUNC) &_bgms_mixed_test_leapfrog_constrained, 17},
+    {"_bgms_mixed_test_ggm_ratio", (DL_FUNC) &_bgms_mixed_test_ggm_ratio, 7},
     {"_bgms_compute_conditional_ggm", (DL_FUNC) &_bgms_compute_conditional_ggm, 3},
     {"_bgms_compute_conditional_probs", (DL_FUNC) &_bgms_compute_conditional_probs, 7},
+    {"_bgms_compute_conditional_probs_draws", (DL_FUNC) &_bgms_compute_conditional_probs_draws, 8},
     {"_bgms_compute_conditional_mixed", (DL_FUNC) &_bgms_compute_conditional_mixed, 11},
-    {"_bgms_sample_omrf_gibbs", (DL_FUNC) &_bgms_sample_omrf_gibbs, 7},
-    {"_bgms_sample_bcomrf_gibbs", (DL_FUNC) &_bgms_sample_bcomrf_gibbs, 9},
+    {"_bgms_compute_conditional_mixed_draws", (DL_FUNC) &_bgms_compute_conditional_mixed_draws, 12},
+    {"_bgms_sample_omrf_gibbs", (DL_FUNC) &_bgms_sample_omrf_gibbs, 9},
+    {"_bgms_sample_bcomrf_gibbs", (DL_FUNC) &_bgms_sample_bcomrf_gibbs, 11},
     {"_bgms_sample_ggm_direct", (DL_FUNC) &_bgms_sample_ggm_direct, 4},
     {"_bgms_run_simulation_parallel", (DL_FUNC) &_bgms_run_simulation_parallel, 12},
     {"_bgms_run_ggm_simulation_parallel", (DL_FUNC) &_bgms_run_ggm_simulation_parallel, 9},
-    {"_bgms_sample_mixed_mrf_gibbs", (DL_FUNC) &_bgms_sample_mixed_mrf_gibbs, 11},
-    {"_bgms_run_mixed_simulation_parallel", (DL_FUNC) &_bgms_run_mixed_simulation_parallel, 16},
+    {"_bgms_sample_mixed_mrf_gibbs", (DL_FUNC) &_bgms_sample_mixed_mrf_gibbs, 12},
+    {"_bgms_run_mixed_simulation_parallel", (DL_FUNC) &_bgms_run_mixed_simulation_parallel, 17},
+    {"_bgms_test_nuts_engines", (DL_FUNC) &_bgms_test_nuts_engines, 7},
+    {"_bgms_test_nuts_metric", (DL_FUNC) &_bgms_test_nuts_metric, 4},
+    {"_bgms_test_omrf_logp_and_gradient", (DL_FUNC) &_bgms_test_omrf_logp_and_gradient, 8},
+    {"_bgms_test_omrf_sparse_gradient", (DL_FUNC) &_bgms_test_omrf_sparse_gradient, 6},
+    {"_bgms_test_omrf_gpu_gradient", (DL_FUNC) &_bgms_test_omrf_gpu_gradient, 5},
+    {"_bgms_test_omrf_batched_gradient", (DL_FUNC) &_bgms_test_omrf_batched_gradient, 7},
+    {"_bgms_test_omrf_impute_missing", (DL_FUNC) &_bgms_test_omrf_impute_missing, 9},
+    {"_bgms_test_omrf_log_normalizer_cache", (DL_FUNC) &_bgms_test_omrf_log_normalizer_cache, 9},
     {"_bgms_test_omrf_residual_invariant", (DL_FUNC) &_bgms_test_omrf_residual_invariant, 8},
     {"_bgms_test_parameter_prior", (DL_FUNC) &_bgms_test_parameter_prior, 6},
     {"_bgms_test_scale_prior", (DL_FUNC) &_bgms_test_scale_prior, 4},
+    {"_bgms_test_parameter_prior_batch", (DL_FUNC) &_bgms_test_parameter_prior_batch, 6},
     {"_bgms_ggm_test_logp_and_gradient_prior", (DL_FUNC) &_bgms_ggm_test_logp_and_gradient_prior, 11},
-    {"_bgms_sample_ggm", (DL_FUNC) &_bgms_sample_ggm, 24},
-    {"_bgms_sample_mixed_mrf", (DL_FUNC) &_bgms_sample_mixed_mrf, 25},
-    {"_bgms_sample_omrf", (DL_FUNC) &_bgms_sample_omrf, 24},
+    {"_bgms_test_edge_prior_toggles", (DL_FUNC) &_bgms_test_edge_prior_toggles, 5},
+    {"_bgms_test_sbm_allocations", (DL_FUNC) &_bgms_test_sbm_allocations, 10},
+    {"_bgms_test_rng_fills", (DL_FUNC) &_bgms_test_rng_fills, 2},
+    {"_bgms_test_polya_gamma", (DL_FUNC) &_bgms_test_polya_gamma, 3},
+    {"_bgms_benchmark_rng_fills", (DL_FUNC) &_bgms_benchmark_rng_fills, 2},
+    {"_bgms_sample_ggm", (DL_FUNC) &_bgms_sample_ggm, 25},
+    {"_bgms_sample_mixed_mrf", (DL_FUNC) &_bgms_sample_mixed_mrf, 26},
+    {"_bgms_sample_omrf", (DL_FUNC) &_bgms_sample_omrf, 25},
+    {"_bgms_omrf_gpu_backend_available", (DL_FUNC) &_bgms_omrf_gpu_backend_available, 0},
+    {"_bgms_sample_omrf_batch", (DL_FUNC) &_bgms_sample_omrf_batch, 20},
+    {"_bgms_test_chunked_file_sink", (DL_FUNC) &_bgms_test_chunked_file_sink, 4},
+    {"_bgms_sampler_session_extend", (DL_FUNC) &_bgms_sampler_session_extend, 5},
+    {"_bgms_sampler_session_update_data", (DL_FUNC) &_bgms_sampler_session_update_data, 3},
     {"_bgms_compute_Vn_mfm_sbm", (DL_FUNC) &_bgms_compute_Vn_mfm_sbm, 4},
+    {"_bgms_write_score_file_cpp", (DL_FUNC) &_bgms_write_score_file_cpp, 2},
+    {"_bgms_score_file_summary", (DL_FUNC) &_bgms_score_file_summary, 1},
     {NULL, NULL, 0}
 };
 
@@ -0,0 +1,292 @@
+// benchmark_interface.cpp - development benchmarks of the sampler hot paths
+//
+// Times the kernels that dominate a bgm() iteration on synthetic data of a
+// given size, so releases can be compared. Used by the driver in
+// inst/benchmarks/run_benchmarks.R, which sweeps a grid of sizes and adds
+// the R-level kernels (simulate_mrf, ESS and Rhat).
+#include <RcppArmadillo.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "math/cholupdate.h"
+#include "mcmc/algorithms/nuts.h"
+#include "models/ggm/ggm_gradient.h"
+#include "models/ggm/graph_constraint_structure.h"
+#include "models/mixed/mixed_mrf_model.h"
+#include "models/omrf/omrf_model.h"
+#include "priors/edge_prior.h"
+#include "priors/parameter_prior.h"
+#include "rng/rng_utils.h"
+#include "utils/variable_helpers.h"
+
+namespace {
+
+// Symmetric 0/1 matrix with each off-diagonal pair included with
+// probability `density`.
+arma::imat random_graph(const int p, const double density, SafeRNG& rng) {
+    arma::imat graph(p, p, arma::fill::zeros);
+    for (int j = 1; j < p; ++j) {
+        for (int i = 0; i < j; ++i) {
+            graph(i, j) = graph(j, i) = runif(rng) < density ? 1 : 0;
+        }
+    }
+    return graph;
+}
+
+arma::imat random_categories(const int n, const int p, const int num_cats, SafeRNG& rng) {
+    arma::imat x(n, p);
+    for (arma::uword k = 0; k < x.n_elem; ++k) {
+        x(k) = std::min(num_cats, static_cast<int>(runif(rng) * (num_cats + 1)));
+    }
+    return x;
+}
+
+arma::vec random_normal(const arma::uword n, const double scale, SafeRNG& rng) {
+    arma::vec x(n);
+    for (arma::uword k = 0; k < n; ++k) x(k) = scale * rnorm(rng);
+    return x;
+}
+
+// Per-call timings of `body` in microseconds, after one untimed warm-up
+// call that sizes the workspaces.
+struct Timer {
+    int reps;
+    std::vector<double> times;
+
+    template <typename Body>
+    std::pair<double, double> operator()(Body&& body) {
+        body();
+        times.assign(reps, 0.0);
+        for (int r = 0; r < reps; ++r) {
+            auto t0 = std::chrono::steady_clock::now();
+            body();
+            auto t1 = std::chrono::steady_clock::now();
+            times[r] = std::chrono::duration<double, std::micro>(t1 - t0).count();
+        }
+        std::sort(times.begin(), times.end());
+        const double median = reps % 2 == 1
+            ? times[reps / 2]
+            : 0.5 * (times[reps / 2 - 1] + times[reps / 2]);
+        return {median, times.front()};
+    }
+};
+
+} // namespace
+
+// Benchmark of the C++ hot paths on synthetic data: n observations of p
+// variables with `num_categories` + 1 response categories, and a random
+// graph with the given edge density for the models. Each kernel is called
+// `reps` times after a warm-up call; `median_us` and `min_us` are
+// microseconds per call.
+//
+// Kernels: the ordinal and Blume-Capel log-normalizers of one variable
+// (logz_ordinal, logz_blume_capel), the OMRF, GGM and mixed MRF
+// log-pseudoposteriors with their gradients, the OMRF gradients of four
+// chains evaluated one by one and in one batched pass
+// (omrf_gradient_4_chains_separate, omrf_gradient_4_chains_batched), one
+// NUTS transition on the OMRF target (max tree depth 6), a rank-one Cholesky update plus downdate
+// of a p x p factor, sequentially (cholesky_update_downdate) and in one pass
+// (cholesky_rank2_one_pass), and one SBM allocation sweep of the edge prior. The
+// mixed MRF splits the p variables into ceiling(p / 2) ordinal and the rest
+// continuous. Development helper: bgms:::benchmark_hot_paths(2000, 10).
+// [[Rcpp::export]]
+Rcpp::DataFrame benchmark_hot_paths(
+    const int n,
+    const int p,
+    const int num_categories = 4,
+    const double density = 0.5,
+    const int reps = 50,
+    const int threads = 1,
+    const int seed = 1)
+{
+    if (n < 2 || p < 2 || num_categories < 1 || reps < 1) {
+        Rcpp::stop("benchmark_hot_paths needs n >= 2, p >= 2, num_categories >= 1 and reps >= 1");
+    }
+
+    SafeRNG rng(seed);
+    Timer time_us{reps, {}};
+    std::vector<std::string> kernels;
+    std::vector<double> median_us, min_us;
+    double sink = 0.0;
+
+    auto record = [&](const std::string& kernel, std::pair<double, double> t) {
+        kernels.push_back(kernel);
+        median_us.push_back(t.first);
+        min_us.push_back(t.second);
+    };
+
+    // --- Log-normalizer kernels of one variable ------------------------------
+    {
+        const arma::vec residual = random_normal(n, 0.5, rng);
+        const arma::vec thresholds = random_normal(num_categories, 0.5, rng);
+        const arma::vec bound = num_categories * residual;
+        arma::vec bc_bound;
+        LogZAndProbs out;
+        LogZScratch scratch;
+
+        record("logz_ordinal", time_us([&] {
+            compute_logZ_and_probs_ordinal_into(thresholds, residual, bound,
+                                                num_categories, out, scratch);
+            sink += out.log_Z(0);
+        }));
+        record("logz_blume_capel", time_us([&] {
+            compute_logZ_and_probs_blume_capel_into(residual, 0.2, -0.1, num_categories / 2,
+                                                    num_categories, bc_bound, out, scratch);
+            sink += out.log_Z(0);
+        }));
+    }
+
+    const arma::imat graph = random_graph(p, density, rng);
+
+    // --- OMRF log-pseudoposterior and NUTS transition ------------------------
+    {
+        const arma::imat x = random_categories(n, p, num_categories, rng);
+        const arma::ivec cats(p, arma::fill::value(num_categories));
+        const arma::uvec ordinal(p, arma::fill::ones);
+        const arma::ivec baseline(p, arma::fill::zeros);
+        const arma::mat incl_prob(p, p, arma::fill::value(0.5));
+
+        OMRFModel model(
+            x, cats, incl_prob, graph, ordinal, baseline,
+            create_parameter_prior("cauchy", 2.5),
+            create_parameter_prior("beta-prime", 1.0, 0.5, 0.5),
+            /*edge_selection=*/true);
+        model.set_gradient_threads(threads);
+
+        const arma::vec theta = random_normal(model.parameter_dimension(), 0.1, rng);
+        record("omrf_logp_and_gradient", time_us([&] {
+            sink += model.logp_and_gradient(theta).first;
+        }));
+
+        const std::function<std::pair<double, arma::vec>(const arma::vec&)> joint =
+            [&model](const arma::vec& t) { return model.logp_and_gradient(t); };
+        const arma::vec inv_mass = arma::ones<arma::vec>(theta.n_elem);
+        NUTSArena arena;
+        record("nuts_step_omrf", time_us([&] {
+            StepResult res = nuts_step(theta, 0.05, joint, inv_mass, rng, 6,
+                                       nullptr, nullptr, true, 0.5, &arena);
+            sink += res.state(0);
+        }));
+
+        // Four chains on the same observations, each evaluated on its own
+        // and all of them in one batched pass over the data
+        constexpr int lockstep_chains = 4;
+        std::vector<std::unique_ptr<OMRFModel>> chains;
+        std::vector<BaseModel*> batch;
+        std::vector<arma::vec> thetas;
+        for (int k = 0; k < lockstep_chains; ++k) {
+            chains.push_back(std::make_unique<OMRFModel>(model));
+            batch.push_back(chains.back().get());
+            thetas.push_back(theta + 0.01 * k);
+        }
+        std::vector<std::pair<double, arma::vec>> results;
+        record("omrf_gradient_4_chains_separate", time_us([&] {
+            for (int k = 0; k < lockstep_chains; ++k) {
+                sink += chains[k]->logp_and_gradient(thetas[k]).first;
+            }
+        }));
+        record("omrf_gradient_4_chains_batched", time_us([&] {
+            chains.front()->logp_and_gradient_batch(batch, thetas, results);
+            sink += results.front().first;
+        }));
+    }
+
+    // --- GGM gradient engine -------------------------------------------------
+    {
+        GraphConstraintStructure cs;
+        cs.build(graph);
+        const arma::mat suf_stat = static_cast<double>(n) * arma::eye(p, p);
+        CauchyPrior ip(2.5);
+        GammaScalePrior dp(1.0, 1.0);
+        GGMGradientEngine engine;
+        engine.rebuild(cs, static_cast<size_t>(n), suf_stat, ip, dp);
+
+        const arma::vec theta = random_normal(cs.active_dim, 0.1, rng);
+        record("ggm_logp_and_gradient", time_us([&] {
+            sink += engine.logp_and_gradient(theta).first;
+        }));
+    }
+
+    // --- Mixed MRF log-pseudoposterior ---------------------------------------
+    {
+        const int p_discrete = (p + 1) / 2;
+        const int q = p - p_discrete;
+        const arma::imat x = random_categories(n, p_discrete, num_categories, rng);
+        arma::mat y(n, q);
+        y.imbue([&] { return rnorm(rng); });
+        const arma::mat incl_prob(p, p, arma::fill::value(0.5));
+
+        MixedMRFModel model(
+            x, y,
+            arma::ivec(p_discrete, arma::fill::value(num_categories)),
+            arma::uvec(p_discrete, arma::fill::ones),
+            arma::ivec(p_discrete, arma::fill::zeros),
+            incl_prob, graph, /*edge_selection=*/true,
+            create_parameter_prior("cauchy", 2.5),
+            create_parameter_prior("beta-prime", 1.0, 0.5, 0.5),
+            create_parameter_prior("normal", 1.0),
+            create_scale_prior("gamma", 1.0, 1.0),
+            seed);
+
+        const arma::vec theta = model.get_vectorized_parameters();
+        record("mixed_logp_and_gradient", time_us([&] {
+            sink += model.logp_and_gradient(theta).first;
+        }));
+    }
+
+    // --- Rank-one Cholesky update and downdate -------------------------------
+    {
+        arma::mat a(p, p);
+        a.imbue([&] { return rnorm(rng); });
+        arma::mat R = arma::chol(a.t() * a + p * arma::eye(p, p));
+        const arma::vec u0 = random_normal(p, 1.0, rng);
+        arma::vec u;
+        record("cholesky_update_downdate", time_us([&] {
+            u = u0;
+            cholesky_update(R, u);
+            u = u0;
+            cholesky_downdate(R, u);
+            sink += R(0, 0);
+        }));
+
+        arma::mat U(p, 2);
+        U.col(0) = u0;
+        U.col(1) = u0;
+        CholeskyUpdateWorkspace ws;
+        record("cholesky_rank2_one_pass", time_us([&] {
+            cholesky_rank_update(R, U, 1, ws);
+            sink += R(0, 0);
+        }));
+    }
+
+    // --- SBM allocation sweep ------------------------------------------------
+    {
+        StochasticBlockEdgePrior prior(1.0, 1.0, 1.0, 1.0, 1.0, 1.0);
+        arma::mat incl_prob(p, p, arma::fill::value(0.5));
+        const int num_pairwise = p * (p - 1) / 2;
+        record("sbm_allocations", time_us([&] {
+            prior.update(graph, incl_prob, p, num_pairwise, rng);
+            sink += incl_prob(0, 1);
+        }));
+    }
+
+    const R_xlen_t k = static_cast<R_xlen_t>(kernels.size());
+    Rcpp::DataFrame out = Rcpp::DataFrame::create(
+        Rcpp::Named("kernel")     = Rcpp::wrap(kernels),
+        Rcpp::Named("n")          = Rcpp::IntegerVector(k, n),
+        Rcpp::Named("p")          = Rcpp::IntegerVector(k, p),
+        Rcpp::Named("categories") = Rcpp::IntegerVector(k, num_categories),
+        Rcpp::Named("density")    = Rcpp::NumericVector(k, density),
+        Rcpp::Named("reps")       = Rcpp::IntegerVector(k, reps),
+        Rcpp::Named("median_us")  = Rcpp::wrap(median_us),
+        Rcpp::Named("min_us")     = Rcpp::wrap(min_us),
+        Rcpp::Named("stringsAsFactors") = false
+    );
+    out.attr("checksum") = sink;
+    return out;
+}
@@ -0,0 +1,99 @@
+// bgmcompare_residual_test_interface.cpp - test-only interface
+//
+// Exposes a harness to verify that the per-group residual matrices
+// BGMCompareModel keeps across its Metropolis updates stay equal to a fresh
+// rebuild, and that keeping them draws what rebuilding them does. Used by
+// tests/testthat.
+#include <RcppArmadillo.h>
+#include <algorithm>
+#include <vector>
+
+#include "models/bgmCompare/bgmCompare_model.h"
+#include "priors/parameter_prior.h"
+
+// Build a bgmCompare model with difference selection from the arguments
+// run_bgmCompare_parallel() takes, then run `iterations` Metropolis sweeps
+// of the main and pairwise effects and the difference indicators twice from
+// `seed`: once keeping the residual matrices across updates, once marking
+// them stale before every update so each update starts from a rebuild, as
+// it did before the matrices were kept. Returns the storage parameters and
+// indicators after every sweep of both runs, and the largest difference
+// between the kept residual matrices and a rebuild over all sweeps.
+//
+// [[Rcpp::export]]
+Rcpp::List test_bgmcompare_residuals(
+    const arma::imat& observations,
+    int num_groups,
+    const std::vector<arma::imat>& counts_per_category,
+    const std::vector<arma::imat>& blume_capel_stats,
+    const std::vector<arma::mat>& pairwise_stats,
+    const arma::ivec& num_categories,
+    const arma::uvec& is_ordinal_variable,
+    const arma::ivec& baseline_category,
+    const arma::imat& main_effect_indices,
+    const arma::imat& pairwise_effect_indices,
+    const arma::mat& projection,
+    const arma::ivec& group_membership,
+    const arma::imat& group_indices,
+    const arma::imat& interaction_index_matrix,
+    const arma::mat& pairwise_scaling_factors,
+    const arma::mat& inclusion_probability,
+    const int iterations,
+    const int seed
+) {
+    BGMCompareModel kept(
+        observations, num_groups,
+        counts_per_category, blume_capel_stats, pairwise_stats,
+        num_categories, is_ordinal_variable, baseline_category,
+        main_effect_indices, pairwise_effect_indices, projection,
+        group_membership, group_indices, interaction_index_matrix,
+        pairwise_scaling_factors, inclusion_probability,
+        create_parameter_prior("cauchy", 1.0),
+        create_parameter_prior("cauchy", 1.0),
+        create_parameter_prior("beta-prime", 1.0, 0.5, 0.5),
+        /*difference_selection=*/true, /*main_difference_selection=*/false);
+    kept.set_rng(SafeRNG(seed));
+    kept.set_edge_selection_active(true);
+    BGMCompareModel rebuilt(kept);
+
+    const int dim = static_cast<int>(kept.get_storage_vectorized_parameters().n_elem);
+    const int num_indicators = static_cast<int>(kept.get_vectorized_indicator_parameters().n_elem);
+    arma::mat params_kept(iterations, dim), params_rebuilt(iterations, dim);
+    arma::imat indicators_kept(iterations, num_indicators);
+    arma::imat indicators_rebuilt(iterations, num_indicators);
+    double max_residual_error = 0.0;
+
+    for (int iter = 0; iter < iterations; ++iter) {
+        kept.prepare_iteration();
+        kept.do_one_metropolis_step(iter);
+        kept.update_edge_indicators();
+
+        rebuilt.prepare_iteration();
+        rebuilt.invalidate_residual_matrices();
+        rebuilt.do_one_metropolis_step(iter);
+        rebuilt.invalidate_residual_matrices();
+        rebuilt.update_edge_indicators();
+
+        BGMCompareModel fresh(kept);
+        fresh.invalidate_residual_matrices();
+        const std::vector<arma::mat>& residuals = kept.get_residual_matrices();
+        const std::vector<arma::mat>& expected = fresh.get_residual_matrices();
+        for (size_t g = 0; g < residuals.size(); ++g) {
+            max_residual_error = std::max(
+                max_residual_error, arma::abs(residuals[g] - expected[g]).max());
+        }
+
+        params_kept.row(iter) = kept.get_storage_vectorized_parameters().t();
+        params_rebuilt.row(iter) = rebuilt.get_storage_vectorized_parameters().t();
+        indicators_kept.row(iter) = kept.get_vectorized_indicator_parameters().t();
+        indicators_rebuilt.row(iter) = rebuilt.get_vectorized_indicator_parameters().t();
+    }
+
+    return Rcpp::List::create(
+        Rcpp::Named("parameters_kept")     = params_kept,
+        Rcpp::Named("parameters_rebuilt")  = params_rebuilt,
+        Rcpp::Named("indicators_kept")     = indicators_kept,
+        Rcpp::Named("indicators_rebuilt")  = indicators_rebuilt,
+        Rcpp::Named("max_residual_error")  = max_residual_error
+    );
+}
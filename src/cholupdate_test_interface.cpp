@@ -0,0 +1,47 @@
+// cholupdate_test_interface.cpp - test-only interface
+//
+// Exposes the Cholesky update kernels of math/cholupdate.h. Used by
+// tests/testthat to check that the one-pass rank-k update gives the same
+// factor as the rank-1 updates and downdates applied in turn.
+#include <RcppArmadillo.h>
+
+#include "math/cholupdate.h"
+
+// Apply the columns of U to the upper Cholesky factor R: the first
+// `num_updates` as updates, the rest as downdates. With `sequential` the
+// rank-1 routines run one column at a time, otherwise
+// cholesky_rank_update() applies all columns in one pass. Returns NULL if
+// the one-pass kernel reports a downdate that is not positive definite.
+//
+// [[Rcpp::export]]
+SEXP test_cholesky_rank_update(
+    arma::mat R,
+    const arma::mat& U,
+    const int num_updates,
+    const bool sequential = false
+) {
+    if (R.n_rows != R.n_cols || U.n_rows != R.n_cols) {
+        Rcpp::stop("R must be square with as many rows as U");
+    }
+    if (num_updates < 0 || num_updates > static_cast<int>(U.n_cols)) {
+        Rcpp::stop("num_updates must be between 0 and ncol(U)");
+    }
+
+    if (sequential) {
+        for (arma::uword c = 0; c < U.n_cols; ++c) {
+            arma::vec u = U.col(c);
+            if (static_cast<int>(c) < num_updates) {
+                cholesky_update(R, u);
+            } else {
+                cholesky_downdate(R, u);
+            }
+        }
+        return Rcpp::wrap(R);
+    }
+
+    CholeskyUpdateWorkspace ws;
+    if (!cholesky_rank_update(R, U, static_cast<arma::uword>(num_updates), ws)) {
+        return R_NilValue;
+    }
+    return Rcpp::wrap(R);
+}
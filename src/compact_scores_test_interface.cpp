@@ -0,0 +1,47 @@
+#include <RcppArmadillo.h>
+#include "math/compact_scores.h"
+
+// The CompactScores kernels next to their double-matrix counterparts, for
+// scores x (n x p), a length-n vector v and a p x k matrix B. `set_value`
+// is written into cell (0, 0) first, so a value outside int8 exercises the
+// switch to 16-bit storage. The columns are also packed with shifts 0, 1,
+// ..., p - 1, as the OMRF centers its Blume-Capel columns.
+// [[Rcpp::export]]
+Rcpp::List test_compact_scores(const arma::imat& x, const arma::vec& v,
+                               const arma::mat& B, const int set_value,
+                               const int panel_rows = 256) {
+  CompactScores scores(x);
+  scores.set(0, 0, set_value);
+  arma::imat updated = x;
+  updated(0, 0) = set_value;
+
+  arma::vec tmul(scores.n_cols());
+  scores.tmul(v, tmul.memptr());
+
+  arma::vec add_scaled = v;
+  scores.add_scaled(scores.n_cols() - 1, 0.5, add_scaled.memptr());
+
+  arma::mat product, panel;
+  scores.mul(B, 2.0, product, panel, panel_rows);
+
+  arma::ivec shift = arma::regspace<arma::ivec>(0, x.n_cols - 1);
+  CompactScores shifted(x, shift);
+  arma::imat shifted_dense = x;
+  shifted_dense.each_row() -= shift.t();
+
+  const arma::mat dense = arma::conv_to<arma::mat>::from(updated);
+  return Rcpp::List::create(
+    Rcpp::Named("bytes_per_score") = scores.bytes_per_score(),
+    Rcpp::Named("roundtrip") = arma::approx_equal(scores.to_double(), dense, "absdiff", 0.0),
+    Rcpp::Named("tmul") = tmul,
+    Rcpp::Named("tmul_dense") = arma::vec(dense.t() * v),
+    Rcpp::Named("add_scaled") = add_scaled,
+    Rcpp::Named("add_scaled_dense") = arma::vec(v + 0.5 * dense.col(dense.n_cols - 1)),
+    Rcpp::Named("mul") = product,
+    Rcpp::Named("mul_dense") = arma::mat(2.0 * dense * B),
+    Rcpp::Named("gram") = scores.gram(panel_rows),
+    Rcpp::Named("gram_dense") = arma::mat(dense.t() * dense),
+    Rcpp::Named("shifted_roundtrip") = arma::approx_equal(
+        shifted.to_double(), arma::conv_to<arma::mat>::from(shifted_dense), "absdiff", 0.0)
+  );
+}
@@ -1,5 +1,10 @@
+#include <RcppArmadillo.h>
+#include <chrono>
+#include <cmath>
+#include "math/categorical.h"
 #include "math/explog_macros.h"
-#include "Rcpp.h"
+#include "math/custom_explog.h"
+#include "math/simd_explog.h"
 
 // [[Rcpp::export]]
 Rcpp::String get_explog_switch() {
@@ -26,4 +31,108 @@ Rcpp::NumericVector rcpp_ieee754_log(Rcpp::NumericVector x) {
     y[i] = MY_LOG(x[i]);
   }
   return y;
-}
\ No newline at end of file
+}
+
+// Element-wise exp/log through the ARMA_MY_EXP / ARMA_MY_LOG path that the
+// samplers use (the vectorized kernels unless built with SIMD_EXP_LOG=0).
+// [[Rcpp::export]]
+Rcpp::NumericVector rcpp_vector_exp(const arma::vec& x) {
+  arma::vec y = ARMA_MY_EXP(x);
+  return Rcpp::NumericVector(y.begin(), y.end());
+}
+
+// [[Rcpp::export]]
+Rcpp::NumericVector rcpp_vector_log(const arma::vec& x) {
+  arma::vec y = ARMA_MY_LOG(x);
+  return Rcpp::NumericVector(y.begin(), y.end());
+}
+
+// Instruction set picked by the vectorized exp/log dispatcher, or
+// "disabled" when ARMA_MY_EXP / ARMA_MY_LOG do not route through it.
+// [[Rcpp::export]]
+Rcpp::String get_simd_explog_isa() {
+#if USE_SIMD_EXP_LOG
+  return simd_explog_isa();
+#else
+  return "disabled";
+#endif
+}
+
+// Log-sum-exp and categorical draws of each column of `log_weights`:
+// the array and streaming log-sum-exp, the log-softmax, and the 0-based
+// category drawn at `uniforms` by the batched sampler (after log-softmax)
+// and by the scalar log-weight sampler.
+// [[Rcpp::export]]
+Rcpp::List test_categorical(const arma::mat& log_weights, const arma::vec& uniforms) {
+  const arma::uword n_cols = log_weights.n_cols;
+  const int n = static_cast<int>(log_weights.n_rows);
+  arma::vec lse(n_cols), lse_stream(n_cols);
+  arma::ivec draws_log(n_cols);
+  for (arma::uword j = 0; j < n_cols; ++j) {
+    lse[j] = log_sum_exp(log_weights.colptr(j), log_weights.n_rows);
+    LogSumExp stream;
+    for (int k = 0; k < n; ++k) stream.add(log_weights(k, j));
+    lse_stream[j] = stream.value();
+    arma::vec column = log_weights.col(j);
+    draws_log[j] = sample_categorical_log(column.memptr(), n, uniforms[j]);
+  }
+
+  arma::mat log_softmax = log_weights;
+  log_softmax_columns(log_softmax);
+  arma::mat weights = log_softmax;
+  arma::uvec draws;
+  sample_categorical_exp_columns(weights, uniforms, draws);
+
+  return Rcpp::List::create(
+    Rcpp::Named("log_sum_exp")        = Rcpp::NumericVector(lse.begin(), lse.end()),
+    Rcpp::Named("log_sum_exp_stream") = Rcpp::NumericVector(lse_stream.begin(), lse_stream.end()),
+    Rcpp::Named("log_softmax")        = log_softmax,
+    Rcpp::Named("draws")              = Rcpp::IntegerVector(draws.begin(), draws.end()),
+    Rcpp::Named("draws_log")          = Rcpp::IntegerVector(draws_log.begin(), draws_log.end())
+  );
+}
+
+// Benchmark of the element-wise exp/log implementations on a vector of
+// length n, repeated `reps` times. Returns nanoseconds per element for
+// std::exp/std::log, OpenLibM, arma::exp/arma::log and the vectorized
+// kernels. Development helper: bgms:::benchmark_explog_kernels().
+// [[Rcpp::export]]
+Rcpp::DataFrame benchmark_explog_kernels(const int n = 4096, const int reps = 2000) {
+  arma::vec x_exp = arma::linspace<arma::vec>(-40.0, 40.0, n);
+  arma::vec x_log = arma::linspace<arma::vec>(1e-3, 1e3, n);
+  arma::vec y(n);
+  double sink = 0.0;
+
+  auto time_ns = [&](auto&& body) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; ++r) {
+      body();
+      sink += y[r % n];
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() /
+      (static_cast<double>(reps) * n);
+  };
+
+  Rcpp::CharacterVector impl = {"std", "openlibm", "armadillo", "simd"};
+  Rcpp::NumericVector exp_ns(4), log_ns(4);
+
+  exp_ns[0] = time_ns([&] { for (int i = 0; i < n; ++i) y[i] = std::exp(x_exp[i]); });
+  exp_ns[1] = time_ns([&] { for (int i = 0; i < n; ++i) y[i] = __ieee754_exp(x_exp[i]); });
+  exp_ns[2] = time_ns([&] { y = arma::exp(x_exp); });
+  exp_ns[3] = time_ns([&] { simd_exp(x_exp.memptr(), y.memptr(), n); });
+
+  log_ns[0] = time_ns([&] { for (int i = 0; i < n; ++i) y[i] = std::log(x_log[i]); });
+  log_ns[1] = time_ns([&] { for (int i = 0; i < n; ++i) y[i] = __ieee754_log(x_log[i]); });
+  log_ns[2] = time_ns([&] { y = arma::log(x_log); });
+  log_ns[3] = time_ns([&] { simd_log(x_log.memptr(), y.memptr(), n); });
+
+  Rcpp::DataFrame out = Rcpp::DataFrame::create(
+    Rcpp::Named("implementation") = impl,
+    Rcpp::Named("exp_ns")         = exp_ns,
+    Rcpp::Named("log_ns")         = log_ns
+  );
+  out.attr("isa") = simd_explog_isa();
+  out.attr("checksum") = sink;
+  return out;
+}
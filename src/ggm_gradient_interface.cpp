@@ -1,11 +1,15 @@
 // Test interface for the GGM gradient engine and RATTLE projection.
 //
 // Exposes logp_and_gradient, forward_map, project_position,
-// project_momentum, and constrained leapfrog to R for validation.
+// project_momentum, and constrained leapfrog to R for validation, a
+// benchmark of the gradient engine's workspace reuse, the missing-data
+// imputation sweep, and the sparse Cholesky factor of the Metropolis sweeps.
 // Also exposes sample_ggm_prior() for sampling from the GGM prior
 // from the GGM prior using NUTS.
 
+#include <chrono>
 #include <RcppArmadillo.h>
+#include "math/sparse_cholesky.h"
 #include "models/ggm/graph_constraint_structure.h"
 #include "models/ggm/ggm_gradient.h"
 #include "models/ggm/ggm_model.h"
@@ -61,15 +65,89 @@ Rcpp::List ggm_test_forward_map(
 
     ForwardMapResult fm = engine.forward_map(theta);
 
+    // Inverse map through the engine's workspace, for round-trip checks
+    arma::vec theta_back;
+    engine.theta_from_phi(cs, fm.Phi, theta_back);
+
     return Rcpp::List::create(
         Rcpp::Named("Phi") = Rcpp::wrap(fm.Phi),
         Rcpp::Named("K") = Rcpp::wrap(fm.K),
         Rcpp::Named("log_det_jacobian") = fm.log_det_jacobian,
-        Rcpp::Named("psi") = Rcpp::wrap(fm.psi)
+        Rcpp::Named("psi") = Rcpp::wrap(fm.psi),
+        Rcpp::Named("theta") = Rcpp::wrap(theta_back)
     );
 }
 
 
+// Benchmark of GGMGradientEngine::logp_and_gradient on random graphs with
+// the given edge density. For each p, `fresh_us` times an engine rebuilt
+// for every call (so its workspace is allocated per call, as a leapfrog
+// step did before the engine kept one) and `reused_us` one engine
+// evaluated repeatedly. Microseconds per gradient. Development helper:
+// bgms:::benchmark_ggm_gradient(c(20, 50, 100, 200)).
+// [[Rcpp::export]]
+Rcpp::DataFrame benchmark_ggm_gradient(
+    const Rcpp::IntegerVector& p_values,
+    const double density = 0.3,
+    const int reps = 50,
+    const int seed = 1)
+{
+    const R_xlen_t k = p_values.size();
+    Rcpp::IntegerVector edges(k);
+    Rcpp::NumericVector fresh_us(k), reused_us(k);
+    SafeRNG rng(seed);
+    CauchyPrior ip(1.0);
+    GammaScalePrior dp(1.0, 1.0);
+    double sink = 0.0;
+
+    for (R_xlen_t r = 0; r < k; ++r) {
+        const int p = p_values[r];
+        arma::imat G(p, p, arma::fill::ones);
+        int m = 0;
+        for (int j = 1; j < p; ++j) {
+            for (int i = 0; i < j; ++i) {
+                G(i, j) = G(j, i) = runif(rng) < density ? 1 : 0;
+                m += G(i, j);
+            }
+        }
+        edges[r] = m;
+
+        GraphConstraintStructure cs;
+        cs.build(G);
+        arma::mat S = 100.0 * arma::eye(p, p);
+        arma::vec theta(cs.active_dim);
+        for (arma::uword t = 0; t < theta.n_elem; ++t) theta(t) = 0.1 * rnorm(rng);
+
+        auto time_us = [&](auto&& body) {
+            auto t0 = std::chrono::steady_clock::now();
+            for (int rep = 0; rep < reps; ++rep) body();
+            auto t1 = std::chrono::steady_clock::now();
+            return std::chrono::duration<double, std::micro>(t1 - t0).count() / reps;
+        };
+
+        fresh_us[r] = time_us([&] {
+            GGMGradientEngine engine;
+            engine.rebuild(cs, 100, S, ip, dp);
+            sink += engine.logp_and_gradient(theta).first;
+        });
+
+        GGMGradientEngine engine;
+        engine.rebuild(cs, 100, S, ip, dp);
+        reused_us[r] = time_us([&] {
+            sink += engine.logp_and_gradient(theta).first;
+        });
+    }
+
+    Rcpp::DataFrame out = Rcpp::DataFrame::create(
+        Rcpp::Named("p")         = p_values,
+        Rcpp::Named("edges")     = edges,
+        Rcpp::Named("fresh_us")  = fresh_us,
+        Rcpp::Named("reused_us") = reused_us
+    );
+    out.attr("checksum") = sink;
+    return out;
+}
+
 
 // -----------------------------------------------------------------------------
 // sample_ggm_prior: Sample from the GGM prior (K_yy = -K/2 partial-association
@@ -177,7 +255,7 @@ Rcpp::List sample_ggm_prior(
     // Samples are stored as the upper triangle of K (p(p+1)/2 elements per
     // iteration, column-wise iteration index): see GGMModel::extract_upper_triangle.
     // Layout: for i in 0..p-1, for j in i..p-1, entry K(i,j).
-    const arma::mat& samples = results[0].samples;  // dim x no_iter
+    const arma::mat& samples = results[0].samples.view();  // dim x no_iter
 
     int n_edges = p * (p - 1) / 2;
     arma::mat K_offdiag_samples(n_samples, n_edges);
@@ -224,3 +302,106 @@ Rcpp::List sample_ggm_prior(
         Rcpp::Named("edge_indicators") = Rcpp::wrap(edge_indicators)
     );
 }
+
+
+// Runs `sweeps` imputation sweeps of a GGM (full graph) at its initial
+// (MLE warm-start) precision, which impute_missing() leaves unchanged. Returns the draws of
+// the missing cells (sweeps x M, in the row order of missing_index), that
+// precision, and the largest absolute difference over all sweeps between
+// the incrementally updated X'X and X'X of the imputed data.
+//
+// [[Rcpp::export]]
+Rcpp::List ggm_test_impute_missing(
+    const arma::mat& observations,
+    const arma::imat& missing_index,
+    int sweeps,
+    int seed = 1)
+{
+    const arma::uword p = observations.n_cols;
+    GGMModel model(
+        observations, arma::mat(p, p, arma::fill::value(0.5)),
+        arma::imat(p, p, arma::fill::ones), false,
+        create_parameter_prior("cauchy", 1.0),
+        create_scale_prior("gamma", 1.0, 1.0),
+        /*na_impute=*/true);
+    model.set_rng(SafeRNG(seed));
+    model.set_missing_data(missing_index);
+
+    // Upper triangle of K, row by row (see GGMModel::extract_upper_triangle)
+    const arma::vec upper = model.get_storage_vectorized_parameters();
+    arma::mat precision(p, p);
+    arma::uword e = 0;
+    for (arma::uword i = 0; i < p; ++i) {
+        for (arma::uword j = i; j < p; ++j) {
+            precision(i, j) = precision(j, i) = upper(e++);
+        }
+    }
+
+    arma::mat draws(sweeps, missing_index.n_rows);
+    double max_suf_stat_error = 0.0;
+    for (int s = 0; s < sweeps; ++s) {
+        model.impute_missing();
+        const arma::mat& x = model.observations();
+        for (arma::uword m = 0; m < missing_index.n_rows; ++m) {
+            draws(s, m) = x(missing_index(m, 0), missing_index(m, 1));
+        }
+        const arma::mat exact = x.t() * x;
+        max_suf_stat_error = std::max(
+            max_suf_stat_error,
+            arma::abs(model.sufficient_statistic() - exact).max());
+    }
+
+    return Rcpp::List::create(
+        Rcpp::Named("draws") = draws,
+        Rcpp::Named("precision") = precision,
+        Rcpp::Named("max_suf_stat_error") = max_suf_stat_error
+    );
+}
+
+
+// Factors `precision` over the pattern of `edge_indicators` with the sparse
+// Cholesky factor of the GGM Metropolis sweeps, applies the rank-one change
+// precision + sigma w w' (w = w_values at the 1-based rows w_index, one or
+// two of them; an edge of the graph if two), and returns log|K|, the number
+// of nonzeros of the factor and the covariance entries (i,i), (i,j), (j,j)
+// for each 1-based row (i, j) of `pairs`, all after the change.
+//
+// [[Rcpp::export]]
+Rcpp::List ggm_test_sparse_cholesky(
+    const arma::mat& precision,
+    const arma::imat& edge_indicators,
+    const arma::imat& pairs,
+    const arma::ivec& w_index,
+    const arma::vec& w_values,
+    int sigma = 1)
+{
+    GraphConstraintStructure cs;
+    cs.build(edge_indicators);
+    SparseCholesky factor;
+    factor.analyze(precision.n_cols, [&cs](size_t q) -> const std::vector<size_t>& {
+        return cs.columns[q].included_indices;
+    });
+    if (!factor.factorize([&](size_t i, size_t j) { return precision(i, j); })) {
+        Rcpp::stop("precision is not positive definite");
+    }
+
+    const size_t a = w_index(0) - 1;
+    const size_t b = w_index(w_index.n_elem - 1) - 1;
+    if (a != b && !factor.contains(a, b)) {
+        Rcpp::stop("w_index must be a diagonal entry or an edge of the graph");
+    }
+    const bool ok = factor.rank_one_update(a, w_values(0), b, w_values(w_values.n_elem - 1), sigma);
+
+    arma::mat inverse(pairs.n_rows, 3);
+    for (arma::uword r = 0; r < pairs.n_rows; ++r) {
+        factor.inverse_entries(pairs(r, 0) - 1, pairs(r, 1) - 1,
+                               inverse(r, 0), inverse(r, 1), inverse(r, 2));
+    }
+
+    return Rcpp::List::create(
+        Rcpp::Named("updated") = ok,
+        Rcpp::Named("log_det") = factor.log_det(),
+        Rcpp::Named("nonzeros") = static_cast<double>(factor.factor_nonzeros()),
+        Rcpp::Named("inverse") = inverse
+    );
+}
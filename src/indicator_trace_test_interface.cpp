@@ -0,0 +1,31 @@
+// indicator_trace_test_interface.cpp - test-only interface
+//
+// Packs an indicator matrix into a PackedIndicatorTrace and returns its R
+// encoding, so tests/testthat can check decode_indicator_trace() and
+// .compute_indicator_ess_packed_cpp() against the unpacked draws.
+#include <RcppArmadillo.h>
+
+#include "mcmc/execution/indicator_trace.h"
+
+// Each column of `draws` (n_edges x n_iter, 0/1) is one draw. Columns at
+// even positions go through store(), the others through an
+// IndicatorBitWriter, so both fill paths are exercised.
+//
+// @return The list made by PackedIndicatorTrace::to_list().
+//
+// [[Rcpp::export]]
+Rcpp::List test_packed_indicator_trace(const arma::imat& draws) {
+    PackedIndicatorTrace trace;
+    trace.reserve(draws.n_rows, draws.n_cols);
+    for (arma::uword t = 0; t < draws.n_cols; ++t) {
+        if (t % 2 == 0) {
+            trace.store(t, draws.col(t));
+        } else {
+            IndicatorBitWriter out(trace.clear_draw(t));
+            for (arma::uword k = 0; k < draws.n_rows; ++k) {
+                out.push(draws(k, t) != 0);
+            }
+        }
+    }
+    return trace.to_list();
+}
@@ -0,0 +1,69 @@
+// logz_kernels_test_interface.cpp - test-only interface
+//
+// Runs the kernels select_logz_kernels() picks for a category count next to
+// the runtime-count kernels in variable_helpers.h. Used by tests/testthat.
+#include <RcppArmadillo.h>
+
+#include "utils/variable_helpers.h"
+#include "utils/variable_kernels.h"
+
+namespace {
+
+Rcpp::List evaluate_kernels(const LogZKernels& kernels,
+                            const arma::vec& residual,
+                            const arma::vec& main_param,
+                            const int num_cats,
+                            const bool ordinal,
+                            const int ref,
+                            const arma::vec* weights) {
+    LogZMoments moments;
+    LogZScratch scratch;
+    arma::vec bound, denom;
+
+    if (ordinal) {
+        bound = num_cats * residual;
+        kernels.ordinal_moments(main_param, residual, bound, num_cats,
+                                moments, scratch, weights);
+        denom = kernels.ordinal_denom(residual, main_param, bound);
+    } else {
+        kernels.blume_capel_moments(residual, main_param(0), main_param(1), ref,
+                                    num_cats, moments, scratch, weights);
+        denom = kernels.blume_capel_denom(residual, main_param(0), main_param(1),
+                                          ref, num_cats, bound);
+    }
+    const arma::vec log_denom = bound + ARMA_MY_LOG(denom);
+
+    return Rcpp::List::create(
+        Rcpp::Named("log_Z_sum") = moments.log_Z_sum,
+        Rcpp::Named("prob_sums") = moments.prob_sums,
+        Rcpp::Named("E") = moments.E,
+        Rcpp::Named("log_denom") = log_denom
+    );
+}
+
+} // namespace
+
+// Log-normalizer moments and denominators of one variable from the
+// specialised kernels (`fixed`) and the runtime-count ones (`runtime`).
+// `main_param` holds the thresholds of an ordinal variable or the linear
+// and quadratic effects of a Blume-Capel one; ordinal bounds are
+// num_cats * residual, as in OMRFModel. An empty `weights` means none.
+//
+// [[Rcpp::export]]
+Rcpp::List test_logz_kernels(
+    const arma::vec& residual,
+    const arma::vec& main_param,
+    const int num_cats,
+    const bool ordinal,
+    const int ref,
+    const arma::vec& weights
+) {
+    const arma::vec* w = weights.n_elem > 0 ? &weights : nullptr;
+    return Rcpp::List::create(
+        Rcpp::Named("fixed") = evaluate_kernels(
+            select_logz_kernels(num_cats), residual, main_param, num_cats,
+            ordinal, ref, w),
+        Rcpp::Named("runtime") = evaluate_kernels(
+            LogZKernels(), residual, main_param, num_cats, ordinal, ref, w)
+    );
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+/**
+ * @file categorical.h
+ * @brief Inverse-CDF draws from categorical distributions.
+ *
+ * The Gibbs updates of missing responses, the data simulators and the SBM
+ * cluster allocation all draw a category from unnormalised weights. The
+ * helpers here share that step: running sums in place, then the first
+ * category whose running sum reaches u * total. The uniforms are passed in
+ * rather than drawn, so a caller can fill them in one runif_fill() — which
+ * is bit-compatible with the scalar runif() calls it replaces — and the
+ * batched forms take one column of weights per draw, exponentiated in a
+ * single vectorized pass.
+ *
+ * An alias table would make a draw O(1), but it costs O(n) to build and
+ * every distribution here is drawn from once, so the inverse CDF is the
+ * cheaper of the two.
+ */
+
+#include <RcppArmadillo.h>
+#include <algorithm>
+#include "math/explog_macros.h"
+#include "math/log_sum_exp.h"
+
+
+/**
+ * Overwrite weights[0..n) with their running sums.
+ *
+ * @return The total, weights[n - 1]
+ */
+inline double cumulative_in_place(double* weights, int n) {
+    for (int k = 1; k < n; ++k) weights[k] += weights[k - 1];
+    return weights[n - 1];
+}
+
+/**
+ * Invert running sums at u.
+ *
+ * @param cumulative  Running sums of n weights
+ * @param u           Point in [0, cumulative[n - 1]]
+ * @return The first k with u <= cumulative[k], or n - 1 when there is none
+ *         (rounding, or non-finite weights)
+ */
+inline int categorical_from_cumulative(const double* cumulative, int n, double u) {
+    int k = 0;
+    while (k < n - 1 && u > cumulative[k]) ++k;
+    return k;
+}
+
+/**
+ * Draw k with probability proportional to weights[k].
+ *
+ * @param weights  n non-negative weights, replaced by their running sums
+ * @param u01      Uniform(0, 1) draw
+ */
+inline int sample_categorical(double* weights, int n, double u01) {
+    const double total = cumulative_in_place(weights, n);
+    return categorical_from_cumulative(weights, n, u01 * total);
+}
+
+/**
+ * Draw k with probability proportional to exp(log_weights[k]).
+ *
+ * The weights are shifted by their maximum before exponentiating, so large
+ * or very negative log-weights neither overflow nor all underflow.
+ *
+ * @param log_weights  n log-weights, overwritten
+ * @param u01          Uniform(0, 1) draw
+ */
+inline int sample_categorical_log(double* log_weights, int n, double u01) {
+    const double max_log_weight = *std::max_element(log_weights, log_weights + n);
+    for (int k = 0; k < n; ++k) {
+        log_weights[k] = MY_EXP(log_weights[k] - max_log_weight);
+    }
+    return sample_categorical(log_weights, n, u01);
+}
+
+/**
+ * Draw one category per column of an unnormalised weight matrix.
+ *
+ * @param weights   Categories x draws, replaced column-wise by running sums
+ * @param uniforms  One Uniform(0, 1) draw per column
+ * @param draws     Set to the drawn category of each column
+ */
+inline void sample_categorical_columns(arma::mat& weights,
+                                       const arma::vec& uniforms,
+                                       arma::uvec& draws) {
+    const int n = static_cast<int>(weights.n_rows);
+    draws.set_size(weights.n_cols);
+    for (arma::uword j = 0; j < weights.n_cols; ++j) {
+        draws[j] = sample_categorical(weights.colptr(j), n, uniforms[j]);
+    }
+}
+
+/**
+ * Draw one category per column of exponents, without shifting.
+ *
+ * Takes exp of the whole matrix in one pass, in place, and then samples as
+ * sample_categorical_columns(). The caller keeps the exponents in range;
+ * use log_softmax_columns() first when they are not.
+ *
+ * @param exponents  Categories x draws log-weights, overwritten
+ * @param uniforms   One Uniform(0, 1) draw per column
+ * @param draws      Set to the drawn category of each column
+ */
+inline void sample_categorical_exp_columns(arma::mat& exponents,
+                                           const arma::vec& uniforms,
+                                           arma::uvec& draws) {
+    exp_in_place(exponents.memptr(), exponents.n_elem);
+    sample_categorical_columns(exponents, uniforms, draws);
+}
@@ -59,38 +59,54 @@ inline double compute_inv_submatrix_i(const arma::mat& A, size_t i,
  * @param precision_prop_ij, precision_prop_jj  Proposed K entries.
  */
 inline double log_det_ratio_edge_kernel(
-        const arma::mat& covariance, size_t i, size_t j,
+        double sigma_ii, double sigma_ij, double sigma_jj,
         double precision_curr_ij, double precision_prop_ij,
         double precision_curr_jj, double precision_prop_jj) {
     double Ui2 = precision_curr_ij - precision_prop_ij;
     double Uj2 = (precision_curr_jj - precision_prop_jj) / 2;
 
-    double cc11 = covariance(j, j);
-    double cc12 = 1.0 - (covariance(i, j) * Ui2 + covariance(j, j) * Uj2);
-    double cc22 = Ui2 * Ui2 * covariance(i, i)
-                + 2.0 * Ui2 * Uj2 * covariance(i, j)
-                + Uj2 * Uj2 * covariance(j, j);
+    double cc11 = sigma_jj;
+    double cc12 = 1.0 - (sigma_ij * Ui2 + sigma_jj * Uj2);
+    double cc22 = Ui2 * Ui2 * sigma_ii
+                + 2.0 * Ui2 * Uj2 * sigma_ij
+                + Uj2 * Uj2 * sigma_jj;
 
     return MY_LOG(std::abs(cc11 * cc22 - cc12 * cc12));
 }
 
+/** Overload reading Σ_ii, Σ_ij and Σ_jj from the full covariance. */
+inline double log_det_ratio_edge_kernel(
+        const arma::mat& covariance, size_t i, size_t j,
+        double precision_curr_ij, double precision_prop_ij,
+        double precision_curr_jj, double precision_prop_jj) {
+    return log_det_ratio_edge_kernel(
+        covariance(i, i), covariance(i, j), covariance(j, j),
+        precision_curr_ij, precision_prop_ij, precision_curr_jj, precision_prop_jj);
+}
+
 /**
  * Rank-1 specialisation of log_det_ratio_edge_kernel (Ui2 = 0): a diagonal-only
  * precision change at (j,j). Shared by GGMModel::log_det_ratio_diag and
  * MixedMRFModel::log_det_ratio_yy_diag.
  */
 inline double log_det_ratio_diag_kernel(
-        const arma::mat& covariance, size_t j,
-        double precision_curr_jj, double precision_prop_jj) {
+        double sigma_jj, double precision_curr_jj, double precision_prop_jj) {
     double Uj2 = (precision_curr_jj - precision_prop_jj) / 2;
 
-    double cc11 = covariance(j, j);
-    double cc12 = 1.0 - covariance(j, j) * Uj2;
-    double cc22 = Uj2 * Uj2 * covariance(j, j);
+    double cc11 = sigma_jj;
+    double cc12 = 1.0 - sigma_jj * Uj2;
+    double cc22 = Uj2 * Uj2 * sigma_jj;
 
     return MY_LOG(std::abs(cc11 * cc22 - cc12 * cc12));
 }
 
+/** Overload reading Σ_jj from the full covariance. */
+inline double log_det_ratio_diag_kernel(
+        const arma::mat& covariance, size_t j,
+        double precision_curr_jj, double precision_prop_jj) {
+    return log_det_ratio_diag_kernel(covariance(j, j), precision_curr_jj, precision_prop_jj);
+}
+
 /**
  * Extract the six reparameterization constants for a rank-2 off-diagonal MH
  * proposal in precision space (Roverato move). Shared by GGMModel::get_constants
@@ -130,4 +146,38 @@ inline std::array<double, 6> precision_proposal_constants(
     return c;
 }
 
+/**
+ * precision_proposal_constants() from the three covariance entries it
+ * needs, for callers without a dense Σ (the sparse-Cholesky GGM path).
+ * log|K| cancels from every constant, so it is not needed.
+ *
+ * @param sigma_ii, sigma_ij, sigma_jj  Entries of Σ = K⁻¹.
+ * @param precision_ij, precision_jj    Current K entries K(i,j), K(j,j).
+ * @return  {Phi_q1q, Phi_q1q1, c2, Phi_q1q1, c4, c5}.
+ */
+inline std::array<double, 6> precision_proposal_constants(
+        double sigma_ii, double sigma_ij, double sigma_jj,
+        double precision_ij, double precision_jj) {
+    double log_adj_ii = MY_LOG(std::abs(sigma_ii));
+    double log_adj_ij = MY_LOG(std::abs(sigma_ij));
+    double log_adj_jj = MY_LOG(std::abs(sigma_jj));
+
+    double inv_sub_jj = sigma_jj - sigma_ij * sigma_ij / sigma_ii;
+    double log_abs_inv_sub_jj = log_adj_ii + MY_LOG(std::abs(inv_sub_jj));
+
+    double Phi_q1q  = (2 * std::signbit(sigma_ij) - 1) * MY_EXP(
+        (log_adj_ij - (log_adj_jj + log_abs_inv_sub_jj) / 2)
+    );
+    double Phi_q1q1 = MY_EXP((log_adj_jj - log_abs_inv_sub_jj) / 2);
+
+    std::array<double, 6> c{};
+    c[0] = Phi_q1q;
+    c[1] = Phi_q1q1;
+    c[2] = precision_ij - Phi_q1q * Phi_q1q1;
+    c[3] = Phi_q1q1;
+    c[4] = precision_jj - Phi_q1q * Phi_q1q;
+    c[5] = c[4] + c[2] * c[2] / (c[3] * c[3]);
+    return c;
+}
+
 } // namespace cholesky_helpers
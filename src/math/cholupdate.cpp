@@ -108,6 +108,60 @@ void cholesky_downdate(arma::mat& R, arma::vec& u, double eps) {
     chol_up(R.memptr(), u.memptr(), &n, &up, &eps);
 }
 
+bool cholesky_rank_update(arma::mat& R, const arma::mat& U, arma::uword num_updates,
+                          CholeskyUpdateWorkspace& ws, double eps) {
+    const arma::uword n = R.n_cols;
+    const arma::uword k = U.n_cols;
+    ws.cos.set_size(k, n);
+    ws.sin.set_size(k, n);
+    ws.z.set_size(k);
+    double* z = ws.z.memptr();
+
+    for (arma::uword j = 0; j < n; ++j) {
+        double* x = R.colptr(j);
+        for (arma::uword c = 0; c < k; ++c) z[c] = U(j, c);
+
+        // Rows above the diagonal: the rotations of the earlier columns
+        for (arma::uword i = 0; i < j; ++i) {
+            const double* cs = ws.cos.colptr(i);
+            const double* sn = ws.sin.colptr(i);
+            double xi = x[i];
+            for (arma::uword c = 0; c < num_updates; ++c) {
+                const double z0 = z[c];
+                z[c] = cs[c] * z0 - sn[c] * xi;
+                xi = sn[c] * z0 + cs[c] * xi;
+            }
+            for (arma::uword c = num_updates; c < k; ++c) {
+                const double z0 = z[c];
+                z[c] = cs[c] * z0 - sn[c] * xi;
+                xi = -sn[c] * z0 + cs[c] * xi;
+            }
+            x[i] = xi;
+        }
+
+        // Diagonal: construct each vector's rotation u[j] <-> R[j,j]
+        double* cs = ws.cos.colptr(j);
+        double* sn = ws.sin.colptr(j);
+        double xj = x[j];
+        for (arma::uword c = 0; c < num_updates; ++c) {
+            const double r = hypote(z[c], xj);
+            cs[c] = xj / r;
+            sn[c] = z[c] / r;
+            xj = sn[c] * z[c] + cs[c] * xj;
+        }
+        for (arma::uword c = num_updates; c < k; ++c) {
+            double t = z[c] / xj;
+            if (std::fabs(t) >= 1) return false;
+            if (t > 1 - eps) t = 1 - eps;
+            cs[c] = 1 / std::sqrt(1 - t * t);
+            sn[c] = cs[c] * t;
+            xj = -sn[c] * z[c] + cs[c] * xj;
+        }
+        x[j] = xj;
+    }
+    return true;
+}
+
 // for testing
 // [[Rcpp::export]]
 arma::mat chol_update_arma(arma::mat& R, arma::vec& u, bool downdate = false, double eps = 1e-12) {
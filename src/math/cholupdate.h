@@ -19,6 +19,9 @@
  * column-major C implementation. The sub-diagonal entries of the first two
  * columns of R are used as scratch storage during the computation but are
  * zeroed on return.
+ *
+ * `cholesky_rank_update()` applies k updates and downdates in one pass
+ * over R, with the same rotations as k calls of the rank-1 routines.
  */
 
 #include <RcppArmadillo.h>
@@ -45,3 +48,36 @@ void cholesky_update(  arma::mat& R, arma::vec& u, double eps = 1e-12);
  * @param eps  Tolerance for near-singularity (default 1e-12)
  */
 void cholesky_downdate(arma::mat& R, arma::vec& u, double eps = 1e-12);
+
+
+/**
+ * Rotation storage for cholesky_rank_update(), reused across calls.
+ */
+struct CholeskyUpdateWorkspace {
+    arma::mat cos;  ///< k x p: cosine of vector c's rotation at row i
+    arma::mat sin;  ///< k x p: sine (hyperbolic for downdates)
+    arma::vec z;    ///< Running element of each vector in the current column
+};
+
+/**
+ * Rank-k Cholesky update and downdate in one pass over R:
+ *
+ *   R'R + sum_{c < num_updates} u_c u_c' - sum_{c >= num_updates} u_c u_c' = R1'R1.
+ *
+ * Works column by column like chol_up(), but rotates every row of a column
+ * against all k vectors while it is in cache, so R is read and written once
+ * instead of k times, and the k rotation chains are independent. The
+ * arithmetic is that of cholesky_update() for the first `num_updates`
+ * columns of U followed by cholesky_downdate() for the rest, so the result
+ * is the same to the last bit.
+ *
+ * @param R            Upper-triangular Cholesky factor (p x p, modified in place)
+ * @param U            Update vectors, one per column (p x k): updates first
+ * @param num_updates  Number of leading columns of U that are updates
+ * @param ws           Rotation workspace
+ * @param eps          Tolerance for near-singularity (default 1e-12)
+ * @return false if a downdate would leave R not positive definite; R is
+ *         then partially modified and must be recomputed
+ */
+bool cholesky_rank_update(arma::mat& R, const arma::mat& U, arma::uword num_updates,
+                          CholeskyUpdateWorkspace& ws, double eps = 1e-12);
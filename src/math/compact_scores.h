@@ -0,0 +1,424 @@
+#pragma once
+
+/**
+ * @file compact_scores.h
+ * @brief Byte-sized storage for integer category scores, with widening kernels.
+ *
+ * Ordinal and Blume-Capel scores rarely leave [-128, 127], yet a double copy
+ * of the data costs eight bytes per cell and the pairwise gradient streams
+ * it for every variable. CompactScores keeps the scores as int8 (int16 when
+ * a score does not fit) and widens them to double inside the kernels:
+ *   - dot() and tmul() for X^T E, one contiguous column at a time, and
+ *     the matrix tmul() for X^T E of many columns at once, from row
+ *     panels as below;
+ *   - add_scaled() for the rank-1 residual-column updates;
+ *   - mul() for X B, which widens a panel of rows at a time into a small
+ *     double buffer and multiplies that with BLAS, so the full double copy
+ *     of X never exists;
+ *   - gram() and weighted_gram() for X^T X and X_S^T W X_S, from the same
+ *     row panels.
+ *
+ * Storage is column-major, like arma::imat. The int8 scores can also be
+ * read in place from a memory-mapped score file (see MappedScoreFile), so
+ * data larger than memory streams from the page cache through the same
+ * row-panel kernels.
+ */
+
+#include <RcppArmadillo.h>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "math/score_file.h"
+
+
+class CompactScores {
+public:
+    CompactScores() = default;
+
+    /**
+     * @param scores  Integer scores (n x p)
+     * @throws std::invalid_argument if a score does not fit in 16 bits
+     */
+    explicit CompactScores(const arma::imat& scores)
+        : CompactScores(scores, arma::ivec(scores.n_cols, arma::fill::zeros)) {}
+
+    /**
+     * Scores shifted per column, x(i, j) - shift(j), packed without an
+     * intermediate shifted copy of the matrix.
+     *
+     * @param scores  Integer scores (n x p)
+     * @param shift   Offset subtracted from each column (p-vector)
+     * @throws std::invalid_argument if a shifted score does not fit in 16 bits
+     */
+    CompactScores(const arma::imat& scores, const arma::ivec& shift)
+        : CompactScores(scores.memptr(), scores.n_rows, scores.n_cols, shift) {}
+
+    /**
+     * Shifted scores packed straight from column-major memory of any
+     * arithmetic type, such as the INTEGER() or REAL() data of an R matrix,
+     * so no integer copy of the whole matrix is made first. Double scores
+     * must hold integer values.
+     *
+     * @param scores  Column-major scores (n_rows x n_cols)
+     * @param shift   Offset subtracted from each column (n_cols-vector)
+     * @throws std::invalid_argument if a shifted score does not fit in 16 bits
+     */
+    template <typename T>
+    CompactScores(const T* scores, arma::uword n_rows, arma::uword n_cols, const arma::ivec& shift)
+        : n_rows_(n_rows), n_cols_(n_cols)
+    {
+        long lo = 0, hi = 0;
+        for (arma::uword j = 0; j < n_cols_ && n_rows_ > 0; ++j) {
+            const T* x = scores + j * n_rows_;
+            const auto range = std::minmax_element(x, x + n_rows_);
+            const long col_lo = static_cast<long>(*range.first) - shift(j);
+            const long col_hi = static_cast<long>(*range.second) - shift(j);
+            lo = j == 0 ? col_lo : std::min(lo, col_lo);
+            hi = j == 0 ? col_hi : std::max(hi, col_hi);
+        }
+        if (lo < std::numeric_limits<std::int16_t>::min() ||
+            hi > std::numeric_limits<std::int16_t>::max()) {
+            throw std::invalid_argument("Category scores must lie in [-32768, 32767].");
+        }
+        wide_ = lo < std::numeric_limits<std::int8_t>::min() ||
+                hi > std::numeric_limits<std::int8_t>::max();
+        if (wide_) {
+            wide_scores_.resize(n_rows_ * n_cols_);
+            pack(scores, shift, wide_scores_.data());
+        } else {
+            narrow_scores_.resize(n_rows_ * n_cols_);
+            pack(scores, shift, narrow_scores_.data());
+        }
+    }
+
+    /**
+     * Scores read in place from a mapped score file; the file stays mapped
+     * while any copy of this store refers to it. Writes (set(),
+     * append_rows(), keep_rows()) first copy the scores into memory.
+     *
+     * @param file  Mapped score file (scores in [0, 127])
+     */
+    explicit CompactScores(std::shared_ptr<const MappedScoreFile> file)
+        : n_rows_(file->n_rows()), n_cols_(file->n_cols()),
+          mapped_(std::move(file)) {}
+
+    arma::uword n_rows() const { return n_rows_; }
+    arma::uword n_cols() const { return n_cols_; }
+
+    /** @return Bytes per stored score (1 or 2). */
+    int bytes_per_score() const { return wide_ ? 2 : 1; }
+
+    /** @return Whether the scores are read from a mapped file. */
+    bool is_mapped() const { return mapped_ != nullptr; }
+
+    /** @return Score of row i, column j. */
+    int operator()(arma::uword i, arma::uword j) const {
+        const arma::uword k = j * n_rows_ + i;
+        return wide_ ? wide_scores_[k] : narrow_data()[k];
+    }
+
+    /**
+     * Overwrite one score. A value outside the current storage width
+     * switches the whole store to 16 bits.
+     */
+    void set(arma::uword i, arma::uword j, int value) {
+        own_scores();
+        const arma::uword k = j * n_rows_ + i;
+        if (!wide_ && (value < std::numeric_limits<std::int8_t>::min() ||
+                       value > std::numeric_limits<std::int8_t>::max())) {
+            widen_store();
+        }
+        if (wide_) {
+            wide_scores_[k] = static_cast<std::int16_t>(value);
+        } else {
+            narrow_scores_[k] = static_cast<std::int8_t>(value);
+        }
+    }
+
+    /**
+     * Append rows below the stored ones. Scores outside the current storage
+     * width switch the whole store to 16 bits.
+     *
+     * @param rows  Integer scores (k x p), already shifted like the store
+     * @throws std::invalid_argument if a score does not fit in 16 bits
+     */
+    void append_rows(const arma::imat& rows) {
+        if (rows.n_rows == 0) return;
+        own_scores();
+        const long lo = rows.min(), hi = rows.max();
+        if (lo < std::numeric_limits<std::int16_t>::min() ||
+            hi > std::numeric_limits<std::int16_t>::max()) {
+            throw std::invalid_argument("Category scores must lie in [-32768, 32767].");
+        }
+        if (!wide_ && (lo < std::numeric_limits<std::int8_t>::min() ||
+                       hi > std::numeric_limits<std::int8_t>::max())) {
+            widen_store();
+        }
+        if (wide_) {
+            append_impl(rows, wide_scores_);
+        } else {
+            append_impl(rows, narrow_scores_);
+        }
+        n_rows_ += rows.n_rows;
+    }
+
+    /**
+     * Keep the given rows, in the given order, and drop the others.
+     *
+     * @param rows  Row indices (each < n_rows())
+     */
+    void keep_rows(const arma::uvec& rows) {
+        own_scores();
+        if (wide_) {
+            keep_impl(rows, wide_scores_);
+        } else {
+            keep_impl(rows, narrow_scores_);
+        }
+        n_rows_ = rows.n_elem;
+    }
+
+    /** @return The scores as a double matrix (n x p); for one-off use. */
+    arma::mat to_double() const {
+        arma::mat out(n_rows_, n_cols_, arma::fill::none);
+        for (arma::uword j = 0; j < n_cols_; ++j) {
+            widen(j, 0, n_rows_, out.colptr(j));
+        }
+        return out;
+    }
+
+    /** @return Column j as integers. */
+    arma::ivec col(arma::uword j) const {
+        arma::ivec out(n_rows_);
+        for (arma::uword i = 0; i < n_rows_; ++i) out(i) = (*this)(i, j);
+        return out;
+    }
+
+    /** @return Row i as integers (1 x p). */
+    arma::irowvec row(arma::uword i) const {
+        arma::irowvec out(n_cols_);
+        for (arma::uword j = 0; j < n_cols_; ++j) out(j) = (*this)(i, j);
+        return out;
+    }
+
+    /** @return x_j' v for column j and a length-n vector v. */
+    double dot(arma::uword j, const arma::vec& v) const {
+        return wide_ ? dot_impl(wide_scores_.data() + j * n_rows_, v.memptr())
+                     : dot_impl(narrow_data() + j * n_rows_, v.memptr());
+    }
+
+    /** out = X' v, for a length-n vector v and a length-p output. */
+    void tmul(const arma::vec& v, double* out) const {
+        for (arma::uword j = 0; j < n_cols_; ++j) out[j] = dot(j, v);
+    }
+
+    /**
+     * out = X' E, for E with n rows, from row panels as in mul(): the
+     * scores are read once for all columns of E, and each panel is
+     * multiplied with BLAS. `panel` keeps its memory across calls.
+     */
+    void tmul(const arma::mat& E, arma::mat& out, arma::mat& panel,
+              arma::uword panel_rows = 256) const {
+        out.zeros(n_cols_, E.n_cols);
+        if (n_rows_ == 0) return;
+        const arma::uword rows = std::min(panel_rows, n_rows_);
+        if (panel.n_rows != rows || panel.n_cols != n_cols_) {
+            panel.set_size(rows, n_cols_);
+        }
+        for (arma::uword begin = 0; begin < n_rows_; begin += rows) {
+            const arma::uword count = std::min(rows, n_rows_ - begin);
+            for (arma::uword j = 0; j < n_cols_; ++j) {
+                widen(j, begin, count, panel.colptr(j));
+            }
+            if (count == rows) {
+                out += panel.t() * E.rows(begin, begin + count - 1);
+            } else {
+                out += panel.head_rows(count).t() * E.rows(begin, begin + count - 1);
+            }
+        }
+    }
+
+    /** out += alpha * x_j, for a length-n output. */
+    void add_scaled(arma::uword j, double alpha, double* out) const {
+        if (wide_) {
+            add_scaled_impl(wide_scores_.data() + j * n_rows_, alpha, out);
+        } else {
+            add_scaled_impl(narrow_data() + j * n_rows_, alpha, out);
+        }
+    }
+
+    /**
+     * out = scale * X B, for B with p rows.
+     *
+     * Rows are widened `panel_rows` at a time into `panel`, which keeps its
+     * memory across calls.
+     */
+    void mul(const arma::mat& B, double scale, arma::mat& out, arma::mat& panel,
+             arma::uword panel_rows = 256) const {
+        out.set_size(n_rows_, B.n_cols);
+        if (n_rows_ == 0) return;
+        const arma::uword rows = std::min(panel_rows, n_rows_);
+        if (panel.n_rows != rows || panel.n_cols != n_cols_) {
+            panel.set_size(rows, n_cols_);
+        }
+        for (arma::uword begin = 0; begin < n_rows_; begin += rows) {
+            const arma::uword count = std::min(rows, n_rows_ - begin);
+            for (arma::uword j = 0; j < n_cols_; ++j) {
+                widen(j, begin, count, panel.colptr(j));
+            }
+            if (count == rows) {
+                out.rows(begin, begin + count - 1) = scale * panel * B;
+            } else {
+                out.rows(begin, begin + count - 1) = scale * panel.head_rows(count) * B;
+            }
+        }
+    }
+
+    /**
+     * @return X' X (p x p), from the same row panels as mul(), so the full
+     *         double copy of X never exists. Exact for integer scores.
+     */
+    arma::mat gram(arma::uword panel_rows = 256) const {
+        arma::mat out(n_cols_, n_cols_, arma::fill::zeros);
+        if (n_rows_ == 0) return out;
+        const arma::uword rows = std::min(panel_rows, n_rows_);
+        arma::mat panel(rows, n_cols_, arma::fill::none);
+        for (arma::uword begin = 0; begin < n_rows_; begin += rows) {
+            const arma::uword count = std::min(rows, n_rows_ - begin);
+            for (arma::uword j = 0; j < n_cols_; ++j) {
+                widen(j, begin, count, panel.colptr(j));
+            }
+            if (count == rows) {
+                out += panel.t() * panel;
+            } else {
+                const arma::mat tail = panel.head_rows(count);
+                out += tail.t() * tail;
+            }
+        }
+        return out;
+    }
+
+    /**
+     * out = X_S' diag(w) X_S for the columns S, from row panels as in
+     * gram(). `out` and `panel` keep their memory when they already have
+     * the size (|S| x |S|, and min(panel_rows, n) x |S|).
+     *
+     * @param columns  Columns S of X
+     * @param w        n row weights
+     */
+    void weighted_gram(const std::vector<int>& columns, const double* w, arma::mat& out,
+                       arma::mat& panel, arma::uword panel_rows = 256) const {
+        const arma::uword k = columns.size();
+        if (out.n_rows != k || out.n_cols != k) out.set_size(k, k);
+        out.zeros();
+        if (n_rows_ == 0 || k == 0) return;
+        const arma::uword rows = std::min(panel_rows, n_rows_);
+        if (panel.n_rows != rows || panel.n_cols != k) panel.set_size(rows, k);
+        for (arma::uword begin = 0; begin < n_rows_; begin += rows) {
+            const arma::uword count = std::min(rows, n_rows_ - begin);
+            for (arma::uword j = 0; j < k; ++j) {
+                widen(columns[j], begin, count, panel.colptr(j));
+            }
+            const arma::vec weights(const_cast<double*>(w + begin), count, false, true);
+            if (count == rows) {
+                out += panel.t() * (panel.each_col() % weights);
+            } else {
+                const arma::mat tail = panel.head_rows(count);
+                out += tail.t() * (tail.each_col() % weights);
+            }
+        }
+    }
+
+private:
+    const std::int8_t* narrow_data() const {
+        return mapped_ ? mapped_->scores() : narrow_scores_.data();
+    }
+
+    /** Copy mapped scores into memory before the first write. */
+    void own_scores() {
+        if (!mapped_) return;
+        narrow_scores_.assign(mapped_->scores(), mapped_->scores() + n_rows_ * n_cols_);
+        mapped_.reset();
+    }
+
+    void widen_store() {
+        wide_scores_.assign(narrow_scores_.begin(), narrow_scores_.end());
+        std::vector<std::int8_t>().swap(narrow_scores_);
+        wide_ = true;
+    }
+
+    template <typename T>
+    void append_impl(const arma::imat& rows, std::vector<T>& store) const {
+        const arma::uword n_new = n_rows_ + rows.n_rows;
+        std::vector<T> out(n_new * n_cols_);
+        for (arma::uword j = 0; j < n_cols_; ++j) {
+            std::copy(store.begin() + j * n_rows_, store.begin() + (j + 1) * n_rows_,
+                      out.begin() + j * n_new);
+            const arma::sword* x = rows.colptr(j);
+            T* y = out.data() + j * n_new + n_rows_;
+            for (arma::uword i = 0; i < rows.n_rows; ++i) y[i] = static_cast<T>(x[i]);
+        }
+        store.swap(out);
+    }
+
+    template <typename T>
+    void keep_impl(const arma::uvec& rows, std::vector<T>& store) const {
+        std::vector<T> out(rows.n_elem * n_cols_);
+        for (arma::uword j = 0; j < n_cols_; ++j) {
+            const T* x = store.data() + j * n_rows_;
+            T* y = out.data() + j * rows.n_elem;
+            for (arma::uword i = 0; i < rows.n_elem; ++i) y[i] = x[rows(i)];
+        }
+        store.swap(out);
+    }
+
+    template <typename S, typename T>
+    void pack(const S* scores, const arma::ivec& shift, T* out) const {
+        for (arma::uword j = 0; j < n_cols_; ++j) {
+            const S* x = scores + j * n_rows_;
+            T* y = out + j * n_rows_;
+            for (arma::uword i = 0; i < n_rows_; ++i) {
+                y[i] = static_cast<T>(x[i] - shift(j));
+            }
+        }
+    }
+
+    void widen(arma::uword j, arma::uword begin, arma::uword count, double* out) const {
+        const arma::uword k = j * n_rows_ + begin;
+        if (wide_) {
+            for (arma::uword i = 0; i < count; ++i) out[i] = wide_scores_[k + i];
+        } else {
+            const std::int8_t* x = narrow_data();
+            for (arma::uword i = 0; i < count; ++i) out[i] = x[k + i];
+        }
+    }
+
+    template <typename T>
+    double dot_impl(const T* x, const double* v) const {
+        // Four partial sums so the loop vectorizes without -ffast-math
+        double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+        arma::uword i = 0;
+        for (; i + 4 <= n_rows_; i += 4) {
+            s0 += x[i] * v[i];
+            s1 += x[i + 1] * v[i + 1];
+            s2 += x[i + 2] * v[i + 2];
+            s3 += x[i + 3] * v[i + 3];
+        }
+        for (; i < n_rows_; ++i) s0 += x[i] * v[i];
+        return (s0 + s1) + (s2 + s3);
+    }
+
+    template <typename T>
+    void add_scaled_impl(const T* x, double alpha, double* out) const {
+        for (arma::uword i = 0; i < n_rows_; ++i) out[i] += alpha * x[i];
+    }
+
+    arma::uword n_rows_ = 0;
+    arma::uword n_cols_ = 0;
+    bool wide_ = false;
+    std::vector<std::int8_t> narrow_scores_;
+    std::vector<std::int16_t> wide_scores_;
+    std::shared_ptr<const MappedScoreFile> mapped_;  ///< Source of the narrow scores, if mapped
+};
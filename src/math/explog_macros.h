@@ -11,14 +11,23 @@
  *     because MSVC's `std::exp` / `std::log` are significantly slower.
  *   - **macOS / Linux:** Uses `std::exp` / `arma::exp` etc.
  *
+ * The element-wise `ARMA_MY_EXP` / `ARMA_MY_LOG` macros additionally
+ * resolve to the vectorized kernels in `simd_explog.h` on every platform;
+ * the scalar `MY_EXP` / `MY_LOG` are unaffected. The SIMD kernels give the
+ * same bits on every instruction set they dispatch to, but differ from
+ * libm/OpenLibM in the last ulp, so build with `-DSIMD_EXP_LOG=0` to
+ * reproduce results from earlier versions exactly.
+ *
  * Override at build time:
  * @code
  * Sys.setenv("PKG_CPPFLAGS" = "-DCUSTOM_EXP_LOG=1")  # force OpenLibM
  * Sys.setenv("PKG_CPPFLAGS" = "-DCUSTOM_EXP_LOG=0")  # force std
+ * Sys.setenv("PKG_CPPFLAGS" = "-DSIMD_EXP_LOG=0")    # element-wise via the above
  * @endcode
  *
  * @see custom_explog.h       Scalar OpenLibM exp/log
  * @see custom_arma_explog.h  Armadillo element-wise wrappers
+ * @see simd_explog.h         Vectorized element-wise exp/log
  */
 #ifndef _EXPLOG_MACROS_H_
 #define	_EXPLOG_MACROS_H_
@@ -34,6 +43,16 @@
 
 #endif
 
+#if !defined(SIMD_EXP_LOG) || SIMD_EXP_LOG != 0
+
+#define USE_SIMD_EXP_LOG 1
+
+#else
+
+#define USE_SIMD_EXP_LOG 0
+
+#endif
+
 #if USE_CUSTOM_LOG
 
 #include "math/custom_explog.h"
@@ -60,4 +79,15 @@
 
 #endif
 
-#endif
\ No newline at end of file
+#if USE_SIMD_EXP_LOG
+
+#include "math/simd_explog.h"
+
+#undef ARMA_MY_EXP
+#undef ARMA_MY_LOG
+#define ARMA_MY_EXP simd_arma_exp
+#define ARMA_MY_LOG simd_arma_log
+
+#endif
+
+#endif
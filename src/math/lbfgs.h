@@ -0,0 +1,193 @@
+#pragma once
+
+/**
+ * @file lbfgs.h
+ * @brief Limited-memory BFGS maximisation of a smooth log density, and the
+ *        finite-difference diagonal of its Hessian.
+ *
+ * Used to move a model to (near) the mode of its log-pseudoposterior before
+ * warmup, from the same logp_and_gradient() the gradient samplers use. The
+ * objective is a callable f(x) returning the pair (log density, gradient);
+ * a non-finite log density marks a point outside the support, and the line
+ * search backs off from it.
+ *
+ * The search direction is the two-loop recursion of Nocedal and Wright
+ * (2006, Algorithm 7.4) over the last `memory` curvature pairs, scaled by
+ * s'y / y'y; the step satisfies the Armijo condition by backtracking.
+ * Pairs with s'y <= 0 (non-concave stretches) are skipped, so the implied
+ * inverse Hessian stays positive definite.
+ */
+
+#include <RcppArmadillo.h>
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+
+struct LBFGSOptions {
+    int memory = 7;                   ///< Number of curvature pairs kept
+    int max_iterations = 200;
+    /// Stop when max |gradient| <= gradient_tolerance * max(1, |log density|)
+    double gradient_tolerance = 1e-6;
+    /// Stop when the log density increases by less than this, relatively
+    double value_tolerance = 1e-10;
+    int max_backtracks = 30;
+    double armijo = 1e-4;             ///< Sufficient-increase constant
+};
+
+
+struct LBFGSResult {
+    arma::vec x;                      ///< Final point
+    double value;                     ///< Log density at x
+    arma::vec gradient;               ///< Gradient at x
+    int iterations = 0;
+    bool converged = false;           ///< A tolerance was met (not the iteration cap)
+};
+
+
+/**
+ * Maximise f from x0.
+ *
+ * @param f     Callable: f(x) -> std::pair<double, arma::vec>
+ * @param x0    Starting point; f(x0) must be finite
+ * @param opts  Memory, tolerances and iteration limits
+ * @return The best point found. If no step can be taken, x0.
+ */
+template <typename Objective>
+LBFGSResult lbfgs_maximize(Objective&& f, const arma::vec& x0,
+                           const LBFGSOptions& opts = LBFGSOptions()) {
+    LBFGSResult res;
+    res.x = x0;
+    std::tie(res.value, res.gradient) = f(res.x);
+    if (!std::isfinite(res.value)) return res;
+
+    std::deque<arma::vec> s_hist, y_hist;
+    std::deque<double> rho_hist;
+    std::vector<double> alpha(opts.memory);
+
+    for (int iter = 0; iter < opts.max_iterations; ++iter) {
+        res.iterations = iter;
+        const double scale = std::max(1.0, std::abs(res.value));
+        if (arma::abs(res.gradient).max() <= opts.gradient_tolerance * scale) {
+            res.converged = true;
+            return res;
+        }
+
+        // Two-loop recursion on the ascent direction H g
+        arma::vec d = res.gradient;
+        const int m = static_cast<int>(s_hist.size());
+        for (int k = m - 1; k >= 0; --k) {
+            alpha[k] = rho_hist[k] * arma::dot(s_hist[k], d);
+            d -= alpha[k] * y_hist[k];
+        }
+        if (m > 0) {
+            d *= 1.0 / (rho_hist[m - 1] * arma::dot(y_hist[m - 1], y_hist[m - 1]));
+        } else {
+            // First step: unit length in the largest coordinate
+            d /= std::max(1.0, arma::abs(d).max());
+        }
+        for (int k = 0; k < m; ++k) {
+            const double beta = rho_hist[k] * arma::dot(y_hist[k], d);
+            d += (alpha[k] - beta) * s_hist[k];
+        }
+
+        double slope = arma::dot(res.gradient, d);
+        if (!(slope > 0.0)) {
+            // Not an ascent direction: restart from the gradient
+            s_hist.clear();
+            y_hist.clear();
+            rho_hist.clear();
+            d = res.gradient / std::max(1.0, arma::abs(res.gradient).max());
+            slope = arma::dot(res.gradient, d);
+        }
+
+        // Backtracking line search (Armijo)
+        double step = 1.0;
+        bool accepted = false;
+        arma::vec x_new;
+        double value_new = 0.0;
+        arma::vec gradient_new;
+        for (int b = 0; b < opts.max_backtracks; ++b) {
+            x_new = res.x + step * d;
+            std::tie(value_new, gradient_new) = f(x_new);
+            if (std::isfinite(value_new) &&
+                value_new >= res.value + opts.armijo * step * slope) {
+                accepted = true;
+                break;
+            }
+            step *= 0.5;
+        }
+        if (!accepted) return res;
+
+        arma::vec s = x_new - res.x;
+        arma::vec y = res.gradient - gradient_new;   // -(change in gradient of -f)
+        const double sy = arma::dot(s, y);
+        const double increase = value_new - res.value;
+
+        res.x = std::move(x_new);
+        res.gradient = std::move(gradient_new);
+        res.value = value_new;
+
+        if (sy > 1e-12 * arma::norm(s) * arma::norm(y)) {
+            if (static_cast<int>(s_hist.size()) == opts.memory) {
+                s_hist.pop_front();
+                y_hist.pop_front();
+                rho_hist.pop_front();
+            }
+            s_hist.push_back(std::move(s));
+            y_hist.push_back(std::move(y));
+            rho_hist.push_back(1.0 / sy);
+        }
+
+        if (increase <= opts.value_tolerance * std::max(1.0, std::abs(res.value))) {
+            res.iterations = iter + 1;
+            res.converged = true;
+            return res;
+        }
+    }
+    res.iterations = opts.max_iterations;
+    return res;
+}
+
+
+/**
+ * Diagonal of the Hessian of f at x by forward differences of the gradient,
+ * H_kk ~ (g_k(x + h_k e_k) - g_k(x)) / h_k with h_k = h max(1, |x_k|).
+ * Costs one gradient per coordinate. Coordinates where f is not finite one
+ * step away get NaN.
+ *
+ * @param gradient  Gradient of f at x
+ */
+template <typename Objective>
+arma::vec hessian_diagonal(Objective&& f, const arma::vec& x,
+                           const arma::vec& gradient, double h = 1e-5) {
+    arma::vec diagonal(x.n_elem);
+    arma::vec x_step = x;
+    for (arma::uword k = 0; k < x.n_elem; ++k) {
+        const double h_k = h * std::max(1.0, std::abs(x(k)));
+        x_step(k) = x(k) + h_k;
+        auto [value, gradient_step] = f(x_step);
+        diagonal(k) = std::isfinite(value)
+            ? (gradient_step(k) - gradient(k)) / h_k
+            : arma::datum::nan;
+        x_step(k) = x(k);
+    }
+    return diagonal;
+}
+
+
+/**
+ * Inverse mass diagonal from the Hessian diagonal of a log density:
+ * 1 / (-H_kk) where the curvature is positive and finite, 1 elsewhere.
+ */
+inline arma::vec inverse_curvature(const arma::vec& diagonal) {
+    arma::vec inv_mass(diagonal.n_elem, arma::fill::ones);
+    for (arma::uword k = 0; k < diagonal.n_elem; ++k) {
+        const double curvature = -diagonal(k);
+        if (std::isfinite(curvature) && curvature > 0.0) inv_mass(k) = 1.0 / curvature;
+    }
+    return inv_mass;
+}
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <RcppArmadillo.h>
 #include <algorithm>
 #include <cmath>
+#include <cstddef>
 #include <limits>
 #include "math/explog_macros.h"
 
@@ -17,3 +19,71 @@ inline double log_sum_exp(double a, double b) {
   const double m = std::max(a, b);
   return m + MY_LOG1P(MY_EXP(-std::abs(a - b)));
 }
+
+// log(sum_i exp(x[i])) over x[0..n), shifted by the maximum.
+//
+// -inf for n == 0 or when every term is -inf; +inf when a term is +inf.
+inline double log_sum_exp(const double* x, std::size_t n) {
+  constexpr double inf = std::numeric_limits<double>::infinity();
+  if (n == 0) return -inf;
+  const double m = *std::max_element(x, x + n);
+  if (m == -inf || m == inf) return m;
+  double sum = 0.0;
+  for (std::size_t i = 0; i < n; ++i) sum += MY_EXP(x[i] - m);
+  return m + MY_LOG(sum);
+}
+
+// x[i] = exp(x[i]) for i in [0, n), with the kernel behind ARMA_MY_EXP, so
+// the result has the same bits as ARMA_MY_EXP without the temporary.
+inline void exp_in_place(double* x, std::size_t n) {
+#if USE_SIMD_EXP_LOG
+  simd_exp(x, x, n);
+#else
+  for (std::size_t i = 0; i < n; ++i) x[i] = MY_EXP(x[i]);
+#endif
+}
+
+// Log-softmax of every column of x, in place:
+//   x(c, j) <- x(c, j) - log(sum_d exp(x(d, j))).
+//
+// Each column is shifted by its maximum and the exponentials of the whole
+// matrix are taken in one vectorized pass. A column without a finite
+// maximum (all -inf, or a +inf term) becomes NaN.
+inline void log_softmax_columns(arma::mat& x) {
+  if (x.is_empty()) return;
+  for (arma::uword j = 0; j < x.n_cols; ++j) {
+    x.col(j) -= x.col(j).max();
+  }
+  const arma::mat weights = ARMA_MY_EXP(x);
+  for (arma::uword j = 0; j < x.n_cols; ++j) {
+    x.col(j) -= MY_LOG(arma::accu(weights.col(j)));
+  }
+}
+
+// LogSumExp - log(sum exp(x)) over a stream of terms
+//
+// Keeps the running maximum and the sum of exp(x - max), rescaling the sum
+// when a larger term arrives, so terms can be added one at a time without
+// overflow and without storing them.
+class LogSumExp {
+public:
+  void add(double x) {
+    if (x == -std::numeric_limits<double>::infinity()) return;
+    if (x > max_) {
+      sum_ = sum_ * MY_EXP(max_ - x) + 1.0;
+      max_ = x;
+    } else {
+      sum_ += MY_EXP(x - max_);
+    }
+  }
+
+  // log(sum exp(x)) of the terms so far; -inf before the first finite one.
+  double value() const {
+    if (sum_ == 0.0) return max_;
+    return max_ + MY_LOG(sum_);
+  }
+
+private:
+  double max_ = -std::numeric_limits<double>::infinity();
+  double sum_ = 0.0;
+};
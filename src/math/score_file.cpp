@@ -0,0 +1,124 @@
+#include "math/score_file.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+MappedScoreFile::MappedScoreFile(const std::string& path) : path_(path) {
+    const std::string cannot_map = "Cannot map score file: " + path;
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) throw std::runtime_error(cannot_map);
+    file_handle_ = file;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        throw std::runtime_error(cannot_map);
+    }
+    mapped_bytes_ = static_cast<std::size_t>(size.QuadPart);
+    if (mapped_bytes_ < static_cast<std::size_t>(header_bytes)) {
+        CloseHandle(file);
+        throw std::runtime_error("Not a bgms score file: " + path);
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        throw std::runtime_error(cannot_map);
+    }
+    mapping_handle_ = mapping;
+    base_ = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (base_ == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        throw std::runtime_error(cannot_map);
+    }
+#else
+    fd_ = open(path.c_str(), O_RDONLY);
+    if (fd_ < 0) throw std::runtime_error(cannot_map);
+    struct stat info;
+    if (fstat(fd_, &info) != 0) {
+        close(fd_);
+        throw std::runtime_error(cannot_map);
+    }
+    mapped_bytes_ = static_cast<std::size_t>(info.st_size);
+    if (mapped_bytes_ < static_cast<std::size_t>(header_bytes)) {
+        close(fd_);
+        throw std::runtime_error("Not a bgms score file: " + path);
+    }
+    void* base = mmap(nullptr, mapped_bytes_, PROT_READ, MAP_SHARED, fd_, 0);
+    if (base == MAP_FAILED) {
+        close(fd_);
+        throw std::runtime_error(cannot_map);
+    }
+#ifdef MADV_SEQUENTIAL
+    // The kernels walk the file column by column
+    madvise(base, mapped_bytes_, MADV_SEQUENTIAL);
+#endif
+    base_ = static_cast<const unsigned char*>(base);
+#endif
+
+    std::int32_t type_code = 0;
+    std::int64_t n_rows = 0, n_cols = 0;
+    std::memcpy(&type_code, base_ + 8, sizeof(type_code));
+    std::memcpy(&n_rows, base_ + 16, sizeof(n_rows));
+    std::memcpy(&n_cols, base_ + 24, sizeof(n_cols));
+    const bool valid_header = std::memcmp(base_, magic, sizeof(magic)) == 0 &&
+        type_code == uint8_type && n_rows >= 0 && n_cols >= 0 &&
+        static_cast<std::size_t>(header_bytes + n_rows * n_cols) == mapped_bytes_;
+    if (!valid_header) {
+        release();
+        throw std::runtime_error("Not a bgms score file: " + path);
+    }
+    n_rows_ = static_cast<arma::uword>(n_rows);
+    n_cols_ = static_cast<arma::uword>(n_cols);
+}
+
+
+MappedScoreFile::~MappedScoreFile() {
+    release();
+}
+
+
+void MappedScoreFile::release() {
+#ifdef _WIN32
+    if (base_ != nullptr) UnmapViewOfFile(base_);
+    if (mapping_handle_ != nullptr) CloseHandle(static_cast<HANDLE>(mapping_handle_));
+    if (file_handle_ != nullptr) CloseHandle(static_cast<HANDLE>(file_handle_));
+    mapping_handle_ = nullptr;
+    file_handle_ = nullptr;
+#else
+    if (base_ != nullptr) munmap(const_cast<unsigned char*>(base_), mapped_bytes_);
+    if (fd_ >= 0) close(fd_);
+    fd_ = -1;
+#endif
+    base_ = nullptr;
+}
+
+
+arma::umat MappedScoreFile::score_counts() const {
+    arma::umat counts(128, n_cols_, arma::fill::zeros);
+    const unsigned char* x = base_ + header_bytes;
+    for (arma::uword j = 0; j < n_cols_; ++j) {
+        const unsigned char* column = x + j * n_rows_;
+        arma::uword* column_counts = counts.colptr(j);
+        for (arma::uword i = 0; i < n_rows_; ++i) {
+            if (column[i] > 127) {
+                throw std::runtime_error(
+                    "Score file " + path_ + " holds a score above 127 in column " +
+                    std::to_string(j + 1) + ".");
+            }
+            column_counts[column[i]]++;
+        }
+    }
+    return counts;
+}
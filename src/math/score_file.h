@@ -0,0 +1,85 @@
+#pragma once
+
+/**
+ * @file score_file.h
+ * @brief Read-only memory map of a binary file of category scores.
+ *
+ * Lets a model work on observations that do not fit in memory: the file
+ * is mapped, not read, and the operating system pages in the parts the
+ * kernels touch. CompactScores reads a mapped file in place (see its
+ * MappedScoreFile constructor), so the scores are never copied; repeated
+ * passes over a file that fits in the page cache run at in-memory speed.
+ *
+ * File layout (native byte order, 32-byte header), as written by
+ * write_score_file() on the R side:
+ *
+ *   offset  0  char[8]  magic "BGMSSCR1"
+ *   offset  8  int32    element type: 2 = uint8
+ *   offset 12  int32    reserved (0)
+ *   offset 16  int64    n_rows (observations)
+ *   offset 24  int64    n_cols (variables)
+ *   offset 32  data     n_rows x n_cols matrix of scores, column-major
+ *
+ * Scores must lie in [0, 127], so the bytes read as the int8 scores of
+ * CompactScores.
+ */
+
+#include <RcppArmadillo.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+class MappedScoreFile {
+public:
+    static constexpr char magic[8] = {'B', 'G', 'M', 'S', 'S', 'C', 'R', '1'};
+    static constexpr std::int64_t header_bytes = 32;
+    static constexpr std::int32_t uint8_type = 2;
+
+    /**
+     * Map the file read-only.
+     *
+     * @param path  Score file
+     * @throws std::runtime_error if the file cannot be opened or mapped,
+     *         or its header or size is not that of a score file
+     */
+    explicit MappedScoreFile(const std::string& path);
+    ~MappedScoreFile();
+
+    MappedScoreFile(const MappedScoreFile&) = delete;
+    MappedScoreFile& operator=(const MappedScoreFile&) = delete;
+
+    arma::uword n_rows() const { return n_rows_; }
+    arma::uword n_cols() const { return n_cols_; }
+    const std::string& path() const { return path_; }
+
+    /** @return The column-major scores (n_rows * n_cols bytes). */
+    const std::int8_t* scores() const {
+        return reinterpret_cast<const std::int8_t*>(base_) + header_bytes;
+    }
+
+    /**
+     * Per-variable counts of each score, from one pass over the file in
+     * column order.
+     *
+     * @return 128 x n_cols matrix; entry (s, j) counts score s in column j
+     * @throws std::runtime_error if a score exceeds 127
+     */
+    arma::umat score_counts() const;
+
+private:
+    /** Unmap the file and close its handles. */
+    void release();
+
+    std::string path_;
+    arma::uword n_rows_ = 0;
+    arma::uword n_cols_ = 0;
+    const unsigned char* base_ = nullptr;  ///< Start of the mapping (the header)
+    std::size_t mapped_bytes_ = 0;
+#ifdef _WIN32
+    void* file_handle_ = nullptr;
+    void* mapping_handle_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+};
@@ -0,0 +1,135 @@
+// simd_explog.cpp - runtime dispatch for the vectorized exp/log kernels.
+//
+// The kernel in simd_explog_kernel.h is instantiated once per instruction
+// set by including it inside a target-specific region. FP contraction is
+// disabled for the whole file so the AVX-512 (and NEON) builds cannot fuse
+// multiply-adds and stay bit-identical to the SSE2/AVX2 builds.
+#include "math/simd_explog.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize("fp-contract=off")
+#elif defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__aarch64__))
+#define BGMS_HAVE_SIMD_EXPLOG 1
+#else
+#define BGMS_HAVE_SIMD_EXPLOG 0
+#endif
+
+
+#if BGMS_HAVE_SIMD_EXPLOG
+
+// Baseline: SSE2 on x86-64, NEON (Advanced SIMD) on AArch64.
+#define BGMS_SIMD_WIDTH 2
+#define BGMS_SIMD_NS simd_base
+#include "math/simd_explog_kernel.h"
+#undef BGMS_SIMD_NS
+#undef BGMS_SIMD_WIDTH
+
+// AVX paths are skipped on Windows: MinGW GCC does not realign the stack
+// for 32/64-byte spills (GCC bug 54412), which faults at run time.
+#if defined(__x86_64__) && !defined(_WIN32)
+#define BGMS_HAVE_AVX_EXPLOG 1
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+#define BGMS_SIMD_WIDTH 4
+#define BGMS_SIMD_NS simd_avx2
+#include "math/simd_explog_kernel.h"
+#undef BGMS_SIMD_NS
+#undef BGMS_SIMD_WIDTH
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#endif
+#define BGMS_SIMD_WIDTH 8
+#define BGMS_SIMD_NS simd_avx512
+#include "math/simd_explog_kernel.h"
+#undef BGMS_SIMD_NS
+#undef BGMS_SIMD_WIDTH
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#endif  // __x86_64__ && !_WIN32
+#endif  // BGMS_HAVE_SIMD_EXPLOG
+
+
+namespace {
+
+typedef void (*array_fn)(const double*, double*, std::size_t);
+
+#if !BGMS_HAVE_SIMD_EXPLOG
+void scalar_exp_array(const double* x, double* y, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) y[i] = std::exp(x[i]);
+}
+
+void scalar_log_array(const double* x, double* y, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) y[i] = std::log(x[i]);
+}
+#endif
+
+struct Dispatch {
+  array_fn exp_fn;
+  array_fn log_fn;
+  const char* isa;
+};
+
+Dispatch select_dispatch() {
+#if defined(BGMS_HAVE_AVX_EXPLOG)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return {simd_avx512::exp_array, simd_avx512::log_array, "avx512f"};
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return {simd_avx2::exp_array, simd_avx2::log_array, "avx2"};
+  }
+  return {simd_base::exp_array, simd_base::log_array, "sse2"};
+#elif BGMS_HAVE_SIMD_EXPLOG && defined(__x86_64__)
+  return {simd_base::exp_array, simd_base::log_array, "sse2"};
+#elif BGMS_HAVE_SIMD_EXPLOG
+  return {simd_base::exp_array, simd_base::log_array, "neon"};
+#else
+  return {scalar_exp_array, scalar_log_array, "scalar"};
+#endif
+}
+
+// Resolved once, on first use; static initialization is thread-safe.
+const Dispatch& dispatch() {
+  static const Dispatch d = select_dispatch();
+  return d;
+}
+
+}  // namespace
+
+
+void simd_exp(const double* x, double* y, std::size_t n) {
+  dispatch().exp_fn(x, y, n);
+}
+
+void simd_log(const double* x, double* y, std::size_t n) {
+  dispatch().log_fn(x, y, n);
+}
+
+const char* simd_explog_isa() {
+  return dispatch().isa;
+}
@@ -0,0 +1,166 @@
+/**
+ * @file simd_explog_kernel.h
+ * @brief Vector exp/log kernel body, included once per instruction set.
+ *
+ * Deliberately has no include guard: simd_explog.cpp includes it several
+ * times, each time inside a different `#pragma GCC target` region and with
+ * BGMS_SIMD_WIDTH / BGMS_SIMD_NS set, to instantiate the same kernel for
+ * SSE2/NEON (2 lanes), AVX2 (4 lanes) and AVX-512 (8 lanes). Every lane
+ * performs the same sequence of IEEE operations (no FMA contraction), so
+ * all instantiations return bit-identical results.
+ *
+ * exp: Cody-Waite reduction x = n*ln2 + r, |r| <= ln2/2, degree-13
+ *      Taylor polynomial (Estrin scheme), and 2^n applied as two exactly representable
+ *      factors so gradual underflow near -745 is handled.
+ * log: fdlibm e_log.c reduction x = 2^k * m, m in [sqrt(2)/2, sqrt(2)),
+ *      and its minimax polynomial Lg1..Lg7.
+ */
+
+namespace BGMS_SIMD_NS {
+
+typedef double             vd __attribute__((vector_size(8 * BGMS_SIMD_WIDTH)));
+typedef long long          vi __attribute__((vector_size(8 * BGMS_SIMD_WIDTH)));
+typedef unsigned long long vu __attribute__((vector_size(8 * BGMS_SIMD_WIDTH)));
+
+constexpr std::size_t W = BGMS_SIMD_WIDTH;
+
+#define BGMS_SIMD_INLINE static inline __attribute__((always_inline))
+
+BGMS_SIMD_INLINE vd splat(double a) {
+  vd v;
+  for (std::size_t k = 0; k < W; ++k) v[k] = a;
+  return v;
+}
+
+// Lane-wise mask ? a : b, mask lanes are all-ones or all-zeros.
+BGMS_SIMD_INLINE vd select(vi mask, vd a, vd b) {
+  return (vd)(((vi)a & mask) | ((vi)b & ~mask));
+}
+
+BGMS_SIMD_INLINE vd exp_v(vd x) {
+  const double LOG2E  = 1.44269504088896338700e+00;
+  const double LN2_HI = 6.93147180369123816490e-01;
+  const double LN2_LO = 1.90821492927058770002e-10;
+  const double SHIFT  = 6755399441055744.0;            // 1.5 * 2^52
+  const double OVER   = 7.09782712893383973096e+02;    // log(DBL_MAX)
+  const double UNDER  = -7.45133219101941108420e+02;   // log(min subnormal / 2)
+
+  // Clamp so the integer part stays small; NaN compares false and passes.
+  vd xc = select((vi)(x > 710.0), splat(710.0), x);
+  xc = select((vi)(xc < -746.0), splat(-746.0), xc);
+
+  // n = nearest(x / ln2), read back as an integer from the shifted bits.
+  const vd shift = splat(SHIFT);
+  vd t = xc * LOG2E + shift;
+  vd n = t - shift;
+  vi ni = (vi)t - (vi)shift;
+  vd r = (xc - n * LN2_HI) - n * LN2_LO;
+
+  // exp(r) = 1 + (r + r^2 * Q(r)), Q(r) = sum_{k=2}^{13} r^(k-2) / k!,
+  // with Q evaluated by Estrin's scheme for a shorter dependency chain.
+  vd r2 = r * r;
+  vd r4 = r2 * r2;
+  vd r8 = r4 * r4;
+  vd q01   = 0.5 + r * (1.0 / 6.0);
+  vd q23   = (1.0 / 24.0) + r * (1.0 / 120.0);
+  vd q45   = (1.0 / 720.0) + r * (1.0 / 5040.0);
+  vd q67   = (1.0 / 40320.0) + r * (1.0 / 362880.0);
+  vd q89   = (1.0 / 3628800.0) + r * (1.0 / 39916800.0);
+  vd q1011 = (1.0 / 479001600.0) + r * (1.0 / 6227020800.0);
+  vd q03   = q01 + r2 * q23;
+  vd q47   = q45 + r2 * q67;
+  vd q811  = q89 + r2 * q1011;
+  vd q     = (q03 + r4 * q47) + r8 * q811;
+  vd p     = 1.0 + (r + r2 * q);
+
+  // 2^n = 2^k1 * 2^k2 with both factors normal for n in [-1076, 1024].
+  vi k1 = (vi)(n * 0.5 + shift) - (vi)shift;
+  vi k2 = ni - k1;
+  vd s1 = (vd)((vu)(k1 + 1023) << 52);
+  vd s2 = (vd)((vu)(k2 + 1023) << 52);
+  vd y = p * s1 * s2;
+
+  y = select((vi)(x > OVER), splat(__builtin_inf()), y);
+  y = select((vi)(x < UNDER), splat(0.0), y);
+  return select((vi)(x != x), x, y);
+}
+
+BGMS_SIMD_INLINE vd log_v(vd x) {
+  const double TWO54  = 1.80143985094819840000e+16;
+  const double TWO52  = 4.50359962737049600000e+15;
+  const double MIN_NORMAL = 2.2250738585072014e-308;
+  const double SQRT2  = 1.41421356237309514547e+00;
+  const double LN2_HI = 6.93147180369123816490e-01;
+  const double LN2_LO = 1.90821492927058770002e-10;
+  const double Lg1 = 6.666666666666735130e-01;
+  const double Lg2 = 3.999999999940941908e-01;
+  const double Lg3 = 2.857142874366239149e-01;
+  const double Lg4 = 2.222219843214978396e-01;
+  const double Lg5 = 1.818357216161805012e-01;
+  const double Lg6 = 1.531383769920937332e-01;
+  const double Lg7 = 1.479819860511658591e-01;
+
+  // Scale subnormals into the normal range.
+  vi subnormal = (vi)(x < MIN_NORMAL);
+  vd xs = select(subnormal, x * TWO54, x);
+
+  // x = 2^e * m with m in [1, 2); exponent converted via 2^52 + field.
+  vu bits = (vu)xs;
+  vu field = (bits >> 52) & 0x7ffULL;
+  vd e = (vd)(field | 0x4330000000000000ULL) - TWO52;
+  e = e - 1023.0 - select(subnormal, splat(54.0), splat(0.0));
+  vd m = (vd)((bits & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL);
+
+  // Move m into [sqrt(2)/2, sqrt(2)).
+  vi big = (vi)(m > SQRT2);
+  m = select(big, m * 0.5, m);
+  e = select(big, e + 1.0, e);
+
+  vd f = m - 1.0;
+  vd hfsq = 0.5 * f * f;
+  vd s = f / (2.0 + f);
+  vd z = s * s;
+  vd w = z * z;
+  vd t1 = w * (Lg2 + w * (Lg4 + w * Lg6));
+  vd t2 = z * (Lg1 + w * (Lg3 + w * (Lg5 + w * Lg7)));
+  vd R = t2 + t1;
+  vd y = e * LN2_HI - ((hfsq - (s * (hfsq + R) + e * LN2_LO)) - f);
+
+  y = select((vi)(x == __builtin_inf()), splat(__builtin_inf()), y);
+  y = select((vi)(x == 0.0), splat(-__builtin_inf()), y);
+  y = select((vi)(x < 0.0), splat(__builtin_nan("")), y);
+  return select((vi)(x != x), x, y);
+}
+
+// Apply op lane-wise to x[0..n), padding the tail with `pad`.
+template <vd (*op)(vd)>
+static inline void apply(const double* x, double* y, std::size_t n, double pad) {
+  std::size_t i = 0;
+  for (; i + W <= n; i += W) {
+    vd v;
+    std::memcpy(&v, x + i, sizeof(vd));
+    v = op(v);
+    std::memcpy(y + i, &v, sizeof(vd));
+  }
+  if (i < n) {
+    double buf[W];
+    for (std::size_t k = 0; k < W; ++k) buf[k] = (i + k < n) ? x[i + k] : pad;
+    vd v;
+    std::memcpy(&v, buf, sizeof(vd));
+    v = op(v);
+    std::memcpy(buf, &v, sizeof(vd));
+    for (std::size_t k = 0; i + k < n; ++k) y[i + k] = buf[k];
+  }
+}
+
+void exp_array(const double* x, double* y, std::size_t n) {
+  apply<exp_v>(x, y, n, 0.0);
+}
+
+void log_array(const double* x, double* y, std::size_t n) {
+  apply<log_v>(x, y, n, 1.0);
+}
+
+#undef BGMS_SIMD_INLINE
+
+}  // namespace BGMS_SIMD_NS
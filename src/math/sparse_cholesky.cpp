@@ -0,0 +1,291 @@
+#include "math/sparse_cholesky.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+
+void SparseCholesky::analyze_graph(std::vector<std::vector<std::size_t>> adjacency) {
+    const std::size_t n = adjacency.size();
+    for (auto& nbrs : adjacency) {
+        std::sort(nbrs.begin(), nbrs.end());
+        nbrs.erase(std::unique(nbrs.begin(), nbrs.end()), nbrs.end());
+    }
+
+    // Upper pattern in original indices: rows i < q of every column q.
+    std::vector<std::vector<std::size_t>> original(n);
+    for (std::size_t q = 0; q < n; ++q) {
+        for (std::size_t i : adjacency[q]) {
+            if (i < q) original[q].push_back(i);
+        }
+    }
+
+    // Minimum-degree ordering on the elimination graph: eliminating v makes
+    // its remaining neighbours a clique. Ties go to the lowest index, so the
+    // ordering depends on the graph only.
+    perm_.clear();
+    perm_.reserve(n);
+    std::vector<char> eliminated(n, 0);
+    std::vector<std::size_t> merged;
+    for (std::size_t step = 0; step < n; ++step) {
+        std::size_t v = n;
+        for (std::size_t u = 0; u < n; ++u) {
+            if (!eliminated[u] && (v == n || adjacency[u].size() < adjacency[v].size())) v = u;
+        }
+        perm_.push_back(v);
+        eliminated[v] = 1;
+        const std::vector<std::size_t> clique = std::move(adjacency[v]);
+        adjacency[v].clear();
+        for (std::size_t u : clique) {
+            merged.clear();
+            std::set_union(adjacency[u].begin(), adjacency[u].end(),
+                           clique.begin(), clique.end(), std::back_inserter(merged));
+            merged.erase(std::remove_if(merged.begin(), merged.end(),
+                                        [&](std::size_t w) { return w == u || w == v; }),
+                         merged.end());
+            adjacency[u].swap(merged);
+        }
+    }
+    iperm_.assign(n, 0);
+    for (std::size_t k = 0; k < n; ++k) iperm_[perm_[k]] = k;
+
+    // Upper triangle of P A P': entry (i, q) goes to column max(iperm) at
+    // row min(iperm).
+    std::vector<std::vector<std::size_t>> columns(n);
+    for (std::size_t q = 0; q < n; ++q) {
+        for (std::size_t i : original[q]) {
+            const std::size_t a = iperm_[i], b = iperm_[q];
+            columns[std::max(a, b)].push_back(std::min(a, b));
+        }
+    }
+    Ap_.assign(n + 1, 0);
+    Ai_.clear();
+    for (std::size_t k = 0; k < n; ++k) {
+        std::sort(columns[k].begin(), columns[k].end());
+        Ai_.insert(Ai_.end(), columns[k].begin(), columns[k].end());
+        Ai_.push_back(k);
+        Ap_[k + 1] = Ai_.size();
+    }
+    symbolic();
+}
+
+
+void SparseCholesky::insert(std::size_t i, std::size_t j) {
+    const std::size_t a = iperm_[i], b = iperm_[j];
+    const std::size_t lo = std::min(a, b), hi = std::max(a, b);
+    if (lo == hi) return;
+    auto first = Ai_.begin() + Ap_[hi];
+    auto last = Ai_.begin() + Ap_[hi + 1] - 1;   // diagonal is last
+    auto it = std::lower_bound(first, last, lo);
+    if (it != last && *it == lo) return;
+    Ai_.insert(it, lo);
+    for (std::size_t k = hi + 1; k < Ap_.size(); ++k) ++Ap_[k];
+    symbolic();
+}
+
+
+void SparseCholesky::symbolic() {
+    const std::size_t n = perm_.size();
+
+    // Original row and column of every stored entry of A
+    A_row_.resize(Ai_.size());
+    A_col_.resize(Ai_.size());
+    Ax_.assign(Ai_.size(), 0.0);
+    for (std::size_t k = 0; k < n; ++k) {
+        for (std::size_t p = Ap_[k]; p < Ap_[k + 1]; ++p) {
+            A_row_[p] = perm_[Ai_[p]];
+            A_col_[p] = perm_[k];
+        }
+    }
+
+    // Elimination tree with path compression (Liu)
+    parent_.assign(n, -1);
+    std::vector<std::ptrdiff_t> ancestor(n, -1);
+    for (std::size_t k = 0; k < n; ++k) {
+        const std::ptrdiff_t kk = static_cast<std::ptrdiff_t>(k);
+        for (std::size_t p = Ap_[k]; p + 1 < Ap_[k + 1]; ++p) {
+            std::ptrdiff_t i = static_cast<std::ptrdiff_t>(Ai_[p]);
+            while (i != -1 && i < kk) {
+                const std::ptrdiff_t next = ancestor[i];
+                ancestor[i] = kk;
+                if (next == -1) parent_[i] = kk;
+                i = next;
+            }
+        }
+    }
+
+    // Row k of L is the union of the tree paths from the rows of column k
+    // of A up to k; count the entries of each column from these row
+    // patterns, then lay out the rows in increasing order, diagonal first.
+    flag_.assign(n, -1);
+    std::vector<std::size_t> count(n, 1);
+    for (std::size_t k = 0; k < n; ++k) {
+        const std::ptrdiff_t kk = static_cast<std::ptrdiff_t>(k);
+        flag_[k] = kk;
+        for (std::size_t p = Ap_[k]; p + 1 < Ap_[k + 1]; ++p) {
+            for (std::ptrdiff_t i = static_cast<std::ptrdiff_t>(Ai_[p]); flag_[i] != kk; i = parent_[i]) {
+                ++count[i];
+                flag_[i] = kk;
+            }
+        }
+    }
+    Lp_.assign(n + 1, 0);
+    for (std::size_t k = 0; k < n; ++k) Lp_[k + 1] = Lp_[k] + count[k];
+    Li_.assign(Lp_[n], 0);
+    Lx_.assign(Lp_[n], 0.0);
+
+    next_.resize(n);
+    for (std::size_t k = 0; k < n; ++k) {
+        Li_[Lp_[k]] = k;
+        next_[k] = Lp_[k] + 1;
+    }
+    flag_.assign(n, -1);
+    for (std::size_t k = 0; k < n; ++k) {
+        const std::ptrdiff_t kk = static_cast<std::ptrdiff_t>(k);
+        flag_[k] = kk;
+        for (std::size_t p = Ap_[k]; p + 1 < Ap_[k + 1]; ++p) {
+            for (std::ptrdiff_t i = static_cast<std::ptrdiff_t>(Ai_[p]); flag_[i] != kk; i = parent_[i]) {
+                Li_[next_[i]++] = k;
+                flag_[i] = kk;
+            }
+        }
+    }
+
+    x_.assign(n, 0.0);
+    y_.assign(n, 0.0);
+    w_.assign(n, 0.0);
+    stack_.resize(n);
+}
+
+
+bool SparseCholesky::factorize_numeric() {
+    // Up-looking factorization (cs_chol): row k of L from a sparse
+    // triangular solve with the rows of L computed so far.
+    const std::size_t n = perm_.size();
+    flag_.assign(n, -1);
+    for (std::size_t k = 0; k < n; ++k) next_[k] = Lp_[k];
+
+    for (std::size_t k = 0; k < n; ++k) {
+        const std::ptrdiff_t kk = static_cast<std::ptrdiff_t>(k);
+
+        // Pattern of row k in topological order, in stack_[top, n)
+        std::size_t top = n;
+        flag_[k] = kk;
+        for (std::size_t p = Ap_[k]; p + 1 < Ap_[k + 1]; ++p) {
+            std::size_t len = 0;
+            for (std::ptrdiff_t i = static_cast<std::ptrdiff_t>(Ai_[p]); flag_[i] != kk; i = parent_[i]) {
+                stack_[len++] = static_cast<std::size_t>(i);
+                flag_[i] = kk;
+            }
+            while (len > 0) stack_[--top] = stack_[--len];
+        }
+
+        for (std::size_t p = Ap_[k]; p + 1 < Ap_[k + 1]; ++p) x_[Ai_[p]] = Ax_[p];
+        double d = Ax_[Ap_[k + 1] - 1];
+
+        for (; top < n; ++top) {
+            const std::size_t i = stack_[top];
+            const double lki = x_[i] / Lx_[Lp_[i]];
+            x_[i] = 0.0;
+            for (std::size_t p = Lp_[i] + 1; p < next_[i]; ++p) {
+                x_[Li_[p]] -= Lx_[p] * lki;
+            }
+            d -= lki * lki;
+            const std::size_t p = next_[i]++;
+            Li_[p] = k;
+            Lx_[p] = lki;
+        }
+        if (!(d > 0.0)) {
+            std::fill(x_.begin(), x_.end(), 0.0);
+            return false;
+        }
+        const std::size_t p = next_[k]++;
+        Li_[p] = k;
+        Lx_[p] = std::sqrt(d);
+    }
+    return true;
+}
+
+
+bool SparseCholesky::contains(std::size_t i, std::size_t j) const {
+    const std::size_t a = iperm_[i], b = iperm_[j];
+    if (a == b) return true;
+    const std::size_t lo = std::min(a, b), hi = std::max(a, b);
+    return std::binary_search(Li_.begin() + Lp_[lo] + 1, Li_.begin() + Lp_[lo + 1], hi);
+}
+
+
+double SparseCholesky::log_det() const {
+    double sum = 0.0;
+    for (std::size_t k = 0; k + 1 < Lp_.size(); ++k) sum += std::log(Lx_[Lp_[k]]);
+    return 2.0 * sum;
+}
+
+
+void SparseCholesky::solve_unit(std::size_t a, std::vector<double>& x,
+                                std::vector<std::size_t>& path) const {
+    // The nonzeros of L^{-1} e_a lie on the path from a to the root of the
+    // elimination tree, and every column of L only reaches its ancestors.
+    path.clear();
+    x[a] = 1.0;
+    for (std::ptrdiff_t c = static_cast<std::ptrdiff_t>(a); c != -1; c = parent_[c]) {
+        path.push_back(static_cast<std::size_t>(c));
+        const double xc = (x[c] /= Lx_[Lp_[c]]);
+        for (std::size_t p = Lp_[c] + 1; p < Lp_[c + 1]; ++p) {
+            x[Li_[p]] -= Lx_[p] * xc;
+        }
+    }
+}
+
+
+void SparseCholesky::inverse_entries(std::size_t i, std::size_t j,
+                                     double& s_ii, double& s_ij, double& s_jj) {
+    // (L L')^{-1}_{ab} = (L^{-1} e_a)' (L^{-1} e_b)
+    const std::size_t a = iperm_[i], b = iperm_[j];
+    solve_unit(a, x_, path_x_);
+    s_ii = 0.0;
+    for (std::size_t c : path_x_) s_ii += x_[c] * x_[c];
+
+    if (a == b) {
+        s_ij = s_jj = s_ii;
+    } else {
+        solve_unit(b, y_, path_y_);
+        s_jj = 0.0;
+        s_ij = 0.0;
+        for (std::size_t c : path_y_) s_jj += y_[c] * y_[c];
+        for (std::size_t c : path_x_) s_ij += x_[c] * y_[c];
+        for (std::size_t c : path_y_) y_[c] = 0.0;
+    }
+    for (std::size_t c : path_x_) x_[c] = 0.0;
+}
+
+
+bool SparseCholesky::rank_one_update(std::size_t i, double w_i, std::size_t j, double w_j,
+                                     int sigma) {
+    const std::size_t a = iperm_[i], b = iperm_[j];
+    const std::size_t f = std::min(a, b);
+    w_[a] = w_i;
+    if (b != a) w_[b] = w_j;
+
+    double beta = 1.0, beta2 = 1.0;
+    std::ptrdiff_t c = static_cast<std::ptrdiff_t>(f);
+    for (; c != -1; c = parent_[c]) {
+        std::size_t p = Lp_[c];
+        const double alpha = w_[c] / Lx_[p];
+        beta2 = beta * beta + sigma * alpha * alpha;
+        if (beta2 <= 0.0) break;
+        beta2 = std::sqrt(beta2);
+        const double delta = sigma > 0 ? beta / beta2 : beta2 / beta;
+        const double gamma = sigma * alpha / (beta2 * beta);
+        Lx_[p] = delta * Lx_[p] + (sigma > 0 ? gamma * w_[c] : 0.0);
+        beta = beta2;
+        for (++p; p < Lp_[c + 1]; ++p) {
+            const double w1 = w_[Li_[p]];
+            const double w2 = w1 - alpha * Lx_[p];
+            w_[Li_[p]] = w2;
+            Lx_[p] = delta * Lx_[p] + gamma * (sigma > 0 ? w1 : w2);
+        }
+    }
+    for (c = static_cast<std::ptrdiff_t>(f); c != -1; c = parent_[c]) w_[c] = 0.0;
+    return beta2 > 0.0;
+}
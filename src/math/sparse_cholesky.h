@@ -0,0 +1,127 @@
+#pragma once
+
+/**
+ * @file sparse_cholesky.h
+ * @brief Sparse Cholesky factor of a symmetric positive-definite matrix
+ *        with a fixed sparsity pattern.
+ *
+ * Factors P A P' = L L' for a p x p matrix A whose off-diagonal pattern is
+ * given as an undirected graph. The permutation P is a minimum-degree
+ * ordering of that graph, chosen to keep the fill of L small. L is stored
+ * column by column (compressed sparse columns, diagonal first).
+ *
+ * Besides the numeric factorization the class offers what a Metropolis
+ * sampler for a sparse precision matrix needs:
+ *
+ *   - log|A| from the diagonal of L;
+ *   - individual entries of A^{-1}, from sparse triangular solves that
+ *     only visit the elimination-tree path of the requested index;
+ *   - rank-one updates and downdates of L for a change of A that touches
+ *     one or two rows and columns already in the pattern of L
+ *     (the up/down-date of Davis and Hager, as in CSparse's cs_updown);
+ *   - insertion of a new off-diagonal entry into the pattern, with a
+ *     symbolic re-analysis under the existing ordering.
+ *
+ * All indices in the public interface are the original (unpermuted) ones.
+ * The algorithms follow Davis (2006), "Direct Methods for Sparse Linear
+ * Systems", chapters 4 and 7.
+ */
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+
+class SparseCholesky {
+public:
+    /**
+     * Choose the ordering and the pattern of L.
+     *
+     * @param p            Dimension of A
+     * @param rows_above   Callable: rows_above(q) is a container with the
+     *                     rows i < q of the off-diagonal entries of column q
+     */
+    template <typename RowsAbove>
+    void analyze(std::size_t p, RowsAbove&& rows_above) {
+        std::vector<std::vector<std::size_t>> adjacency(p);
+        for (std::size_t q = 0; q < p; ++q) {
+            for (std::size_t i : rows_above(q)) {
+                adjacency[i].push_back(q);
+                adjacency[q].push_back(i);
+            }
+        }
+        analyze_graph(std::move(adjacency));
+    }
+
+    /**
+     * Numeric factorization over the analyzed pattern.
+     *
+     * @param value  Callable: value(i, j) is A(i, j) in original indices;
+     *               only entries in the pattern and the diagonal are read
+     * @return false if A is not positive definite
+     */
+    template <typename Value>
+    bool factorize(Value&& value) {
+        for (std::size_t k = 0; k < Ax_.size(); ++k) {
+            Ax_[k] = value(A_row_[k], A_col_[k]);
+        }
+        return factorize_numeric();
+    }
+
+    /// Add the off-diagonal entry (i, j) to the pattern of A, keeping the
+    /// ordering. The factor must be recomputed with factorize() afterwards.
+    void insert(std::size_t i, std::size_t j);
+
+    /// Whether entry (i, j) is in the pattern of L + L' (including fill).
+    bool contains(std::size_t i, std::size_t j) const;
+
+    /// log|A| = 2 sum_k log L(k, k).
+    double log_det() const;
+
+    /**
+     * Entries (i, i), (i, j) and (j, j) of A^{-1}.
+     *
+     * Costs two sparse triangular solves along the elimination-tree paths
+     * of i and j and no more; i == j is allowed.
+     */
+    void inverse_entries(std::size_t i, std::size_t j,
+                         double& s_ii, double& s_ij, double& s_jj);
+
+    /**
+     * Rank-one update (sigma = +1) or downdate (sigma = -1) of L:
+     * A + sigma w w', where w has entries w_i at i and w_j at j and zeros
+     * elsewhere. (i, j) must be in the pattern of L unless i == j.
+     *
+     * @return false if a downdate leaves A not positive definite; L is then
+     *         partially modified and must be recomputed with factorize()
+     */
+    bool rank_one_update(std::size_t i, double w_i, std::size_t j, double w_j, int sigma);
+
+    std::size_t dimension() const { return perm_.size(); }
+    /// Nonzeros of L, including the diagonal.
+    std::size_t factor_nonzeros() const { return Lp_.empty() ? 0 : Lp_.back(); }
+
+private:
+    void analyze_graph(std::vector<std::vector<std::size_t>> adjacency);
+    void symbolic();
+    bool factorize_numeric();
+    // Solve L x = e_a, leaving the nonzeros of x on the path of a.
+    void solve_unit(std::size_t a, std::vector<double>& x, std::vector<std::size_t>& path) const;
+
+    std::vector<std::size_t> perm_;    ///< perm_[k] = original index of position k
+    std::vector<std::size_t> iperm_;   ///< iperm_[i] = position of original index i
+
+    // Upper triangle of P A P' (columns sorted, diagonal last), with the
+    // original row and column of every entry for factorize().
+    std::vector<std::size_t> Ap_, Ai_, A_row_, A_col_;
+    std::vector<double> Ax_;
+
+    std::vector<std::ptrdiff_t> parent_;  ///< Elimination tree (-1 = root)
+    std::vector<std::size_t> Lp_, Li_;    ///< Pattern of L, diagonal first
+    std::vector<double> Lx_;
+
+    // Workspaces
+    std::vector<double> x_, y_, w_;
+    std::vector<std::size_t> path_x_, path_y_, stack_, next_;
+    std::vector<std::ptrdiff_t> flag_;
+};
@@ -1,12 +1,21 @@
 #include <RcppArmadillo.h>
 #include <algorithm>
 #include <functional>
+#include <utility>
 #include "mcmc/algorithms/hmc.h"
 #include "mcmc/algorithms/leapfrog.h"
 #include "math/explog_macros.h"
 #include "rng/rng_utils.h"
 
 
+namespace {
+
+// Energy error beyond which a trajectory counts as divergent (NUTS's Delta_max)
+constexpr double divergence_threshold = 1000.0;
+
+}  // namespace
+
+
 double kinetic_energy(const arma::vec& r, const arma::vec& inv_mass_diag) {
   return 0.5 * arma::dot(r % inv_mass_diag, r);
 }
@@ -95,25 +104,26 @@ double heuristic_initial_step_size_constrained(
 ) {
   double eps = init_step;
 
-  Memoizer memo(joint);
-
-  // Log-posterior at initial position (does not change across iterations)
-  double logp0 = memo.cached_log_post(theta);
+  // Log-posterior and gradient at the initial position (does not change
+  // across attempts)
+  LeapfrogState z0, z1;
+  z0.theta = theta;
+  evaluate_state(z0, joint);
+  double logp0 = z0.logp;
 
   // Sample momentum and project onto cotangent space (momentum-only)
-  arma::vec r = arma::sqrt(1.0 / inv_mass_diag) % arma_rnorm_vec(rng, theta.n_elem);
-  project_momentum(r, theta);
-  double kin0 = kinetic_energy(r, inv_mass_diag);
+  z0.r = arma::sqrt(1.0 / inv_mass_diag) % arma_rnorm_vec(rng, theta.n_elem);
+  project_momentum(z0.r, theta);
+  double kin0 = kinetic_energy(z0.r, inv_mass_diag);
   double H0 = logp0 - kin0;
 
   // One constrained leapfrog step
-  auto [theta1, r1] = leapfrog_constrained(
-    theta, r, eps, memo, inv_mass_diag, project_position, project_momentum
+  leapfrog_constrained(
+    z0, eps, joint, inv_mass_diag, project_position, project_momentum, z1
   );
 
-  double logp1 = memo.cached_log_post(theta1);
-  double kin1 = kinetic_energy(r1, inv_mass_diag);
-  double H1 = logp1 - kin1;
+  double kin1 = kinetic_energy(z1.r, inv_mass_diag);
+  double H1 = z1.logp - kin1;
 
   double log_target = MY_LOG(target_acceptance);
   int direction = 2 * (H1 - H0 > log_target) - 1;
@@ -123,19 +133,18 @@ double heuristic_initial_step_size_constrained(
     eps = (direction == 1) ? 2.0 * eps : 0.5 * eps;
 
     // Resample momentum and project onto cotangent space
-    r = arma::sqrt(1.0 / inv_mass_diag) % arma_rnorm_vec(rng, theta.n_elem);
-    project_momentum(r, theta);
-    kin0 = kinetic_energy(r, inv_mass_diag);
+    z0.r = arma::sqrt(1.0 / inv_mass_diag) % arma_rnorm_vec(rng, theta.n_elem);
+    project_momentum(z0.r, theta);
+    kin0 = kinetic_energy(z0.r, inv_mass_diag);
     H0 = logp0 - kin0;
 
     // One constrained leapfrog step from original position
-    auto [theta_new, r_new] = leapfrog_constrained(
-      theta, r, eps, memo, inv_mass_diag, project_position, project_momentum
+    leapfrog_constrained(
+      z0, eps, joint, inv_mass_diag, project_position, project_momentum, z1
     );
 
-    logp1 = memo.cached_log_post(theta_new);
-    kin1 = kinetic_energy(r_new, inv_mass_diag);
-    H1 = logp1 - kin1;
+    kin1 = kinetic_energy(z1.r, inv_mass_diag);
+    H1 = z1.logp - kin1;
 
     attempts++;
   }
@@ -151,7 +160,8 @@ StepResult hmc_step(
     const std::function<std::pair<double, arma::vec>(const arma::vec&)>& joint,
     const int num_leapfrogs,
     const arma::vec& inv_mass_diag,
-    SafeRNG& rng
+    SafeRNG& rng,
+    HMCTrajectory* trajectory
 ) {
   // Sample initial momentum
   arma::vec init_r = arma::sqrt(1.0 / inv_mass_diag) % arma_rnorm_vec(rng, init_theta.n_elem);
@@ -170,10 +180,19 @@ StepResult hmc_step(
   double proposed_H = -result.log_post + kinetic_energy(result.r, inv_mass_diag);
   double log_accept_prob = current_H - proposed_H;
 
-  arma::vec state = (MY_LOG(runif(rng)) < log_accept_prob) ? result.theta : init_theta;
+  const bool accept = MY_LOG(runif(rng)) < log_accept_prob;
+  arma::vec state = accept ? result.theta : init_theta;
 
   double accept_prob = std::min(1.0, MY_EXP(log_accept_prob));
 
+  if (trajectory) {
+    trajectory->theta = result.theta;
+    trajectory->r = result.r;
+    trajectory->energy = accept ? proposed_H : current_H;
+    trajectory->divergent = !(proposed_H - current_H <= divergence_threshold);
+    trajectory->non_reversible = false;
+  }
+
   return {state, accept_prob};
 }
 
@@ -188,54 +207,143 @@ StepResult hmc_step(
     const ProjectMomentumFn& project_momentum,
     SafeRNG& rng,
     bool reverse_check,
-    double reverse_check_tol
+    double reverse_check_tol,
+    HMCTrajectory* trajectory
 ) {
-  Memoizer memo(joint);
-
   // Sample initial momentum and project onto cotangent space
-  arma::vec r = arma::sqrt(1.0 / inv_mass_diag) % arma_rnorm_vec(rng, init_theta.n_elem);
-  project_momentum(r, init_theta);
+  LeapfrogState z, z_next, scratch;
+  z.theta = init_theta;
+  z.r = arma::sqrt(1.0 / inv_mass_diag) % arma_rnorm_vec(rng, init_theta.n_elem);
+  project_momentum(z.r, init_theta);
 
-  double logp0 = memo.cached_log_post(init_theta);
-  double kin0 = kinetic_energy(r, inv_mass_diag);
-  double H0 = logp0 - kin0;
+  evaluate_state(z, joint);
+  double kin0 = kinetic_energy(z.r, inv_mass_diag);
+  double H0 = z.logp - kin0;
 
   // Run num_leapfrogs constrained leapfrog steps
-  arma::vec theta = init_theta;
   bool non_reversible = false;
   for (int i = 0; i < num_leapfrogs; ++i) {
     if (reverse_check) {
-      auto checked = leapfrog_constrained_checked(
-        theta, r, step_size, memo, inv_mass_diag,
+      const bool reversible = leapfrog_constrained_checked(
+        z, step_size, joint, inv_mass_diag,
         project_position, project_momentum,
-        reverse_check_tol
+        reverse_check_tol, z_next, scratch
       );
-      theta = std::move(checked.theta);
-      r = std::move(checked.r);
-      if (!checked.reversible) {
+      std::swap(z, z_next);
+      if (!reversible) {
         non_reversible = true;
         break;
       }
     } else {
-      std::tie(theta, r) = leapfrog_constrained(
-        theta, r, step_size, memo, inv_mass_diag,
-        project_position, project_momentum
+      leapfrog_constrained(
+        z, step_size, joint, inv_mass_diag,
+        project_position, project_momentum, z_next
       );
+      std::swap(z, z_next);
     }
   }
 
   // Non-reversible step forces rejection
   if (non_reversible) {
+    if (trajectory) {
+      trajectory->theta = std::move(z.theta);
+      trajectory->r = std::move(z.r);
+      trajectory->energy = -H0;
+      trajectory->divergent = false;
+      trajectory->non_reversible = true;
+    }
     return {init_theta, 0.0};
   }
 
-  double logp1 = memo.cached_log_post(theta);
-  double kin1 = kinetic_energy(r, inv_mass_diag);
-  double H1 = logp1 - kin1;
+  double kin1 = kinetic_energy(z.r, inv_mass_diag);
+  double H1 = z.logp - kin1;
 
   double log_accept_prob = H1 - H0;
-  arma::vec state = (MY_LOG(runif(rng)) < log_accept_prob) ? theta : init_theta;
+  const bool accept = MY_LOG(runif(rng)) < log_accept_prob;
+  arma::vec state = accept ? z.theta : init_theta;
   double accept_prob = std::min(1.0, MY_EXP(log_accept_prob));
 
+  if (trajectory) {
+    trajectory->theta = std::move(z.theta);
+    trajectory->r = std::move(z.r);
+    trajectory->energy = accept ? -H1 : -H0;
+    trajectory->divergent = !(H0 - H1 <= divergence_threshold);
+    trajectory->non_reversible = false;
+  }
+
   return {state, accept_prob};
 }
+
+
+void hmc_step_batch(std::vector<HMCBatchMember>& members, const BatchJointFn& joint) {
+  const std::size_t n = members.size();
+  if (n == 0) return;
+
+  // Initial momenta, each from its chain's stream as in hmc_step
+  std::vector<arma::vec> init_r(n), r(n), theta(n), grad(n);
+  for (std::size_t k = 0; k < n; ++k) {
+    const HMCBatchMember& member = members[k];
+    init_r[k] = arma::sqrt(1.0 / member.inv_mass_diag) %
+      arma_rnorm_vec(*member.rng, member.init_theta.n_elem);
+    r[k] = init_r[k];
+    theta[k] = member.init_theta;
+  }
+
+  // Log_post and gradient at the initial positions, in one call
+  std::vector<std::size_t> active(n);
+  int max_leapfrogs = 0;
+  for (std::size_t k = 0; k < n; ++k) {
+    active[k] = k;
+    max_leapfrogs = std::max(max_leapfrogs, members[k].num_leapfrogs);
+  }
+  std::vector<std::pair<double, arma::vec>> evaluations;
+  joint(active, theta, evaluations);
+  std::vector<double> log_post_0(n), log_post(n);
+  for (std::size_t k = 0; k < n; ++k) {
+    log_post_0[k] = evaluations[k].first;
+    log_post[k] = log_post_0[k];
+    grad[k] = std::move(evaluations[k].second);
+  }
+
+  // Leapfrog steps, in the order of leapfrog(); the members whose
+  // trajectories are still running share each gradient call
+  std::vector<arma::vec> positions;
+  for (int step = 0; step < max_leapfrogs; ++step) {
+    active.clear();
+    positions.clear();
+    for (std::size_t k = 0; k < n; ++k) {
+      const HMCBatchMember& member = members[k];
+      if (step >= member.num_leapfrogs) continue;
+      r[k] += 0.5 * member.step_size * grad[k];
+      theta[k] += member.step_size * (member.inv_mass_diag % r[k]);
+      active.push_back(k);
+      positions.push_back(theta[k]);
+    }
+    joint(active, positions, evaluations);
+    for (std::size_t a = 0; a < active.size(); ++a) {
+      const std::size_t k = active[a];
+      grad[k] = std::move(evaluations[a].second);
+      r[k] += 0.5 * members[k].step_size * grad[k];
+      log_post[k] = evaluations[a].first;
+    }
+  }
+
+  // Accept or reject each member as hmc_step does
+  for (std::size_t k = 0; k < n; ++k) {
+    HMCBatchMember& member = members[k];
+    double current_H = -log_post_0[k] + kinetic_energy(init_r[k], member.inv_mass_diag);
+    double proposed_H = -log_post[k] + kinetic_energy(r[k], member.inv_mass_diag);
+    double log_accept_prob = current_H - proposed_H;
+
+    const bool accept = MY_LOG(runif(*member.rng)) < log_accept_prob;
+    member.result.state = accept ? theta[k] : member.init_theta;
+    member.result.accept_prob = std::min(1.0, MY_EXP(log_accept_prob));
+    member.result.diagnostics.reset();
+
+    member.trajectory.theta = theta[k];
+    member.trajectory.r = r[k];
+    member.trajectory.energy = accept ? proposed_H : current_H;
+    member.trajectory.divergent = !(proposed_H - current_H <= divergence_threshold);
+    member.trajectory.non_reversible = false;
+  }
+}
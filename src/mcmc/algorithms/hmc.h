@@ -3,6 +3,7 @@
 #include <RcppArmadillo.h>
 #include <functional>
 #include <utility>
+#include <vector>
 #include "mcmc/execution/step_result.h"
 #include "mcmc/algorithms/leapfrog.h"
 struct SafeRNG;
@@ -107,6 +108,22 @@ double heuristic_initial_step_size_constrained(
 );
 
 
+/**
+ * HMCTrajectory - Where an hmc_step trajectory ended
+ *
+ * Filled by hmc_step when requested, whether or not the proposal was
+ * accepted. The adaptive-HMC sampler uses the end point to tune the
+ * trajectory length and reports the rest as NUTS-style diagnostics.
+ */
+struct HMCTrajectory {
+  arma::vec theta;           ///< Proposed position (end of the trajectory)
+  arma::vec r;               ///< Momentum at the end of the trajectory
+  double energy = 0.0;       ///< Hamiltonian (-log posterior + kinetic) of the returned state
+  bool divergent = false;    ///< Energy error above 1000 (as in NUTS)
+  bool non_reversible = false; ///< A constrained step failed the reverse check
+};
+
+
 /**
  * Performs one iteration of Hamiltonian Monte Carlo sampling
  *
@@ -122,6 +139,7 @@ double heuristic_initial_step_size_constrained(
  * @param num_leapfrogs  Number of leapfrog steps per proposal
  * @param inv_mass_diag  Diagonal of the inverse mass matrix
  * @param rng            Thread-safe random number generator
+ * @param trajectory     If non-null, receives the end of the trajectory
  * @return StepResult with accepted state and acceptance probability
  */
 StepResult hmc_step(
@@ -131,7 +149,8 @@ StepResult hmc_step(
     const std::function<std::pair<double, arma::vec>(const arma::vec&)>& joint,
     const int num_leapfrogs,
     const arma::vec& inv_mass_diag,
-    SafeRNG& rng
+    SafeRNG& rng,
+    HMCTrajectory* trajectory = nullptr
 );
 
 
@@ -152,6 +171,8 @@ StepResult hmc_step(
  * @param rng               Thread-safe random number generator
  * @param reverse_check     Enable runtime reversibility check
  * @param reverse_check_tol Factor for eps²-scaled reversibility tolerance
+ * @param trajectory        If non-null, receives the end of the trajectory
+ *                          (cut short at a non-reversible step)
  * @return StepResult with accepted state and acceptance probability
  */
 StepResult hmc_step(
@@ -164,5 +185,50 @@ StepResult hmc_step(
     const ProjectMomentumFn& project_momentum,
     SafeRNG& rng,
     bool reverse_check = true,
-    double reverse_check_tol = 0.5
+    double reverse_check_tol = 0.5,
+    HMCTrajectory* trajectory = nullptr
 );
+
+
+/**
+ * HMCBatchMember - One chain of an hmc_step_batch call
+ *
+ * The chain fills the inputs before the call; hmc_step_batch fills
+ * `result` and `trajectory` as hmc_step does.
+ */
+struct HMCBatchMember {
+  arma::vec init_theta;      ///< Initial parameter vector (position)
+  double step_size = 0.0;    ///< Leapfrog integration step size (epsilon)
+  int num_leapfrogs = 0;     ///< Number of leapfrog steps per proposal
+  arma::vec inv_mass_diag;   ///< Diagonal of the inverse mass matrix
+  SafeRNG* rng = nullptr;    ///< The chain's random number generator
+  StepResult result;         ///< Accepted state and acceptance probability
+  HMCTrajectory trajectory;  ///< End of the trajectory
+};
+
+
+/**
+ * Joint log-posterior + gradient of several chains at once: receives the
+ * indices of the members to evaluate, their positions, and fills one
+ * (log-posterior, gradient) pair per member, in the same order.
+ */
+using BatchJointFn = std::function<void(
+    const std::vector<std::size_t>& members,
+    const std::vector<arma::vec>& thetas,
+    std::vector<std::pair<double, arma::vec>>& results)>;
+
+
+/**
+ * One unconstrained HMC iteration for several chains in lockstep
+ *
+ * Every member takes the step hmc_step would take, from its own RNG and
+ * with its own step size, step count and inverse mass, but the leapfrog
+ * steps of all members advance together so that each evaluation of the
+ * members' gradients is one call of `joint`; a member drops out of the
+ * calls once its trajectory has ended. The draws are hmc_step's as long
+ * as `joint` returns what each chain's own evaluation would.
+ *
+ * @param members  Chains to step; their results are filled in place
+ * @param joint    Batched joint log-posterior + gradient function
+ */
+void hmc_step_batch(std::vector<HMCBatchMember>& members, const BatchJointFn& joint);
@@ -1,106 +1,78 @@
 #include <RcppArmadillo.h>
 #include <functional>
-#include <utility>
 #include "mcmc/algorithms/leapfrog.h"
+#include "mcmc/execution/chain_profile.h"
 
 
-std::pair<arma::vec, arma::vec> leapfrog_memo(
-    const arma::vec& theta,
-    const arma::vec& r,
+void leapfrog_constrained(
+    const LeapfrogState& z,
     double eps,
-    Memoizer& memo,
-    const arma::vec& inv_mass_diag
-) {
-  arma::vec r_half = r;
-  arma::vec theta_new = theta;
-
-  const arma::vec& grad1 = memo.cached_grad(theta_new);
-
-  r_half += 0.5 * eps * grad1;
-  theta_new += eps * (inv_mass_diag % r_half);
-
-  const arma::vec& grad2 = memo.cached_grad(theta_new);
-
-  r_half += 0.5 * eps * grad2;
-
-  return {theta_new, r_half};
-}
-
-
-std::pair<arma::vec, arma::vec> leapfrog_constrained(
-    const arma::vec& theta,
-    const arma::vec& r,
-    double eps,
-    Memoizer& memo,
+    const JointFn& joint,
     const arma::vec& inv_mass_diag,
     const ProjectPositionFn& project_position,
-    const ProjectMomentumFn& project_momentum
+    const ProjectMomentumFn& project_momentum,
+    LeapfrogState& out
 ) {
-  arma::vec r_half = r;
-  arma::vec theta_new = theta;
+  BGMS_PROFILE_SCOPE(Leapfrog);
+  out.r = z.r;
+  out.theta = z.theta;
 
   // --- Step 1: Half-step momentum ---
-  const arma::vec& grad1 = memo.cached_grad(theta_new);
-  r_half += 0.5 * eps * grad1;
+  out.r += 0.5 * eps * z.grad;
 
   // --- Step 2: Project momentum onto cotangent space ---
-  project_momentum(r_half, theta_new);
+  project_momentum(out.r, out.theta);
 
   // --- Step 3: Full-step position ---
-  theta_new += eps * (inv_mass_diag % r_half);
+  out.theta += eps * (inv_mass_diag % out.r);
 
   // --- Step 4: SHAKE — position-only projection ---
-  arma::vec theta_pre = theta_new;
-  project_position(theta_new);
+  arma::vec theta_pre = out.theta;
+  project_position(out.theta);
 
   // --- Step 5: Momentum correction for constraint forces ---
-  arma::vec delta_x = theta_new - theta_pre;
-  r_half += delta_x / (eps * inv_mass_diag);
+  arma::vec delta_x = out.theta - theta_pre;
+  out.r += delta_x / (eps * inv_mass_diag);
 
-  memo.invalidate();
-
-  // --- Step 6: Second half-step momentum ---
-  const arma::vec& grad2 = memo.cached_grad(theta_new);
-  r_half += 0.5 * eps * grad2;
+  // --- Step 6: Second half-step momentum, at the projected position ---
+  evaluate_state(out, joint);
+  out.r += 0.5 * eps * out.grad;
 
   // --- Step 7: Project momentum onto cotangent space ---
-  project_momentum(r_half, theta_new);
-
-  return {theta_new, r_half};
+  project_momentum(out.r, out.theta);
 }
 
 
-ConstrainedLeapfrogResult leapfrog_constrained_checked(
-    const arma::vec& theta,
-    const arma::vec& r,
+bool leapfrog_constrained_checked(
+    const LeapfrogState& z,
     double eps,
-    Memoizer& memo,
+    const JointFn& joint,
     const arma::vec& inv_mass_diag,
     const ProjectPositionFn& project_position,
     const ProjectMomentumFn& project_momentum,
-    double reverse_check_tol
+    double reverse_check_tol,
+    LeapfrogState& out,
+    LeapfrogState& scratch
 ) {
   // --- Forward step ---
-  auto [theta_new, r_new] = leapfrog_constrained(
-    theta, r, eps, memo, inv_mass_diag,
-    project_position, project_momentum
+  leapfrog_constrained(
+    z, eps, joint, inv_mass_diag, project_position, project_momentum, out
   );
 
   // --- Backward step (negate momentum, step forward) ---
-  // Use a separate Memoizer so the caller's cache stays at theta_new.
-  Memoizer back_memo(memo.joint_fn);
-  arma::vec r_back = -r_new;
-  auto [theta_back, r_back_out] = leapfrog_constrained(
-    theta_new, r_back, eps, back_memo, inv_mass_diag,
-    project_position, project_momentum
+  // Starts from `out` itself, which already holds the gradient at the
+  // forward position; negation is exact, so out.r is restored bitwise.
+  out.r *= -1.0;
+  leapfrog_constrained(
+    out, eps, joint, inv_mass_diag,
+    project_position, project_momentum, scratch
   );
+  out.r *= -1.0;
 
   // --- Reversibility check (eps^2-scaled max-norm) ---
-  double max_diff = arma::max(arma::abs(theta_back - theta));
+  double max_diff = arma::max(arma::abs(scratch.theta - z.theta));
   double tol = reverse_check_tol * eps * eps;
-  bool reversible = (max_diff <= tol);
-
-  return {std::move(theta_new), std::move(r_new), reversible};
+  return max_diff <= tol;
 }
 
 
@@ -114,6 +86,7 @@ LeapfrogJointResult leapfrog(
     const arma::vec& inv_mass_diag,
     const arma::vec* init_grad
 ) {
+  BGMS_PROFILE_SCOPE_N(Leapfrog, num_leapfrogs);
   arma::vec r = r_init;
   arma::vec theta = theta_init;
 
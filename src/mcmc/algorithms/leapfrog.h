@@ -1,114 +1,88 @@
 #pragma once
 
 #include <RcppArmadillo.h>
-#include <cstring>
 #include <functional>
 #include <utility>
+#include "mcmc/execution/chain_profile.h"
 
 // ---------------------------------------------------------------------------
-// Memoizer — single-entry cache for joint log-posterior + gradient evaluations
+// LeapfrogState — a phase-space point with its log-posterior and gradient
 // ---------------------------------------------------------------------------
 
 /**
- * Memoizer - Single-entry cache for joint log-posterior and gradient evaluations.
- *
- * In NUTS, the typical access pattern within a leapfrog step is:
- *   1. cached_grad(theta) — compute gradient (and cache logp as side-effect)
- *   2. cached_log_post(theta) — retrieve the already-cached logp
- *
- * A single-entry cache is optimal here because each leapfrog step produces
- * a new unique theta: hash-map lookups would almost never hit, and hashing
- * an arma::vec element-by-element is expensive.
+ * Joint log-posterior and gradient function: returns (log_post, gradient)
+ * at a position. Models compute both together because they share most of
+ * the work.
+ */
+using JointFn = std::function<std::pair<double, arma::vec>(const arma::vec&)>;
+
+/**
+ * LeapfrogState - Position, momentum, log-posterior and gradient
  *
- * The joint evaluation function computes both logp and gradient together
- * (since models often share most of the computation between the two).
+ * The integrators take a state whose logp and grad belong to its theta and
+ * return the next state with its own logp and grad, so every position is
+ * evaluated exactly once. NUTS carries these states through the tree: the
+ * gradient at a subtree endpoint is already there when the next subtree
+ * starts from it, and the log-posterior of a leaf is the one computed
+ * during its leapfrog step.
  */
-class Memoizer {
-public:
-  using JointFn = std::function<std::pair<double, arma::vec>(const arma::vec&)>;
-
-  JointFn joint_fn;
-
-  // Single-entry cache
-  arma::vec cached_theta;
-  double    cached_logp_val;
-  arma::vec cached_grad_val;
-  bool      has_cache = false;
-
-  /**
-   * Construct from separate log_post and grad functions.
-   * Calls them independently (backward-compatible).
-   */
-  Memoizer(
-    const std::function<double(const arma::vec&)>& lp,
-    const std::function<arma::vec(const arma::vec&)>& gr
-  ) : joint_fn([lp, gr](const arma::vec& theta) -> std::pair<double, arma::vec> {
-        arma::vec g = gr(theta);
-        double v = lp(theta);
-        return {v, std::move(g)};
-      }) {}
-
-  /**
-   * Construct from a joint function that computes both at once.
-   */
-  explicit Memoizer(JointFn jf) : joint_fn(std::move(jf)) {}
-
-  double cached_log_post(const arma::vec& theta) {
-    ensure_cached(theta);
-    return cached_logp_val;
-  }
-
-  const arma::vec& cached_grad(const arma::vec& theta) {
-    ensure_cached(theta);
-    return cached_grad_val;
-  }
-
-  /**
-   * Invalidate the cached gradient (e.g. after in-place position projection).
-   *
-   * After RATTLE projection modifies x, the cached gradient is for the
-   * pre-projection position and must be recomputed.
-   */
-  void invalidate() { has_cache = false; }
-
-private:
-  void ensure_cached(const arma::vec& theta) {
-    if (has_cache &&
-        theta.n_elem == cached_theta.n_elem &&
-        std::memcmp(theta.memptr(), cached_theta.memptr(),
-                    theta.n_elem * sizeof(double)) == 0) {
-      return;
-    }
-    auto [lp, gr] = joint_fn(theta);
-    cached_theta = theta;
-    cached_logp_val = lp;
-    cached_grad_val = std::move(gr);
-    has_cache = true;
-  }
+struct LeapfrogState {
+  arma::vec theta;     ///< Position
+  arma::vec r;         ///< Momentum
+  double logp = 0.0;   ///< Log-posterior at theta
+  arma::vec grad;      ///< Gradient of the log-posterior at theta
 };
 
+/**
+ * Evaluates the log-posterior and gradient at z.theta into z.
+ *
+ * @param z      State whose theta is set; receives logp and grad
+ * @param joint  Joint log_post+gradient callable
+ */
+template <typename Joint>
+inline void evaluate_state(LeapfrogState& z, const Joint& joint) {
+  auto [lp, gr] = joint(z.theta);
+  z.logp = lp;
+  z.grad = std::move(gr);
+}
+
 // ---------------------------------------------------------------------------
-// Leapfrog integrator — two variants (memoized for NUTS, joint for HMC)
+// Leapfrog integrator — state-passing variants for NUTS, joint for HMC
 // ---------------------------------------------------------------------------
 
 /**
- * Performs a single leapfrog step with memoized gradient evaluation.
+ * Performs a single leapfrog step from a state with known gradient.
  * Used by NUTS tree-building.
  *
- * @param theta          Current position (parameter vector)
- * @param r              Current momentum vector
+ * Evaluates `joint` once, at the new position. The buffers of `out` are
+ * reused, so repeated steps allocate nothing beyond what `joint` returns.
+ * `out` must not alias `z`.
+ *
+ * @param z              Current state (logp and grad at z.theta)
  * @param eps            Step size for integration
- * @param memo           Memoizer caching gradient evaluations
+ * @param joint          Joint log_post+gradient callable
  * @param inv_mass_diag  Diagonal of the inverse mass matrix
- * @return Pair of (updated position, updated momentum)
+ * @param out            Receives the updated state with its logp and grad
  */
-std::pair<arma::vec, arma::vec> leapfrog_memo(
-    const arma::vec& theta,
-    const arma::vec& r,
+template <typename Joint>
+inline void leapfrog_state(
+    const LeapfrogState& z,
     double eps,
-    Memoizer& memo,
-    const arma::vec& inv_mass_diag
-);
+    const Joint& joint,
+    const arma::vec& inv_mass_diag,
+    LeapfrogState& out
+) {
+  BGMS_PROFILE_SCOPE(Leapfrog);
+  out.r = z.r;
+  out.theta = z.theta;
+
+  out.r += 0.5 * eps * z.grad;
+  out.theta += eps * (inv_mass_diag % out.r);
+
+  evaluate_state(out, joint);
+
+  out.r += 0.5 * eps * out.grad;
+}
 
 /**
  * Projection callback for SHAKE position constraint.
@@ -142,24 +116,25 @@ using ProjectFn = std::function<void(arma::vec& x, arma::vec& r)>;
  *
  * Position and momentum projections are separate, eliminating the
  * wasted PCG solve in the old bundled-projection implementation.
+ * `joint` is evaluated once, at the projected position. `out` must not
+ * alias `z`.
  *
- * @param theta            Current position (parameter vector)
- * @param r                Current momentum vector
+ * @param z                Current state (logp and grad at z.theta)
  * @param eps              Step size for integration
- * @param memo             Memoizer caching gradient evaluations
+ * @param joint            Joint log_post+gradient function
  * @param inv_mass_diag    Diagonal of the inverse mass matrix
  * @param project_position SHAKE position projection callback
  * @param project_momentum RATTLE momentum projection callback
- * @return Pair of (updated position, updated momentum)
+ * @param out              Receives the updated state with its logp and grad
  */
-std::pair<arma::vec, arma::vec> leapfrog_constrained(
-    const arma::vec& theta,
-    const arma::vec& r,
+void leapfrog_constrained(
+    const LeapfrogState& z,
     double eps,
-    Memoizer& memo,
+    const JointFn& joint,
     const arma::vec& inv_mass_diag,
     const ProjectPositionFn& project_position,
-    const ProjectMomentumFn& project_momentum
+    const ProjectMomentumFn& project_momentum,
+    LeapfrogState& out
 );
 
 
@@ -167,48 +142,42 @@ std::pair<arma::vec, arma::vec> leapfrog_constrained(
 // Constrained leapfrog with runtime reversibility check
 // ---------------------------------------------------------------------------
 
-/**
- * Result of a constrained leapfrog step with reversibility information.
- */
-struct ConstrainedLeapfrogResult {
-  arma::vec theta;    ///< Updated position
-  arma::vec r;        ///< Updated momentum
-  bool reversible;    ///< Whether the forward-backward check passed
-};
-
-
 /**
  * Constrained leapfrog step with a runtime reversibility check.
  *
  * Performs a forward constrained leapfrog step, then a backward step
  * (negate momentum, step forward, negate again).  If the round-trip
  * position differs from the original by more than factor * eps^2
- * in max-norm, the step is flagged as non-reversible.
+ * in max-norm, the step is flagged as non-reversible. The backward step
+ * starts from the forward state's gradient, so the check costs one
+ * gradient evaluation.
  *
  * This is the runtime analogue of Mici's ConstrainedLeapfrogIntegrator
  * reverse check (Zappa et al., 2018; Lelièvre et al., 2019), adapted
  * to use eps^2-scaled tolerance matching the O(eps^2) column-coupling
  * error of the direct SHAKE solver.
  *
- * @param theta                Current position (parameter vector)
- * @param r                    Current momentum vector
+ * @param z                    Current state (logp and grad at z.theta)
  * @param eps                  Step size for integration
- * @param memo                 Memoizer caching gradient evaluations
+ * @param joint                Joint log_post+gradient function
  * @param inv_mass_diag        Diagonal of the inverse mass matrix
  * @param project_position     SHAKE position projection callback
  * @param project_momentum     RATTLE momentum projection callback
- * @param reverse_check_tol Factor for eps^2-scaled tolerance
- * @return ConstrainedLeapfrogResult with position, momentum, and reversibility flag
+ * @param reverse_check_tol    Factor for eps^2-scaled tolerance
+ * @param out                  Receives the forward state
+ * @param scratch              Buffer for the backward state
+ * @return Whether the forward-backward check passed
  */
-ConstrainedLeapfrogResult leapfrog_constrained_checked(
-    const arma::vec& theta,
-    const arma::vec& r,
+bool leapfrog_constrained_checked(
+    const LeapfrogState& z,
     double eps,
-    Memoizer& memo,
+    const JointFn& joint,
     const arma::vec& inv_mass_diag,
     const ProjectPositionFn& project_position,
     const ProjectMomentumFn& project_momentum,
-    double reverse_check_tol
+    double reverse_check_tol,
+    LeapfrogState& out,
+    LeapfrogState& scratch
 );
 
 
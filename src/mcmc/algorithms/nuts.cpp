@@ -8,6 +8,7 @@
 #include "math/log_sum_exp.h"
 #include "mcmc/algorithms/leapfrog.h"
 #include "mcmc/algorithms/nuts.h"
+#include "mcmc/algorithms/nuts_trajectory.h"
 #include "mcmc/algorithms/hmc.h"
 #include "rng/rng_utils.h"
 
@@ -26,12 +27,6 @@
 //     https://github.com/stan-dev/stan/blob/develop/src/stan/mcmc/hmc/nuts/base_nuts.hpp
 
 
-// Computes the generalized U-turn criterion for the NUTS algorithm
-//
-// @param p_sharp_minus  Sharp momentum (M^{-1} p) at backward end
-// @param p_sharp_plus   Sharp momentum (M^{-1} p) at forward end
-// @param rho            Sum of momenta along the trajectory
-// @return true if criterion satisfied (continue), false if U-turn detected (stop)
 bool compute_criterion(const arma::vec& p_sharp_minus,
                        const arma::vec& p_sharp_plus,
                        const arma::vec& rho) {
@@ -40,276 +35,263 @@ bool compute_criterion(const arma::vec& p_sharp_minus,
 
 
 
+void NUTSArena::fit(arma::vec& v, arma::uword dim) {
+  if (v.n_elem != dim) {
+    v.set_size(dim);
+    ++last_allocations_;
+  }
+}
+
+
+void NUTSArena::fit(LeapfrogState& z, arma::uword dim) {
+  fit(z.theta, dim);
+  fit(z.r, dim);
+  fit(z.grad, dim);
+}
+
+
+void NUTSArena::prepare(arma::uword dim, int max_depth) {
+  last_allocations_ = 0;
+  const std::size_t num_slots = static_cast<std::size_t>(std::max(max_depth, 0)) + 1;
+  if (slots.size() < num_slots) {
+    slots.resize(num_slots);
+  }
+  if (pending.size() < num_slots) {
+    pending.resize(num_slots, nullptr);
+  }
+  for (BuildTreeResult& slot : slots) {
+    fit(slot.z_min, dim);
+    fit(slot.z_plus, dim);
+    fit(slot.z_prime, dim);
+    fit(slot.rho, dim);
+    fit(slot.p_sharp_beg, dim);
+    fit(slot.p_sharp_end, dim);
+    fit(slot.p_beg, dim);
+    fit(slot.p_end, dim);
+  }
+  for (LeapfrogState* state : {&z0, &z, &z_min, &z_plus, &check_scratch}) {
+    fit(*state, dim);
+  }
+  for (arma::vec* v : {&p_sharp_bck_bck, &p_sharp_fwd_fwd, &p_sharp_fwd_bck,
+                       &p_sharp_bck_fwd, &p_bck_bck, &p_fwd_fwd, &p_fwd_bck,
+                       &p_bck_fwd, &rho, &rho_fwd, &rho_bck, &rho_extended}) {
+    fit(*v, dim);
+  }
+}
+
+
+
+void merge_subtrees(
+    BuildTreeResult& out,
+    const BuildTreeResult& final_result,
+    int v,
+    SafeRNG& rng,
+    arma::vec& rho_extended
+) {
+  if (v == -1) {
+    out.z_min = final_result.z_min;
+  } else {
+    out.z_plus = final_result.z_plus;
+  }
+
+  // Accumulate Metropolis contributions regardless of subtree validity: every
+  // leapfrog step happened and contributes to the trajectory-level diagnostic.
+  out.alpha += final_result.alpha;
+  out.n_leapfrog += final_result.n_leapfrog;
+  out.divergent = out.divergent || final_result.divergent;
+  out.non_reversible = out.non_reversible || final_result.non_reversible;
+
+  const double log_sum_weight_init = out.log_sum_weight;
+
+  if (final_result.s_prime == 0) {
+    // Second subtree invalid — return early with s_prime=0. The returned
+    // log_sum_weight sums both halves' contributions; the outer level will
+    // use this value in its own biased-progression step. The existing
+    // z_prime (from the init subtree) is preserved because no valid
+    // candidate from the final subtree can be combined here (it would be
+    // dominated by the -inf weight anyway).
+    out.rho += final_result.rho;
+    out.p_sharp_end = final_result.p_sharp_end;
+    out.p_end = final_result.p_end;
+    out.log_sum_weight =
+      log_sum_exp(log_sum_weight_init, final_result.log_sum_weight);
+    out.s_prime = 0;
+    return;
+  }
+
+  const double log_sum_weight_final = final_result.log_sum_weight;
+
+  // Symmetric multinomial sample between the two sibling subtrees.
+  // log_sum_weight_subtree = log_sum_exp(init, final) >= max(init, final),
+  // so the first branch can only fire when init = -inf (every leaf in the
+  // init subtree diverged). Stan keeps the two branches for clarity; we
+  // match that layout.
+  double log_sum_weight_subtree =
+    log_sum_exp(log_sum_weight_init, log_sum_weight_final);
+  if (log_sum_weight_final > log_sum_weight_subtree) {
+    out.z_prime = final_result.z_prime;
+  } else if (MY_LOG(runif(rng)) <
+             log_sum_weight_final - log_sum_weight_subtree) {
+    out.z_prime = final_result.z_prime;
+  }
+
+  // Generalized U-turn criterion (three checks, Betancourt section A.4).
+  // The two extended checks need the init half's rho, so they run before
+  // out.rho is turned into the subtree sum.
+  rho_extended = out.rho + final_result.p_beg;
+  bool persist_criterion =
+    compute_criterion(out.p_sharp_beg, final_result.p_sharp_beg, rho_extended);
+  rho_extended = final_result.rho + out.p_end;
+  persist_criterion = persist_criterion &&
+    compute_criterion(out.p_sharp_end, final_result.p_sharp_end, rho_extended);
+  out.rho += final_result.rho;
+  persist_criterion = persist_criterion &&
+    compute_criterion(out.p_sharp_beg, final_result.p_sharp_end, out.rho);
+
+  out.p_sharp_end = final_result.p_sharp_end;
+  out.p_end = final_result.p_end;
+  out.log_sum_weight = log_sum_weight_subtree;
+  out.s_prime = persist_criterion ? 1 : 0;
+}
+
+
+
 // Recursively builds a binary tree of leapfrog steps in the NUTS algorithm.
 //
 // Each base-case leaf contributes log-weight H0 - h to the subtree's
 // log_sum_weight. Sibling subtrees combine by symmetric multinomial
 // sampling in log-space (Stan's base_nuts.hpp).
 //
-// @param theta              Current position at the base of the tree
-// @param r                  Current momentum at the base of the tree
+// The subtree is written into `out`. Its first half is built directly in
+// `out` and its second half in arena.slots[j - 1]; `z` must not alias
+// either. Every state carries its log-posterior and gradient, so each leaf
+// costs one evaluation of `joint` (two with the reversibility check).
+//
+// @param z                  State at the base of the tree, with its
+//                           log-posterior and gradient
 // @param v                  Direction of expansion (-1 backward, +1 forward)
 // @param j                  Current tree depth
 // @param step_size          Step size used in leapfrog integration
 // @param H0                 Hamiltonian at the start of the trajectory
-// @param memo               Memoizer object for caching evaluations
+// @param joint              Joint log_post+gradient function
 // @param inv_mass_diag      Diagonal of the inverse mass matrix
 // @param rng                RNG for the log-sum-exp progressive draws
 // @param project_position   RATTLE position projection (nullptr = unconstrained)
 // @param project_momentum   RATTLE momentum projection (nullptr = unconstrained)
 // @param reverse_check      Enable runtime reversibility check (constrained only)
 // @param reverse_check_tol  Factor for eps^2-scaled reversibility tolerance
-// @return BuildTreeResult with updated endpoints, candidate sample, log weight,
-//         and diagnostics.
-BuildTreeResult build_tree(
-    const arma::vec& theta,
-    const arma::vec& r,
+// @param arena              Preallocated subtree slots and U-turn scratch
+// @param out                Receives the endpoints, candidate sample, log
+//                           weight, and diagnostics of the subtree
+void build_tree(
+    const LeapfrogState& z,
     int v,
     int j,
     double step_size,
     double H0,
-    Memoizer& memo,
+    const JointFn& joint,
     const arma::vec& inv_mass_diag,
     SafeRNG& rng,
     const ProjectPositionFn* project_position,
     const ProjectMomentumFn* project_momentum,
     bool reverse_check,
-    double reverse_check_tol
+    double reverse_check_tol,
+    NUTSArena& arena,
+    BuildTreeResult& out
 ) {
   constexpr double Delta_max = 1000.0;
   constexpr double neg_inf = -std::numeric_limits<double>::infinity();
 
   if (j == 0) {
     // ---- Base case: a single leapfrog step --------------------------------
-    arma::vec theta_new, r_new;
+    // The new state goes straight into z_prime; every other endpoint of a
+    // one-leaf tree is a copy of it.
     bool non_reversible = false;
     if (project_position && project_momentum) {
       // Always run the checked variant so we can observe reversibility even
       // when reverse_check is off. reverse_check controls whether we ACT
       // on the result (terminate the tree); observation is always on.
-      auto checked = leapfrog_constrained_checked(
-        theta, r, v * step_size, memo, inv_mass_diag,
+      non_reversible = !leapfrog_constrained_checked(
+        z, v * step_size, joint, inv_mass_diag,
         *project_position, *project_momentum,
-        reverse_check_tol
+        reverse_check_tol, out.z_prime, arena.check_scratch
       );
-      theta_new = std::move(checked.theta);
-      r_new = std::move(checked.r);
-      non_reversible = !checked.reversible;
     } else {
-      std::tie(theta_new, r_new) = leapfrog_memo(
-        theta, r, v * step_size, memo, inv_mass_diag
-      );
+      leapfrog_state(z, v * step_size, joint, inv_mass_diag, out.z_prime);
     }
 
-    // Branch 1: non-reversible early return, BEFORE logp evaluation.
-    // Skips the potentially expensive/unstable posterior eval on a state
-    // that failed the reversibility round-trip. n_leapfrog and alpha are
-    // still 1 / 0 so trajectory-level bookkeeping stays consistent.
+    const arma::vec& r_prime = out.z_prime.r;
+    out.z_min = out.z_prime;
+    out.z_plus = out.z_prime;
+    out.rho = r_prime;
+    out.p_beg = r_prime;
+    out.p_end = r_prime;
+    out.p_sharp_beg = inv_mass_diag % r_prime;
+    out.p_sharp_end = out.p_sharp_beg;
+    out.n_leapfrog = 1;
+    out.non_reversible = non_reversible;  // recorded even when not acting
+
+    // Branch 1: non-reversible early return. A state that failed the
+    // reversibility round-trip gets no weight, whatever its Hamiltonian.
+    // n_leapfrog and alpha are still 1 / 0 so trajectory-level bookkeeping
+    // stays consistent.
     if (reverse_check && non_reversible) {
-      arma::vec p_sharp = inv_mass_diag % r_new;
-      BuildTreeResult result;
-      result.theta_min = theta_new;
-      result.theta_plus = theta_new;
-      result.r_min = r_new;
-      result.r_plus = r_new;
-      result.rho = r_new;
-      result.p_beg = r_new;
-      result.p_end = r_new;
-      result.r_prime = std::move(r_new);
-      result.theta_prime = std::move(theta_new);
-      result.p_sharp_beg = p_sharp;
-      result.p_sharp_end = std::move(p_sharp);
-      result.log_sum_weight = neg_inf;
-      result.s_prime = 0;
-      result.alpha = 0.0;
-      result.n_leapfrog = 1;
-      result.divergent = false;
-      result.non_reversible = true;
-      return result;
+      out.log_sum_weight = neg_inf;
+      out.s_prime = 0;
+      out.alpha = 0.0;
+      out.divergent = false;
+      return;
     }
 
-    // Branch 2: evaluate posterior, kinetic energy, Hamiltonian.
-    double logp = memo.cached_log_post(theta_new);
-    double kin = kinetic_energy(r_new, inv_mass_diag);
+    // Branch 2: Hamiltonian from the log-posterior of the leapfrog step.
+    double logp = out.z_prime.logp;
+    double kin = kinetic_energy(r_prime, inv_mass_diag);
     double h = -logp + kin;
     // Guard NaN and inf symmetrically: either flags a broken state and will
     // trigger the divergence branch below.
     if (!std::isfinite(h)) {
       h = std::numeric_limits<double>::infinity();
     }
-    double alpha = std::min(1.0, MY_EXP(H0 - h));  // 0 when h = +inf
-
-    arma::vec p_sharp = inv_mass_diag % r_new;
-
-    BuildTreeResult result;
-    result.theta_min = theta_new;
-    result.theta_plus = theta_new;
-    result.r_min = r_new;
-    result.r_plus = r_new;
-    result.rho = r_new;
-    result.p_beg = r_new;
-    result.p_end = r_new;
-    result.r_prime = std::move(r_new);
-    result.theta_prime = std::move(theta_new);
-    result.p_sharp_beg = p_sharp;
-    result.p_sharp_end = std::move(p_sharp);
-    result.alpha = alpha;
-    result.n_leapfrog = 1;
-    result.non_reversible = non_reversible;  // recorded even when not acting
+    out.alpha = std::min(1.0, MY_EXP(H0 - h));  // 0 when h = +inf
 
     // Branch 3: divergence check. A divergent leaf contributes no weight to
     // candidate selection (log_sum_weight = -inf) but its alpha is still
     // summed into the trajectory-level Metropolis diagnostic.
     if ((h - H0) > Delta_max) {
-      result.log_sum_weight = neg_inf;
-      result.s_prime = 0;
-      result.divergent = true;
+      out.log_sum_weight = neg_inf;
+      out.s_prime = 0;
+      out.divergent = true;
     } else {
-      result.log_sum_weight = H0 - h;
-      result.s_prime = 1;
-      result.divergent = false;
+      out.log_sum_weight = H0 - h;
+      out.s_prime = 1;
+      out.divergent = false;
     }
-    return result;
+    return;
   }
 
   // ---- Recursive case: build first subtree, then second -------------------
-  BuildTreeResult init_result = build_tree(
-    theta, r, v, j - 1, step_size, H0, memo, inv_mass_diag, rng,
-    project_position, project_momentum, reverse_check, reverse_check_tol
+  build_tree(
+    z, v, j - 1, step_size, H0, joint, inv_mass_diag, rng,
+    project_position, project_momentum, reverse_check, reverse_check_tol,
+    arena, out
   );
 
-  if (init_result.s_prime == 0) {
+  if (out.s_prime == 0) {
     // First subtree is invalid; propagate as-is (log_sum_weight already set).
-    return init_result;
-  }
-
-  bool divergent = init_result.divergent;
-  bool non_reversible = init_result.non_reversible;
-
-  arma::vec theta_min = std::move(init_result.theta_min);
-  arma::vec r_min = std::move(init_result.r_min);
-  arma::vec theta_plus = std::move(init_result.theta_plus);
-  arma::vec r_plus = std::move(init_result.r_plus);
-  arma::vec theta_prime = std::move(init_result.theta_prime);
-  arma::vec r_prime = std::move(init_result.r_prime);
-  arma::vec rho_init = std::move(init_result.rho);
-  arma::vec p_sharp_init_beg = std::move(init_result.p_sharp_beg);
-  arma::vec p_sharp_init_end = std::move(init_result.p_sharp_end);
-  arma::vec p_init_beg = std::move(init_result.p_beg);
-  arma::vec p_init_end = std::move(init_result.p_end);
-  double log_sum_weight_init = init_result.log_sum_weight;
-  double alpha_prime = init_result.alpha;
-  int n_leapfrog_prime = init_result.n_leapfrog;
-
-  // Build the second subtree in the same direction.
-  BuildTreeResult final_result;
-  if (v == -1) {
-    final_result = build_tree(
-      theta_min, r_min, v, j - 1, step_size, H0, memo, inv_mass_diag, rng,
-      project_position, project_momentum, reverse_check, reverse_check_tol
-    );
-    theta_min = std::move(final_result.theta_min);
-    r_min = std::move(final_result.r_min);
-  } else {
-    final_result = build_tree(
-      theta_plus, r_plus, v, j - 1, step_size, H0, memo, inv_mass_diag, rng,
-      project_position, project_momentum, reverse_check, reverse_check_tol
-    );
-    theta_plus = std::move(final_result.theta_plus);
-    r_plus = std::move(final_result.r_plus);
-  }
-
-  // Accumulate Metropolis contributions regardless of subtree validity: every
-  // leapfrog step happened and contributes to the trajectory-level diagnostic.
-  alpha_prime += final_result.alpha;
-  n_leapfrog_prime += final_result.n_leapfrog;
-  divergent = divergent || final_result.divergent;
-  non_reversible = non_reversible || final_result.non_reversible;
-
-  if (final_result.s_prime == 0) {
-    // Second subtree invalid — return early with s_prime=0. The returned
-    // log_sum_weight sums both halves' contributions; the outer level will
-    // use this value in its own biased-progression step. The existing
-    // theta_prime (from the init subtree) is preserved because no valid
-    // candidate from the final subtree can be combined here (it would be
-    // dominated by the -inf weight anyway).
-    BuildTreeResult result;
-    result.theta_min = std::move(theta_min);
-    result.r_min = std::move(r_min);
-    result.theta_plus = std::move(theta_plus);
-    result.r_plus = std::move(r_plus);
-    result.theta_prime = std::move(theta_prime);
-    result.r_prime = std::move(r_prime);
-    rho_init += final_result.rho;
-    result.rho = std::move(rho_init);
-    result.p_sharp_beg = std::move(p_sharp_init_beg);
-    result.p_sharp_end = std::move(final_result.p_sharp_end);
-    result.p_beg = std::move(p_init_beg);
-    result.p_end = std::move(final_result.p_end);
-    result.log_sum_weight =
-      log_sum_exp(log_sum_weight_init, final_result.log_sum_weight);
-    result.s_prime = 0;
-    result.alpha = alpha_prime;
-    result.n_leapfrog = n_leapfrog_prime;
-    result.divergent = divergent;
-    result.non_reversible = non_reversible;
-    return result;
+    return;
   }
 
-  arma::vec rho_final = std::move(final_result.rho);
-  arma::vec p_sharp_final_beg = std::move(final_result.p_sharp_beg);
-  arma::vec p_sharp_final_end = std::move(final_result.p_sharp_end);
-  arma::vec p_final_beg = std::move(final_result.p_beg);
-  arma::vec p_final_end = std::move(final_result.p_end);
-  double log_sum_weight_final = final_result.log_sum_weight;
-
-  // Symmetric multinomial sample between the two sibling subtrees.
-  // log_sum_weight_subtree = log_sum_exp(init, final) >= max(init, final),
-  // so the first branch can only fire when init = -inf (every leaf in the
-  // init subtree diverged). Stan keeps the two branches for clarity; we
-  // match that layout.
-  double log_sum_weight_subtree =
-    log_sum_exp(log_sum_weight_init, log_sum_weight_final);
-  if (log_sum_weight_final > log_sum_weight_subtree) {
-    theta_prime = std::move(final_result.theta_prime);
-    r_prime = std::move(final_result.r_prime);
-  } else if (MY_LOG(runif(rng)) <
-             log_sum_weight_final - log_sum_weight_subtree) {
-    theta_prime = std::move(final_result.theta_prime);
-    r_prime = std::move(final_result.r_prime);
-  }
-
-  arma::vec rho_subtree = rho_init + rho_final;
+  // Build the second subtree in the same direction, from the end of the
+  // first one.
+  BuildTreeResult& final_result = arena.slots[j - 1];
+  const LeapfrogState& z_edge = (v == -1) ? out.z_min : out.z_plus;
+  build_tree(
+    z_edge, v, j - 1, step_size, H0, joint, inv_mass_diag, rng,
+    project_position, project_momentum, reverse_check, reverse_check_tol,
+    arena, final_result
+  );
 
-  // Generalized U-turn criterion (three checks, Betancourt section A.4).
-  bool persist_criterion =
-    compute_criterion(p_sharp_init_beg, p_sharp_final_end, rho_subtree);
-  arma::vec rho_extended = rho_init + p_final_beg;
-  persist_criterion = persist_criterion &&
-    compute_criterion(p_sharp_init_beg, p_sharp_final_beg, rho_extended);
-  rho_extended = rho_final + p_init_end;
-  persist_criterion = persist_criterion &&
-    compute_criterion(p_sharp_init_end, p_sharp_final_end, rho_extended);
-
-  BuildTreeResult result;
-  result.theta_min = std::move(theta_min);
-  result.r_min = std::move(r_min);
-  result.theta_plus = std::move(theta_plus);
-  result.r_plus = std::move(r_plus);
-  result.theta_prime = std::move(theta_prime);
-  result.r_prime = std::move(r_prime);
-  result.rho = std::move(rho_subtree);
-  result.p_sharp_beg = std::move(p_sharp_init_beg);
-  result.p_sharp_end = std::move(p_sharp_final_end);
-  result.p_beg = std::move(p_init_beg);
-  result.p_end = std::move(p_final_end);
-  result.log_sum_weight = log_sum_weight_subtree;
-  result.s_prime = persist_criterion ? 1 : 0;
-  result.alpha = alpha_prime;
-  result.n_leapfrog = n_leapfrog_prime;
-  result.divergent = divergent;
-  result.non_reversible = non_reversible;
-  return result;
+  merge_subtrees(out, final_result, v, rng, arena.rho_extended);
 }
 
 
@@ -323,146 +305,23 @@ StepResult nuts_step(
     const ProjectPositionFn* project_position,
     const ProjectMomentumFn* project_momentum,
     bool reverse_check,
-    double reverse_check_tol
+    double reverse_check_tol,
+    NUTSArena* arena,
+    bool reuse_start
 ) {
-  // Create Memoizer with joint function
-  Memoizer memo(joint);
-  bool any_divergence = false;
-  bool any_non_reversible = false;
-
-  arma::vec r0 = arma::sqrt(1.0 / inv_mass_diag) % arma_rnorm_vec(rng, init_theta.n_elem);
-
-  // Project initial momentum onto cotangent space (momentum-only)
-  if (project_momentum) {
-    (*project_momentum)(r0, init_theta);
-  }
-
-  double logp0 = memo.cached_log_post(init_theta);
-  double kin0 = kinetic_energy(r0, inv_mass_diag);
-  double H0 = -logp0 + kin0;
-
-  arma::vec theta_min = init_theta, r_min = r0;
-  arma::vec theta_plus = init_theta, r_plus = r0;
-  arma::vec theta = init_theta;
-  arma::vec r = r0;
-
-  arma::vec p_sharp_bck_bck = inv_mass_diag % r0;
-  arma::vec p_sharp_fwd_fwd = p_sharp_bck_bck;
-  arma::vec p_fwd_bck = r0;
-  arma::vec p_sharp_fwd_bck = p_sharp_bck_bck;
-  arma::vec p_bck_fwd = r0;
-  arma::vec p_sharp_bck_fwd = p_sharp_bck_bck;
-  // Regular (non-sharp) boundary momenta for the extreme ends of the
-  // trajectory. Needed for the Stan-style "save old end as new inner
-  // boundary" maintenance before each extension.
-  arma::vec p_bck_bck = r0;
-  arma::vec p_fwd_fwd = r0;
-  arma::vec rho = r0;
-
-  int j = 0;
-  int s = 1;
-  // Log-sum of state weights exp(H0 - h_i) accumulated across the trajectory.
-  // Initialized to 0 = log exp(H0 - H0) so the initial position carries unit
-  // weight; the sampler stays put if every subtree diverges.
-  double log_sum_weight_traj = 0.0;
-  // Accumulate Metropolis contributions across every leapfrog step (including
-  // inside subtrees that terminated). Matches Stan's by-reference accumulation
-  // in base_nuts.hpp.
-  double sum_metro_prob = 0.0;
-  int n_leapfrog_total = 0;
-
-  while (s == 1 && j < max_depth) {
-    int v = runif(rng) < 0.5 ? -1 : 1;
-    arma::vec rho_fwd, rho_bck;
-
-    BuildTreeResult result;
-    if (v == -1) {
-      rho_fwd = rho;
-      // Save old backward-end as the forward half's new backward boundary.
-      // Matches Stan base_nuts.hpp: p_fwd_bck = p_bck_bck before building.
-      p_fwd_bck = p_bck_bck;
-      p_sharp_fwd_bck = p_sharp_bck_bck;
-      result = build_tree(
-        theta_min, r_min, v, j, step_size, H0, memo, inv_mass_diag, rng,
-        project_position, project_momentum, reverse_check, reverse_check_tol
-      );
-      theta_min = std::move(result.theta_min);
-      r_min = std::move(result.r_min);
-      rho_bck = std::move(result.rho);
-      // For a backward subtree, p_beg = first leaf built = interior (closest
-      // to origin), p_end = last leaf built = outer-leftmost. Map accordingly.
-      p_sharp_bck_bck = std::move(result.p_sharp_end);
-      p_bck_bck = std::move(result.p_end);
-      p_sharp_bck_fwd = std::move(result.p_sharp_beg);
-      p_bck_fwd = std::move(result.p_beg);
-    } else {
-      rho_bck = rho;
-      // Save old forward-end as the backward half's new forward boundary.
-      // Matches Stan base_nuts.hpp: p_bck_fwd = p_fwd_fwd before building.
-      p_bck_fwd = p_fwd_fwd;
-      p_sharp_bck_fwd = p_sharp_fwd_fwd;
-      result = build_tree(
-        theta_plus, r_plus, v, j, step_size, H0, memo, inv_mass_diag, rng,
-        project_position, project_momentum, reverse_check, reverse_check_tol
+  NUTSArena local_arena;
+  NUTSArena& a = arena ? *arena : local_arena;
+  a.prepare(init_theta.n_elem, max_depth);
+
+  return run_nuts_trajectory(
+    init_theta, inv_mass_diag, rng, max_depth, project_momentum, joint, a,
+    reuse_start && arena,
+    [&](const LeapfrogState& z, int v, int j, double H0, BuildTreeResult& out) {
+      build_tree(
+        z, v, j, step_size, H0, joint, inv_mass_diag, rng,
+        project_position, project_momentum, reverse_check, reverse_check_tol,
+        a, out
       );
-      theta_plus = std::move(result.theta_plus);
-      r_plus = std::move(result.r_plus);
-      rho_fwd = std::move(result.rho);
-      p_sharp_fwd_fwd = std::move(result.p_sharp_end);
-      p_fwd_fwd = std::move(result.p_end);
-      p_fwd_bck = std::move(result.p_beg);
-      p_sharp_fwd_bck = std::move(result.p_sharp_beg);
-    }
-
-    // Trajectory-level bookkeeping: always accumulate (subtrees that
-    // terminated still consumed leapfrog steps).
-    any_divergence = any_divergence || result.divergent;
-    any_non_reversible = any_non_reversible || result.non_reversible;
-    sum_metro_prob += result.alpha;
-    n_leapfrog_total += result.n_leapfrog;
-
-    // Biased progressive sampling: prefer the newly built subtree when its
-    // weight exceeds the running trajectory weight (accept with probability
-    // min(1, w_subtree / w_traj) in the multinomial formulation). Only eligible
-    // when the subtree itself is valid.
-    if (result.s_prime == 1) {
-      if (result.log_sum_weight > log_sum_weight_traj ||
-          MY_LOG(runif(rng)) <
-            result.log_sum_weight - log_sum_weight_traj) {
-        theta = std::move(result.theta_prime);
-        r = std::move(result.r_prime);
-      }
-    }
-    log_sum_weight_traj =
-      log_sum_exp(log_sum_weight_traj, result.log_sum_weight);
-
-    rho = rho_bck + rho_fwd;
-    bool persist_criterion = true;
-    if (result.s_prime == 1) {
-      persist_criterion = compute_criterion(p_sharp_bck_bck, p_sharp_fwd_fwd, rho);
-      arma::vec rho_extended = rho_bck + p_fwd_bck;
-      persist_criterion = persist_criterion &&
-        compute_criterion(p_sharp_bck_bck, p_sharp_fwd_bck, rho_extended);
-      rho_extended = rho_fwd + p_bck_fwd;
-      persist_criterion = persist_criterion &&
-        compute_criterion(p_sharp_bck_fwd, p_sharp_fwd_fwd, rho_extended);
     }
-
-    s = result.s_prime * (persist_criterion ? 1 : 0);
-    j++;
-  }
-
-  double accept_prob = sum_metro_prob / static_cast<double>(n_leapfrog_total);
-  auto logp_final = memo.cached_log_post(theta);
-  double kin_final = kinetic_energy(r, inv_mass_diag);
-  double energy = -logp_final + kin_final;
-
-  auto diag = std::make_shared<NUTSDiagnostics>();
-  diag->tree_depth = j;
-  diag->divergent = any_divergence;
-  diag->non_reversible = any_non_reversible;
-  diag->energy = energy;
-  diag->accept_prob = accept_prob;
-
-  return {theta, accept_prob, diag};
+  );
 }
@@ -3,6 +3,7 @@
 #include <RcppArmadillo.h>
 #include <functional>
 #include <utility>
+#include <vector>
 #include "mcmc/execution/step_result.h"
 #include "mcmc/algorithms/leapfrog.h"
 struct SafeRNG;
@@ -15,12 +16,9 @@ struct SafeRNG;
  * candidate samples or indicate when the trajectory should terminate.
  */
 struct BuildTreeResult {
-  arma::vec theta_min;     ///< Leftmost position in the trajectory
-  arma::vec r_min;         ///< Corresponding momentum at theta_min
-  arma::vec theta_plus;    ///< Rightmost position in the trajectory
-  arma::vec r_plus;        ///< Corresponding momentum at theta_plus
-  arma::vec theta_prime;   ///< Current proposed sample (to possibly accept)
-  arma::vec r_prime;       ///< Momentum at theta_prime (for energy diagnostics)
+  LeapfrogState z_min;     ///< Leftmost state in the trajectory
+  LeapfrogState z_plus;    ///< Rightmost state in the trajectory
+  LeapfrogState z_prime;   ///< Current proposed sample (to possibly accept)
   arma::vec rho;           ///< Sum of momenta along the subtree (for U-turn criterion)
   arma::vec p_sharp_beg;   ///< Sharp momentum (M^{-1} p) at subtree beginning
   arma::vec p_sharp_end;   ///< Sharp momentum (M^{-1} p) at subtree end
@@ -36,12 +34,101 @@ struct BuildTreeResult {
 
 
 
+/**
+ * NUTSArena - Preallocated buffers for one chain's NUTS trajectories
+ *
+ * build_tree writes each subtree into a depth-indexed slot instead of
+ * returning vectors by value: a node at depth j builds its second half in
+ * slots[j - 1], so no two live subtrees ever share a slot, and the
+ * top-level subtree goes into slots[max_depth]. With the trajectory-level
+ * vectors below, tree building and leapfrog integration perform no heap
+ * allocations once the arena matches the parameter dimension.
+ *
+ * After a transition, `z` holds the accepted state with its log-posterior
+ * and gradient. A caller that starts the next transition from that state,
+ * with the target unchanged, passes reuse_start to nuts_step to skip the
+ * evaluation at the initial point.
+ *
+ * NUTSSampler owns one arena per chain.
+ */
+class NUTSArena {
+public:
+  /**
+   * Size every buffer for `dim` parameters and trees up to `max_depth`.
+   * Buffers that already have the right size are left untouched.
+   */
+  void prepare(arma::uword dim, int max_depth);
+
+  /** @return Buffer (re)allocations made by the most recent prepare(). */
+  int last_allocations() const { return last_allocations_; }
+
+  std::vector<BuildTreeResult> slots; ///< Subtree slots (max_depth + 1)
+  std::vector<BuildTreeResult*> pending; ///< Iterative engine: first half awaiting its sibling, per level
+
+  // Trajectory state of nuts_step
+  LeapfrogState z0;                   ///< Initial state
+  LeapfrogState z;                    ///< Selected sample; the accepted state after the step
+  LeapfrogState z_min, z_plus;        ///< Trajectory endpoints
+  LeapfrogState check_scratch;        ///< Backward state of the reversibility check
+  arma::vec p_sharp_bck_bck, p_sharp_fwd_fwd, p_sharp_fwd_bck, p_sharp_bck_fwd;
+  arma::vec p_bck_bck, p_fwd_fwd, p_fwd_bck, p_bck_fwd;
+  arma::vec rho, rho_fwd, rho_bck;
+  arma::vec rho_extended;             ///< U-turn scratch, used only between recursions
+
+private:
+  void fit(arma::vec& v, arma::uword dim);
+  void fit(LeapfrogState& z, arma::uword dim);
+
+  int last_allocations_ = 0;
+};
+
+
+
+/**
+ * Generalized U-turn criterion (Betancourt 2017)
+ *
+ * @param p_sharp_minus  Sharp momentum (M^{-1} p) at backward end
+ * @param p_sharp_plus   Sharp momentum (M^{-1} p) at forward end
+ * @param rho            Sum of momenta along the trajectory
+ * @return true if criterion satisfied (continue), false if U-turn detected (stop)
+ */
+bool compute_criterion(const arma::vec& p_sharp_minus,
+                       const arma::vec& p_sharp_plus,
+                       const arma::vec& rho);
+
+
+
+/**
+ * Joins a completed first half with its sibling subtree
+ *
+ * `out` holds the first half and receives the joined subtree: outer
+ * endpoint in direction v, summed Metropolis statistics, multinomial choice
+ * of the candidate, and the three U-turn checks. Consumes at most one
+ * uniform draw. Shared by the recursive and iterative tree builders so both
+ * combine subtrees with the same arithmetic and random draws.
+ *
+ * @param out           First half on entry, joined subtree on return
+ * @param final_result  Second half, built from the outer end of `out`
+ * @param v             Direction of expansion (-1 backward, +1 forward)
+ * @param rng           Thread-safe random number generator
+ * @param rho_extended  Scratch vector for the extended U-turn checks
+ */
+void merge_subtrees(
+    BuildTreeResult& out,
+    const BuildTreeResult& final_result,
+    int v,
+    SafeRNG& rng,
+    arma::vec& rho_extended
+);
+
+
+
 /**
  * Executes the No-U-Turn Sampler algorithm (NUTS)
  *
- * Takes a joint log_post+gradient function for efficient memoization.
- * The joint function computes both values together, which is more efficient
- * when they share common computations (e.g., normalization constants).
+ * Takes a joint log_post+gradient function, which computes both values
+ * together since they share most of the work (e.g., normalization
+ * constants). Each leapfrog step evaluates it once, at its new position.
  *
  * For constrained models, pass non-null project_position and
  * project_momentum callbacks to use RATTLE integration.
@@ -56,6 +143,11 @@ struct BuildTreeResult {
  * @param project_momentum  RATTLE momentum projection (nullptr for unconstrained)
  * @param reverse_check     Enable runtime reversibility check (constrained only)
  * @param reverse_check_tol Factor for eps²-scaled reversibility tolerance
+ * @param arena             Per-chain trajectory buffers (nullptr = use a local arena)
+ * @param reuse_start       Start from arena->z, the accepted state of the
+ *                          previous step, and its stored log-posterior and
+ *                          gradient; init_theta is then ignored. Only valid
+ *                          when the target has not changed since that step.
  * @return StepResult with position, acceptance probability, and NUTS diagnostics
  */
 StepResult nuts_step(
@@ -68,5 +160,7 @@ StepResult nuts_step(
     const ProjectPositionFn* project_position = nullptr,
     const ProjectMomentumFn* project_momentum = nullptr,
     bool reverse_check = true,
-    double reverse_check_tol = 0.5
+    double reverse_check_tol = 0.5,
+    NUTSArena* arena = nullptr,
+    bool reuse_start = false
 );
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <RcppArmadillo.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include "math/explog_macros.h"
+#include "mcmc/algorithms/hmc.h"
+#include "mcmc/algorithms/leapfrog.h"
+#include "mcmc/algorithms/nuts.h"
+#include "mcmc/algorithms/nuts_trajectory.h"
+#include "rng/rng_utils.h"
+
+
+// Iterative NUTS engine ("nuts-iterative").
+//
+// Builds each subtree leaf by leaf instead of recursing. Pending first halves
+// wait in NUTSArena::pending, one per level. When a new leaf completes a
+// subtree, it is joined with its pending sibling by the same merge_subtrees
+// as the recursive builder. Subtrees live in the same arena slots as the
+// recursive build_tree's.
+//
+// The engine is templated on the joint log_post+gradient callable, so the
+// model evaluation can be inlined into the leapfrog. No std::function is
+// involved. Leaves, merges and random draws happen in the same order, with
+// the same arithmetic, as in nuts_step. Draws for a given seed are therefore
+// bit-identical to the recursive engine.
+//
+// Only the unconstrained integrator is provided. Constrained (RATTLE) models
+// keep using nuts_step.
+
+
+/**
+ * One unconstrained leaf of the iterative engine
+ *
+ * Takes a leapfrog step from z and writes the one-leaf subtree into `out`,
+ * exactly as the unconstrained base case of build_tree does.
+ */
+template <typename Joint>
+void build_leaf_iterative(
+    const LeapfrogState& z,
+    int v,
+    double step_size,
+    double H0,
+    const Joint& joint,
+    const arma::vec& inv_mass_diag,
+    BuildTreeResult& out
+) {
+  constexpr double Delta_max = 1000.0;
+  constexpr double neg_inf = -std::numeric_limits<double>::infinity();
+
+  leapfrog_state(z, v * step_size, joint, inv_mass_diag, out.z_prime);
+
+  const arma::vec& r_prime = out.z_prime.r;
+  out.z_min = out.z_prime;
+  out.z_plus = out.z_prime;
+  out.rho = r_prime;
+  out.p_beg = r_prime;
+  out.p_end = r_prime;
+  out.p_sharp_beg = inv_mass_diag % r_prime;
+  out.p_sharp_end = out.p_sharp_beg;
+  out.n_leapfrog = 1;
+  out.non_reversible = false;
+
+  double logp = out.z_prime.logp;
+  double kin = kinetic_energy(r_prime, inv_mass_diag);
+  double h = -logp + kin;
+  if (!std::isfinite(h)) {
+    h = std::numeric_limits<double>::infinity();
+  }
+  out.alpha = std::min(1.0, MY_EXP(H0 - h));
+
+  if ((h - H0) > Delta_max) {
+    out.log_sum_weight = neg_inf;
+    out.s_prime = 0;
+    out.divergent = true;
+  } else {
+    out.log_sum_weight = H0 - h;
+    out.s_prime = 1;
+    out.divergent = false;
+  }
+}
+
+
+
+/**
+ * Builds a depth-j subtree without recursion
+ *
+ * Leaves are built in trajectory order. After each leaf, the subtrees it
+ * completes are closed bottom-up. A completed second half is merged into
+ * its pending first half. A completed first half is parked in
+ * arena.pending at its level, and the next leaf starts its sibling. An
+ * invalid first half ends its parent without a sibling, as in build_tree.
+ *
+ * The next leaf goes into arena.slots[level]. That is the slot build_tree
+ * uses for the second half of a node at depth level + 1.
+ *
+ * @param z              State at the base of the subtree
+ * @param v              Direction of expansion (-1 backward, +1 forward)
+ * @param j              Subtree depth
+ * @param step_size      Leapfrog step size
+ * @param H0             Hamiltonian at the start of the trajectory
+ * @param joint          Joint log_post+gradient callable
+ * @param inv_mass_diag  Diagonal of the inverse mass matrix
+ * @param rng            Thread-safe random number generator
+ * @param arena          Preallocated subtree slots and pending stack
+ * @param out            Receives the subtree; must not alias z
+ */
+template <typename Joint>
+void build_tree_iterative(
+    const LeapfrogState& z,
+    int v,
+    int j,
+    double step_size,
+    double H0,
+    const Joint& joint,
+    const arma::vec& inv_mass_diag,
+    SafeRNG& rng,
+    NUTSArena& arena,
+    BuildTreeResult& out
+) {
+  std::fill(arena.pending.begin(), arena.pending.begin() + j, nullptr);
+
+  BuildTreeResult* current = &out;
+  const LeapfrogState* z_edge = &z;
+
+  while (true) {
+    build_leaf_iterative(*z_edge, v, step_size, H0, joint, inv_mass_diag,
+                         *current);
+
+    int level = 0;
+    for (; level < j; ++level) {
+      BuildTreeResult* first = arena.pending[level];
+      if (first) {
+        arena.pending[level] = nullptr;
+        merge_subtrees(*first, *current, v, rng, arena.rho_extended);
+        current = first;
+      } else if (current->s_prime == 1) {
+        break;
+      }
+    }
+
+    // Every level closed: current is back at `out`.
+    if (level == j) return;
+
+    arena.pending[level] = current;
+    z_edge = (v == -1) ? &current->z_min : &current->z_plus;
+    current = &arena.slots[level];
+  }
+}
+
+
+
+/**
+ * Executes NUTS with the iterative tree builder
+ *
+ * Drop-in replacement for the unconstrained nuts_step. It takes `joint` by
+ * its own type instead of std::function, and draws are bit-identical to
+ * nuts_step for the same generator state.
+ *
+ * @param init_theta     Initial position (parameter vector)
+ * @param step_size      Step size for leapfrog integration
+ * @param joint          Callable returning (log_post, gradient) pair
+ * @param inv_mass_diag  Diagonal of the inverse mass matrix
+ * @param rng            Thread-safe random number generator
+ * @param max_depth      Maximum tree depth (default = 10)
+ * @param arena          Per-chain trajectory buffers (nullptr = use a local arena)
+ * @param reuse_start    Start from arena->z and its stored evaluation, as
+ *                       in nuts_step
+ * @return StepResult with position, acceptance probability, and NUTS diagnostics
+ */
+template <typename Joint>
+StepResult nuts_step_iterative(
+    const arma::vec& init_theta,
+    double step_size,
+    const Joint& joint,
+    const arma::vec& inv_mass_diag,
+    SafeRNG& rng,
+    int max_depth = 10,
+    NUTSArena* arena = nullptr,
+    bool reuse_start = false
+) {
+  NUTSArena local_arena;
+  NUTSArena& a = arena ? *arena : local_arena;
+  a.prepare(init_theta.n_elem, max_depth);
+
+  return run_nuts_trajectory(
+    init_theta, inv_mass_diag, rng, max_depth, nullptr, joint, a,
+    reuse_start && arena,
+    [&](const LeapfrogState& z, int v, int j, double H0, BuildTreeResult& out) {
+      build_tree_iterative(
+        z, v, j, step_size, H0, joint, inv_mass_diag, rng, a, out
+      );
+    }
+  );
+}
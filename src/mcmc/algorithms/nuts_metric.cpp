@@ -0,0 +1,133 @@
+#include <RcppArmadillo.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "mcmc/algorithms/nuts_metric.h"
+
+
+MetricKind metric_kind_from_string(const std::string& metric) {
+  if (metric == "diag") return MetricKind::Diagonal;
+  if (metric == "dense") return MetricKind::Dense;
+  if (metric == "low-rank") return MetricKind::LowRank;
+  throw std::invalid_argument("Invalid NUTS metric: " + metric);
+}
+
+
+arma::uword LinearMetric::dim() const {
+  switch (kind_) {
+    case MetricKind::Dense:   return chol_.n_rows;
+    case MetricKind::LowRank: return diag_.n_elem;
+    default:                  return 0;
+  }
+}
+
+
+void LinearMetric::set_dense(const arma::mat& inv_mass) {
+  arma::mat chol;
+  if (!arma::chol(chol, inv_mass, "lower")) {
+    // Not positive definite (should not happen for a regularized
+    // covariance); keep the identity so the caller stays on the diagonal.
+    *this = LinearMetric();
+    return;
+  }
+  *this = LinearMetric();
+  kind_ = MetricKind::Dense;
+  inv_mass_ = inv_mass;
+  chol_ = std::move(chol);
+}
+
+
+void LinearMetric::set_low_rank(const arma::vec& inv_mass_diag, const arma::mat& factor) {
+  *this = LinearMetric();
+  kind_ = MetricKind::LowRank;
+  diag_ = inv_mass_diag;
+  factor_ = factor;
+  sqrt_diag_ = arma::sqrt(inv_mass_diag);
+
+  if (factor.n_cols == 0) return;  // plain diagonal, stored in the same form
+  arma::mat v = factor.each_col() / sqrt_diag_;
+  arma::mat w;
+  arma::vec s;
+  if (!arma::svd_econ(basis_, s, w, v, "left")) {
+    basis_.reset();
+    return;
+  }
+  arma::vec root = arma::sqrt(1.0 + arma::square(s));
+  stretch_ = root - 1.0;
+  shrink_ = 1.0 / root - 1.0;
+}
+
+
+arma::vec LinearMetric::to_position(const arma::vec& y) const {
+  if (kind_ == MetricKind::Dense) {
+    return chol_ * y;
+  }
+  arma::vec b = y;
+  if (basis_.n_cols > 0) {
+    b += basis_ * (stretch_ % (basis_.t() * y));
+  }
+  return sqrt_diag_ % b;
+}
+
+
+arma::vec LinearMetric::to_latent(const arma::vec& theta) const {
+  if (kind_ == MetricKind::Dense) {
+    return arma::solve(arma::trimatl(chol_), theta);
+  }
+  arma::vec z = theta / sqrt_diag_;
+  if (basis_.n_cols > 0) {
+    z += basis_ * (shrink_ % (basis_.t() * z));
+  }
+  return z;
+}
+
+
+arma::vec LinearMetric::pull_back(const arma::vec& grad) const {
+  if (kind_ == MetricKind::Dense) {
+    return chol_.t() * grad;
+  }
+  arma::vec z = sqrt_diag_ % grad;
+  if (basis_.n_cols > 0) {
+    z += basis_ * (stretch_ % (basis_.t() * z));
+  }
+  return z;
+}
+
+
+LinearMetric LinearMetric::restrict(const arma::uvec& indices) const {
+  LinearMetric out;
+  if (kind_ == MetricKind::Dense) {
+    out.set_dense(inv_mass_.submat(indices, indices));
+  } else if (kind_ == MetricKind::LowRank) {
+    out.set_low_rank(diag_.elem(indices), factor_.rows(indices));
+  }
+  return out;
+}
+
+
+arma::mat low_rank_covariance_factor(const arma::mat& cov, int rank) {
+  const arma::vec sd = arma::sqrt(cov.diag());
+  const arma::mat corr = cov / (sd * sd.t());
+
+  arma::vec eigval;
+  arma::mat eigvec;
+  if (rank <= 0 || !arma::eig_sym(eigval, eigvec, corr)) {
+    return arma::mat(cov.n_rows, 0);
+  }
+
+  // eig_sym sorts ascending; take the largest eigenvalues above one
+  // (with a margin, so rounding on uncorrelated parameters adds nothing).
+  constexpr double min_excess = 1e-8;
+  int k = 0;
+  while (k < rank && k < static_cast<int>(eigval.n_elem) &&
+         eigval(eigval.n_elem - 1 - k) > 1.0 + min_excess) {
+    ++k;
+  }
+
+  arma::mat factor(cov.n_rows, k);
+  for (int i = 0; i < k; ++i) {
+    const arma::uword col = eigval.n_elem - 1 - i;
+    factor.col(i) = sd % eigvec.col(col) * std::sqrt(eigval(col) - 1.0);
+  }
+  return factor;
+}
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <RcppArmadillo.h>
+#include <memory>
+#include "math/log_sum_exp.h"
+#include "mcmc/algorithms/hmc.h"
+#include "mcmc/algorithms/leapfrog.h"
+#include "mcmc/algorithms/nuts.h"
+#include "mcmc/execution/step_result.h"
+#include "rng/rng_utils.h"
+
+
+/**
+ * Top level of a NUTS transition, shared by the tree-building engines
+ *
+ * Draws the momentum, then doubles the trajectory in random directions until
+ * a U-turn, an invalid subtree or max_depth stops it, with biased progressive
+ * sampling between the old trajectory and each new subtree. The engines
+ * differ only in how a subtree is built, which `build_subtree` supplies:
+ *
+ *   build_subtree(z, v, j, H0, out)
+ *
+ * builds a depth-j subtree from the LeapfrogState z in direction v into
+ * `out` (always a.slots[max_depth]). Every random draw outside the subtrees
+ * is made here, so engines whose subtrees consume the generator identically
+ * produce identical draws.
+ *
+ * The initial point is evaluated once, unless `reuse_start` is set: the
+ * transition then starts from a.z, the accepted state of the previous
+ * transition, with its stored log-posterior and gradient. The accepted
+ * state is left in a.z.
+ *
+ * @param init_theta        Initial position (ignored with reuse_start)
+ * @param inv_mass_diag     Diagonal of the inverse mass matrix
+ * @param rng               Thread-safe random number generator
+ * @param max_depth         Maximum tree depth
+ * @param project_momentum  RATTLE momentum projection (nullptr = unconstrained)
+ * @param joint             Joint log_post+gradient callable
+ * @param a                 Arena prepared for init_theta.n_elem and max_depth
+ * @param reuse_start       Start from a.z and its stored evaluation
+ * @param build_subtree     Subtree builder (see above)
+ * @return StepResult with position, acceptance probability, and NUTS diagnostics
+ */
+template <typename Joint, typename BuildSubtree>
+StepResult run_nuts_trajectory(
+    const arma::vec& init_theta,
+    const arma::vec& inv_mass_diag,
+    SafeRNG& rng,
+    int max_depth,
+    const ProjectMomentumFn* project_momentum,
+    const Joint& joint,
+    NUTSArena& a,
+    bool reuse_start,
+    BuildSubtree&& build_subtree
+) {
+  bool any_divergence = false;
+  bool any_non_reversible = false;
+
+  LeapfrogState& z0 = a.z0;
+  if (reuse_start) {
+    z0.theta = a.z.theta;
+    z0.logp = a.z.logp;
+    z0.grad = a.z.grad;
+  } else {
+    z0.theta = init_theta;
+  }
+
+  for (arma::uword i = 0; i < z0.r.n_elem; ++i) {
+    z0.r[i] = rnorm(rng, 0.0, 1.0);
+  }
+  z0.r %= arma::sqrt(1.0 / inv_mass_diag);
+
+  // Project initial momentum onto cotangent space (momentum-only)
+  if (project_momentum) {
+    (*project_momentum)(z0.r, z0.theta);
+  }
+
+  if (!reuse_start) {
+    evaluate_state(z0, joint);
+  }
+  double kin0 = kinetic_energy(z0.r, inv_mass_diag);
+  double H0 = -z0.logp + kin0;
+
+  a.z_min = z0;
+  a.z_plus = z0;
+  a.z = z0;
+
+  const arma::vec& r0 = z0.r;
+  a.p_sharp_bck_bck = inv_mass_diag % r0;
+  a.p_sharp_fwd_fwd = a.p_sharp_bck_bck;
+  a.p_fwd_bck = r0;
+  a.p_sharp_fwd_bck = a.p_sharp_bck_bck;
+  a.p_bck_fwd = r0;
+  a.p_sharp_bck_fwd = a.p_sharp_bck_bck;
+  // Regular (non-sharp) boundary momenta for the extreme ends of the
+  // trajectory. Needed for the Stan-style "save old end as new inner
+  // boundary" maintenance before each extension.
+  a.p_bck_bck = r0;
+  a.p_fwd_fwd = r0;
+  a.rho = r0;
+
+  int j = 0;
+  int s = 1;
+  // Log-sum of state weights exp(H0 - h_i) accumulated across the trajectory.
+  // Initialized to 0 = log exp(H0 - H0) so the initial position carries unit
+  // weight; the sampler stays put if every subtree diverges.
+  double log_sum_weight_traj = 0.0;
+  // Accumulate Metropolis contributions across every leapfrog step (including
+  // inside subtrees that terminated). Matches Stan's by-reference accumulation
+  // in base_nuts.hpp.
+  double sum_metro_prob = 0.0;
+  int n_leapfrog_total = 0;
+
+  BuildTreeResult& result = a.slots[max_depth];
+
+  while (s == 1 && j < max_depth) {
+    int v = runif(rng) < 0.5 ? -1 : 1;
+
+    if (v == -1) {
+      a.rho_fwd = a.rho;
+      // Save old backward-end as the forward half's new backward boundary.
+      // Matches Stan base_nuts.hpp: p_fwd_bck = p_bck_bck before building.
+      a.p_fwd_bck = a.p_bck_bck;
+      a.p_sharp_fwd_bck = a.p_sharp_bck_bck;
+      build_subtree(a.z_min, v, j, H0, result);
+      a.z_min = result.z_min;
+      a.rho_bck = result.rho;
+      // For a backward subtree, p_beg = first leaf built = interior (closest
+      // to origin), p_end = last leaf built = outer-leftmost. Map accordingly.
+      a.p_sharp_bck_bck = result.p_sharp_end;
+      a.p_bck_bck = result.p_end;
+      a.p_sharp_bck_fwd = result.p_sharp_beg;
+      a.p_bck_fwd = result.p_beg;
+    } else {
+      a.rho_bck = a.rho;
+      // Save old forward-end as the backward half's new forward boundary.
+      // Matches Stan base_nuts.hpp: p_bck_fwd = p_fwd_fwd before building.
+      a.p_bck_fwd = a.p_fwd_fwd;
+      a.p_sharp_bck_fwd = a.p_sharp_fwd_fwd;
+      build_subtree(a.z_plus, v, j, H0, result);
+      a.z_plus = result.z_plus;
+      a.rho_fwd = result.rho;
+      a.p_sharp_fwd_fwd = result.p_sharp_end;
+      a.p_fwd_fwd = result.p_end;
+      a.p_fwd_bck = result.p_beg;
+      a.p_sharp_fwd_bck = result.p_sharp_beg;
+    }
+
+    // Trajectory-level bookkeeping: always accumulate (subtrees that
+    // terminated still consumed leapfrog steps).
+    any_divergence = any_divergence || result.divergent;
+    any_non_reversible = any_non_reversible || result.non_reversible;
+    sum_metro_prob += result.alpha;
+    n_leapfrog_total += result.n_leapfrog;
+
+    // Biased progressive sampling: prefer the newly built subtree when its
+    // weight exceeds the running trajectory weight (accept with probability
+    // min(1, w_subtree / w_traj) in the multinomial formulation). Only eligible
+    // when the subtree itself is valid.
+    if (result.s_prime == 1) {
+      if (result.log_sum_weight > log_sum_weight_traj ||
+          MY_LOG(runif(rng)) <
+            result.log_sum_weight - log_sum_weight_traj) {
+        a.z = result.z_prime;
+      }
+    }
+    log_sum_weight_traj =
+      log_sum_exp(log_sum_weight_traj, result.log_sum_weight);
+
+    a.rho = a.rho_bck + a.rho_fwd;
+    bool persist_criterion = true;
+    if (result.s_prime == 1) {
+      persist_criterion = compute_criterion(a.p_sharp_bck_bck, a.p_sharp_fwd_fwd, a.rho);
+      a.rho_extended = a.rho_bck + a.p_fwd_bck;
+      persist_criterion = persist_criterion &&
+        compute_criterion(a.p_sharp_bck_bck, a.p_sharp_fwd_bck, a.rho_extended);
+      a.rho_extended = a.rho_fwd + a.p_bck_fwd;
+      persist_criterion = persist_criterion &&
+        compute_criterion(a.p_sharp_bck_fwd, a.p_sharp_fwd_fwd, a.rho_extended);
+    }
+
+    s = result.s_prime * (persist_criterion ? 1 : 0);
+    j++;
+  }
+
+  double accept_prob = sum_metro_prob / static_cast<double>(n_leapfrog_total);
+  double kin_final = kinetic_energy(a.z.r, inv_mass_diag);
+  double energy = -a.z.logp + kin_final;
+
+  auto diag = std::make_shared<NUTSDiagnostics>();
+  diag->tree_depth = j;
+  diag->divergent = any_divergence;
+  diag->non_reversible = any_non_reversible;
+  diag->energy = energy;
+  diag->accept_prob = accept_prob;
+  diag->arena_allocations = a.last_allocations();
+  diag->n_leapfrog = n_leapfrog_total;
+
+  return {a.z.theta, accept_prob, diag};
+}
@@ -0,0 +1,237 @@
+#pragma once
+
+/**
+ * @file chain_profile.h
+ * @brief Per-chain wall-time and call counters for the sampler hot paths.
+ *
+ * Each chain owns a ChainProfile. run_mcmc_chain() binds it to the running
+ * thread with an ActiveProfile guard, and the hot paths open a
+ * BGMS_PROFILE_SCOPE(phase) that adds one call and its wall time to the
+ * bound profile. Code that runs outside a chain (the R-facing test
+ * interfaces, simulation) finds no bound profile and records nothing.
+ *
+ * Times are inclusive: a leapfrog step contains its gradient evaluations,
+ * and the sampler step contains both. When within-chain gradient threads
+ * let a waiting chain thread pick up another chain's task, the waiting
+ * scope also absorbs that time; the guard keeps the counts per chain.
+ *
+ * The counters are on by default. Build with `-DBGMS_PROFILE=0` to compile
+ * every scope away:
+ * @code
+ * Sys.setenv("PKG_CPPFLAGS" = "-DBGMS_PROFILE=0")
+ * @endcode
+ */
+
+#if !defined(BGMS_PROFILE) || BGMS_PROFILE != 0
+#define BGMS_USE_PROFILE 1
+#else
+#define BGMS_USE_PROFILE 0
+#endif
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <RcppArmadillo.h>
+
+
+/// Hot-path phases with their own counters.
+enum class ProfilePhase {
+    Gradient,          ///< logp_and_gradient evaluations
+    Leapfrog,          ///< Leapfrog steps
+    SamplerStep,       ///< One sampler->step() call
+    MetropolisSweep,   ///< One do_one_metropolis_step() sweep
+    EdgeIndicators,    ///< update_edge_indicators()
+    ImputeMissing,     ///< impute_missing()
+    EdgePriorUpdate,   ///< edge_prior.update()
+    SampleStorage,     ///< Storing a draw and its diagnostics
+    ProjectPosition,   ///< RATTLE position projections (project_position)
+    ProjectMomentum,   ///< RATTLE momentum projections (project_momentum)
+    Count
+};
+
+
+/**
+ * ChainProfile - Call counts and wall time per phase for one chain
+ *
+ * Also keeps a histogram of the NUTS tree depths over every iteration,
+ * warmup included, which the stored `treedepth` trace does not cover, and
+ * the per-iteration (re)allocations that model-owned workspaces report
+ * through profile_workspace_allocations().
+ */
+class ChainProfile {
+public:
+    static constexpr std::size_t num_phases = static_cast<std::size_t>(ProfilePhase::Count);
+
+    /// Add `calls` calls taking `nanoseconds` in total to a phase.
+    void record(ProfilePhase phase, std::int64_t nanoseconds, std::int64_t calls = 1) {
+        const std::size_t k = static_cast<std::size_t>(phase);
+        calls_[k] += calls;
+        nanoseconds_[k] += nanoseconds;
+    }
+
+    /// Size the per-iteration traces for a chain of `total_iter` iterations.
+    void reserve_iterations(int total_iter) {
+        workspace_allocations_.assign(static_cast<std::size_t>(total_iter), 0);
+    }
+
+    /// Attribute subsequent per-iteration counts to iteration `iter`.
+    void begin_iteration(int iter) { iteration_ = iter; }
+
+    /// Add workspace (re)allocations to the current iteration.
+    void record_workspace_allocations(int count) {
+        if (iteration_ >= 0 &&
+            static_cast<std::size_t>(iteration_) < workspace_allocations_.size()) {
+            workspace_allocations_[iteration_] += count;
+        }
+    }
+
+    /// Count one NUTS iteration of the given tree depth.
+    void record_tree_depth(int depth) {
+        if (depth < 0) return;
+        if (static_cast<std::size_t>(depth) >= tree_depths_.size()) {
+            tree_depths_.resize(depth + 1, 0);
+        }
+        ++tree_depths_[depth];
+    }
+
+    /**
+     * Summary for R
+     *
+     * @return list(phases = data.frame(phase, calls, seconds),
+     *              treedepth = integer counts for depths 0, 1, ...,
+     *              workspace_allocations = integer count per iteration)
+     */
+    Rcpp::List to_list() const {
+        static const char* const names[num_phases] = {
+            "gradient", "leapfrog", "sampler_step", "metropolis_sweep",
+            "edge_indicators", "impute_missing", "edge_prior_update",
+            "sample_storage", "project_position", "project_momentum"
+        };
+
+        Rcpp::CharacterVector phase(num_phases);
+        Rcpp::NumericVector calls(num_phases);
+        Rcpp::NumericVector seconds(num_phases);
+        for (std::size_t k = 0; k < num_phases; ++k) {
+            phase[k] = names[k];
+            calls[k] = static_cast<double>(calls_[k]);
+            seconds[k] = 1e-9 * static_cast<double>(nanoseconds_[k]);
+        }
+
+        Rcpp::IntegerVector treedepth(tree_depths_.begin(), tree_depths_.end());
+        Rcpp::CharacterVector depth(treedepth.size());
+        for (R_xlen_t d = 0; d < treedepth.size(); ++d) {
+            depth[d] = std::to_string(d);
+        }
+        treedepth.names() = depth;
+
+        return Rcpp::List::create(
+            Rcpp::Named("phases") = Rcpp::DataFrame::create(
+                Rcpp::Named("phase") = phase,
+                Rcpp::Named("calls") = calls,
+                Rcpp::Named("seconds") = seconds,
+                Rcpp::Named("stringsAsFactors") = false
+            ),
+            Rcpp::Named("treedepth") = treedepth,
+            Rcpp::Named("workspace_allocations") = Rcpp::IntegerVector(
+                workspace_allocations_.begin(), workspace_allocations_.end())
+        );
+    }
+
+private:
+    std::array<std::int64_t, num_phases> calls_{};
+    std::array<std::int64_t, num_phases> nanoseconds_{};
+    std::vector<int> tree_depths_;
+    std::vector<int> workspace_allocations_;
+    int iteration_ = -1;
+};
+
+
+/// Profile bound to this thread, or null outside a chain.
+inline ChainProfile*& active_chain_profile() {
+    thread_local ChainProfile* profile = nullptr;
+    return profile;
+}
+
+
+/// Report workspace (re)allocations to the bound profile, if any.
+inline void profile_workspace_allocations(int count) {
+#if BGMS_USE_PROFILE
+    if (count == 0) return;
+    if (ChainProfile* profile = active_chain_profile()) {
+        profile->record_workspace_allocations(count);
+    }
+#else
+    (void)count;
+#endif
+}
+
+
+/**
+ * ActiveProfile - Binds a chain's profile to the running thread
+ *
+ * Restores the previous binding on exit, so a chain task that TBB runs
+ * while another chain on the same thread waits keeps its own counters.
+ */
+class ActiveProfile {
+public:
+    explicit ActiveProfile(ChainProfile& profile)
+        : previous_(active_chain_profile()) {
+        active_chain_profile() = &profile;
+    }
+    ~ActiveProfile() { active_chain_profile() = previous_; }
+
+    ActiveProfile(const ActiveProfile&) = delete;
+    ActiveProfile& operator=(const ActiveProfile&) = delete;
+
+private:
+    ChainProfile* previous_;
+};
+
+
+/**
+ * ProfileScope - Times one call of a phase into the bound profile
+ *
+ * Does nothing, clock reads included, when no profile is bound.
+ */
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfilePhase phase, std::int64_t calls = 1)
+        : profile_(active_chain_profile()), phase_(phase), calls_(calls) {
+        if (profile_) start_ = std::chrono::steady_clock::now();
+    }
+    ~ProfileScope() {
+        if (!profile_) return;
+        const auto elapsed = std::chrono::steady_clock::now() - start_;
+        profile_->record(
+            phase_,
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+            calls_);
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    ChainProfile* profile_;
+    ProfilePhase phase_;
+    std::int64_t calls_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+
+#define BGMS_PROFILE_CONCAT_(a, b) a##b
+#define BGMS_PROFILE_CONCAT(a, b) BGMS_PROFILE_CONCAT_(a, b)
+
+#if BGMS_USE_PROFILE
+/// Time the rest of the enclosing block as one call of `phase`.
+#define BGMS_PROFILE_SCOPE(phase) \
+    ProfileScope BGMS_PROFILE_CONCAT(bgms_profile_scope_, __LINE__)(ProfilePhase::phase)
+/// Time the rest of the enclosing block as `calls` calls of `phase`.
+#define BGMS_PROFILE_SCOPE_N(phase, calls) \
+    ProfileScope BGMS_PROFILE_CONCAT(bgms_profile_scope_, __LINE__)(ProfilePhase::phase, (calls))
+#else
+#define BGMS_PROFILE_SCOPE(phase) ((void)0)
+#define BGMS_PROFILE_SCOPE_N(phase, calls) ((void)0)
+#endif
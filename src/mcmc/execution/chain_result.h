@@ -1,13 +1,35 @@
 #pragma once
 
+#include <memory>
+#include <optional>
 #include <string>
 #include <RcppArmadillo.h>
+#include "mcmc/execution/chain_profile.h"
+#include "mcmc/execution/convergence_monitor.h"
+#include "mcmc/execution/parallel_tempering.h"
+#include "mcmc/execution/indicator_trace.h"
+#include "mcmc/execution/online_summary.h"
+#include "mcmc/execution/predictive_checks.h"
+#include "mcmc/execution/r_buffer.h"
+#include "mcmc/execution/sample_sink.h"
+#include "mcmc/execution/sampler_state.h"
+#include "mcmc/execution/warmup_schedule.h"
+#include "models/base_model.h"
 
 /**
  * ChainResult - Storage for a single MCMC chain's output
  *
  * Holds samples, diagnostics, and error state for one chain.
  * Designed for use with both Metropolis and NUTS samplers.
+ *
+ * Parameter and indicator draws can instead be streamed to a SampleSink
+ * (see stream_samples_to()). The in-memory matrix is then never allocated.
+ *
+ * The per-iteration traces live in RBuffers: R matrices allocated by the
+ * reserve_*() calls on the main thread and written through Armadillo
+ * views, so convert_results_to_list() returns them without a copy. The
+ * parameter, energy and acceptance traces can be kept in single precision
+ * (see SamplerConfig::single_precision_traces); computation stays double.
  */
 class ChainResult {
 
@@ -25,44 +47,95 @@ public:
     int         chain_id = 0;
 
     /// Parameter samples (param_dim x n_iter).
-    arma::mat   samples;
+    RealRBuffer<arma::mat> samples;
 
-    /// Edge indicator samples (n_edges x n_iter), only if edge_selection = true.
-    arma::imat  indicator_samples;
+    /// Edge indicator samples (n_edges x n_iter, bit-packed), only if
+    /// edge_selection = true.
+    PackedIndicatorTrace indicator_samples;
     /// Whether indicator samples are stored.
     bool        has_indicators = false;
 
+    /// Destination of the parameter draws, or null to keep them in `samples`.
+    std::unique_ptr<SampleSink<double>>       sample_sink;
+    /// Destination of the indicator draws, or null to keep them in
+    /// `indicator_samples`.
+    std::unique_ptr<SampleSink<arma::sword>>  indicator_sink;
+
     /// SBM allocation samples (n_variables x n_iter), only if SBM edge prior.
-    arma::imat  allocation_samples;
+    RBuffer<arma::Mat<int>> allocation_samples;
     /// Whether allocation samples are stored.
     bool        has_allocations = false;
 
     /// NUTS tree depth diagnostics (n_iter).
-    arma::ivec  treedepth_samples;
+    RBuffer<arma::Col<int>> treedepth_samples;
     /// NUTS divergent transition flags (n_iter).
-    arma::ivec  divergent_samples;
+    RBuffer<arma::Col<int>> divergent_samples;
     /// NUTS non-reversible step flags (n_iter).
-    arma::ivec  non_reversible_samples;
+    RBuffer<arma::Col<int>> non_reversible_samples;
     /// NUTS energy diagnostic (n_iter).
-    arma::vec   energy_samples;
+    RealRBuffer<arma::vec>  energy_samples;
     /// NUTS mean per-trajectory Metropolis acceptance (n_iter).
-    arma::vec   accept_prob_samples;
+    RealRBuffer<arma::vec>  accept_prob_samples;
+    /// NUTS trajectory-buffer (re)allocations per iteration (n_iter).
+    RBuffer<arma::Col<int>> arena_allocation_samples;
     /// Whether NUTS diagnostics are stored.
     bool        has_nuts_diagnostics = false;
 
     /// Adaptive-Metropolis mean per-iteration acceptance probability across
     /// all updated components (n_iter).
-    arma::vec   am_accept_prob_samples;
+    RBuffer<arma::vec> am_accept_prob_samples;
     /// Whether AM diagnostics are stored.
     bool        has_am_diagnostics = false;
 
+    /// Variance of the subsampled log-pseudolikelihood estimate (n_iter).
+    RBuffer<arma::vec> subsample_variance_samples;
+    /// Whether subsampling diagnostics are stored.
+    bool        has_subsample_diagnostics = false;
+
+    /// Running summaries over every post-warmup iteration.
+    OnlineSummary online_summary;
+    /// Whether running summaries are kept.
+    bool        has_online_summary = false;
+
+    /// Discrepancy statistics of the replicates simulated in the chain.
+    PredictiveChecks predictive_checks;
+    /// Whether the chain runs posterior-predictive checks.
+    bool        has_predictive_checks = false;
+    /// Scratch for the current replicate dataset.
+    arma::mat   predictive_replicate;
+    /// Stream the replicates are drawn from, apart from the model's, so
+    /// the checks leave the parameter draws unchanged.
+    SafeRNG     predictive_rng;
+
+    /// Hot-path call counts and wall time, filled while the chain runs.
+    ChainProfile profile;
+
+    /// State of the chain when it stopped, to continue it in a later run.
+    SamplerState final_state;
+
+    /// Checks of a run with a ConvergenceTarget (shared by its chains).
+    ConvergenceReport convergence;
+    /// Whether the run checked convergence.
+    bool        has_convergence = false;
+
+    /// Replica swaps of a tempered chain.
+    TemperingReport tempering;
+    /// Whether the chain ran tempered replicas.
+    bool        has_tempering = false;
+
+    /// Stage boundaries the warmup ran with, when Stage 2 could end early.
+    std::optional<WarmupSchedule> warmup_schedule;
+
     /**
-     * Reserve storage for samples
-     * @param param_dim  Number of parameters per sample
-     * @param n_iter     Number of sampling iterations
+     * Reserve storage for samples. Main thread only, like the other
+     * reserve_*() calls.
+     * @param param_dim         Number of parameters per sample
+     * @param n_iter            Number of sampling iterations
+     * @param single_precision  Store the samples as float32
      */
-    void reserve(const size_t param_dim, const size_t n_iter) {
-        samples.set_size(param_dim, n_iter);
+    void reserve(const size_t param_dim, const size_t n_iter,
+                 const bool single_precision = false) {
+        if (!sample_sink) samples.allocate(param_dim, n_iter, single_precision);
     }
 
     /**
@@ -71,30 +144,51 @@ public:
      * @param n_iter   Number of sampling iterations
      */
     void reserve_indicators(const size_t n_edges, const size_t n_iter) {
-        indicator_samples.set_size(n_edges, n_iter);
+        if (!indicator_sink) indicator_samples.reserve(n_edges, n_iter);
         has_indicators = true;
     }
 
+    /**
+     * Stream draws to sinks instead of the in-memory matrices. Call before
+     * reserve() / reserve_indicators().
+     * @param samples_to     Sink for parameter draws (may be null)
+     * @param indicators_to  Sink for indicator draws (may be null)
+     */
+    void stream_samples_to(std::unique_ptr<SampleSink<double>> samples_to,
+                           std::unique_ptr<SampleSink<arma::sword>> indicators_to) {
+        sample_sink = std::move(samples_to);
+        indicator_sink = std::move(indicators_to);
+    }
+
+    /** Write out buffered draws. Call once the chain has stopped sampling. */
+    void finish_sinks() {
+        if (sample_sink) sample_sink->finish();
+        if (indicator_sink) indicator_sink->finish();
+    }
+
     /**
      * Reserve storage for SBM allocation samples
      * @param n_variables  Number of variables
      * @param n_iter       Number of sampling iterations
      */
     void reserve_allocations(const size_t n_variables, const size_t n_iter) {
-        allocation_samples.set_size(n_variables, n_iter);
+        allocation_samples.allocate(n_variables, n_iter);
         has_allocations = true;
     }
 
     /**
      * Reserve storage for NUTS diagnostics
-     * @param n_iter  Number of sampling iterations
+     * @param n_iter            Number of sampling iterations
+     * @param single_precision  Store energy and acceptance as float32
      */
-    void reserve_nuts_diagnostics(const size_t n_iter) {
-        treedepth_samples.set_size(n_iter);
-        divergent_samples.set_size(n_iter);
-        non_reversible_samples.set_size(n_iter);
-        energy_samples.set_size(n_iter);
-        accept_prob_samples.set_size(n_iter);
+    void reserve_nuts_diagnostics(const size_t n_iter, const bool single_precision = false) {
+        treedepth_samples.allocate(n_iter);
+        divergent_samples.allocate(n_iter);
+        non_reversible_samples.allocate(n_iter);
+        energy_samples.allocate(n_iter, 1, single_precision);
+        accept_prob_samples.allocate(n_iter, 1, single_precision);
+        arena_allocation_samples.allocate(n_iter);
+        arena_allocation_samples.view().zeros();
         has_nuts_diagnostics = true;
     }
 
@@ -103,17 +197,100 @@ public:
      * @param n_iter  Number of sampling iterations
      */
     void reserve_am_diagnostics(const size_t n_iter) {
-        am_accept_prob_samples.set_size(n_iter);
+        am_accept_prob_samples.allocate(n_iter);
         has_am_diagnostics = true;
     }
 
+    /**
+     * Reserve storage for subsampling diagnostics
+     * @param n_iter  Number of sampling iterations
+     */
+    void reserve_subsample_diagnostics(const size_t n_iter) {
+        subsample_variance_samples.allocate(n_iter);
+        has_subsample_diagnostics = true;
+    }
+
+    /**
+     * Set up running summaries
+     * @param param_dim    Number of parameters per sample
+     * @param n_edges      Number of edge indicators (0 without edge selection)
+     * @param coinclusion  Also count pairwise edge co-inclusions
+     * @param batch_size   Draws per batch for the batch-means ESS
+     */
+    void reserve_online_summary(const size_t param_dim, const size_t n_edges,
+                                const bool coinclusion, const size_t batch_size) {
+        online_summary.reserve(param_dim, n_edges, coinclusion, batch_size);
+        has_online_summary = true;
+    }
+
+    /**
+     * Set up the posterior-predictive checks
+     * @param schedule  Statistics, thinning and observed data of the checks
+     */
+    void reserve_predictive_checks(const PredictiveCheckSchedule& schedule) {
+        predictive_checks.reserve(schedule);
+        has_predictive_checks = true;
+    }
+
+    /**
+     * Simulate a replicate from the model's current parameters and add its
+     * statistics to the predictive checks
+     * @param model     Model of the chain (draws from predictive_rng)
+     * @param schedule  Schedule the checks were reserved with
+     */
+    void update_predictive_checks(BaseModel& model, const PredictiveCheckSchedule& schedule) {
+        model.simulate_replicate(static_cast<int>(schedule.observed.n_rows),
+                                 schedule.gibbs_iter, predictive_rng, predictive_replicate);
+        predictive_checks.update(predictive_replicate);
+    }
+
+    /**
+     * Add the current state to the running summaries
+     * @param sample  Parameter vector
+     * @param model   Model whose edge indicators are summarized
+     */
+    void update_online_summary(const arma::vec& sample, BaseModel& model) {
+        online_summary.update(sample);
+        if (online_summary.has_indicators()) {
+            IndicatorBitWriter out(online_summary.indicator_words());
+            model.pack_indicator_parameters(out);
+            online_summary.update_indicators();
+        }
+    }
+
+    /**
+     * Keep only the first `n_draws` stored draws of every trace, after a
+     * run that stopped early. Running summaries, which cover every draw the
+     * chain took, are left as they are. Main thread only.
+     * @param n_draws  Number of draws to keep
+     */
+    void truncate(const size_t n_draws) {
+        if (samples.allocated()) samples.truncate(n_draws);
+        if (has_indicators && !indicator_sink) indicator_samples.truncate(n_draws);
+        if (has_allocations) allocation_samples.truncate(n_draws);
+        if (has_nuts_diagnostics) {
+            treedepth_samples.truncate(n_draws);
+            divergent_samples.truncate(n_draws);
+            non_reversible_samples.truncate(n_draws);
+            energy_samples.truncate(n_draws);
+            accept_prob_samples.truncate(n_draws);
+            arena_allocation_samples.truncate(n_draws);
+        }
+        if (has_am_diagnostics) am_accept_prob_samples.truncate(n_draws);
+        if (has_subsample_diagnostics) subsample_variance_samples.truncate(n_draws);
+    }
+
     /**
      * Store a parameter sample
      * @param iter    Iteration index (0-based)
      * @param sample  Parameter vector
      */
     void store_sample(const size_t iter, const arma::vec& sample) {
-        samples.col(iter) = sample;
+        if (sample_sink) {
+            sample_sink->write(sample);
+        } else {
+            samples.set_col(iter, sample);
+        }
     }
 
     /**
@@ -122,7 +299,30 @@ public:
      * @param indicators  Edge indicator vector
      */
     void store_indicators(const size_t iter, const arma::ivec& indicators) {
-        indicator_samples.col(iter) = indicators;
+        if (indicator_sink) {
+            indicator_sink->write(indicators);
+        } else {
+            indicator_samples.store(iter, indicators);
+        }
+    }
+
+    /**
+     * Store the model's current edge indicators
+     *
+     * Packs the indicators straight into the trace via
+     * BaseModel::pack_indicator_parameters(). Only a file sink, which stores
+     * indicators unpacked, goes through get_vectorized_indicator_parameters().
+     *
+     * @param iter   Iteration index (0-based)
+     * @param model  Model whose indicators are recorded
+     */
+    void store_indicators_from(const size_t iter, BaseModel& model) {
+        if (indicator_sink) {
+            indicator_sink->write(model.get_vectorized_indicator_parameters());
+        } else {
+            IndicatorBitWriter out(indicator_samples.clear_draw(iter));
+            model.pack_indicator_parameters(out);
+        }
     }
 
     /**
@@ -131,7 +331,7 @@ public:
      * @param allocations  Allocation vector (1-based cluster labels)
      */
     void store_allocations(const size_t iter, const arma::ivec& allocations) {
-        allocation_samples.col(iter) = allocations;
+        allocation_samples.view().col(iter) = arma::conv_to<arma::Col<int>>::from(allocations);
     }
 
     /**
@@ -142,13 +342,15 @@ public:
      * @param non_reversible Whether a non-reversible constrained step occurred
      * @param energy       Final Hamiltonian energy
      * @param accept_prob  Mean Metropolis acceptance over the trajectory
+     * @param arena_allocations Trajectory-buffer (re)allocations in this step
      */
-    void store_nuts_diagnostics(const size_t iter, int tree_depth, bool divergent, bool non_reversible, double energy, double accept_prob) {
-        treedepth_samples(iter) = tree_depth;
-        divergent_samples(iter) = divergent ? 1 : 0;
-        non_reversible_samples(iter) = non_reversible ? 1 : 0;
-        energy_samples(iter) = energy;
-        accept_prob_samples(iter) = accept_prob;
+    void store_nuts_diagnostics(const size_t iter, int tree_depth, bool divergent, bool non_reversible, double energy, double accept_prob, int arena_allocations = 0) {
+        treedepth_samples.view()(iter) = tree_depth;
+        divergent_samples.view()(iter) = divergent ? 1 : 0;
+        non_reversible_samples.view()(iter) = non_reversible ? 1 : 0;
+        energy_samples.set(iter, energy);
+        accept_prob_samples.set(iter, accept_prob);
+        arena_allocation_samples.view()(iter) = arena_allocations;
     }
 
     /**
@@ -157,6 +359,15 @@ public:
      * @param accept_prob  Mean acceptance probability across the sweep
      */
     void store_am_diagnostics(const size_t iter, double accept_prob) {
-        am_accept_prob_samples(iter) = accept_prob;
+        am_accept_prob_samples.view()(iter) = accept_prob;
+    }
+
+    /**
+     * Store the subsampling diagnostics for one iteration
+     * @param iter      Iteration index (0-based)
+     * @param variance  Variance of the log-pseudolikelihood estimate
+     */
+    void store_subsample_variance(const size_t iter, double variance) {
+        subsample_variance_samples.view()(iter) = variance;
     }
 };
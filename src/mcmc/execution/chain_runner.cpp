@@ -1,9 +1,18 @@
 #include "mcmc/execution/chain_runner.h"
 
+#include <algorithm>
+#include <cmath>
 #include <exception>
-#include <tbb/global_control.h>
+#include <string>
+#include <utility>
+#include "mcmc/execution/chain_profile.h"
+#include "mcmc/samplers/hmc_sampler.h"
 #include "mcmc/samplers/nuts_sampler.h"
 #include "mcmc/samplers/metropolis_sampler.h"
+#include "mcmc/samplers/polya_gamma_sampler.h"
+#include "mcmc/samplers/sgld_sampler.h"
+#include "rng/rng_utils.h"
+#include "utils/task_arena.h"
 
 
 namespace {
@@ -17,18 +26,84 @@ void store_nuts_diagnostics_if_present(ChainResult& chain_result, int sample_ind
     auto* diag = dynamic_cast<NUTSDiagnostics*>(result.diagnostics.get());
     if (diag) {
         chain_result.store_nuts_diagnostics(sample_index, diag->tree_depth, diag->divergent,
-                                            diag->non_reversible, diag->energy, diag->accept_prob);
+                                            diag->non_reversible, diag->energy, diag->accept_prob,
+                                            diag->arena_allocations);
     }
 }
 
+// Count this iteration's NUTS tree depth in the chain profile.
+void record_tree_depth_if_present(ChainResult& chain_result, const SamplerBase& sampler,
+                                  const StepResult& result) {
+#if BGMS_USE_PROFILE
+    if (!sampler.has_nuts_diagnostics()) return;
+    auto* diag = dynamic_cast<NUTSDiagnostics*>(result.diagnostics.get());
+    if (diag) chain_result.profile.record_tree_depth(diag->tree_depth);
+#endif
+}
+
+// The stage boundaries of a warmup as an R list; iterations are counted
+// from 0, and each boundary is the first iteration of the next part.
+Rcpp::List warmup_schedule_to_list(const WarmupSchedule& schedule) {
+    return Rcpp::List::create(
+        Rcpp::Named("planned_warmup") = schedule.planned_warmup,
+        Rcpp::Named("warmup") = schedule.total_warmup,
+        Rcpp::Named("stage1_end") = schedule.stage1_end,
+        Rcpp::Named("window_ends") = Rcpp::wrap(schedule.window_ends),
+        Rcpp::Named("stage3a_start") = schedule.stage3a_start,
+        Rcpp::Named("stage3b_start") = schedule.stage3b_start,
+        Rcpp::Named("stage3c_start") = schedule.stage3c_start
+    );
+}
+
+// Save where the chain stopped: model blocks, sampler tuning, edge-prior
+// state and the RNG position.
+void save_chain_state(ChainResult& chain_result, BaseModel& model,
+                      const SamplerBase& sampler, const BaseEdgePrior& edge_prior) {
+    SamplerState& state = chain_result.final_state;
+    model.save_state(state);
+    sampler.save_state(state);
+    edge_prior.save_state(state);
+    state.rng = model.get_rng().state();
+}
+
+// Path of one chain's streamed trace: <dir>/chain-<id>-<what>.bin
+std::string sample_file_path(const std::string& dir, int chain_id, const char* what) {
+    return dir + "/chain-" + std::to_string(chain_id) + "-" + what + ".bin";
+}
+
 }  // namespace
 
 
+int resolve_gradient_threads(int threads_per_chain, int no_chains, int no_threads) {
+    if (no_threads <= 1) return 1;
+    if (threads_per_chain <= 0) {
+        const int concurrent_chains = std::max(1, std::min(no_chains, no_threads));
+        return std::max(1, no_threads / concurrent_chains);
+    }
+    return std::min(threads_per_chain, no_threads);
+}
+
+
+int lockstep_chain_batch(int no_chains, int no_threads) {
+    const int threads = std::max(1, no_threads);
+    const int chain_batch = no_chains > threads ? (no_chains + threads - 1) / threads : 1;
+    return std::max(1, std::min(chain_batch, no_chains));
+}
+
+
 SamplerSpec resolve_sampler_spec(const std::string& sampler_type) {
     if (sampler_type == "nuts") {
         return SamplerSpec{SamplerKind::NUTS, /*learn_sd=*/true, /*nuts_diag=*/true, /*am_diag=*/false};
+    } else if (sampler_type == "nuts-iterative") {
+        return SamplerSpec{SamplerKind::NUTSIterative, /*learn_sd=*/true, /*nuts_diag=*/true, /*am_diag=*/false};
+    } else if (sampler_type == "adaptive-hmc") {
+        return SamplerSpec{SamplerKind::AdaptiveHMC, /*learn_sd=*/true, /*nuts_diag=*/true, /*am_diag=*/false};
     } else if (sampler_type == "adaptive-metropolis") {
         return SamplerSpec{SamplerKind::AdaptiveMetropolis, /*learn_sd=*/false, /*nuts_diag=*/false, /*am_diag=*/true};
+    } else if (sampler_type == "sgld") {
+        return SamplerSpec{SamplerKind::SGLD, /*learn_sd=*/true, /*nuts_diag=*/false, /*am_diag=*/false};
+    } else if (sampler_type == "polya-gamma") {
+        return SamplerSpec{SamplerKind::PolyaGamma, /*learn_sd=*/true, /*nuts_diag=*/false, /*am_diag=*/false};
     } else {
         Rcpp::stop("Unknown sampler_type: '%s'", sampler_type.c_str());
     }
@@ -38,182 +113,966 @@ std::unique_ptr<SamplerBase> create_sampler(SamplerKind kind, const SamplerConfi
     switch (kind) {
         case SamplerKind::NUTS:
             return std::make_unique<NUTSSampler>(config, schedule);
+        case SamplerKind::NUTSIterative:
+            return std::make_unique<NUTSSampler>(config, schedule, /*iterative=*/true);
+        case SamplerKind::AdaptiveHMC:
+            return std::make_unique<AdaptiveHMCSampler>(config, schedule);
         case SamplerKind::AdaptiveMetropolis:
             return std::make_unique<MetropolisSampler>(config, schedule);
+        case SamplerKind::SGLD:
+            return std::make_unique<SGLDSampler>(config, schedule);
+        case SamplerKind::PolyaGamma:
+            return std::make_unique<PolyaGammaSampler>(config, schedule);
     }
     Rcpp::stop("Unhandled SamplerKind");  // unreachable: kind comes from resolve_sampler_spec
 }
 
 
-void run_mcmc_chain(
+ChainExecution::ChainExecution(
     ChainResult& chain_result,
     BaseModel& model,
     BaseEdgePrior& edge_prior,
     const SamplerConfig& config,
     const int chain_id,
-    ProgressManager& pm
-) {
-    chain_result.chain_id = chain_id + 1;
-
-    // Construct warmup schedule (shared by runner and sampler)
-    const SamplerSpec spec = resolve_sampler_spec(config.sampler_type);
-    WarmupSchedule schedule(config.no_warmup, config.edge_selection, spec.learn_sd);
+    ProgressManager& pm,
+    const SamplerState* warm_start,
+    ConvergenceMonitor* monitor,
+    const bool store_draws
+) :
+    chain_result_(chain_result),
+    model_(model),
+    edge_prior_(edge_prior),
+    config_(config),
+    chain_id_(chain_id),
+    pm_(pm),
+    monitor_(monitor),
+    store_draws_(store_draws),
+    // Warmup schedule, shared by the loop and the sampler
+    schedule_(config.no_warmup, config.edge_selection,
+              resolve_sampler_spec(config.sampler_type).learn_sd),
+    total_iter_(config.no_warmup + config.no_iter)
+{
+    chain_result_.chain_id = chain_id + 1;
+    // Early end of Stage 2 for the samplers that adapt a NUTS metric; the
+    // pooled and tempered runs advance all chains by the fixed schedule
+    const SamplerKind kind = resolve_sampler_spec(config.sampler_type).kind;
+    if (config.adaptive_warmup > 0.0 && !config.pooled_warmup && !config.tempering.enabled &&
+        (kind == SamplerKind::NUTS || kind == SamplerKind::NUTSIterative ||
+         kind == SamplerKind::AdaptiveHMC)) {
+        schedule_.stable_tolerance = config.adaptive_warmup;
+    }
+#if BGMS_USE_PROFILE
+    ActiveProfile active_profile(chain_result_.profile);
+    chain_result_.profile.reserve_iterations(total_iter_);
+#endif
 
-    auto sampler = create_sampler(spec.kind, config, schedule);
+    sampler_ = create_sampler(kind, config, schedule_);
+    model_.set_edge_listener(&edge_prior_);
+    if (store_draws_ && pm_.telemetry()) {
+        telemetry_ = std::make_unique<TelemetryProbe>(*pm_.telemetry(), chain_id);
+    }
+    if (warm_start) {
+        sampler_->restore_state(*warm_start);
+    }
+    // The replicates draw from a copy of the chain's stream one jump ahead,
+    // which the chain itself never reaches
+    if (chain_result_.has_predictive_checks) {
+        chain_result_.predictive_rng = model_.get_rng();
+        chain_result_.predictive_rng.jump();
+    }
 
     // Initialize sampler (step-size heuristic) before the main loop
-    sampler->initialize(model);
+    sampler_->initialize(model_);
 
-    const int total_iter = config.no_warmup + config.no_iter;
+    if (total_iter_ == 0) finish();
+}
 
-    // ---- Main MCMC loop (warmup + sampling) ----
-    for (int iter = 0; iter < total_iter; ++iter) {
 
-        // Per-iteration preparation (e.g., shuffle edge order)
-        model.prepare_iteration();
+ChainExecution::~ChainExecution() {
+    model_.set_edge_listener(nullptr);
+}
 
-        // Optional missing-data imputation
-        if (config.na_impute && model.has_missing_data()) {
-            model.impute_missing();
-        }
 
-        // Edge selection
-        if (schedule.selection_enabled(iter) && model.has_edge_selection()) {
-            if (iter == schedule.stage3c_start) {
-                model.set_edge_selection_active(true);
-            }
-            model.update_edge_indicators();
+bool ChainExecution::step() {
+    if (!begin_step()) return false;
+    return finish_step(sample());
+}
+
+
+StepResult ChainExecution::sample() {
+#if BGMS_USE_PROFILE
+    ActiveProfile active_profile(chain_result_.profile);
+#endif
+    BGMS_PROFILE_SCOPE(SamplerStep);
+    return sampler_->step(model_, iter_);
+}
+
+
+bool ChainExecution::begin_step() {
+    if (done_) return false;
+    const int iter = iter_;
+    const SamplerConfig& config = config_;
+    BaseModel& model = model_;
+#if BGMS_USE_PROFILE
+    ActiveProfile active_profile(chain_result_.profile);
+    chain_result_.profile.begin_iteration(iter);
+#endif
+
+    // Per-iteration preparation (e.g., shuffle edge order)
+    model.scratch_arena().reset();
+    model.prepare_iteration();
+    bool target_changed = model.uses_subsampling();
+
+    // Optional missing-data imputation
+    if (config.na_impute && model.has_missing_data()) {
+        BGMS_PROFILE_SCOPE(ImputeMissing);
+        model.impute_missing();
+        target_changed = true;
+    }
+
+    // Edge selection
+    if (schedule_.selection_enabled(iter) && model.has_edge_selection()) {
+        if (iter == schedule_.stage3c_start) {
+            model.set_edge_selection_active(true);
         }
+        BGMS_PROFILE_SCOPE(EdgeIndicators);
+        model.update_edge_indicators();
+        target_changed = true;
+    }
+
+    // Main parameter update — adaptation is internal to sampler
+    if (target_changed) sampler_->target_changed();
+    return true;
+}
 
-        // Main parameter update — adaptation is internal to sampler
-        StepResult result = sampler->step(model, iter);
 
-        // Stage 3b: proposal-SD tuning
-        model.tune_proposal_sd(iter, schedule);
+bool ChainExecution::finish_step(StepResult result) {
+    const int iter = iter_;
+    const SamplerConfig& config = config_;
+    ChainResult& chain_result = chain_result_;
+    BaseModel& model = model_;
+#if BGMS_USE_PROFILE
+    ActiveProfile active_profile(chain_result.profile);
+#endif
+    record_tree_depth_if_present(chain_result, *sampler_, result);
 
-        // Edge prior update
-        if (schedule.selection_enabled(iter) && model.has_edge_selection()) {
-            edge_prior.update(
-                model.get_edge_indicators(),
-                model.get_inclusion_probability(),
-                model.get_num_variables(),
-                model.get_num_pairwise(),
-                model.get_rng()
-            );
+    // Stage 3b: proposal-SD tuning
+    model.tune_proposal_sd(iter, schedule_);
+
+    // Stage 2 ended early: count the dropped warmup as done
+    if (schedule_.warmup_saved() > warmup_skipped_) {
+        if (store_draws_) pm_.skip(chain_id_, schedule_.warmup_saved() - warmup_skipped_);
+        warmup_skipped_ = schedule_.warmup_saved();
+    }
+
+    // Edge prior update
+    if (schedule_.selection_enabled(iter) && model.has_edge_selection()) {
+        BGMS_PROFILE_SCOPE(EdgePriorUpdate);
+        edge_prior_.update(
+            model.get_edge_indicators(),
+            model.get_inclusion_probability(),
+            model.get_num_variables(),
+            model.get_num_pairwise(),
+            model.get_rng()
+        );
+    }
+
+    // Store samples (only during sampling phase): every thin-th draw is
+    // kept, and every draw goes into the running summaries
+    if (store_draws_ && schedule_.sampling(iter)) {
+        BGMS_PROFILE_SCOPE(SampleStorage);
+        const int draw = iter - schedule_.total_warmup;
+        const bool keep = draw % config.thin == 0;
+        const int sample_index = draw / config.thin;
+
+        if (keep || chain_result.has_online_summary) {
+            const arma::vec sample = model.get_storage_vectorized_parameters();
+            if (chain_result.has_online_summary) {
+                chain_result.update_online_summary(sample, model);
+            }
+            if (keep) {
+                chain_result.store_sample(sample_index, sample);
+            }
         }
 
-        // Store samples (only during sampling phase)
-        if (schedule.sampling(iter)) {
-            int sample_index = iter - config.no_warmup;
+        if (chain_result.has_predictive_checks && draw % config.predictive_checks.every == 0) {
+            chain_result.update_predictive_checks(model, config.predictive_checks);
+        }
 
-            store_nuts_diagnostics_if_present(chain_result, sample_index, *sampler, result);
+        if (keep) {
+            store_nuts_diagnostics_if_present(chain_result, sample_index, *sampler_, result);
 
             if (chain_result.has_am_diagnostics) {
                 chain_result.store_am_diagnostics(sample_index, result.accept_prob);
             }
 
-            chain_result.store_sample(sample_index, model.get_storage_vectorized_parameters());
+            if (chain_result.has_subsample_diagnostics) {
+                chain_result.store_subsample_variance(sample_index, model.subsample_variance());
+            }
 
             if (chain_result.has_indicators) {
-                chain_result.store_indicators(sample_index, model.get_vectorized_indicator_parameters());
+                chain_result.store_indicators_from(sample_index, model);
             }
 
-            if (chain_result.has_allocations && edge_prior.has_allocations()) {
-                chain_result.store_allocations(sample_index, edge_prior.get_allocations());
+            if (chain_result.has_allocations && edge_prior_.has_allocations()) {
+                chain_result.store_allocations(sample_index, edge_prior_.get_allocations());
             }
+
+            if (monitor_) monitor_->record_draw(chain_id_);
         }
+    }
 
-        pm.update(chain_id);
-        if (pm.shouldExit()) {
-            chain_result.userInterrupt = true;
-            return;
+    ++iter_;
+    if (telemetry_) telemetry_->record(result);
+    if (store_draws_) pm_.update(chain_id_);
+    if (pm_.shouldExit()) {
+        chain_result.userInterrupt = true;
+        finish();
+    } else if (iter_ == total_iter_ - warmup_skipped_ ||
+               (monitor_ && monitor_->stop_requested())) {
+        finish();
+    }
+    if (!done_ && telemetry_ && telemetry_->due()) report_telemetry(false);
+    return !done_;
+}
+
+
+void ChainExecution::finish() {
+    chain_result_.finish_sinks();
+    if (schedule_.adaptive_stage2()) chain_result_.warmup_schedule = schedule_;
+    save_chain_state(chain_result_, model_, *sampler_, edge_prior_);
+    if (telemetry_) report_telemetry(true);
+    done_ = true;
+}
+
+
+void ChainExecution::report_telemetry(const bool done) {
+    const double edges = model_.has_edge_selection()
+        ? static_cast<double>(arma::accu(arma::trimatu(model_.get_edge_indicators(), 1)))
+        : TelemetryRecord::missing;
+    telemetry_->push(iter_, iter_ <= schedule_.total_warmup, done,
+                     sampler_->current_step_size(), edges);
+}
+
+
+void run_mcmc_chain(
+    ChainResult& chain_result,
+    BaseModel& model,
+    BaseEdgePrior& edge_prior,
+    const SamplerConfig& config,
+    const int chain_id,
+    ProgressManager& pm,
+    const SamplerState* warm_start
+) {
+    ChainExecution execution(chain_result, model, edge_prior, config, chain_id, pm, warm_start);
+    while (execution.step()) {}
+}
+
+
+namespace {
+
+// Record an exception thrown by a chain in its result.
+void record_chain_error(ChainResult& chain_result, const std::exception_ptr& error) {
+    chain_result.error = true;
+    try {
+        std::rethrow_exception(error);
+    } catch (std::exception& e) {
+        chain_result.error_msg = e.what();
+    } catch (...) {
+        chain_result.error_msg = "Unknown error";
+    }
+}
+
+// Close the Stage-2 window the chains of `runner` have just ended: every
+// chain adopts the inverse mass diagonal pooled over all windows and runs
+// the step-size heuristic under it, and all restart dual averaging from
+// the geometric mean of their heuristic step sizes. The pooling visits the
+// chains in index order, so the result does not depend on the threads.
+// It runs on the thread that drives run_phases (the run_with_reporter
+// helper in the parallel path, the caller in the sequential one), and
+// only once every chain task of the round has returned; no worker touches
+// the chains' adaptation in between, and R is never called here.
+void pool_warmup_window(MCMCChainRunner& runner) {
+    std::vector<std::size_t> chains;
+    std::vector<const DiagMassMatrixAccumulator*> windows;
+    for (std::size_t i = 0; i < runner.executions_.size(); ++i) {
+        auto& execution = runner.executions_[i];
+        if (!execution || execution->done()) continue;
+        auto* nuts = dynamic_cast<NUTSSampler*>(&execution->sampler());
+        if (!nuts || !nuts->window_pending()) continue;
+        chains.push_back(i);
+        windows.push_back(&nuts->window_statistics());
+    }
+    if (chains.empty()) return;
+
+    const arma::vec inv_mass = DiagMassMatrixAccumulator::pooled_variance(windows);
+
+    std::vector<std::size_t> pooled;
+    double log_eps_sum = 0.0;
+    double eps = 0.0;
+    for (std::size_t i : chains) {
+        auto& execution = runner.executions_[i];
+        auto& nuts = static_cast<NUTSSampler&>(execution->sampler());
+        try {
+            eps = nuts.end_window(execution->model(), inv_mass);
+        } catch (...) {
+            record_chain_error(runner.results_[i], std::current_exception());
+            if (runner.monitor_) runner.monitor_->retire(static_cast<int>(i));
+            execution.reset();
+            continue;
         }
+        pooled.push_back(i);
+        log_eps_sum += std::log(eps);
+    }
+    if (pooled.size() > 1) {
+        eps = std::exp(log_eps_sum / static_cast<double>(pooled.size()));
     }
 
+    for (std::size_t i : pooled) {
+        static_cast<NUTSSampler&>(runner.executions_[i]->sampler()).set_window_step_size(eps);
+    }
 }
 
+}  // namespace
+
 
 void MCMCChainRunner::operator()(std::size_t begin, std::size_t end) {
-    for (std::size_t i = begin; i < end; ++i) {
-        ChainResult& chain_result = results_[i];
-        BaseModel& model = *models_[i];
-        BaseEdgePrior& edge_prior = *edge_priors_[i];
-        model.set_seed(config_.seed + static_cast<int>(i));
+    const std::size_t batch = static_cast<std::size_t>(chain_batch_);
+    for (std::size_t b0 = begin; b0 < end; b0 += batch) {
+        const std::size_t b1 = std::min(end, b0 + batch);
+
+        // Set up every chain of the batch, then advance them one iteration
+        // at a time in turn until all have stopped or reached run_until_.
+        // A chain that throws is dropped from the batch; the others carry on.
+        for (std::size_t i = b0; i < b1; ++i) {
+            if (executions_[i] || results_[i].error) continue;
+            const SamplerState* warm_start = warm_start_.empty() ? nullptr : &warm_start_[i];
+            try {
+                if (!models_[i] && setup_) setup_(i);
+                executions_[i] = std::make_unique<ChainExecution>(
+                    results_[i], *models_[i], *edge_priors_[i], config_,
+                    static_cast<int>(i), pm_, warm_start, monitor_);
+            } catch (...) {
+                record_chain_error(results_[i], std::current_exception());
+                if (monitor_) monitor_->retire(static_cast<int>(i));
+            }
+        }
+
+        const bool together = batch_gradients_ && b1 - b0 > 1;
+        while (together ? step_together(b0, b1) : step_in_turn(b0, b1)) {}
+    }
+}
+
+
+bool MCMCChainRunner::runnable(const std::size_t i) const {
+    const auto& execution = executions_[i];
+    return execution && !execution->done() && execution->iteration() < run_until_;
+}
+
 
+void MCMCChainRunner::fail(const std::size_t i, const std::exception_ptr& error) {
+    record_chain_error(results_[i], error);
+    if (monitor_) monitor_->retire(static_cast<int>(i));
+    executions_[i].reset();
+}
+
+
+bool MCMCChainRunner::step_in_turn(const std::size_t b0, const std::size_t b1) {
+    // A chain that throws is dropped from the batch; the others carry on
+    bool running = false;
+    for (std::size_t i = b0; i < b1; ++i) {
+        if (!runnable(i)) continue;
         try {
-            run_mcmc_chain(chain_result, model, edge_prior, config_, static_cast<int>(i), pm_);
-        } catch (std::exception& e) {
-            chain_result.error = true;
-            chain_result.error_msg = e.what();
+            if (executions_[i]->step()) running = true;
         } catch (...) {
-            chain_result.error = true;
-            chain_result.error_msg = "Unknown error";
+            fail(i, std::current_exception());
         }
     }
+    return running;
 }
 
 
-std::vector<ChainResult> run_mcmc_sampler(
+bool MCMCChainRunner::step_together(const std::size_t b0, const std::size_t b1) {
+    // Work before the sampler step; the adaptive-HMC chains with
+    // unconstrained trajectories join the shared step, the others step
+    // on their own
+    bool running = false;
+    std::vector<std::size_t> chains;
+    std::vector<HMCBatchMember> members;
+    for (std::size_t i = b0; i < b1; ++i) {
+        if (!runnable(i)) continue;
+        ChainExecution& execution = *executions_[i];
+        try {
+            if (!execution.begin_step()) continue;
+            auto* hmc = dynamic_cast<AdaptiveHMCSampler*>(&execution.sampler());
+            if (!hmc || !hmc->batchable(execution.model())) {
+                if (execution.finish_step(execution.sample())) running = true;
+                continue;
+            }
+            members.emplace_back();
+            hmc->begin_batched_step(execution.model(), execution.iteration(), members.back());
+            chains.push_back(i);
+        } catch (...) {
+            if (chains.size() < members.size()) members.pop_back();
+            fail(i, std::current_exception());
+        }
+    }
+    if (chains.empty()) return running;
+
+    // One evaluation of the members' gradients per leapfrog step, by the
+    // first member's model; when it throws, every member fails
+    BaseModel& lead = executions_[chains[0]]->model();
+    std::vector<BaseModel*> models;
+    try {
+#if BGMS_USE_PROFILE
+        ActiveProfile active_profile(results_[chains[0]].profile);
+#endif
+        BGMS_PROFILE_SCOPE(SamplerStep);
+        hmc_step_batch(members, [&](const std::vector<std::size_t>& active,
+                                    const std::vector<arma::vec>& thetas,
+                                    std::vector<std::pair<double, arma::vec>>& evaluations) {
+            models.clear();
+            for (std::size_t k : active) models.push_back(&executions_[chains[k]]->model());
+            lead.logp_and_gradient_batch(models, thetas, evaluations);
+        });
+    } catch (...) {
+        const std::exception_ptr error = std::current_exception();
+        for (std::size_t i : chains) fail(i, error);
+        return running;
+    }
+
+    // Work after the sampler step, chain by chain
+    for (std::size_t k = 0; k < chains.size(); ++k) {
+        ChainExecution& execution = *executions_[chains[k]];
+        try {
+            auto& hmc = static_cast<AdaptiveHMCSampler&>(execution.sampler());
+            StepResult result = hmc.end_batched_step(execution.model(), execution.iteration(), members[k]);
+            if (execution.finish_step(std::move(result))) running = true;
+        } catch (...) {
+            fail(chains[k], std::current_exception());
+        }
+    }
+    return running;
+}
+
+
+TemperedChainRunner::TemperedChainRunner(
+    std::vector<ChainResult>& results,
+    std::vector<std::unique_ptr<BaseModel>>& models,
+    std::vector<std::unique_ptr<BaseEdgePrior>>& edge_priors,
+    const SamplerConfig& config,
+    ProgressManager& pm,
+    const std::vector<SamplerState>& warm_start,
+    std::vector<SafeRNG> swap_rngs,
+    ConvergenceMonitor* monitor
+) :
+    results_(results),
+    replica_results_(models.size() - results.size()),
+    models_(models),
+    edge_priors_(edge_priors),
+    config_(config),
+    pm_(pm),
+    warm_start_(warm_start),
+    monitor_(monitor),
+    beta_(tempering_ladder(config.tempering)),
+    no_chains_(results.size()),
+    swap_rngs_(std::move(swap_rngs)),
+    executions_(models.size()),
+    log_pl_(models.size(), 0.0),
+    active_(results.size(), 1)
+{
+    for (ChainResult& chain : results_) {
+        chain.tempering.temperatures = 1.0 / beta_;
+        chain.tempering.swap_attempts.zeros(beta_.n_elem - 1);
+        chain.tempering.swap_accepts.zeros(beta_.n_elem - 1);
+        chain.has_tempering = true;
+    }
+}
+
+
+void TemperedChainRunner::operator()(std::size_t begin, std::size_t end) {
+    for (std::size_t slot = begin; slot < end; ++slot) {
+        const std::size_t chain = slot % no_chains_;
+        if (!active_[chain]) continue;
+        ChainResult& result = slot_result(slot);
+        if (result.error) continue;
+        auto& execution = executions_[slot];
+        try {
+            if (!execution) {
+                const SamplerState* warm_start = warm_start_.empty() ? nullptr : &warm_start_[chain];
+                execution = std::make_unique<ChainExecution>(
+                    result, *models_[slot], *edge_priors_[slot], config_,
+                    static_cast<int>(chain), pm_, warm_start,
+                    slot == chain ? monitor_ : nullptr,
+                    /*store_draws=*/slot == chain);
+            }
+            while (execution->iteration() < run_until_ && execution->step()) {}
+            log_pl_[slot] = execution->model().log_pseudolikelihood();
+        } catch (...) {
+            record_chain_error(result, std::current_exception());
+            execution.reset();
+        }
+    }
+}
+
+
+void TemperedChainRunner::fail_chain(const std::size_t chain) {
+    ChainResult& cold = results_[chain];
+    for (std::size_t k = 1; k < beta_.n_elem && !cold.error; ++k) {
+        const ChainResult& hot = replica_results_[(k - 1) * no_chains_ + chain];
+        if (!hot.error) continue;
+        cold.error = true;
+        cold.error_msg = "replica " + std::to_string(k + 1) + ": " + hot.error_msg;
+    }
+    for (std::size_t k = 0; k < beta_.n_elem; ++k) {
+        executions_[k * no_chains_ + chain].reset();
+    }
+    if (monitor_) monitor_->retire(static_cast<int>(chain));
+    active_[chain] = 0;
+}
+
+
+bool TemperedChainRunner::swap(const int round) {
+    const std::size_t replicas = beta_.n_elem;
+    bool running = false;
+    for (std::size_t chain = 0; chain < no_chains_; ++chain) {
+        if (!active_[chain]) continue;
+
+        bool failed = false;
+        for (std::size_t k = 0; k < replicas; ++k) {
+            if (!executions_[k * no_chains_ + chain]) failed = true;
+        }
+        if (failed) {
+            fail_chain(chain);
+            continue;
+        }
+        if (executions_[chain]->done()) {
+            active_[chain] = 0;
+            continue;
+        }
+
+        std::vector<double> log_pl(replicas);
+        for (std::size_t k = 0; k < replicas; ++k) log_pl[k] = log_pl_[k * no_chains_ + chain];
+        const std::vector<int> accepted = propose_replica_swaps(
+            beta_, log_pl, round, swap_rngs_[chain], results_[chain].tempering);
+
+        for (int k : accepted) {
+            ChainExecution& lower = *executions_[k * no_chains_ + chain];
+            ChainExecution& upper = *executions_[(k + 1) * no_chains_ + chain];
+            // The positions and edge-prior states trade places; each
+            // replica keeps the tuning it adapted at its temperature
+            SamplerState lower_state, upper_state;
+            lower.model().save_position(lower_state);
+            lower.edge_prior().save_state(lower_state);
+            upper.model().save_position(upper_state);
+            upper.edge_prior().save_state(upper_state);
+            lower.model().restore_position(upper_state);
+            lower.edge_prior().restore_state(upper_state);
+            upper.model().restore_position(lower_state);
+            upper.edge_prior().restore_state(lower_state);
+            lower.sampler().target_changed();
+            upper.sampler().target_changed();
+        }
+        running = true;
+    }
+    return running;
+}
+
+
+void BatchChainRunner::operator()(std::size_t begin, std::size_t end) {
+    for (std::size_t t = begin; t < end; ++t) {
+        try {
+            auto chain_model = models_[t / no_chains_]->clone();
+            auto chain_edge_prior = edge_prior_.clone();
+            chain_model->set_gradient_threads(gradient_threads_);
+            chain_model->set_rng(rngs_[t]);
+            run_mcmc_chain(results_[t], *chain_model, *chain_edge_prior, config_,
+                           static_cast<int>(t), pm_);
+        } catch (...) {
+            record_chain_error(results_[t], std::current_exception());
+        }
+    }
+}
+
+
+void reserve_chain_results(
+    std::vector<ChainResult>& results,
     BaseModel& model,
     BaseEdgePrior& edge_prior,
-    const SamplerConfig& config,
-    const int no_chains,
-    const int no_threads,
-    ProgressManager& pm
+    const SamplerConfig& config
 ) {
     const SamplerSpec spec = resolve_sampler_spec(config.sampler_type);
     const bool has_nuts_diag = spec.nuts_diag;
     const bool has_am_diag = spec.am_diag;
     const bool has_sbm_alloc = edge_prior.has_allocations() ||
-        (config.edge_selection && dynamic_cast<StochasticBlockEdgePrior*>(&edge_prior) != nullptr);
+        (config.edge_selection && edge_prior.tracks_allocations());
 
-    std::vector<ChainResult> results(no_chains);
-    for (int c = 0; c < no_chains; ++c) {
-        results[c].reserve(model.storage_dimension(), config.no_iter);
+    const size_t n_edges = config.edge_selection
+        ? model.get_vectorized_indicator_parameters().n_elem : 0;
+    const size_t n_stored = static_cast<size_t>(config.stored_iter());
+    // Batches of about sqrt(n) draws: both the batch length and the number
+    // of batches grow with the run, as the batch-means estimator needs.
+    const size_t batch_size = static_cast<size_t>(std::sqrt(static_cast<double>(config.no_iter)));
+
+    for (int c = 0; c < static_cast<int>(results.size()); ++c) {
+
+        if (!config.sample_dir.empty()) {
+            std::unique_ptr<SampleSink<arma::sword>> indicator_sink;
+            if (config.edge_selection) {
+                indicator_sink = std::make_unique<ChunkedFileSink<arma::sword>>(
+                    sample_file_path(config.sample_dir, c + 1, "indicators"),
+                    n_edges, config.sample_buffer_bytes);
+            }
+            results[c].stream_samples_to(
+                std::make_unique<ChunkedFileSink<double>>(
+                    sample_file_path(config.sample_dir, c + 1, "samples"),
+                    model.storage_dimension(), config.sample_buffer_bytes),
+                std::move(indicator_sink));
+        }
+
+        results[c].reserve(model.storage_dimension(), n_stored, config.single_precision_traces);
 
         if (config.edge_selection) {
-            size_t n_edges = model.get_vectorized_indicator_parameters().n_elem;
-            results[c].reserve_indicators(n_edges, config.no_iter);
+            results[c].reserve_indicators(n_edges, n_stored);
         }
 
         if (has_sbm_alloc) {
-            results[c].reserve_allocations(model.get_num_variables(), config.no_iter);
+            results[c].reserve_allocations(model.get_num_variables(), n_stored);
         }
 
         if (has_nuts_diag) {
-            results[c].reserve_nuts_diagnostics(config.no_iter);
+            results[c].reserve_nuts_diagnostics(n_stored, config.single_precision_traces);
         }
 
         if (has_am_diag) {
-            results[c].reserve_am_diagnostics(config.no_iter);
+            results[c].reserve_am_diagnostics(n_stored);
+        }
+
+        if (model.uses_subsampling()) {
+            results[c].reserve_subsample_diagnostics(n_stored);
+        }
+
+        if (config.online_summary != "none") {
+            results[c].reserve_online_summary(
+                model.storage_dimension(), n_edges,
+                config.online_summary == "coinclusion", batch_size);
+        }
+
+        if (config.predictive_checks.enabled) {
+            results[c].reserve_predictive_checks(config.predictive_checks);
         }
     }
+}
+
+
+std::vector<ChainResult> run_mcmc_sampler(
+    BaseModel& model,
+    BaseEdgePrior& edge_prior,
+    const SamplerConfig& config,
+    const int no_chains,
+    const int no_threads,
+    ProgressManager& pm,
+    const std::vector<SamplerState>& warm_start
+) {
+    const SamplerSpec spec = resolve_sampler_spec(config.sampler_type);
+    const size_t n_stored = static_cast<size_t>(config.stored_iter());
+
+    std::vector<ChainResult> results(no_chains);
+    reserve_chain_results(results, model, edge_prior, config);
+
+    // The chains queue their telemetry; the progress reporter writes it
+    if (config.telemetry.enabled) pm.start_telemetry(config.telemetry);
+
+    // A worker runs one batch of chains at a time, so the batches are what
+    // run concurrently; without convergence checks or batched gradients a
+    // batch is one chain
+    int chain_batch = 1;
+
+    // The convergence checks compare the chains while they run, so every
+    // chain must be running: the chains are spread evenly over the workers
+    // in lockstep batches, and all chains form one batch without threads
+    std::unique_ptr<ConvergenceMonitor> monitor;
+    if (config.convergence.enabled) {
+        if (!config.sample_dir.empty()) {
+            Rcpp::stop("Convergence checks need the draws in memory; they cannot be combined with sample_dir.");
+        }
+        if (config.single_precision_traces) {
+            Rcpp::stop("Convergence checks need double-precision draws; they cannot be combined with single-precision traces.");
+        }
+        std::vector<const double*> samples(no_chains);
+        for (int c = 0; c < no_chains; ++c) samples[c] = results[c].samples.view().memptr();
+        monitor = std::make_unique<ConvergenceMonitor>(
+            config.convergence, std::move(samples),
+            static_cast<int>(model.storage_dimension()), static_cast<int>(n_stored));
+        chain_batch = lockstep_chain_batch(no_chains, no_threads);
+    }
+
+    // Adaptive-HMC trajectories have the same length on every chain, so
+    // the chains a worker would run one after another can instead run in
+    // lockstep and evaluate their gradients together
+    const bool batch_gradients = spec.kind == SamplerKind::AdaptiveHMC &&
+        model.supports_batched_gradient();
+    if (batch_gradients && no_chains > std::max(1, no_threads)) {
+        chain_batch = lockstep_chain_batch(no_chains, no_threads);
+    }
+
+    const int no_batches = (no_chains + chain_batch - 1) / chain_batch;
+    const int gradient_threads =
+        resolve_gradient_threads(config.threads_per_chain, no_batches, no_threads);
+
+    // One long-jump-spaced stream per chain, so a chain's draws depend on
+    // the seed and its index only. A warm-started chain instead continues
+    // its saved stream, from the saved model and edge-prior state.
+    const std::vector<SafeRNG> chain_rngs = rng_streams(config.seed, no_chains);
+    const bool warm = !warm_start.empty();
+    auto prepare_chain = [&](BaseModel& chain_model, BaseEdgePrior& chain_edge_prior, int c) {
+        if (!warm) {
+            chain_model.set_rng(chain_rngs[c]);
+            return;
+        }
+        SafeRNG rng;
+        rng.set_state(warm_start[c].rng);
+        chain_model.set_rng(rng);
+        chain_model.restore_state(warm_start[c]);
+        chain_edge_prior.restore_state(warm_start[c]);
+    };
+
+    // Pooled warmup runs the chains up to each Stage-2 window end in turn
+    // and pools the windows there, on the thread running run_phases, after
+    // run_chains has joined all chain tasks; otherwise one call runs them
+    // to the end
+    const bool pooled = config.pooled_warmup &&
+        (spec.kind == SamplerKind::NUTS || spec.kind == SamplerKind::NUTSIterative);
+    auto run_phases = [&](MCMCChainRunner& runner, auto&& run_chains) {
+        if (pooled) {
+            const WarmupSchedule schedule(config.no_warmup, config.edge_selection, spec.learn_sd);
+            for (int window_end : schedule.window_ends) {
+                runner.run_until_ = window_end;
+                run_chains();
+                pool_warmup_window(runner);
+            }
+            runner.run_until_ = std::numeric_limits<int>::max();
+        }
+        run_chains();
+    };
+
+    if (config.tempering.enabled) {
+        if (!model.supports_tempering()) {
+            Rcpp::stop("Parallel tempering is available for ordinal and Blume-Capel MRFs only.");
+        }
+        if (config.na_impute && model.has_missing_data()) {
+            Rcpp::stop("Parallel tempering cannot be combined with missing-data imputation.");
+        }
+        if (pooled) {
+            Rcpp::stop("Parallel tempering cannot be combined with pooled warmup.");
+        }
+        if (model.uses_subsampling()) {
+            Rcpp::stop("Parallel tempering cannot be combined with subsampling.");
+        }
+
+        // Replica k of chain c is slot k * no_chains + c. The cold replicas
+        // use the chain streams of an untempered run; the hot replicas and
+        // the swaps draw from streams after those.
+        const arma::vec beta = tempering_ladder(config.tempering);
+        const int replicas = static_cast<int>(beta.n_elem);
+        const int slots = no_chains * replicas;
+        const std::vector<SafeRNG> streams =
+            rng_streams(config.seed, static_cast<std::size_t>(slots + no_chains));
+        const int replica_threads =
+            resolve_gradient_threads(config.threads_per_chain, slots, no_threads);
 
-    if (no_threads > 1) {
         std::vector<std::unique_ptr<BaseModel>> models;
         std::vector<std::unique_ptr<BaseEdgePrior>> edge_priors;
-        models.reserve(no_chains);
-        edge_priors.reserve(no_chains);
+        models.reserve(slots);
+        edge_priors.reserve(slots);
+        for (int slot = 0; slot < slots; ++slot) {
+            const int c = slot % no_chains;
+            models.push_back(model.clone());
+            models[slot]->set_gradient_threads(replica_threads);
+            edge_priors.push_back(edge_prior.clone());
+            prepare_chain(*models[slot], *edge_priors[slot], c);
+            if (slot >= no_chains) models[slot]->set_rng(streams[slot]);
+            models[slot]->set_temperature(beta(slot / no_chains));
+        }
+        std::vector<SafeRNG> swap_rngs(streams.begin() + slots, streams.end());
+
+        TemperedChainRunner runner(results, models, edge_priors, config, pm, warm_start,
+                                   std::move(swap_rngs), monitor.get());
+        auto run_replicas = [&] {
+            if (no_threads > 1) {
+                parallel_for_tasks(static_cast<size_t>(slots), runner, 1);
+            } else {
+                runner(0, static_cast<size_t>(slots));
+            }
+        };
+        auto run_rounds = [&] {
+            const int total_iter = config.no_warmup + config.no_iter;
+            const int swap_every = std::max(1, config.tempering.swap_every);
+            for (int round = 0; ; ++round) {
+                runner.run_until_ = std::min(total_iter, (round + 1) * swap_every);
+                run_replicas();
+                if (!runner.swap(round) || runner.run_until_ >= total_iter) break;
+            }
+        };
+        if (no_threads > 1) {
+            pm.run_with_reporter([&] { run_in_arena(no_threads, run_rounds); });
+        } else {
+            run_rounds();
+        }
+
+    } else if (no_threads > 1) {
+        // With "main" placement every chain is cloned here; otherwise on
+        // the worker thread that runs it. The draws need no such care: R
+        // leaves their storage untouched until the chain writes to it.
+        std::vector<std::unique_ptr<BaseModel>> models(no_chains);
+        std::vector<std::unique_ptr<BaseEdgePrior>> edge_priors(no_chains);
+        const bool replicate = config.chain_placement == "replicate";
+        auto setup_chain = [&](std::size_t c) {
+            models[c] = model.clone();
+            if (replicate) models[c]->replicate_shared_data();
+            models[c]->set_gradient_threads(gradient_threads);
+            edge_priors[c] = edge_prior.clone();
+            prepare_chain(*models[c], *edge_priors[c], static_cast<int>(c));
+        };
+
+        MCMCChainRunner runner(results, models, edge_priors, config, pm, warm_start,
+                               chain_batch, monitor.get(), batch_gradients);
+        if (config.chain_placement == "main") {
+            for (int c = 0; c < no_chains; ++c) setup_chain(static_cast<std::size_t>(c));
+        } else {
+            runner.setup_ = setup_chain;
+        }
+        pm.run_with_reporter([&] {
+            run_in_arena(no_threads, [&] {
+                run_phases(runner, [&] {
+                    parallel_for_tasks(static_cast<size_t>(no_chains), runner,
+                                       static_cast<size_t>(chain_batch));
+                });
+            });
+        });
+
+    } else if (pooled) {
+        // Sequential pooled warmup: every chain must reach each window end
+        // before any chain goes on, so all chains are cloned at once
+        std::vector<std::unique_ptr<BaseModel>> models;
+        std::vector<std::unique_ptr<BaseEdgePrior>> edge_priors;
         for (int c = 0; c < no_chains; ++c) {
             models.push_back(model.clone());
-            models[c]->set_seed(config.seed + c);
             edge_priors.push_back(edge_prior.clone());
+            prepare_chain(*models[c], *edge_priors[c], c);
         }
+        MCMCChainRunner runner(results, models, edge_priors, config, pm, warm_start,
+                               chain_batch, monitor.get(), batch_gradients);
+        run_phases(runner, [&] {
+            for (int b0 = 0; b0 < no_chains; b0 += chain_batch) {
+                runner(static_cast<size_t>(b0),
+                       static_cast<size_t>(std::min(no_chains, b0 + chain_batch)));
+            }
+        });
 
-        MCMCChainRunner runner(results, models, edge_priors, config, pm);
-        tbb::global_control control(tbb::global_control::max_allowed_parallelism, no_threads);
-        RcppParallel::parallelFor(0, static_cast<size_t>(no_chains), runner);
+    } else if (monitor || chain_batch > 1) {
+        // Sequential lockstep: clone one batch of chains at a time
+        for (int b0 = 0; b0 < no_chains; b0 += chain_batch) {
+            const int b1 = std::min(no_chains, b0 + chain_batch);
+            std::vector<std::unique_ptr<BaseModel>> models(no_chains);
+            std::vector<std::unique_ptr<BaseEdgePrior>> edge_priors(no_chains);
+            for (int c = b0; c < b1; ++c) {
+                models[c] = model.clone();
+                edge_priors[c] = edge_prior.clone();
+                prepare_chain(*models[c], *edge_priors[c], c);
+            }
+            MCMCChainRunner runner(results, models, edge_priors, config, pm, warm_start,
+                                   chain_batch, monitor.get(), batch_gradients);
+            runner(static_cast<size_t>(b0), static_cast<size_t>(b1));
+        }
 
     } else {
-        model.set_seed(config.seed);
         for (int c = 0; c < no_chains; ++c) {
             auto chain_model = model.clone();
-            chain_model->set_seed(config.seed + c);
             auto chain_edge_prior = edge_prior.clone();
-            run_mcmc_chain(results[c], *chain_model, *chain_edge_prior, config, c, pm);
+            prepare_chain(*chain_model, *chain_edge_prior, c);
+            run_mcmc_chain(results[c], *chain_model, *chain_edge_prior, config, c, pm,
+                           warm ? &warm_start[c] : nullptr);
+        }
+    }
+
+    // Keep the draws up to the check that stopped the run
+    if (monitor) {
+        monitor->finish();
+        const ConvergenceReport& report = monitor->report();
+        for (ChainResult& chain : results) {
+            if (report.stopped_early && !chain.error) {
+                chain.truncate(static_cast<size_t>(report.draws));
+            }
+            chain.convergence = report;
+            chain.has_convergence = true;
+        }
+    }
+
+    return results;
+}
+
+
+std::vector<ChainResult> run_mcmc_batch(
+    const std::vector<std::unique_ptr<BaseModel>>& models,
+    const BaseEdgePrior& edge_prior,
+    const SamplerConfig& config,
+    const std::vector<int>& seeds,
+    const int no_chains,
+    const int no_threads,
+    ProgressManager& pm
+) {
+    if (config.online_summary == "none") {
+        Rcpp::stop("Batch fits keep running summaries only; online_summary cannot be \"none\".");
+    }
+    if (config.convergence.enabled || config.pooled_warmup || config.tempering.enabled) {
+        Rcpp::stop("Batch fits cannot be combined with convergence checks, pooled warmup or tempering.");
+    }
+
+    const std::size_t chains = static_cast<std::size_t>(no_chains);
+    const std::size_t tasks = models.size() * chains;
+    const size_t batch_size = static_cast<size_t>(std::sqrt(static_cast<double>(config.no_iter)));
+
+    // Reserve on the main thread: the summaries only, as the traces go to
+    // discard sinks
+    std::vector<ChainResult> results(tasks);
+    std::vector<SafeRNG> rngs;
+    rngs.reserve(tasks);
+    for (std::size_t d = 0; d < models.size(); ++d) {
+        BaseModel& model = *models[d];
+        const size_t n_edges = config.edge_selection
+            ? model.get_vectorized_indicator_parameters().n_elem : 0;
+        const std::vector<SafeRNG> streams = rng_streams(seeds[d], chains);
+        for (std::size_t c = 0; c < chains; ++c) {
+            ChainResult& result = results[d * chains + c];
+            std::unique_ptr<SampleSink<arma::sword>> indicator_sink;
+            if (config.edge_selection) {
+                indicator_sink = std::make_unique<DiscardSink<arma::sword>>();
+            }
+            result.stream_samples_to(std::make_unique<DiscardSink<double>>(),
+                                     std::move(indicator_sink));
+            if (config.edge_selection) {
+                result.reserve_indicators(n_edges, 0);
+            }
+            result.reserve_online_summary(
+                model.storage_dimension(), n_edges,
+                config.online_summary == "coinclusion", batch_size);
+            rngs.push_back(streams[c]);
         }
     }
 
+    const int gradient_threads = resolve_gradient_threads(
+        config.threads_per_chain, static_cast<int>(tasks), no_threads);
+    BatchChainRunner runner(results, models, edge_prior, config, pm, rngs,
+                            chains, gradient_threads);
+    if (no_threads > 1) {
+        pm.run_with_reporter([&] {
+            run_in_arena(no_threads, [&] { parallel_for_tasks(tasks, runner, 1); });
+        });
+    } else {
+        runner(0, tasks);
+    }
+
     return results;
 }
 
@@ -232,28 +1091,66 @@ Rcpp::List convert_results_to_list(const std::vector<ChainResult>& results) {
             chain_list["error_msg"] = chain.error_msg;
         } else {
             chain_list["error"] = false;
-            chain_list["samples"] = chain.samples;
+            if (chain.sample_sink) {
+                chain_list["samples_file"] = chain.sample_sink->path();
+            } else {
+                chain_list["samples"] = chain.samples.sexp();
+            }
             chain_list["userInterrupt"] = chain.userInterrupt;
 
             if (chain.has_indicators) {
-                chain_list["indicator_samples"] = chain.indicator_samples;
+                if (chain.indicator_sink) {
+                    chain_list["indicator_samples_file"] = chain.indicator_sink->path();
+                } else {
+                    chain_list["indicator_trace"] = chain.indicator_samples.to_list();
+                }
+            }
+
+            if (chain.has_online_summary) {
+                chain_list["online_summary"] = chain.online_summary.to_list();
+            }
+            if (chain.has_predictive_checks) {
+                chain_list["predictive_checks"] = chain.predictive_checks.to_list();
             }
 
             if (chain.has_allocations) {
-                chain_list["allocation_samples"] = chain.allocation_samples;
+                chain_list["allocation_samples"] = chain.allocation_samples.sexp();
             }
 
             if (chain.has_nuts_diagnostics) {
-                chain_list["treedepth"] = chain.treedepth_samples;
-                chain_list["divergent"] = chain.divergent_samples;
-                chain_list["non_reversible"] = chain.non_reversible_samples;
-                chain_list["energy"] = chain.energy_samples;
-                chain_list["accept_prob"] = chain.accept_prob_samples;
+                chain_list["treedepth"] = chain.treedepth_samples.sexp();
+                chain_list["divergent"] = chain.divergent_samples.sexp();
+                chain_list["non_reversible"] = chain.non_reversible_samples.sexp();
+                chain_list["energy"] = chain.energy_samples.sexp();
+                chain_list["accept_prob"] = chain.accept_prob_samples.sexp();
+                chain_list["arena_allocations"] = chain.arena_allocation_samples.sexp();
             }
 
             if (chain.has_am_diagnostics) {
-                chain_list["am_accept_prob"] = chain.am_accept_prob_samples;
+                chain_list["am_accept_prob"] = chain.am_accept_prob_samples.sexp();
+            }
+
+            if (chain.has_subsample_diagnostics) {
+                chain_list["subsample_variance"] = chain.subsample_variance_samples.sexp();
             }
+
+            chain_list["sampler_state"] = chain.final_state.to_list();
+
+            if (chain.has_convergence) {
+                chain_list["convergence"] = chain.convergence.to_list();
+            }
+
+            if (chain.has_tempering) {
+                chain_list["tempering"] = chain.tempering.to_list();
+            }
+
+            if (chain.warmup_schedule) {
+                chain_list["warmup_schedule"] = warmup_schedule_to_list(*chain.warmup_schedule);
+            }
+
+#if BGMS_USE_PROFILE
+            chain_list["profile"] = chain.profile.to_list();
+#endif
         }
 
         output[i] = chain_list;
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <limits>
 #include <vector>
 #include <memory>
 #include <RcppArmadillo.h>
@@ -7,15 +11,19 @@
 
 #include "models/base_model.h"
 #include "mcmc/execution/chain_result.h"
+#include "mcmc/execution/convergence_monitor.h"
+#include "mcmc/execution/parallel_tempering.h"
 #include "priors/edge_prior.h"
 #include "utils/progress_manager.h"
 #include "mcmc/execution/sampler_config.h"
+#include "mcmc/execution/sampler_state.h"
+#include "mcmc/execution/telemetry.h"
 #include "mcmc/samplers/sampler_base.h"
 #include "mcmc/execution/warmup_schedule.h"
 
 
 /** Which concrete sampler a run uses. */
-enum class SamplerKind { NUTS, AdaptiveMetropolis };
+enum class SamplerKind { NUTS, NUTSIterative, AdaptiveHMC, AdaptiveMetropolis, SGLD, PolyaGamma };
 
 /**
  * Behavioral descriptor for a sampler type. resolve_sampler_spec is the single
@@ -24,15 +32,16 @@ enum class SamplerKind { NUTS, AdaptiveMetropolis };
  */
 struct SamplerSpec {
     SamplerKind kind;
-    bool learn_sd;    ///< NUTS dual-averaging step-size adaptation during warmup
-    bool nuts_diag;   ///< reserve/store NUTS per-iteration diagnostics
+    bool learn_sd;    ///< HMC/NUTS dual-averaging step-size adaptation during warmup
+    bool nuts_diag;   ///< reserve/store NUTS per-iteration diagnostics (also adaptive HMC)
     bool am_diag;     ///< reserve/store adaptive-Metropolis diagnostics
 };
 
 /**
  * Decode a sampler-type string into a SamplerSpec.
  *
- * @param sampler_type  "nuts" or "adaptive-metropolis".
+ * @param sampler_type  "nuts", "nuts-iterative", "adaptive-hmc",
+ *                      "adaptive-metropolis", "sgld" or "polya-gamma".
  * @return Descriptor with the concrete kind and its derived behavior flags.
  */
 SamplerSpec resolve_sampler_spec(const std::string& sampler_type);
@@ -56,6 +65,12 @@ std::unique_ptr<SamplerBase> create_sampler(SamplerKind kind, const SamplerConfi
  * @param config        Sampler configuration
  * @param chain_id      Chain identifier (0-based)
  * @param pm            Progress manager for user-facing status updates
+ * @param warm_start    Saved state whose sampler tuning the chain reuses, or
+ *                      null for a cold start (the model, edge prior and RNG
+ *                      are restored by the caller)
+ *
+ * The chain's state when it stops, interrupted or not, is saved in
+ * chain_result.final_state.
  */
 void run_mcmc_chain(
     ChainResult& chain_result,
@@ -63,15 +78,138 @@ void run_mcmc_chain(
     BaseEdgePrior& edge_prior,
     const SamplerConfig& config,
     int chain_id,
-    ProgressManager& pm
+    ProgressManager& pm,
+    const SamplerState* warm_start = nullptr
 );
 
 
+/**
+ * ChainExecution - One chain's sampler, warmup schedule and loop position
+ *
+ * run_mcmc_chain() drives one execution from the first iteration to the
+ * last. In lockstep mode (convergence checks, or adaptive HMC on more
+ * chains than threads, see run_mcmc_sampler()) a worker holds a batch of
+ * executions and advances each by one iteration in turn, so all chains
+ * are running when the checks compare them. Every chain keeps its own
+ * model, RNG stream and profile, so its draws do not depend on the
+ * batching, up to the rounding of gradients the batch evaluates together.
+ *
+ * With a ConvergenceMonitor, the execution reports each stored draw to it
+ * and stops after the iteration in which the monitor asks the chains to.
+ * The hot replicas of a tempered chain (see TemperedChainRunner) are
+ * executions that store no draws and report no progress.
+ *
+ * The sampler keeps a reference to the schedule, so an execution is
+ * neither copied nor moved.
+ */
+class ChainExecution {
+public:
+    /**
+     * Same arguments as run_mcmc_chain(), plus the run's convergence
+     * monitor (null for none) and whether the execution stores its draws
+     * (false for a hot replica); initializes the sampler.
+     */
+    ChainExecution(
+        ChainResult& chain_result,
+        BaseModel& model,
+        BaseEdgePrior& edge_prior,
+        const SamplerConfig& config,
+        int chain_id,
+        ProgressManager& pm,
+        const SamplerState* warm_start = nullptr,
+        ConvergenceMonitor* monitor = nullptr,
+        bool store_draws = true
+    );
+
+    /** Detaches the edge prior from the model. */
+    ~ChainExecution();
+
+    ChainExecution(const ChainExecution&) = delete;
+    ChainExecution& operator=(const ChainExecution&) = delete;
+
+    /**
+     * Run the next iteration. After the last iteration, when the user
+     * interrupts, or when the convergence monitor stops the run, flushes
+     * the sinks and saves the chain's state.
+     * @return Whether the chain has iterations left
+     */
+    bool step();
+
+    /**
+     * step() in parts, for a runner that advances the samplers of several
+     * chains together (see MCMCChainRunner): begin_step() runs the work
+     * before the sampler step (imputation, edge updates), sample() the
+     * sampler step itself, and finish_step() the work after it, from the
+     * sampler's result.
+     * @return begin_step(): whether the chain runs this iteration;
+     *         finish_step(): whether the chain has iterations left
+     */
+    bool begin_step();
+    StepResult sample();
+    bool finish_step(StepResult result);
+
+    /** @return Whether the chain has stopped (finished or interrupted). */
+    bool done() const { return done_; }
+
+    /** @return Iterations run so far (warmup included). */
+    int iteration() const { return iter_; }
+
+    /**
+     * The chain's sampler, model and edge prior, for the pooled warmup
+     * windows and the replica swaps.
+     */
+    SamplerBase& sampler() { return *sampler_; }
+    BaseModel& model() { return model_; }
+    BaseEdgePrior& edge_prior() { return edge_prior_; }
+
+private:
+    void finish();
+    /** Queue a telemetry record of the iterations since the last one. */
+    void report_telemetry(bool done);
+
+    ChainResult& chain_result_;
+    BaseModel& model_;
+    BaseEdgePrior& edge_prior_;
+    const SamplerConfig& config_;
+    const int chain_id_;
+    ProgressManager& pm_;
+    ConvergenceMonitor* monitor_;
+    const bool store_draws_;
+    WarmupSchedule schedule_;
+    std::unique_ptr<SamplerBase> sampler_;
+    const int total_iter_;
+    int iter_ = 0;
+    /// Warm-up iterations dropped by an early end of Stage 2.
+    int warmup_skipped_ = 0;
+    /// Live metrics of the chain (null without telemetry or for a hot replica).
+    std::unique_ptr<TelemetryProbe> telemetry_;
+    bool done_ = false;
+};
+
+
 /**
  * MCMCChainRunner - TBB worker for parallel chain execution
  *
- * Each chain gets its own model clone and edge prior. The worker dispatches
- * chains to threads via RcppParallel::parallelFor.
+ * Each chain gets its own model clone and edge prior, with the model's RNG
+ * already set to the chain's stream. The chains are dispatched through
+ * parallel_for_tasks() inside a task arena of the run's thread budget,
+ * which the chains' gradient kernels share; the worker runs the chains of
+ * its range in lockstep batches of `chain_batch` (see ChainExecution).
+ *
+ * With `batch_gradients`, the adaptive-HMC chains of a batch also share
+ * their gradient evaluations: each iteration runs their trajectories
+ * through one hmc_step_batch() call, whose evaluations go to the lead
+ * model's BaseModel::logp_and_gradient_batch(). Chains that cannot join
+ * (constrained integration) step on their own in between.
+ *
+ * The runner keeps the chains' executions, and a call advances each chain
+ * only up to iteration `run_until_`. With pooled warmup, the caller runs
+ * the chains to each Stage-2 window end in turn, pools the windows, and
+ * then runs them to the end.
+ *
+ * A chain whose model slot is still empty is built by `setup_(i)` on the
+ * worker thread that first reaches it (SamplerConfig::chain_placement), so
+ * its model clone is first touched on that thread's memory node.
  */
 struct MCMCChainRunner : public RcppParallel::Worker {
     std::vector<ChainResult>& results_;
@@ -79,34 +217,247 @@ struct MCMCChainRunner : public RcppParallel::Worker {
     std::vector<std::unique_ptr<BaseEdgePrior>>& edge_priors_;
     const SamplerConfig& config_;
     ProgressManager& pm_;
+    const std::vector<SamplerState>& warm_start_;
+    const int chain_batch_;
+    ConvergenceMonitor* monitor_;
+    /// Whether the chains of a batch share their gradient evaluations.
+    const bool batch_gradients_;
+    /// Each chain's execution, created by the first call that reaches it.
+    std::vector<std::unique_ptr<ChainExecution>> executions_;
+    /// Iteration at which a call stops advancing the chains.
+    int run_until_ = std::numeric_limits<int>::max();
+    /// Fills models_[i] and edge_priors_[i] for a chain without a model.
+    std::function<void(std::size_t)> setup_;
 
     MCMCChainRunner(
         std::vector<ChainResult>& results,
         std::vector<std::unique_ptr<BaseModel>>& models,
         std::vector<std::unique_ptr<BaseEdgePrior>>& edge_priors,
         const SamplerConfig& config,
-        ProgressManager& pm
+        ProgressManager& pm,
+        const std::vector<SamplerState>& warm_start,
+        int chain_batch = 1,
+        ConvergenceMonitor* monitor = nullptr,
+        bool batch_gradients = false
     ) :
         results_(results),
         models_(models),
         edge_priors_(edge_priors),
         config_(config),
-        pm_(pm)
+        pm_(pm),
+        warm_start_(warm_start),
+        chain_batch_(std::max(1, chain_batch)),
+        monitor_(monitor),
+        batch_gradients_(batch_gradients),
+        executions_(results.size())
     {}
 
     void operator()(std::size_t begin, std::size_t end);
+
+private:
+    /** Whether chain i runs another iteration in this call. */
+    bool runnable(std::size_t i) const;
+    /** Record the error of chain i and drop its execution. */
+    void fail(std::size_t i, const std::exception_ptr& error);
+    /** Advance chains [b0, b1) by one iteration each, in turn. */
+    bool step_in_turn(std::size_t b0, std::size_t b1);
+    /** Same, with the adaptive-HMC chains stepping through hmc_step_batch(). */
+    bool step_together(std::size_t b0, std::size_t b1);
 };
 
 
+/**
+ * TemperedChainRunner - TBB worker for parallel tempering
+ *
+ * Every chain runs `replicas` executions, replica k on a model tempered to
+ * inverse temperature beta_k of tempering_ladder(); replica 0, at beta = 1,
+ * is the chain itself and the only one that stores draws. Slot
+ * k * no_chains + c holds replica k of chain c, and parallel_for_tasks()
+ * spreads the slots over the threads of the run's task arena.
+ *
+ * A call advances every slot of the active chains up to iteration
+ * `run_until_` and records the untempered log-pseudolikelihood of its
+ * state. swap() then runs, on the thread driving the rounds and after all
+ * slots have returned, one round of propose_replica_swaps() per chain,
+ * from the chain's own swap stream, and exchanges the model positions
+ * (BaseModel::save_position) and edge-prior states of the accepted pairs. Each replica keeps all of its tuning, so
+ * the step size, mass matrix, proposal SDs, surrogate curvature, block
+ * proposals and informed edge rates stay adapted to its temperature. A
+ * chain stops with its cold replica; when any replica fails, the chain
+ * fails with it.
+ */
+struct TemperedChainRunner : public RcppParallel::Worker {
+    std::vector<ChainResult>& results_;
+    /// Results of the hot replicas: errors and final states only.
+    std::vector<ChainResult> replica_results_;
+    std::vector<std::unique_ptr<BaseModel>>& models_;
+    std::vector<std::unique_ptr<BaseEdgePrior>>& edge_priors_;
+    const SamplerConfig& config_;
+    ProgressManager& pm_;
+    const std::vector<SamplerState>& warm_start_;
+    ConvergenceMonitor* monitor_;
+    const arma::vec beta_;
+    const std::size_t no_chains_;
+    std::vector<SafeRNG> swap_rngs_;
+    std::vector<std::unique_ptr<ChainExecution>> executions_;
+    std::vector<double> log_pl_;
+    std::vector<char> active_;
+    /// Iteration at which a call stops advancing the replicas.
+    int run_until_ = std::numeric_limits<int>::max();
+
+    /**
+     * @param models       One model per slot, hot ones already tempered
+     * @param edge_priors  One edge prior per slot
+     * @param swap_rngs    One swap stream per chain
+     * (other arguments as for MCMCChainRunner)
+     */
+    TemperedChainRunner(
+        std::vector<ChainResult>& results,
+        std::vector<std::unique_ptr<BaseModel>>& models,
+        std::vector<std::unique_ptr<BaseEdgePrior>>& edge_priors,
+        const SamplerConfig& config,
+        ProgressManager& pm,
+        const std::vector<SamplerState>& warm_start,
+        std::vector<SafeRNG> swap_rngs,
+        ConvergenceMonitor* monitor = nullptr
+    );
+
+    void operator()(std::size_t begin, std::size_t end);
+
+    /**
+     * Swap round `round` for every active chain; retires the chains that
+     * have stopped or failed.
+     * @return Whether any chain is still running
+     */
+    bool swap(int round);
+
+private:
+    ChainResult& slot_result(std::size_t slot) {
+        return slot < no_chains_ ? results_[slot] : replica_results_[slot - no_chains_];
+    }
+    void fail_chain(std::size_t chain);
+};
+
+
+/**
+ * BatchChainRunner - TBB worker for the chains of many datasets
+ *
+ * Task t runs chain t % no_chains of dataset t / no_chains from start to
+ * end: it clones that dataset's model and the edge prior, seeds the clone
+ * with its stream and frees both when the chain is done, so memory holds
+ * one model per running task. parallel_for_tasks() hands out single
+ * tasks, so idle threads steal the remaining chains of any dataset.
+ */
+struct BatchChainRunner : public RcppParallel::Worker {
+    std::vector<ChainResult>& results_;
+    const std::vector<std::unique_ptr<BaseModel>>& models_;
+    const BaseEdgePrior& edge_prior_;
+    const SamplerConfig& config_;
+    ProgressManager& pm_;
+    const std::vector<SafeRNG>& rngs_;
+    const std::size_t no_chains_;
+    const int gradient_threads_;
+
+    BatchChainRunner(
+        std::vector<ChainResult>& results,
+        const std::vector<std::unique_ptr<BaseModel>>& models,
+        const BaseEdgePrior& edge_prior,
+        const SamplerConfig& config,
+        ProgressManager& pm,
+        const std::vector<SafeRNG>& rngs,
+        std::size_t no_chains,
+        int gradient_threads
+    ) :
+        results_(results),
+        models_(models),
+        edge_prior_(edge_prior),
+        config_(config),
+        pm_(pm),
+        rngs_(rngs),
+        no_chains_(no_chains),
+        gradient_threads_(gradient_threads)
+    {}
+
+    void operator()(std::size_t begin, std::size_t end);
+};
+
+
+/**
+ * Resolve the per-chain gradient thread count
+ *
+ * Never exceeds the total thread budget: with no_threads == 1 every chain
+ * runs serially. A request of 0 splits the budget evenly over the chains
+ * that run concurrently.
+ *
+ * @param threads_per_chain  Requested threads per chain (0 = auto)
+ * @param no_chains          Number of chains
+ * @param no_threads         Total thread budget
+ * @return Number of threads each chain's gradient may use (>= 1)
+ */
+int resolve_gradient_threads(int threads_per_chain, int no_chains, int no_threads);
+
+
+/**
+ * Number of chains one worker advances in lockstep when every chain must be
+ * running at once: the chains spread evenly over the threads when there
+ * are more chains than threads, otherwise 1
+ *
+ * @param no_chains   Number of chains
+ * @param no_threads  Total thread budget
+ * @return Batch size, between 1 and no_chains
+ */
+int lockstep_chain_batch(int no_chains, int no_threads);
+
+
+/**
+ * Reserve the draw and diagnostic storage of every chain of a run
+ *
+ * Sizes each result for config.stored_iter() draws of the traces the
+ * sampler, model and edge prior produce, and with config.sample_dir set
+ * opens the chain's sample files instead. Main thread only.
+ *
+ * @param results     One result per chain, indexed by chain
+ * @param model       Model of the chains (any chain or the prototype)
+ * @param edge_prior  Edge prior of the chains
+ * @param config      Sampler configuration
+ */
+void reserve_chain_results(
+    std::vector<ChainResult>& results,
+    BaseModel& model,
+    BaseEdgePrior& edge_prior,
+    const SamplerConfig& config
+);
+
+
 /**
  * Run multi-chain MCMC (parallel or sequential based on thread count)
  *
+ * Each worker runs its chains one after another. With config.convergence
+ * enabled, a ConvergenceMonitor checks the chains as they run and may stop
+ * them early; the workers then advance their chains in lockstep batches of
+ * lockstep_chain_batch() so that all chains run at once, and every chain
+ * keeps the draws up to the stopping check. Adaptive HMC on more chains
+ * than threads runs in the same lockstep batches when the model supports
+ * batched gradients (BaseModel::supports_batched_gradient()), so that the
+ * chains of a batch share their gradient evaluations. With config.pooled_warmup and a NUTS sampler,
+ * the chains stop at the end of every Stage-2 window, where their
+ * diagonal mass-matrix windows and step sizes are pooled (on the thread
+ * driving the chains, between rounds of chain tasks), so all chains
+ * leave warmup with the same tuning. With config.tempering, every chain
+ * runs tempered replicas that swap states every `swap_every` iterations
+ * (see TemperedChainRunner); the model must support tempering. With
+ * config.sample_dir set, each chain streams its parameter (and indicator)
+ * draws to <sample_dir>/chain-<id>-{samples,indicators}.bin through a
+ * ChunkedFileSink instead of holding them in memory.
+ *
  * @param model       Prototype model (cloned per chain)
  * @param edge_prior  Prototype edge prior (cloned per chain)
  * @param config      Sampler configuration
  * @param no_chains   Number of chains to run
  * @param no_threads  Number of threads (1 = sequential)
  * @param pm          Progress manager for user-facing status updates
+ * @param warm_start  One saved state per chain to continue from (see
+ *                    warm_start_states()), or empty for a cold start
  * @return Vector of ChainResult, one per chain
  */
 std::vector<ChainResult> run_mcmc_sampler(
@@ -115,6 +466,38 @@ std::vector<ChainResult> run_mcmc_sampler(
     const SamplerConfig& config,
     int no_chains,
     int no_threads,
+    ProgressManager& pm,
+    const std::vector<SamplerState>& warm_start = {}
+);
+
+/**
+ * Run the chains of many datasets on one thread pool
+ *
+ * Every (dataset, chain) pair is one task of a BatchChainRunner, so the
+ * threads stay busy however few chains each dataset has. The chains keep
+ * running summaries only (config.online_summary must not be "none"):
+ * their draws go to a DiscardSink and no per-iteration diagnostics are
+ * stored. Chain c of dataset d uses stream c of rng_streams(seeds[d]), so
+ * its summaries match a run_mcmc_sampler() call with seed seeds[d].
+ * Convergence checks, pooled warmup, tempering and warm starts are not
+ * available.
+ *
+ * @param models      One prototype model per dataset (cloned per chain)
+ * @param edge_prior  Prototype edge prior (cloned per chain)
+ * @param config      Sampler configuration shared by all datasets
+ * @param seeds       Seed of each dataset
+ * @param no_chains   Chains per dataset
+ * @param no_threads  Number of threads (1 = sequential)
+ * @param pm          Progress manager with one counter per task
+ * @return ChainResult of task d * no_chains + c for chain c of dataset d
+ */
+std::vector<ChainResult> run_mcmc_batch(
+    const std::vector<std::unique_ptr<BaseModel>>& models,
+    const BaseEdgePrior& edge_prior,
+    const SamplerConfig& config,
+    const std::vector<int>& seeds,
+    int no_chains,
+    int no_threads,
     ProgressManager& pm
 );
 
@@ -122,6 +505,11 @@ std::vector<ChainResult> run_mcmc_sampler(
  * Convert chain results to an Rcpp::List for return to R
  *
  * @param results  Vector of completed chain results
- * @return Named list with samples, diagnostics, and metadata
+ * @return Named list with samples, diagnostics, and metadata. Indicator
+ *         draws are returned as an encoded `indicator_trace` (see
+ *         PackedIndicatorTrace::to_list()). Streamed traces are returned as
+ *         `samples_file` / `indicator_samples_file` paths instead. Sample
+ *         and diagnostic matrices are the chains' own R-owned buffers, so
+ *         they are not copied.
  */
 Rcpp::List convert_results_to_list(const std::vector<ChainResult>& results);
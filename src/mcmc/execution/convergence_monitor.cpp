@@ -0,0 +1,138 @@
+#include "mcmc/execution/convergence_monitor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#include "utils/draw_diagnostics.h"
+
+
+ConvergenceMonitor::ConvergenceMonitor(
+    const ConvergenceTarget& target,
+    std::vector<const double*> samples,
+    const int nparam,
+    const int n_stored
+) :
+    target_(target),
+    samples_(std::move(samples)),
+    nparam_(nparam),
+    n_stored_(n_stored),
+    start_(std::chrono::steady_clock::now()),
+    draws_(std::make_unique<std::atomic<int>[]>(samples_.size())),
+    retired_(std::make_unique<std::atomic<bool>[]>(samples_.size())),
+    next_check_(std::max(1, target.check_every))
+{
+    for (size_t c = 0; c < samples_.size(); ++c) {
+        draws_[c].store(0, std::memory_order_relaxed);
+        retired_[c].store(false, std::memory_order_relaxed);
+    }
+}
+
+
+void ConvergenceMonitor::record_draw(const int chain) {
+    // Release: the draw is in the buffer before the count says so
+    const int n = draws_[chain].fetch_add(1, std::memory_order_release) + 1;
+    if (stop_requested()) return;
+
+    const int next = next_check_.load(std::memory_order_relaxed);
+    if (n < next || next > n_stored_ || !all_reached(next)) return;
+
+    // One check at a time; a chain that finds one running carries on
+    if (checking_.exchange(true, std::memory_order_acquire)) return;
+    const int claimed = next_check_.load(std::memory_order_relaxed);
+    if (claimed <= n_stored_ && !stop_requested() && all_reached(claimed)) {
+        check(claimed, /*allow_timeout=*/true);
+        next_check_.store(claimed + std::max(1, target_.check_every),
+                          std::memory_order_relaxed);
+    }
+    checking_.store(false, std::memory_order_release);
+}
+
+
+void ConvergenceMonitor::retire(const int chain) {
+    retired_[chain].store(true, std::memory_order_release);
+}
+
+
+bool ConvergenceMonitor::all_reached(const int n) const {
+    for (size_t c = 0; c < samples_.size(); ++c) {
+        if (retired_[c].load(std::memory_order_acquire)) continue;
+        if (draws_[c].load(std::memory_order_acquire) < n) return false;
+    }
+    return true;
+}
+
+
+void ConvergenceMonitor::check(const int n, const bool allow_timeout) {
+    // The first n draws of each chain: parameter j of draw i is at
+    // samples[i * nparam + j]
+    DrawsView draws;
+    for (size_t c = 0; c < samples_.size(); ++c) {
+        if (!retired_[c].load(std::memory_order_acquire)) draws.chain.push_back(samples_[c]);
+    }
+    if (draws.nchains() == 0) return;
+    draws.niter = n;
+    draws.nparam = nparam_;
+    draws.iter_stride = nparam_;
+    draws.param_stride = 1;
+
+    const int max_order = ess_max_order(n);
+    double max_rhat = -std::numeric_limits<double>::infinity();
+    double min_ess = std::numeric_limits<double>::infinity();
+    for (int j = 0; j < nparam_; ++j) {
+        if (draws.nchains() > 1) {
+            const double rhat = draws_rhat(draws, j, buf_);
+            if (std::isfinite(rhat)) max_rhat = std::max(max_rhat, rhat);
+        }
+        const double ess = draws_ess(draws, j, max_order, buf_, centered_);
+        if (std::isfinite(ess)) min_ess = std::min(min_ess, ess);
+    }
+
+    const bool have_rhat = std::isfinite(max_rhat);
+    const bool have_ess = std::isfinite(min_ess);
+    const double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start_).count();
+
+    report_.checks += 1;
+    report_.draws = n;
+    report_.max_rhat = have_rhat ? max_rhat : NA_REAL;
+    report_.min_ess = have_ess ? min_ess : NA_REAL;
+    report_.elapsed = elapsed;
+    // Parameters without a finite Rhat or ESS (constant traces) are skipped
+    report_.converged = (!have_rhat || max_rhat <= target_.rhat) &&
+                        have_ess && min_ess >= target_.ess;
+
+    const bool timed_out = allow_timeout && target_.max_time > 0.0 &&
+                           elapsed >= target_.max_time;
+    if (n < n_stored_ && (report_.converged || timed_out)) {
+        report_.stopped_early = true;
+        stop_.store(true, std::memory_order_release);
+    }
+}
+
+
+void ConvergenceMonitor::finish() {
+    if (stop_requested()) return;
+
+    int min_draws = n_stored_;
+    bool any_active = false;
+    for (size_t c = 0; c < samples_.size(); ++c) {
+        if (retired_[c].load(std::memory_order_acquire)) continue;
+        any_active = true;
+        min_draws = std::min(min_draws, draws_[c].load(std::memory_order_acquire));
+    }
+    if (!any_active) return;
+
+    // Checks the chains outpaced, in order, as if they had kept up
+    const int step = std::max(1, target_.check_every);
+    for (int n = next_check_.load(std::memory_order_relaxed);
+         n <= min_draws && !stop_requested(); n += step) {
+        check(n, /*allow_timeout=*/false);
+    }
+
+    // Report on all draws of a completed run
+    if (!stop_requested() && min_draws == n_stored_ && report_.draws != n_stored_) {
+        check(n_stored_, /*allow_timeout=*/false);
+    }
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <RcppArmadillo.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "mcmc/execution/sampler_config.h"
+
+
+/**
+ * ConvergenceReport - Outcome of the checks a ConvergenceMonitor ran
+ */
+struct ConvergenceReport {
+    /// Whether the targets were met at the check that ended the run.
+    bool converged = false;
+    /// True if the run stopped before its last iteration.
+    bool stopped_early = false;
+    /// Draws per chain at the last check (the draws kept when stopped_early).
+    int draws = 0;
+    /// Number of checks run.
+    int checks = 0;
+    /// Largest Rhat and smallest ESS over the parameters at the last check
+    /// (NA when not available).
+    double max_rhat = NA_REAL;
+    double min_ess = NA_REAL;
+    /// Seconds from the start of the chains to the last check.
+    double elapsed = 0.0;
+
+    /** @return The report as a named list for R. */
+    Rcpp::List to_list() const {
+        return Rcpp::List::create(
+            Rcpp::Named("converged") = converged,
+            Rcpp::Named("stopped_early") = stopped_early,
+            Rcpp::Named("draws") = draws,
+            Rcpp::Named("checks") = checks,
+            Rcpp::Named("max_rhat") = max_rhat,
+            Rcpp::Named("min_ess") = min_ess,
+            Rcpp::Named("elapsed") = elapsed
+        );
+    }
+};
+
+
+/**
+ * ConvergenceMonitor - Stops the chains of a run once they have converged
+ *
+ * Every chain calls record_draw() after it stores a draw. When all chains
+ * have stored `check_every` more draws than at the previous check, the
+ * chain that completes the set computes Rhat and ESS over the first N
+ * stored draws of every chain, with the kernels of .compute_rhat_cpp() and
+ * .compute_ess_cpp() (utils/draw_diagnostics.h), reading the sample
+ * buffers in place. The other chains do not wait for it: a chain that
+ * finds a check in progress carries on, and a check reads only draws that
+ * every chain has already published, so no locks are taken.
+ *
+ * If the check meets the ConvergenceTarget (or the time budget has run
+ * out), stop_requested() turns true, each chain stops after its current
+ * iteration, and the run keeps the first N draws of every chain. Because a
+ * check at N depends only on those draws, the stopping point does not
+ * depend on thread timing; finish() runs any checks the chains outpaced.
+ */
+class ConvergenceMonitor {
+public:
+    /**
+     * @param target    Targets and check interval (target.enabled is true)
+     * @param samples   Each chain's sample buffer (nparam x n_stored)
+     * @param nparam    Parameters per draw
+     * @param n_stored  Draws each chain stores when it runs to the end
+     */
+    ConvergenceMonitor(const ConvergenceTarget& target,
+                       std::vector<const double*> samples,
+                       int nparam, int n_stored);
+
+    ConvergenceMonitor(const ConvergenceMonitor&) = delete;
+    ConvergenceMonitor& operator=(const ConvergenceMonitor&) = delete;
+
+    /**
+     * Publish that `chain` has stored one more draw, and run the next check
+     * if this completes it and no other check is running.
+     */
+    void record_draw(int chain);
+
+    /** Leave a chain that failed out of the checks. */
+    void retire(int chain);
+
+    /** @return Whether the chains should stop. */
+    bool stop_requested() const { return stop_.load(std::memory_order_acquire); }
+
+    /**
+     * Run the checks that the chains completed but nobody evaluated, and a
+     * last one at the end of the run. Main thread, after the chains stopped.
+     */
+    void finish();
+
+    /** @return What the checks found. Call after finish(). */
+    const ConvergenceReport& report() const { return report_; }
+
+private:
+    // Whether every active chain has stored at least n draws.
+    bool all_reached(int n) const;
+    // Evaluate the first n draws of every active chain. Caller holds the
+    // check (checking_ or the main thread after the run).
+    void check(int n, bool allow_timeout);
+
+    const ConvergenceTarget target_;
+    const std::vector<const double*> samples_;
+    const int nparam_;
+    const int n_stored_;
+    const std::chrono::steady_clock::time_point start_;
+
+    std::unique_ptr<std::atomic<int>[]> draws_;
+    std::unique_ptr<std::atomic<bool>[]> retired_;
+    std::atomic<bool> checking_{false};
+    std::atomic<bool> stop_{false};
+    // Draws of the next check; written only by the thread holding the check.
+    std::atomic<int> next_check_;
+
+    ConvergenceReport report_;
+    std::vector<double> buf_, centered_;
+};
+
+
+/**
+ * Decode the convergence targets passed from R.
+ *
+ * @param convergence_nullable  NULL (off) or a list with elements `rhat`,
+ *                              `ess`, `check_every` and `max_time`
+ * @return Target with `enabled` set when a list was given
+ */
+inline ConvergenceTarget convergence_target(
+    const Rcpp::Nullable<Rcpp::List>& convergence_nullable
+) {
+    ConvergenceTarget target;
+    if (convergence_nullable.isNull()) return target;
+
+    Rcpp::List convergence(convergence_nullable.get());
+    target.enabled = true;
+    target.rhat = Rcpp::as<double>(convergence["rhat"]);
+    target.ess = Rcpp::as<double>(convergence["ess"]);
+    target.check_every = Rcpp::as<int>(convergence["check_every"]);
+    target.max_time = Rcpp::as<double>(convergence["max_time"]);
+    return target;
+}
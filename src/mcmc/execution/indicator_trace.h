@@ -0,0 +1,172 @@
+#pragma once
+
+#include <RcppArmadillo.h>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+
+/**
+ * IndicatorBitWriter - Appends 0/1 edge indicators to a bit-packed draw
+ *
+ * Indicator k of a draw is bit (k % 64) of word k / 64. The words must be
+ * zeroed beforehand; push() only sets bits.
+ */
+class IndicatorBitWriter {
+public:
+  explicit IndicatorBitWriter(std::uint64_t* words) : words_(words) {}
+
+  /** Append the next indicator. */
+  void push(bool included) {
+    if (included) words_[k_ >> 6] |= std::uint64_t{1} << (k_ & 63);
+    ++k_;
+  }
+
+  /** @return Number of indicators written so far. */
+  size_t size() const { return k_; }
+
+private:
+  std::uint64_t* words_;
+  size_t k_ = 0;
+};
+
+
+
+/**
+ * PackedIndicatorTrace - Edge-indicator draws of one chain, 64 per word
+ *
+ * Draw t occupies words_per_draw() consecutive words, so the trace costs
+ * n_edges / 8 bytes per iteration instead of 4 * n_edges for an arma::imat.
+ * Models fill a draw in place through BaseModel::pack_indicator_parameters(),
+ * without building an intermediate arma::ivec.
+ *
+ * to_list() hands the trace to R in one of two encodings (decoded by
+ * decode_indicator_trace() in R/indicator_trace.R):
+ *
+ *   - "bits": `bits`, a raw vector of the packed words in little-endian byte
+ *     order (bit k of draw t is bit k % 8 of byte t * 8 * words_per_draw +
+ *     k / 8).
+ *   - "rle": `initial` (state of each indicator at draw 1), `flip_start`
+ *     (n_edges + 1 zero-based offsets into `flip_iter`) and `flip_iter`
+ *     (1-based draws at which indicator k differs from the draw before,
+ *     for k = 0, 1, ... in turn).
+ *
+ * Indicators flip rarely once a chain has settled, so the run-length form
+ * is usually far smaller. to_list() picks whichever encoding is shorter.
+ */
+class PackedIndicatorTrace {
+public:
+  /**
+   * Allocate a zeroed trace.
+   * @param n_edges  Indicators per draw
+   * @param n_iter   Number of draws
+   */
+  void reserve(const size_t n_edges, const size_t n_iter) {
+    n_edges_ = n_edges;
+    n_iter_ = n_iter;
+    words_per_draw_ = (n_edges + 63) / 64;
+    words_.assign(words_per_draw_ * n_iter, 0);
+  }
+
+  size_t n_edges() const { return n_edges_; }
+  size_t n_iter() const { return n_iter_; }
+  size_t words_per_draw() const { return words_per_draw_; }
+
+  /** @return The zeroed words of draw `iter`, ready for an IndicatorBitWriter. */
+  std::uint64_t* clear_draw(const size_t iter) {
+    std::uint64_t* words = words_.data() + iter * words_per_draw_;
+    std::fill(words, words + words_per_draw_, 0);
+    return words;
+  }
+
+  /** Store draw `iter` from an unpacked indicator vector. */
+  void store(const size_t iter, const arma::ivec& indicators) {
+    IndicatorBitWriter out(clear_draw(iter));
+    for (arma::uword k = 0; k < indicators.n_elem; ++k) {
+      out.push(indicators(k) != 0);
+    }
+  }
+
+  /** Keep only the first `n` draws. */
+  void truncate(const size_t n) {
+    if (n >= n_iter_) return;
+    n_iter_ = n;
+    words_.resize(words_per_draw_ * n);
+  }
+
+  /** @return Indicator `edge` of draw `iter`. */
+  bool get(const size_t iter, const size_t edge) const {
+    return (words_[iter * words_per_draw_ + (edge >> 6)] >> (edge & 63)) & 1;
+  }
+
+  /** @return The trace encoded for R (see the class comment). */
+  Rcpp::List to_list() const {
+    const size_t n_draws = n_iter_;
+
+    // Flips per indicator, from word-wise XOR of consecutive draws
+    std::vector<int> flip_start(n_edges_ + 1, 0);
+    for (size_t t = 1; t < n_draws; ++t) {
+      for_each_flip(t, [&](size_t k) { ++flip_start[k + 1]; });
+    }
+    for (size_t k = 0; k < n_edges_; ++k) flip_start[k + 1] += flip_start[k];
+    const size_t n_flips = flip_start[n_edges_];
+
+    const size_t rle_bytes = 4 * (2 * n_edges_ + 1 + n_flips);
+    const size_t bits_bytes = 8 * words_per_draw_ * n_draws;
+
+    if (rle_bytes >= bits_bytes) {
+      Rcpp::RawVector bits(bits_bytes);
+      for (size_t w = 0; w < words_per_draw_ * n_draws; ++w) {
+        for (int b = 0; b < 8; ++b) {
+          bits[8 * w + b] = static_cast<unsigned char>(words_[w] >> (8 * b));
+        }
+      }
+      return Rcpp::List::create(
+        Rcpp::Named("encoding") = "bits",
+        Rcpp::Named("n_edges") = static_cast<int>(n_edges_),
+        Rcpp::Named("n_iter") = static_cast<int>(n_draws),
+        Rcpp::Named("bits") = bits
+      );
+    }
+
+    Rcpp::IntegerVector initial(n_edges_);
+    for (size_t k = 0; k < n_edges_; ++k) {
+      initial[k] = n_draws > 0 && get(0, k) ? 1 : 0;
+    }
+    Rcpp::IntegerVector flip_iter(n_flips);
+    std::vector<int> next(flip_start.begin(), flip_start.end() - 1);
+    for (size_t t = 1; t < n_draws; ++t) {
+      for_each_flip(t, [&](size_t k) { flip_iter[next[k]++] = static_cast<int>(t + 1); });
+    }
+    return Rcpp::List::create(
+      Rcpp::Named("encoding") = "rle",
+      Rcpp::Named("n_edges") = static_cast<int>(n_edges_),
+      Rcpp::Named("n_iter") = static_cast<int>(n_draws),
+      Rcpp::Named("initial") = initial,
+      Rcpp::Named("flip_start") = Rcpp::IntegerVector(flip_start.begin(), flip_start.end()),
+      Rcpp::Named("flip_iter") = flip_iter
+    );
+  }
+
+private:
+  // Calls f(k) for every indicator k that differs between draws t - 1 and t.
+  template <typename F>
+  void for_each_flip(const size_t t, F&& f) const {
+    const std::uint64_t* prev = words_.data() + (t - 1) * words_per_draw_;
+    const std::uint64_t* curr = prev + words_per_draw_;
+    for (size_t w = 0; w < words_per_draw_; ++w) {
+      std::uint64_t diff = prev[w] ^ curr[w];
+      while (diff) {
+        const int b = std::countr_zero(diff);
+        f(64 * w + b);
+        diff &= diff - 1;
+      }
+    }
+  }
+
+  size_t n_edges_ = 0;
+  size_t n_iter_ = 0;
+  size_t words_per_draw_ = 0;
+  std::vector<std::uint64_t> words_;
+};
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <RcppArmadillo.h>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+
+/**
+ * OnlineSummary - Running posterior summaries of one chain
+ *
+ * Updated at every post-warmup iteration, thinned or not, so the summaries
+ * cover the whole run while memory stays O(dim) (plus O(n_edges^2) when
+ * co-inclusion counts are requested).
+ *
+ * Per parameter (sampler storage order):
+ *   - mean and variance, by Welford's algorithm;
+ *   - batch-means ESS: the draws are cut into consecutive batches of
+ *     `batch_size`; with s^2 the variance of all draws and s_b^2 the
+ *     variance of the batch means, ESS = n s^2 / (batch_size s_b^2),
+ *     over the n draws in complete batches.
+ *
+ * Per edge indicator: inclusion counts and, optionally, the number of
+ * iterations in which each pair of edges was included together.
+ */
+class OnlineSummary {
+public:
+  /**
+   * @param dim          Parameters per draw
+   * @param n_edges      Edge indicators per draw (0 = no indicators)
+   * @param coinclusion  Also count pairwise co-inclusions
+   * @param batch_size   Draws per batch for the batch-means ESS
+   */
+  void reserve(const size_t dim, const size_t n_edges, const bool coinclusion,
+               const size_t batch_size) {
+    n_ = 0;
+    mean_.zeros(dim);
+    m2_.zeros(dim);
+
+    batch_size_ = std::max<size_t>(1, batch_size);
+    in_batch_ = 0;
+    n_batches_ = 0;
+    batch_sum_.zeros(dim);
+    batch_mean_.zeros(dim);
+    batch_m2_.zeros(dim);
+
+    n_edges_ = n_edges;
+    n_indicator_draws_ = 0;
+    indicator_words_.assign((n_edges + 63) / 64, 0);
+    inclusion_.zeros(n_edges);
+    coinclusion_ = coinclusion && n_edges > 0;
+    if (coinclusion_) {
+      coinclusion_counts_.zeros(n_edges, n_edges);
+      included_.reserve(n_edges);
+    }
+  }
+
+  /** @return true when edge indicators are summarized. */
+  bool has_indicators() const { return n_edges_ > 0; }
+
+  /** Add one parameter draw. */
+  void update(const arma::vec& draw) {
+    ++n_;
+    const arma::vec delta = draw - mean_;
+    mean_ += delta / static_cast<double>(n_);
+    m2_ += delta % (draw - mean_);
+
+    batch_sum_ += draw;
+    if (++in_batch_ == batch_size_) {
+      ++n_batches_;
+      const arma::vec bm = batch_sum_ / static_cast<double>(batch_size_);
+      const arma::vec bdelta = bm - batch_mean_;
+      batch_mean_ += bdelta / static_cast<double>(n_batches_);
+      batch_m2_ += bdelta % (bm - batch_mean_);
+      batch_sum_.zeros();
+      in_batch_ = 0;
+    }
+  }
+
+  /**
+   * @return Zeroed words for the current indicator draw; fill them with an
+   *         IndicatorBitWriter and then call update_indicators().
+   */
+  std::uint64_t* indicator_words() {
+    std::fill(indicator_words_.begin(), indicator_words_.end(), 0);
+    return indicator_words_.data();
+  }
+
+  /** Add the indicator draw written to indicator_words(). */
+  void update_indicators() {
+    ++n_indicator_draws_;
+    included_.clear();
+    for (size_t w = 0; w < indicator_words_.size(); ++w) {
+      std::uint64_t bits = indicator_words_[w];
+      while (bits) {
+        const size_t k = 64 * w + std::countr_zero(bits);
+        inclusion_(k) += 1;
+        if (coinclusion_) included_.push_back(k);
+        bits &= bits - 1;
+      }
+    }
+    if (!coinclusion_) return;
+    for (size_t a = 0; a < included_.size(); ++a) {
+      for (size_t b = a + 1; b < included_.size(); ++b) {
+        coinclusion_counts_(included_[a], included_[b]) += 1;
+      }
+    }
+  }
+
+  /**
+   * @return Named list: n_draws, mean, variance, ess_batch, batch_size and,
+   *         with indicators, inclusion_probability (and coinclusion, an
+   *         n_edges x n_edges matrix of joint inclusion frequencies).
+   */
+  Rcpp::List to_list() const {
+    const size_t n_used = n_batches_ * batch_size_;
+    arma::vec variance(mean_.n_elem);
+    arma::vec ess(mean_.n_elem);
+    for (arma::uword i = 0; i < mean_.n_elem; ++i) {
+      variance(i) = n_ > 1 ? m2_(i) / (n_ - 1) : NA_REAL;
+      const double var_bm = n_batches_ > 1 ? batch_m2_(i) / (n_batches_ - 1) : 0.0;
+      ess(i) = (n_ > 1 && var_bm > 0.0)
+        ? n_used * variance(i) / (batch_size_ * var_bm)
+        : NA_REAL;
+    }
+
+    Rcpp::List out = Rcpp::List::create(
+      Rcpp::Named("n_draws") = static_cast<int>(n_),
+      Rcpp::Named("mean") = Rcpp::NumericVector(mean_.begin(), mean_.end()),
+      Rcpp::Named("variance") = Rcpp::NumericVector(variance.begin(), variance.end()),
+      Rcpp::Named("ess_batch") = Rcpp::NumericVector(ess.begin(), ess.end()),
+      Rcpp::Named("batch_size") = static_cast<int>(batch_size_)
+    );
+    if (has_indicators()) {
+      const double n = std::max<size_t>(1, n_indicator_draws_);
+      const arma::vec prob = arma::conv_to<arma::vec>::from(inclusion_) / n;
+      out["inclusion_probability"] = Rcpp::NumericVector(prob.begin(), prob.end());
+      if (coinclusion_) {
+        arma::mat joint = arma::conv_to<arma::mat>::from(coinclusion_counts_);
+        joint = (joint + joint.t()) / n;
+        joint.diag() = prob;
+        out["coinclusion"] = joint;
+      }
+    }
+    return out;
+  }
+
+private:
+  size_t    n_ = 0;
+  arma::vec mean_;
+  arma::vec m2_;
+
+  size_t    batch_size_ = 1;
+  size_t    in_batch_ = 0;
+  size_t    n_batches_ = 0;
+  arma::vec batch_sum_;
+  arma::vec batch_mean_;
+  arma::vec batch_m2_;
+
+  size_t                     n_edges_ = 0;
+  size_t                     n_indicator_draws_ = 0;
+  std::vector<std::uint64_t> indicator_words_;
+  arma::uvec                 inclusion_;
+  bool                       coinclusion_ = false;
+  arma::umat                 coinclusion_counts_;
+  std::vector<size_t>        included_;
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <RcppArmadillo.h>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "mcmc/execution/sampler_config.h"
+#include "math/explog_macros.h"
+#include "rng/rng_utils.h"
+
+
+/**
+ * TemperingReport - Swap moves of one tempered chain
+ */
+struct TemperingReport {
+    /// Temperature of each replica, 1 for the stored replica.
+    arma::vec temperatures;
+    /// Swaps proposed and accepted between replicas k and k + 1.
+    arma::ivec swap_attempts;
+    arma::ivec swap_accepts;
+
+    /** @return The report as a named list for R. */
+    Rcpp::List to_list() const {
+        Rcpp::NumericVector swap_rate(swap_attempts.n_elem);
+        for (arma::uword k = 0; k < swap_attempts.n_elem; ++k) {
+            swap_rate[k] = swap_attempts(k) > 0
+                ? static_cast<double>(swap_accepts(k)) / swap_attempts(k)
+                : NA_REAL;
+        }
+        return Rcpp::List::create(
+            Rcpp::Named("temperatures") = Rcpp::NumericVector(temperatures.begin(), temperatures.end()),
+            Rcpp::Named("swap_attempts") = Rcpp::IntegerVector(swap_attempts.begin(), swap_attempts.end()),
+            Rcpp::Named("swap_accepts") = Rcpp::IntegerVector(swap_accepts.begin(), swap_accepts.end()),
+            Rcpp::Named("swap_rate") = swap_rate
+        );
+    }
+};
+
+
+/**
+ * Inverse temperatures of the replicas: beta_k = T_max^(-k / (K - 1)) for
+ * k = 0, ..., K - 1, so replica 0 is the untempered chain and the ratio of
+ * neighbouring temperatures is constant.
+ */
+inline arma::vec tempering_ladder(const TemperingSchedule& schedule) {
+    const int replicas = std::max(1, schedule.replicas);
+    arma::vec beta(replicas);
+    for (int k = 0; k < replicas; ++k) {
+        const double step = replicas > 1 ? static_cast<double>(k) / (replicas - 1) : 0.0;
+        beta(k) = MY_EXP(-step * MY_LOG(schedule.max_temperature));
+    }
+    return beta;
+}
+
+
+/**
+ * One round of swap proposals between adjacent replicas of a chain.
+ *
+ * Even rounds pair replicas (0, 1), (2, 3), ..., odd rounds (1, 2),
+ * (3, 4), ..., so the pairs of a round are disjoint and a state can travel
+ * the whole ladder in K - 1 rounds. The exchange of the states of replicas
+ * k and k + 1 is accepted with probability
+ *
+ *   min(1, exp((beta_k - beta_{k+1}) * (l_{k+1} - l_k))),
+ *
+ * where l is the untempered log-pseudolikelihood of a state; the priors
+ * are not tempered and cancel.
+ *
+ * @param beta    Inverse temperature of each replica
+ * @param log_pl  Untempered log-pseudolikelihood of each replica's state;
+ *                entries of accepted pairs are exchanged
+ * @param round   Swap round (0-based)
+ * @param rng     The chain's swap stream
+ * @param report  Swap counts to update
+ * @return Lower replica k of every accepted pair (k, k + 1)
+ */
+inline std::vector<int> propose_replica_swaps(
+    const arma::vec& beta,
+    std::vector<double>& log_pl,
+    const int round,
+    SafeRNG& rng,
+    TemperingReport& report
+) {
+    std::vector<int> accepted;
+    const int replicas = static_cast<int>(beta.n_elem);
+    for (int k = round % 2; k + 1 < replicas; k += 2) {
+        const double log_accept = (beta(k) - beta(k + 1)) * (log_pl[k + 1] - log_pl[k]);
+        ++report.swap_attempts(k);
+        if (!std::isnan(log_accept) && MY_LOG(runif(rng)) < log_accept) {
+            ++report.swap_accepts(k);
+            std::swap(log_pl[k], log_pl[k + 1]);
+            accepted.push_back(k);
+        }
+    }
+    return accepted;
+}
+
+
+/**
+ * Decode the tempering schedule passed from R.
+ *
+ * @param tempering_nullable  NULL (off) or a list with elements `replicas`,
+ *                            `max_temperature` and `swap_every`
+ * @return Schedule with `enabled` set when a list was given
+ */
+inline TemperingSchedule tempering_schedule(
+    const Rcpp::Nullable<Rcpp::List>& tempering_nullable
+) {
+    TemperingSchedule schedule;
+    if (tempering_nullable.isNull()) return schedule;
+
+    Rcpp::List tempering(tempering_nullable.get());
+    schedule.enabled = true;
+    schedule.replicas = Rcpp::as<int>(tempering["replicas"]);
+    schedule.max_temperature = Rcpp::as<double>(tempering["max_temperature"]);
+    schedule.swap_every = Rcpp::as<int>(tempering["swap_every"]);
+    return schedule;
+}
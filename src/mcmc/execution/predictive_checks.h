@@ -0,0 +1,194 @@
+#pragma once
+
+#include <RcppArmadillo.h>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "mcmc/execution/sampler_config.h"
+
+
+/**
+ * Decode the predictive-check schedule passed from R.
+ *
+ * @param checks_nullable  NULL (off) or a list with elements `every`,
+ *                         `iter`, `statistics` (character), `observed`
+ *                         (numeric matrix) and `num_categories`
+ * @return Schedule with `enabled` set when a list was given
+ */
+inline PredictiveCheckSchedule predictive_check_schedule(
+    const Rcpp::Nullable<Rcpp::List>& checks_nullable
+) {
+    PredictiveCheckSchedule schedule;
+    if (checks_nullable.isNull()) return schedule;
+
+    Rcpp::List checks(checks_nullable.get());
+    schedule.enabled = true;
+    schedule.every = Rcpp::as<int>(checks["every"]);
+    schedule.gibbs_iter = Rcpp::as<int>(checks["iter"]);
+    for (const std::string& name : Rcpp::as<std::vector<std::string>>(checks["statistics"])) {
+        if (name == "frequencies") schedule.frequencies = true;
+        if (name == "correlations") schedule.correlations = true;
+    }
+    schedule.observed = Rcpp::as<arma::mat>(checks["observed"]);
+    schedule.num_categories = Rcpp::as<arma::ivec>(checks["num_categories"]);
+    return schedule;
+}
+
+
+/**
+ * PredictiveChecks - running posterior-predictive summaries of one chain
+ *
+ * For each discrepancy statistic T, over the replicates y_rep the chain
+ * simulated: the mean and variance of T(y_rep), by Welford's algorithm,
+ * and the posterior-predictive p-value P(T(y_rep) >= T(y)), with ties
+ * counted half. Memory is O(number of statistics); no draw or replicate
+ * is kept.
+ *
+ * Statistics, in this order:
+ *   - frequencies: the proportion of each category 0..max_category of
+ *     each discrete variable (cells above a variable's categories are
+ *     reported as NA);
+ *   - correlations: the Pearson correlation of each pair of variables
+ *     (0 when a variable is constant in a dataset).
+ */
+class PredictiveChecks {
+public:
+  /** Set up the statistics of `schedule` and compute their observed values. */
+  void reserve(const PredictiveCheckSchedule& schedule) {
+    num_categories_ = schedule.num_categories;
+    frequencies_ = schedule.frequencies && !num_categories_.is_empty();
+    correlations_ = schedule.correlations;
+    every_ = schedule.every;
+    num_variables_ = schedule.observed.n_cols;
+    max_category_ = num_categories_.is_empty() ? 0 : num_categories_.max();
+
+    observed_ = statistics(schedule.observed);
+    n_ = 0;
+    mean_.zeros(observed_.n_elem);
+    m2_.zeros(observed_.n_elem);
+    upper_tail_.zeros(observed_.n_elem);
+  }
+
+  /** Add the statistics of one replicate dataset. */
+  void update(const arma::mat& replicate) {
+    const arma::vec t = statistics(replicate);
+    ++n_;
+    const arma::vec delta = t - mean_;
+    mean_ += delta / static_cast<double>(n_);
+    m2_ += delta % (t - mean_);
+    for (arma::uword i = 0; i < t.n_elem; ++i) {
+      if (t(i) > observed_(i)) {
+        upper_tail_(i) += 1.0;
+      } else if (t(i) == observed_(i)) {
+        upper_tail_(i) += 0.5;
+      }
+    }
+  }
+
+  /**
+   * @return Named list: n_replicates, every and, per requested statistic,
+   *         a list of observed, mean, sd and p_value matrices (discrete
+   *         variables x categories for frequencies, variables x variables
+   *         for correlations).
+   */
+  Rcpp::List to_list() const {
+    const double n = static_cast<double>(n_);
+    arma::vec sd(mean_.n_elem);
+    arma::vec p_value(mean_.n_elem);
+    for (arma::uword i = 0; i < mean_.n_elem; ++i) {
+      sd(i) = n_ > 1 ? std::sqrt(m2_(i) / (n - 1.0)) : NA_REAL;
+      p_value(i) = n_ > 0 ? upper_tail_(i) / n : NA_REAL;
+    }
+
+    Rcpp::List out = Rcpp::List::create(
+      Rcpp::Named("n_replicates") = static_cast<int>(n_),
+      Rcpp::Named("every") = every_
+    );
+    arma::uword offset = 0;
+    if (frequencies_) {
+      const arma::uword k = num_categories_.n_elem;
+      const arma::uword cols = static_cast<arma::uword>(max_category_) + 1;
+      auto block = [&](const arma::vec& values) {
+        arma::mat m = arma::reshape(values.subvec(offset, offset + k * cols - 1), k, cols);
+        for (arma::uword v = 0; v < k; ++v) {
+          const arma::uword used = static_cast<arma::uword>(num_categories_(v)) + 1;
+          for (arma::uword c = used; c < cols; ++c) m(v, c) = NA_REAL;
+        }
+        return m;
+      };
+      out["frequencies"] = Rcpp::List::create(
+        Rcpp::Named("observed") = block(observed_),
+        Rcpp::Named("mean") = block(mean_),
+        Rcpp::Named("sd") = block(sd),
+        Rcpp::Named("p_value") = block(p_value)
+      );
+      offset += k * cols;
+    }
+    if (correlations_) {
+      auto block = [&](const arma::vec& values, double diagonal) {
+        arma::mat m(num_variables_, num_variables_);
+        arma::uword e = offset;
+        for (arma::uword j = 0; j < num_variables_; ++j) {
+          m(j, j) = diagonal;
+          for (arma::uword i = 0; i < j; ++i) {
+            m(i, j) = m(j, i) = values(e++);
+          }
+        }
+        return m;
+      };
+      out["correlations"] = Rcpp::List::create(
+        Rcpp::Named("observed") = block(observed_, 1.0),
+        Rcpp::Named("mean") = block(mean_, 1.0),
+        Rcpp::Named("sd") = block(sd, 0.0),
+        Rcpp::Named("p_value") = block(p_value, NA_REAL)
+      );
+    }
+    return out;
+  }
+
+private:
+  /// Discrepancy statistics of one dataset, in the order of the class comment.
+  arma::vec statistics(const arma::mat& x) const {
+    const arma::uword k = num_categories_.n_elem;
+    const arma::uword cols = static_cast<arma::uword>(max_category_) + 1;
+    const arma::uword size = (frequencies_ ? k * cols : 0) +
+        (correlations_ && num_variables_ > 1 ? num_variables_ * (num_variables_ - 1) / 2 : 0);
+    arma::vec out(size, arma::fill::zeros);
+    const double n = static_cast<double>(x.n_rows);
+
+    arma::uword e = 0;
+    if (frequencies_) {
+      // Column-major over (variable, category), as to_list() reshapes it
+      for (arma::uword v = 0; v < k; ++v) {
+        const double* column = x.colptr(v);
+        for (arma::uword i = 0; i < x.n_rows; ++i) {
+          const arma::uword c = static_cast<arma::uword>(column[i]);
+          if (c < cols) out(c * k + v) += 1.0;
+        }
+      }
+      out.subvec(0, k * cols - 1) /= n;
+      e = k * cols;
+    }
+    if (correlations_ && num_variables_ > 1) {
+      arma::mat r = arma::cor(x);
+      r.elem(arma::find_nonfinite(r)).zeros();
+      for (arma::uword j = 0; j < num_variables_; ++j) {
+        for (arma::uword i = 0; i < j; ++i) out(e++) = r(i, j);
+      }
+    }
+    return out;
+  }
+
+  bool frequencies_ = false;
+  bool correlations_ = false;
+  int every_ = 1;
+  arma::ivec num_categories_;
+  arma::uword num_variables_ = 0;
+  int max_category_ = 0;
+
+  size_t    n_ = 0;          ///< Replicates added
+  arma::vec observed_;       ///< T(y) of the observed data
+  arma::vec mean_;           ///< Running mean of T(y_rep)
+  arma::vec m2_;             ///< Running sum of squared deviations
+  arma::vec upper_tail_;     ///< Replicates with T(y_rep) >= T(y), ties half
+};
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <RcppArmadillo.h>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+
+/**
+ * RBuffer - Armadillo view over memory owned by an R matrix
+ *
+ * The R matrix is allocated on the main thread, before the chains start.
+ * Chains then write through the Armadillo view (no R API calls, so this is
+ * safe inside RcppParallel workers), and convert_results_to_list() hands
+ * the R object over as is, without copying the draws.
+ *
+ * A column-vector buffer of length n is backed by an n x 1 matrix, the
+ * shape RcppArmadillo's wrap() gives an arma::Col.
+ *
+ * R has no single-precision type: float elements are backed by a raw
+ * vector of 4-byte floats in native byte order, whose "float32_dim"
+ * attribute holds the dimensions. widen_float32() in R turns it into a
+ * numeric matrix.
+ *
+ * @tparam ArmaT  arma::Mat<eT> or arma::Col<eT>, with eT double, int or float
+ */
+template <typename ArmaT>
+class RBuffer {
+  using eT = typename ArmaT::elem_type;
+  static_assert(std::is_same_v<eT, double> || std::is_same_v<eT, int> ||
+                std::is_same_v<eT, float>,
+                "RBuffer holds double, int or float elements");
+  static constexpr bool is_float = std::is_same_v<eT, float>;
+  static constexpr int RTYPE = is_float ? RAWSXP
+                             : std::is_same_v<eT, double> ? REALSXP : INTSXP;
+  using Owner = std::conditional_t<is_float, Rcpp::RawVector, Rcpp::Matrix<RTYPE>>;
+
+public:
+  /**
+   * Allocate uninitialized storage. Main thread only.
+   * @param n_rows  Number of rows (vector length for a column buffer)
+   * @param n_cols  Number of columns (must be 1 for a column buffer)
+   */
+  void allocate(const size_t n_rows, const size_t n_cols = 1) {
+    owner_ = make_owner(n_rows, n_cols);
+    attach(n_rows, n_cols);
+  }
+
+  /** @return true once allocate() has been called. */
+  bool allocated() const { return static_cast<bool>(view_); }
+
+  /** @return View over the R-owned memory. */
+  ArmaT& view() { return *view_; }
+  const ArmaT& view() const { return *view_; }
+
+  /**
+   * Keep only the first `n` columns (the first `n` elements of a column
+   * buffer), copying them into a new R matrix. Main thread only.
+   */
+  void truncate(const size_t n) {
+    const ArmaT& old = *view_;
+    const size_t n_rows = ArmaT::is_col ? n : old.n_rows;
+    const size_t n_cols = ArmaT::is_col ? 1 : n;
+    if (n >= (ArmaT::is_col ? old.n_elem : old.n_cols)) return;
+    Owner kept = make_owner(n_rows, n_cols);
+    std::memcpy(data_of(kept), old.memptr(), n_rows * n_cols * sizeof(eT));
+    owner_ = kept;
+    attach(n_rows, n_cols);
+  }
+
+  /** @return The R matrix (raw vector for float elements) holding the data. */
+  SEXP sexp() const { return owner_; }
+
+private:
+  static Owner make_owner(const size_t n_rows, const size_t n_cols) {
+    if constexpr (is_float) {
+      Owner owner(Rcpp::no_init(n_rows * n_cols * sizeof(float)));
+      owner.attr("float32_dim") = Rcpp::NumericVector::create(
+          static_cast<double>(n_rows), static_cast<double>(n_cols));
+      return owner;
+    } else {
+      return Owner(Rcpp::no_init(n_rows, n_cols));
+    }
+  }
+
+  static eT* data_of(Owner& owner) {
+    if constexpr (is_float) {
+      return reinterpret_cast<float*>(owner.begin());
+    } else {
+      return owner.begin();
+    }
+  }
+
+  void attach(const size_t n_rows, const size_t n_cols) {
+    if constexpr (ArmaT::is_col) {
+      view_ = std::make_unique<ArmaT>(data_of(owner_), n_rows, false, true);
+    } else {
+      view_ = std::make_unique<ArmaT>(data_of(owner_), n_rows, n_cols, false, true);
+    }
+  }
+
+  Owner owner_;
+  std::unique_ptr<ArmaT> view_;
+};
+
+
+/**
+ * RealRBuffer - RBuffer of real values stored in double or single precision
+ *
+ * Values are written as double and kept as float32 once allocated with
+ * `single_precision`, which halves the memory of the trace and of its
+ * hand-over to R. The double view is only available in double precision.
+ *
+ * @tparam ArmaT  arma::mat or arma::vec
+ */
+template <typename ArmaT>
+class RealRBuffer {
+  using SingleT = std::conditional_t<ArmaT::is_col, arma::fvec, arma::fmat>;
+
+public:
+  /**
+   * Allocate uninitialized storage. Main thread only.
+   * @param n_rows            Number of rows (vector length for a column buffer)
+   * @param n_cols            Number of columns (1 for a column buffer)
+   * @param single_precision  Store the values as float32
+   */
+  void allocate(const size_t n_rows, const size_t n_cols = 1,
+                const bool single_precision = false) {
+    single_ = single_precision;
+    if (single_) {
+      narrow_.allocate(n_rows, n_cols);
+    } else {
+      wide_.allocate(n_rows, n_cols);
+    }
+  }
+
+  /** @return true once allocate() has been called. */
+  bool allocated() const { return single_ ? narrow_.allocated() : wide_.allocated(); }
+
+  /** @return true if the values are stored as float32. */
+  bool single_precision() const { return single_; }
+
+  /** @return Double-precision view; not available in single precision. */
+  ArmaT& view() { return wide_.view(); }
+  const ArmaT& view() const { return wide_.view(); }
+
+  /** Store element `i` (column-major). */
+  void set(const size_t i, const double value) {
+    if (single_) {
+      narrow_.view()(i) = static_cast<float>(value);
+    } else {
+      wide_.view()(i) = value;
+    }
+  }
+
+  /** Store column `j`. */
+  void set_col(const size_t j, const arma::vec& values) {
+    if (single_) {
+      float* out = narrow_.view().colptr(j);
+      for (arma::uword k = 0; k < values.n_elem; ++k) out[k] = static_cast<float>(values[k]);
+    } else {
+      wide_.view().col(j) = values;
+    }
+  }
+
+  /** See RBuffer::truncate(). */
+  void truncate(const size_t n) {
+    if (single_) {
+      narrow_.truncate(n);
+    } else {
+      wide_.truncate(n);
+    }
+  }
+
+  /** @return The R object holding the data. */
+  SEXP sexp() const { return single_ ? narrow_.sexp() : wide_.sexp(); }
+
+private:
+  RBuffer<ArmaT> wide_;
+  RBuffer<SingleT> narrow_;
+  bool single_ = false;
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+/**
+ * SampleFileReader - reads a trace written by ChunkedFileSink in blocks
+ *
+ * Checks the header of the file (see ChunkedFileSink for the layout) and
+ * reads the values of a range of rows (parameters) over a range of
+ * columns (draws), widened to double, so that a trace larger than memory
+ * can be processed one block at a time. The reader owns its stream: give
+ * each thread its own reader of a file.
+ */
+class SampleFileReader {
+public:
+  static constexpr std::int64_t header_bytes = 32;
+
+  /**
+   * @param path  File written by ChunkedFileSink
+   * @throws std::runtime_error if the file cannot be opened or has no
+   *         sample-file header
+   */
+  explicit SampleFileReader(const std::string& path)
+    : path_(path),
+      in_(path, std::ios::binary)
+  {
+    if (!in_) {
+      throw std::runtime_error("Cannot open sample file: " + path);
+    }
+    char header[header_bytes];
+    in_.read(header, header_bytes);
+    if (!in_ || std::memcmp(header, "BGMSDRW1", 8) != 0) {
+      throw std::runtime_error("'" + path + "' is not a bgms sample file.");
+    }
+    std::int32_t type_code = 0;
+    std::memcpy(&type_code, header + 8, sizeof(type_code));
+    std::memcpy(&n_rows_, header + 16, sizeof(n_rows_));
+    std::memcpy(&n_cols_, header + 24, sizeof(n_cols_));
+    is_double_ = type_code == 0;
+    value_bytes_ = is_double_ ? sizeof(double) : sizeof(std::int32_t);
+  }
+
+  const std::string& path() const { return path_; }
+  std::int64_t n_rows() const { return n_rows_; }
+  std::int64_t n_cols() const { return n_cols_; }
+
+  /**
+   * Read rows [row_begin, row_end) of columns [col_begin, col_end).
+   *
+   * @param out  Resized to hold the block column by column: the value of
+   *             (row i, column t) is at
+   *             out[(t - col_begin) * (row_end - row_begin) + (i - row_begin)]
+   * @throws std::runtime_error on a read error or a truncated file
+   */
+  void read(std::int64_t row_begin, std::int64_t row_end,
+            std::int64_t col_begin, std::int64_t col_end,
+            std::vector<double>& out) {
+    const std::int64_t rows = row_end - row_begin;
+    const std::int64_t cols = col_end - col_begin;
+    out.resize(static_cast<std::size_t>(rows * cols));
+    if (rows <= 0 || cols <= 0) return;
+
+    // All rows: the columns are one contiguous stretch of the file.
+    // Otherwise each column's rows are read after a seek.
+    const bool contiguous = rows == n_rows_;
+    const std::int64_t stretch = contiguous ? rows * cols : rows;
+    raw_.resize(static_cast<std::size_t>(stretch * value_bytes_));
+    for (std::int64_t t = 0; t < (contiguous ? 1 : cols); ++t) {
+      const std::int64_t offset = header_bytes +
+          ((col_begin + t) * n_rows_ + row_begin) * value_bytes_;
+      in_.seekg(offset);
+      in_.read(raw_.data(), static_cast<std::streamsize>(raw_.size()));
+      if (!in_) {
+        throw std::runtime_error("Error reading sample file: " + path_);
+      }
+      widen(out.data() + t * rows, stretch);
+    }
+  }
+
+private:
+  void widen(double* dest, std::int64_t count) const {
+    if (is_double_) {
+      std::memcpy(dest, raw_.data(), static_cast<std::size_t>(count) * sizeof(double));
+      return;
+    }
+    for (std::int64_t i = 0; i < count; ++i) {
+      std::int32_t value;
+      std::memcpy(&value, raw_.data() + i * sizeof(std::int32_t), sizeof(value));
+      dest[i] = static_cast<double>(value);
+    }
+  }
+
+  std::string path_;
+  std::ifstream in_;
+  std::int64_t n_rows_ = 0;
+  std::int64_t n_cols_ = 0;
+  bool is_double_ = true;
+  std::size_t value_bytes_ = sizeof(double);
+  std::vector<char> raw_;
+};
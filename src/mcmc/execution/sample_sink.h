@@ -0,0 +1,173 @@
+#pragma once
+
+#include <RcppArmadillo.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+
+/**
+ * SampleSink - Destination for the post-warmup draws of one chain
+ *
+ * ChainResult writes each draw to its sink, if one is set. Otherwise draws
+ * stay in ChainResult's in-memory matrices. A sink receives the draws in
+ * iteration order, one column of `n_rows` values at a time.
+ *
+ * @tparam eT  Element type of the draws (double for parameters, the
+ *             arma::ivec element type for indicators).
+ */
+template <typename eT>
+class SampleSink {
+public:
+  virtual ~SampleSink() = default;
+
+  /** Append one draw (a column of the trace). */
+  virtual void write(const arma::Col<eT>& draw) = 0;
+
+  /** Write out anything still buffered. Called once, after the last draw. */
+  virtual void finish() = 0;
+
+  /** @return Where the draws went, for convert_results_to_list(). */
+  virtual const std::string& path() const = 0;
+};
+
+
+
+/**
+ * ChunkedFileSink - SampleSink that streams draws to a binary file
+ *
+ * Draws are collected in a buffer of whole columns. The buffer is written
+ * out each time it fills, so the memory one chain holds for its trace is
+ * bounded by `buffer_bytes` whatever the number of iterations.
+ *
+ * File layout (native byte order, 32-byte header):
+ *
+ *   offset  0  char[8]  magic "BGMSDRW1"
+ *   offset  8  int32    element type: 0 = double (8 bytes), 1 = int32
+ *   offset 12  int32    reserved (0)
+ *   offset 16  int64    n_rows (values per draw)
+ *   offset 24  int64    n_cols (draws written; filled in by finish())
+ *   offset 32  data     n_rows x n_cols matrix, column-major
+ *
+ * The data block is a plain column-major matrix, so it can be
+ * memory-mapped at offset 32, or read column range by column range.
+ * read_sample_file() on the R side reads it back.
+ */
+template <typename eT>
+class ChunkedFileSink : public SampleSink<eT> {
+public:
+  /// On-disk element type: double for real draws, int32 for indicators.
+  using FileT = std::conditional_t<std::is_floating_point<eT>::value, double, std::int32_t>;
+
+  static constexpr char magic[8] = {'B', 'G', 'M', 'S', 'D', 'R', 'W', '1'};
+  static constexpr std::int64_t header_bytes = 32;
+
+  /**
+   * @param path          File to create (overwritten if it exists)
+   * @param n_rows        Values per draw
+   * @param buffer_bytes  Upper bound on the in-memory buffer (at least one
+   *                      column is always buffered)
+   */
+  ChunkedFileSink(const std::string& path, size_t n_rows, size_t buffer_bytes)
+    : path_(path),
+      n_rows_(n_rows),
+      out_(path, std::ios::binary | std::ios::trunc)
+  {
+    if (!out_) {
+      throw std::runtime_error("Cannot open sample file for writing: " + path);
+    }
+    // The buffer grows on demand, so a generous limit costs nothing for
+    // short runs.
+    const size_t column_bytes = std::max<size_t>(1, n_rows * sizeof(FileT));
+    buffer_columns_ = std::max<size_t>(1, buffer_bytes / column_bytes);
+    write_header();
+  }
+
+  void write(const arma::Col<eT>& draw) override {
+    for (arma::uword i = 0; i < draw.n_elem; ++i) {
+      buffer_.push_back(static_cast<FileT>(draw(i)));
+    }
+    if (++buffered_columns_ == buffer_columns_) {
+      flush();
+    }
+  }
+
+  void finish() override {
+    if (finished_) return;
+    flush();
+    write_header();
+    out_.close();
+    finished_ = true;
+    if (out_.fail()) {
+      throw std::runtime_error("Error writing sample file: " + path_);
+    }
+  }
+
+  const std::string& path() const override { return path_; }
+
+  /** @return Number of draws held in memory before each write. */
+  size_t buffer_columns() const { return buffer_columns_; }
+
+private:
+  void flush() {
+    if (buffer_.empty()) return;
+    out_.write(reinterpret_cast<const char*>(buffer_.data()),
+               static_cast<std::streamsize>(buffer_.size() * sizeof(FileT)));
+    if (!out_) {
+      throw std::runtime_error("Error writing sample file: " + path_);
+    }
+    n_cols_ += static_cast<std::int64_t>(buffered_columns_);
+    buffer_.clear();
+    buffered_columns_ = 0;
+  }
+
+  // Header at offset 0. The stream is left at the end of the data, so the
+  // header can be rewritten whenever n_cols changes.
+  void write_header() {
+    char header[header_bytes] = {};
+    const std::int32_t type_code = std::is_floating_point<eT>::value ? 0 : 1;
+    const std::int64_t n_rows = static_cast<std::int64_t>(n_rows_);
+    std::memcpy(header, magic, sizeof(magic));
+    std::memcpy(header + 8, &type_code, sizeof(type_code));
+    std::memcpy(header + 16, &n_rows, sizeof(n_rows));
+    std::memcpy(header + 24, &n_cols_, sizeof(n_cols_));
+
+    const std::streampos end = out_.tellp();
+    out_.seekp(0);
+    out_.write(header, header_bytes);
+    if (end > std::streampos(header_bytes)) out_.seekp(end);
+  }
+
+  std::string path_;
+  size_t n_rows_;
+  std::ofstream out_;
+  std::vector<FileT> buffer_;
+  size_t buffer_columns_ = 1;
+  size_t buffered_columns_ = 0;
+  std::int64_t n_cols_ = 0;
+  bool finished_ = false;
+};
+
+
+
+/**
+ * DiscardSink - SampleSink that drops every draw
+ *
+ * For runs that only keep the running summaries (see OnlineSummary), such
+ * as the batch fits of run_mcmc_batch(): no trace is held or written.
+ */
+template <typename eT>
+class DiscardSink : public SampleSink<eT> {
+public:
+  void write(const arma::Col<eT>& /*draw*/) override {}
+  void finish() override {}
+  const std::string& path() const override { return path_; }
+
+private:
+  const std::string path_;
+};
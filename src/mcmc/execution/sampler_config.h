@@ -1,7 +1,88 @@
 #pragma once
 
+#include <RcppArmadillo.h>
 #include <string>
 
+
+/**
+ * ConvergenceTarget - When a run may stop before its last iteration
+ *
+ * With `enabled`, the chains' stored draws are checked every `check_every`
+ * draws (see ConvergenceMonitor). The run stops at the first check at which
+ * every parameter has Rhat <= `rhat` and ESS >= `ess`, or, when `max_time`
+ * is positive, at the first check after `max_time` seconds of sampling.
+ * The iteration count remains the upper bound.
+ */
+struct ConvergenceTarget {
+    bool enabled = false;
+    double rhat = 1.01;
+    double ess = 400.0;
+    int check_every = 100;
+    double max_time = 0.0;
+};
+
+
+/**
+ * TemperingSchedule - Parallel tempering of each chain
+ *
+ * With `enabled`, every chain runs `replicas` copies of the model whose
+ * pseudolikelihoods are raised to the inverse temperatures of a geometric
+ * ladder from 1 down to 1 / `max_temperature` (see tempering_ladder()).
+ * Every `swap_every` iterations adjacent replicas propose to exchange
+ * their states. Only the replica at temperature 1 stores draws.
+ */
+struct TemperingSchedule {
+    bool enabled = false;
+    int replicas = 4;
+    double max_temperature = 5.0;
+    int swap_every = 1;
+};
+
+
+/**
+ * PredictiveCheckSchedule - posterior-predictive checks run inside a chain
+ *
+ * Every `every`-th post-warmup draw, the chain simulates a replicate of
+ * the data from its current parameters (see BaseModel::simulate_replicate)
+ * and adds its discrepancy statistics to a PredictiveChecks accumulator.
+ * The observed data, with the discrete variables in the leading columns,
+ * give the statistics the replicates are compared with.
+ */
+struct PredictiveCheckSchedule {
+    /// Whether the chains simulate replicates.
+    bool enabled = false;
+    /// Simulate from every `every`-th post-warmup draw.
+    int every = 10;
+    /// Gibbs sweeps per replicate of the discrete variables.
+    int gibbs_iter = 1000;
+    /// Category proportions of each discrete variable.
+    bool frequencies = false;
+    /// Correlations between all pairs of variables.
+    bool correlations = false;
+    /// Observed data (n x V), coded as the model's data.
+    arma::mat observed;
+    /// Categories (on top of 0) of the leading discrete columns.
+    arma::ivec num_categories;
+};
+
+
+/**
+ * TelemetrySchedule - live per-chain metrics written while the chains run
+ *
+ * Every `interval_seconds`, each chain queues a summary of the iterations
+ * since its last one (see TelemetryProbe); the main thread appends the
+ * queued summaries to `path` as newline-delimited JSON.
+ */
+struct TelemetrySchedule {
+    /// Whether the chains report telemetry.
+    bool enabled = false;
+    /// File (or named pipe) the records are appended to.
+    std::string path;
+    /// Seconds between two records of a chain.
+    double interval_seconds = 10.0;
+};
+
+
 /**
  * SamplerConfig - Configuration for MCMC sampling
  *
@@ -10,15 +91,24 @@
  * - Iteration counts
  * - NUTS-specific parameters
  * - Edge selection settings
+ * - Within-chain threading
  */
 struct SamplerConfig {
-    /// Sampler type: "nuts" or "adaptive-metropolis".
+    /// Sampler type: "nuts", "nuts-iterative", "adaptive-hmc",
+    /// "adaptive-metropolis", "sgld" or "polya-gamma".
     std::string sampler_type = "adaptive-metropolis";
 
     /// Number of post-warmup iterations.
     int no_iter = 1000;
     /// Number of warmup iterations.
     int no_warmup = 500;
+    /// Keep every `thin`-th post-warmup draw (1 = keep all).
+    int thin = 1;
+
+    /// Running summaries over all post-warmup draws: "none", "moments"
+    /// (means, variances, batch-means ESS, inclusion frequencies) or
+    /// "coinclusion" (moments plus pairwise edge co-inclusion counts).
+    std::string online_summary = "none";
 
     /// Maximum NUTS tree depth.
     int max_tree_depth = 10;
@@ -26,6 +116,22 @@ struct SamplerConfig {
     double initial_step_size = 0.1;
     /// Target acceptance rate for dual-averaging adaptation.
     double target_acceptance = 0.8;
+    /// Step size of the preconditioned stochastic-gradient Langevin sampler.
+    double sgld_step_size = 0.05;
+
+    /// Adapt the NUTS mass matrix during warmup (false keeps the identity).
+    bool learn_mass_matrix = true;
+    /// NUTS metric learned in warmup: "diag", "dense" or "low-rank".
+    std::string nuts_metric = "diag";
+    /// Maximum rank of the "low-rank" metric's correction.
+    int nuts_metric_rank = 10;
+    /// Pool the diagonal mass-matrix windows and step sizes of all chains
+    /// at the end of each Stage-2 window (NUTS only).
+    bool pooled_warmup = false;
+    /// End Stage 2 of the NUTS warmup at the first window whose inverse
+    /// mass diagonal and step size changed by less than this fraction
+    /// (0 = always run every window; see WarmupSchedule).
+    double adaptive_warmup = 0.0;
 
     /// Enable spike-and-slab edge selection.
     bool edge_selection = false;
@@ -39,9 +145,43 @@ struct SamplerConfig {
     /// Factor for the eps²-scaled reversibility tolerance (tol = factor * eps²).
     double reverse_check_tol = 0.5;
 
+    /// Threads one chain may use inside a gradient evaluation.
+    /// 1 = serial (default), 0 = split the thread budget evenly over chains.
+    int threads_per_chain = 1;
+
+    /// Where parallel chains build their models: "main" (cloned on the
+    /// calling thread, default), "first-touch" (cloned on the worker thread
+    /// that runs the chain) or "replicate" (first-touch, with a per-chain
+    /// copy of the shared data).
+    std::string chain_placement = "main";
+
+    /// Stop sampling once the chains meet these targets (off by default).
+    ConvergenceTarget convergence;
+
+    /// Run tempered replicas of every chain (off by default).
+    TemperingSchedule tempering;
+
+    /// Simulate replicate datasets for posterior-predictive checks (off by default).
+    PredictiveCheckSchedule predictive_checks;
+
+    /// Append live per-chain metrics to a file (off by default).
+    TelemetrySchedule telemetry;
+
+    /// Directory to stream parameter and indicator draws to, one
+    /// ChunkedFileSink file per chain. Empty = keep draws in memory.
+    std::string sample_dir;
+    /// Buffer per streamed trace, in bytes.
+    size_t sample_buffer_bytes = 64u << 20;
+    /// Keep the in-memory parameter, energy and acceptance traces as
+    /// float32 (about 7 significant digits) instead of double.
+    bool single_precision_traces = false;
+
     /// Random seed.
     int seed = 42;
 
     /// Default constructor.
     SamplerConfig() = default;
+
+    /// @return Number of draws stored per chain after thinning.
+    int stored_iter() const { return (no_iter + thin - 1) / thin; }
 };
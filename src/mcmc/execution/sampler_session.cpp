@@ -0,0 +1,103 @@
+#include "mcmc/execution/sampler_session.h"
+#include "mcmc/execution/chain_runner.h"
+#include "utils/task_arena.h"
+
+
+SamplerSession::SamplerSession(
+    const BaseModel& model,
+    const BaseEdgePrior& edge_prior,
+    const SamplerConfig& config,
+    const int no_threads,
+    const std::vector<ChainResult>& results
+) :
+    config_(config),
+    no_threads_(no_threads)
+{
+    // An extension has no warmup windows to pool and no checks to stop at,
+    // and the draws stay in memory
+    config_.pooled_warmup = false;
+    config_.convergence = ConvergenceTarget();
+
+    const int no_chains = static_cast<int>(results.size());
+    const int gradient_threads =
+        resolve_gradient_threads(config_.threads_per_chain, no_chains, no_threads_);
+
+    // Each chain continues from its final state, as a warm start would
+    for (const ChainResult& result : results) {
+        const SamplerState& state = result.final_state;
+        auto chain_model = model.clone();
+        chain_model->set_gradient_threads(gradient_threads);
+        SafeRNG rng;
+        rng.set_state(state.rng);
+        chain_model->set_rng(rng);
+        chain_model->restore_state(state);
+        auto chain_edge_prior = edge_prior.clone();
+        chain_edge_prior->restore_state(state);
+
+        models_.push_back(std::move(chain_model));
+        edge_priors_.push_back(std::move(chain_edge_prior));
+        states_.push_back(state);
+    }
+}
+
+
+std::vector<ChainResult> SamplerSession::extend(const int no_iter, const int no_warmup,
+                                                ProgressManager& pm) {
+    SamplerConfig config = config_;
+    config.no_iter = no_iter;
+    config.no_warmup = no_warmup;
+
+    const int no_chains = num_chains();
+    std::vector<ChainResult> results(no_chains);
+    reserve_chain_results(results, *models_[0], *edge_priors_[0], config);
+
+    if (no_threads_ > 1) {
+        MCMCChainRunner runner(results, models_, edge_priors_, config, pm, states_);
+        pm.run_with_reporter([&] {
+            run_in_arena(no_threads_, [&] {
+                parallel_for_tasks(static_cast<size_t>(no_chains), runner);
+            });
+        });
+    } else {
+        for (int c = 0; c < no_chains; ++c) {
+            run_mcmc_chain(results[c], *models_[c], *edge_priors_[c], config, c, pm, &states_[c]);
+        }
+    }
+
+    // The next extension restores the tuning the chains stopped with
+    for (int c = 0; c < no_chains; ++c) {
+        if (!results[c].error) states_[c] = results[c].final_state;
+    }
+    return results;
+}
+
+
+// The first chain writes the update to the data block; the others update
+// their own statistics and residuals and share its block, so the data is
+// copied once rather than once per chain
+void SamplerSession::append_observations(const arma::imat& rows) {
+    models_[0]->append_observations(rows);
+    for (size_t c = 1; c < models_.size(); ++c) {
+        models_[c]->append_observations(rows, *models_[0]);
+    }
+}
+
+
+void SamplerSession::remove_observations(const arma::uvec& rows) {
+    models_[0]->remove_observations(rows);
+    for (size_t c = 1; c < models_.size(); ++c) {
+        models_[c]->remove_observations(rows, *models_[0]);
+    }
+}
+
+
+SEXP make_sampler_session(const BaseModel& model, const BaseEdgePrior& edge_prior,
+                          const SamplerConfig& config, const int no_threads,
+                          const std::vector<ChainResult>& results) {
+    for (const ChainResult& result : results) {
+        if (result.error || result.userInterrupt) return R_NilValue;
+    }
+    Rcpp::XPtr<SamplerSession> session(
+        new SamplerSession(model, edge_prior, config, no_threads, results), true);
+    return session;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <RcppArmadillo.h>
+#include "models/base_model.h"
+#include "mcmc/execution/chain_result.h"
+#include "mcmc/execution/sampler_config.h"
+#include "mcmc/execution/sampler_state.h"
+#include "priors/edge_prior.h"
+#include "utils/progress_manager.h"
+
+
+/**
+ * SamplerSession - The chains of a finished run, kept for more draws
+ *
+ * Holds one model and edge prior per chain, at the state the chain
+ * stopped in, and the chain's saved sampler tuning (step size, inverse
+ * mass, proposal SDs). extend() runs every chain for more iterations from
+ * there, without building the model from the data again; each chain
+ * continues its own random stream, so the new draws are those of a warm
+ * start from the previous run.
+ *
+ * append_observations() and remove_observations() change the data of
+ * every chain's model in place (see BaseModel), so a later extend()
+ * samples the posterior of the updated data from where the chains were.
+ * The chains keep sharing one copy of the updated data.
+ *
+ * Created by the sampler entry points with keep_session = TRUE and handed
+ * to R as an external pointer (see make_sampler_session()).
+ */
+class SamplerSession {
+public:
+    /**
+     * @param model       Prototype model of the run (cloned per chain)
+     * @param edge_prior  Prototype edge prior of the run
+     * @param config      Sampler configuration of the run
+     * @param no_threads  Thread budget of the run
+     * @param results     The run's chain results, with their final states
+     */
+    SamplerSession(const BaseModel& model, const BaseEdgePrior& edge_prior,
+                   const SamplerConfig& config, int no_threads,
+                   const std::vector<ChainResult>& results);
+
+    /**
+     * Run every chain for `no_iter` more sampling iterations.
+     *
+     * @param no_iter    Post-warmup iterations per chain
+     * @param no_warmup  Warmup iterations before them, which restart the
+     *                   adaptation from the saved tuning (0 keeps it fixed)
+     * @param pm         Progress manager for the extension
+     * @return One ChainResult per chain, holding the new draws only
+     */
+    std::vector<ChainResult> extend(int no_iter, int no_warmup, ProgressManager& pm);
+
+    /** Add observation rows to the data of every chain. */
+    void append_observations(const arma::imat& rows);
+
+    /** Drop observation rows (0-based) from the data of every chain. */
+    void remove_observations(const arma::uvec& rows);
+
+    int num_chains() const { return static_cast<int>(models_.size()); }
+
+private:
+    SamplerConfig config_;
+    int no_threads_;
+    std::vector<std::unique_ptr<BaseModel>> models_;
+    std::vector<std::unique_ptr<BaseEdgePrior>> edge_priors_;
+    /// Where each chain stopped; the sampler tuning is restored from it
+    std::vector<SamplerState> states_;
+};
+
+
+/**
+ * Keep the chains of a finished run_mcmc_sampler() call for extension.
+ *
+ * @return External pointer to a SamplerSession, or R_NilValue when a chain
+ *         failed or the run was interrupted
+ */
+SEXP make_sampler_session(const BaseModel& model, const BaseEdgePrior& edge_prior,
+                          const SamplerConfig& config, int no_threads,
+                          const std::vector<ChainResult>& results);
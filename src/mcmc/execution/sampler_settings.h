@@ -0,0 +1,113 @@
+#pragma once
+
+/**
+ * @file sampler_settings.h
+ * @brief The `settings` list of the sample_* entry points.
+ *
+ * The entry points take the data, priors and core sampler arguments
+ * positionally; every other resolved setting of validate_sampler() comes in
+ * one named list (see sampler_settings() in R/run_sampler.R). Elements that
+ * are missing or NULL keep their SamplerConfig defaults, so an empty list
+ * runs the plain sampler. apply_sampler_settings() fills the SamplerConfig
+ * fields; each entry point reads its model-specific elements itself.
+ */
+
+#include <RcppArmadillo.h>
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "mcmc/execution/sampler_config.h"
+#include "mcmc/execution/sampler_state.h"
+#include "mcmc/execution/convergence_monitor.h"
+#include "mcmc/execution/parallel_tempering.h"
+#include "mcmc/execution/predictive_checks.h"
+#include "mcmc/execution/telemetry.h"
+
+
+/**
+ * SamplerSettings - typed access to the `settings` list passed from R
+ */
+class SamplerSettings {
+public:
+    /**
+     * @param settings_nullable  NULL or a named list of settings
+     */
+    explicit SamplerSettings(const Rcpp::Nullable<Rcpp::List>& settings_nullable) {
+        if (settings_nullable.isNotNull()) {
+            settings_ = Rcpp::List(settings_nullable.get());
+        }
+    }
+
+    /// @return Whether `name` is given and not NULL.
+    bool has(const char* name) const {
+        return settings_.containsElementNamed(name) && !Rf_isNull(settings_[name]);
+    }
+
+    /**
+     * @param name      Element name
+     * @param fallback  Value when the element is missing or NULL
+     * @return The element converted to T, or `fallback`
+     */
+    template <typename T>
+    T get(const char* name, const T& fallback) const {
+        return has(name) ? Rcpp::as<T>(settings_[name]) : fallback;
+    }
+
+    /// @return The element as a nullable list (NULL when missing).
+    Rcpp::Nullable<Rcpp::List> list(const char* name) const {
+        if (!has(name)) return R_NilValue;
+        return Rcpp::Nullable<Rcpp::List>(settings_[name]);
+    }
+
+    /**
+     * @param no_chains  Number of chains the run will start
+     * @return The `warm_start` states (see warm_start_states()), or an
+     *         empty vector for a cold start
+     */
+    std::vector<SamplerState> warm_start(int no_chains) const {
+        return warm_start_states(list("warm_start"), no_chains);
+    }
+
+private:
+    Rcpp::List settings_;
+};
+
+
+/**
+ * Copy the settings that SamplerConfig holds into `config`.
+ *
+ * Reads threads_per_chain, nuts_metric, sample_dir, sample_buffer_mb,
+ * thin, online_summary, trace_precision, chain_placement, convergence,
+ * pooled_warmup, adaptive_warmup, tempering, predictive_checks, telemetry
+ * and the SGLD step size of `subsample`. Fields whose element is missing
+ * keep their current value.
+ *
+ * @param config    Configuration to update
+ * @param settings  Settings from R
+ */
+inline void apply_sampler_settings(SamplerConfig& config, const SamplerSettings& settings) {
+    config.threads_per_chain = settings.get("threads_per_chain", config.threads_per_chain);
+    config.nuts_metric = settings.get("nuts_metric", config.nuts_metric);
+    config.sample_dir = settings.get("sample_dir", config.sample_dir);
+    if (settings.has("sample_buffer_mb")) {
+        config.sample_buffer_bytes = static_cast<size_t>(
+            settings.get("sample_buffer_mb", 64.0) * 1024.0 * 1024.0);
+    }
+    config.thin = std::max(1, settings.get("thin", config.thin));
+    config.online_summary = settings.get("online_summary", config.online_summary);
+    config.single_precision_traces =
+        settings.get<std::string>("trace_precision", "double") == "single";
+    config.chain_placement = settings.get("chain_placement", config.chain_placement);
+    config.convergence = convergence_target(settings.list("convergence"));
+    config.pooled_warmup = settings.get("pooled_warmup", config.pooled_warmup);
+    config.adaptive_warmup = settings.get("adaptive_warmup", config.adaptive_warmup);
+    config.tempering = tempering_schedule(settings.list("tempering"));
+    config.predictive_checks = predictive_check_schedule(settings.list("predictive_checks"));
+    config.telemetry = telemetry_schedule(settings.list("telemetry"));
+    if (settings.has("subsample")) {
+        config.sgld_step_size =
+            Rcpp::as<double>(Rcpp::List(settings.list("subsample").get())["step_size"]);
+    }
+}
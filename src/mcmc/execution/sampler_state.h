@@ -0,0 +1,195 @@
+#pragma once
+
+/**
+ * @file sampler_state.h
+ * @brief Everything a chain needs to continue where an earlier run stopped.
+ *
+ * run_mcmc_chain() saves a SamplerState when a chain stops, and
+ * run_mcmc_sampler() starts each chain from one when a warm start is
+ * given. The model contributes its parameter blocks, edge indicators,
+ * inclusion probabilities and Metropolis proposal SDs; the sampler its
+ * adapted step size and inverse mass diagonal; the edge prior its SBM
+ * allocations and block probabilities; the runner the chain's RNG state.
+ *
+ * to_list() and from_list() convert to and from the R list stored in
+ * `fit$raw_samples$sampler_state`. Both run on the main thread.
+ */
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <RcppArmadillo.h>
+
+
+/**
+ * SamplerState - Saved state of one chain
+ *
+ * Model blocks are kept by name, so each model decides what it saves and
+ * checks the dimensions of what it restores (see block()).
+ */
+struct SamplerState {
+    /// Named model blocks: parameters, indicators, proposal SDs, ...
+    std::vector<std::pair<std::string, arma::mat>> model;
+    /// Whether edge-indicator moves were active when the chain stopped.
+    bool edge_selection_active = false;
+
+    /// Adapted NUTS step size (NaN for the Metropolis sampler).
+    double step_size = std::numeric_limits<double>::quiet_NaN();
+    /// Adapted NUTS inverse mass diagonal (empty for the Metropolis sampler).
+    arma::vec inv_mass;
+    /// Adapted trajectory length of adaptive HMC (NaN for other samplers).
+    double trajectory_length = std::numeric_limits<double>::quiet_NaN();
+
+    /// SBM cluster allocations, 0-based (empty without an SBM edge prior).
+    arma::uvec allocations;
+    /// SBM block inclusion probabilities (K x K).
+    arma::mat block_probs;
+
+    /// Serialized xoshiro256++ engine state.
+    std::string rng;
+
+    /// Save a model block under `name`.
+    void add(const std::string& name, const arma::mat& value) {
+        model.emplace_back(name, value);
+    }
+
+    /**
+     * Model block saved under `name`.
+     *
+     * @param name    Block name
+     * @param n_rows  Expected number of rows
+     * @param n_cols  Expected number of columns
+     * @throws std::invalid_argument if the block is missing or has other dimensions
+     */
+    const arma::mat& block(const std::string& name,
+                           arma::uword n_rows, arma::uword n_cols) const {
+        for (const auto& [block_name, value] : model) {
+            if (block_name != name) continue;
+            if (value.n_rows != n_rows || value.n_cols != n_cols) {
+                throw std::invalid_argument(
+                    "warm_start: `" + name + "` is " +
+                    std::to_string(value.n_rows) + " x " + std::to_string(value.n_cols) +
+                    ", but this model needs " +
+                    std::to_string(n_rows) + " x " + std::to_string(n_cols) + ".");
+            }
+            return value;
+        }
+        throw std::invalid_argument(
+            "warm_start: the saved state has no `" + name + "` for this model.");
+    }
+
+    /** @return Whether a model block was saved under `name`. */
+    bool has_block(const std::string& name) const {
+        for (const auto& entry : model) {
+            if (entry.first == name) return true;
+        }
+        return false;
+    }
+
+    /** @return Whether a NUTS step size and inverse mass were saved. */
+    bool has_nuts_tuning() const {
+        return std::isfinite(step_size) && inv_mass.n_elem > 0;
+    }
+
+    /**
+     * State for R
+     *
+     * @return list(model = named list of matrices, edge_selection_active,
+     *              step_size, inv_mass, trajectory_length,
+     *              allocations (1-based), block_probs, rng)
+     */
+    Rcpp::List to_list() const {
+        Rcpp::List blocks(model.size());
+        Rcpp::CharacterVector names(model.size());
+        for (std::size_t k = 0; k < model.size(); ++k) {
+            names[k] = model[k].first;
+            blocks[k] = Rcpp::wrap(model[k].second);
+        }
+        blocks.names() = names;
+
+        Rcpp::IntegerVector allocations_1based(allocations.n_elem);
+        for (arma::uword i = 0; i < allocations.n_elem; ++i) {
+            allocations_1based[i] = static_cast<int>(allocations(i)) + 1;
+        }
+
+        return Rcpp::List::create(
+            Rcpp::Named("model") = blocks,
+            Rcpp::Named("edge_selection_active") = edge_selection_active,
+            Rcpp::Named("step_size") = step_size,
+            Rcpp::Named("inv_mass") = Rcpp::NumericVector(inv_mass.begin(), inv_mass.end()),
+            Rcpp::Named("trajectory_length") = trajectory_length,
+            Rcpp::Named("allocations") = allocations_1based,
+            Rcpp::Named("block_probs") = Rcpp::wrap(block_probs),
+            Rcpp::Named("rng") = rng
+        );
+    }
+
+    /**
+     * Rebuild a state from the list returned by to_list(). States saved
+     * before `trajectory_length` was added are accepted without it.
+     * @throws std::invalid_argument if a field is missing
+     */
+    static SamplerState from_list(const Rcpp::List& list) {
+        for (const char* field : {"model", "edge_selection_active", "step_size",
+                                  "inv_mass", "allocations", "block_probs", "rng"}) {
+            if (!list.containsElementNamed(field)) {
+                throw std::invalid_argument(
+                    std::string("warm_start: the saved state has no `") + field + "` field.");
+            }
+        }
+
+        SamplerState state;
+        Rcpp::List blocks = list["model"];
+        Rcpp::CharacterVector names = blocks.names();
+        for (R_xlen_t k = 0; k < blocks.size(); ++k) {
+            state.add(Rcpp::as<std::string>(names[k]),
+                      Rcpp::as<arma::mat>(blocks[k]));
+        }
+        state.edge_selection_active = Rcpp::as<bool>(list["edge_selection_active"]);
+        state.step_size = Rcpp::as<double>(list["step_size"]);
+        state.inv_mass = Rcpp::as<arma::vec>(list["inv_mass"]);
+        if (list.containsElementNamed("trajectory_length")) {
+            state.trajectory_length = Rcpp::as<double>(list["trajectory_length"]);
+        }
+
+        Rcpp::IntegerVector allocations = list["allocations"];
+        state.allocations.set_size(allocations.size());
+        for (R_xlen_t i = 0; i < allocations.size(); ++i) {
+            state.allocations(i) = static_cast<arma::uword>(allocations[i] - 1);
+        }
+        state.block_probs = Rcpp::as<arma::mat>(list["block_probs"]);
+        state.rng = Rcpp::as<std::string>(list["rng"]);
+        return state;
+    }
+};
+
+
+/**
+ * Decode the per-chain warm-start states passed from R.
+ *
+ * @param warm_start_nullable  NULL or a list of to_list() states, one per chain
+ * @param no_chains            Number of chains the run will start
+ * @return One state per chain, or an empty vector for a cold start
+ * @throws std::invalid_argument if the number of states differs from no_chains
+ */
+inline std::vector<SamplerState> warm_start_states(
+    const Rcpp::Nullable<Rcpp::List>& warm_start_nullable, int no_chains
+) {
+    std::vector<SamplerState> states;
+    if (warm_start_nullable.isNull()) return states;
+
+    Rcpp::List warm_start(warm_start_nullable.get());
+    if (warm_start.size() != no_chains) {
+        throw std::invalid_argument(
+            "warm_start holds " + std::to_string(warm_start.size()) +
+            " chain states, but " + std::to_string(no_chains) + " chains were requested.");
+    }
+    states.reserve(no_chains);
+    for (R_xlen_t c = 0; c < warm_start.size(); ++c) {
+        states.push_back(SamplerState::from_list(warm_start[c]));
+    }
+    return states;
+}
@@ -31,6 +31,9 @@ struct NUTSDiagnostics : public DiagnosticsBase {
   double energy;         ///< Final Hamiltonian (-log posterior + kinetic energy)
   double accept_prob;    ///< Mean Metropolis acceptance over the trajectory's
                          ///  leapfrog steps (Stan's `accept_stat__`)
+  int arena_allocations = 0; ///< Trajectory-buffer (re)allocations this step
+                             ///  (0 once the arena fits the dimension)
+  int n_leapfrog = 0;        ///< Leapfrog steps (one gradient evaluation each)
 };
 
 
@@ -0,0 +1,153 @@
+#include "mcmc/execution/telemetry.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#elif defined(__linux__)
+#include <unistd.h>
+#endif
+
+
+namespace {
+
+// Resident memory of the process in MB, or NaN where it is not known.
+double resident_memory_mb() {
+#if defined(__APPLE__)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO,
+                  reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS) {
+        return TelemetryRecord::missing;
+    }
+    return static_cast<double>(info.resident_size) / (1024.0 * 1024.0);
+#elif defined(__linux__)
+    std::FILE* statm = std::fopen("/proc/self/statm", "r");
+    if (statm == nullptr) return TelemetryRecord::missing;
+    long pages_total = 0, pages_resident = 0;
+    const int read = std::fscanf(statm, "%ld %ld", &pages_total, &pages_resident);
+    std::fclose(statm);
+    if (read != 2) return TelemetryRecord::missing;
+    return static_cast<double>(pages_resident) *
+        static_cast<double>(sysconf(_SC_PAGESIZE)) / (1024.0 * 1024.0);
+#else
+    return TelemetryRecord::missing;
+#endif
+}
+
+// Append `"key":value` to a JSON object, with null for a non-finite value.
+void append_field(std::string& line, const char* key, double value) {
+    char buffer[64];
+    if (std::isfinite(value)) {
+        std::snprintf(buffer, sizeof(buffer), ",\"%s\":%.6g", key, value);
+    } else {
+        std::snprintf(buffer, sizeof(buffer), ",\"%s\":null", key);
+    }
+    line += buffer;
+}
+
+std::string to_json(const TelemetryRecord& record) {
+    std::string line = "{\"chain\":" + std::to_string(record.chain) +
+        ",\"iteration\":" + std::to_string(record.iteration) +
+        ",\"phase\":" + (record.warmup ? "\"warmup\"" : "\"sampling\"") +
+        ",\"done\":" + (record.done ? "true" : "false");
+    append_field(line, "elapsed", record.elapsed);
+    line += ",\"iterations\":" + std::to_string(record.iterations);
+    append_field(line, "step_size", record.step_size);
+    append_field(line, "mean_tree_depth", record.mean_tree_depth);
+    line += ",\"divergences\":" + std::to_string(record.divergences);
+    append_field(line, "mean_accept_prob", record.mean_accept_prob);
+    append_field(line, "edges_included", record.edges_included);
+    append_field(line, "gradient_evals_per_sec", record.gradient_evals_per_sec);
+    append_field(line, "memory_mb", record.memory_mb);
+    line += ",\"dropped\":" + std::to_string(record.dropped) + "}\n";
+    return line;
+}
+
+}  // namespace
+
+
+TelemetryWriter::TelemetryWriter(const TelemetrySchedule& schedule, int no_chains)
+    : interval_seconds_(schedule.interval_seconds),
+      start_(std::chrono::steady_clock::now())
+{
+    file_ = std::fopen(schedule.path.c_str(), "a");
+    if (file_ == nullptr) {
+        throw std::runtime_error("Cannot open telemetry file: " + schedule.path);
+    }
+    queues_.reserve(no_chains);
+    for (int c = 0; c < no_chains; ++c) {
+        queues_.push_back(std::make_unique<TelemetryQueue>());
+    }
+}
+
+
+TelemetryWriter::~TelemetryWriter() {
+    flush();
+    std::fclose(file_);
+}
+
+
+void TelemetryWriter::flush() {
+    TelemetryRecord record;
+    bool wrote = false;
+    for (auto& queue : queues_) {
+        while (queue->pop(record)) {
+            const std::string line = to_json(record);
+            std::fwrite(line.data(), 1, line.size(), file_);
+            wrote = true;
+        }
+    }
+    if (wrote) std::fflush(file_);
+}
+
+
+void TelemetryProbe::record(const StepResult& result) {
+    ++iterations_;
+    accept_sum_ += result.accept_prob;
+    auto diag = std::dynamic_pointer_cast<NUTSDiagnostics>(result.diagnostics);
+    if (diag) {
+        ++nuts_steps_;
+        tree_depth_sum_ += diag->tree_depth;
+        divergences_ += diag->divergent ? 1 : 0;
+        leapfrog_sum_ += diag->n_leapfrog;
+    }
+}
+
+
+void TelemetryProbe::push(int iteration, bool warmup, bool done, double step_size,
+                          double edges_included) {
+    const double now = writer_.elapsed();
+    const double seconds = now - last_push_;
+
+    TelemetryRecord record;
+    record.chain = chain_id_ + 1;
+    record.iteration = iteration;
+    record.warmup = warmup;
+    record.done = done;
+    record.elapsed = now;
+    record.iterations = iterations_;
+    record.step_size = step_size;
+    if (nuts_steps_ > 0) record.mean_tree_depth = tree_depth_sum_ / nuts_steps_;
+    record.divergences = divergences_;
+    if (iterations_ > 0) record.mean_accept_prob = accept_sum_ / iterations_;
+    record.edges_included = edges_included;
+    if (seconds > 0.0) record.gradient_evals_per_sec = leapfrog_sum_ / seconds;
+    record.memory_mb = resident_memory_mb();
+    record.dropped = dropped_;
+
+    if (queue_.push(record)) {
+        dropped_ = 0;
+    } else {
+        ++dropped_;
+    }
+    last_push_ = now;
+    iterations_ = 0;
+    nuts_steps_ = 0;
+    tree_depth_sum_ = 0.0;
+    divergences_ = 0;
+    accept_sum_ = 0.0;
+    leapfrog_sum_ = 0.0;
+}
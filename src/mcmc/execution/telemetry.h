@@ -0,0 +1,187 @@
+#pragma once
+
+#include <RcppArmadillo.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+#include "mcmc/execution/sampler_config.h"
+#include "mcmc/execution/step_result.h"
+
+
+/**
+ * Decode the telemetry settings passed from R.
+ *
+ * @param telemetry_nullable  NULL (off) or a list with elements `file`
+ *                            (character) and `every` (seconds)
+ * @return Schedule with `enabled` set when a list was given
+ */
+inline TelemetrySchedule telemetry_schedule(
+    const Rcpp::Nullable<Rcpp::List>& telemetry_nullable
+) {
+    TelemetrySchedule schedule;
+    if (telemetry_nullable.isNull()) return schedule;
+
+    Rcpp::List telemetry(telemetry_nullable.get());
+    schedule.enabled = true;
+    schedule.path = Rcpp::as<std::string>(telemetry["file"]);
+    schedule.interval_seconds = Rcpp::as<double>(telemetry["every"]);
+    return schedule;
+}
+
+
+/**
+ * TelemetryRecord - one chain's metrics over the iterations since its
+ * previous record
+ *
+ * Quantities a sampler or model does not have are NaN (written as JSON
+ * null): the step size of Metropolis samplers, the tree depth of
+ * samplers without NUTS diagnostics, the edge count without edge
+ * selection.
+ */
+struct TelemetryRecord {
+    static constexpr double missing = std::numeric_limits<double>::quiet_NaN();
+
+    int chain = 0;                        ///< 1-based chain index
+    int iteration = 0;                    ///< Iterations completed, warmup included
+    bool warmup = true;                   ///< Whether the chain is still in warmup
+    bool done = false;                    ///< Last record of the chain
+    double elapsed = 0.0;                 ///< Seconds since the run started
+    int iterations = 0;                   ///< Iterations this record summarises
+    double step_size = missing;           ///< Current integrator step size
+    double mean_tree_depth = missing;     ///< Mean NUTS tree depth
+    int divergences = 0;                  ///< Divergent transitions
+    double mean_accept_prob = missing;    ///< Mean acceptance probability
+    double edges_included = missing;      ///< Edges in the current graph
+    double gradient_evals_per_sec = 0.0;  ///< Leapfrog steps (gradients) per second
+    double memory_mb = missing;           ///< Resident memory of the process
+    int dropped = 0;                      ///< Earlier records lost to a full queue
+};
+
+
+/**
+ * TelemetryQueue - single-producer, single-consumer ring of records
+ *
+ * The chain's worker thread pushes and the main thread pops, without
+ * locks: each side owns one index and publishes it with release
+ * ordering. A push to a full ring fails instead of waiting, so a slow
+ * reader never stalls a chain.
+ */
+class TelemetryQueue {
+public:
+    static constexpr std::size_t capacity = 64;
+
+    /** @return Whether the record was queued (false when the ring is full). */
+    bool push(const TelemetryRecord& record) {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == capacity) return false;
+        slots_[head % capacity] = record;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** @return Whether a record was taken into `record`. */
+    bool pop(TelemetryRecord& record) {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) return false;
+        record = slots_[tail % capacity];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::array<TelemetryRecord, capacity> slots_;
+    alignas(64) std::atomic<std::size_t> head_{0};  ///< Next slot to write
+    alignas(64) std::atomic<std::size_t> tail_{0};  ///< Next slot to read
+};
+
+
+/**
+ * TelemetryWriter - the queues of a run and the file they are flushed to
+ *
+ * Owned by the ProgressManager, whose main-thread poll calls flush(). The
+ * file is opened in append mode, so several runs can share one stream, and
+ * each record is written as one line of JSON; a named pipe works as well
+ * as a file, for a reader that follows the run.
+ */
+class TelemetryWriter {
+public:
+    /**
+     * @param schedule   Destination and record interval
+     * @param no_chains  Chains of the run (one queue each)
+     * @throws std::runtime_error if the file cannot be opened
+     */
+    TelemetryWriter(const TelemetrySchedule& schedule, int no_chains);
+    ~TelemetryWriter();
+
+    TelemetryWriter(const TelemetryWriter&) = delete;
+    TelemetryWriter& operator=(const TelemetryWriter&) = delete;
+
+    TelemetryQueue& queue(int chain_id) { return *queues_[chain_id]; }
+    double interval_seconds() const { return interval_seconds_; }
+
+    /** @return Seconds since the writer was created. */
+    double elapsed() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    }
+
+    /** Write every queued record to the file. Main thread only. */
+    void flush();
+
+private:
+    std::FILE* file_ = nullptr;
+    double interval_seconds_;
+    std::vector<std::unique_ptr<TelemetryQueue>> queues_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+
+/**
+ * TelemetryProbe - a chain's side of the telemetry
+ *
+ * Accumulates the diagnostics of each step and, once the writer's interval
+ * has passed, pushes their summary to the chain's queue. Costs a clock read
+ * per iteration.
+ */
+class TelemetryProbe {
+public:
+    TelemetryProbe(TelemetryWriter& writer, int chain_id)
+        : writer_(writer), queue_(writer.queue(chain_id)), chain_id_(chain_id),
+          last_push_(writer.elapsed()) {}
+
+    /** Add the outcome of one step. */
+    void record(const StepResult& result);
+
+    /** @return Whether the interval since the last record has passed. */
+    bool due() const { return writer_.elapsed() - last_push_ >= writer_.interval_seconds(); }
+
+    /**
+     * Queue the summary of the steps since the last record and start a new
+     * interval.
+     *
+     * @param iteration       Iterations completed
+     * @param warmup          Whether the chain is in warmup
+     * @param done            Whether this is the chain's last record
+     * @param step_size       Current step size (NaN for none)
+     * @param edges_included  Edges in the graph (NaN without edge selection)
+     */
+    void push(int iteration, bool warmup, bool done, double step_size, double edges_included);
+
+private:
+    TelemetryWriter& writer_;
+    TelemetryQueue& queue_;
+    const int chain_id_;
+    double last_push_;
+    int iterations_ = 0;
+    int nuts_steps_ = 0;
+    double tree_depth_sum_ = 0.0;
+    int divergences_ = 0;
+    double accept_sum_ = 0.0;
+    double leapfrog_sum_ = 0.0;
+    int dropped_ = 0;
+};
@@ -19,6 +19,13 @@
  *   - Stage 3c: step size re-adaptation with edge selection active
  *   If Stage 3b would get < 20 iterations, it's skipped (uses default proposal SD).
  *
+ * With an adaptive Stage 2 (`stable_tolerance` > 0), the NUTS adaptation
+ * ends Stage 2 at the first window end where the inverse mass diagonal
+ * and the averaged step size both changed by less than the tolerance
+ * (relative to the previous window); end_stage2_after() then drops the
+ * remaining windows and moves Stages 3a-3c forward, so warmup ends
+ * earlier by their length. The sampling iterations are unchanged.
+ *
  * Warning types:
  *   0 = none, 1 = warmup extremely short (< 50),
  *   2 = core stages using proportional fallback,
@@ -31,11 +38,13 @@ struct WarmupSchedule {
   int stage3a_start;              ///< First iter in Stage-3a
   int stage3b_start;              ///< First iter in Stage-3b (== stage3c_start if skipped)
   int stage3c_start;              ///< First iter in Stage-3c (== total_warmup if skipped)
-  int total_warmup;               ///< Warm-up iterations = user-specified value
+  int total_warmup;               ///< Warm-up iterations (user-specified, less any early end of Stage 2)
   bool learn_proposal_sd;         ///< Whether to run the proposal-SD tuner
   bool enable_selection;          ///< Allow edge-indicator moves
   int warning_type;               ///< Warning code (see above)
   bool stage3b_skipped;           ///< True if 3b was skipped due to insufficient budget
+  int planned_warmup;             ///< Warm-up iterations before any early end of Stage 2
+  double stable_tolerance = 0.0;  ///< Relative change that ends Stage 2 early (0 = never)
 
   WarmupSchedule(int warmup,
                  bool enable_sel,
@@ -50,6 +59,7 @@ struct WarmupSchedule {
     , enable_selection(enable_sel)
     , warning_type(0)
     , stage3b_skipped(false)
+    , planned_warmup(warmup)
   {
     // ===== Step 1: Determine budget allocation =====
     int warmup_core;    // Budget for Stage 1-3a (mass matrix + step size)
@@ -187,6 +197,29 @@ struct WarmupSchedule {
     return std::pow(t, -proposal_sd_rm_decay);
   }
 
+  /// Whether Stage 2 may end before its last planned window.
+  bool adaptive_stage2() const { return stable_tolerance > 0.0; }
+
+  /**
+   * End Stage 2 with window `w`: drop the windows after it and move the
+   * later stages forward by their length.
+   *
+   * @return Warm-up iterations saved
+   */
+  int end_stage2_after(int w) {
+    const int saved = stage3a_start - window_ends[w];
+    if (saved <= 0) return 0;
+    window_ends.resize(w + 1);
+    stage3a_start -= saved;
+    stage3b_start -= saved;
+    stage3c_start -= saved;
+    total_warmup -= saved;
+    return saved;
+  }
+
+  /// Warm-up iterations saved by ending Stage 2 early.
+  int warmup_saved() const { return planned_warmup - total_warmup; }
+
   /// Current Stage-2 window index (-1 outside Stage-2)
   int current_window(int i) const {
     for (size_t k = 0; k < window_ends.size(); ++k)
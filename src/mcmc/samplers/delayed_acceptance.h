@@ -0,0 +1,89 @@
+#pragma once
+
+#include <RcppArmadillo.h>
+#include <algorithm>
+
+
+/**
+ * DelayedAcceptance - two-stage Metropolis-Hastings test for pairwise moves
+ *
+ * A move of one pairwise effect by delta is first screened with a cheap
+ * quadratic surrogate of the log-pseudolikelihood change,
+ *
+ *   T(x, delta) = g(x) delta - c delta^2 / 2 + (prior and proposal terms),
+ *
+ * where g(x) is the exact derivative of the log-pseudolikelihood in the
+ * effect at the current state and c a per-pair curvature. Only moves that
+ * pass this first stage pay for the exact ratio r, and are then accepted
+ * with
+ *
+ *   min(1, exp(r) min(1, exp(T(y, -delta))) / min(1, exp(T(x, delta)))),
+ *
+ * which keeps the exact pseudoposterior invariant (Christen and Fox, 2005)
+ * as long as the surrogate is a fixed function of the state. The curvature
+ * is therefore only learned during warmup, from secants of the gradients
+ * at the current and the proposed state, and frozen afterwards.
+ */
+class DelayedAcceptance {
+public:
+  /// Whether the models use the two-stage test.
+  bool enabled = false;
+  /// Whether the curvature is still being learned (warmup only).
+  bool adapting = false;
+
+  /// Size the per-pair curvature for p variables and reset the counts.
+  void resize(arma::uword p) {
+    curvature_.zeros(p, p);
+    secants_.zeros(p, p);
+    proposals_ = first_stage_accepts_ = second_stage_accepts_ = 0.0;
+  }
+
+  /// First-stage log ratio of the surrogate, without prior and proposal terms.
+  double surrogate(arma::uword i, arma::uword j, double gradient, double delta) const {
+    return gradient * delta - 0.5 * curvature_(i, j) * delta * delta;
+  }
+
+  /// Log acceptance ratio of the second stage.
+  static double second_stage_log_ratio(double log_ratio, double forward, double reverse) {
+    return log_ratio + std::min(0.0, reverse) - std::min(0.0, forward);
+  }
+
+  /**
+   * Learn the curvature of pair (i, j) from the gradients at the current
+   * and the proposed state. A running mean of the non-negative secants;
+   * does nothing outside warmup.
+   */
+  void learn(arma::uword i, arma::uword j, double gradient_current,
+             double gradient_proposed, double delta) {
+    if (!adapting || delta == 0.0) return;
+    const double secant = std::max(0.0, (gradient_current - gradient_proposed) / delta);
+    const double count = ++secants_(i, j);
+    curvature_(i, j) += (secant - curvature_(i, j)) / count;
+    curvature_(j, i) = curvature_(i, j);
+    secants_(j, i) = count;
+  }
+
+  void record_proposal() { proposals_ += 1.0; }
+  void record_first_stage_accept() { first_stage_accepts_ += 1.0; }
+  void record_second_stage_accept() { second_stage_accepts_ += 1.0; }
+
+  /// Proposals, first-stage and second-stage acceptances (1 x 3).
+  arma::mat statistics() const {
+    return arma::mat{{proposals_, first_stage_accepts_, second_stage_accepts_}};
+  }
+
+  const arma::mat& curvature() const { return curvature_; }
+
+  /// Restore a saved curvature; it counts as learned from one secant.
+  void set_curvature(const arma::mat& curvature) {
+    curvature_ = curvature;
+    secants_ = arma::conv_to<arma::mat>::from(curvature_ > 0.0);
+  }
+
+private:
+  arma::mat curvature_;   ///< Per-pair curvature c of the surrogate
+  arma::mat secants_;     ///< Number of secants averaged into each curvature
+  double proposals_ = 0.0;
+  double first_stage_accepts_ = 0.0;
+  double second_stage_accepts_ = 0.0;
+};
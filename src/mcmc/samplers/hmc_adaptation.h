@@ -0,0 +1,142 @@
+#pragma once
+
+#include <RcppArmadillo.h>
+#include <algorithm>
+#include <cmath>
+#include "math/explog_macros.h"
+
+
+/**
+ * TrajectoryLengthAdapter - ChEES trajectory-length adaptation for HMC
+ *
+ * Tunes the integration time T of adaptive HMC during warmup by stochastic
+ * gradient ascent on the ChEES criterion (Hoffman, Radul & Sountsov, 2021),
+ *
+ *   ChEES = E[(|theta' - m|^2 - |theta - m|^2)^2] / 4,
+ *
+ * which keeps growing while longer trajectories still carry the proposal
+ * theta' further from the posterior mean m than the current state theta.
+ * Each iteration integrates for the jittered time u * T, with u in (0, 1)
+ * from a van der Corput sequence, and
+ *
+ *   g = a * (|theta' - m|^2 - |theta - m|^2) * ((theta' - m)' v') * u * T
+ *
+ * estimates the derivative of ChEES in log T, where a is the acceptance
+ * probability and v' = M^{-1} r' the velocity at the end of the trajectory.
+ * Adam (beta1 = 0, beta2 = 0.95) turns g into a step on log T. The final T
+ * is a weighted average of the iterates, as for the dual-averaging step
+ * size.
+ *
+ * The ChEES paper centres on the mean over many parallel chains. Here every
+ * chain adapts on its own, so that its draws do not depend on the other
+ * chains or on the threads: m is the chain's running mean, restarted when
+ * the mass matrix changes (see restart_mean()).
+ */
+class TrajectoryLengthAdapter {
+public:
+  /**
+   * @param initial_length  Trajectory length to start from
+   */
+  explicit TrajectoryLengthAdapter(double initial_length = 1.0)
+    : log_length_(MY_LOG(initial_length)),
+      log_length_avg_(MY_LOG(initial_length)) {}
+
+  /**
+   * Jitter factor of an iteration: the van der Corput (base 2) number of
+   * iteration + 1, 1/2, 1/4, 3/4, 1/8, ..., always in (0, 1). Consumes no
+   * random numbers.
+   */
+  static double jitter(int iteration) {
+    double u = 0.0;
+    double scale = 0.5;
+    for (unsigned n = static_cast<unsigned>(iteration) + 1u; n > 0; n >>= 1) {
+      if (n & 1u) u += scale;
+      scale *= 0.5;
+    }
+    return u;
+  }
+
+  /**
+   * Leapfrog steps that integrate for `u * length()`.
+   *
+   * @param step_size  Leapfrog step size
+   * @param u          Jitter factor (see jitter())
+   * @param max_steps  Upper bound on the number of steps
+   */
+  int num_steps(double step_size, double u, int max_steps) const {
+    const double steps = std::ceil(u * length() / step_size);
+    if (!(steps >= 1.0)) return 1;
+    return static_cast<int>(std::min(steps, static_cast<double>(max_steps)));
+  }
+
+  /**
+   * One ChEES update from a completed trajectory.
+   *
+   * @param theta        State the trajectory started from
+   * @param proposal     Position at the end of the trajectory
+   * @param velocity     Velocity at the end of the trajectory (M^{-1} r)
+   * @param accept_prob  Metropolis acceptance probability of the proposal
+   * @param u            Jitter factor of the trajectory
+   * @param step_size    Leapfrog step size (bounds T from below)
+   * @param max_steps    Maximum steps per trajectory (bounds T from above)
+   */
+  void update(const arma::vec& theta, const arma::vec& proposal,
+              const arma::vec& velocity, double accept_prob, double u,
+              double step_size, int max_steps) {
+    if (mean_.n_elem != theta.n_elem) {
+      mean_.zeros(theta.n_elem);
+      mean_count_ = 0;
+    }
+    ++mean_count_;
+    mean_ += (theta - mean_) / static_cast<double>(mean_count_);
+    if (mean_count_ < 2) return;
+
+    const arma::vec from = theta - mean_;
+    const arma::vec to = proposal - mean_;
+    const double a = std::isfinite(accept_prob) ? accept_prob : 0.0;
+    const double g = a * (arma::dot(to, to) - arma::dot(from, from)) *
+                     arma::dot(to, velocity) * u * length();
+    if (!std::isfinite(g)) return;
+
+    // Adam with beta1 = 0: the step is g scaled by its running RMS
+    ++t_;
+    second_moment_ = beta2 * second_moment_ + (1.0 - beta2) * g * g;
+    const double v_hat = second_moment_ / (1.0 - std::pow(beta2, t_));
+    log_length_ += learning_rate * g / (std::sqrt(v_hat) + 1e-8);
+
+    const double lo = MY_LOG(step_size);
+    const double hi = MY_LOG(step_size * max_steps);
+    log_length_ = std::clamp(log_length_, lo, std::max(lo, hi));
+
+    const double weight = std::pow(static_cast<double>(t_), -kappa);
+    log_length_avg_ = weight * log_length_ + (1.0 - weight) * log_length_avg_;
+  }
+
+  /** Forget the running mean, e.g. after the mass matrix changed. */
+  void restart_mean() { mean_count_ = 0; mean_.reset(); }
+
+  /** Use the averaged length from now on. */
+  void freeze() { log_length_ = log_length_avg_; }
+
+  /** Start from a saved trajectory length (warm start). */
+  void set_length(double length) {
+    log_length_ = MY_LOG(length);
+    log_length_avg_ = log_length_;
+  }
+
+  double length() const { return MY_EXP(log_length_); }
+  double averaged_length() const { return MY_EXP(log_length_avg_); }
+
+private:
+  static constexpr double learning_rate = 0.025;
+  static constexpr double beta2 = 0.95;
+  static constexpr double kappa = 0.75;
+
+  double log_length_;
+  double log_length_avg_;
+  double second_moment_ = 0.0;
+  int t_ = 0;
+
+  arma::vec mean_;
+  int mean_count_ = 0;
+};
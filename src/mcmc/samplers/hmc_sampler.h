@@ -0,0 +1,392 @@
+#pragma once
+
+#include <RcppArmadillo.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include "mcmc/algorithms/hmc.h"
+#include "mcmc/algorithms/leapfrog.h"
+#include "mcmc/execution/sampler_config.h"
+#include "mcmc/execution/sampler_state.h"
+#include "mcmc/execution/step_result.h"
+#include "mcmc/execution/warmup_schedule.h"
+#include "mcmc/samplers/hmc_adaptation.h"
+#include "mcmc/samplers/nuts_adaptation.h"
+#include "mcmc/samplers/sampler_base.h"
+#include "models/base_model.h"
+
+/**
+ * AdaptiveHMCSampler - Static-trajectory HMC with a ChEES-tuned length
+ *
+ * Every iteration runs hmc_step for a jittered trajectory length, tuned in
+ * warmup Stages 1, 2 and 3a by a TrajectoryLengthAdapter and then frozen.
+ * Step size and diagonal mass matrix follow the same warmup as NUTS,
+ * through a NUTSAdaptationController: dual averaging in Stages 1, 2, 3a
+ * and 3c, and mass-matrix windows in Stage 2, each followed by the
+ * step-size heuristic. The number of leapfrog steps, at most
+ * 2^max_tree_depth, does not depend on the state, so iterations cost about
+ * the same and chains advanced in lockstep stay in step.
+ *
+ * For constrained models (edge selection or sparse graph), trajectories
+ * use RATTLE integration in the full position space, with the reverse
+ * check enforced during sampling as in NUTS.
+ *
+ * Reports NUTSDiagnostics, with `tree_depth` the number of doublings that
+ * reach the trajectory's step count (so hitting the maximum depth means
+ * the trajectory was capped). Always uses a diagonal metric.
+ *
+ * Unconstrained iterations can also be split around hmc_step_batch()
+ * (begin_batched_step() and end_batched_step()), so that chains advanced
+ * in lockstep share their gradient evaluations.
+ */
+class AdaptiveHMCSampler : public SamplerBase {
+public:
+    AdaptiveHMCSampler(const SamplerConfig& config, WarmupSchedule& schedule)
+        : step_size_(config.initial_step_size),
+          target_acceptance_(config.target_acceptance),
+          schedule_(schedule),
+          max_steps_(1 << std::max(0, std::min(config.max_tree_depth, 20))),
+          learn_mass_matrix_(config.learn_mass_matrix),
+          reverse_check_(config.reverse_check),
+          reverse_check_tol_(config.reverse_check_tol)
+    {}
+
+    bool has_nuts_diagnostics() const override { return true; }
+
+    StepResult step(BaseModel& model, int iteration) override {
+        const int num_steps = begin_iteration(model, iteration);
+
+        const bool constrained = uses_constrained_integration(model);
+        arma::vec start;
+        HMCTrajectory end;
+        StepResult result = constrained
+            ? do_constrained_step(model, num_steps, schedule_.sampling(iteration), start, end)
+            : do_unconstrained_step(model, num_steps, start, end);
+
+        return end_iteration(model, iteration, num_steps, constrained, start, end,
+                             std::move(result));
+    }
+
+    /**
+     * @return Whether the model's iterations can go through
+     *         hmc_step_batch() (unconstrained integration only).
+     */
+    bool batchable(const BaseModel& model) const {
+        return !uses_constrained_integration(model);
+    }
+
+    /**
+     * First part of a step() that runs inside hmc_step_batch(): the
+     * adaptation before the trajectory, then the member's start, step
+     * size, step count, inverse mass and RNG. Requires batchable().
+     */
+    void begin_batched_step(BaseModel& model, int iteration, HMCBatchMember& member) {
+        member.num_leapfrogs = begin_iteration(model, iteration);
+        member.init_theta = model.get_vectorized_parameters();
+        member.step_size = step_size_;
+        member.inv_mass_diag = model.get_active_inv_mass();
+        member.rng = &model.get_rng();
+    }
+
+    /**
+     * Last part of that step(), once hmc_step_batch() has filled the
+     * member: takes its state and adapts as step() does.
+     */
+    StepResult end_batched_step(BaseModel& model, int iteration, HMCBatchMember& member) {
+        model.set_vectorized_parameters(member.result.state);
+        return end_iteration(model, iteration, member.num_leapfrogs, false,
+                             member.init_theta, member.trajectory, std::move(member.result));
+    }
+
+    void initialize(BaseModel& model) override {
+        if (initialized_) return;
+        do_initialize(model);
+        initialized_ = true;
+    }
+
+    /** Save the step size, inverse mass diagonal and trajectory length. */
+    void save_state(SamplerState& state) const override {
+        if (!nuts_adapt_) return;
+        state.step_size = step_size_;
+        state.inv_mass = nuts_adapt_->inv_mass_diag();
+        state.trajectory_length = trajectory_.length();
+    }
+
+    /**
+     * Start from a saved step size and inverse mass diagonal (and
+     * trajectory length, when saved by this sampler). Warmup then keeps the
+     * mass diagonal and continues adapting the rest from the saved values.
+     */
+    void restore_state(const SamplerState& state) override {
+        if (!state.has_nuts_tuning()) return;
+        warm_step_size_ = state.step_size;
+        warm_inv_mass_ = state.inv_mass;
+        warm_length_ = state.trajectory_length;
+    }
+
+    double get_step_size() const { return step_size_; }
+    double current_step_size() const override { return step_size_; }
+    double get_trajectory_length() const { return trajectory_.length(); }
+
+private:
+    bool uses_constrained_integration(const BaseModel& model) const {
+        return model.has_constraints();
+    }
+
+    /**
+     * Adaptation before the trajectory: Stage-3c restart, length freeze,
+     * step size and jitter. @return The trajectory's number of steps
+     */
+    int begin_iteration(BaseModel& model, int iteration) {
+        // Stage 3c boundary: edge selection just activated. Restart dual
+        // averaging, re-tuned for the constrained integrator if needed.
+        if (schedule_.in_stage3c(iteration) && !stage3c_initialized_) {
+            stage3c_initialized_ = true;
+            nuts_adapt_->reinit_stepsize(uses_constrained_integration(model)
+                ? heuristic_step_size(model, model.get_inv_mass())
+                : nuts_adapt_->current_step_size());
+        }
+
+        // The trajectory length stops adapting with Stage 3a
+        adapt_length_ = schedule_.in_stage1(iteration) ||
+                        schedule_.in_stage2(iteration) ||
+                        schedule_.in_stage3a(iteration);
+        if (!adapt_length_ && !length_frozen_) {
+            trajectory_.freeze();
+            length_frozen_ = true;
+        }
+
+        step_size_ = nuts_adapt_->current_step_size();
+        jitter_ = TrajectoryLengthAdapter::jitter(iteration);
+        return trajectory_.num_steps(step_size_, jitter_, max_steps_);
+    }
+
+    /**
+     * Diagnostics and adaptation after the trajectory from `start` that
+     * ended at `end` and gave `result`. @return The completed result
+     */
+    StepResult end_iteration(BaseModel& model, int iteration, int num_steps, bool constrained,
+                             const arma::vec& start, const HMCTrajectory& end,
+                             StepResult result) {
+        auto diag = std::make_shared<NUTSDiagnostics>();
+        diag->tree_depth = static_cast<int>(std::ceil(std::log2(static_cast<double>(num_steps))));
+        diag->divergent = end.divergent;
+        diag->non_reversible = end.non_reversible;
+        diag->energy = end.energy;
+        diag->accept_prob = result.accept_prob;
+        diag->n_leapfrog = num_steps;
+        result.diagnostics = diag;
+
+        if (adapt_length_ && !end.non_reversible) {
+            const arma::vec& inv_mass = constrained
+                ? model.get_inv_mass()
+                : model.get_active_inv_mass();
+            trajectory_.update(start, end.theta, inv_mass % end.r,
+                               result.accept_prob, jitter_, step_size_, max_steps_);
+        }
+
+        // Step size and mass matrix, in the coordinates of the integrator
+        arma::vec full_params = constrained
+            ? model.get_full_position()
+            : model.get_full_vectorized_parameters();
+        nuts_adapt_->update(full_params, result.accept_prob, iteration);
+
+        if (nuts_adapt_->mass_matrix_just_updated()) {
+            arma::vec new_inv_mass = nuts_adapt_->inv_mass_diag();
+            model.set_inv_mass(new_inv_mass);
+            nuts_adapt_->reinit_stepsize(heuristic_step_size(model, new_inv_mass));
+            trajectory_.restart_mean();
+        }
+
+        step_size_ = nuts_adapt_->current_step_size();
+        return result;
+    }
+
+    StepResult do_unconstrained_step(BaseModel& model, int num_steps,
+                                     arma::vec& start, HMCTrajectory& end) {
+        start = model.get_vectorized_parameters();
+        auto grad_fn = [&model](const arma::vec& params) -> arma::vec {
+            return model.logp_and_gradient(params).second;
+        };
+        auto joint_fn = [&model](const arma::vec& params)
+            -> std::pair<double, arma::vec> {
+            return model.logp_and_gradient(params);
+        };
+        arma::vec active_inv_mass = model.get_active_inv_mass();
+
+        StepResult result = hmc_step(
+            start, step_size_, grad_fn, joint_fn, num_steps,
+            active_inv_mass, model.get_rng(), &end);
+
+        model.set_vectorized_parameters(result.state);
+        return result;
+    }
+
+    StepResult do_constrained_step(BaseModel& model, int num_steps, bool enforce_reverse_check,
+                                   arma::vec& start, HMCTrajectory& end) {
+        model.reset_projection_cache();
+        start = model.get_full_position();
+
+        auto joint_fn = [&model](const arma::vec& params)
+            -> std::pair<double, arma::vec> {
+            return model.logp_and_gradient_full(params);
+        };
+        arma::vec inv_mass = model.get_inv_mass();
+        ProjectPositionFn proj_pos = [&model, &inv_mass](arma::vec& pos) {
+            model.project_position(pos, inv_mass);
+        };
+        ProjectMomentumFn proj_mom = [&model, &inv_mass](arma::vec& mom, const arma::vec& pos) {
+            model.project_momentum(mom, pos, inv_mass);
+        };
+
+        StepResult result = hmc_step(
+            start, step_size_, joint_fn, num_steps, inv_mass,
+            proj_pos, proj_mom, model.get_rng(),
+            reverse_check_ && enforce_reverse_check, reverse_check_tol_, &end);
+
+        model.set_full_position(result.state);
+        return result;
+    }
+
+    /**
+     * Step-size heuristic under `inv_mass`, from the current step size, with
+     * the integrator the model needs.
+     */
+    double heuristic_step_size(BaseModel& model, const arma::vec& inv_mass) {
+        SafeRNG& rng = model.get_rng();
+        if (uses_constrained_integration(model)) {
+            arma::vec x = model.get_full_position();
+            auto joint_fn = [&model](const arma::vec& params)
+                -> std::pair<double, arma::vec> {
+                return model.logp_and_gradient_full(params);
+            };
+            ProjectPositionFn proj_pos = [&model, &inv_mass](arma::vec& pos) {
+                model.project_position(pos, inv_mass);
+            };
+            ProjectMomentumFn proj_mom = [&model, &inv_mass](arma::vec& mom, const arma::vec& pos) {
+                model.project_momentum(mom, pos, inv_mass);
+            };
+            return heuristic_initial_step_size_constrained(
+                x, joint_fn, inv_mass, proj_pos, proj_mom, rng,
+                target_acceptance_, nuts_adapt_->current_step_size());
+        }
+        arma::vec theta = model.get_vectorized_parameters();
+        auto grad_fn = [&model](const arma::vec& params) -> arma::vec {
+            return model.logp_and_gradient(params).second;
+        };
+        auto joint_fn = [&model](const arma::vec& params)
+            -> std::pair<double, arma::vec> {
+            return model.logp_and_gradient(params);
+        };
+        arma::vec active_inv_mass = model.get_active_inv_mass();
+        return heuristic_initial_step_size(
+            theta, grad_fn, joint_fn, active_inv_mass, rng,
+            target_acceptance_, nuts_adapt_->current_step_size());
+    }
+
+    void do_initialize(BaseModel& model) {
+        int dim = static_cast<int>(model.full_parameter_dimension());
+        SafeRNG& rng = model.get_rng();
+
+        if (warm_inv_mass_.n_elem > 0) {
+            if (warm_inv_mass_.n_elem != static_cast<arma::uword>(dim)) {
+                throw std::invalid_argument(
+                    "warm_start: `inv_mass` has " + std::to_string(warm_inv_mass_.n_elem) +
+                    " entries, but this model has " + std::to_string(dim) + " parameters.");
+            }
+            model.set_inv_mass(warm_inv_mass_);
+            step_size_ = warm_step_size_;
+            nuts_adapt_ = std::make_unique<NUTSAdaptationController>(
+                dim, warm_step_size_, target_acceptance_, schedule_, false);
+            nuts_adapt_->set_inv_mass_diag(warm_inv_mass_);
+            trajectory_.set_length(std::isfinite(warm_length_)
+                ? warm_length_
+                : initial_length_steps * warm_step_size_);
+            return;
+        }
+
+        arma::vec init_inv_mass = arma::ones<arma::vec>(dim);
+        model.set_inv_mass(init_inv_mass);
+
+        double init_eps;
+        if (uses_constrained_integration(model)) {
+            // Start on the constraint manifold (see NUTSSampler)
+            arma::vec x = model.get_full_position();
+            arma::vec r_dummy = arma::zeros<arma::vec>(x.n_elem);
+            model.project_position(x);
+            model.project_momentum(r_dummy, x);
+            model.set_full_position(x);
+
+            x = model.get_full_position();
+            auto grad_fn = [&model](const arma::vec& params) -> arma::vec {
+                return model.logp_and_gradient_full(params).second;
+            };
+            auto joint_fn = [&model](const arma::vec& params)
+                -> std::pair<double, arma::vec> {
+                return model.logp_and_gradient_full(params);
+            };
+            init_eps = heuristic_initial_step_size(
+                x, grad_fn, joint_fn, rng, target_acceptance_);
+        } else {
+            arma::vec theta = model.get_vectorized_parameters();
+            auto grad_fn = [&model](const arma::vec& params) -> arma::vec {
+                return model.logp_and_gradient(params).second;
+            };
+            auto joint_fn = [&model](const arma::vec& params)
+                -> std::pair<double, arma::vec> {
+                return model.logp_and_gradient(params);
+            };
+            init_eps = heuristic_initial_step_size(
+                theta, grad_fn, joint_fn, rng, target_acceptance_);
+        }
+
+        nuts_adapt_ = std::make_unique<NUTSAdaptationController>(
+            dim, init_eps, target_acceptance_, schedule_, learn_mass_matrix_);
+
+        // Inverse curvature at the pseudoposterior mode (see NUTSSampler)
+        arma::vec seeded_inv_mass = model.initial_inv_mass();
+        if (seeded_inv_mass.n_elem == static_cast<arma::uword>(dim)) {
+            model.set_inv_mass(seeded_inv_mass);
+            nuts_adapt_->set_inv_mass_diag(seeded_inv_mass);
+            init_eps = heuristic_step_size(model, seeded_inv_mass);
+            nuts_adapt_->reinit_stepsize(init_eps);
+        }
+
+        step_size_ = init_eps;
+        trajectory_.set_length(initial_length_steps * init_eps);
+    }
+
+    /// Initial trajectory length, in initial step sizes.
+    static constexpr double initial_length_steps = 10.0;
+
+    // --- Configuration / state ---
+    double step_size_;
+    double target_acceptance_;
+    WarmupSchedule& schedule_;
+    int max_steps_;
+    bool learn_mass_matrix_;
+    bool reverse_check_;
+    double reverse_check_tol_;
+
+    // --- Lifecycle flags ---
+    bool initialized_ = false;
+    bool stage3c_initialized_ = false;
+    bool length_frozen_ = false;
+
+    // --- The current iteration, from begin_iteration() to end_iteration() ---
+    bool adapt_length_ = false;
+    double jitter_ = 0.0;
+
+    // --- Warm start (restore_state); empty inverse mass = cold start ---
+    double warm_step_size_ = 0.0;
+    arma::vec warm_inv_mass_;
+    double warm_length_ = std::numeric_limits<double>::quiet_NaN();
+
+    // --- Adaptation: step size + mass matrix, and trajectory length ---
+    std::unique_ptr<NUTSAdaptationController> nuts_adapt_;
+    TrajectoryLengthAdapter trajectory_;
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <RcppArmadillo.h>
+#include <algorithm>
+#include "rng/rng_utils.h"
+
+
+/**
+ * InformedEdgeSchedule - which edge indicators a sweep proposes to flip
+ *
+ * The sequential sweep proposes a flip for every pair once per iteration,
+ * however unlikely the flip is; on a sparse, well-identified graph almost
+ * all of these evaluations are rejected. This schedule instead draws the
+ * pairs of a sweep at random, with replacement, in proportion to a locally
+ * balanced weight of each pair: the mean acceptance probability
+ * min(1, exp(r)) of its flips, which satisfies g(t) = t g(1/t). Pairs that
+ * flip often are then proposed often, and pairs that never flip rarely.
+ *
+ * Weights that follow the current state would have to be refreshed at the
+ * proposed state of every move for the sweep to remain exact. They are
+ * therefore learned during warmup only, from the moves of the sequential
+ * sweep, and frozen afterwards: each move of a sampling sweep is then an
+ * ordinary Metropolis-Hastings flip of a pair drawn from a fixed
+ * distribution, which keeps the posterior invariant. A floor of
+ * `uniform_share / num_pairs` on every selection probability keeps each
+ * pair reachable.
+ */
+class InformedEdgeSchedule {
+public:
+  /// Whether the models draw their edge moves from this schedule.
+  bool enabled = false;
+  /// Whether the weights are still being learned (warmup only).
+  bool adapting = false;
+
+  /// Share of the selection probability spread uniformly over the pairs.
+  static constexpr double uniform_share = 0.1;
+
+  /// Size the weights for `num_pairs` pairs and forget what was learned.
+  void resize(arma::uword num_pairs) {
+    flip_rate_.zeros(num_pairs);
+    flips_seen_.zeros(num_pairs);
+    cumulative_.reset();
+  }
+
+  /// Whether a sweep draws its pairs from the learned weights.
+  bool drawing() const { return enabled && !adapting && flip_rate_.n_elem > 0; }
+
+  /**
+   * Learn from one move of the sequential sweep: a running mean of the
+   * acceptance probability of pair `pair`. Does nothing outside warmup.
+   */
+  void record(arma::uword pair, double accept_prob) {
+    if (!adapting) return;
+    const double count = ++flips_seen_(pair);
+    flip_rate_(pair) += (accept_prob - flip_rate_(pair)) / count;
+    cumulative_.reset();
+  }
+
+  /// Draw the pair of the next move.
+  arma::uword draw(SafeRNG& rng) {
+    if (cumulative_.is_empty()) build_cumulative();
+    const double u = runif(rng) * cumulative_(cumulative_.n_elem - 1);
+    const auto it = std::upper_bound(cumulative_.begin(), cumulative_.end(), u);
+    const arma::uword pair = static_cast<arma::uword>(it - cumulative_.begin());
+    return std::min(pair, cumulative_.n_elem - 1);
+  }
+
+  /// Learned acceptance rate per pair (num_pairs x 1), for the sampler state.
+  const arma::vec& flip_rates() const { return flip_rate_; }
+
+  /// Restore saved rates; they count as learned from one move each.
+  void set_flip_rates(const arma::mat& rates) {
+    flip_rate_ = arma::vectorise(rates);
+    flips_seen_.ones(rates.n_elem);
+    cumulative_.reset();
+  }
+
+private:
+  /// Cumulative selection probabilities from the current rates.
+  void build_cumulative() {
+    const arma::uword n = flip_rate_.n_elem;
+    const double total = arma::accu(flip_rate_);
+    arma::vec weight(n, arma::fill::value(1.0 / static_cast<double>(n)));
+    if (total > 0.0) {
+      weight = uniform_share * weight + (1.0 - uniform_share) * flip_rate_ / total;
+    }
+    cumulative_ = arma::cumsum(weight);
+  }
+
+  arma::vec flip_rate_;    ///< Mean acceptance probability of each pair's flips
+  arma::vec flips_seen_;   ///< Flips each rate was learned from
+  arma::vec cumulative_;   ///< Cached cumulative weights; empty when stale
+};
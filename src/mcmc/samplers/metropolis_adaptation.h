@@ -1,10 +1,13 @@
 #pragma once
 
 #include <RcppArmadillo.h>
+#include <algorithm>
 #include <cmath>
+#include <vector>
 #include "mcmc/execution/step_result.h"
 #include "mcmc/execution/warmup_schedule.h"
 #include "math/explog_macros.h"
+#include "rng/rng_utils.h"
 
 
 /**
@@ -54,3 +57,147 @@ public:
     }
   }
 };
+
+
+/**
+ * BlockMetropolisAdaptation - adaptive random-walk proposals for parameter blocks
+ *
+ * Proposes all parameters of a block jointly, y = x + lambda L z with z
+ * standard normal and L the lower Cholesky factor of the block's proposal
+ * covariance (Haario, Saksman and Tamminen, 2001). Until enough draws are
+ * in, L is the diagonal of the block's per-parameter proposal SDs.
+ *
+ * During warmup the global scale lambda follows a Robbins-Monro recursion
+ * on log lambda toward an acceptance rate of 0.44 for one parameter and
+ * 0.234 for more (Andrieu and Thoms, 2008, Algorithm 4), and from the
+ * second quarter of warmup on the block's draws feed a running covariance
+ * that replaces L every 50 draws. Both are frozen after warmup, so the
+ * sampling-phase kernel is fixed.
+ */
+class BlockMetropolisAdaptation {
+public:
+  /// Whether the models use blocked proposals.
+  bool enabled = false;
+
+  /**
+   * Size the blocks and start each from a diagonal proposal.
+   *
+   * @param block_sizes  Number of parameters of each block
+   * @param proposal_sd  Row b holds the initial SDs of block b in its
+   *                     first block_sizes(b) entries
+   */
+  void resize(const arma::uvec& block_sizes, const arma::mat& proposal_sd) {
+    const arma::uword num_blocks = block_sizes.n_elem;
+    cholesky_.resize(num_blocks);
+    mean_.resize(num_blocks);
+    scatter_.resize(num_blocks);
+    draws_.zeros(num_blocks);
+    log_scale_.zeros(num_blocks);
+    learned_.zeros(num_blocks);
+    for (arma::uword b = 0; b < num_blocks; ++b) {
+      const arma::uword d = block_sizes(b);
+      cholesky_[b] = arma::diagmat(proposal_sd.row(b).head(d).t());
+      mean_[b].zeros(d);
+      scatter_[b].zeros(d, d);
+    }
+  }
+
+  /// Number of warmup iterations; adaptation stops after them.
+  void set_warmup(int total_warmup) { total_warmup_ = total_warmup; }
+
+  arma::uword num_blocks() const { return cholesky_.size(); }
+
+  /// Joint random-walk proposal for one block.
+  arma::vec propose(arma::uword block, const arma::vec& current, SafeRNG& rng) const {
+    const arma::mat& factor = cholesky_[block];
+    arma::vec z(factor.n_rows);
+    for (arma::uword k = 0; k < z.n_elem; ++k) z(k) = rnorm(rng);
+    return current + std::exp(log_scale_(block)) * (arma::trimatl(factor) * z);
+  }
+
+  /**
+   * Learn from one update of a block; does nothing outside warmup.
+   *
+   * @param block        Block index
+   * @param state        The block's parameters after the update
+   * @param accept_prob  Acceptance probability of the update
+   * @param iteration    Warmup iteration (0-based)
+   */
+  void adapt(arma::uword block, const arma::vec& state, double accept_prob, int iteration) {
+    if (iteration >= total_warmup_ || iteration < 1) return;
+
+    const arma::uword d = state.n_elem;
+    const double target = d == 1 ? 0.44 : 0.234;
+    const double rm_weight = std::pow(iteration, -0.75);
+    log_scale_(block) = std::clamp(
+      log_scale_(block) + rm_weight * (accept_prob - target), -10.0, 5.0);
+
+    if (iteration < total_warmup_ / 4) return;
+    const double count = ++draws_(block);
+    const arma::vec delta = state - mean_[block];
+    mean_[block] += delta / count;
+    scatter_[block] += delta * (state - mean_[block]).t();
+    if (count >= std::max(20.0, 10.0 * d) && std::fmod(count, 50.0) == 0.0) {
+      refresh(block);
+    }
+  }
+
+  /**
+   * The learned proposals, one row per block: log lambda, whether the
+   * covariance has been learned, and L column-major (zero-padded).
+   */
+  arma::mat state() const {
+    arma::mat out(num_blocks(), state_columns(), arma::fill::zeros);
+    for (arma::uword b = 0; b < num_blocks(); ++b) {
+      out(b, 0) = log_scale_(b);
+      out(b, 1) = learned_(b);
+      const arma::uword n = cholesky_[b].n_elem;
+      if (n > 0) out.row(b).cols(2, 1 + n) = arma::vectorise(cholesky_[b]).t();
+    }
+    return out;
+  }
+
+  /// Columns of state(): two plus the square of the largest block size.
+  arma::uword state_columns() const {
+    arma::uword max_size = 0;
+    for (const arma::mat& factor : cholesky_) max_size = std::max(max_size, factor.n_rows);
+    return 2 + max_size * max_size;
+  }
+
+  /// Restore proposals saved by state(); blocks keep their sizes.
+  void restore(const arma::mat& saved) {
+    for (arma::uword b = 0; b < num_blocks(); ++b) {
+      const arma::uword d = cholesky_[b].n_rows;
+      log_scale_(b) = saved(b, 0);
+      learned_(b) = saved(b, 1);
+      if (d > 0) {
+        cholesky_[b] = arma::reshape(saved.row(b).cols(2, 1 + d * d).t(), d, d);
+      }
+    }
+  }
+
+private:
+  /// Replace L with the factor of the block's running covariance.
+  void refresh(arma::uword block) {
+    const arma::uword d = mean_[block].n_elem;
+    arma::mat covariance = scatter_[block] / (draws_(block) - 1.0);
+    covariance.diag() += 1e-6;
+    arma::mat factor;
+    if (!arma::chol(factor, covariance, "lower")) return;
+    if (!learned_(block)) {
+      // The scale of Haario et al. for the first learned covariance;
+      // Robbins-Monro takes it from there
+      log_scale_(block) = std::log(2.38 / std::sqrt(static_cast<double>(d)));
+      learned_(block) = 1.0;
+    }
+    cholesky_[block] = factor;
+  }
+
+  std::vector<arma::mat> cholesky_;  ///< Lower Cholesky factor L per block
+  std::vector<arma::vec> mean_;      ///< Running mean of the warmup draws per block
+  std::vector<arma::mat> scatter_;   ///< Running sum of squared deviations per block
+  arma::vec draws_;                  ///< Warmup draws in each running covariance
+  arma::vec log_scale_;              ///< log lambda per block
+  arma::vec learned_;                ///< 1 = L comes from a learned covariance
+  int total_warmup_ = 0;
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "mcmc/samplers/sampler_base.h"
+#include "mcmc/execution/chain_profile.h"
 #include "mcmc/execution/sampler_config.h"
 #include "mcmc/execution/warmup_schedule.h"
 #include "models/base_model.h"
@@ -53,7 +54,10 @@ public:
             initialize(model);
         }
 
-        model.do_one_metropolis_step(iteration);
+        {
+            BGMS_PROFILE_SCOPE(MetropolisSweep);
+            model.do_one_metropolis_step(iteration);
+        }
 
         StepResult result;
         result.accept_prob = model.last_metropolis_mean_accept_prob();
@@ -3,8 +3,10 @@
 #include <RcppArmadillo.h>
 #include <cmath>
 #include <algorithm>
+#include <vector>
 #include "mcmc/execution/warmup_schedule.h"
 #include "math/explog_macros.h"
+#include "mcmc/algorithms/nuts_metric.h"
 
 
 /**
@@ -32,6 +34,8 @@ public:
   double kappa;
   /// Iteration counter.
   int t;
+  /// Step size at construction or the last restart.
+  double start_step_size;
 
   DualAveraging(double initial_step_size)
     : log_step_size(MY_LOG(initial_step_size)),
@@ -41,7 +45,8 @@ public:
       gamma(0.05),
       t0(10.0),
       kappa(0.75),
-      t(1) {}
+      t(1),
+      start_step_size(initial_step_size) {}
 
   void update(double accept_prob, double target_accept) {
     double eta = 1.0 / (t + t0);
@@ -60,10 +65,14 @@ public:
     mu = MY_LOG(10.0 * new_step_size);
     hbar = 0.0;
     t = 1;
+    start_step_size = new_step_size;
   }
 
   double current() const { return MY_EXP(log_step_size); }
-  double averaged() const { return MY_EXP(log_step_size_avg); }
+  /// Averaged step size; before the first update, the start value exactly.
+  double averaged() const {
+    return t > 1 ? MY_EXP(log_step_size_avg) : start_step_size;
+  }
 };
 
 
@@ -95,16 +104,83 @@ public:
   }
 
   arma::vec variance() const {
+    return blend_with_prior(m2 / std::max(1.0, count - 1.0), count);
+  }
+
+  /**
+   * Pooled within-chain variance of several chains' windows: the summed
+   * squared deviations over the summed degrees of freedom, blended with the
+   * prior as in variance() with the weight of all draws. Equals variance()
+   * for a single window.
+   */
+  static arma::vec pooled_variance(const std::vector<const DiagMassMatrixAccumulator*>& windows) {
+    arma::vec m2_sum = windows.front()->m2;
+    double n = windows.front()->count;
+    for (size_t c = 1; c < windows.size(); ++c) {
+      m2_sum += windows[c]->m2;
+      n += windows[c]->count;
+    }
+    const double df = n - static_cast<double>(windows.size());
+    return blend_with_prior(m2_sum / std::max(1.0, df), n);
+  }
+
+  void reset() {
+    count = 0;
+    mean.zeros();
+    m2.zeros();
+  }
+
+private:
+  static arma::vec blend_with_prior(const arma::vec& empirical, double n) {
     static constexpr double prior_weight = 5.0;
     static constexpr double prior_variance = 1e-3;
-    double n = static_cast<double>(count);
-
-    arma::vec empirical = m2 / std::max(1.0, n - 1.0);
     arma::vec prior = arma::ones(empirical.n_elem) * prior_variance;
     arma::vec var = (n / (n + prior_weight)) * empirical
     + (prior_weight / (n + prior_weight)) * prior;
     return var;
   }
+};
+
+/**
+ * DenseMassMatrixAccumulator - Online dense mass matrix estimator
+ *
+ * Welford running covariance of parameter samples, shrunk toward a small
+ * multiple of the identity with the same prior weight as
+ * DiagMassMatrixAccumulator. Its diagonal therefore equals
+ * DiagMassMatrixAccumulator::variance(). Used by NUTSAdaptationController
+ * when a dense or low-rank metric is requested.
+ */
+class DenseMassMatrixAccumulator {
+public:
+  /// Number of samples accumulated.
+  int count;
+  /// Running mean of parameter samples.
+  arma::vec mean;
+  /// Running sum of outer products of deviations.
+  arma::mat m2;
+
+  DenseMassMatrixAccumulator(int dim)
+    : count(0), mean(arma::zeros(dim)), m2(arma::zeros(dim, dim)) {}
+
+  void update(const arma::vec& sample) {
+    count++;
+    arma::vec delta = sample - mean;
+    mean += delta / count;
+    arma::vec delta2 = sample - mean;
+    m2 += delta * delta2.t();
+  }
+
+  arma::mat covariance() const {
+    static constexpr double prior_weight = 5.0;
+    static constexpr double prior_variance = 1e-3;
+    double n = static_cast<double>(count);
+
+    arma::mat empirical = m2 / std::max(1.0, n - 1.0);
+    empirical = 0.5 * (empirical + empirical.t());
+    arma::mat cov = (n / (n + prior_weight)) * empirical;
+    cov.diag() += (prior_weight / (n + prior_weight)) * prior_variance;
+    return cov;
+  }
 
   void reset() {
     count = 0;
@@ -119,6 +195,19 @@ public:
  * Coordinates step-size dual averaging (Stages 1, 2, 3a, 3c) and
  * mass-matrix estimation in doubling windows (Stage 2). Step size
  * is frozen at the Stage 3b boundary.
+ *
+ * With a dense or low-rank metric, Stage 2 accumulates the full sample
+ * covariance instead. At each window end, metric() is refit as a
+ * LinearMetric, and inv_mass_diag() holds its diagonal.
+ *
+ * With an adaptive Stage 2 (WarmupSchedule::adaptive_stage2()), a window
+ * end that changed the inverse mass diagonal and the averaged step size by
+ * less than the schedule's tolerance, relative to the previous window,
+ * ends Stage 2 there (WarmupSchedule::end_stage2_after()).
+ *
+ * With `pool_windows` (diagonal metric only), a window end does not update
+ * the mass matrix: window_pending() turns true until the chain runner has
+ * combined the windows of all chains and called end_pooled_window().
  */
 class NUTSAdaptationController {
 public:
@@ -126,10 +215,17 @@ public:
                           double initial_step_size,
                           double target_accept,
                           WarmupSchedule& schedule_ref,
-                          bool learn_mass_matrix = true)
+                          bool learn_mass_matrix = true,
+                          MetricKind metric_kind = MetricKind::Diagonal,
+                          int metric_rank = 10,
+                          bool pool_windows = false)
     : schedule(schedule_ref),
       learn_mass_matrix_(learn_mass_matrix),
-      mass_accumulator(dim),
+      pool_windows_(pool_windows && metric_kind == MetricKind::Diagonal),
+      metric_kind_(metric_kind),
+      metric_rank_(metric_rank),
+      mass_accumulator(metric_kind == MetricKind::Diagonal ? dim : 0),
+      dense_accumulator(metric_kind == MetricKind::Diagonal ? 0 : dim),
       step_adapter(initial_step_size),
       inv_mass_(arma::ones<arma::vec>(dim)),
       step_size_(initial_step_size),
@@ -158,16 +254,33 @@ public:
      *    – only while we are inside Stage-2
      * --------------------------------------------------------- */
     if (schedule.in_stage2(iteration) && learn_mass_matrix_) {
-      mass_accumulator.update(theta);
+      if (metric_kind_ == MetricKind::Diagonal) {
+        mass_accumulator.update(theta);
+      } else {
+        dense_accumulator.update(theta);
+      }
       int w = schedule.current_window(iteration);
       if (iteration + 1 == schedule.window_ends[w]) {
-        // inv_mass = variance (not 1/variance)
-        // Higher variance → higher inverse mass → parameter moves more freely
-        inv_mass_ = mass_accumulator.variance();
-        mass_accumulator.reset();
-        // Signal that mass matrix was updated - caller should run heuristic
-        // and call reinit_stepsize() with the new step size
-        mass_matrix_updated_ = true;
+        if (pool_windows_) {
+          // Keep the window for the chain runner to pool
+          window_pending_ = true;
+        } else {
+          // inv_mass = variance (not 1/variance)
+          // Higher variance → higher inverse mass → parameter moves more freely
+          const arma::vec previous_inv_mass = inv_mass_;
+          if (metric_kind_ == MetricKind::Diagonal) {
+            inv_mass_ = mass_accumulator.variance();
+            mass_accumulator.reset();
+          } else {
+            update_linear_metric();
+          }
+          if (schedule.adaptive_stage2()) {
+            end_stage2_if_stable(w, previous_inv_mass);
+          }
+          // Signal that mass matrix was updated - caller should run heuristic
+          // and call reinit_stepsize() with the new step size
+          mass_matrix_updated_ = true;
+        }
       }
     }
 
@@ -179,16 +292,43 @@ public:
     }
   }
 
+  /**
+   * Start from a saved inverse mass diagonal, e.g. when a chain continues
+   * an earlier run. Construct the controller with learn_mass_matrix = false
+   * to keep it through warmup.
+   */
+  void set_inv_mass_diag(const arma::vec& inv_mass) { inv_mass_ = inv_mass; }
+
   double current_step_size() const { return step_size_; }
   double final_step_size() const { return step_adapter.averaged(); }
   const arma::vec& inv_mass_diag() const { return inv_mass_; }
 
+  /** Non-diagonal metric fitted in Stage 2 (empty for a diagonal metric). */
+  const LinearMetric& metric() const { return metric_; }
+  bool has_linear_metric() const { return !metric_.empty(); }
+
   /**
    * Check if the mass matrix was just updated and needs step size re-initialization.
    * After calling this, call reinit_stepsize() with the result of the heuristic.
    */
   bool mass_matrix_just_updated() const { return mass_matrix_updated_; }
 
+  /** Whether a Stage-2 window has ended and awaits end_pooled_window(). */
+  bool window_pending() const { return window_pending_; }
+
+  /** Draws of the current (with window_pending(), the ended) window. */
+  const DiagMassMatrixAccumulator& window_accumulator() const { return mass_accumulator; }
+
+  /**
+   * Close the pending window with an inverse mass diagonal pooled over
+   * the chains. Then call reinit_stepsize(), as after a window end.
+   */
+  void end_pooled_window(const arma::vec& inv_mass) {
+    inv_mass_ = inv_mass;
+    mass_accumulator.reset();
+    window_pending_ = false;
+  }
+
   /** Target acceptance probability for dual averaging and heuristic. */
   double target_acceptance() const { return target_accept_; }
 
@@ -210,9 +350,47 @@ public:
   }
 
 private:
+  /**
+   * End Stage 2 after window `w` if it moved the inverse mass diagonal
+   * (from `previous_inv_mass`) and the averaged step size (from the last
+   * window's) by less than the schedule's tolerance. The first window is
+   * compared with the unit start, so it never ends Stage 2.
+   */
+  void end_stage2_if_stable(int w, const arma::vec& previous_inv_mass) {
+    const double step = step_adapter.averaged();
+    const double tolerance = schedule.stable_tolerance;
+    if (w > 0 && last_window_step_size_ > 0.0) {
+      const double mass_change =
+          arma::max(arma::abs(inv_mass_ - previous_inv_mass) / previous_inv_mass);
+      const double step_change = std::abs(step / last_window_step_size_ - 1.0);
+      if (mass_change < tolerance && step_change < tolerance) {
+        schedule.end_stage2_after(w);
+      }
+    }
+    last_window_step_size_ = step;
+  }
+
+  void update_linear_metric() {
+    arma::mat cov = dense_accumulator.covariance();
+    dense_accumulator.reset();
+    inv_mass_ = cov.diag();
+    if (metric_kind_ == MetricKind::Dense) {
+      metric_.set_dense(cov);
+    } else {
+      metric_.set_low_rank(inv_mass_, low_rank_covariance_factor(cov, metric_rank_));
+    }
+  }
+
   WarmupSchedule& schedule;
   bool learn_mass_matrix_;
+  bool pool_windows_;
+  bool window_pending_ = false;
+  double last_window_step_size_ = 0.0;  ///< Averaged step size at the last window end
+  MetricKind metric_kind_;
+  int metric_rank_;
   DiagMassMatrixAccumulator mass_accumulator;
+  DenseMassMatrixAccumulator dense_accumulator;
+  LinearMetric metric_;
   DualAveraging step_adapter;
   arma::vec inv_mass_;
   double step_size_;
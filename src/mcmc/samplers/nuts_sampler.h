@@ -1,18 +1,38 @@
 #pragma once
 
 #include <RcppArmadillo.h>
+#include <algorithm>
 #include <memory>
+#include <stdexcept>
+#include <string>
 #include <utility>
 #include "mcmc/algorithms/hmc.h"
 #include "mcmc/algorithms/leapfrog.h"
 #include "mcmc/algorithms/nuts.h"
+#include "mcmc/algorithms/nuts_iterative.h"
+#include "mcmc/algorithms/nuts_metric.h"
 #include "mcmc/execution/sampler_config.h"
+#include "mcmc/execution/sampler_state.h"
 #include "mcmc/execution/step_result.h"
 #include "mcmc/execution/warmup_schedule.h"
 #include "mcmc/samplers/nuts_adaptation.h"
 #include "mcmc/samplers/sampler_base.h"
 #include "models/base_model.h"
 
+/**
+ * Joint log posterior and gradient of `model` with respect to the latent
+ * coordinates y = A^{-1} theta of a LinearMetric.
+ */
+struct LatentJoint {
+    BaseModel& model;
+    const LinearMetric& metric;
+
+    std::pair<double, arma::vec> operator()(const arma::vec& y) const {
+        auto [logp, grad] = model.logp_and_gradient(metric.to_position(y));
+        return {logp, metric.pull_back(grad)};
+    }
+};
+
 /**
  * NUTSSampler - No-U-Turn Sampler with warmup adaptation
  *
@@ -24,28 +44,52 @@
  *  - Stage-3c boundary: edge selection just activated → restart dual averaging
  *    so adaptation can tune to the new geometry quickly.
  *  - Mass-matrix update: when the controller emits a new mass matrix, re-run
- *    the step-size heuristic with the new metric.
+ *    the step-size heuristic with the new metric. With config.pooled_warmup
+ *    and a diagonal metric, the window ends are left to the chain runner,
+ *    which pools them across chains (window_pending(), end_window()).
  *  - Phase-aware reverse check: observe during warmup, enforce during sampling
  *    (constrained integration only).
  *
  * For constrained models (edge selection or sparse graph), uses RATTLE
  * integration: full Cholesky space with position and momentum projection at
  * each leapfrog step.
+ *
+ * Owns a NUTSArena so tree building reuses the same buffers across
+ * iterations of the chain. When nothing has changed the target since the
+ * previous step, the next trajectory starts from the arena's accepted
+ * state with its stored log posterior and gradient, saving one gradient
+ * evaluation per iteration (see can_reuse_start()).
+ *
+ * With `iterative` set ("nuts-iterative"), unconstrained steps use
+ * nuts_step_iterative, which gives the same draws without recursion or
+ * std::function. Constrained steps always use nuts_step.
+ *
+ * With a dense or low-rank metric (config.nuts_metric), unconstrained steps
+ * run identity-mass NUTS on y = A^{-1} theta, where A A^T is the learned
+ * inverse mass (see LinearMetric). Constrained steps keep its diagonal.
  */
 class NUTSSampler : public SamplerBase {
 public:
-    explicit NUTSSampler(const SamplerConfig& config, WarmupSchedule& schedule)
+    explicit NUTSSampler(const SamplerConfig& config, WarmupSchedule& schedule,
+                         bool iterative = false)
         : step_size_(config.initial_step_size),
           target_acceptance_(config.target_acceptance),
           schedule_(schedule),
           max_tree_depth_(config.max_tree_depth),
+          learn_mass_matrix_(config.learn_mass_matrix),
           reverse_check_(config.reverse_check),
           reverse_check_tol_(config.reverse_check_tol),
+          iterative_(iterative),
+          metric_kind_(metric_kind_from_string(config.nuts_metric)),
+          metric_rank_(config.nuts_metric_rank),
+          pooled_warmup_(config.pooled_warmup),
           initialized_(false)
     {}
 
     bool has_nuts_diagnostics() const override { return true; }
 
+    void target_changed() override { start_valid_ = false; }
+
     StepResult step(BaseModel& model, int iteration) override {
         // Stage 3c boundary: edge selection just activated.
         // Restart dual averaging so adaptation can tune to the new
@@ -100,42 +144,8 @@ public:
 
         // If mass matrix was just updated, apply it and re-run the step-size heuristic
         if (nuts_adapt_->mass_matrix_just_updated()) {
-            arma::vec new_inv_mass = nuts_adapt_->inv_mass_diag();
-            model.set_inv_mass(new_inv_mass);
-
-            SafeRNG& rng = model.get_rng();
-
-            if (uses_constrained_integration(model)) {
-                arma::vec x = model.get_full_position();
-                auto joint_fn = [&model](const arma::vec& params)
-                    -> std::pair<double, arma::vec> {
-                    return model.logp_and_gradient_full(params);
-                };
-                ProjectPositionFn proj_pos = [&model, &new_inv_mass](arma::vec& pos) {
-                    model.project_position(pos, new_inv_mass);
-                };
-                ProjectMomentumFn proj_mom = [&model, &new_inv_mass](arma::vec& mom, const arma::vec& pos) {
-                    model.project_momentum(mom, pos, new_inv_mass);
-                };
-                double new_eps = heuristic_initial_step_size_constrained(
-                    x, joint_fn, new_inv_mass, proj_pos, proj_mom, rng,
-                    target_acceptance_, nuts_adapt_->current_step_size());
-                nuts_adapt_->reinit_stepsize(new_eps);
-            } else {
-                arma::vec theta = model.get_vectorized_parameters();
-                auto grad_fn = [&model](const arma::vec& params) -> arma::vec {
-                    return model.logp_and_gradient(params).second;
-                };
-                auto joint_fn = [&model](const arma::vec& params)
-                    -> std::pair<double, arma::vec> {
-                    return model.logp_and_gradient(params);
-                };
-                arma::vec active_inv_mass = model.get_active_inv_mass();
-                double new_eps = heuristic_initial_step_size(
-                    theta, grad_fn, joint_fn, active_inv_mass, rng,
-                    target_acceptance_, nuts_adapt_->current_step_size());
-                nuts_adapt_->reinit_stepsize(new_eps);
-            }
+            nuts_adapt_->reinit_stepsize(
+                apply_inv_mass(model, nuts_adapt_->inv_mass_diag()));
         }
 
         // Update step_size_ from controller (may have changed due to mass update)
@@ -150,34 +160,219 @@ public:
         initialized_ = true;
     }
 
+    /** Save the step size in use and the inverse mass diagonal. */
+    void save_state(SamplerState& state) const override {
+        if (!nuts_adapt_) return;
+        state.step_size = step_size_;
+        state.inv_mass = nuts_adapt_->inv_mass_diag();
+    }
+
+    /**
+     * Start from a saved step size and inverse mass diagonal. initialize()
+     * then skips the step-size heuristic, and warmup keeps the saved mass
+     * diagonal while dual averaging continues from the saved step size.
+     * A dense or low-rank metric is not saved; its diagonal is used.
+     */
+    void restore_state(const SamplerState& state) override {
+        if (!state.has_nuts_tuning()) return;
+        warm_step_size_ = state.step_size;
+        warm_inv_mass_ = state.inv_mass;
+    }
+
     double get_step_size() const { return step_size_; }
+    double current_step_size() const override { return step_size_; }
     double get_averaged_step_size() const {
         return nuts_adapt_ ? nuts_adapt_->final_step_size() : step_size_;
     }
     const arma::vec& get_inv_mass() const { return nuts_adapt_->inv_mass_diag(); }
 
+    // --- Pooled warmup (config.pooled_warmup, diagonal metric) ---
+
+    /** Whether a Stage-2 window has ended and awaits end_window(). */
+    bool window_pending() const { return nuts_adapt_ && nuts_adapt_->window_pending(); }
+
+    /** Draws of the pending window, to pool with the other chains'. */
+    const DiagMassMatrixAccumulator& window_statistics() const {
+        return nuts_adapt_->window_accumulator();
+    }
+
+    /**
+     * Close the pending window with the pooled inverse mass diagonal and
+     * run the step-size heuristic under it.
+     *
+     * @return This chain's heuristic step size
+     */
+    double end_window(BaseModel& model, const arma::vec& inv_mass) {
+        nuts_adapt_->end_pooled_window(inv_mass);
+        return apply_inv_mass(model, nuts_adapt_->inv_mass_diag());
+    }
+
+    /** Restart dual averaging from the step size agreed by the chains. */
+    void set_window_step_size(double eps) {
+        nuts_adapt_->reinit_stepsize(eps);
+        step_size_ = eps;
+    }
+
 private:
     bool uses_constrained_integration(const BaseModel& model) const {
         return model.has_constraints();
     }
 
+    /**
+     * Install a new inverse mass diagonal after a window end and re-run the
+     * step-size heuristic under it (and under the refit dense/low-rank
+     * metric, if any).
+     *
+     * @return Step size to restart dual averaging from
+     */
+    double apply_inv_mass(BaseModel& model, const arma::vec& new_inv_mass) {
+        model.set_inv_mass(new_inv_mass);
+        restricted_indices_.reset();
+        start_valid_ = false;  // a refit metric changes the latent target
+        const LinearMetric* metric = active_metric(model);
+
+        SafeRNG& rng = model.get_rng();
+
+        if (uses_constrained_integration(model)) {
+            arma::vec x = model.get_full_position();
+            auto joint_fn = [&model](const arma::vec& params)
+                -> std::pair<double, arma::vec> {
+                return model.logp_and_gradient_full(params);
+            };
+            ProjectPositionFn proj_pos = [&model, &new_inv_mass](arma::vec& pos) {
+                model.project_position(pos, new_inv_mass);
+            };
+            ProjectMomentumFn proj_mom = [&model, &new_inv_mass](arma::vec& mom, const arma::vec& pos) {
+                model.project_momentum(mom, pos, new_inv_mass);
+            };
+            return heuristic_initial_step_size_constrained(
+                x, joint_fn, new_inv_mass, proj_pos, proj_mom, rng,
+                target_acceptance_, nuts_adapt_->current_step_size());
+        }
+        if (metric) {
+            // Same heuristic, in the latent coordinates NUTS runs in.
+            arma::vec y = metric->to_latent(model.get_vectorized_parameters());
+            LatentJoint joint_fn{model, *metric};
+            auto grad_fn = [&joint_fn](const arma::vec& params) -> arma::vec {
+                return joint_fn(params).second;
+            };
+            arma::vec unit_inv_mass = arma::ones<arma::vec>(y.n_elem);
+            return heuristic_initial_step_size(
+                y, grad_fn, joint_fn, unit_inv_mass, rng,
+                target_acceptance_, nuts_adapt_->current_step_size());
+        }
+        arma::vec theta = model.get_vectorized_parameters();
+        auto grad_fn = [&model](const arma::vec& params) -> arma::vec {
+            return model.logp_and_gradient(params).second;
+        };
+        auto joint_fn = [&model](const arma::vec& params)
+            -> std::pair<double, arma::vec> {
+            return model.logp_and_gradient(params);
+        };
+        arma::vec active_inv_mass = model.get_active_inv_mass();
+        return heuristic_initial_step_size(
+            theta, grad_fn, joint_fn, active_inv_mass, rng,
+            target_acceptance_, nuts_adapt_->current_step_size());
+    }
+
+    /**
+     * Learned dense/low-rank metric on the active parameters, or nullptr
+     * for a diagonal metric. When edge selection leaves only some
+     * parameters active, the metric is restricted to them. The restriction
+     * is cached until the active set or the metric changes.
+     */
+    const LinearMetric* active_metric(const BaseModel& model) {
+        if (!nuts_adapt_ || !nuts_adapt_->has_linear_metric()) return nullptr;
+        const LinearMetric& full = nuts_adapt_->metric();
+
+        arma::uvec indices = model.get_active_parameter_indices();
+        bool identity = indices.n_elem == full.dim();
+        for (arma::uword k = 0; identity && k < indices.n_elem; ++k) {
+            identity = indices(k) == k;
+        }
+        if (identity) return &full;
+
+        if (indices.n_elem != restricted_indices_.n_elem ||
+            arma::any(indices != restricted_indices_)) {
+            restricted_ = full.restrict(indices);
+            restricted_indices_ = indices;
+        }
+        return restricted_.empty() ? nullptr : &restricted_;
+    }
+
+    /** Integration path of a step, for can_reuse_start(). */
+    enum class StartPath { Diagonal, Latent, Constrained };
+
+    /**
+     * Whether the step can start from arena_.z, the accepted state of the
+     * previous step, with its stored log posterior and gradient. The
+     * target must be unchanged (no target_changed() or new metric since),
+     * the step must take the same path, and the model must still be at
+     * the position that step left it: updates between steps, such as the
+     * Metropolis sweeps of tune_proposal_sd(), may move it.
+     *
+     * @param position  The model's current position for this path
+     * @param path      Integration path of this step
+     */
+    bool can_reuse_start(const arma::vec& position, StartPath path) const {
+        return start_valid_ && path == start_path_ &&
+            position.n_elem == start_position_.n_elem &&
+            std::equal(position.begin(), position.end(), start_position_.begin());
+    }
+
+    /** Record where the step left the model, for the next can_reuse_start(). */
+    void remember_start(const arma::vec& position, StartPath path) {
+        start_position_ = position;
+        start_path_ = path;
+        start_valid_ = true;
+    }
+
     StepResult do_unconstrained_step(BaseModel& model) {
         arma::vec theta = model.get_vectorized_parameters();
         SafeRNG& rng = model.get_rng();
 
+        if (const LinearMetric* metric = active_metric(model)) {
+            // A reused start keeps the latent state exactly, rather than
+            // mapping theta back through the metric.
+            const bool reuse = can_reuse_start(theta, StartPath::Latent);
+            arma::vec y = reuse ? arena_.z.theta : metric->to_latent(theta);
+            LatentJoint joint_fn{model, *metric};
+            arma::vec unit_inv_mass = arma::ones<arma::vec>(y.n_elem);
+
+            StepResult result = iterative_
+                ? nuts_step_iterative(
+                    y, step_size_, joint_fn,
+                    unit_inv_mass, rng, max_tree_depth_, &arena_, reuse)
+                : nuts_step(
+                    y, step_size_, joint_fn,
+                    unit_inv_mass, rng, max_tree_depth_,
+                    nullptr, nullptr, true, 0.5, &arena_, reuse);
+
+            result.state = metric->to_position(result.state);
+            model.set_vectorized_parameters(result.state);
+            remember_start(result.state, StartPath::Latent);
+            return result;
+        }
+
         auto joint_fn = [&model](const arma::vec& params)
             -> std::pair<double, arma::vec> {
             return model.logp_and_gradient(params);
         };
 
         arma::vec active_inv_mass = model.get_active_inv_mass();
+        const bool reuse = can_reuse_start(theta, StartPath::Diagonal);
 
-        StepResult result = nuts_step(
-            theta, step_size_, joint_fn,
-            active_inv_mass, rng, max_tree_depth_
-        );
+        StepResult result = iterative_
+            ? nuts_step_iterative(
+                theta, step_size_, joint_fn,
+                active_inv_mass, rng, max_tree_depth_, &arena_, reuse)
+            : nuts_step(
+                theta, step_size_, joint_fn,
+                active_inv_mass, rng, max_tree_depth_,
+                nullptr, nullptr, true, 0.5, &arena_, reuse);
 
         model.set_vectorized_parameters(result.state);
+        remember_start(result.state, StartPath::Diagonal);
         return result;
     }
 
@@ -206,10 +401,12 @@ private:
             inv_mass, rng, max_tree_depth_,
             &proj_pos, &proj_mom,
             reverse_check_ && enforce_reverse_check_,
-            reverse_check_tol_
+            reverse_check_tol_, &arena_,
+            can_reuse_start(x, StartPath::Constrained)
         );
 
         model.set_full_position(result.state);
+        remember_start(result.state, StartPath::Constrained);
         return result;
     }
 
@@ -217,6 +414,21 @@ private:
         int dim = static_cast<int>(model.full_parameter_dimension());
         SafeRNG& rng = model.get_rng();
 
+        if (warm_inv_mass_.n_elem > 0) {
+            if (warm_inv_mass_.n_elem != static_cast<arma::uword>(dim)) {
+                throw std::invalid_argument(
+                    "warm_start: `inv_mass` has " + std::to_string(warm_inv_mass_.n_elem) +
+                    " entries, but this model has " + std::to_string(dim) + " parameters.");
+            }
+            model.set_inv_mass(warm_inv_mass_);
+            step_size_ = warm_step_size_;
+            nuts_adapt_ = std::make_unique<NUTSAdaptationController>(
+                dim, warm_step_size_, target_acceptance_, schedule_,
+                false, MetricKind::Diagonal, metric_rank_);
+            nuts_adapt_->set_inv_mass_diag(warm_inv_mass_);
+            return;
+        }
+
         // Initialize inverse mass to ones
         arma::vec init_inv_mass = arma::ones<arma::vec>(dim);
         model.set_inv_mass(init_inv_mass);
@@ -258,10 +470,23 @@ private:
 
         step_size_ = init_eps;
 
-        // Construct the adaptation controller with the shared schedule
+        // Construct the adaptation controller with the shared schedule.
+        // RATTLE integrates in x-space with a diagonal metric only.
+        MetricKind metric_kind = uses_constrained_integration(model)
+            ? MetricKind::Diagonal
+            : metric_kind_;
         nuts_adapt_ = std::make_unique<NUTSAdaptationController>(
             dim, init_eps, target_acceptance_, schedule_,
-            /*learn_mass_matrix=*/true);
+            learn_mass_matrix_, metric_kind, metric_rank_, pooled_warmup_);
+
+        // A model started at its pseudoposterior mode supplies the inverse
+        // curvature there; start from it and re-tune the step size under it.
+        arma::vec seeded_inv_mass = model.initial_inv_mass();
+        if (seeded_inv_mass.n_elem == static_cast<arma::uword>(dim)) {
+            nuts_adapt_->set_inv_mass_diag(seeded_inv_mass);
+            step_size_ = apply_inv_mass(model, seeded_inv_mass);
+            nuts_adapt_->reinit_stepsize(step_size_);
+        }
     }
 
     // --- Configuration / state ---
@@ -269,8 +494,13 @@ private:
     double target_acceptance_;
     WarmupSchedule& schedule_;
     int max_tree_depth_;
+    bool learn_mass_matrix_;
     bool reverse_check_;
     double reverse_check_tol_;
+    bool iterative_;
+    MetricKind metric_kind_;
+    int metric_rank_;
+    bool pooled_warmup_;
 
     // --- Lifecycle flags ---
     bool initialized_;
@@ -280,6 +510,22 @@ private:
     /// Set in step() before do_*_step(). Read by the constrained path.
     bool enforce_reverse_check_ = false;
 
+    // --- Warm start (restore_state); empty inverse mass = cold start ---
+    double warm_step_size_ = 0.0;
+    arma::vec warm_inv_mass_;
+
     // --- Adaptation controller (owns step size + mass matrix) ---
     std::unique_ptr<NUTSAdaptationController> nuts_adapt_;
+
+    /// Trajectory buffers reused by every nuts_step of this chain.
+    NUTSArena arena_;
+
+    // --- Start point carried to the next step (see can_reuse_start()) ---
+    bool start_valid_ = false;
+    StartPath start_path_ = StartPath::Diagonal;
+    arma::vec start_position_;
+
+    /// Metric restricted to the active parameters (see active_metric()).
+    LinearMetric restricted_;
+    arma::uvec restricted_indices_;
 };
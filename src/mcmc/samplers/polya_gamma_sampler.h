@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdexcept>
+#include "mcmc/samplers/sampler_base.h"
+#include "mcmc/execution/sampler_config.h"
+#include "mcmc/execution/warmup_schedule.h"
+#include "models/base_model.h"
+
+/**
+ * PolyaGammaSampler - Pólya-Gamma augmented block Gibbs sampler
+ *
+ * Delegates to the model's do_one_polya_gamma_step(): given Pólya-Gamma
+ * draws for the logistic factors of the pseudolikelihood, and latent
+ * variables for the priors, the parameters have Gaussian full
+ * conditionals and are drawn exactly, a block at a time. Every draw is
+ * accepted and there is no step size or proposal to tune; only the
+ * proposal SDs of the edge-indicator moves are learned, in warmup
+ * stage 3b.
+ */
+class PolyaGammaSampler : public SamplerBase {
+public:
+    PolyaGammaSampler(const SamplerConfig& config, WarmupSchedule& schedule) {
+        (void)config;
+        (void)schedule;
+    }
+
+    /** Refuse a model without Gaussian full conditionals. */
+    void initialize(BaseModel& model) override {
+        if (!model.supports_polya_gamma()) {
+            throw std::runtime_error(
+                "sampler_type \"polya-gamma\" needs binary variables and normal, Cauchy "
+                "or beta-prime (whole alpha + beta) priors.");
+        }
+    }
+
+    /** One Gibbs sweep; the acceptance probability is 1. */
+    StepResult step(BaseModel& model, int iteration) override {
+        (void)iteration;
+        model.do_one_polya_gamma_step();
+        StepResult result;
+        result.accept_prob = 1.0;
+        return result;
+    }
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <limits>
 #include "mcmc/execution/step_result.h"
 #include "models/base_model.h"
 
@@ -39,9 +40,38 @@ public:
      */
     virtual void initialize(BaseModel& /*model*/) {}
 
+    /**
+     * Save the adapted tuning (step size, inverse mass) into `state`.
+     * Default no-op: the Metropolis proposal SDs live in the model.
+     */
+    virtual void save_state(SamplerState& /*state*/) const {}
+
+    /**
+     * Start from saved tuning instead of the initialization heuristics.
+     * Call before initialize(). Default no-op.
+     */
+    virtual void restore_state(const SamplerState& /*state*/) {}
+
+    /**
+     * Tell the sampler that the target changed outside step(): imputed
+     * data, new edge indicators, a tempering swap or a new subsample.
+     * Values a sampler carries from one step to the next (the log
+     * posterior and gradient at its end point) are then stale. Default
+     * no-op.
+     */
+    virtual void target_changed() {}
+
     /**
      * Check if this sampler produces NUTS-style diagnostics
      * (tree depth, divergences, energy)
      */
     virtual bool has_nuts_diagnostics() const { return false; }
+
+    /**
+     * Current integrator step size, for the telemetry. NaN for samplers
+     * without one (Metropolis).
+     */
+    virtual double current_step_size() const {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
 };
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <RcppArmadillo.h>
+#include <algorithm>
+#include <cmath>
+#include "mcmc/execution/sampler_config.h"
+#include "mcmc/execution/sampler_state.h"
+#include "mcmc/execution/step_result.h"
+#include "mcmc/execution/warmup_schedule.h"
+#include "mcmc/samplers/sampler_base.h"
+#include "models/base_model.h"
+#include "rng/rng_utils.h"
+
+/**
+ * SGLDSampler - Preconditioned stochastic-gradient Langevin dynamics
+ *
+ * Every iteration takes one unadjusted Langevin step on the active
+ * parameters,
+ *
+ *   theta' = theta + (eps / 2) G g(theta) + sqrt(eps G) z,   z ~ N(0, I),
+ *
+ * with g the model's gradient estimate (the subsampled control-variate
+ * gradient when the model uses subsampling) and G a diagonal
+ * preconditioner. G is the inverse of a running mean of g^2, a diagonal
+ * Fisher estimate, so eps is in units of the posterior scale. The running
+ * mean adapts during warmup and is then frozen; a parameter that first
+ * becomes active after warmup starts from its own squared gradient. G is
+ * capped at 1, the scale of the priors, so a vanishing gradient cannot
+ * blow up a step.
+ *
+ * There is no accept-reject step: the chain targets the posterior only up
+ * to an O(eps) discretization bias and the gradient noise, the usual SGLD
+ * trade-off. The preconditioner is kept for every parameter (full layout),
+ * so edge moves that change the active set do not reset it.
+ */
+class SGLDSampler : public SamplerBase {
+public:
+    SGLDSampler(const SamplerConfig& config, WarmupSchedule& schedule)
+        : step_size_(config.sgld_step_size), schedule_(schedule) {}
+
+    StepResult step(BaseModel& model, int iteration) override {
+        arma::vec theta = model.get_vectorized_parameters();
+        const arma::vec gradient = model.logp_and_gradient(theta).second;
+
+        StepResult result;
+        if (!gradient.is_finite()) {
+            result.state = theta;
+            result.accept_prob = 0.0;
+            return result;
+        }
+
+        const arma::uword full_dim = model.full_parameter_dimension();
+        if (fisher_.n_elem != full_dim) {
+            fisher_.zeros(full_dim);
+            seen_.zeros(full_dim);
+        }
+
+        const bool adapt = !schedule_.sampling(iteration);
+        const arma::uvec active = model.get_active_parameter_indices();
+        noise_.set_size(theta.n_elem);
+        rnorm_fill(model.get_rng(), noise_.memptr(), theta.n_elem);
+
+        for (arma::uword k = 0; k < theta.n_elem; ++k) {
+            const arma::uword j = active(k);
+            const double g2 = gradient(k) * gradient(k);
+            if (!seen_(j)) {
+                fisher_(j) = g2;
+                seen_(j) = 1;
+            } else if (adapt) {
+                fisher_(j) = decay * fisher_(j) + (1.0 - decay) * g2;
+            }
+            const double precond = 1.0 / std::max(fisher_(j), 1.0);
+            theta(k) += 0.5 * step_size_ * precond * gradient(k) +
+                        std::sqrt(step_size_ * precond) * noise_(k);
+        }
+
+        model.set_vectorized_parameters(theta);
+        result.state = theta;
+        result.accept_prob = 1.0;
+        return result;
+    }
+
+    /** Save the step size and the preconditioner (as an inverse mass). */
+    void save_state(SamplerState& state) const override {
+        if (fisher_.is_empty()) return;
+        state.step_size = step_size_;
+        state.inv_mass = 1.0 / arma::clamp(fisher_, 1.0, arma::datum::inf);
+    }
+
+    /** Continue from a saved preconditioner. */
+    void restore_state(const SamplerState& state) override {
+        if (!state.has_nuts_tuning()) return;
+        fisher_ = 1.0 / state.inv_mass;
+        seen_.ones(fisher_.n_elem);
+    }
+
+    double current_step_size() const override { return step_size_; }
+
+private:
+    static constexpr double decay = 0.99;
+
+    double step_size_;
+    WarmupSchedule& schedule_;
+    arma::vec fisher_;        ///< Running mean of g^2 per parameter (full layout)
+    arma::uvec seen_;         ///< 1 once a parameter's running mean is set
+    arma::vec noise_;         ///< Standard-normal draws of one step
+};
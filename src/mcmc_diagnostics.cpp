@@ -4,7 +4,14 @@
 #include <vector>
 #include <cmath>
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <numeric>
+#include <string>
+
+#include "mcmc/execution/sample_file_reader.h"
+#include "utils/draw_diagnostics.h"
+#include "utils/task_arena.h"
 
 
 // ============================================================================
@@ -24,30 +31,12 @@
 // ============================================================================
 
 
-// --- Single-column ESS (called from worker) ----------------------------------
-
-static double compute_column_ess(const double* x, int n, int max_order) {
-  // Need at least 2 observations to estimate autocorrelation
-  if(n <= 1) return NA_REAL;
-
-  // Step 1: mean
-  double mean = 0.0;
-  for(int i = 0; i < n; i++) mean += x[i];
-  mean /= n;
-
-  // Guard against non-finite input (NaN / Inf)
-  if(!std::isfinite(mean)) return NA_REAL;
-
-  // Step 2: biased autocovariance c[0..max_order]
-  std::vector<double> acov(max_order + 1, 0.0);
-  for(int lag = 0; lag <= max_order; lag++) {
-    double s = 0.0;
-    for(int i = 0; i < n - lag; i++) {
-      s += (x[i] - mean) * (x[i + lag] - mean);
-    }
-    acov[lag] = s / n;
-  }
+// --- AR spectral ESS from the autocovariances -------------------------------
 
+// Steps 3-5 for a chain of n draws with biased autocovariances
+// acov[0..max_order].
+static double ess_from_autocovariance(const std::vector<double>& acov, int n,
+                                      int max_order) {
   // Constant chain: no autocorrelation structure to estimate
   if(acov[0] < 1e-15) return NA_REAL;
 
@@ -111,33 +100,211 @@ static double compute_column_ess(const double* x, int n, int max_order) {
 }
 
 
+// --- Single-column ESS (called from worker) ----------------------------------
+
+// `centered` is scratch space for n values.
+static double compute_column_ess(const double* x, int n, int max_order,
+                                 std::vector<double>& centered) {
+  // Need at least 2 observations to estimate autocorrelation
+  if(n <= 1) return NA_REAL;
+
+  // Step 1: mean
+  double mean = 0.0;
+  for(int i = 0; i < n; i++) mean += x[i];
+  mean /= n;
+
+  // Guard against non-finite input (NaN / Inf)
+  if(!std::isfinite(mean)) return NA_REAL;
+
+  // Step 2: biased autocovariance c[0..max_order]
+  //
+  // All lags are accumulated in one pass over the centered draws, so each
+  // draw is read once instead of once per lag. For every lag the products
+  // are still added in increasing i, so the sums are the same as with one
+  // loop per lag.
+  centered.resize(n);
+  for(int i = 0; i < n; i++) centered[i] = x[i] - mean;
+  const double* d = centered.data();
+
+  std::vector<double> acov(max_order + 1, 0.0);
+  double* s = acov.data();
+  const int full = n - max_order;  // rows with every lag in range
+  for(int i = 0; i < full; i++) {
+    const double di = d[i];
+    for(int lag = 0; lag <= max_order; lag++) s[lag] += di * d[i + lag];
+  }
+  for(int i = std::max(full, 0); i < n; i++) {
+    const double di = d[i];
+    for(int lag = 0; lag < n - i; lag++) s[lag] += di * d[i + lag];
+  }
+  for(int lag = 0; lag <= max_order; lag++) acov[lag] /= n;
+
+  return ess_from_autocovariance(acov, n, max_order);
+}
+
+
+// --- Per-parameter kernels (declared in utils/draw_diagnostics.h) -----------
+
+int ess_max_order(int niter) {
+  return std::min(niter - 1, (int)std::floor(10.0 * std::log10((double)niter)));
+}
+
+
+double draws_ess(const DrawsView& draws, int j, int max_order,
+                 std::vector<double>& buf, std::vector<double>& centered) {
+  double total_ess = 0.0;
+  for(int c = 0; c < draws.nchains(); c++) {
+    const double* col = draws.column(c, j, buf);
+    total_ess += compute_column_ess(col, draws.niter, max_order, centered);
+  }
+  return total_ess;
+}
+
+
+// Gelman-Rubin Rhat (matching coda::gelman.diag point estimate) from the
+// means and unbiased variances of m chains of n draws each.
+static double rhat_from_moments(const std::vector<double>& chain_mean,
+                                const std::vector<double>& chain_var, int n) {
+  const int m = static_cast<int>(chain_mean.size());
+
+  double grand_mean = 0.0;
+  for(int c = 0; c < m; c++) grand_mean += chain_mean[c];
+  grand_mean /= m;
+
+  // Guard: if any chain summary is non-finite (NaN/Inf in input),
+  // skip this parameter.
+  if(!std::isfinite(grand_mean)) return NA_REAL;
+
+  // W = mean of within-chain variances
+  double W = 0.0;
+  for(int c = 0; c < m; c++) W += chain_var[c];
+  W /= m;
+
+  // B = n * variance of chain means (unbiased)
+  double B = 0.0;
+  for(int c = 0; c < m; c++) {
+    double d = chain_mean[c] - grand_mean;
+    B += d * d;
+  }
+  B *= n / (m - 1.0);
+
+  // --- Rhat with df adjustment (full coda formula) ---
+  // s2[c] = chain_var[c]
+  double var_w = 0.0;
+  for(int c = 0; c < m; c++) {
+    double d = chain_var[c] - W;
+    var_w += d * d;
+  }
+  var_w /= (m - 1.0) * m; // var(s2) / m
+
+  double var_b = (2.0 * B * B) / (m - 1.0);
+
+  // cov(W, B) term
+  double cov_wb = 0.0;
+  for(int c = 0; c < m; c++) {
+    double s2c = chain_var[c];
+    double xbar_c = chain_mean[c];
+    double xbar2_c = xbar_c * xbar_c;
+    cov_wb += (s2c - W) * (xbar2_c - 2.0 * grand_mean * xbar_c);
+  }
+  cov_wb *= (double)n / (m - 1.0) / m;
+
+  double V = (n - 1.0) * W / n + (1.0 + 1.0 / m) * B / n;
+  double var_V = ((double)(n - 1) * (n - 1) * var_w
+                 + (1.0 + 1.0 / m) * (1.0 + 1.0 / m) * var_b
+                 + 2.0 * (n - 1.0) * (1.0 + 1.0 / m) * cov_wb) / ((double)n * n);
+
+  double df_V = (var_V > 0) ? (2.0 * V * V) / var_V : 1e6;
+  double df_adj = (df_V + 3.0) / (df_V + 1.0);
+
+  double R2_fixed = (n - 1.0) / n;
+  double R2_random = (W > 0) ? (1.0 + 1.0 / m) * (1.0 / n) * (B / W) : 0.0;
+  double R2 = R2_fixed + R2_random;
+
+  return (W > 0 && R2 > 0) ? std::sqrt(df_adj * R2) : NA_REAL;
+}
+
+
+double draws_rhat(const DrawsView& draws, int j, std::vector<double>& buf) {
+  int n = draws.niter;
+  int m = draws.nchains();
+
+  // Compute per-chain means and variances
+  std::vector<double> chain_mean(m), chain_var(m);
+
+  for(int c = 0; c < m; c++) {
+    const double* col = draws.column(c, j, buf);
+    double s = 0.0;
+    for(int i = 0; i < n; i++) s += col[i];
+    chain_mean[c] = s / n;
+
+    double s2 = 0.0;
+    for(int i = 0; i < n; i++) {
+      double d = col[i] - chain_mean[c];
+      s2 += d * d;
+    }
+    chain_var[c] = s2 / (n - 1.0);
+  }
+
+  return rhat_from_moments(chain_mean, chain_var, n);
+}
+
+
+// --- Draws views over R objects ---------------------------------------------
+
+static DrawsView view_array3d(const Rcpp::NumericVector& array3d) {
+  Rcpp::IntegerVector dims = array3d.attr("dim");
+  DrawsView v;
+  v.niter = dims[0];
+  v.nparam = dims[2];
+  const int nchains = dims[1];
+  for(int c = 0; c < nchains; c++) {
+    v.chain.push_back(array3d.begin() + (std::ptrdiff_t)c * v.niter);
+  }
+  v.iter_stride = 1;
+  v.param_stride = (std::ptrdiff_t)v.niter * nchains;
+  return v;
+}
+
+// `chains` holds one numeric matrix per chain: iter x param, or param x iter
+// when `param_rows` is true. The view points into the R matrices, which
+// `chains` keeps alive.
+static DrawsView view_chains(const Rcpp::List& chains, bool param_rows) {
+  DrawsView v;
+  for(int c = 0; c < chains.size(); c++) {
+    Rcpp::NumericMatrix m = chains[c];
+    const int niter = param_rows ? m.ncol() : m.nrow();
+    const int nparam = param_rows ? m.nrow() : m.ncol();
+    if(c == 0) {
+      v.niter = niter;
+      v.nparam = nparam;
+    } else if(niter != v.niter || nparam != v.nparam) {
+      Rcpp::stop("All chains must have the same dimensions.");
+    }
+    v.chain.push_back(m.begin());
+  }
+  v.iter_stride = param_rows ? v.nparam : 1;
+  v.param_stride = param_rows ? 1 : v.niter;
+  return v;
+}
+
+
 // --- RcppParallel worker for multi-parameter ESS -----------------------------
 
 struct ESSWorker : public RcppParallel::Worker {
-  // Input: 3D array stored as [niter x nchains x nparam] in column-major
-  const double* data;
-  const int niter;
-  const int nchains;
-  const int nparam;
+  const DrawsView& draws;
   const int max_order;
 
   // Output
   RcppParallel::RVector<double> ess;
 
-  ESSWorker(const double* data, int niter, int nchains, int nparam,
-            int max_order, Rcpp::NumericVector ess)
-    : data(data), niter(niter), nchains(nchains), nparam(nparam),
-      max_order(max_order), ess(ess) {}
+  ESSWorker(const DrawsView& draws, int max_order, Rcpp::NumericVector ess)
+    : draws(draws), max_order(max_order), ess(ess) {}
 
   void operator()(std::size_t begin, std::size_t end) {
+    std::vector<double> buf, centered;
     for(std::size_t j = begin; j < end; j++) {
-      double total_ess = 0.0;
-      for(int c = 0; c < nchains; c++) {
-        // Column-major 3D: element [i, c, j] is at data[i + c*niter + j*niter*nchains]
-        const double* col = data + c * niter + j * niter * nchains;
-        total_ess += compute_column_ess(col, niter, max_order);
-      }
-      ess[j] = total_ess;
+      ess[j] = draws_ess(draws, j, max_order, buf, centered);
     }
   }
 };
@@ -148,126 +315,57 @@ struct ESSWorker : public RcppParallel::Worker {
 // ============================================================================
 
 struct RhatWorker : public RcppParallel::Worker {
-  const double* data;
-  const int niter;
-  const int nchains;
-  const int nparam;
+  const DrawsView& draws;
 
   RcppParallel::RVector<double> rhat;
 
-  RhatWorker(const double* data, int niter, int nchains, int nparam,
-             Rcpp::NumericVector rhat)
-    : data(data), niter(niter), nchains(nchains), nparam(nparam),
-      rhat(rhat) {}
+  RhatWorker(const DrawsView& draws, Rcpp::NumericVector rhat)
+    : draws(draws), rhat(rhat) {}
 
   void operator()(std::size_t begin, std::size_t end) {
-    int n = niter;
-    int m = nchains;
-
+    std::vector<double> buf;
     for(std::size_t j = begin; j < end; j++) {
-      // Compute per-chain means and variances
-      double grand_mean = 0.0;
-      std::vector<double> chain_mean(m), chain_var(m);
-
-      for(int c = 0; c < m; c++) {
-        const double* col = data + c * n + j * n * m;
-        double s = 0.0;
-        for(int i = 0; i < n; i++) s += col[i];
-        chain_mean[c] = s / n;
-        grand_mean += chain_mean[c];
-
-        double s2 = 0.0;
-        for(int i = 0; i < n; i++) {
-          double d = col[i] - chain_mean[c];
-          s2 += d * d;
-        }
-        chain_var[c] = s2 / (n - 1.0);
-      }
-      grand_mean /= m;
-
-      // Guard: if any chain summary is non-finite (NaN/Inf in input),
-      // skip this parameter.
-      if(!std::isfinite(grand_mean)) {
-        rhat[j] = NA_REAL;
-        continue;
-      }
+      rhat[j] = draws_rhat(draws, j, buf);
+    }
+  }
+};
 
-      // W = mean of within-chain variances
-      double W = 0.0;
-      for(int c = 0; c < m; c++) W += chain_var[c];
-      W /= m;
 
-      // B = n * variance of chain means (unbiased)
-      double B = 0.0;
-      for(int c = 0; c < m; c++) {
-        double d = chain_mean[c] - grand_mean;
-        B += d * d;
-      }
-      B *= n / (m - 1.0);
-
-      // --- Rhat with df adjustment (full coda formula) ---
-      // s2[c] = chain_var[c]
-      double var_w = 0.0;
-      for(int c = 0; c < m; c++) {
-        double d = chain_var[c] - W;
-        var_w += d * d;
-      }
-      var_w /= (m - 1.0) * m; // var(s2) / m
-
-      double var_b = (2.0 * B * B) / (m - 1.0);
+// ============================================================================
+//   Rcpp exports
+// ============================================================================
 
-      // cov(W, B) term
-      double cov_wb = 0.0;
-      for(int c = 0; c < m; c++) {
-        double s2c = chain_var[c];
-        double xbar_c = chain_mean[c];
-        double xbar2_c = xbar_c * xbar_c;
-        cov_wb += (s2c - W) * (xbar2_c - 2.0 * grand_mean * xbar_c);
-      }
-      cov_wb *= (double)n / (m - 1.0) / m;
+static Rcpp::NumericVector compute_ess(const DrawsView& draws) {
+  if(draws.niter <= 1) {
+    return Rcpp::NumericVector(draws.nparam, NA_REAL);
+  }
 
-      double V = (n - 1.0) * W / n + (1.0 + 1.0 / m) * B / n;
-      double var_V = ((double)(n - 1) * (n - 1) * var_w
-                     + (1.0 + 1.0 / m) * (1.0 + 1.0 / m) * var_b
-                     + 2.0 * (n - 1.0) * (1.0 + 1.0 / m) * cov_wb) / ((double)n * n);
+  int max_order = ess_max_order(draws.niter);
 
-      double df_V = (var_V > 0) ? (2.0 * V * V) / var_V : 1e6;
-      double df_adj = (df_V + 3.0) / (df_V + 1.0);
+  Rcpp::NumericVector ess(draws.nparam);
+  ESSWorker worker(draws, max_order, ess);
+  parallel_for_tasks(draws.nparam, worker);
+  return ess;
+}
 
-      double R2_fixed = (n - 1.0) / n;
-      double R2_random = (W > 0) ? (1.0 + 1.0 / m) * (1.0 / n) * (B / W) : 0.0;
-      double R2 = R2_fixed + R2_random;
 
-      rhat[j] = (W > 0 && R2 > 0) ? std::sqrt(df_adj * R2) : NA_REAL;
-    }
+static Rcpp::NumericVector compute_rhat(const DrawsView& draws) {
+  if(draws.nchains() < 2 || draws.niter <= 1) {
+    return Rcpp::NumericVector(draws.nparam, NA_REAL);
   }
-};
 
+  Rcpp::NumericVector rhat(draws.nparam);
+  RhatWorker worker(draws, rhat);
+  parallel_for_tasks(draws.nparam, worker);
+  return rhat;
+}
 
-// ============================================================================
-//   Rcpp exports
-// ============================================================================
 
 // Compute ESS for a 3D array [niter x nchains x nparam].
 // Multi-chain ESS = sum of per-chain ESS.
 // [[Rcpp::export(.compute_ess_cpp)]]
 Rcpp::NumericVector compute_ess_cpp(Rcpp::NumericVector array3d) {
-  Rcpp::IntegerVector dims = array3d.attr("dim");
-  int niter   = dims[0];
-  int nchains = dims[1];
-  int nparam  = dims[2];
-
-  if(niter <= 1) {
-    return Rcpp::NumericVector(nparam, NA_REAL);
-  }
-
-  int max_order = std::min(niter - 1,
-                           (int)std::floor(10.0 * std::log10((double)niter)));
-
-  Rcpp::NumericVector ess(nparam);
-  ESSWorker worker(array3d.begin(), niter, nchains, nparam, max_order, ess);
-  RcppParallel::parallelFor(0, nparam, worker);
-  return ess;
+  return compute_ess(view_array3d(array3d));
 }
 
 
@@ -275,19 +373,25 @@ Rcpp::NumericVector compute_ess_cpp(Rcpp::NumericVector array3d) {
 // Returns NA for single-chain input.
 // [[Rcpp::export(.compute_rhat_cpp)]]
 Rcpp::NumericVector compute_rhat_cpp(Rcpp::NumericVector array3d) {
-  Rcpp::IntegerVector dims = array3d.attr("dim");
-  int niter   = dims[0];
-  int nchains = dims[1];
-  int nparam  = dims[2];
+  return compute_rhat(view_array3d(array3d));
+}
 
-  if(nchains < 2 || niter <= 1) {
-    return Rcpp::NumericVector(nparam, NA_REAL);
-  }
 
-  Rcpp::NumericVector rhat(nparam);
-  RhatWorker worker(array3d.begin(), niter, nchains, nparam, rhat);
-  RcppParallel::parallelFor(0, nparam, worker);
-  return rhat;
+// Compute ESS from a list of per-chain matrices, read in place.
+// Each chain is iter x param, or param x iter when param_rows is TRUE.
+// [[Rcpp::export(.compute_ess_chains_cpp)]]
+Rcpp::NumericVector compute_ess_chains_cpp(Rcpp::List chains,
+                                           bool param_rows = false) {
+  return compute_ess(view_chains(chains, param_rows));
+}
+
+
+// Compute Rhat from a list of per-chain matrices, read in place.
+// Each chain is iter x param, or param x iter when param_rows is TRUE.
+// [[Rcpp::export(.compute_rhat_chains_cpp)]]
+Rcpp::NumericVector compute_rhat_chains_cpp(Rcpp::List chains,
+                                            bool param_rows = false) {
+  return compute_rhat(view_chains(chains, param_rows));
 }
 
 
@@ -311,6 +415,37 @@ Rcpp::NumericVector compute_rhat_cpp(Rcpp::NumericVector array3d) {
 // Origin: two-state Markov chain integrated autocorrelation time.
 // ============================================================================
 
+// Mean, sd, mcse, transition counts and n_eff_mixt of one indicator, written
+// to row j of the column-major [nparam x 8] output.
+template <typename Out>
+static void store_indicator_stats(Out& out, std::size_t j, int nparam, int n_total,
+                                  double sum_x, int c00, int c01, int c10, int c11) {
+  double p_hat = sum_x / n_total;
+  double sd = std::sqrt(p_hat * (1.0 - p_hat));
+
+  double n_eff_mixt, mcse;
+  if(c01 + c10 == 0) {
+    n_eff_mixt = NA_REAL;
+    mcse = NA_REAL;
+  } else {
+    double a = (double)c01 / (c00 + c01);
+    double b = (double)c10 / (c10 + c11);
+    double tau_int = (2.0 - a - b) / (a + b);
+    n_eff_mixt = n_total / tau_int;
+    mcse = (n_eff_mixt > 0.0) ? sd / std::sqrt(n_eff_mixt) : NA_REAL;
+  }
+
+  // Store in column-major matrix: out[j + col * nparam]
+  out[j + 0 * nparam] = p_hat;
+  out[j + 1 * nparam] = sd;
+  out[j + 2 * nparam] = mcse;
+  out[j + 3 * nparam] = (double)c00;
+  out[j + 4 * nparam] = (double)c01;
+  out[j + 5 * nparam] = (double)c10;
+  out[j + 6 * nparam] = (double)c11;
+  out[j + 7 * nparam] = n_eff_mixt;
+}
+
 struct IndicatorESSWorker : public RcppParallel::Worker {
   const double* data;
   const int niter;
@@ -378,30 +513,7 @@ struct IndicatorESSWorker : public RcppParallel::Worker {
         continue;
       }
 
-      double p_hat = sum_x / n_total;
-      double sd = std::sqrt(p_hat * (1.0 - p_hat));
-
-      double n_eff_mixt, mcse;
-      if(c01 + c10 == 0) {
-        n_eff_mixt = NA_REAL;
-        mcse = NA_REAL;
-      } else {
-        double a = (double)c01 / (c00 + c01);
-        double b = (double)c10 / (c10 + c11);
-        double tau_int = (2.0 - a - b) / (a + b);
-        n_eff_mixt = n_total / tau_int;
-        mcse = (n_eff_mixt > 0.0) ? sd / std::sqrt(n_eff_mixt) : NA_REAL;
-      }
-
-      // Store in column-major matrix: out[j + col * nparam]
-      out[j + 0 * nparam] = p_hat;
-      out[j + 1 * nparam] = sd;
-      out[j + 2 * nparam] = mcse;
-      out[j + 3 * nparam] = (double)c00;
-      out[j + 4 * nparam] = (double)c01;
-      out[j + 5 * nparam] = (double)c10;
-      out[j + 6 * nparam] = (double)c11;
-      out[j + 7 * nparam] = n_eff_mixt;
+      store_indicator_stats(out, j, nparam, n_total, sum_x, c00, c01, c10, c11);
     }
   }
 };
@@ -450,6 +562,460 @@ Rcpp::NumericMatrix compute_indicator_ess_cpp(Rcpp::NumericVector array3d) {
   }
 
   IndicatorESSWorker worker(array3d.begin(), niter, nchains, nparam, out);
-  RcppParallel::parallelFor(0, nparam, worker);
+  parallel_for_tasks(nparam, worker);
+  return out;
+}
+
+
+// ============================================================================
+//   Indicator ESS from packed traces
+// ============================================================================
+//
+// Same statistics as compute_indicator_ess_cpp, read directly from the
+// per-chain indicator traces returned by the C++ samplers (see
+// PackedIndicatorTrace in src/mcmc/execution/indicator_trace.h), without
+// expanding them to a double array first. Chains are pooled in order, so
+// the transition from the last draw of one chain to the first draw of the
+// next is counted, as in compute_indicator_ess_cpp.
+//
+// For run-length-encoded traces the counts follow from the run lengths:
+// a run of length L in state s adds L - 1 s->s transitions, and each flip
+// adds one s->(1 - s) transition.
+// ============================================================================
+
+struct IndicatorTraceView {
+  bool rle;
+  // "bits" encoding
+  const unsigned char* bits;
+  std::size_t bytes_per_draw;
+  // "rle" encoding
+  const int* initial;
+  const int* flip_start;
+  const int* flip_iter;
+
+  int first(std::size_t e) const {
+    return rle ? initial[e] : (bits[e >> 3] >> (e & 7)) & 1;
+  }
+};
+
+struct PackedIndicatorESSWorker : public RcppParallel::Worker {
+  const std::vector<IndicatorTraceView>& chains;
+  const std::vector<int>& edges;
+  const int niter;
+  const int nparam;
+
+  RcppParallel::RVector<double> out;
+
+  PackedIndicatorESSWorker(const std::vector<IndicatorTraceView>& chains,
+                           const std::vector<int>& edges, int niter,
+                           Rcpp::NumericMatrix out)
+    : chains(chains), edges(edges), niter(niter),
+      nparam(static_cast<int>(edges.size())), out(out) {}
+
+  void operator()(std::size_t begin, std::size_t end) {
+    const int n_total = niter * static_cast<int>(chains.size());
+
+    for(std::size_t j = begin; j < end; j++) {
+      const std::size_t e = edges[j];
+      double sum_x = 0.0;
+      int count[2][2] = {{0, 0}, {0, 0}};
+      int prev = -1;
+
+      for(const IndicatorTraceView& chain : chains) {
+        if(chain.rle) {
+          int state = chain.initial[e];
+          if(prev >= 0) count[prev][state]++;
+          int pos = 1;
+          for(int f = chain.flip_start[e]; f < chain.flip_start[e + 1]; f++) {
+            const int len = chain.flip_iter[f] - pos;
+            sum_x += state * len;
+            count[state][state] += len - 1;
+            count[state][1 - state]++;
+            state = 1 - state;
+            pos = chain.flip_iter[f];
+          }
+          const int len = niter - pos + 1;
+          sum_x += state * len;
+          count[state][state] += len - 1;
+          prev = state;
+        } else {
+          const unsigned char* byte = chain.bits + (e >> 3);
+          const int shift = static_cast<int>(e & 7);
+          for(int i = 0; i < niter; i++, byte += chain.bytes_per_draw) {
+            const int curr = (*byte >> shift) & 1;
+            if(prev >= 0) count[prev][curr]++;
+            sum_x += curr;
+            prev = curr;
+          }
+        }
+      }
+
+      store_indicator_stats(out, j, nparam, n_total, sum_x,
+                            count[0][0], count[0][1], count[1][0], count[1][1]);
+    }
+  }
+};
+
+
+// Compute indicator transition ESS from a list of per-chain indicator traces
+// (the `indicator_trace` elements of the raw sampler output). A trace may
+// carry `edges`, the 1-based indicators to report (default: all). Returns
+// the same [nparam x 8] matrix as compute_indicator_ess_cpp.
+// [[Rcpp::export(.compute_indicator_ess_packed_cpp)]]
+Rcpp::NumericMatrix compute_indicator_ess_packed_cpp(Rcpp::List traces) {
+  const int nchains = traces.size();
+  if(nchains == 0) {
+    Rcpp::stop("No indicator traces supplied.");
+  }
+
+  Rcpp::List first = traces[0];
+  const int niter = Rcpp::as<int>(first["n_iter"]);
+  const int n_edges = Rcpp::as<int>(first["n_edges"]);
+
+  std::vector<int> edges;
+  if(first.containsElementNamed("edges")) {
+    Rcpp::IntegerVector sel = first["edges"];
+    for(int k : sel) {
+      if(k < 1 || k > n_edges) Rcpp::stop("Indicator trace `edges` out of range.");
+      edges.push_back(k - 1);
+    }
+  } else {
+    edges.resize(n_edges);
+    std::iota(edges.begin(), edges.end(), 0);
+  }
+  const int nparam = static_cast<int>(edges.size());
+
+  // Views hold raw pointers into the R vectors; `traces` keeps them alive.
+  std::vector<IndicatorTraceView> chains(nchains);
+  for(int c = 0; c < nchains; c++) {
+    Rcpp::List trace = traces[c];
+    if(Rcpp::as<int>(trace["n_iter"]) != niter || Rcpp::as<int>(trace["n_edges"]) != n_edges) {
+      Rcpp::stop("Indicator traces differ in size across chains.");
+    }
+    IndicatorTraceView& view = chains[c];
+    view.rle = Rcpp::as<std::string>(trace["encoding"]) == "rle";
+    if(view.rle) {
+      Rcpp::IntegerVector initial = trace["initial"];
+      Rcpp::IntegerVector flip_start = trace["flip_start"];
+      Rcpp::IntegerVector flip_iter = trace["flip_iter"];
+      view.initial = initial.begin();
+      view.flip_start = flip_start.begin();
+      view.flip_iter = flip_iter.begin();
+    } else {
+      Rcpp::RawVector bits = trace["bits"];
+      view.bits = bits.begin();
+      view.bytes_per_draw = 8 * static_cast<std::size_t>((n_edges + 63) / 64);
+    }
+  }
+
+  Rcpp::NumericMatrix out(nparam, 8);
+  Rcpp::colnames(out) = Rcpp::CharacterVector::create(
+    "mean", "sd", "mcse", "n00", "n01", "n10", "n11", "n_eff_mixt"
+  );
+
+  if(niter <= 1) {
+    // Same conventions as compute_indicator_ess_cpp: no transitions, and
+    // mcse / n_eff_mixt undefined.
+    if(niter == 0) {
+      std::fill(out.begin(), out.end(), NA_REAL);
+      return out;
+    }
+    for(int j = 0; j < nparam; j++) {
+      double sum_x = 0.0;
+      for(const IndicatorTraceView& chain : chains) sum_x += chain.first(edges[j]);
+      double p_hat = sum_x / nchains;
+      out[j + 0 * nparam] = p_hat;
+      out[j + 1 * nparam] = std::sqrt(p_hat * (1.0 - p_hat));
+      out[j + 2 * nparam] = NA_REAL;
+      for(int k = 3; k < 7; k++) out[j + k * nparam] = 0.0;
+      out[j + 7 * nparam] = NA_REAL;
+    }
+    return out;
+  }
+
+  PackedIndicatorESSWorker worker(chains, edges, niter, out);
+  parallel_for_tasks(nparam, worker);
+  return out;
+}
+
+
+// ============================================================================
+//   Diagnostics of streamed sample files
+// ============================================================================
+//
+// The same statistics for the draws the chains streamed to disk with
+// bgms.sample_dir (see ChunkedFileSink), without holding the traces in
+// memory. The parameters (file rows) are split into blocks that are
+// processed in parallel, each task with its own readers; a block reads each
+// chain's trace in chunks of draws, and only the rows of the block.
+//
+// ESS and Rhat take two passes over each chain. The first sums the draws
+// for the chain mean. The second accumulates the lag products of the
+// centered draws for all lags at once, keeping the last max_order centered
+// draws of each parameter in a ring. For every lag the products are added
+// in increasing draw order, as in compute_column_ess(), so the results are
+// those of .compute_ess_cpp() and .compute_rhat_cpp() on the same draws.
+// Indicator transitions are counted in one pass, with the state carried
+// from one chain into the next as in IndicatorESSWorker.
+//
+// `memory_mb` bounds the memory of all concurrent blocks together: per
+// block, the accumulators of its parameters and one chunk of draws.
+// ============================================================================
+
+// Paths of the chains' sample files and their common dimensions.
+struct SampleFileSet {
+  std::vector<std::string> paths;
+  std::int64_t nparam = 0;
+  std::int64_t niter = 0;
+
+  int nchains() const { return static_cast<int>(paths.size()); }
+};
+
+static SampleFileSet open_sample_files(const Rcpp::CharacterVector& paths) {
+  if(paths.size() == 0) Rcpp::stop("No sample files given.");
+  SampleFileSet files;
+  for(int c = 0; c < paths.size(); c++) {
+    SampleFileReader reader(Rcpp::as<std::string>(paths[c]));
+    if(c == 0) {
+      files.nparam = reader.n_rows();
+      files.niter = reader.n_cols();
+    } else if(reader.n_rows() != files.nparam || reader.n_cols() != files.niter) {
+      Rcpp::stop("All sample files must have the same dimensions.");
+    }
+    files.paths.push_back(reader.path());
+  }
+  if(files.niter < 2) Rcpp::stop("Sample files must hold at least two draws.");
+  return files;
+}
+
+
+// Parameters per block and draws per chunk. Half of each block's share of
+// the budget goes to the accumulators (`param_bytes` per parameter), half
+// to the chunk: 16 bytes per value, for the file bytes and their widened
+// copy. Blocks are no larger than needed to give every thread one.
+struct FileBlocking {
+  std::int64_t block_params = 1;
+  std::int64_t chunk_draws = 1;
+  std::size_t nblocks = 0;
+};
+
+static FileBlocking file_blocking(const SampleFileSet& files, double memory_mb,
+                                  double param_bytes) {
+  const int tasks = std::max(1, tbb::this_task_arena::max_concurrency());
+  const double budget = memory_mb * 1024.0 * 1024.0 / tasks;
+  const std::int64_t spread = (files.nparam + tasks - 1) / tasks;
+
+  FileBlocking b;
+  b.block_params = std::max<std::int64_t>(
+    1, std::min<std::int64_t>(spread, (std::int64_t)(0.5 * budget / param_bytes)));
+  b.chunk_draws = std::max<std::int64_t>(
+    1, std::min<std::int64_t>(files.niter, (std::int64_t)(0.5 * budget / (16.0 * b.block_params))));
+  b.nblocks = (std::size_t)((files.nparam + b.block_params - 1) / b.block_params);
+  return b;
+}
+
+
+struct FileMomentsWorker : public RcppParallel::Worker {
+  const SampleFileSet& files;
+  const FileBlocking& blocking;
+  const int max_order;
+
+  // Output
+  RcppParallel::RVector<double> mean, sd, ess, rhat;
+
+  FileMomentsWorker(const SampleFileSet& files, const FileBlocking& blocking,
+                    int max_order, Rcpp::NumericVector mean, Rcpp::NumericVector sd,
+                    Rcpp::NumericVector ess, Rcpp::NumericVector rhat)
+    : files(files), blocking(blocking), max_order(max_order),
+      mean(mean), sd(sd), ess(ess), rhat(rhat) {}
+
+  void operator()(std::size_t begin, std::size_t end) {
+    for(std::size_t b = begin; b < end; b++) block(b);
+  }
+
+  void block(std::size_t b) {
+    const std::int64_t j0 = (std::int64_t)b * blocking.block_params;
+    const std::int64_t j1 = std::min(files.nparam, j0 + blocking.block_params);
+    const int nb = (int)(j1 - j0);
+    const int n = (int)files.niter;
+    const int m = files.nchains();
+    const int L = max_order;
+
+    std::vector<double> chain_mean(m * nb), chain_ss(m * nb), ess_sum(nb, 0.0);
+    std::vector<double> lags(nb * (L + 1)), ring(nb * L), acov(L + 1), chunk;
+
+    for(int c = 0; c < m; c++) {
+      SampleFileReader reader(files.paths[c]);
+      double* mu = chain_mean.data() + c * nb;
+
+      // Pass 1: chain means
+      std::fill(mu, mu + nb, 0.0);
+      for(int t0 = 0; t0 < n; t0 += blocking.chunk_draws) {
+        const int t1 = (int)std::min<std::int64_t>(n, t0 + blocking.chunk_draws);
+        reader.read(j0, j1, t0, t1, chunk);
+        for(int t = t0; t < t1; t++) {
+          const double* x = chunk.data() + (std::ptrdiff_t)(t - t0) * nb;
+          for(int p = 0; p < nb; p++) mu[p] += x[p];
+        }
+      }
+      for(int p = 0; p < nb; p++) mu[p] /= n;
+
+      // Pass 2: lag products of the centered draws; ring[p * L + i % L]
+      // holds the centered draw i of parameter p
+      std::fill(lags.begin(), lags.end(), 0.0);
+      for(int t0 = 0; t0 < n; t0 += blocking.chunk_draws) {
+        const int t1 = (int)std::min<std::int64_t>(n, t0 + blocking.chunk_draws);
+        reader.read(j0, j1, t0, t1, chunk);
+        for(int t = t0; t < t1; t++) {
+          const double* x = chunk.data() + (std::ptrdiff_t)(t - t0) * nb;
+          const int back = std::min(L, t);
+          for(int p = 0; p < nb; p++) {
+            const double d = x[p] - mu[p];
+            double* s = lags.data() + p * (L + 1);
+            double* r = ring.data() + p * L;
+            s[0] += d * d;
+            for(int lag = 1; lag <= back; lag++) s[lag] += r[(t - lag) % L] * d;
+            if(L > 0) r[t % L] = d;
+          }
+        }
+      }
+
+      for(int p = 0; p < nb; p++) {
+        const double* s = lags.data() + p * (L + 1);
+        chain_ss[c * nb + p] = s[0];
+        if(!std::isfinite(mu[p])) {
+          ess_sum[p] += NA_REAL;
+          continue;
+        }
+        for(int lag = 0; lag <= L; lag++) acov[lag] = s[lag] / n;
+        ess_sum[p] += ess_from_autocovariance(acov, n, L);
+      }
+    }
+
+    std::vector<double> means(m), vars(m);
+    for(int p = 0; p < nb; p++) {
+      const std::size_t j = (std::size_t)(j0 + p);
+      double grand_mean = 0.0, ss = 0.0;
+      for(int c = 0; c < m; c++) {
+        means[c] = chain_mean[c * nb + p];
+        vars[c] = chain_ss[c * nb + p] / (n - 1.0);
+        grand_mean += means[c];
+      }
+      grand_mean /= m;
+      for(int c = 0; c < m; c++) {
+        const double d = means[c] - grand_mean;
+        ss += chain_ss[c * nb + p] + n * d * d;
+      }
+      mean[j] = grand_mean;
+      sd[j] = std::sqrt(ss / ((double)n * m - 1.0));
+      ess[j] = ess_sum[p];
+      rhat[j] = (m > 1) ? rhat_from_moments(means, vars, n) : NA_REAL;
+    }
+  }
+};
+
+
+struct FileIndicatorWorker : public RcppParallel::Worker {
+  const SampleFileSet& files;
+  const FileBlocking& blocking;
+
+  // Output: nparam x 8 matrix in column-major order
+  RcppParallel::RVector<double> out;
+
+  FileIndicatorWorker(const SampleFileSet& files, const FileBlocking& blocking,
+                      Rcpp::NumericMatrix out)
+    : files(files), blocking(blocking), out(out) {}
+
+  void operator()(std::size_t begin, std::size_t end) {
+    for(std::size_t b = begin; b < end; b++) block(b);
+  }
+
+  void block(std::size_t b) {
+    const std::int64_t j0 = (std::int64_t)b * blocking.block_params;
+    const std::int64_t j1 = std::min(files.nparam, j0 + blocking.block_params);
+    const int nb = (int)(j1 - j0);
+    const int n = (int)files.niter;
+    const int m = files.nchains();
+    const int nparam = (int)files.nparam;
+
+    std::vector<double> sum_x(nb, 0.0), chunk;
+    std::vector<int> prev(nb, 0), counts(4 * nb, 0);
+    std::vector<char> nonfinite(nb, 0);
+
+    for(int c = 0; c < m; c++) {
+      SampleFileReader reader(files.paths[c]);
+      for(int t0 = 0; t0 < n; t0 += blocking.chunk_draws) {
+        const int t1 = (int)std::min<std::int64_t>(n, t0 + blocking.chunk_draws);
+        reader.read(j0, j1, t0, t1, chunk);
+        for(int t = t0; t < t1; t++) {
+          const double* x = chunk.data() + (std::ptrdiff_t)(t - t0) * nb;
+          const bool first = (c == 0 && t == 0);
+          for(int p = 0; p < nb; p++) {
+            if(nonfinite[p]) continue;
+            if(!std::isfinite(x[p])) {
+              nonfinite[p] = 1;
+              continue;
+            }
+            const int curr = (int)x[p];
+            sum_x[p] += curr;
+            // Transition from prev to curr: n00, n01, n10, n11
+            if(!first) counts[4 * p + 2 * (prev[p] != 0) + (curr != 0)]++;
+            prev[p] = curr;
+          }
+        }
+      }
+    }
+
+    for(int p = 0; p < nb; p++) {
+      const std::size_t j = (std::size_t)(j0 + p);
+      if(nonfinite[p]) {
+        for(int k = 0; k < 8; k++) out[j + k * nparam] = NA_REAL;
+        continue;
+      }
+      const int* k = counts.data() + 4 * p;
+      store_indicator_stats(out, j, nparam, n * m, sum_x[p], k[0], k[1], k[2], k[3]);
+    }
+  }
+};
+
+
+// Mean, sd, ESS and Rhat of each row of the chains' streamed sample files
+// (one file per chain), read in blocks within about `memory_mb` MB.
+// [[Rcpp::export(.compute_file_diagnostics_cpp)]]
+Rcpp::List compute_file_diagnostics_cpp(Rcpp::CharacterVector paths,
+                                        double memory_mb = 64.0) {
+  const SampleFileSet files = open_sample_files(paths);
+  const int max_order = ess_max_order((int)files.niter);
+  // Per parameter: 2 * max_order + 1 lag sums and ring values, the ESS sum,
+  // and the chain means and sums of squares
+  const double param_bytes = sizeof(double) * (2.0 * max_order + 2.0 + 2.0 * files.nchains());
+  const FileBlocking blocking = file_blocking(files, memory_mb, param_bytes);
+
+  Rcpp::NumericVector mean(files.nparam), sd(files.nparam), ess(files.nparam), rhat(files.nparam);
+  FileMomentsWorker worker(files, blocking, max_order, mean, sd, ess, rhat);
+  parallel_for_tasks(blocking.nblocks, worker);
+  return Rcpp::List::create(
+    Rcpp::Named("mean") = mean,
+    Rcpp::Named("sd") = sd,
+    Rcpp::Named("n_eff") = ess,
+    Rcpp::Named("Rhat") = rhat
+  );
+}
+
+
+// Indicator transition ESS of each row of the chains' streamed indicator
+// files, pooled over the chains in order, as .compute_indicator_ess_cpp().
+// [[Rcpp::export(.compute_indicator_ess_files_cpp)]]
+Rcpp::NumericMatrix compute_indicator_ess_files_cpp(Rcpp::CharacterVector paths,
+                                                    double memory_mb = 64.0) {
+  const SampleFileSet files = open_sample_files(paths);
+  const FileBlocking blocking = file_blocking(files, memory_mb, 4.0 * sizeof(double));
+
+  Rcpp::NumericMatrix out(files.nparam, 8);
+  Rcpp::colnames(out) = Rcpp::CharacterVector::create(
+    "mean", "sd", "mcse", "n00", "n01", "n10", "n11", "n_eff_mixt"
+  );
+  FileIndicatorWorker worker(files, blocking, out);
+  parallel_for_tasks(blocking.nblocks, worker);
   return out;
 }
@@ -1,7 +1,8 @@
 // Test interface for the mixed MRF gradient engine.
 //
 // Exposes logp_and_gradient, project_position, project_momentum,
-// and constrained leapfrog to R for validation.
+// constrained leapfrog and the precision-proposal likelihood ratio to R for
+// validation.
 
 #include <RcppArmadillo.h>
 #include "models/mixed/mixed_mrf_model.h"
@@ -241,11 +242,10 @@ Rcpp::List mixed_test_leapfrog_constrained(
         42
     );
 
-    Memoizer::JointFn joint = [&model](const arma::vec& x)
+    JointFn joint = [&model](const arma::vec& x)
         -> std::pair<double, arma::vec> {
         return model.logp_and_gradient_full(x);
     };
-    Memoizer memo(joint);
 
     arma::vec inv_mass;
     if(inv_mass_in.isNotNull()) {
@@ -261,17 +261,22 @@ Rcpp::List mixed_test_leapfrog_constrained(
         model.project_momentum(r, x, inv_mass);
     };
 
-    arma::vec x = x0;
-    arma::vec r = r0;
-    double logp0 = memo.cached_log_post(x);
+    LeapfrogState z, z_next;
+    z.theta = x0;
+    z.r = r0;
+    evaluate_state(z, joint);
+    double logp0 = z.logp;
 
     for(int s = 0; s < n_steps; ++s) {
-        std::tie(x, r) = leapfrog_constrained(
-            x, r, step_size, memo, inv_mass, proj_pos, proj_mom
+        leapfrog_constrained(
+            z, step_size, joint, inv_mass, proj_pos, proj_mom, z_next
         );
+        std::swap(z, z_next);
     }
 
-    double logp_final = memo.cached_log_post(x);
+    const arma::vec& x = z.theta;
+    const arma::vec& r = z.r;
+    double logp_final = z.logp;
     double kin0 = 0.5 * arma::dot(r0, inv_mass % r0);
     double kin_final = 0.5 * arma::dot(r, inv_mass % r);
     double H0 = -logp0 + kin0;
@@ -286,4 +291,78 @@ Rcpp::List mixed_test_leapfrog_constrained(
         Rcpp::Named("H_final") = H_final,
         Rcpp::Named("dH") = H_final - H0
     );
-}
\ No newline at end of file
+}
+
+
+// Build a mixed MRF with all edges included, run `iterations` Metropolis
+// sweeps from `seed`, then price a random move of every precision entry
+// (i <= j) with log_ggm_ratio(). Returns the proposals (0-based i, j,
+// precision_ij, precision_jj), their log ratios and the storage parameters
+// of the state they were priced at.
+// [[Rcpp::export]]
+Rcpp::List mixed_test_ggm_ratio(
+    const arma::imat& discrete_observations,
+    const arma::mat& continuous_observations,
+    const arma::ivec& num_categories,
+    const arma::uvec& is_ordinal_variable,
+    const arma::ivec& baseline_category,
+    int iterations,
+    int seed)
+{
+    size_t p = discrete_observations.n_cols;
+    size_t q = continuous_observations.n_cols;
+    size_t total = p + q;
+
+    arma::mat inc_prob(total, total, arma::fill::value(0.5));
+    arma::imat edge_indicators(total, total, arma::fill::ones);
+    edge_indicators.diag().zeros();
+
+    MixedMRFModel model(
+        discrete_observations, continuous_observations,
+        num_categories, is_ordinal_variable, baseline_category,
+        inc_prob, edge_indicators, false,
+        create_parameter_prior("cauchy", 2.5),
+        create_parameter_prior("beta-prime", 1.0, 0.5, 0.5),
+        create_parameter_prior("normal", 1.0),
+        create_scale_prior("gamma", 1.0, 1.0),
+        seed
+    );
+    for(int iter = 0; iter < iterations; ++iter) {
+        model.do_one_metropolis_step(iter);
+    }
+
+    // Current precision from the trailing A_yy block of the storage vector
+    const arma::vec parameters = model.get_storage_vectorized_parameters();
+    arma::mat precision(q, q);
+    size_t idx = parameters.n_elem - q * (q + 1) / 2;
+    for(size_t i = 0; i < q; ++i) {
+        for(size_t j = i; j < q; ++j) {
+            precision(i, j) = precision(j, i) = -2.0 * parameters(idx++);
+        }
+    }
+
+    SafeRNG rng(seed + 1);
+    const size_t num_proposals = q * (q + 1) / 2;
+    arma::mat proposals(num_proposals, 4);
+    arma::vec ratio(num_proposals);
+    size_t k = 0;
+    for(size_t j = 0; j < q; ++j) {
+        for(size_t i = 0; i <= j; ++i, ++k) {
+            const double precision_ij = i == j ? precision(i, j)
+                                               : precision(i, j) + rnorm(rng, 0.0, 0.1);
+            const double precision_jj = precision(j, j) * std::exp(rnorm(rng, 0.0, 0.2));
+            proposals(k, 0) = static_cast<double>(i);
+            proposals(k, 1) = static_cast<double>(j);
+            proposals(k, 2) = precision_ij;
+            proposals(k, 3) = precision_jj;
+            ratio(k) = model.log_ggm_ratio(static_cast<int>(i), static_cast<int>(j),
+                                           precision_ij, precision_jj);
+        }
+    }
+
+    return Rcpp::List::create(
+        Rcpp::Named("proposals") = proposals,
+        Rcpp::Named("ratio") = Rcpp::wrap(ratio),
+        Rcpp::Named("parameters") = Rcpp::wrap(parameters)
+    );
+}
@@ -4,10 +4,16 @@
 #include <stdexcept>
 #include <memory>
 #include <limits>
+#include <utility>
+#include <vector>
+#include "mcmc/execution/indicator_trace.h"
+#include "priors/edge_change_listener.h"
+#include "utils/scratch_arena.h"
 
 // Forward declarations
 struct StepResult;
 struct SafeRNG;
+struct SamplerState;
 struct WarmupSchedule;
 
 /**
@@ -24,6 +30,7 @@ struct WarmupSchedule;
  *   - GGMModel      — Gaussian Graphical Model (precision matrix, Metropolis + NUTS)
  *   - OMRFModel     — Ordinal Markov Random Field (Metropolis + NUTS)
  *   - MixedMRFModel — Mixed discrete + continuous MRF (Metropolis + NUTS)
+ *   - BGMCompareModel — Multi-group ordinal MRF with group differences (Metropolis + NUTS)
  *
  * Methods fall into several groups:
  *   - **Capability queries** (has_edge_selection, has_constraints, has_missing_data)
@@ -39,6 +46,8 @@ struct WarmupSchedule;
  *     — tuned during warmup.
  *   - **Missing data** (has_missing_data, impute_missing)
  *     — full-conditional imputation between iterations.
+ *   - **Warm start** (save_state, restore_state)
+ *     — carry a chain's state over to a later run.
  */
 class BaseModel {
 public:
@@ -69,6 +78,34 @@ public:
         throw std::runtime_error("logp_and_gradient not implemented for this model");
     }
 
+    /**
+     * logp_and_gradient() of several chains' models, each at its own
+     * parameters, for chains that the runner advances in lockstep (see
+     * hmc_step_batch()). Called on one model of the batch, by the thread
+     * that drives all of them. Models whose chains share their data may
+     * evaluate all of them in one pass over it (see
+     * supports_batched_gradient()); the default evaluates them one by one.
+     *
+     * @param models      Models to evaluate, of the same type as this one
+     * @param parameters  Vectorized parameters of each model
+     * @param results     Receives (log-posterior, gradient) of each model
+     */
+    virtual void logp_and_gradient_batch(
+        const std::vector<BaseModel*>& models,
+        const std::vector<arma::vec>& parameters,
+        std::vector<std::pair<double, arma::vec>>& results) {
+        results.resize(models.size());
+        for (std::size_t k = 0; k < models.size(); ++k) {
+            results[k] = models[k]->logp_and_gradient(parameters[k]);
+        }
+    }
+
+    /**
+     * @return Whether logp_and_gradient_batch() shares work between the
+     *         models instead of evaluating them one by one.
+     */
+    virtual bool supports_batched_gradient() const { return false; }
+
     /**
      * Perform one full Metropolis sweep over all parameters.
      *
@@ -105,6 +142,76 @@ public:
      */
     virtual void set_metropolis_target_accept(double /*target*/) {}
 
+    /**
+     * Set the number of threads a single logp_and_gradient() evaluation may
+     * use. Called by the chain runner before the MCMC loop, with the
+     * per-chain thread budget from SamplerConfig::threads_per_chain.
+     *
+     * Implementations must return results that do not depend on the
+     * thread count, so chains stay reproducible for a fixed seed.
+     *
+     * Default: no-op for models without a parallel gradient.
+     *
+     * @param num_threads  Threads available to one chain (>= 1)
+     */
+    virtual void set_gradient_threads(int /*num_threads*/) {}
+
+    /**
+     * Give this model its own copy of the data it shares with the other
+     * chain clones (see SharedData). Called by the chain runner on the
+     * chain's worker thread with SamplerConfig::chain_placement
+     * "replicate", so the copy is first touched on that thread's memory
+     * node.
+     *
+     * Default: no-op for models without shared data.
+     */
+    virtual void replicate_shared_data() {}
+
+    /**
+     * Add observation rows to the data, updating the sufficient statistics
+     * and residuals from the new rows only. The parameters are kept, so
+     * sampling continues from the current state on the updated data.
+     *
+     * @param rows  New observations (k x p), coded as the model's data
+     */
+    virtual void append_observations(const arma::imat& /*rows*/) {
+        throw std::runtime_error("append_observations not implemented for this model");
+    }
+
+    /**
+     * Drop observation rows from the data, subtracting their contribution
+     * from the sufficient statistics.
+     *
+     * @param rows  0-based indices of the rows to drop (distinct, < n)
+     */
+    virtual void remove_observations(const arma::uvec& /*rows*/) {
+        throw std::runtime_error("remove_observations not implemented for this model");
+    }
+
+    /**
+     * Apply the same update as append_observations(rows) to this model's
+     * own state (sufficient statistics, residuals), but take the updated
+     * data from `updated`, a clone that has already appended `rows`.
+     * The chain clones thus keep sharing one data block (see SharedData)
+     * instead of each copying it.
+     *
+     * @param rows     The rows `updated` appended
+     * @param updated  Clone of this model after append_observations(rows)
+     */
+    virtual void append_observations(const arma::imat& /*rows*/, const BaseModel& /*updated*/) {
+        throw std::runtime_error("append_observations not implemented for this model");
+    }
+
+    /**
+     * As append_observations(rows, updated), for remove_observations().
+     *
+     * @param rows     The rows (0-based) `updated` dropped
+     * @param updated  Clone of this model after remove_observations(rows)
+     */
+    virtual void remove_observations(const arma::uvec& /*rows*/, const BaseModel& /*updated*/) {
+        throw std::runtime_error("remove_observations not implemented for this model");
+    }
+
     /**
      * Initialize Metropolis adaptation controllers.
      *
@@ -164,6 +271,19 @@ public:
     /** @return Edge indicators as a flat integer vector. */
     virtual arma::ivec get_vectorized_indicator_parameters() = 0;
 
+    /**
+     * Write the edge indicators, in get_vectorized_indicator_parameters()
+     * order, into a bit-packed draw. Overrides read the indicator matrix
+     * directly; the default goes through the vector.
+     * @param out  Writer positioned at the start of a zeroed draw
+     */
+    virtual void pack_indicator_parameters(IndicatorBitWriter& out) {
+        const arma::ivec indicators = get_vectorized_indicator_parameters();
+        for (arma::uword k = 0; k < indicators.n_elem; ++k) {
+            out.push(indicators(k) != 0);
+        }
+    }
+
     /**
      * @return Full parameter dimension (fixed size, includes inactive parameters).
      *
@@ -215,10 +335,12 @@ public:
     // =========================================================================
 
     /**
-     * Set the random seed for reproducibility.
-     * @param seed  Integer seed value
+     * Replace the model's random number generator.
+     *
+     * The chain runner hands each chain its own engine from rng_streams().
+     * @param rng  Engine to copy into the model
      */
-    virtual void set_seed(int seed) = 0;
+    virtual void set_rng(const SafeRNG& rng) = 0;
 
     /** @return Deep copy of this model (for parallel chains). */
     virtual std::unique_ptr<BaseModel> clone() const = 0;
@@ -246,6 +368,28 @@ public:
      */
     virtual arma::vec get_active_inv_mass() const { return inv_mass_; }
 
+    /**
+     * @return Inverse mass diagonal (full dimension) for the gradient
+     *         samplers to start warmup from, or an empty vector for the
+     *         identity. Set by models that locate the mode of their
+     *         pseudoposterior before sampling.
+     */
+    virtual arma::vec initial_inv_mass() const { return arma::vec(); }
+
+    /**
+     * @return Position of each active parameter in the full vector.
+     *
+     * Entry k is the index into get_full_vectorized_parameters() of
+     * element k of get_vectorized_parameters(). NUTSSampler uses it to
+     * restrict a dense or low-rank metric to the active parameters, the
+     * way get_active_inv_mass() restricts the diagonal. Default: identity.
+     */
+    virtual arma::uvec get_active_parameter_indices() const {
+        const size_t dim = parameter_dimension();
+        if (dim == 0) return arma::uvec();
+        return arma::regspace<arma::uvec>(0, dim - 1);
+    }
+
     // =========================================================================
     // RATTLE constrained integration
     // =========================================================================
@@ -372,6 +516,114 @@ public:
     /** Impute missing entries from full-conditional distributions. */
     virtual void impute_missing() {}
 
+    // =========================================================================
+    // Parallel tempering
+    // =========================================================================
+
+    /** @return true when the model implements set_temperature(). */
+    virtual bool supports_tempering() const { return false; }
+
+    /**
+     * Raise the (pseudo)likelihood to the power `beta` in (0, 1] in every
+     * update, for a hot replica of a tempered chain. The priors are not
+     * tempered. Default no-op.
+     */
+    virtual void set_temperature(double beta) { (void)beta; }
+
+    /**
+     * @return Untempered log-(pseudo)likelihood of the current state, which
+     *         the replica swaps compare. Default 0.
+     */
+    virtual double log_pseudolikelihood() const { return 0.0; }
+
+    // =========================================================================
+    // Posterior-predictive checks
+    // =========================================================================
+
+    /**
+     * Simulate a replicate of the data from the current parameters, for the
+     * posterior-predictive checks run inside the chain (see
+     * PredictiveChecks). Draws from `rng`, not the model's own stream, so
+     * the parameter draws do not depend on whether the checks run.
+     *
+     * @param num_states  Observations to simulate
+     * @param gibbs_iter  Gibbs sweeps for the discrete variables
+     * @param rng         Stream of the replicates
+     * @param out         Replicate (num_states x variables), discrete
+     *                    variables first, coded as the model's data
+     */
+    virtual void simulate_replicate(int /*num_states*/, int /*gibbs_iter*/, SafeRNG& /*rng*/,
+                                    arma::mat& /*out*/) {
+        throw std::runtime_error("simulate_replicate not implemented for this model");
+    }
+
+    // =========================================================================
+    // Subsampled likelihood
+    // =========================================================================
+
+    /** @return true when the likelihood is estimated from a row batch. */
+    virtual bool uses_subsampling() const { return false; }
+
+    /**
+     * @return Variance of the subsampled log-(pseudo)likelihood estimate at
+     *         the current state. Default NaN.
+     */
+    virtual double subsample_variance() const {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+
+    // =========================================================================
+    // Polya-Gamma Gibbs sampler
+    // =========================================================================
+
+    /**
+     * @return true when do_one_polya_gamma_step() can update this model's
+     *         parameters from Gaussian full conditionals.
+     */
+    virtual bool supports_polya_gamma() const { return false; }
+
+    /**
+     * One Polya-Gamma augmented Gibbs sweep over the parameters. Needs no
+     * step size, so it is not tuned during warmup.
+     */
+    virtual void do_one_polya_gamma_step() {
+        throw std::runtime_error("do_one_polya_gamma_step not implemented for this model");
+    }
+
+    // =========================================================================
+    // Warm start
+    // =========================================================================
+
+    /**
+     * Save the parameters, edge indicators, inclusion probabilities,
+     * Metropolis proposal SDs and edge-selection phase into `state`.
+     * Default no-op.
+     */
+    virtual void save_state(SamplerState& state) const { (void)state; }
+
+    /**
+     * Continue from a state written by save_state(). Derived caches are
+     * rebuilt from the restored blocks.
+     *
+     * @throws std::invalid_argument if a block is missing or does not
+     *         match this model's dimensions
+     */
+    virtual void restore_state(const SamplerState& state) { (void)state; }
+
+    /**
+     * Save only where the chain is: the parameters, edge indicators and
+     * inclusion probabilities, without the sampler tuning. Used to swap
+     * states between tempered replicas, which keep their own tuning.
+     * Default: the full save_state().
+     */
+    virtual void save_position(SamplerState& state) const { save_state(state); }
+
+    /**
+     * Continue from a position written by save_position(), keeping this
+     * model's tuning. Default: the full restore_state().
+     */
+    virtual void restore_position(const SamplerState& state) { restore_state(state); }
+
     // =========================================================================
     // Edge prior support
     // =========================================================================
@@ -388,8 +640,32 @@ public:
     /** @return Number of unique off-diagonal pairs p(p-1)/2. */
     virtual int get_num_pairwise() const = 0;
 
+    /**
+     * @return true if the model reports its edge toggles and other
+     *         indicator changes to an attached listener.
+     */
+    virtual bool reports_edge_changes() const { return false; }
+
+    /**
+     * Report edge changes to `listener` (the chain's edge prior), or stop
+     * with nullptr. Ignored by models that do not report them.
+     */
+    void set_edge_listener(EdgeChangeListener* listener) {
+        if (reports_edge_changes() || listener == nullptr) edge_changes_.attach(listener);
+    }
+
+    /**
+     * Per-chain scratch memory for the temporaries of the model's hot
+     * paths. The chain runner resets it before every iteration.
+     */
+    ScratchArena& scratch_arena() const { return scratch_; }
+
 protected:
     BaseModel() = default;
     /// Inverse mass matrix diagonal for NUTS.
     arma::vec inv_mass_;
+    /// See scratch_arena().
+    mutable ScratchArena scratch_;
+    /// Edge-prior notifications; see set_edge_listener().
+    EdgeChangeLink edge_changes_;
 };
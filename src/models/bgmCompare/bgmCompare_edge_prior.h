@@ -0,0 +1,135 @@
+#pragma once
+
+/**
+ * @file bgmCompare_edge_prior.h
+ * @brief Prior on the difference indicators of the bgmCompare model.
+ */
+
+#include <memory>
+#include <RcppArmadillo.h>
+#include "priors/edge_prior.h"
+#include "rng/rng_utils.h"
+#include "utils/common_helpers.h"
+
+
+/**
+ * DifferenceEdgePrior - Inclusion prior for group-difference indicators
+ *
+ * The bgmCompare indicator matrix has pairwise differences off the diagonal
+ * and, with main-difference selection, main-effect differences on it. The
+ * update mirrors the sampler's original semantics:
+ *   - Beta-Bernoulli: one inclusion probability, drawn from the pooled
+ *     pairwise and selectable main-effect indicators, shared by all entries.
+ *   - Stochastic-Block: the off-diagonal goes through an MFM-SBM
+ *     (StochasticBlockEdgePrior); the diagonal gets its own Beta-Bernoulli
+ *     draw with the within-cluster (alpha, beta).
+ *   - Bernoulli: fixed inclusion probabilities.
+ */
+class DifferenceEdgePrior : public BaseEdgePrior {
+public:
+    DifferenceEdgePrior(
+        EdgePrior type,
+        double alpha,
+        double beta,
+        double alpha_between,
+        double beta_between,
+        double dirichlet_alpha,
+        double lambda,
+        bool main_difference_selection
+    ) : type_(type),
+        alpha_(alpha),
+        beta_(beta),
+        main_difference_selection_(main_difference_selection)
+    {
+        if (type_ == Stochastic_Block) {
+            block_prior_ = std::make_unique<StochasticBlockEdgePrior>(
+                alpha, beta, alpha_between, beta_between, dirichlet_alpha, lambda);
+        }
+    }
+
+    DifferenceEdgePrior(const DifferenceEdgePrior& other)
+        : BaseEdgePrior(other),
+          type_(other.type_),
+          alpha_(other.alpha_),
+          beta_(other.beta_),
+          main_difference_selection_(other.main_difference_selection_)
+    {
+        if (other.block_prior_) {
+            block_prior_ = std::make_unique<StochasticBlockEdgePrior>(*other.block_prior_);
+        }
+    }
+
+    void update(
+        const arma::imat& edge_indicators,
+        arma::mat& inclusion_probability,
+        int num_variables,
+        int num_pairwise,
+        SafeRNG& rng
+    ) override {
+        if (type_ == Beta_Bernoulli) {
+            int num_included = 0;
+            for (int i = 0; i < num_variables - 1; ++i) {
+                for (int j = i + 1; j < num_variables; ++j) {
+                    num_included += edge_indicators(i, j);
+                }
+            }
+            int num_main_selectable = 0;
+            if (main_difference_selection_) {
+                for (int i = 0; i < num_variables; ++i) {
+                    num_included += edge_indicators(i, i);
+                }
+                num_main_selectable = num_variables;
+            }
+            const double prob = rbeta(rng,
+                alpha_ + num_included,
+                beta_ + num_pairwise + num_main_selectable - num_included
+            );
+            inclusion_probability.fill(prob);
+        } else if (block_prior_) {
+            block_prior_->update(
+                edge_indicators, inclusion_probability,
+                num_variables, num_pairwise, rng
+            );
+            if (main_difference_selection_) {
+                int num_included = 0;
+                for (int i = 0; i < num_variables; ++i) {
+                    num_included += edge_indicators(i, i);
+                }
+                const double prob_main = rbeta(rng,
+                    alpha_ + num_included,
+                    beta_ + num_variables - num_included
+                );
+                inclusion_probability.diag().fill(prob_main);
+            }
+        }
+    }
+
+    std::unique_ptr<BaseEdgePrior> clone() const override {
+        return std::make_unique<DifferenceEdgePrior>(*this);
+    }
+
+    bool tracks_allocations() const override { return block_prior_ != nullptr; }
+
+    bool has_allocations() const override {
+        return block_prior_ && block_prior_->has_allocations();
+    }
+
+    arma::ivec get_allocations() const override {
+        return block_prior_ ? block_prior_->get_allocations() : arma::ivec();
+    }
+
+    void save_state(SamplerState& state) const override {
+        if (block_prior_) block_prior_->save_state(state);
+    }
+
+    void restore_state(const SamplerState& state) override {
+        if (block_prior_) block_prior_->restore_state(state);
+    }
+
+private:
+    EdgePrior type_;
+    double alpha_;
+    double beta_;
+    bool main_difference_selection_;
+    std::unique_ptr<StochasticBlockEdgePrior> block_prior_;
+};
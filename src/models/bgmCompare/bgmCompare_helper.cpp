@@ -398,114 +398,3 @@ std::pair<arma::imat, arma::imat> build_index_maps(
 
   return {main_index, pair_index};
 }
-
-
-
-// Extracts entries of the inverse mass matrix corresponding to active parameters (bgmCompare model).
-//
-// If `selection` is false, the full diagonal vector is returned unchanged.
-// If `selection` is true, the output is restricted to:
-//  1. Main-effect overall parameters (column 0).
-//  2. Pairwise-effect overall parameters (column 0).
-//  3. Main-effect group differences (columns 1..G-1) for variables with
-//     inclusion_indicator(v,v) == 1.
-//  4. Pairwise-effect group differences (columns 1..G-1) for pairs with
-//     inclusion_indicator(v1,v2) == 1.
-//
-// Inputs:
-//  - inv_diag: Full inverse mass diagonal (length = all parameters).
-//  - inclusion_indicator: Symmetric binary matrix of active variables (diag) and pairs (off-diag).
-//  - num_groups: Number of groups.
-//  - num_categories: Number of categories per variable.
-//  - is_ordinal_variable: Indicator (1 = ordinal, 0 = Blume–Capel).
-//  - main_index: Index map for main effects (from build_index_maps()).
-//  - pair_index: Index map for pairwise effects (from build_index_maps()).
-//  - main_effect_indices: Index ranges [row_start, row_end] for each variable in main_effects.
-//  - pairwise_effect_indices: Lookup table mapping (var1,var2) → row in pairwise_effects.
-//  - selection: If true, restrict to active parameters; if false, return full inv_diag.
-//
-// Returns:
-//  - A vector containing inverse mass entries for active parameters only.
-//
-// Notes:
-//  - Must be consistent with the layout in `vectorize_model_parameters_bgmcompare()`.
-//  - Index maps (`main_index`, `pair_index`) are required to locate group-difference entries.
-arma::vec inv_mass_active(
-    const arma::vec& inv_diag,
-    const arma::imat& inclusion_indicator,
-    const int num_groups,
-    const arma::ivec& num_categories,
-    const arma::uvec& is_ordinal_variable,
-    const arma::imat& main_index,
-    const arma::imat& pair_index,
-    const arma::imat& main_effect_indices,
-    const arma::imat& pairwise_effect_indices,
-    const bool& selection
-) {
-  if(selection == false)
-    return inv_diag;
-
-  const int num_variables = inclusion_indicator.n_rows;
-  const int num_main = count_num_main_effects(num_categories, is_ordinal_variable);
-  const int num_pair = num_variables * (num_variables - 1) / 2;
-
-  // total length
-  int total_len = 0;
-  total_len += num_main;      // MAIN overall (col 0)
-  total_len += num_pair;      // PAIR overall (col 0)
-
-  // MAIN differences
-  for (int v = 0; v < num_variables; ++v) {
-    if (inclusion_indicator(v, v) == 0) continue;
-    const int r0 = main_effect_indices(v, 0);
-    const int r1 = main_effect_indices(v, 1);
-    total_len += static_cast<int>(r1 - r0 + 1) * (num_groups - 1);
-  }
-
-  // PAIRWISE differences
-  for (int v1 = 0; v1 < num_variables - 1; ++v1) {
-    for (int v2 = v1 + 1; v2 < num_variables; ++v2) {
-      if (inclusion_indicator(v1, v2) == 1) total_len += (num_groups - 1);
-    }
-  }
-
-  arma::vec active_inv_diag(total_len, arma::fill::zeros);
-
-  int off = 0;
-
-  // 1) MAIN overall (col 0) — vectorized
-  active_inv_diag.subvec(off, off + num_main - 1) = inv_diag.subvec(off, off + num_main - 1);
-  off += num_main;
-
-  // 2) PAIRWISE overall (col 0) — vectorized
-  // (Relies on rows being in the same upper-triangle order as constructed in R.)
-  active_inv_diag.subvec(off, off + num_pair - 1) = inv_diag.subvec(off, off + num_pair - 1);
-  off += num_pair;
-
-  // 3) MAIN differences (cols 1..G-1) for selected variables
-  for (int v = 0; v < num_variables; ++v) {
-    if (inclusion_indicator(v, v) == 0) continue;
-    const int r0 = main_effect_indices(v, 0);
-    const int r1 = main_effect_indices(v, 1);
-    for (int r = r0; r <= r1; ++r) {
-      for (int g = 1; g < num_groups; ++g) {
-        int idx = main_index(r, g);
-        active_inv_diag(off++) = inv_diag(idx);
-      }
-    }
-  }
-
-  // 4) PAIRWISE differences (cols 1..G-1) for selected pairs
-  for (int v1 = 0; v1 < num_variables - 1; ++v1) {
-    for (int v2 = v1 + 1; v2 < num_variables; ++v2) {
-      if (inclusion_indicator(v1, v2) != 1) continue;
-      const int row = pairwise_effect_indices(v1, v2);
-      for (int g = 1; g < num_groups; ++g) {
-        int idx = pair_index(row, g);
-        active_inv_diag(off++) = inv_diag(idx);
-      }
-    }
-  }
-
-  return active_inv_diag;
-}
\ No newline at end of file
@@ -139,37 +139,6 @@ std::pair<arma::imat, arma::imat> build_index_maps(
     const arma::uvec& is_ordinal_variable
 );
 
-/**
- * Extract inverse-mass diagonal entries for active parameters only.
- *
- * When selection is enabled, restricts to entries whose inclusion indicator
- * is 1. When selection is disabled, returns the full diagonal.
- *
- * @param inv_diag                 Full inverse-mass diagonal
- * @param inclusion_indicator      Edge inclusion indicators (V x V)
- * @param num_groups               Number of groups (G)
- * @param num_categories           Number of categories per variable
- * @param is_ordinal_variable      1 = ordinal, 0 = Blume-Capel
- * @param main_index               Main-effect index map from build_index_maps()
- * @param pair_index               Pairwise index map from build_index_maps()
- * @param main_effect_indices      Start/end row indices per variable (V x 2)
- * @param pairwise_effect_indices  Row index per variable pair (V x V)
- * @param selection                true restricts to active entries
- * @return Inverse-mass vector for active parameters
- */
-arma::vec inv_mass_active(
-    const arma::vec& inv_diag,
-    const arma::imat& inclusion_indicator,
-    const int num_groups,
-    const arma::ivec& num_categories,
-    const arma::uvec& is_ordinal_variable,
-    const arma::imat& main_index,
-    const arma::imat& pair_index,
-    const arma::imat& main_effect_indices,
-    const arma::imat& pairwise_effect_indices,
-    const bool& selection
-);
-
 /**
  * Initialize the graph structure for a bgmCompare model.
  *
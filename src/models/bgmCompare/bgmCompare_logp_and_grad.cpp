@@ -1,9 +1,11 @@
 #include <RcppArmadillo.h>
 #include "models/bgmCompare/bgmCompare_helper.h"
 #include "models/bgmCompare/bgmCompare_logp_and_grad.h"
+#include <algorithm>
 #include <cmath>
 #include "math/explog_macros.h"
 #include "utils/common_helpers.h"
+#include "utils/parallel_helpers.h"
 #include "utils/variable_helpers.h"
 #include "priors/parameter_prior.h"
 
@@ -494,12 +496,41 @@ arma::vec gradient(
 }
 
 
+// Split the observations into per-group double matrices, in the layout
+// logp_and_gradient() takes. Groups occupy the row ranges in group_indices.
+std::vector<arma::mat> split_observations_by_group(
+    const arma::imat& observations,
+    const arma::imat& group_indices,
+    const int num_groups
+) {
+  std::vector<arma::mat> observations_group(num_groups);
+  for (int g = 0; g < num_groups; ++g) {
+    const int r0 = group_indices(g, 0);
+    const int r1 = group_indices(g, 1);
+    observations_group[g] = arma::conv_to<arma::mat>::from(observations.rows(r0, r1));
+  }
+  return observations_group;
+}
+
+
 // Computes both log pseudoposterior and gradient in a single pass.
 //
 // Fuses the computations of `log_pseudoposterior()` and `gradient()`,
 // sharing intermediate results (group-specific effects, residual matrices,
 // and probability computations) to avoid redundant work during NUTS sampling.
 //
+// Evaluation runs in three stages:
+//  1. Per group: group-specific main and pairwise effects, the residual
+//     matrix, and the linear sufficient-statistic terms.
+//  2. Per (group, block of variables) tile: log normalizers and expected
+//     sufficient statistics, written to tile-private slots.
+//  3. A reduction over groups and variables, in a fixed order: serial for
+//     the gradient entries, and tree_sum() over the (variable, group)
+//     slots for the log pseudolikelihood.
+// Stages 1 and 2 run in parallel when num_threads > 1. The tiling depends
+// on num_threads, but every slot is filled by the same arithmetic and the
+// reduction order is fixed, so the result does not depend on num_threads.
+//
 // Returns:
 //  - std::pair containing:
 //    - first: log pseudoposterior value (scalar)
@@ -510,8 +541,7 @@ std::pair<double, arma::vec> logp_and_gradient(
     const arma::imat& main_effect_indices,
     const arma::imat& pairwise_effect_indices,
     const arma::mat& projection,
-    const arma::mat& observations_double,
-    const arma::imat& group_indices,
+    const std::vector<arma::mat>& observations_group,
     const arma::ivec& num_categories,
     const std::vector<arma::imat>& counts_per_category_group,
     const std::vector<arma::imat>& blume_capel_stats_group,
@@ -526,9 +556,10 @@ std::pair<double, arma::vec> logp_and_gradient(
     const arma::vec& grad_obs,
     const BaseParameterPrior& interaction_prior,
     const BaseParameterPrior& difference_prior,
-    const BaseParameterPrior& threshold_prior
+    const BaseParameterPrior& threshold_prior,
+    const int num_threads
 ) {
-  const int num_variables  = observations_double.n_cols;
+  const int num_variables  = observations_group[0].n_cols;
   const int max_num_categories = num_categories.max();
 
   double log_pp = 0.0;
@@ -536,96 +567,154 @@ std::pair<double, arma::vec> logp_and_gradient(
 
   int off;
 
-  arma::mat main_group(num_variables, max_num_categories, arma::fill::none);
-  arma::mat pairwise_group(num_variables, num_variables, arma::fill::none);
+  // ---- stage 1: group-specific effects (one task per group) ----
+  std::vector<arma::mat> main_group(num_groups);
+  std::vector<arma::mat> pairwise_group(num_groups);
+  std::vector<arma::mat> residual_group(num_groups);
+  arma::vec linear_group(num_groups);
 
-  // --- per group ---
-  for (int g = 0; g < num_groups; ++g) {
-    const int r0 = group_indices(g, 0);
-    const int r1 = group_indices(g, 1);
-
-    const arma::imat counts_per_category = counts_per_category_group[g];
-    const arma::imat blume_capel_stats = blume_capel_stats_group[g];
+  auto build_group = [&](int g) {
+    const arma::imat& counts_per_category = counts_per_category_group[g];
+    const arma::imat& blume_capel_stats = blume_capel_stats_group[g];
     const arma::vec proj_g = projection.row(g).t();
 
-    main_group.zeros();
-    pairwise_group.zeros();
+    arma::mat& main_g = main_group[g];
+    arma::mat& pairwise_g = pairwise_group[g];
+    main_g.zeros(num_variables, max_num_categories);
+    pairwise_g.zeros(num_variables, num_variables);
 
-    // ---- build group-specific main & pairwise effects ----
+    double linear = 0.0;
     for (int v = 0; v < num_variables; v++) {
       arma::vec me = compute_group_main_effects(
         v, num_groups, main_effects, main_effect_indices, proj_g
       );
-      main_group(v, arma::span(0, me.n_elem - 1)) = me.t();
+      main_g(v, arma::span(0, me.n_elem - 1)) = me.t();
 
       for (int u = v + 1; u < num_variables; ++u) {
         double w = compute_group_pairwise_effects(
           v, u, num_groups, pairwise_effects, pairwise_effect_indices,
           inclusion_indicator, proj_g
         );
-        pairwise_group(v, u) = w;
-        pairwise_group(u, v) = w;
+        pairwise_g(v, u) = w;
+        pairwise_g(u, v) = w;
       }
 
       // ---- data contribution pseudolikelihood (linear terms) ----
       const int num_cats = num_categories(v);
       if (is_ordinal_variable(v)) {
         for (int c = 0; c < num_cats; c++) {
-          const double val = main_group(v, c);
-          log_pp += static_cast<double>(counts_per_category(c, v)) * val;
+          linear += static_cast<double>(counts_per_category(c, v)) * main_g(v, c);
         }
       } else {
-        log_pp += static_cast<double>(blume_capel_stats(0, v)) * main_group(v, 0);
-        log_pp += static_cast<double>(blume_capel_stats(1, v)) * main_group(v, 1);
+        linear += static_cast<double>(blume_capel_stats(0, v)) * main_g(v, 0);
+        linear += static_cast<double>(blume_capel_stats(1, v)) * main_g(v, 1);
       }
     }
 
     // ---- data contribution pseudolikelihood (quadratic terms) ----
-    const arma::mat obs = observations_double.rows(r0, r1);
-    const arma::mat obs_t = obs.t();  // Pre-transpose for BLAS vectorization
-    const arma::mat pairwise_stats = pairwise_stats_group[g];
+    linear += arma::accu(pairwise_g % pairwise_stats_group[g]);
+    linear_group(g) = linear;
+
+    residual_group[g] = observations_group[g] * pairwise_g;
+  };
+
+  // ---- stage 2: normalizers and expected statistics per variable ----
+  // Slots per (variable, group): the summed log normalizer, the expected
+  // main-effect statistics (K category sums for ordinal variables; linear
+  // and quadratic sums for Blume-Capel ones), and X_g^T E, the pairwise
+  // expectations against every other variable.
+  const int main_slots = std::max(max_num_categories, 2);
+  arma::mat  log_z_sum(num_variables, num_groups);
+  arma::cube main_sums(main_slots, num_variables, num_groups);
+  std::vector<arma::mat> pairwise_sums(
+    num_groups, arma::mat(num_variables, num_variables, arma::fill::none)
+  );
 
-    log_pp += arma::accu(pairwise_group % pairwise_stats);
+  auto accumulate_variable = [&](int g, int v) {
+    const int K = num_categories(v);
+    const int ref = baseline_category(v);
+    const arma::mat& obs = observations_group[g];
 
-    // ---- pseudolikelihood normalizing constants & gradient (per variable) ----
-    const arma::mat residual_matrix = obs * pairwise_group;
+    const arma::vec rest_score = residual_group[g].col(v);
+    arma::vec bound = K * rest_score;
 
-    for (int v = 0; v < num_variables; ++v) {
-      const int K = num_categories(v);
-      const int ref = baseline_category(v);
-      const int base = main_effect_indices(v, 0);
+    // Persistent per-thread scratch — survives across NUTS leapfrog calls.
+    // A tile runs start to finish on one thread, so each tile in flight
+    // has its own scratch (no contention; isolated state).
+    thread_local LogZAndProbs result;
+    thread_local LogZScratch  scratch;
+    if (is_ordinal_variable(v)) {
+      arma::vec main_param = main_group[g].row(v).cols(0, K - 1).t();
+      compute_logZ_and_probs_ordinal_into(
+        main_param, rest_score, bound, K, result, scratch
+      );
+    } else {
+      const double lin_effect = main_group[g](v, 0);
+      const double quad_effect = main_group[g](v, 1);
+      compute_logZ_and_probs_blume_capel_into(
+        rest_score, lin_effect, quad_effect, ref, K, bound, result, scratch
+      );
+    }
 
-      const arma::vec rest_score = residual_matrix.col(v);
-      arma::vec bound = K * rest_score;
+    log_z_sum(v, g) = arma::accu(result.log_Z);
 
-      // Persistent per-thread scratch — survives across NUTS leapfrog calls.
-      // Each TBB chain worker has its own thread, so each chain has its own
-      // scratch (no contention; isolated state).
-      thread_local LogZAndProbs result;
-      thread_local LogZScratch  scratch;
-      if (is_ordinal_variable(v)) {
-        arma::vec main_param = main_group.row(v).cols(0, K - 1).t();
-        compute_logZ_and_probs_ordinal_into(
-          main_param, rest_score, bound, K, result, scratch
-        );
-      } else {
-        const double lin_effect = main_group(v, 0);
-        const double quad_effect = main_group(v, 1);
-        compute_logZ_and_probs_blume_capel_into(
-          rest_score, lin_effect, quad_effect, ref, K, bound, result, scratch
-        );
+    const arma::mat& probs = result.probs;
+    arma::vec E;
+    if (is_ordinal_variable(v)) {
+      for (int s = 1; s <= K; s++) {
+        main_sums(s - 1, v, g) = arma::accu(probs.col(s));
       }
+      arma::vec weights = arma::regspace<arma::vec>(1, K);
+      E = probs.cols(1, K) * weights;
+    } else {
+      arma::vec lin_score  = arma::regspace<arma::vec>(0 - ref, K - ref);
+      arma::vec quad_score = arma::square(lin_score);
+      main_sums(0, v, g) = arma::accu(probs * lin_score);
+      main_sums(1, v, g) = arma::accu(probs * quad_score);
+      E = probs * lin_score;
+    }
 
-      // log_pp contribution: subtract log normalizers
-      log_pp -= arma::accu(result.log_Z);
+    // ---- gradient: PAIRWISE expected (BLAS vectorized) ----
+    pairwise_sums[g].col(v) = obs.t() * E;
+  };
 
-      // ---- gradient: MAIN expected ----
-      const arma::mat& probs = result.probs;
+  // Tiles: each group is cut into the same number of variable blocks, so
+  // that there are about num_threads tiles, and at least one per group.
+  const int threads = std::max(1, num_threads);
+  const int blocks_per_group = std::min(
+    num_variables, std::max(1, (threads + num_groups - 1) / num_groups)
+  );
+  const int num_tiles = num_groups * blocks_per_group;
+  auto run_tile = [&](int tile) {
+    const int g = tile / blocks_per_group;
+    int begin, end;
+    block_range(num_variables, blocks_per_group, tile % blocks_per_group, begin, end);
+    for (int v = begin; v < end; ++v) accumulate_variable(g, v);
+  };
+
+  if (threads == 1) {
+    for (int g = 0; g < num_groups; ++g) build_group(g);
+    for (int tile = 0; tile < num_tiles; ++tile) run_tile(tile);
+  } else {
+    parallel_for_blocks(num_groups, build_group);
+    parallel_for_blocks(num_tiles, run_tile);
+  }
+
+  // ---- stage 3: reduction in group, variable order ----
+  log_pp += tree_sum(linear_group.memptr(), linear_group.n_elem);
+  log_pp -= tree_sum(log_z_sum.memptr(), log_z_sum.n_elem);
+
+  for (int g = 0; g < num_groups; ++g) {
+    const arma::vec proj_g = projection.row(g).t();
+
+    for (int v = 0; v < num_variables; ++v) {
+      const int K = num_categories(v);
+      const int base = main_effect_indices(v, 0);
 
+      // ---- gradient: MAIN expected ----
       if (is_ordinal_variable(v)) {
-        for (int s = 1; s <= K; s++) {
-          const int j = s - 1;
-          double sum_col_s = arma::accu(probs.col(s));
+        for (int j = 0; j < K; j++) {
+          const double sum_col_s = main_sums(j, v, g);
 
           off = main_index(base + j, 0);
           grad(off) -= sum_col_s;
@@ -637,11 +726,8 @@ std::pair<double, arma::vec> logp_and_gradient(
           }
         }
       } else {
-        arma::vec lin_score  = arma::regspace<arma::vec>(0 - ref, K - ref);
-        arma::vec quad_score = arma::square(lin_score);
-
-        double sum_lin  = arma::accu(probs * lin_score);
-        double sum_quad = arma::accu(probs * quad_score);
+        const double sum_lin  = main_sums(0, v, g);
+        const double sum_quad = main_sums(1, v, g);
 
         off = main_index(base, 0);
         grad(off) -= sum_lin;
@@ -658,22 +744,11 @@ std::pair<double, arma::vec> logp_and_gradient(
         }
       }
 
-      // ---- gradient: PAIRWISE expected (BLAS vectorized) ----
-      arma::vec E;
-      if (is_ordinal_variable(v)) {
-        arma::vec weights = arma::regspace<arma::vec>(1, K);
-        E = probs.cols(1, K) * weights;
-      } else {
-        arma::vec score = arma::regspace<arma::vec>(0 - ref, K - ref);
-        E = probs * score;
-      }
-
-      arma::vec pw_grad = obs_t * E;
-
+      // ---- gradient: PAIRWISE expected ----
       for (int v2 = 0; v2 < num_variables; v2++) {
         if (v == v2) continue;
 
-        double sum_expectation = pw_grad(v2);
+        double sum_expectation = pairwise_sums[g](v2, v);
 
         const int row = (v < v2) ? pairwise_effect_indices(v, v2)
           : pairwise_effect_indices(v2, v);
@@ -691,48 +766,24 @@ std::pair<double, arma::vec> logp_and_gradient(
   }
 
   // -------------------------------
-  // Priors (same as in log_pseudoposterior and gradient)
+  // Priors (same as in log_pseudoposterior and gradient), each evaluated
+  // once over all of its terms (see PriorBatch)
   // -------------------------------
+  PriorBatch threshold_terms(main_effects.n_rows);
+  PriorBatch interaction_terms(pairwise_effects.n_rows);
+  PriorBatch difference_terms(grad.n_elem);
 
   // Main effects prior
   for (int v = 0; v < num_variables; v++) {
-    const int r0 = main_effect_indices(v, 0);
-    const int num_cats = num_categories(v);
     const int base = main_effect_indices(v, 0);
+    const int num_terms = is_ordinal_variable(v) ? num_categories(v) : 2;
 
-    if (is_ordinal_variable(v)) {
-      for (int c = 0; c < num_cats; ++c) {
-        double value = main_effects(r0 + c, 0);
-        log_pp += threshold_prior.logp(value);
-
-        off = main_index(base + c, 0);
-        grad(off) += threshold_prior.grad(value);
-
-        if (inclusion_indicator(v, v) == 0) continue;
-        for (int eff = 1; eff < num_groups; eff++) {
-          double diff_val = main_effects(r0 + c, eff);
-          log_pp += difference_prior.logp(diff_val);
-
-          off = main_index(base + c, eff);
-          grad(off) += difference_prior.grad(diff_val);
-        }
-      }
-    } else {
-      for (int par = 0; par < 2; ++par) {
-        double value = main_effects(r0 + par, 0);
-        log_pp += threshold_prior.logp(value);
-
-        off = main_index(base + par, 0);
-        grad(off) += threshold_prior.grad(value);
-
-        if (inclusion_indicator(v, v) == 0) continue;
-        for (int eff = 1; eff < num_groups; eff++) {
-          double diff_val = main_effects(r0 + par, eff);
-          log_pp += difference_prior.logp(diff_val);
+    for (int c = 0; c < num_terms; ++c) {
+      threshold_terms.add(main_effects(base + c, 0), main_index(base + c, 0));
 
-          off = main_index(base + par, eff);
-          grad(off) += difference_prior.grad(diff_val);
-        }
+      if (inclusion_indicator(v, v) == 0) continue;
+      for (int eff = 1; eff < num_groups; eff++) {
+        difference_terms.add(main_effects(base + c, eff), main_index(base + c, eff));
       }
     }
   }
@@ -741,29 +792,77 @@ std::pair<double, arma::vec> logp_and_gradient(
   for (int v1 = 0; v1 < num_variables - 1; v1++) {
     for (int v2 = v1 + 1; v2 < num_variables; v2++) {
       const int idx = pairwise_effect_indices(v1, v2);
-
-      double value = pairwise_effects(idx, 0);
-      log_pp += interaction_prior.logp(value, pairwise_scaling_factors(v1, v2));
-
-      off = pair_index(idx, 0);
-      grad(off) += interaction_prior.grad(value, pairwise_scaling_factors(v1, v2));
+      const double scale_factor = pairwise_scaling_factors(v1, v2);
+      interaction_terms.add(pairwise_effects(idx, 0), pair_index(idx, 0), scale_factor);
 
       if (inclusion_indicator(v1, v2) == 0) continue;
       for (int eff = 1; eff < num_groups; eff++) {
-        double diff_val = pairwise_effects(idx, eff);
-        log_pp += difference_prior.logp(diff_val, pairwise_scaling_factors(v1, v2));
-
-        off = pair_index(idx, eff);
-        grad(off) += difference_prior.grad(diff_val, pairwise_scaling_factors(v1, v2));
+        difference_terms.add(pairwise_effects(idx, eff), pair_index(idx, eff), scale_factor);
       }
     }
   }
 
+  log_pp += threshold_terms.evaluate(threshold_prior, grad);
+  log_pp += interaction_terms.evaluate(interaction_prior, grad);
+  log_pp += difference_terms.evaluate(difference_prior, grad);
+
   return {log_pp, grad};
 }
 
 
 
+// Per-group residual matrices for the Metropolis updates of bgmCompare.
+//
+// Column v of residual_matrices[g] holds the rest scores of variable v,
+//   r_iv = sum_u x_iu * w_g(u, v),
+// for the persons i of group g, where w_g are the group-specific pairwise
+// effects under the current inclusion indicators. The element-wise updates
+// read these columns instead of rebuilding group-specific effects, and keep
+// them current on acceptance by adding delta_g * x_u to column v (and
+// delta_g * x_v to column u) for a change delta_g in w_g(u, v).
+//
+// Inputs:
+//  - pairwise_effects: Matrix of pairwise-effect parameters (rows = pairs, cols = groups).
+//  - pairwise_effect_indices: Lookup table mapping (var1, var2) to row in pairwise_effects.
+//  - inclusion_indicator: Symmetric binary matrix of active pairs (off-diag).
+//  - projection: Group projection matrix (num_groups × (num_groups − 1)).
+//  - observations_group: Per-group observations as double (see split_observations_by_group()).
+//  - num_groups: Number of groups.
+//
+// Returns:
+//  - One (n_g × V) residual matrix per group.
+std::vector<arma::mat> compute_residual_matrices(
+    const arma::mat& pairwise_effects,
+    const arma::imat& pairwise_effect_indices,
+    const arma::imat& inclusion_indicator,
+    const arma::mat& projection,
+    const std::vector<arma::mat>& observations_group,
+    const int num_groups
+) {
+  const int num_variables = inclusion_indicator.n_cols;
+  std::vector<arma::mat> residual_matrices(num_groups);
+  arma::mat pairwise_group(num_variables, num_variables);
+
+  for (int g = 0; g < num_groups; ++g) {
+    const arma::vec proj_g = projection.row(g).t();
+    pairwise_group.zeros();
+    for (int v = 0; v < num_variables - 1; ++v) {
+      for (int u = v + 1; u < num_variables; ++u) {
+        const double w = compute_group_pairwise_effects(
+          v, u, num_groups, pairwise_effects, pairwise_effect_indices,
+          inclusion_indicator, proj_g
+        );
+        pairwise_group(v, u) = w;
+        pairwise_group(u, v) = w;
+      }
+    }
+    residual_matrices[g] = observations_group[g] * pairwise_group;
+  }
+  return residual_matrices;
+}
+
+
+
 // Computes the log pseudoposterior contribution of a single main-effect parameter (bgmCompare model).
 //
 // This function isolates the contribution of one main-effect parameter,
@@ -773,30 +872,25 @@ std::pair<double, arma::vec> logp_and_gradient(
 //  - For each group:
 //    * Construct group-specific main effects for the selected variable
 //      with `compute_group_main_effects()`.
-//    * Construct group-specific pairwise effects for the variable.
 //    * Add linear contributions from sufficient statistics.
-//    * Subtract log normalizing constants from the group-specific likelihood.
+//    * Subtract log normalizing constants from the group-specific likelihood,
+//      with the rest scores read from the group's residual matrix.
 //  - Add prior contribution:
 //    * Logistic–Beta prior for baseline (h == 0).
 //    * Cauchy prior for group differences (h > 0), if included.
 //
 // Inputs:
 //  - main_effects: Matrix of main-effect parameters (rows = categories, cols = groups).
-//  - pairwise_effects: Matrix of pairwise-effect parameters (rows = pairs, cols = groups).
 //  - main_effect_indices: Index ranges [row_start,row_end] for each variable.
-//  - pairwise_effect_indices: Lookup table mapping (var1,var2) → row in pairwise_effects.
 //  - projection: Group projection matrix (num_groups × (num_groups − 1)).
-//  - observations: Observation matrix (persons × variables).
-//  - group_indices: Row ranges [start,end] for each group in observations.
 //  - num_categories: Number of categories per variable.
 //  - counts_per_category_group: Per-group category counts (for ordinal variables).
 //  - blume_capel_stats_group: Per-group sufficient statistics (for Blume–Capel variables).
+//  - residual_matrices: Per-group residual matrices (see compute_residual_matrices()).
 //  - num_groups: Number of groups.
 //  - inclusion_indicator: Symmetric binary matrix of active variables (diag) and pairs (off-diag).
 //  - is_ordinal_variable: Indicator (1 = ordinal, 0 = Blume–Capel).
 //  - baseline_category: Reference categories for Blume–Capel variables.
-//  - main_alpha, main_beta: Hyperparameters for Beta priors on main effects.
-//  - difference_scale: Scale parameter for Cauchy priors on group differences.
 //  - variable: Index of the variable of interest.
 //  - category: Category index (only used if variable is ordinal).
 //  - par: Parameter index (0 = linear, 1 = quadratic; used for Blume–Capel).
@@ -812,15 +906,12 @@ std::pair<double, arma::vec> logp_and_gradient(
 //  - Consistent with the full `log_pseudoposterior()` for bgmCompare.
 double log_pseudoposterior_main_component(
     const arma::mat& main_effects,
-    const arma::mat& pairwise_effects,
     const arma::imat& main_effect_indices,
-    const arma::imat& pairwise_effect_indices,
     const arma::mat& projection,
-    const arma::imat& observations,
-    const arma::imat& group_indices,
     const arma::ivec& num_categories,
     const std::vector<arma::imat>& counts_per_category_group,
     const std::vector<arma::imat>& blume_capel_stats_group,
+    const std::vector<arma::mat>& residual_matrices,
     const int num_groups,
     const arma::imat& inclusion_indicator,
     const arma::uvec& is_ordinal_variable,
@@ -836,75 +927,40 @@ double log_pseudoposterior_main_component(
     return 0.0; // No contribution if differences not included
   }
 
-  const int num_variables = observations.n_cols;
-  const int max_num_categories = num_categories.max();
+  const int num_cats = num_categories(variable);
   double log_pp = 0.0;
 
   // --- per group ---
   for (int group = 0; group < num_groups; ++group) {
-    const arma::imat counts_per_category = counts_per_category_group[group];
-    const arma::imat blume_capel_stats = blume_capel_stats_group[group];
-
-    arma::mat main_group(num_variables, max_num_categories, arma::fill::zeros);
-    arma::mat pairwise_group(num_variables, num_variables, arma::fill::zeros);
-
     const arma::vec proj_g = projection.row(group).t(); // length = num_groups-1
 
-    // ---- build group-specific main & pairwise effects ----
-    arma::vec me = compute_group_main_effects(
+    // ---- group-specific main effects of the variable ----
+    const arma::vec main_group = compute_group_main_effects(
       variable, num_groups, main_effects, main_effect_indices, proj_g
     );
 
-    // store into row v
-    main_group(variable, arma::span(0, me.n_elem - 1)) = me.t();
-
-    // upper triangle incl. base value; mirror to keep symmetry
-    for (int u = 0; u < num_variables; u++) {
-      if(u == variable) continue;
-      double w = compute_group_pairwise_effects(
-        variable, u, num_groups, pairwise_effects, pairwise_effect_indices,
-        inclusion_indicator, proj_g
-      );
-      pairwise_group(variable, u) = w;
-      pairwise_group(u, variable) = w;
-    }
-
     // ---- data contribution pseudolikelihood (linear terms) ----
     if (is_ordinal_variable(variable)) {
-      const double val = main_group(variable, category);
-      log_pp += static_cast<double>(counts_per_category(category, variable)) * val;
+      log_pp += static_cast<double>(
+        counts_per_category_group[group](category, variable)) * main_group(category);
     } else {
-      log_pp += static_cast<double>(blume_capel_stats(par, variable)) *
-        main_group(variable, par);
+      log_pp += static_cast<double>(
+        blume_capel_stats_group[group](par, variable)) * main_group(par);
     }
 
-    // ---- data contribution pseudolikelihood (quadratic terms) ----
-    const int r0 = group_indices(group, 0);
-    const int r1 = group_indices(group, 1);
-    const arma::mat obs = arma::conv_to<arma::mat>::from(observations.rows(r0, r1));
-
     // ---- pseudolikelihood normalizing constants (per variable) ----
-    const arma::vec rest_score = obs * pairwise_group.col(variable);
-    const int num_cats = num_categories(variable);
+    const arma::vec rest_score = residual_matrices[group].col(variable);
 
     // bound to stabilize exp; use group-specific params consistently
     arma::vec bound = num_cats * rest_score;
-    arma::vec denom(rest_score.n_elem, arma::fill::zeros);
+    arma::vec denom;
 
     if (is_ordinal_variable(variable)) {
-      arma::vec main_eff = main_group.row(variable).cols(0, num_cats - 1).t();
-      denom = compute_denom_ordinal(
-        rest_score, main_eff, bound
-      );
+      denom = compute_denom_ordinal(rest_score, main_group, bound);
     } else {
-      // linear/quadratic main effects from main_group
-      const double lin_effect  = main_group(variable, 0);
-      const double quad_effect = main_group(variable, 1);
-      const int ref = baseline_category(variable);
-
       denom = compute_denom_blume_capel(
-        rest_score, lin_effect, quad_effect, ref, num_cats,
-        /*updated in place:*/bound
+        rest_score, main_group(0), main_group(1), baseline_category(variable),
+        num_cats, /*updated in place:*/bound
       );
     }
 
@@ -913,24 +969,14 @@ double log_pseudoposterior_main_component(
   }
 
   // ---- priors ----
+  const int r = main_effect_indices(variable, 0) +
+    (is_ordinal_variable(variable) ? category : par);
   if (h == 0) {
     // Main effects prior (baseline)
-    if(is_ordinal_variable(variable)) {
-      int r = main_effect_indices(variable, 0) + category;
-      log_pp += threshold_prior.logp(main_effects(r, 0));
-    } else {
-      int r = main_effect_indices(variable, 0) + par;
-      log_pp += threshold_prior.logp(main_effects(r, 0));
-    }
+    log_pp += threshold_prior.logp(main_effects(r, 0));
   } else {
     // Group-difference prior
-    if(is_ordinal_variable(variable)) {
-      int r = main_effect_indices(variable, 0) + category;
-      log_pp += difference_prior.logp(main_effects(r, h));
-    } else {
-      int r = main_effect_indices(variable, 0) + par;
-      log_pp += difference_prior.logp(main_effects(r, h));
-    }
+    log_pp += difference_prior.logp(main_effects(r, h));
   }
 
   return log_pp;
@@ -959,8 +1005,7 @@ double log_pseudoposterior_main_component(
 //  - main_effect_indices: Index ranges [row_start, row_end] for each variable.
 //  - pairwise_effect_indices: Lookup table mapping (var1, var2) to row in pairwise_effects.
 //  - projection: Group projection matrix (num_groups × (num_groups − 1)).
-//  - observations: Observation matrix (persons × variables).
-//  - group_indices: Row ranges [start, end] for each group in observations.
+//  - observations_group: Per-group observations as double (persons × variables).
 //  - num_categories: Number of categories per variable.
 //  - pairwise_stats_group: Per-group pairwise sufficient statistics.
 //  - residual_matrices: Per-group residual matrices (persons × variables).
@@ -988,8 +1033,7 @@ double log_pseudoposterior_pair_component(
     const arma::imat& main_effect_indices,
     const arma::imat& pairwise_effect_indices,
     const arma::mat& projection,
-    const arma::imat& observations,
-    const arma::imat& group_indices,
+    const std::vector<arma::mat>& observations_group,
     const arma::ivec& num_categories,
     const std::vector<arma::mat>& pairwise_stats_group,
     const std::vector<arma::mat>& residual_matrices,
@@ -1009,8 +1053,6 @@ double log_pseudoposterior_pair_component(
     return 0.0;
   }
 
-  const int num_variables = observations.n_cols;
-  const int max_num_categories = num_categories.max();
   double log_pp = 0.0;
   int idx = pairwise_effect_indices(variable1, variable2);
 
@@ -1024,15 +1066,6 @@ double log_pseudoposterior_pair_component(
     // Compute group-specific delta: how much pairwise_group(var1,var2) changes for this group
     double delta_g = (h == 0) ? delta : delta * proj_g(h - 1);
 
-    // ---- build group-specific main effects (only for the two variables) ----
-    arma::mat main_group(num_variables, max_num_categories, arma::fill::zeros);
-    for (int v : {variable1, variable2}) {
-      arma::vec me = compute_group_main_effects(
-        v, num_groups, main_effects, main_effect_indices, proj_g
-      );
-      main_group(v, arma::span(0, me.n_elem - 1)) = me.t();
-    }
-
     // ---- data contribution pseudolikelihood ----
     const arma::mat& pairwise_stats = pairwise_stats_group[group];
     const double suff_pair = pairwise_stats(variable1, variable2);
@@ -1044,32 +1077,27 @@ double log_pseudoposterior_pair_component(
     }
 
     // ---- pseudolikelihood normalizing constants (using residual matrix + delta) ----
-    const int r0 = group_indices(group, 0);
-    const int r1 = group_indices(group, 1);
-    
-    // Pre-convert observation columns for the two variables (needed for delta adjustment)
-    const arma::vec obs_var1 = arma::conv_to<arma::vec>::from(observations.col(variable1).rows(r0, r1));
-    const arma::vec obs_var2 = arma::conv_to<arma::vec>::from(observations.col(variable2).rows(r0, r1));
+    const arma::mat& obs = observations_group[group];
 
     for (int v : {variable1, variable2}) {
       const int num_cats = num_categories(v);
-      const arma::vec& obs_other = (v == variable1) ? obs_var2 : obs_var1;
+      const int other = (v == variable1) ? variable2 : variable1;
+      const arma::vec main_group = compute_group_main_effects(
+        v, num_groups, main_effects, main_effect_indices, proj_g
+      );
 
       // Use residual_matrix with delta adjustment: O(n) instead of O(n*p)
-      arma::vec rest_score = residual_matrices[group].col(v) + obs_other * delta_g;
+      arma::vec rest_score = residual_matrices[group].col(v) + obs.col(other) * delta_g;
 
       // bound to stabilize exp
       arma::vec bound = num_cats * rest_score;
-      arma::vec denom(rest_score.n_elem, arma::fill::zeros);
+      arma::vec denom;
 
       if (is_ordinal_variable(v)) {
-        arma::vec main_eff = main_group.row(v).cols(0, num_cats - 1).t();
-        denom = compute_denom_ordinal(rest_score, main_eff, bound);
+        denom = compute_denom_ordinal(rest_score, main_group, bound);
       } else {
-        const double lin_effect  = main_group(v, 0);
-        const double quad_effect = main_group(v, 1);
         const int ref = baseline_category(v);
-        denom = compute_denom_blume_capel(rest_score, lin_effect, quad_effect, ref, num_cats, bound);
+        denom = compute_denom_blume_capel(rest_score, main_group(0), main_group(1), ref, num_cats, bound);
       }
 
       log_pp -= arma::accu(bound + ARMA_MY_LOG(denom));
@@ -1090,34 +1118,36 @@ double log_pseudoposterior_pair_component(
 // Computes the log-ratio of pseudolikelihood normalizing constants
 // for a single variable under current vs. proposed parameters (bgmCompare model).
 //
-// This function is used in Metropolis–Hastings updates for main-effect parameters.
-// It evaluates how the normalizing constant (denominator of the pseudolikelihood)
-// changes when switching from the current to the proposed parameter values.
+// This function is used in Metropolis–Hastings updates of the difference
+// indicators. It evaluates how the normalizing constant (denominator of the
+// pseudolikelihood) changes when switching from the current to the proposed
+// parameter values.
 //
 // Procedure:
 //  - For each group:
 //    * Construct group-specific main effects (current vs. proposed).
-//    * Construct group-specific pairwise weights for the variable.
-//    * Compute residual scores for observations under both models.
+//    * Take the variable's rest scores from the group's residual matrix,
+//      shifted by x_other * shift for the one pairwise weight that differs
+//      from the residual matrix (current and proposed shift).
 //    * Calculate denominators with stability bounds (ordinal vs. Blume–Capel cases).
 //    * Accumulate the log-ratio contribution across all observations.
 //
 // Inputs:
 //  - current_main_effects, proposed_main_effects: Matrices of main-effect parameters
 //    (rows = categories, cols = groups).
-//  - current_pairwise_effects, proposed_pairwise_effects: Matrices of pairwise-effect parameters
-//    (rows = pairs, cols = groups).
 //  - main_effect_indices: Index ranges [row_start,row_end] for each variable.
-//  - pairwise_effect_indices: Lookup table mapping (var1,var2) → row in pairwise_effects.
 //  - projection: Group projection matrix (num_groups × (num_groups − 1)).
-//  - observations: Observation matrix (persons × variables).
-//  - group_indices: Row ranges [start,end] for each group in observations.
+//  - observations_group: Per-group observations as double (persons × variables).
+//  - residual_matrices: Per-group residual matrices (persons × variables).
 //  - num_categories: Number of categories per variable.
 //  - num_groups: Number of groups.
-//  - inclusion_indicator: Symmetric binary matrix of active variables (diag) and pairs (off-diag).
 //  - is_ordinal_variable: Indicator (1 = ordinal, 0 = Blume–Capel).
 //  - baseline_category: Reference categories for Blume–Capel variables.
 //  - variable: Index of the variable being updated.
+//  - other: Partner variable whose weight w_g(variable, other) is shifted,
+//    or -1 if the rest scores are those of the residual matrices.
+//  - shift_current, shift_proposed: Per-group shifts of that weight
+//    (unused when other == -1).
 //
 // Returns:
 //  - The scalar log-ratio of pseudolikelihood constants
@@ -1130,23 +1160,21 @@ double log_pseudoposterior_pair_component(
 //  - Stability bounds (`bound_current`, `bound_proposed`) are applied to avoid overflow.
 double log_ratio_pseudolikelihood_constant_variable(
     const arma::mat& current_main_effects,
-    const arma::mat& current_pairwise_effects,
     const arma::mat& proposed_main_effects,
-    const arma::mat& proposed_pairwise_effects,
     const arma::imat& main_effect_indices,
-    const arma::imat& pairwise_effect_indices,
     const arma::mat& projection,
-    const arma::imat& observations,
-    const arma::imat& group_indices,
+    const std::vector<arma::mat>& observations_group,
+    const std::vector<arma::mat>& residual_matrices,
     const arma::ivec& num_categories,
     const int num_groups,
-    const arma::imat& inclusion_indicator,
     const arma::uvec& is_ordinal_variable,
     const arma::ivec& baseline_category,
-    const int variable
+    const int variable,
+    const int other,
+    const arma::vec& shift_current,
+    const arma::vec& shift_proposed
 ) {
   const int num_cats = num_categories(variable);
-  const int num_variables = observations.n_cols;
 
   double log_ratio = 0.0;
 
@@ -1162,50 +1190,31 @@ double log_ratio_pseudolikelihood_constant_variable(
       variable, num_groups, proposed_main_effects, main_effect_indices, proj_g
     );
 
-    // --- group-specific pairwise effects for this variable (column) ---
-    arma::vec weights_current(num_variables, arma::fill::zeros);
-    arma::vec weights_proposed(num_variables, arma::fill::zeros);
-    for (int u = 0; u < num_variables; ++u) {
-      if (u == variable) continue;
-      weights_current(u) = compute_group_pairwise_effects(
-        variable, u, num_groups, current_pairwise_effects,
-        pairwise_effect_indices, inclusion_indicator, proj_g
-      );
-      weights_proposed(u) = compute_group_pairwise_effects(
-        variable, u, num_groups, proposed_pairwise_effects,
-        pairwise_effect_indices, inclusion_indicator, proj_g
-      );
+    // --- rest scores from the residual matrix ---
+    arma::vec rest_current = residual_matrices[group].col(variable);
+    arma::vec rest_proposed = rest_current;
+    if (other >= 0) {
+      const auto x_other = observations_group[group].col(other);
+      rest_current += x_other * shift_current(group);
+      rest_proposed += x_other * shift_proposed(group);
     }
 
-    // --- group observations and rest scores ---
-    const int r0 = group_indices(group, 0);
-    const int r1 = group_indices(group, 1);
-    const arma::mat obs = arma::conv_to<arma::mat>::from(observations.rows(r0, r1));
-
-    const arma::vec rest_current = obs * weights_current;
-    const arma::vec rest_proposed = obs * weights_proposed;
-
     // --- denominators with stability bounds ---
-    arma::vec bound_current;
-    arma::vec bound_proposed;
-    arma::vec denom_current(rest_current.n_elem, arma::fill::zeros);
-    arma::vec denom_proposed(rest_proposed.n_elem, arma::fill::zeros);
+    arma::vec bound_current = rest_current * num_cats;
+    arma::vec bound_proposed = rest_proposed * num_cats;
+    arma::vec denom_current;
+    arma::vec denom_proposed;
 
     if (is_ordinal_variable (variable)) {
-      bound_current = rest_current * num_cats;
-      bound_proposed = rest_proposed * num_cats;
-
-      denom_current += compute_denom_ordinal(
+      denom_current = compute_denom_ordinal(
         rest_current, main_current, bound_current
       );
-      denom_proposed += compute_denom_ordinal(
+      denom_proposed = compute_denom_ordinal(
         rest_proposed, main_proposed, bound_proposed
       );
     } else {
       // Binary or categorical variable: linear + quadratic score
       const int ref_cat = baseline_category (variable);
-      bound_current = rest_current * num_cats;
-      bound_proposed = rest_proposed * num_cats;
 
       denom_current = compute_denom_blume_capel(
         rest_current, main_current (0), main_current (1),
@@ -1241,22 +1250,20 @@ double log_ratio_pseudolikelihood_constant_variable(
 //    * Add contributions from observed sufficient statistics
 //      (category counts or Blume–Capel stats).
 //  - Add the ratio of pseudolikelihood normalizing constants by calling
-//    `log_ratio_pseudolikelihood_constant_variable()`.
+//    `log_ratio_pseudolikelihood_constant_variable()`; the pairwise effects
+//    do not change, so the rest scores are the residual-matrix columns.
 //
 // Inputs:
 //  - current_main_effects: Matrix of main-effect parameters (current state).
 //  - proposed_main_effects: Matrix of main-effect parameters (candidate state).
-//  - current_pairwise_effects: Matrix of pairwise-effect parameters (fixed at current state).
 //  - main_effect_indices: Index ranges [row_start,row_end] for each variable.
-//  - pairwise_effect_indices: Lookup table mapping (var1,var2) → row in pairwise_effects.
 //  - projection: Group projection matrix (num_groups × (num_groups − 1)).
-//  - observations: Observation matrix (persons × variables).
-//  - group_indices: Row ranges [start,end] for each group in observations.
+//  - observations_group: Per-group observations as double (persons × variables).
+//  - residual_matrices: Per-group residual matrices (persons × variables).
 //  - num_categories: Number of categories per variable.
 //  - counts_per_category_group: Per-group category counts (for ordinal variables).
 //  - blume_capel_stats_group: Per-group sufficient statistics (for Blume–Capel variables).
 //  - num_groups: Number of groups.
-//  - inclusion_indicator: Symmetric binary matrix of active variables (diag) and pairs (off-diag).
 //  - is_ordinal_variable: Indicator (1 = ordinal, 0 = Blume–Capel).
 //  - baseline_category: Reference categories for Blume–Capel variables.
 //  - variable: Index of the variable being updated.
@@ -1265,32 +1272,25 @@ double log_ratio_pseudolikelihood_constant_variable(
 //  - The scalar log pseudolikelihood ratio (proposed vs. current).
 //
 // Notes:
-//  - A temporary copy of `inclusion_indicator` is made to ensure the
-//    variable’s self-term (diagonal entry) is included.
 //  - Only the variable under update changes between current and proposed states;
 //    all other variables and pairwise effects remain fixed.
 //  - This function does not add prior contributions — only pseudolikelihood terms.
 double log_pseudolikelihood_ratio_main(
     const arma::mat& current_main_effects,
     const arma::mat& proposed_main_effects,
-    const arma::mat& current_pairwise_effects,
     const arma::imat& main_effect_indices,
-    const arma::imat& pairwise_effect_indices,
     const arma::mat&  projection,
-    const arma::imat& observations,
-    const arma::imat& group_indices,
+    const std::vector<arma::mat>& observations_group,
+    const std::vector<arma::mat>& residual_matrices,
     const arma::ivec& num_categories,
     const std::vector<arma::imat>& counts_per_category_group,
     const std::vector<arma::imat>& blume_capel_stats_group,
     const int num_groups,
-    const arma::imat& inclusion_indicator,
     const arma::uvec& is_ordinal_variable,
     const arma::ivec& baseline_category,
     const int variable
 ) {
   double lr = 0.0;
-  arma::imat tmp_ind = inclusion_indicator;
-  tmp_ind(variable, variable) = 1; // Ensure self-interaction is included
 
   // Add data contribution (group-specific parameters via projection)
   for (int g = 0; g < num_groups; ++g) {
@@ -1317,12 +1317,12 @@ double log_pseudolikelihood_ratio_main(
   }
 
   // Add ratio of normalizing constants
+  const arma::vec no_shift;
   lr += log_ratio_pseudolikelihood_constant_variable(
-    current_main_effects, current_pairwise_effects, proposed_main_effects,
-    /* same */ current_pairwise_effects, main_effect_indices,
-    pairwise_effect_indices, projection, observations, group_indices,
-    num_categories, num_groups, tmp_ind, is_ordinal_variable,
-    baseline_category, variable
+    current_main_effects, proposed_main_effects, main_effect_indices,
+    projection, observations_group, residual_matrices, num_categories,
+    num_groups, is_ordinal_variable, baseline_category, variable,
+    /*other=*/-1, no_shift, no_shift
   );
 
   return lr;
@@ -1339,11 +1339,12 @@ double log_pseudolikelihood_ratio_main(
 // Procedure:
 //  - Ensure the interaction is included in a temporary copy of inclusion_indicator.
 //  - For each group:
-//    * Compute group-specific pairwise effect for (var1,var2), current vs. proposed.
+//    * Compute group-specific pairwise effect for (var1,var2), current vs. proposed,
+//      and the effect the residual matrices were built with.
 //    * Add linear contribution from the pairwise sufficient statistic.
 //  - Add the ratio of pseudolikelihood normalizing constants for both variables:
 //    * Call `log_ratio_pseudolikelihood_constant_variable()` separately for var1 and var2,
-//      comparing current vs. proposed pairwise weights.
+//      shifting the residual-matrix rest scores to the current and proposed weights.
 //
 // Inputs:
 //  - main_effects: Matrix of main-effect parameters (fixed).
@@ -1352,8 +1353,9 @@ double log_pseudolikelihood_ratio_main(
 //  - main_effect_indices: Index ranges [row_start,row_end] for each variable.
 //  - pairwise_effect_indices: Lookup table mapping (var1,var2) → row in pairwise_effects.
 //  - projection: Group projection matrix (num_groups × (num_groups − 1)).
-//  - observations: Observation matrix (persons × variables).
-//  - group_indices: Row ranges [start,end] for each group in observations.
+//  - observations_group: Per-group observations as double (persons × variables).
+//  - residual_matrices: Per-group residual matrices (persons × variables), built
+//    from current_pairwise_effects under inclusion_indicator.
 //  - num_categories: Number of categories per variable.
 //  - pairwise_stats_group: Per-group pairwise sufficient statistics.
 //  - num_groups: Number of groups.
@@ -1377,8 +1379,8 @@ double log_pseudolikelihood_ratio_pairwise(
     const arma::imat& main_effect_indices,
     const arma::imat& pairwise_effect_indices,
     const arma::mat& projection,
-    const arma::imat& observations,
-    const arma::imat& group_indices,
+    const std::vector<arma::mat>& observations_group,
+    const std::vector<arma::mat>& residual_matrices,
     const arma::ivec& num_categories,
     const std::vector<arma::mat>& pairwise_stats_group,
     const int num_groups,
@@ -1394,7 +1396,10 @@ double log_pseudolikelihood_ratio_pairwise(
   tmp_ind(var1, var2) = 1;
   tmp_ind(var2, var1) = 1;
 
-  // Add data contribution
+  // Add data contribution, and the shifts of w_g(var1, var2) relative to
+  // the weight in the residual matrices
+  arma::vec shift_current(num_groups);
+  arma::vec shift_proposed(num_groups);
   for (int g = 0; g < num_groups; ++g) {
     const arma::vec proj_g = projection.row(g).t();
     const arma::mat& suff  = pairwise_stats_group[g];
@@ -1407,25 +1412,31 @@ double log_pseudolikelihood_ratio_pairwise(
       var1, var2, num_groups, proposed_pairwise_effects,
       pairwise_effect_indices, tmp_ind, proj_g
     );
+    const double w_residual = compute_group_pairwise_effects(
+      var1, var2, num_groups, current_pairwise_effects,
+      pairwise_effect_indices, inclusion_indicator, proj_g
+    );
 
     lr += 2.0 * (w_prop - w_cur) * suff(var1, var2);
+    shift_current(g) = w_cur - w_residual;
+    shift_proposed(g) = w_prop - w_residual;
   }
 
   // Add ratio of normalizing constant for `var1`
   lr += log_ratio_pseudolikelihood_constant_variable(
-    main_effects, current_pairwise_effects, /* same */ main_effects,
-    proposed_pairwise_effects, main_effect_indices, pairwise_effect_indices,
-    projection, observations, group_indices, num_categories, num_groups,
-    tmp_ind, is_ordinal_variable, baseline_category, var1
+    main_effects, /* same */ main_effects, main_effect_indices, projection,
+    observations_group, residual_matrices, num_categories, num_groups,
+    is_ordinal_variable, baseline_category, var1, var2,
+    shift_current, shift_proposed
   );
 
   // Add ratio of normalizing constant for `var2`
   lr += log_ratio_pseudolikelihood_constant_variable(
-    main_effects, current_pairwise_effects, /* same */ main_effects,
-    proposed_pairwise_effects, main_effect_indices, pairwise_effect_indices,
-    projection, observations, group_indices, num_categories, num_groups,
-    tmp_ind, is_ordinal_variable, baseline_category, var2
+    main_effects, /* same */ main_effects, main_effect_indices, projection,
+    observations_group, residual_matrices, num_categories, num_groups,
+    is_ordinal_variable, baseline_category, var2, var1,
+    shift_current, shift_proposed
   );
 
   return lr;
-}
\ No newline at end of file
+}
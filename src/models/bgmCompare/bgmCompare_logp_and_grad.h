@@ -14,6 +14,7 @@
  */
 
 #include <RcppArmadillo.h>
+#include <vector>
 #include "priors/parameter_prior.h"
 
 
@@ -144,9 +145,16 @@ arma::vec gradient(
  *
  * Shares intermediate computations (group-specific effects, residual
  * matrices, probability vectors) to avoid redundant work during NUTS.
+ * With num_threads > 1, groups and (group, variable-block) tiles are
+ * evaluated in parallel and reduced in a fixed order, so the result is the
+ * same for every thread count.
  *
+ * @param observations_group  Observations as double, one (n_g x V) matrix
+ *                            per group (see split_observations_by_group())
+ * @param num_threads         Threads for the within-call parallel loops
+ *                            (1 = serial)
  * @return Pair of (log-pseudoposterior value, gradient vector)
- * @see gradient() for parameter descriptions
+ * @see gradient() for the remaining parameter descriptions
  */
 std::pair<double, arma::vec> logp_and_gradient(
     const arma::mat& main_effects,
@@ -154,8 +162,7 @@ std::pair<double, arma::vec> logp_and_gradient(
     const arma::imat& main_effect_indices,
     const arma::imat& pairwise_effect_indices,
     const arma::mat& projection,
-    const arma::mat& observations_double,
-    const arma::imat& group_indices,
+    const std::vector<arma::mat>& observations_group,
     const arma::ivec& num_categories,
     const std::vector<arma::imat>& counts_per_category_group,
     const std::vector<arma::imat>& blume_capel_stats_group,
@@ -170,15 +177,52 @@ std::pair<double, arma::vec> logp_and_gradient(
     const arma::vec& grad_obs,
     const BaseParameterPrior& interaction_prior,
     const BaseParameterPrior& difference_prior,
-    const BaseParameterPrior& threshold_prior
+    const BaseParameterPrior& threshold_prior,
+    const int num_threads = 1
+);
+
+/**
+ * Split the observations into per-group double matrices.
+ *
+ * @param observations   Integer observation matrix (n x V), sorted by group
+ * @param group_indices  Group start/end row indices per group (G x 2)
+ * @param num_groups     Number of groups (G)
+ * @return One (n_g x V) matrix per group, as taken by logp_and_gradient()
+ */
+std::vector<arma::mat> split_observations_by_group(
+    const arma::imat& observations,
+    const arma::imat& group_indices,
+    const int num_groups
+);
+
+/**
+ * Per-group residual matrices for the element-wise Metropolis updates.
+ *
+ * Column v of matrix g holds the rest scores sum_u x_u * w_g(u, v) of the
+ * persons in group g under the current inclusion indicators. The updates
+ * read these columns and keep them current on acceptance.
+ *
+ * @param observations_group  Per-group observations (see split_observations_by_group())
+ * @return One (n_g x V) residual matrix per group
+ * @see gradient() for remaining parameter descriptions
+ */
+std::vector<arma::mat> compute_residual_matrices(
+    const arma::mat& pairwise_effects,
+    const arma::imat& pairwise_effect_indices,
+    const arma::imat& inclusion_indicator,
+    const arma::mat& projection,
+    const std::vector<arma::mat>& observations_group,
+    const int num_groups
 );
 
 /**
  * Log-pseudoposterior contribution of a single main-effect parameter.
  *
  * Used by element-wise Metropolis updates. Evaluates the pseudolikelihood
- * and prior for one (variable, category/par, column h) entry.
+ * and prior for one (variable, category/par, column h) entry, with the
+ * rest scores read from the residual matrices.
  *
+ * @param residual_matrices  Per-group residual matrices (see compute_residual_matrices())
  * @param variable   Variable index
  * @param category   Category index (ordinal variables only)
  * @param par        Parameter index: 0 = linear, 1 = quadratic (Blume-Capel only)
@@ -187,15 +231,12 @@ std::pair<double, arma::vec> logp_and_gradient(
  */
 double log_pseudoposterior_main_component(
     const arma::mat& main_effects,
-    const arma::mat& pairwise_effects,
     const arma::imat& main_effect_indices,
-    const arma::imat& pairwise_effect_indices,
     const arma::mat& projection,
-    const arma::imat& observations,
-    const arma::imat& group_indices,
     const arma::ivec& num_categories,
     const std::vector<arma::imat>& counts_per_category_group,
     const std::vector<arma::imat>& blume_capel_stats_group,
+    const std::vector<arma::mat>& residual_matrices,
     const int num_groups,
     const arma::imat& inclusion_indicator,
     const arma::uvec& is_ordinal_variable,
@@ -214,6 +255,7 @@ double log_pseudoposterior_main_component(
  * Uses pre-computed residual matrices adjusted by delta to avoid full
  * recomputation. Used by element-wise Metropolis updates.
  *
+ * @param observations_group Per-group observations (see split_observations_by_group())
  * @param residual_matrices  Pre-computed residual matrices per group
  * @param variable1          First variable index
  * @param variable2          Second variable index
@@ -227,8 +269,7 @@ double log_pseudoposterior_pair_component(
     const arma::imat& main_effect_indices,
     const arma::imat& pairwise_effect_indices,
     const arma::mat& projection,
-    const arma::imat& observations,
-    const arma::imat& group_indices,
+    const std::vector<arma::mat>& observations_group,
     const arma::ivec& num_categories,
     const std::vector<arma::mat>& pairwise_stats_group,
     const std::vector<arma::mat>& residual_matrices,
@@ -255,23 +296,22 @@ double log_pseudoposterior_pair_component(
  *
  * @param current_main_effects   Current main-effect matrix
  * @param proposed_main_effects  Proposed main-effect matrix
+ * @param observations_group     Per-group observations (see split_observations_by_group())
+ * @param residual_matrices      Per-group residual matrices (see compute_residual_matrices())
  * @param variable               Variable whose main effect is being toggled
  * @see gradient() for remaining parameter descriptions
  */
 double log_pseudolikelihood_ratio_main(
     const arma::mat& current_main_effects,
     const arma::mat& proposed_main_effects,
-    const arma::mat& current_pairwise_effects,
     const arma::imat& main_effect_indices,
-    const arma::imat& pairwise_effect_indices,
     const arma::mat&  projection,
-    const arma::imat& observations,
-    const arma::imat& group_indices,
+    const std::vector<arma::mat>& observations_group,
+    const std::vector<arma::mat>& residual_matrices,
     const arma::ivec& num_categories,
     const std::vector<arma::imat>& counts_per_category_group,
     const std::vector<arma::imat>& blume_capel_stats_group,
     const int num_groups,
-    const arma::imat& inclusion_indicator,
     const arma::uvec& is_ordinal_variable,
     const arma::ivec& baseline_category,
     const int variable
@@ -286,6 +326,9 @@ double log_pseudolikelihood_ratio_main(
  *
  * @param current_pairwise_effects   Current pairwise-effect matrix
  * @param proposed_pairwise_effects  Proposed pairwise-effect matrix
+ * @param observations_group         Per-group observations (see split_observations_by_group())
+ * @param residual_matrices          Per-group residual matrices, built from the
+ *                                   current pairwise effects and inclusion_indicator
  * @param var1                       First variable index
  * @param var2                       Second variable index
  * @see gradient() for remaining parameter descriptions
@@ -297,8 +340,8 @@ double log_pseudolikelihood_ratio_pairwise(
     const arma::imat& main_effect_indices,
     const arma::imat& pairwise_effect_indices,
     const arma::mat& projection,
-    const arma::imat& observations,
-    const arma::imat& group_indices,
+    const std::vector<arma::mat>& observations_group,
+    const std::vector<arma::mat>& residual_matrices,
     const arma::ivec& num_categories,
     const std::vector<arma::mat>& pairwise_stats_group,
     const int num_groups,
@@ -0,0 +1,504 @@
+#include <RcppArmadillo.h>
+#include "models/bgmCompare/bgmCompare_model.h"
+#include "models/bgmCompare/bgmCompare_helper.h"
+#include "models/bgmCompare/bgmCompare_logp_and_grad.h"
+#include "models/bgmCompare/bgmCompare_sampler.h"
+#include "mcmc/execution/chain_profile.h"
+#include "mcmc/execution/sampler_state.h"
+#include "mcmc/execution/warmup_schedule.h"
+#include "rng/rng_utils.h"
+#include "utils/common_helpers.h"
+
+
+// =============================================================================
+// Constructor
+// =============================================================================
+
+BGMCompareModel::BGMCompareModel(
+    const arma::imat& observations,
+    int num_groups,
+    const std::vector<arma::imat>& counts_per_category,
+    const std::vector<arma::imat>& blume_capel_stats,
+    const std::vector<arma::mat>& pairwise_stats,
+    const arma::ivec& num_categories,
+    const arma::uvec& is_ordinal_variable,
+    const arma::ivec& baseline_category,
+    const arma::imat& main_effect_indices,
+    const arma::imat& pairwise_effect_indices,
+    const arma::mat& projection,
+    const arma::ivec& group_membership,
+    const arma::imat& group_indices,
+    const arma::imat& interaction_index_matrix,
+    const arma::mat& pairwise_scaling_factors,
+    const arma::mat& inclusion_probability,
+    std::unique_ptr<BaseParameterPrior> interaction_prior,
+    std::unique_ptr<BaseParameterPrior> difference_prior,
+    std::unique_ptr<BaseParameterPrior> threshold_prior,
+    bool difference_selection,
+    bool main_difference_selection
+) :
+    observations_(observations),
+    num_groups_(num_groups),
+    counts_per_category_(counts_per_category),
+    blume_capel_stats_(blume_capel_stats),
+    pairwise_stats_(pairwise_stats),
+    num_categories_(num_categories),
+    is_ordinal_variable_(is_ordinal_variable),
+    baseline_category_(baseline_category),
+    main_effect_indices_(main_effect_indices),
+    pairwise_effect_indices_(pairwise_effect_indices),
+    projection_(projection),
+    group_membership_(group_membership),
+    group_indices_(group_indices),
+    interaction_index_(interaction_index_matrix),
+    pairwise_scaling_factors_(pairwise_scaling_factors),
+    inclusion_probability_(inclusion_probability),
+    interaction_prior_(std::move(interaction_prior)),
+    difference_prior_(std::move(difference_prior)),
+    threshold_prior_(std::move(threshold_prior)),
+    difference_selection_(difference_selection),
+    main_difference_selection_(main_difference_selection),
+    rng_(0)
+{
+    num_variables_ = static_cast<int>(observations_.n_cols);
+    num_main_ = count_num_main_effects(num_categories_, is_ordinal_variable_);
+    num_pairwise_ = static_cast<size_t>(num_variables_) * (num_variables_ - 1) / 2;
+
+    main_effects_.zeros(num_main_, num_groups_);
+    pairwise_effects_.zeros(num_pairwise_, num_groups_);
+    inclusion_indicator_.ones(num_variables_, num_variables_);
+    all_included_.ones(num_variables_, num_variables_);
+
+    proposal_sd_main_.ones(num_main_, num_groups_);
+    proposal_sd_pairwise_.ones(num_pairwise_, num_groups_);
+
+    shuffled_index_ = interaction_index_;
+
+    auto full_maps = build_index_maps(
+        main_effects_, pairwise_effects_, all_included_,
+        main_effect_indices_, pairwise_effect_indices_,
+        num_categories_, is_ordinal_variable_
+    );
+    full_main_index_ = std::move(full_maps.first);
+    full_pair_index_ = std::move(full_maps.second);
+
+    scratch_main_ = main_effects_;
+    scratch_pair_ = pairwise_effects_;
+}
+
+
+// =============================================================================
+// Copy constructor
+// =============================================================================
+
+BGMCompareModel::BGMCompareModel(const BGMCompareModel& other)
+    : BaseModel(other),
+      observations_(other.observations_),
+      num_groups_(other.num_groups_),
+      counts_per_category_(other.counts_per_category_),
+      blume_capel_stats_(other.blume_capel_stats_),
+      pairwise_stats_(other.pairwise_stats_),
+      num_categories_(other.num_categories_),
+      is_ordinal_variable_(other.is_ordinal_variable_),
+      baseline_category_(other.baseline_category_),
+      main_effect_indices_(other.main_effect_indices_),
+      pairwise_effect_indices_(other.pairwise_effect_indices_),
+      projection_(other.projection_),
+      group_membership_(other.group_membership_),
+      group_indices_(other.group_indices_),
+      interaction_index_(other.interaction_index_),
+      pairwise_scaling_factors_(other.pairwise_scaling_factors_),
+      inclusion_probability_(other.inclusion_probability_),
+      interaction_prior_(other.interaction_prior_->clone()),
+      difference_prior_(other.difference_prior_->clone()),
+      threshold_prior_(other.threshold_prior_->clone()),
+      difference_selection_(other.difference_selection_),
+      main_difference_selection_(other.main_difference_selection_),
+      edge_selection_active_(other.edge_selection_active_),
+      graph_initialized_(other.graph_initialized_),
+      num_variables_(other.num_variables_),
+      num_main_(other.num_main_),
+      num_pairwise_(other.num_pairwise_),
+      main_effects_(other.main_effects_),
+      pairwise_effects_(other.pairwise_effects_),
+      inclusion_indicator_(other.inclusion_indicator_),
+      all_included_(other.all_included_),
+      proposal_sd_main_(other.proposal_sd_main_),
+      proposal_sd_pairwise_(other.proposal_sd_pairwise_),
+      target_accept_(other.target_accept_),
+      last_mh_mean_accept_(other.last_mh_mean_accept_),
+      rng_(other.rng_),
+      has_missing_(other.has_missing_),
+      missing_index_(other.missing_index_),
+      shuffled_index_(other.shuffled_index_),
+      observations_group_(other.observations_group_),
+      observations_group_valid_(other.observations_group_valid_),
+      main_index_(other.main_index_),
+      pair_index_(other.pair_index_),
+      grad_obs_(other.grad_obs_),
+      gradient_cache_valid_(other.gradient_cache_valid_),
+      residual_matrices_(other.residual_matrices_),
+      residual_matrices_valid_(other.residual_matrices_valid_),
+      full_main_index_(other.full_main_index_),
+      full_pair_index_(other.full_pair_index_),
+      scratch_main_(other.scratch_main_),
+      scratch_pair_(other.scratch_pair_),
+      gradient_threads_(other.gradient_threads_)
+{
+}
+
+
+std::unique_ptr<BaseModel> BGMCompareModel::clone() const {
+    return std::make_unique<BGMCompareModel>(*this);
+}
+
+
+void BGMCompareModel::save_state(SamplerState& state) const {
+    state.add("main_effects", main_effects_);
+    state.add("pairwise_effects", pairwise_effects_);
+    state.add("edge_indicators", arma::conv_to<arma::mat>::from(inclusion_indicator_));
+    state.add("inclusion_probability", inclusion_probability_);
+    state.add("proposal_sd_main", proposal_sd_main_);
+    state.add("proposal_sd_pairwise", proposal_sd_pairwise_);
+    state.edge_selection_active = edge_selection_active_;
+}
+
+
+void BGMCompareModel::restore_state(const SamplerState& state) {
+    main_effects_ = state.block("main_effects", main_effects_.n_rows, main_effects_.n_cols);
+    pairwise_effects_ = state.block(
+        "pairwise_effects", pairwise_effects_.n_rows, pairwise_effects_.n_cols);
+    inclusion_indicator_ = arma::conv_to<arma::imat>::from(state.block(
+        "edge_indicators", inclusion_indicator_.n_rows, inclusion_indicator_.n_cols));
+    inclusion_probability_ = state.block(
+        "inclusion_probability", inclusion_probability_.n_rows, inclusion_probability_.n_cols);
+    proposal_sd_main_ = state.block(
+        "proposal_sd_main", proposal_sd_main_.n_rows, proposal_sd_main_.n_cols);
+    proposal_sd_pairwise_ = state.block(
+        "proposal_sd_pairwise", proposal_sd_pairwise_.n_rows, proposal_sd_pairwise_.n_cols);
+    edge_selection_active_ = state.edge_selection_active;
+    graph_initialized_ = edge_selection_active_;
+    residual_matrices_valid_ = false;
+    invalidate_gradient_cache();
+}
+
+
+// =============================================================================
+// Gradient cache
+// =============================================================================
+
+void BGMCompareModel::ensure_gradient_cache() {
+    if (!observations_group_valid_) {
+        observations_group_ = split_observations_by_group(
+            observations_, group_indices_, num_groups_);
+        observations_group_valid_ = true;
+    }
+    if (gradient_cache_valid_) return;
+
+    auto index_maps = build_index_maps(
+        main_effects_, pairwise_effects_, inclusion_indicator_,
+        main_effect_indices_, pairwise_effect_indices_,
+        num_categories_, is_ordinal_variable_
+    );
+    main_index_ = std::move(index_maps.first);
+    pair_index_ = std::move(index_maps.second);
+
+    grad_obs_ = gradient_observed_active(
+        main_effect_indices_, pairwise_effect_indices_, projection_,
+        observations_, group_indices_, num_categories_, inclusion_indicator_,
+        counts_per_category_, blume_capel_stats_, pairwise_stats_,
+        num_groups_, is_ordinal_variable_, baseline_category_,
+        main_index_, pair_index_
+    );
+
+    gradient_cache_valid_ = true;
+}
+
+
+void BGMCompareModel::ensure_residual_matrices() {
+    if (!observations_group_valid_) {
+        observations_group_ = split_observations_by_group(
+            observations_, group_indices_, num_groups_);
+        observations_group_valid_ = true;
+    }
+    if (residual_matrices_valid_) return;
+
+    residual_matrices_ = compute_residual_matrices(
+        pairwise_effects_, pairwise_effect_indices_, inclusion_indicator_,
+        projection_, observations_group_, num_groups_
+    );
+    residual_matrices_valid_ = true;
+}
+
+
+std::pair<double, arma::vec> BGMCompareModel::logp_and_gradient(const arma::vec& parameters) {
+    BGMS_PROFILE_SCOPE(Gradient);
+    ensure_gradient_cache();
+
+    unvectorize_model_parameters_bgmcompare(
+        parameters, scratch_main_, scratch_pair_, inclusion_indicator_,
+        main_effect_indices_, pairwise_effect_indices_, num_groups_,
+        num_categories_, is_ordinal_variable_
+    );
+
+    return ::logp_and_gradient(
+        scratch_main_, scratch_pair_, main_effect_indices_,
+        pairwise_effect_indices_, projection_, observations_group_,
+        num_categories_, counts_per_category_, blume_capel_stats_,
+        pairwise_stats_, num_groups_, inclusion_indicator_,
+        is_ordinal_variable_, baseline_category_, pairwise_scaling_factors_,
+        main_index_, pair_index_, grad_obs_,
+        *interaction_prior_, *difference_prior_, *threshold_prior_,
+        gradient_threads_
+    );
+}
+
+
+// =============================================================================
+// Parameter vectorization
+// =============================================================================
+
+size_t BGMCompareModel::parameter_dimension() const {
+    return total_length(
+        num_variables_, main_effect_indices_, pairwise_effect_indices_,
+        inclusion_indicator_, num_categories_, is_ordinal_variable_,
+        num_groups_
+    );
+}
+
+
+arma::vec BGMCompareModel::get_vectorized_parameters() const {
+    return vectorize_model_parameters_bgmcompare(
+        main_effects_, pairwise_effects_, inclusion_indicator_,
+        main_effect_indices_, pairwise_effect_indices_,
+        num_categories_, is_ordinal_variable_
+    );
+}
+
+
+void BGMCompareModel::set_vectorized_parameters(const arma::vec& parameters) {
+    unvectorize_model_parameters_bgmcompare(
+        parameters, main_effects_, pairwise_effects_, inclusion_indicator_,
+        main_effect_indices_, pairwise_effect_indices_, num_groups_,
+        num_categories_, is_ordinal_variable_
+    );
+    residual_matrices_valid_ = false;
+}
+
+
+arma::vec BGMCompareModel::get_full_vectorized_parameters() const {
+    return vectorize_model_parameters_bgmcompare(
+        main_effects_, pairwise_effects_, all_included_,
+        main_effect_indices_, pairwise_effect_indices_,
+        num_categories_, is_ordinal_variable_
+    );
+}
+
+
+arma::vec BGMCompareModel::get_storage_vectorized_parameters() const {
+    return arma::join_cols(arma::vectorise(main_effects_),
+                           arma::vectorise(pairwise_effects_));
+}
+
+
+arma::ivec BGMCompareModel::get_vectorized_indicator_parameters() {
+    arma::ivec indicators(num_pairwise_ + num_variables_);
+    int idx = 0;
+    for (int i = 0; i < num_variables_; ++i) {
+        for (int j = i; j < num_variables_; ++j) {
+            indicators(idx++) = inclusion_indicator_(i, j);
+        }
+    }
+    return indicators;
+}
+
+
+void BGMCompareModel::pack_indicator_parameters(IndicatorBitWriter& out) {
+    for (int i = 0; i < num_variables_; ++i) {
+        for (int j = i; j < num_variables_; ++j) {
+            out.push(inclusion_indicator_(i, j) != 0);
+        }
+    }
+}
+
+
+arma::uvec BGMCompareModel::get_active_parameter_indices() const {
+    if (!edge_selection_active_) {
+        return BaseModel::get_active_parameter_indices();
+    }
+
+    // Same walk as build_index_maps(): baseline columns, then the included
+    // main and pairwise differences, each mapped to its full-layout slot.
+    std::vector<arma::uword> indices;
+    indices.reserve(full_parameter_dimension());
+    for (size_t r = 0; r < num_main_; ++r) {
+        indices.push_back(full_main_index_(r, 0));
+    }
+    for (size_t r = 0; r < num_pairwise_; ++r) {
+        indices.push_back(full_pair_index_(r, 0));
+    }
+    for (int v = 0; v < num_variables_; ++v) {
+        if (inclusion_indicator_(v, v) == 0) continue;
+        for (int r = main_effect_indices_(v, 0); r <= main_effect_indices_(v, 1); ++r) {
+            for (int g = 1; g < num_groups_; ++g) {
+                indices.push_back(full_main_index_(r, g));
+            }
+        }
+    }
+    for (int v1 = 0; v1 < num_variables_ - 1; ++v1) {
+        for (int v2 = v1 + 1; v2 < num_variables_; ++v2) {
+            if (inclusion_indicator_(v1, v2) == 0) continue;
+            const int row = pairwise_effect_indices_(v1, v2);
+            for (int g = 1; g < num_groups_; ++g) {
+                indices.push_back(full_pair_index_(row, g));
+            }
+        }
+    }
+
+    return arma::uvec(indices);
+}
+
+
+arma::vec BGMCompareModel::get_active_inv_mass() const {
+    if (!edge_selection_active_) {
+        return inv_mass_;
+    }
+    return inv_mass_.elem(get_active_parameter_indices());
+}
+
+
+// =============================================================================
+// Metropolis updates
+// =============================================================================
+
+void BGMCompareModel::init_metropolis_adaptation(const WarmupSchedule& schedule) {
+    metropolis_main_adapter_ = std::make_unique<MetropolisAdaptationController>(
+        proposal_sd_main_, schedule, target_accept_);
+    metropolis_pairwise_adapter_ = std::make_unique<MetropolisAdaptationController>(
+        proposal_sd_pairwise_, schedule, target_accept_);
+}
+
+
+void BGMCompareModel::do_one_metropolis_step(int iteration) {
+    if (!metropolis_main_adapter_ || !metropolis_pairwise_adapter_) {
+        throw std::runtime_error(
+            "init_metropolis_adaptation() must be called before do_one_metropolis_step()");
+    }
+
+    double sum_accept = 0.0;
+    int    n_accept   = 0;
+    ensure_residual_matrices();
+
+    update_main_effects_metropolis_bgmcompare(
+        main_effects_, main_effect_indices_, inclusion_indicator_,
+        projection_, num_categories_, num_groups_, residual_matrices_,
+        counts_per_category_, blume_capel_stats_, is_ordinal_variable_,
+        baseline_category_, iteration, *metropolis_main_adapter_, rng_,
+        proposal_sd_main_, *difference_prior_, *threshold_prior_,
+        sum_accept, n_accept
+    );
+
+    update_pairwise_effects_metropolis_bgmcompare(
+        main_effects_, pairwise_effects_, main_effect_indices_,
+        pairwise_effect_indices_, inclusion_indicator_, projection_,
+        num_categories_, observations_group_, num_groups_, residual_matrices_,
+        pairwise_stats_, is_ordinal_variable_, baseline_category_,
+        pairwise_scaling_factors_, iteration, *metropolis_pairwise_adapter_,
+        rng_, proposal_sd_pairwise_, *interaction_prior_, *difference_prior_,
+        sum_accept, n_accept
+    );
+
+    last_mh_mean_accept_ = (n_accept > 0)
+        ? sum_accept / static_cast<double>(n_accept)
+        : std::numeric_limits<double>::quiet_NaN();
+}
+
+
+void BGMCompareModel::tune_proposal_sd(int iteration, const WarmupSchedule& schedule) {
+    if (!schedule.adapt_proposal_sd(iteration)) return;
+    ensure_residual_matrices();
+
+    tune_proposal_sd_bgmcompare(
+        proposal_sd_main_, proposal_sd_pairwise_, main_effects_,
+        pairwise_effects_, main_effect_indices_, pairwise_effect_indices_,
+        inclusion_indicator_, projection_, num_categories_, observations_group_,
+        num_groups_, residual_matrices_, counts_per_category_, blume_capel_stats_,
+        pairwise_stats_, is_ordinal_variable_, baseline_category_,
+        pairwise_scaling_factors_, iteration, rng_, schedule,
+        *interaction_prior_, *difference_prior_, *threshold_prior_,
+        target_accept_
+    );
+}
+
+
+// =============================================================================
+// Difference selection
+// =============================================================================
+
+void BGMCompareModel::prepare_iteration() {
+    const arma::uvec order = arma_randperm(rng_, num_pairwise_);
+    for (size_t i = 0; i < num_pairwise_; ++i) {
+        shuffled_index_.row(i) = interaction_index_.row(order(i));
+    }
+}
+
+
+void BGMCompareModel::set_edge_selection_active(bool active) {
+    edge_selection_active_ = active;
+    if (active && !graph_initialized_) {
+        initialise_graph_bgmcompare(
+            inclusion_indicator_, main_effects_, pairwise_effects_,
+            main_effect_indices_, pairwise_effect_indices_,
+            inclusion_probability_, main_difference_selection_, rng_
+        );
+        graph_initialized_ = true;
+        residual_matrices_valid_ = false;
+        invalidate_gradient_cache();
+    }
+}
+
+
+void BGMCompareModel::update_edge_indicators() {
+    ensure_residual_matrices();
+
+    update_indicator_differences_metropolis_bgmcompare(
+        inclusion_probability_, shuffled_index_, main_effects_,
+        pairwise_effects_, main_effect_indices_, pairwise_effect_indices_,
+        projection_, observations_group_, num_groups_, residual_matrices_,
+        num_categories_, inclusion_indicator_, is_ordinal_variable_,
+        baseline_category_, proposal_sd_main_, pairwise_scaling_factors_,
+        proposal_sd_pairwise_, counts_per_category_, blume_capel_stats_,
+        pairwise_stats_, main_difference_selection_, rng_, *difference_prior_
+    );
+    invalidate_gradient_cache();
+}
+
+
+// =============================================================================
+// Missing data
+// =============================================================================
+
+void BGMCompareModel::set_missing_data(const arma::imat& missing_index) {
+    missing_index_ = missing_index;
+    has_missing_ = (missing_index.n_rows > 0 && missing_index.n_cols == 2);
+}
+
+
+void BGMCompareModel::impute_missing() {
+    if (!has_missing_) return;
+    ensure_residual_matrices();
+
+    impute_missing_bgmcompare(
+        main_effects_, pairwise_effects_, main_effect_indices_,
+        pairwise_effect_indices_, inclusion_indicator_, projection_,
+        observations_, observations_group_, residual_matrices_,
+        num_groups_, group_membership_, group_indices_,
+        counts_per_category_, blume_capel_stats_, pairwise_stats_,
+        num_categories_, missing_index_, is_ordinal_variable_,
+        baseline_category_, rng_
+    );
+
+    // Observations and sufficient statistics changed; the per-group
+    // observations and residual matrices were updated with them
+    invalidate_gradient_cache();
+}
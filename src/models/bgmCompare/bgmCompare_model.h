@@ -0,0 +1,345 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <limits>
+#include <vector>
+#include "models/base_model.h"
+#include "mcmc/samplers/metropolis_adaptation.h"
+#include "rng/rng_utils.h"
+#include "priors/parameter_prior.h"
+
+/**
+ * BGMCompareModel - Multi-group ordinal MRF with group-difference selection
+ *
+ * Parameters are a baseline column plus G-1 group-difference columns for
+ * every main effect and pairwise interaction; group-specific effects follow
+ * from the contrast `projection`. The difference indicators (pairwise off
+ * the diagonal, main effects on it) play the role of edge indicators, so
+ * the generic runner's edge-selection stages drive difference selection.
+ *
+ * Inherits from BaseModel so bgmCompare runs through run_mcmc_sampler()
+ * with the same samplers, warmup schedule, diagnostics and output as bgm().
+ *
+ * Vector layouts:
+ *   - get_vectorized_parameters(): baseline mains, baseline pairs, active
+ *     main differences, active pair differences
+ *     (vectorize_model_parameters_bgmcompare()).
+ *   - get_full_vectorized_parameters(): the same layout with every
+ *     difference included.
+ *   - get_storage_vectorized_parameters(): vectorise(main) followed by
+ *     vectorise(pair), i.e. group column by group column.
+ *   - get_vectorized_indicator_parameters(): upper triangle of the
+ *     indicator matrix including the diagonal, row by row.
+ */
+class BGMCompareModel : public BaseModel {
+public:
+
+    /**
+     * Constructor
+     *
+     * @param observations             Integer observations (n x V), rows sorted by group
+     * @param num_groups               Number of groups (G)
+     * @param counts_per_category      Category counts per group
+     * @param blume_capel_stats        Blume-Capel statistics per group
+     * @param pairwise_stats           Pairwise sufficient statistics per group
+     * @param num_categories           Number of categories per variable
+     * @param is_ordinal_variable      1 = ordinal, 0 = Blume-Capel
+     * @param baseline_category        Reference categories for Blume-Capel variables
+     * @param main_effect_indices      Start/end row indices per variable (V x 2)
+     * @param pairwise_effect_indices  Row index per variable pair (V x V)
+     * @param projection               Group contrast matrix (G x (G-1))
+     * @param group_membership         Group label per observation
+     * @param group_indices            Group start/end rows (G x 2)
+     * @param interaction_index_matrix Pair table (num_pair x 3)
+     * @param pairwise_scaling_factors Per-pair scaling factors for the priors
+     * @param inclusion_probability    Prior difference-inclusion probabilities (V x V)
+     * @param interaction_prior        Prior on the baseline interactions
+     * @param difference_prior         Prior on the group differences
+     * @param threshold_prior          Prior on the baseline main effects
+     * @param difference_selection     Enable difference selection
+     * @param main_difference_selection  Also select main-effect differences
+     */
+    BGMCompareModel(
+        const arma::imat& observations,
+        int num_groups,
+        const std::vector<arma::imat>& counts_per_category,
+        const std::vector<arma::imat>& blume_capel_stats,
+        const std::vector<arma::mat>& pairwise_stats,
+        const arma::ivec& num_categories,
+        const arma::uvec& is_ordinal_variable,
+        const arma::ivec& baseline_category,
+        const arma::imat& main_effect_indices,
+        const arma::imat& pairwise_effect_indices,
+        const arma::mat& projection,
+        const arma::ivec& group_membership,
+        const arma::imat& group_indices,
+        const arma::imat& interaction_index_matrix,
+        const arma::mat& pairwise_scaling_factors,
+        const arma::mat& inclusion_probability,
+        std::unique_ptr<BaseParameterPrior> interaction_prior,
+        std::unique_ptr<BaseParameterPrior> difference_prior,
+        std::unique_ptr<BaseParameterPrior> threshold_prior,
+        bool difference_selection,
+        bool main_difference_selection
+    );
+
+    /**
+     * Copy constructor for cloning (required for parallel chains)
+     */
+    BGMCompareModel(const BGMCompareModel& other);
+
+    // =========================================================================
+    // BaseModel interface implementation
+    // =========================================================================
+
+    /** @return true when difference selection is enabled. */
+    bool has_edge_selection() const override { return difference_selection_; }
+    /** @return true when missing-data imputation is active. */
+    bool has_missing_data() const override { return has_missing_; }
+
+    /**
+     * Log-pseudoposterior and gradient over the active parameters
+     */
+    std::pair<double, arma::vec> logp_and_gradient(const arma::vec& parameters) override;
+
+    /**
+     * One random-walk Metropolis sweep over main, then pairwise effects
+     * @param iteration  Current iteration (for Robbins-Monro adaptation)
+     */
+    void do_one_metropolis_step(int iteration = -1) override;
+
+    /**
+     * @return Mean Metropolis acceptance probability over the most recent
+     *         do_one_metropolis_step() sweep. NaN before the first step.
+     */
+    double last_metropolis_mean_accept_prob() const override {
+        return last_mh_mean_accept_;
+    }
+
+    /**
+     * Set the Robbins-Monro target acceptance rate for the adaptive
+     * Metropolis controllers and the Stage 3b proposal-SD tuning.
+     */
+    void set_metropolis_target_accept(double target) override {
+        target_accept_ = target;
+    }
+
+    /**
+     * Set the number of threads used by logp_and_gradient(). Groups and
+     * blocks of variables are evaluated in parallel and reduced in a fixed
+     * order, so results do not depend on the thread count.
+     */
+    void set_gradient_threads(int num_threads) override {
+        gradient_threads_ = std::max(1, num_threads);
+    }
+
+    /**
+     * Create the main- and pairwise-effect adaptation controllers
+     */
+    void init_metropolis_adaptation(const WarmupSchedule& schedule) override;
+
+    /**
+     * Stage 3b: Robbins-Monro tuning of main and pairwise proposal SDs
+     */
+    void tune_proposal_sd(int iteration, const WarmupSchedule& schedule) override;
+
+    /**
+     * Shuffle the pairwise difference update order. Called every iteration
+     * so the RNG stream does not depend on the stage.
+     */
+    void prepare_iteration() override;
+
+    /**
+     * Metropolis-Hastings add/delete moves on the difference indicators
+     */
+    void update_edge_indicators() override;
+
+    /**
+     * Enable difference selection. The first activation draws a random
+     * starting configuration from the prior inclusion probabilities.
+     */
+    void set_edge_selection_active(bool active) override;
+
+    /**
+     * Impute missing observations and refresh the sufficient statistics
+     */
+    void impute_missing() override;
+
+    /**
+     * Set missing data information
+     * @param missing_index  (person, variable) pairs of missing entries
+     */
+    void set_missing_data(const arma::imat& missing_index);
+
+    /** @return Dimensionality of the active parameter space. */
+    size_t parameter_dimension() const override;
+
+    /** @return Baseline plus every group difference, (num_main + num_pair) * G. */
+    size_t full_parameter_dimension() const override {
+        return (num_main_ + num_pairwise_) * num_groups_;
+    }
+
+    /** Replace the random number generator */
+    void set_rng(const SafeRNG& rng) override { rng_ = rng; }
+
+    /** Get active parameters as a flat vector */
+    arma::vec get_vectorized_parameters() const override;
+
+    /** Set active parameters from a flat vector */
+    void set_vectorized_parameters(const arma::vec& parameters) override;
+
+    /** Get all parameters with every difference included (inactive ones are 0) */
+    arma::vec get_full_vectorized_parameters() const override;
+
+    /** Get all parameters group column by group column, for sample storage */
+    arma::vec get_storage_vectorized_parameters() const override;
+
+    /** Get difference indicators (upper triangle with diagonal) */
+    arma::ivec get_vectorized_indicator_parameters() override;
+
+    /** Pack difference indicators (same order) without building the vector */
+    void pack_indicator_parameters(IndicatorBitWriter& out) override;
+
+    /** Active subset of the inverse mass diagonal */
+    arma::vec get_active_inv_mass() const override;
+
+    /** Full-vector positions of the active parameters */
+    arma::uvec get_active_parameter_indices() const override;
+
+    /** Clone the model for parallel execution. */
+    std::unique_ptr<BaseModel> clone() const override;
+
+    /** @return Reference to the model's random number generator. */
+    SafeRNG& get_rng() override { return rng_; }
+
+    /**
+     * Save main and pairwise effects, difference indicators, inclusion
+     * probabilities and proposal SDs.
+     */
+    void save_state(SamplerState& state) const override;
+
+    /**
+     * Restore a save_state() state. Indicators saved while selection was
+     * active count as the starting configuration, so they are not redrawn.
+     */
+    void restore_state(const SamplerState& state) override;
+
+    // =========================================================================
+    // Accessors
+    // =========================================================================
+
+    /** @return Current difference-indicator matrix (V x V, symmetric, 0/1). */
+    const arma::imat& get_edge_indicators() const override { return inclusion_indicator_; }
+    /** @return Mutable reference to the prior inclusion-probability matrix. */
+    arma::mat& get_inclusion_probability() override { return inclusion_probability_; }
+    /** @return Number of variables (V). */
+    int get_num_variables() const override { return num_variables_; }
+    /** @return Number of variable pairs V(V-1)/2. */
+    int get_num_pairwise() const override { return static_cast<int>(num_pairwise_); }
+
+    /** @return Current main effects (num_main x G). */
+    const arma::mat& get_main_effects() const { return main_effects_; }
+    /** @return Current pairwise effects (num_pair x G). */
+    const arma::mat& get_pairwise_effects() const { return pairwise_effects_; }
+    /** @return Per-group residual matrices (n_g x V), rebuilt first if stale. */
+    const std::vector<arma::mat>& get_residual_matrices() {
+        ensure_residual_matrices();
+        return residual_matrices_;
+    }
+    /** Rebuild the residual matrices from the parameters at their next use. */
+    void invalidate_residual_matrices() { residual_matrices_valid_ = false; }
+
+private:
+    // Data
+    arma::imat observations_;           ///< Observations (n x V), rows sorted by group
+    int num_groups_;                    ///< Number of groups (G)
+    std::vector<arma::imat> counts_per_category_; ///< Category counts per group
+    std::vector<arma::imat> blume_capel_stats_;   ///< Blume-Capel statistics per group
+    std::vector<arma::mat> pairwise_stats_;       ///< Pairwise statistics per group
+    arma::ivec num_categories_;         ///< Categories per variable
+    arma::uvec is_ordinal_variable_;    ///< 1 = ordinal, 0 = Blume-Capel
+    arma::ivec baseline_category_;      ///< Reference category for Blume-Capel
+    arma::imat main_effect_indices_;    ///< Start/end rows per variable (V x 2)
+    arma::imat pairwise_effect_indices_; ///< Row per variable pair (V x V)
+    arma::mat projection_;              ///< Group contrasts (G x (G-1))
+    arma::ivec group_membership_;       ///< Group label per observation
+    arma::imat group_indices_;          ///< Group start/end rows (G x 2)
+    arma::imat interaction_index_;      ///< Pair table (num_pair x 3)
+    arma::mat pairwise_scaling_factors_; ///< Per-pair prior scaling factors
+
+    // Priors
+    arma::mat inclusion_probability_;   ///< Prior difference-inclusion probabilities
+    std::unique_ptr<BaseParameterPrior> interaction_prior_; ///< Baseline interactions
+    std::unique_ptr<BaseParameterPrior> difference_prior_;  ///< Group differences
+    std::unique_ptr<BaseParameterPrior> threshold_prior_;   ///< Baseline main effects
+
+    // Model configuration
+    bool difference_selection_;         ///< Enable difference selection
+    bool main_difference_selection_;    ///< Also select main-effect differences
+    bool edge_selection_active_ = false; ///< Currently in the selection phase
+    bool graph_initialized_ = false;    ///< Starting configuration has been drawn
+
+    // Dimensions
+    int num_variables_;                 ///< Number of variables (V)
+    size_t num_main_;                   ///< Rows of the main-effect matrix
+    size_t num_pairwise_;               ///< Rows of the pairwise-effect matrix
+
+    // Parameters
+    arma::mat main_effects_;            ///< Main effects (num_main x G)
+    arma::mat pairwise_effects_;        ///< Pairwise effects (num_pair x G)
+    arma::imat inclusion_indicator_;    ///< Difference indicators (V x V)
+    arma::imat all_included_;           ///< All-ones indicators, for the full layout
+
+    // Proposal SDs (adapted during warmup)
+    arma::mat proposal_sd_main_;        ///< Proposal SD for main effects
+    arma::mat proposal_sd_pairwise_;    ///< Proposal SD for pairwise effects
+
+    // Metropolis adaptation controllers (created by init_metropolis_adaptation)
+    std::unique_ptr<MetropolisAdaptationController> metropolis_main_adapter_;      ///< Main-effect adapter
+    std::unique_ptr<MetropolisAdaptationController> metropolis_pairwise_adapter_;  ///< Pairwise-effect adapter
+    double target_accept_ = 0.44;       ///< Robbins-Monro target acceptance rate
+    double last_mh_mean_accept_ = std::numeric_limits<double>::quiet_NaN(); ///< Mean acceptance of the last sweep
+
+    // RNG
+    SafeRNG rng_;                       ///< Per-chain random number generator
+
+    // Missing data handling
+    bool has_missing_ = false;          ///< Whether the data contains missing values
+    arma::imat missing_index_;          ///< (row, col) indices of missing entries
+
+    // Difference update order (set in prepare_iteration)
+    arma::imat shuffled_index_;         ///< Shuffled rows of interaction_index_
+
+    // Cached gradient components; rebuilt when indicators or data change
+    std::vector<arma::mat> observations_group_; ///< Per-group observations as double
+    bool observations_group_valid_ = false;     ///< Whether observations_group_ is current
+    arma::imat main_index_;             ///< Active vector position per main entry (-1 = inactive)
+    arma::imat pair_index_;             ///< Active vector position per pair entry (-1 = inactive)
+    arma::vec grad_obs_;                ///< Observed-statistics part of the gradient
+    bool gradient_cache_valid_ = false; ///< Whether the index maps and grad_obs_ are current
+
+    // Per-group rest scores of the Metropolis updates; kept current on
+    // accepted moves, rebuilt when parameters are set from outside
+    std::vector<arma::mat> residual_matrices_; ///< Residual matrix per group (n_g x V)
+    bool residual_matrices_valid_ = false;     ///< Whether residual_matrices_ is current
+
+    // Full-layout positions of every entry (all differences included)
+    arma::imat full_main_index_;        ///< Full vector position per main entry
+    arma::imat full_pair_index_;        ///< Full vector position per pair entry
+
+    // Scratch matrices reused by logp_and_gradient()
+    arma::mat scratch_main_;
+    arma::mat scratch_pair_;
+
+    int gradient_threads_ = 1;          ///< Threads used by logp_and_gradient
+
+    /** Invalidate gradient cache (call after indicator or data changes) */
+    void invalidate_gradient_cache() { gradient_cache_valid_ = false; }
+
+    /** Rebuild the per-group observations and index maps if stale */
+    void ensure_gradient_cache();
+
+    /** Rebuild the per-group observations and residual matrices if stale */
+    void ensure_residual_matrices();
+};
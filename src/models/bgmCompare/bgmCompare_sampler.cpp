@@ -2,17 +2,12 @@
 #include "models/bgmCompare/bgmCompare_helper.h"
 #include "models/bgmCompare/bgmCompare_logp_and_grad.h"
 #include "models/bgmCompare/bgmCompare_sampler.h"
-#include "models/bgmCompare/bgmCompare_output.h"
+#include "mcmc/execution/warmup_schedule.h"
 #include "mcmc/samplers/metropolis_adaptation.h"
-#include "mcmc/samplers/nuts_adaptation.h"
-#include "mcmc/algorithms/hmc.h"
-#include "mcmc/algorithms/leapfrog.h"
-#include "mcmc/algorithms/nuts.h"
 #include "mcmc/algorithms/metropolis.h"
 #include "rng/rng_utils.h"
+#include "math/categorical.h"
 #include "math/explog_macros.h"
-#include <string>
-#include "utils/progress_manager.h"
 #include "utils/common_helpers.h"
 #include "priors/parameter_prior.h"
 
@@ -27,16 +22,22 @@
 //   - group-specific sufficient statistics.
 //
 // Workflow:
-//  1. For each missing entry, identify its (person, variable, group).
-//  2. Compute group-specific main and pairwise effects via projections.
-//  3. Calculate unnormalized probabilities for all categories of the variable:
+//  1. Build the group-specific pairwise matrix of every group with missing
+//     entries once per sweep.
+//  2. Walk the missing entries in order, in runs that share (group, variable).
+//     The entries of a run are different persons, and a person's own value
+//     does not enter its rest score, so the run's rest scores are read from
+//     the group's residual matrix and its category probabilities computed
+//     for all entries at once, from the group main effects of the run:
 //     - Ordinal: softmax using category-specific thresholds.
 //     - Blume–Capel: quadratic + linear score with baseline centering.
-//  4. Sample a new category with inverse transform sampling.
-//  5. If the imputed value differs from the old one, update:
-//       - `observations` (raw data matrix),
+//  3. Sample each entry with inverse transform sampling, one uniform per
+//     entry in the order of `missing_data_indices`.
+//  4. If the imputed value differs from the old one, update in place:
+//       - `observations` and `observations_group` (raw data),
 //       - `counts_per_category` or `blume_capel_stats` (main-effect sufficient stats),
-//       - `pairwise_stats` (pairwise sufficient stats).
+//       - `pairwise_stats` (one row and column of the group's cross-product),
+//       - the person's row of the group's residual matrix.
 //
 // Inputs:
 //  - main_effects, pairwise_effects: Current parameter matrices.
@@ -44,6 +45,8 @@
 //  - inclusion_indicator: Indicates which differences/pairs are included.
 //  - projection: Group projection matrix.
 //  - observations: Data matrix [persons × variables]; updated in place.
+//  - observations_group, residual_matrices: Current per-group observations and
+//    residual matrices; updated in place.
 //  - num_groups: Number of groups.
 //  - group_membership: Group assignment for each person.
 //  - group_indices: Row ranges [start,end] for each group.
@@ -57,10 +60,9 @@
 //  - rng: Random number generator.
 //
 // Notes:
-//  - The function updates both raw data and sufficient statistics in-place.
-//  - Group-specific pairwise effects are recomputed per missing entry.
-//  - For efficiency, you may consider incremental updates to `pairwise_stats`
-//    instead of full recomputation (`obs.t() * obs`) after each change.
+//  - Entries are processed in their given order, so the draws do not depend on
+//    how they fall into runs; sorted by variable (as R's which() returns them)
+//    the runs are as long as possible.
 void impute_missing_bgmcompare(
     const arma::mat& main_effects,
     const arma::mat& pairwise_effects,
@@ -69,6 +71,8 @@ void impute_missing_bgmcompare(
     const arma::imat& inclusion_indicator,
     const arma::mat& projection,
     arma::imat& observations,
+    std::vector<arma::mat>& observations_group,
+    std::vector<arma::mat>& residual_matrices,
     const int num_groups,
     const arma::ivec& group_membership,
     const arma::imat& group_indices,
@@ -83,106 +87,119 @@ void impute_missing_bgmcompare(
 ) {
   const int num_variables = observations.n_cols;
   const int num_missings = missing_data_indices.n_rows;
-  const int max_num_categories = arma::max(num_categories);
 
-  arma::vec category_response_probabilities(max_num_categories + 1);
-  double exponent, cumsum, u;
-  int score, person, variable, new_value, old_value, group;
-
-  //Impute missing data
+  // Group-specific pairwise effects, once per sweep for the groups that need them
+  std::vector<arma::mat> group_pairwise_effects(num_groups);
   for(int missing = 0; missing < num_missings; missing++) {
-    // Identify the observation to impute
-    person = missing_data_indices(missing, 0);
-    variable = missing_data_indices(missing, 1);
-    group = group_membership[person];
-
+    const int group = group_membership[missing_data_indices(missing, 0)];
+    if(!group_pairwise_effects[group].is_empty()) continue;
     const arma::vec proj_g = projection.row(group).t();
-    // Compute thresholds for the variable in the given group
-    arma::vec group_main_effects = compute_group_main_effects(
-      variable, num_groups, main_effects,  main_effect_indices, proj_g);
-
-    // Generate a new observation based on the model
-    arma::mat group_pairwise_effects(num_variables, num_variables, arma::fill::zeros);
+    arma::mat& weights = group_pairwise_effects[group];
+    weights.zeros(num_variables, num_variables);
     for(int v1 = 0; v1 < num_variables-1; v1++) {
       for(int v2 = v1 + 1; v2 < num_variables; v2++) {
         double w = compute_group_pairwise_effects(
             v1, v2, num_groups, pairwise_effects, pairwise_effect_indices,
             inclusion_indicator, proj_g
         );
-        group_pairwise_effects(v1, v2) = w;
-        group_pairwise_effects(v2, v1) = w;
+        weights(v1, v2) = w;
+        weights(v2, v1) = w;
       }
     }
+  }
 
-    double rest_score =
-      arma::as_scalar(observations.row(person) * group_pairwise_effects.col(variable));
-
-    if(is_ordinal_variable[variable] == true) {
-      // For regular binary or ordinal variables
-      cumsum = 1.0;
-      category_response_probabilities[0] = 1.0;
-      for(int category = 1; category <= num_categories(variable); category++) {
-        exponent = group_main_effects(category - 1);
-        exponent += category * rest_score;
-        cumsum += MY_EXP(exponent);
-        category_response_probabilities[category] = cumsum;
-      }
-    } else {
-      // For Blume-Capel variables
-      cumsum = 0.0;
-      const int ref = baseline_category[variable];
-      for(int category = 0; category <= num_categories(variable); category++) {
-        score = category - ref;
-        exponent = group_main_effects[0] * score;
-        exponent += group_main_effects[1] * score * score;
-        exponent += rest_score * score;
-        cumsum += MY_EXP(exponent);
-        category_response_probabilities[category] = cumsum;
-      }
+  arma::mat category_weights;
+  arma::vec uniforms;
+  arma::uvec sampled_categories;
+  int run_start = 0;
+  while(run_start < num_missings) {
+    // The run of entries that share this entry's group and variable
+    const int variable = missing_data_indices(run_start, 1);
+    const int group = group_membership[missing_data_indices(run_start, 0)];
+    int run_end = run_start + 1;
+    while(run_end < num_missings &&
+          missing_data_indices(run_end, 1) == variable &&
+          group_membership[missing_data_indices(run_end, 0)] == group) {
+      run_end++;
     }
+    const int run_size = run_end - run_start;
+    const int first_row = group_indices(group, 0);
+    const int num_cats = num_categories(variable);
 
-    // Sample a new value based on computed probabilities
-    u = cumsum * runif(rng);
-    score = 0;
-    while (u > category_response_probabilities[score]) {
-      score++;
+    const arma::vec proj_g = projection.row(group).t();
+    const arma::vec group_main_effects = compute_group_main_effects(
+      variable, num_groups, main_effects, main_effect_indices, proj_g);
+
+    // Category exponents, one column per entry; row c is category c
+    category_weights.set_size(num_cats + 1, run_size);
+    const int ref = baseline_category[variable];
+    for(int k = 0; k < run_size; k++) {
+      const int local = missing_data_indices(run_start + k, 0) - first_row;
+      const double rest_score = residual_matrices[group](local, variable);
+      double* exponent = category_weights.colptr(k);
+      if(is_ordinal_variable[variable] == true) {
+        exponent[0] = 0.0;
+        for(int category = 1; category <= num_cats; category++) {
+          exponent[category] = group_main_effects(category - 1) + category * rest_score;
+        }
+      } else {
+        for(int category = 0; category <= num_cats; category++) {
+          const int score = category - ref;
+          exponent[category] = group_main_effects[0] * score +
+            group_main_effects[1] * score * score + rest_score * score;
+        }
+      }
     }
-
-    new_value = score;
-    if(!is_ordinal_variable[variable])
-      new_value -= baseline_category[variable];
-    old_value = observations(person, variable);
-
-    if(old_value != new_value) {
-      // Update raw observations
-      observations(person, variable) = new_value;
+    uniforms.set_size(run_size);
+    runif_fill(rng, uniforms.memptr(), run_size);
+    sample_categorical_exp_columns(category_weights, uniforms, sampled_categories);
+
+    arma::imat& counts_group = counts_per_category[group];
+    arma::imat& blume_capel_group = blume_capel_stats[group];
+    arma::mat& pairwise_stats_group = pairwise_stats[group];
+    arma::mat& observations_g = observations_group[group];
+    arma::mat& residual_g = residual_matrices[group];
+    const arma::mat& weights = group_pairwise_effects[group];
+
+    for(int k = 0; k < run_size; k++) {
+      const int person = missing_data_indices(run_start + k, 0);
+      const int local = person - first_row;
+
+      int new_value = static_cast<int>(sampled_categories[k]);
+      if(!is_ordinal_variable[variable])
+        new_value -= baseline_category[variable];
+      const int old_value = observations(person, variable);
+      if(old_value == new_value) continue;
 
       // Update sufficient statistics for main effects
       if(is_ordinal_variable[variable] == true) {
-        arma::imat counts_per_category_group = counts_per_category[group];
         if(old_value > 0)
-          counts_per_category_group(old_value-1, variable)--;
+          counts_group(old_value-1, variable)--;
         if(new_value > 0)
-          counts_per_category_group(new_value-1, variable)++;
-        counts_per_category[group] = counts_per_category_group;
+          counts_group(new_value-1, variable)++;
       } else {
-        arma::imat blume_capel_stats_group = blume_capel_stats[group];
-        blume_capel_stats_group(0, variable) -= old_value;
-        blume_capel_stats_group(0, variable) += new_value;
-        blume_capel_stats_group(1, variable) -= old_value * old_value;
-        blume_capel_stats_group(1, variable) += new_value * new_value;
-        blume_capel_stats[group] = blume_capel_stats_group;
+        blume_capel_group(0, variable) += new_value - old_value;
+        blume_capel_group(1, variable) += new_value * new_value - old_value * old_value;
+      }
+
+      // Row and column `variable` of the group's cross-product X'X
+      const double delta = new_value - old_value;
+      for(int w = 0; w < num_variables; w++) {
+        if(w == variable) continue;
+        const double change = delta * observations_g(local, w);
+        pairwise_stats_group(variable, w) += change;
+        pairwise_stats_group(w, variable) += change;
       }
+      pairwise_stats_group(variable, variable) +=
+        static_cast<double>(new_value * new_value - old_value * old_value);
 
-      // Update sufficient statistics for pairwise effects
-      const int r0 = group_indices(group, 0);
-      const int r1 = group_indices(group, 1);
-      arma::mat obs = arma::conv_to<arma::mat>::from(observations.rows(r0, r1));
-      arma::mat pairwise_stats_group = obs.t() * obs; // crossprod
-      pairwise_stats[group] = pairwise_stats_group;
+      // Raw observations and the person's residual scores
+      observations(person, variable) = new_value;
+      observations_g(local, variable) = new_value;
+      residual_g.row(local) += delta * weights.row(variable);
     }
+    run_start = run_end;
   }
-  return;
 }
 
 
@@ -211,15 +228,13 @@ void impute_missing_bgmcompare(
 // Inputs:
 //  - main_effects: Matrix of main effect parameters [rows = effects, cols = groups];
 //                  updated in place.
-//  - pairwise_effects: Current pairwise effects (passed through to log posterior).
 //  - main_effect_indices: Row index ranges for each variable’s main effects.
-//  - pairwise_effect_indices: Index map for pairwise effects.
 //  - inclusion_indicator: Indicator matrix; diagonal entries control group differences.
 //  - projection: Group projection matrix.
 //  - num_categories: Number of categories for each variable.
-//  - observations: Data matrix [persons × variables].
 //  - num_groups: Number of groups (G).
-//  - group_indices: Row ranges per group in `observations`.
+//  - residual_matrices: Per-group residual matrices [persons × variables]
+//    (see compute_residual_matrices()).
 //  - counts_per_category, blume_capel_stats: Group-specific sufficient statistics.
 //  - is_ordinal_variable: Indicator for ordinal vs. Blume–Capel.
 //  - baseline_category: Reference categories (Blume–Capel only).
@@ -230,24 +245,23 @@ void impute_missing_bgmcompare(
 //  - rng: Random number generator.
 //  - proposal_sd_main: Proposal standard deviations [same shape as `main_effects`];
 //                      updated in place.
+//  - accept_prob_sum, num_updated: Running sum of acceptance probabilities and
+//                      count of updated parameters; incremented in place.
 //
 // Notes:
 //  - Acceptance probabilities are stored per parameter and fed to `metropolis_adapt.update()`.
-//  - This function does not alter pairwise effects, but passes them into
-//    the posterior for likelihood consistency.
+//  - Main effects do not enter the rest scores, so the residual matrices
+//    stay valid across this sweep.
 //  - The helper lambda `do_update` encapsulates the proposal/accept/revert loop
 //    for a single parameter, improving readability.
 void update_main_effects_metropolis_bgmcompare (
     arma::mat& main_effects,
-    arma::mat& pairwise_effects,
     const arma::imat& main_effect_indices,
-    const arma::imat& pairwise_effect_indices,
     const arma::imat& inclusion_indicator,
     const arma::mat& projection,
     const arma::ivec& num_categories,
-    const arma::imat& observations,
     const int num_groups,
-    const arma::imat& group_indices,
+    const std::vector<arma::mat>& residual_matrices,
     const std::vector<arma::imat>& counts_per_category,
     const std::vector<arma::imat>& blume_capel_stats,
     const arma::uvec& is_ordinal_variable,
@@ -257,9 +271,11 @@ void update_main_effects_metropolis_bgmcompare (
     SafeRNG& rng,
     arma::mat& proposal_sd_main,
     const BaseParameterPrior& difference_prior,
-    const BaseParameterPrior& threshold_prior
+    const BaseParameterPrior& threshold_prior,
+    double& accept_prob_sum,
+    int& num_updated
 ) {
-  const int num_vars = observations.n_cols;
+  const int num_vars = num_categories.n_elem;
   arma::umat index_mask_main = arma::zeros<arma::umat>(proposal_sd_main.n_rows,
                                                        proposal_sd_main.n_cols);
   arma::mat accept_prob_main = arma::zeros<arma::mat>(proposal_sd_main.n_rows,
@@ -274,10 +290,9 @@ void update_main_effects_metropolis_bgmcompare (
     auto log_post = [&](double theta) {
       main_effects(row, h) = theta;
       return log_pseudoposterior_main_component(
-        main_effects, pairwise_effects, main_effect_indices,
-        pairwise_effect_indices, projection, observations,
-        group_indices, num_categories, counts_per_category,
-        blume_capel_stats, num_groups, inclusion_indicator,
+        main_effects, main_effect_indices, projection, num_categories,
+        counts_per_category, blume_capel_stats, residual_matrices,
+        num_groups, inclusion_indicator,
         is_ordinal_variable, baseline_category,
         variable, category, par, h,
         difference_prior, threshold_prior
@@ -287,6 +302,8 @@ void update_main_effects_metropolis_bgmcompare (
     StepResult result = metropolis_step(current, proposal_sd, log_post, rng);
     current = result.state[0];
     accept_prob_main(row, h) = result.accept_prob;
+    accept_prob_sum += result.accept_prob;
+    ++num_updated;
   };
 
   // --- loop over variables ---
@@ -350,9 +367,10 @@ void update_main_effects_metropolis_bgmcompare (
 //  - inclusion_indicator: Indicator matrix; off-diagonal entries control group differences.
 //  - projection: Group projection matrix.
 //  - num_categories: Number of categories per variable.
-//  - observations: Data matrix [persons × variables].
+//  - observations_group: Per-group observations as double [persons × variables].
 //  - num_groups: Number of groups (G).
-//  - group_indices: Row ranges per group in `observations`.
+//  - residual_matrices: Per-group residual matrices [persons × variables];
+//                       columns var1 and var2 updated in place on acceptance.
 //  - pairwise_stats: Group-specific sufficient statistics for pairwise effects.
 //  - is_ordinal_variable: Indicator for ordinal vs. Blume–Capel variables.
 //  - baseline_category: Reference categories (Blume–Capel only).
@@ -363,6 +381,8 @@ void update_main_effects_metropolis_bgmcompare (
 //  - rng: Random number generator.
 //  - proposal_sd_pair: Proposal standard deviations [same shape as `pairwise_effects`];
 //                      updated in place.
+//  - accept_prob_sum, num_updated: Running sum of acceptance probabilities and
+//                      count of updated parameters; incremented in place.
 //
 // Notes:
 //  - Acceptance probabilities are tracked per parameter and fed to
@@ -377,9 +397,9 @@ void update_pairwise_effects_metropolis_bgmcompare (
     const arma::imat& inclusion_indicator,
     const arma::mat& projection,
     const arma::ivec& num_categories,
-    const arma::imat& observations,
+    const std::vector<arma::mat>& observations_group,
     const int num_groups,
-    const arma::imat& group_indices,
+    std::vector<arma::mat>& residual_matrices,
     const std::vector<arma::mat>& pairwise_stats,
     const arma::uvec& is_ordinal_variable,
     const arma::ivec& baseline_category,
@@ -389,42 +409,15 @@ void update_pairwise_effects_metropolis_bgmcompare (
     SafeRNG& rng,
     arma::mat& proposal_sd_pair,
     const BaseParameterPrior& interaction_prior,
-    const BaseParameterPrior& difference_prior
+    const BaseParameterPrior& difference_prior,
+    double& accept_prob_sum,
+    int& num_updated
 ) {
-  int num_variables = observations.n_cols;
+  int num_variables = num_categories.n_elem;
   int num_pairs = num_variables * (num_variables - 1) / 2;
   arma::mat accept_prob_pair = arma::zeros<arma::mat>(num_pairs, num_groups);
   arma::umat index_mask_pair = arma::zeros<arma::umat>(num_pairs, num_groups);
 
-  // --- Build group-specific pairwise matrices and residual matrices ---
-  std::vector<arma::mat> pairwise_groups(num_groups);
-  std::vector<arma::mat> residual_matrices(num_groups);
-  std::vector<arma::mat> obs_double_groups(num_groups);
-
-  for (int g = 0; g < num_groups; ++g) {
-    const int r0 = group_indices(g, 0);
-    const int r1 = group_indices(g, 1);
-    const arma::vec proj_g = projection.row(g).t();
-
-    // Build group-specific pairwise effects matrix
-    arma::mat pairwise_group(num_variables, num_variables, arma::fill::zeros);
-    for (int v = 0; v < num_variables - 1; ++v) {
-      for (int u = v + 1; u < num_variables; ++u) {
-        double w = compute_group_pairwise_effects(
-          v, u, num_groups, pairwise_effects, pairwise_effect_indices,
-          inclusion_indicator, proj_g
-        );
-        pairwise_group(v, u) = w;
-        pairwise_group(u, v) = w;
-      }
-    }
-    pairwise_groups[g] = pairwise_group;
-
-    // Convert observations to double and compute residual matrix
-    obs_double_groups[g] = arma::conv_to<arma::mat>::from(observations.rows(r0, r1));
-    residual_matrices[g] = obs_double_groups[g] * pairwise_group;
-  }
-
   // --- helper for one update using optimized residual-based function ---
   auto do_update = [&](int var1, int var2, int h) {
     int idx = pairwise_effect_indices(var1, var2);
@@ -436,7 +429,7 @@ void update_pairwise_effects_metropolis_bgmcompare (
       double delta = theta - current;
       return log_pseudoposterior_pair_component(
         main_effects, pairwise_effects, main_effect_indices,
-        pairwise_effect_indices, projection, observations, group_indices,
+        pairwise_effect_indices, projection, observations_group,
         num_categories, pairwise_stats, residual_matrices, num_groups,
         inclusion_indicator, is_ordinal_variable, baseline_category,
         pairwise_scaling_factors, var1, var2, h, delta,
@@ -456,17 +449,15 @@ void update_pairwise_effects_metropolis_bgmcompare (
         const arma::vec proj_g = projection.row(g).t();
         double delta_g = (h == 0) ? delta : delta * proj_g(h - 1);
 
-        // Update pairwise_group for this group
-        pairwise_groups[g](var1, var2) += delta_g;
-        pairwise_groups[g](var2, var1) += delta_g;
-
         // Update residual matrix columns
-        residual_matrices[g].col(var1) += obs_double_groups[g].col(var2) * delta_g;
-        residual_matrices[g].col(var2) += obs_double_groups[g].col(var1) * delta_g;
+        residual_matrices[g].col(var1) += observations_group[g].col(var2) * delta_g;
+        residual_matrices[g].col(var2) += observations_group[g].col(var1) * delta_g;
       }
     }
 
     accept_prob_pair(idx, h) = result.accept_prob;
+    accept_prob_sum += result.accept_prob;
+    ++num_updated;
   };
 
   for (int var1 = 0; var1 < num_variables - 1; var1++) {
@@ -484,325 +475,6 @@ void update_pairwise_effects_metropolis_bgmcompare (
 
 
 
-// Heuristically determine an initial NUTS step size for bgmCompare.
-//
-// This function vectorizes the current model parameters, then repeatedly
-// simulates short HMC trajectories to calibrate a stable starting step size
-// that achieves a target acceptance rate.
-//
-// Workflow:
-//  1. Vectorize current parameters into a single state vector.
-//  2. Define closures for log-posterior evaluation and gradient computation:
-//     - `log_post`: unpacks parameters and evaluates the log pseudoposterior.
-//     - `grad`: unpacks parameters and evaluates the gradient of the
-//       pseudoposterior.
-//  3. Pass these to `heuristic_initial_step_size`, which runs the heuristic
-//     tuning loop.
-//
-// Inputs:
-//  - main_effects: Matrix of main-effect parameters [n_main_rows × G].
-//  - pairwise_effects: Matrix of pairwise interaction parameters [n_pairs × G].
-//  - main_effect_indices: Row index ranges for each variable’s main effects.
-//  - pairwise_effect_indices: Row index map for pairwise effects.
-//  - inclusion_indicator: Matrix marking which main and pairwise differences
-//                         are active.
-//  - projection: Group projection matrix (encodes contrasts).
-//  - num_categories: Number of categories per variable [V].
-//  - observations: Data matrix [persons × variables].
-//  - num_groups: Number of groups (G).
-//  - group_indices: Row ranges per group in `observations`.
-//  - counts_per_category: Per-group sufficient statistics for ordinal variables.
-//  - blume_capel_stats: Per-group sufficient statistics for Blume–Capel variables.
-//  - pairwise_stats: Per-group sufficient statistics for pairwise effects.
-//  - is_ordinal_variable: Indicator for ordinal vs. Blume–Capel variables [V].
-//  - baseline_category: Reference categories for Blume–Capel variables [V].
-//  - pairwise_scale: Scale parameter for overall pairwise priors.
-//  - difference_scale: Scale parameter for group difference priors.
-//  - main_alpha, main_beta: Hyperparameters for Beta prior on main effects.
-//  - target_acceptance: Desired acceptance probability (e.g. 0.8).
-//  - rng: Random number generator.
-//
-// Returns:
-//  - A double value for the initial NUTS step size.
-//
-// Notes:
-//  - This routine is only used during warmup to initialize
-//    `NUTSAdaptationController`.
-//  - Correct indexing of parameters relies on `build_index_maps` to ensure
-//    consistency between vectorization and gradient computation.
-double find_initial_stepsize_bgmcompare(
-    arma::mat& main_effects,
-    arma::mat& pairwise_effects,
-    const arma::imat& main_effect_indices,
-    const arma::imat& pairwise_effect_indices,
-    const arma::imat& inclusion_indicator,
-    const arma::mat& projection,
-    const arma::ivec& num_categories,
-    const arma::imat& observations,
-    const int num_groups,
-    const arma::imat& group_indices,
-    const std::vector<arma::imat>& counts_per_category,
-    const std::vector<arma::imat>& blume_capel_stats,
-    const std::vector<arma::mat>& pairwise_stats,
-    const arma::uvec& is_ordinal_variable,
-    const arma::ivec& baseline_category,
-    const arma::mat& pairwise_scaling_factors,
-    const double target_acceptance,
-    SafeRNG& rng,
-    const BaseParameterPrior& interaction_prior,
-    const BaseParameterPrior& difference_prior,
-    const BaseParameterPrior& threshold_prior
-) {
-  arma::vec theta = vectorize_model_parameters_bgmcompare(
-    main_effects, pairwise_effects, inclusion_indicator, main_effect_indices,
-    pairwise_effect_indices, num_categories, is_ordinal_variable
-  );
-  arma::mat current_main = main_effects;
-  arma::mat current_pair = pairwise_effects;
-
-  // Pre-convert observations to double once (avoids repeated conversion in gradient evaluations)
-  const arma::mat obs_double = arma::conv_to<arma::mat>::from(observations);
-
-  auto index_maps = build_index_maps(
-    main_effects, pairwise_effects,
-    inclusion_indicator,
-    main_effect_indices,
-    pairwise_effect_indices, num_categories, is_ordinal_variable
-  );
-  auto& main_index = index_maps.first;
-  auto& pair_index = index_maps.second;
-
-  arma::vec grad_obs_act = gradient_observed_active(
-    main_effect_indices, pairwise_effect_indices, projection,
-    observations, group_indices, num_categories, inclusion_indicator,
-    counts_per_category, blume_capel_stats, pairwise_stats,
-    num_groups, is_ordinal_variable, baseline_category,
-    main_index, pair_index
-  );
-
-  auto grad = [&](const arma::vec& theta_vec) {
-    unvectorize_model_parameters_bgmcompare(
-      theta_vec, current_main, current_pair, inclusion_indicator,
-      main_effect_indices, pairwise_effect_indices, num_groups, num_categories,
-      is_ordinal_variable
-    );
-
-    return gradient(
-      current_main, current_pair, main_effect_indices, pairwise_effect_indices,
-      projection, obs_double, group_indices, num_categories,
-      counts_per_category, blume_capel_stats,
-      pairwise_stats, num_groups, inclusion_indicator,
-      is_ordinal_variable, baseline_category,
-      pairwise_scaling_factors, main_index, pair_index,
-      grad_obs_act,
-      interaction_prior, difference_prior, threshold_prior
-    );
-  };
-
-  auto joint = [&](const arma::vec& theta_vec) {
-    unvectorize_model_parameters_bgmcompare(
-      theta_vec, current_main, current_pair, inclusion_indicator,
-      main_effect_indices, pairwise_effect_indices, num_groups, num_categories,
-      is_ordinal_variable
-    );
-
-    return logp_and_gradient(
-      current_main, current_pair, main_effect_indices, pairwise_effect_indices,
-      projection, obs_double, group_indices, num_categories,
-      counts_per_category, blume_capel_stats,
-      pairwise_stats, num_groups, inclusion_indicator,
-      is_ordinal_variable, baseline_category,
-      pairwise_scaling_factors,
-      main_index, pair_index, grad_obs_act,
-      interaction_prior, difference_prior, threshold_prior
-    );
-  };
-
-  return heuristic_initial_step_size(theta, grad, joint, rng, target_acceptance);
-}
-
-
-
-// Perform one No-U-Turn Sampler (NUTS) update step for the bgmCompare model.
-//
-// The function:
-//  1. Vectorizes the current parameter state (main + pairwise effects).
-//  2. Defines closures for log-posterior evaluation and gradient calculation.
-//  3. Runs a NUTS trajectory (adaptive tree-based extension of HMC).
-//  4. Unpacks the accepted state back into main and pairwise matrices.
-//  5. Updates the adaptation controller with acceptance probability.
-//
-// Inputs:
-//  - main_effects, pairwise_effects: Current parameter matrices, updated in place.
-//  - main_effect_indices, pairwise_effect_indices: Index maps for parameters.
-//  - inclusion_indicator: Indicates active main and pairwise differences.
-//  - projection: Group projection matrix for contrasts.
-//  - num_categories: Number of categories per variable [V].
-//  - observations: Data matrix [N × V].
-//  - num_groups: Number of groups.
-//  - group_indices: Row ranges for each group in `observations`.
-//  - counts_per_category, blume_capel_stats: Per-group sufficient statistics.
-//  - pairwise_stats: Per-group pairwise sufficient statistics.
-//  - is_ordinal_variable: Marks ordinal vs. Blume–Capel variables.
-//  - baseline_category: Reference categories for Blume–Capel variables.
-//  - pairwise_scale: Scale of overall pairwise prior.
-//  - difference_scale: Scale of group-difference prior.
-//  - main_alpha, main_beta: Hyperparameters for main-effect priors.
-//  - nuts_max_depth: Maximum tree depth for NUTS doubling procedure.
-//  - iteration: Current sampler iteration (for adaptation scheduling).
-//  - nuts_adapt: Adaptation controller for step size and mass matrix.
-//  - learn_mass_matrix: Whether to adapt the mass matrix (unused inside NUTS but relevant to controller).
-//  - selection: If true, restrict mass matrix to active parameters only.
-//  - rng: Random number generator.
-//
-// Returns:
-//  - A `StepResult` containing the accepted state and diagnostics
-//    (e.g. tree depth, divergences, energy).
-//
-// Notes:
-//  - This variant is specific to bgmCompare, where parameters are stored in
-//    row-wise structures with group-difference columns.
-//  - Consistency between vectorization, unvectorization, and gradient
-//    indexing is enforced via `build_index_maps`.
-//  - Diagnostics from the returned `StepResult` can be used to monitor
-//    sampler stability (e.g. divergences, tree depth).
-StepResult update_nuts_bgmcompare(
-    arma::mat& main_effects,
-    arma::mat& pairwise_effects,
-    const arma::imat& main_effect_indices,
-    const arma::imat& pairwise_effect_indices,
-    const arma::imat& inclusion_indicator,
-    const arma::mat& projection,
-    const arma::ivec& num_categories,
-    const arma::imat& observations,
-    const int num_groups,
-    const arma::imat& group_indices,
-    const std::vector<arma::imat>& counts_per_category,
-    const std::vector<arma::imat>& blume_capel_stats,
-    const std::vector<arma::mat>& pairwise_stats,
-    const arma::uvec& is_ordinal_variable,
-    const arma::ivec& baseline_category,
-    const arma::mat& pairwise_scaling_factors,
-    const int nuts_max_depth,
-    const int iteration,
-    NUTSAdaptationController& nuts_adapt,
-    const bool learn_mass_matrix,
-    const bool selection,
-    SafeRNG& rng,
-    const BaseParameterPrior& interaction_prior,
-    const BaseParameterPrior& difference_prior,
-    const BaseParameterPrior& threshold_prior
-) {
-  // Pre-convert observations to double once (avoids repeated conversion in gradient evaluations)
-  const arma::mat obs_double = arma::conv_to<arma::mat>::from(observations);
-
-  arma::vec current_state = vectorize_model_parameters_bgmcompare(
-    main_effects, pairwise_effects, inclusion_indicator,
-    main_effect_indices, pairwise_effect_indices, num_categories,
-    is_ordinal_variable
-  );
-
-  arma::mat current_main = main_effects;
-  arma::mat current_pair = pairwise_effects;
-
-  auto index_maps = build_index_maps(
-    main_effects, pairwise_effects,
-    inclusion_indicator,
-    main_effect_indices,
-    pairwise_effect_indices, num_categories, is_ordinal_variable
-  );
-  auto& main_index = index_maps.first;
-  auto& pair_index = index_maps.second;
-
-  arma::vec grad_obs_act = gradient_observed_active(
-    main_effect_indices, pairwise_effect_indices, projection,
-    observations, group_indices, num_categories, inclusion_indicator,
-    counts_per_category, blume_capel_stats, pairwise_stats,
-    num_groups, is_ordinal_variable, baseline_category,
-    main_index, pair_index
-  );
-
-  auto grad = [&](const arma::vec& theta_vec) {
-    unvectorize_model_parameters_bgmcompare(
-      theta_vec, current_main, current_pair, inclusion_indicator,
-      main_effect_indices, pairwise_effect_indices, num_groups, num_categories,
-      is_ordinal_variable
-    );
-
-    return gradient(
-      current_main, current_pair, main_effect_indices, pairwise_effect_indices,
-      projection, obs_double, group_indices, num_categories,
-      counts_per_category, blume_capel_stats,
-      pairwise_stats, num_groups, inclusion_indicator,
-      is_ordinal_variable, baseline_category,
-      pairwise_scaling_factors, main_index, pair_index,
-      grad_obs_act,
-      interaction_prior, difference_prior, threshold_prior
-    );
-  };
-
-  auto joint = [&](const arma::vec& theta_vec) {
-    unvectorize_model_parameters_bgmcompare(
-      theta_vec, current_main, current_pair, inclusion_indicator,
-      main_effect_indices, pairwise_effect_indices, num_groups, num_categories,
-      is_ordinal_variable
-    );
-
-    return logp_and_gradient(
-      current_main, current_pair, main_effect_indices, pairwise_effect_indices,
-      projection, obs_double, group_indices, num_categories,
-      counts_per_category, blume_capel_stats,
-      pairwise_stats, num_groups, inclusion_indicator,
-      is_ordinal_variable, baseline_category,
-      pairwise_scaling_factors,
-      main_index, pair_index, grad_obs_act,
-      interaction_prior, difference_prior, threshold_prior
-    );
-  };
-
-  //adapt
-  arma::vec active_inv_mass = inv_mass_active(
-    nuts_adapt.inv_mass_diag(), inclusion_indicator, num_groups, num_categories,
-    is_ordinal_variable, main_index, pair_index, main_effect_indices,
-    pairwise_effect_indices, selection
-  );
-
-  StepResult result = nuts_step(
-    current_state, nuts_adapt.current_step_size(), joint,
-    active_inv_mass, rng, nuts_max_depth
-  );
-
-  current_state = result.state;
-  unvectorize_model_parameters_bgmcompare(
-    current_state, main_effects, pairwise_effects, inclusion_indicator,
-    main_effect_indices, pairwise_effect_indices, num_groups, num_categories,
-    is_ordinal_variable
-  );
-
-  nuts_adapt.update(current_state, result.accept_prob, iteration);
-
-  // If mass matrix was just updated, re-run the heuristic to find a good
-  // step size for the new mass matrix. Use current step size as starting point.
-  if (nuts_adapt.mass_matrix_just_updated()) {
-    arma::vec new_inv_mass = inv_mass_active(
-      nuts_adapt.inv_mass_diag(), inclusion_indicator, num_groups, num_categories,
-      is_ordinal_variable, main_index, pair_index, main_effect_indices,
-      pairwise_effect_indices, selection
-    );
-    double current_eps = nuts_adapt.current_step_size();
-    double new_eps = heuristic_initial_step_size(
-      current_state, grad, joint, new_inv_mass, rng,
-      nuts_adapt.target_acceptance(),
-      current_eps   // init_step: use current step size as starting point
-    );
-    nuts_adapt.reinit_stepsize(new_eps);
-  }
-
-  return result;
-}
-
-
-
 // Adapt proposal standard deviations (SDs) for main and pairwise effects
 // during the warmup phase of the bgmCompare sampler.
 //
@@ -827,9 +499,10 @@ StepResult update_nuts_bgmcompare(
 //  - inclusion_indicator: Marks which group differences are active.
 //  - projection: Group projection matrix.
 //  - num_categories: Categories per variable.
-//  - observations: Data matrix [N × V].
+//  - observations_group: Per-group observations as double [N_g × V].
 //  - num_groups: Number of groups.
-//  - group_indices: Row ranges per group in `observations`.
+//  - residual_matrices: Per-group residual matrices [N_g × V], kept current
+//    on acceptance of pairwise moves.
 //  - counts_per_category, blume_capel_stats: Per-group sufficient statistics for main effects.
 //  - pairwise_stats: Per-group sufficient statistics for pairwise effects.
 //  - is_ordinal_variable: Marks ordinal vs. Blume–Capel variables.
@@ -860,9 +533,9 @@ void tune_proposal_sd_bgmcompare(
     const arma::imat& inclusion_indicator,
     const arma::mat& projection,
     const arma::ivec& num_categories,
-    const arma::imat& observations,
+    const std::vector<arma::mat>& observations_group,
     int num_groups,
-    const arma::imat& group_indices,
+    std::vector<arma::mat>& residual_matrices,
     const std::vector<arma::imat>& counts_per_category,
     const std::vector<arma::imat>& blume_capel_stats,
     const std::vector<arma::mat>& pairwise_stats,
@@ -875,8 +548,8 @@ void tune_proposal_sd_bgmcompare(
     const BaseParameterPrior& interaction_prior,
     const BaseParameterPrior& difference_prior,
     const BaseParameterPrior& threshold_prior,
-    double target_accept = 0.44,
-    double rm_decay = 0.75)
+    double target_accept,
+    double rm_decay)
 {
   if (!sched.adapt_proposal_sd(iteration)) return;
 
@@ -884,7 +557,7 @@ void tune_proposal_sd_bgmcompare(
   double t = iteration - sched.stage3b_start + 1;
   double rm_weight = std::pow(t, -rm_decay);
 
-  const int V = observations.n_cols;
+  const int V = num_categories.n_elem;
 
   // --- MAIN EFFECTS ---
   for (int var = 0; var < V; ++var) {
@@ -904,11 +577,9 @@ void tune_proposal_sd_bgmcompare(
           auto log_post = [&](double theta) {
             main_effects(row, h) = theta;
             return log_pseudoposterior_main_component(
-              main_effects, pairwise_effects,
-              main_effect_indices, pairwise_effect_indices,
-              projection, observations, group_indices,
+              main_effects, main_effect_indices, projection,
               num_categories, counts_per_category, blume_capel_stats,
-              num_groups, inclusion_indicator, is_ordinal_variable,
+              residual_matrices, num_groups, inclusion_indicator, is_ordinal_variable,
               baseline_category,
               var, c, -1, h,
               difference_prior, threshold_prior
@@ -933,11 +604,9 @@ void tune_proposal_sd_bgmcompare(
           auto log_post = [&](double theta) {
             main_effects(row, h) = theta;
             return log_pseudoposterior_main_component(
-              main_effects, pairwise_effects,
-              main_effect_indices, pairwise_effect_indices,
-              projection, observations, group_indices,
+              main_effects, main_effect_indices, projection,
               num_categories, counts_per_category, blume_capel_stats,
-              num_groups, inclusion_indicator, is_ordinal_variable,
+              residual_matrices, num_groups, inclusion_indicator, is_ordinal_variable,
               baseline_category,
               var, -1, par, h,
               difference_prior, threshold_prior
@@ -955,32 +624,6 @@ void tune_proposal_sd_bgmcompare(
   }
 
   // --- PAIRWISE EFFECTS ---
-  // Build group-specific pairwise matrices and residual matrices
-  std::vector<arma::mat> pairwise_groups(num_groups);
-  std::vector<arma::mat> residual_matrices(num_groups);
-  std::vector<arma::mat> obs_double_groups(num_groups);
-
-  for (int g = 0; g < num_groups; ++g) {
-    const int r0 = group_indices(g, 0);
-    const int r1 = group_indices(g, 1);
-    const arma::vec proj_g = projection.row(g).t();
-
-    arma::mat pairwise_group(V, V, arma::fill::zeros);
-    for (int v = 0; v < V - 1; ++v) {
-      for (int u = v + 1; u < V; ++u) {
-        double w = compute_group_pairwise_effects(
-          v, u, num_groups, pairwise_effects, pairwise_effect_indices,
-          inclusion_indicator, proj_g
-        );
-        pairwise_group(v, u) = w;
-        pairwise_group(u, v) = w;
-      }
-    }
-    pairwise_groups[g] = pairwise_group;
-    obs_double_groups[g] = arma::conv_to<arma::mat>::from(observations.rows(r0, r1));
-    residual_matrices[g] = obs_double_groups[g] * pairwise_group;
-  }
-
   for (int v1 = 0; v1 < V - 1; ++v1) {
     for (int v2 = v1 + 1; v2 < V; ++v2) {
       int idx = pairwise_effect_indices(v1, v2);
@@ -996,7 +639,7 @@ void tune_proposal_sd_bgmcompare(
           return log_pseudoposterior_pair_component(
             main_effects, pairwise_effects,
             main_effect_indices, pairwise_effect_indices,
-            projection, observations, group_indices,
+            projection, observations_group,
             num_categories, pairwise_stats, residual_matrices, num_groups,
             inclusion_indicator, is_ordinal_variable, baseline_category,
             pairwise_scaling_factors, v1, v2, h, delta,
@@ -1015,11 +658,8 @@ void tune_proposal_sd_bgmcompare(
             const arma::vec proj_g = projection.row(g).t();
             double delta_g = (h == 0) ? delta : delta * proj_g(h - 1);
 
-            pairwise_groups[g](v1, v2) += delta_g;
-            pairwise_groups[g](v2, v1) += delta_g;
-
-            residual_matrices[g].col(v1) += obs_double_groups[g].col(v2) * delta_g;
-            residual_matrices[g].col(v2) += obs_double_groups[g].col(v1) * delta_g;
+            residual_matrices[g].col(v1) += observations_group[g].col(v2) * delta_g;
+            residual_matrices[g].col(v2) += observations_group[g].col(v1) * delta_g;
           }
         }
 
@@ -1055,9 +695,10 @@ void tune_proposal_sd_bgmcompare(
 //  - main_effects, pairwise_effects: Parameter matrices, updated in place.
 //  - main_effect_indices, pairwise_effect_indices: Index maps for parameters.
 //  - projection: Group projection matrix.
-//  - observations: Data matrix [N × V].
+//  - observations_group: Per-group observations as double [N_g × V].
 //  - num_groups: Number of groups.
-//  - group_indices: Row ranges per group in `observations`.
+//  - residual_matrices: Per-group residual matrices [N_g × V]; columns var1
+//    and var2 updated in place when a pairwise move is accepted.
 //  - num_categories: Categories per variable [V × G].
 //  - inclusion_indicator: Indicator matrix for differences, updated in place.
 //  - is_ordinal_variable: Marks ordinal vs. Blume–Capel variables [V].
@@ -1088,9 +729,9 @@ void update_indicator_differences_metropolis_bgmcompare (
     const arma::imat& main_effect_indices,
     const arma::imat& pairwise_effect_indices,
     const arma::mat& projection,
-    const arma::imat& observations,
+    const std::vector<arma::mat>& observations_group,
     const int num_groups,
-    const arma::imat& group_indices,
+    std::vector<arma::mat>& residual_matrices,
     const arma::imat& num_categories,
     arma::imat& inclusion_indicator,
     const arma::uvec& is_ordinal_variable,
@@ -1105,7 +746,7 @@ void update_indicator_differences_metropolis_bgmcompare (
     SafeRNG& rng,
     const BaseParameterPrior& difference_prior
 ) {
-  const int num_variables = observations.n_cols;
+  const int num_variables = inclusion_indicator.n_cols;
 
   // --- main effects ---
   // Skip main effect indicator updates if main_difference_selection is disabled
@@ -1135,10 +776,9 @@ void update_indicator_differences_metropolis_bgmcompare (
 
     // Calculate log acceptance probability
     double log_accept = log_pseudolikelihood_ratio_main(
-      current_main_effects, proposed_main_effects, pairwise_effects,
-      main_effect_indices, pairwise_effect_indices, projection,
-      observations, group_indices, num_categories, counts_per_category,
-      blume_capel_stats, num_groups, inclusion_indicator,
+      current_main_effects, proposed_main_effects, main_effect_indices,
+      projection, observations_group, residual_matrices, num_categories,
+      counts_per_category, blume_capel_stats, num_groups,
       is_ordinal_variable, baseline_category, var
     );
 
@@ -1211,9 +851,10 @@ void update_indicator_differences_metropolis_bgmcompare (
     // Calculate log acceptance probability
     double log_accept = log_pseudolikelihood_ratio_pairwise(
       main_effects, current_pairwise_effects, proposed_pairwise_effects,
-      main_effect_indices, pairwise_effect_indices, projection, observations,
-      group_indices, num_categories, pairwise_stats, num_groups,
-      inclusion_indicator, is_ordinal_variable, baseline_category, var1, var2
+      main_effect_indices, pairwise_effect_indices, projection,
+      observations_group, residual_matrices, num_categories, pairwise_stats,
+      num_groups, inclusion_indicator, is_ordinal_variable, baseline_category,
+      var1, var2
     );
 
     // Add prior inclusion probability contribution
@@ -1256,6 +897,16 @@ void update_indicator_differences_metropolis_bgmcompare (
     // Metropolis-Hastings acceptance step
     double U = runif(rng);
     if (MY_LOG(U) < log_accept) {
+      // Group-specific weights before the move
+      arma::vec w_old(num_groups);
+      for (int g = 0; g < num_groups; g++) {
+        const arma::vec proj_g = projection.row(g).t();
+        w_old(g) = compute_group_pairwise_effects(
+          var1, var2, num_groups, pairwise_effects, pairwise_effect_indices,
+          inclusion_indicator, proj_g
+        );
+      }
+
       // Update inclusion inclusion_indicator
       inclusion_indicator(var1, var2) = proposed_ind;
       inclusion_indicator(var2, var1) = proposed_ind;
@@ -1264,511 +915,15 @@ void update_indicator_differences_metropolis_bgmcompare (
       for (int h = 1; h < num_groups; h++) {
         pairwise_effects(int_index, h) = proposed_pairwise_effects(int_index, h);
       }
-    }
-  }
-}
-
-
-
-// Perform one Gibbs update step for the bgmCompare model.
-//
-// This function executes a single iteration of the Gibbs sampler, including:
-//
-//  Step 0: (optional) Initialize graph structure if difference selection
-//          is enabled and the current iteration marks the start of Stage 3c.
-//
-//  Step 1: (optional) Update inclusion indicators for group differences
-//          (main and pairwise effects) via Metropolis–Hastings proposals.
-//
-//  Step 2: Update model parameters according to the selected update method:
-//    - "adaptive-metropolis": Update main and pairwise effects individually
-//      with random-walk Metropolis and adaptive proposal SDs.
-//    - "nuts": Update the full parameter vector using the No-U-Turn Sampler.
-//      If past burn-in, store NUTS diagnostics (tree depth, divergences, energy).
-//
-//  Step 3: (Stage 3b only) Adapt proposal SDs for Metropolis updates using
-//          Robbins–Monro tuning.
-//
-// Inputs:
-//  - observations: Data matrix [N × V].
-//  - num_categories: Number of categories per variable [V].
-//  - pairwise_scale, difference_scale: Prior scale parameters.
-//  - counts_per_category, blume_capel_stats: Sufficient statistics per group.
-//  - main_alpha, main_beta: Hyperparameters for Beta prior on main effects.
-//  - inclusion_indicator: Matrix of active group differences [V × V], updated in place.
-//  - main_effects, pairwise_effects: Parameter matrices, updated in place.
-//  - is_ordinal_variable: Marks ordinal vs. Blume–Capel variables.
-//  - baseline_category: Reference categories for Blume–Capel variables.
-//  - iteration: Current iteration index.
-//  - pairwise_effect_indices, main_effect_indices: Index maps for parameters.
-//  - pairwise_stats: Per-group pairwise sufficient statistics.
-//  - nuts_max_depth: Maximum tree depth for NUTS.
-//  - nuts_adapt: Adaptation controller for NUTS.
-//  - metropolis_adapt_main, metropolis_adapt_pair: Adaptation controllers for RWM updates.
-//  - learn_mass_matrix: Whether to adapt the mass matrix in NUTS.
-//  - schedule: Warmup schedule, controls adaptation and selection phases.
-//  - treedepth_samples, divergent_samples, energy_samples: Buffers for NUTS diagnostics.
-//  - projection: Group projection matrix.
-//  - num_groups: Number of groups.
-//  - group_indices: Row ranges per group in `observations`.
-//  - rng: Random number generator.
-//  - inclusion_probability: Prior probabilities for including differences.
-//  - update_method: Update strategy ("adaptive-metropolis", "nuts").
-//  - proposal_sd_main, proposal_sd_pair: Proposal SD matrices for Metropolis updates.
-//  - index: Index table for pairwise differences.
-//
-// Side effects:
-//  - Updates parameters, inclusion indicators, and sufficient statistics.
-//  - Updates adaptation controllers and (if NUTS) diagnostic buffers.
-//
-// Notes:
-//  - This function encapsulates all update logic for bgmCompare.
-//  - Choice of `update_method` governs whether updates are local (RWM) or
-//    global (NUTS).
-void gibbs_update_step_bgmcompare (
-    const arma::imat& observations,
-    const arma::ivec& num_categories,
-    const arma::mat& pairwise_scaling_factors,
-    const std::vector<arma::imat>& counts_per_category,
-    const std::vector<arma::imat>& blume_capel_stats,
-    arma::imat& inclusion_indicator,
-    arma::mat& pairwise_effects,
-    arma::mat& main_effects,
-    const arma::uvec& is_ordinal_variable,
-    const arma::ivec& baseline_category,
-    const int iteration,
-    const arma::imat& pairwise_effect_indices,
-    const std::vector<arma::mat>& pairwise_stats,
-    const int nuts_max_depth,
-    NUTSAdaptationController& nuts_adapt,
-    MetropolisAdaptationController& metropolis_adapt_main,
-    MetropolisAdaptationController& metropolis_adapt_pair,
-    const bool learn_mass_matrix,
-    WarmupSchedule const& schedule,
-    arma::ivec& treedepth_samples,
-    arma::ivec& divergent_samples,
-    arma::vec& energy_samples,
-    arma::vec& accept_prob_samples,
-    const arma::imat& main_effect_indices,
-    const arma::mat& projection,
-    const int num_groups,
-    const arma::imat group_indices,
-    SafeRNG& rng,
-    arma::mat& inclusion_probability,
-    const UpdateMethod update_method,
-    arma::mat& proposal_sd_main,
-    arma::mat& proposal_sd_pair,
-    const arma::imat& index,
-    const bool main_difference_selection,
-    const BaseParameterPrior& interaction_prior,
-    const BaseParameterPrior& difference_prior,
-    const BaseParameterPrior& threshold_prior
-) {
-
-  // Step 0: Initialise random graph structure when edge_selection = TRUE
-  if (schedule.selection_enabled(iteration) && iteration == schedule.stage3c_start) {
-    initialise_graph_bgmcompare(
-      inclusion_indicator, main_effects, pairwise_effects, main_effect_indices,
-      pairwise_effect_indices, inclusion_probability, main_difference_selection, rng
-    );
-  }
-
-  // Step 1: Difference selection via MH indicator updates (if enabled)
-  if (schedule.selection_enabled(iteration)) {
-    update_indicator_differences_metropolis_bgmcompare (
-        inclusion_probability, index, main_effects, pairwise_effects,
-        main_effect_indices, pairwise_effect_indices, projection, observations,
-        num_groups, group_indices, num_categories, inclusion_indicator,
-        is_ordinal_variable, baseline_category, proposal_sd_main,
-        pairwise_scaling_factors, proposal_sd_pair, counts_per_category,
-        blume_capel_stats, pairwise_stats, main_difference_selection, rng,
-        difference_prior
-    );
-  }
-
-  // Step 2: Update parameters
-  if(update_method == adaptive_metropolis) {
-    update_main_effects_metropolis_bgmcompare (
-        main_effects, pairwise_effects, main_effect_indices,
-        pairwise_effect_indices, inclusion_indicator, projection,
-        num_categories, observations, num_groups, group_indices,
-        counts_per_category, blume_capel_stats, is_ordinal_variable,
-        baseline_category, iteration,
-        metropolis_adapt_main, rng, proposal_sd_main,
-        difference_prior, threshold_prior
-    );
-
-    update_pairwise_effects_metropolis_bgmcompare (
-        main_effects, pairwise_effects, main_effect_indices,
-        pairwise_effect_indices, inclusion_indicator, projection,
-        num_categories, observations, num_groups, group_indices,
-        pairwise_stats, is_ordinal_variable, baseline_category,
-        pairwise_scaling_factors, iteration, metropolis_adapt_pair, rng,
-        proposal_sd_pair,
-        interaction_prior, difference_prior
-    );
-  } else if (update_method == nuts) {
-    StepResult result = update_nuts_bgmcompare(
-      main_effects, pairwise_effects, main_effect_indices,
-      pairwise_effect_indices, inclusion_indicator, projection, num_categories,
-      observations, num_groups, group_indices, counts_per_category,
-      blume_capel_stats, pairwise_stats, is_ordinal_variable,
-      baseline_category, pairwise_scaling_factors,
-      nuts_max_depth, iteration, nuts_adapt, learn_mass_matrix,
-      schedule.selection_enabled(iteration), rng,
-      interaction_prior, difference_prior, threshold_prior
-    );
-
-    if (iteration >= schedule.total_warmup) {
-      int sample_index = iteration - schedule.total_warmup;
-      if (auto diag = std::dynamic_pointer_cast<NUTSDiagnostics>(result.diagnostics)) {
-        treedepth_samples(sample_index) = diag->tree_depth;
-        divergent_samples(sample_index) = diag->divergent ? 1 : 0;
-        energy_samples(sample_index) = diag->energy;
-        accept_prob_samples(sample_index) = diag->accept_prob;
+      for (int g = 0; g < num_groups; g++) {
+        const arma::vec proj_g = projection.row(g).t();
+        const double delta_g = compute_group_pairwise_effects(
+          var1, var2, num_groups, pairwise_effects, pairwise_effect_indices,
+          inclusion_indicator, proj_g
+        ) - w_old(g);
+        residual_matrices[g].col(var1) += observations_group[g].col(var2) * delta_g;
+        residual_matrices[g].col(var2) += observations_group[g].col(var1) * delta_g;
       }
     }
   }
-
-  /* --- 2b.  proposal-sd tuning during Stage-3b ------------------------------ */
-  tune_proposal_sd_bgmcompare(
-    proposal_sd_main, proposal_sd_pair, main_effects,
-    pairwise_effects, main_effect_indices, pairwise_effect_indices,
-    inclusion_indicator, projection, num_categories, observations, num_groups,
-    group_indices, counts_per_category, blume_capel_stats,
-    pairwise_stats, is_ordinal_variable, baseline_category,
-    pairwise_scaling_factors, iteration, rng, schedule,
-    interaction_prior, difference_prior, threshold_prior
-  );
 }
-
-
-
-// Run a full Gibbs sampler for the bgmCompare model.
-//
-// This function controls the full MCMC lifecycle for a single chain:
-//  - Initializes parameter matrices, proposal SDs, and adaptation controllers.
-//  - Optionally imputes missing data at each iteration.
-//  - Executes Gibbs updates for main and pairwise effects, including
-//    difference-selection if enabled.
-//  - Adapts step size, mass matrix, and proposal SDs during warmup.
-//  - Updates inclusion probabilities under the chosen prior
-//    (e.g. Beta–Bernoulli).
-//  - Collects posterior samples and diagnostics into a `SamplerOutput` struct.
-//
-// Inputs:
-//  - chain_id: Identifier for this chain (1-based).
-//  - observations: Data matrix [N × V].
-//  - num_groups: Number of groups (G).
-//  - counts_per_category: Per-group sufficient statistics (ordinal variables).
-//  - blume_capel_stats: Per-group sufficient statistics (Blume–Capel variables).
-//  - pairwise_stats: Per-group sufficient statistics for pairwise effects.
-//  - num_categories: Number of categories per variable [V].
-//  - main_alpha, main_beta: Hyperparameters for Beta prior on main effects.
-//  - pairwise_scale: Scale parameter for overall pairwise priors.
-//  - difference_scale: Scale parameter for group-difference priors.
-//  - difference_selection_alpha, difference_selection_beta: Hyperparameters
-//    for difference-selection prior.
-//  - difference_prior: Prior type for difference-selection ("Beta-Bernoulli", ...).
-//  - iter: Number of post–burn-in sampling iterations.
-//  - warmup: Number of warmup iterations.
-//  - na_impute: If true, impute missing observations at each iteration.
-//  - missing_data_indices: Matrix of [person, variable] indices of missings.
-//  - is_ordinal_variable: Marks ordinal vs. Blume–Capel variables.
-//  - baseline_category: Reference categories for Blume–Capel variables.
-//  - difference_selection: If true, include MH updates for group-difference indicators.
-//  - main_effect_indices, pairwise_effect_indices: Index maps for parameter rows.
-//  - target_accept: Target acceptance probability (NUTS).
-//  - nuts_max_depth: Maximum tree depth for NUTS.
-//  - learn_mass_matrix: Whether to adapt the mass matrix (NUTS).
-//  - projection: Group projection matrix for contrasts.
-//  - group_membership: Mapping of persons to groups.
-//  - group_indices: Row ranges per group in `observations`.
-//  - interaction_index_matrix: Index map for pairwise interactions.
-//  - inclusion_probability: Matrix of prior inclusion probabilities, updated in place.
-//  - rng: Random number generator.
-//  - update_method: Update strategy ("adaptive-metropolis", "nuts").
-//
-// Returns:
-//  - A `SamplerOutput` struct containing:
-//      - main_samples: MCMC samples for main effects.
-//      - pairwise_samples: MCMC samples for pairwise effects.
-//      - indicator_samples: (optional) Inclusion indicator samples if
-//        difference-selection is enabled.
-//      - treedepth_samples, divergent_samples, energy_samples:
-//        Diagnostics (for NUTS).
-//      - chain_id: Identifier for this chain.
-//
-// Notes:
-//  - Warmup is orchestrated via `WarmupSchedule`, which controls adaptation
-//    phases and difference-selection activation.
-//  - Proposal SDs are tuned via Robbins–Monro during Stage 3b.
-//  - Difference-selection updates toggle inclusion indicators and adjust
-//    associated parameters with MH proposals.
-//  - This function runs entirely in C++ and is wrapped for parallel execution
-//    via `GibbsCompareChainRunner`.
-bgmCompareOutput run_gibbs_sampler_bgmCompare(
-    int chain_id,
-    arma::imat observations,
-    const int num_groups,
-    std::vector<arma::imat>& counts_per_category,
-    std::vector<arma::imat>& blume_capel_stats,
-    std::vector<arma::mat>& pairwise_stats,
-    const arma::ivec& num_categories,
-    const arma::mat& pairwise_scaling_factors,
-    const double difference_selection_alpha,
-    const double difference_selection_beta,
-    const std::string& difference_prior_type,
-    const int iter,
-    const int warmup,
-    const bool na_impute,
-    const arma::imat& missing_data_indices,
-    const arma::uvec& is_ordinal_variable,
-    const arma::ivec& baseline_category,
-    const bool difference_selection,
-    const bool main_difference_selection,
-    const arma::imat& main_effect_indices,
-    const arma::imat& pairwise_effect_indices,
-    const double target_accept,
-    const int nuts_max_depth,
-    const bool learn_mass_matrix,
-    const arma::mat& projection,
-    const arma::ivec& group_membership,
-    const arma::imat& group_indices,
-    const arma::imat& interaction_index_matrix,
-    arma::mat inclusion_probability,
-    SafeRNG& rng,
-    const UpdateMethod update_method,
-    ProgressManager& pm,
-    const BaseParameterPrior& interaction_prior,
-    const BaseParameterPrior& difference_prior,
-    const BaseParameterPrior& threshold_prior,
-    BaseEdgePrior& difference_edge_prior
-) {
-  // --- Setup: dimensions and storage structures
-  const int num_variables = observations.n_cols;
-  const int num_main = count_num_main_effects (
-    num_categories, is_ordinal_variable
-  );
-  const int num_pair = num_variables * (num_variables - 1) / 2;
-
-  // Initialize model parameter matrices
-  arma::mat main_effects(num_main, num_groups, arma::fill::zeros);
-  arma::mat pairwise_effects(num_pair, num_groups, arma::fill::zeros);
-  arma::imat inclusion_indicator(num_variables, num_variables, arma::fill::ones);
-
-  // Allocate optional storage for MCMC samples
-  arma::mat main_effect_samples(iter, num_main * num_groups);
-  arma::mat pairwise_effect_samples(iter, num_pair * num_groups);
-  arma::imat indicator_samples;
-
-  if (difference_selection) {
-    indicator_samples.set_size(iter, num_pair + num_variables);
-  }
-
-  // SBM cluster allocation samples (only populated when difference prior is SBM).
-  // Layout matches the bgm() side: (num_variables x iter), one column per draw.
-  const bool is_sbm = difference_selection &&
-                      (difference_prior_type == "Stochastic-Block");
-  arma::imat allocation_samples;
-  if (is_sbm) {
-    allocation_samples.set_size(num_variables, iter);
-  }
-
-  // For logging nuts performance
-  arma::ivec treedepth_samples(iter, arma::fill::zeros);
-  arma::ivec divergent_samples(iter, arma::fill::zeros);
-  arma::vec energy_samples(iter, arma::fill::zeros);
-  arma::vec accept_prob_samples(iter, arma::fill::zeros);
-
-  // Edge update shuffling setup
-  arma::uvec v = arma::regspace<arma::uvec>(0, num_pair - 1);
-  arma::uvec order(num_pair);
-  arma::imat index(num_pair, 3);
-
-  // --- Initialize proposal SDs
-  arma::mat proposal_sd_main(num_main, num_groups, arma::fill::ones);
-  arma::mat proposal_sd_pair(num_pair, num_groups, arma::fill::ones);
-
-  // --- Optional NUTS warmup stage
-  double initial_step_size = 1.0;
-  if (update_method == nuts) {
-    initial_step_size = find_initial_stepsize_bgmcompare(
-      main_effects, pairwise_effects, main_effect_indices,
-      pairwise_effect_indices, inclusion_indicator, projection, num_categories,
-      observations, num_groups, group_indices, counts_per_category,
-      blume_capel_stats, pairwise_stats, is_ordinal_variable,
-      baseline_category, pairwise_scaling_factors,
-      target_accept, rng,
-      interaction_prior, difference_prior, threshold_prior
-    );
-  }
-
-  // --- Warmup scheduling + adaptation controller
-  WarmupSchedule warmup_schedule(warmup, difference_selection, (update_method != adaptive_metropolis));
-
-  NUTSAdaptationController nuts_adapt(
-      (num_main + num_pair) * num_groups, initial_step_size, target_accept,
-      warmup_schedule, learn_mass_matrix
-  );
-
-  MetropolisAdaptationController metropolis_adapt_main(
-      proposal_sd_main, warmup_schedule, target_accept
-  );
-  MetropolisAdaptationController metropolis_adapt_pair(
-      proposal_sd_pair, warmup_schedule, target_accept
-  );
-
-  const int total_iter = warmup_schedule.total_warmup + iter;
-
-  // --- Main Gibbs sampling loop
-  bool userInterrupt = false;
-  for (int iteration = 0; iteration < total_iter; iteration++) {
-
-    pm.update(chain_id - 1);
-    if (pm.shouldExit()) {
-      userInterrupt = true;
-      break;
-    }
-
-    // Shuffle update order of edge indices
-    order = arma_randperm(rng, num_pair);
-    for (int i = 0; i < num_pair; i++) {
-      index.row(i) = interaction_index_matrix.row(order(i));
-    }
-
-    // Optional imputation
-    if (na_impute) {
-      impute_missing_bgmcompare (
-          main_effects, pairwise_effects, main_effect_indices,
-          pairwise_effect_indices, inclusion_indicator, projection,
-          observations, num_groups, group_membership, group_indices,
-          counts_per_category, blume_capel_stats, pairwise_stats,
-          num_categories, missing_data_indices, is_ordinal_variable,
-          baseline_category, rng
-      );
-    }
-
-    // Main Gibbs update step for parameters
-    gibbs_update_step_bgmcompare (
-        observations, num_categories, pairwise_scaling_factors, counts_per_category,
-        blume_capel_stats, inclusion_indicator,
-        pairwise_effects, main_effects, is_ordinal_variable, baseline_category,
-        iteration, pairwise_effect_indices, pairwise_stats, nuts_max_depth,
-        nuts_adapt, metropolis_adapt_main, metropolis_adapt_pair, learn_mass_matrix,
-        warmup_schedule, treedepth_samples, divergent_samples, energy_samples,
-        accept_prob_samples, main_effect_indices, projection, num_groups, group_indices,
-        rng, inclusion_probability,
-        update_method, proposal_sd_main, proposal_sd_pair, index,
-        main_difference_selection,
-        interaction_prior, difference_prior, threshold_prior
-    );
-
-    // --- Update difference probabilities under the prior (if difference selection is active)
-    if (warmup_schedule.selection_enabled(iteration)) {
-      if (difference_prior_type == "Beta-Bernoulli") {
-        // Pool pairwise + (optional) main-effect indicators into a single
-        // shared inclusion probability (legacy compare semantics).
-        int sumG = 0;
-        for (int i = 0; i < num_variables - 1; ++i) {
-          for (int j = i + 1; j < num_variables; ++j) {
-            sumG += inclusion_indicator(i, j);
-          }
-        }
-        int num_main_selectable = 0;
-        if (main_difference_selection) {
-          for(int i = 0; i < num_variables; i++) {
-            sumG += inclusion_indicator(i, i);
-          }
-          num_main_selectable = num_variables;
-        }
-        double prob = rbeta(rng,
-                            difference_selection_alpha + sumG,
-                            difference_selection_beta + num_pair + num_main_selectable - sumG);
-        std::fill(inclusion_probability.begin(), inclusion_probability.end(), prob);
-      } else if (difference_prior_type == "Stochastic-Block") {
-        // Off-diagonal (pairwise differences): MFM-SBM block-allocation +
-        // block-probability update. Mirrors the bgm() SBM path.
-        difference_edge_prior.update(
-          inclusion_indicator, inclusion_probability,
-          num_variables, num_pair, rng
-        );
-        // Diagonal (main-effect differences): independent Beta-Bernoulli
-        // conjugate update using the SBM's within-cluster (alpha, beta).
-        if (main_difference_selection) {
-          int sumD = 0;
-          for (int i = 0; i < num_variables; ++i) {
-            sumD += inclusion_indicator(i, i);
-          }
-          double prob_main = rbeta(rng,
-                                   difference_selection_alpha + sumD,
-                                   difference_selection_beta + num_variables - sumD);
-          for (int i = 0; i < num_variables; ++i) {
-            inclusion_probability(i, i) = prob_main;
-          }
-        }
-      }
-    }
-
-    // --- Store states
-    if (iteration >= warmup_schedule.total_warmup) {
-      int sample_index = iteration - warmup_schedule.total_warmup;
-
-
-      int cntr = 0;
-      for (int col = 0; col < num_groups; ++col) {
-        for (int row = 0; row < num_main; ++row) {
-          main_effect_samples(sample_index, cntr) = main_effects(row, col);
-          cntr++;
-        }
-      }
-
-      cntr = 0;
-      for (int col = 0; col < num_groups; ++col) {
-        for (int row = 0; row < num_pair; ++row) {
-          pairwise_effect_samples(sample_index, cntr) = pairwise_effects(row, col);
-          cntr++;
-        }
-      }
-
-      if (difference_selection) {
-        int cntr = 0;
-        for (int i = 0; i < num_variables; ++i) {
-          for (int j = i; j < num_variables; ++j) {
-            indicator_samples(sample_index, cntr) = inclusion_indicator(i, j);
-            cntr++;
-          }
-        }
-      }
-
-      if (is_sbm && difference_edge_prior.has_allocations()) {
-        allocation_samples.col(sample_index) =
-          difference_edge_prior.get_allocations();
-      }
-    }
-  }
-
-  bgmCompareOutput out;
-  out.chain_id = chain_id;
-  out.main_samples = main_effect_samples;
-  out.pairwise_samples = pairwise_effect_samples;
-  out.treedepth_samples = treedepth_samples;
-  out.divergent_samples = divergent_samples;
-  out.energy_samples = energy_samples;
-  out.accept_prob_samples = accept_prob_samples;
-  out.has_indicator = difference_selection;
-  if (difference_selection) {
-    out.indicator_samples = indicator_samples;
-  } else {
-    out.indicator_samples = arma::imat();
-  }
-  out.has_allocations = is_sbm;
-  if (is_sbm) {
-    out.allocation_samples = allocation_samples;
-  } else {
-    out.allocation_samples = arma::imat();
-  }
-  out.userInterrupt = userInterrupt;
-
-  return out;
-}
\ No newline at end of file
@@ -2,104 +2,296 @@
 
 /**
  * @file bgmCompare_sampler.h
- * @brief MCMC chain runner for the bgmCompare multi-group comparison model.
+ * @brief Component-wise updates for the bgmCompare multi-group comparison model.
+ *
+ * Missing-data imputation, random-walk Metropolis sweeps over main and
+ * pairwise effects, Robbins-Monro proposal-SD tuning, and Metropolis-Hastings
+ * moves on the difference indicators. BGMCompareModel calls these from its
+ * BaseModel hooks; the chain loop itself is run_mcmc_chain().
  */
 
 #include <RcppArmadillo.h>
-#include "utils/common_helpers.h"
-#include "models/bgmCompare/bgmCompare_output.h"
+#include <vector>
 #include "priors/parameter_prior.h"
-#include "priors/edge_prior.h"
-#include <string>
 
 struct SafeRNG;
-class ProgressManager;
+struct WarmupSchedule;
+class MetropolisAdaptationController;
 
 /**
- * Run a complete MCMC chain for a bgmCompare model.
+ * Impute missing observations from their full conditionals.
  *
- * Initializes parameters and adaptation controllers, loops over warmup and
- * sampling iterations (with optional missing-data imputation, difference
- * selection, and prior updates), and collects posterior samples and
- * diagnostics into a bgmCompareOutput struct.
+ * Updates the observations, the per-group sufficient statistics, and the
+ * per-group observations and residual matrices in place. Entries are
+ * processed in runs of the same group and variable, with the probabilities
+ * of a run computed together.
  *
- * @param chain_id                   Identifier for this chain
- * @param observations               Integer observation matrix (n x V)
- * @param num_groups                 Number of groups (G)
- * @param counts_per_category        Category counts per group (modified during imputation)
- * @param blume_capel_stats          Blume-Capel statistics per group (modified during imputation)
- * @param pairwise_stats             Pairwise sufficient statistics per group (modified during imputation)
- * @param num_categories             Number of categories per variable
- * @param pairwise_scaling_factors   Per-pair scaling factors for the Cauchy prior
- * @param difference_selection_alpha Alpha for difference-selection Beta-Bernoulli prior
- * @param difference_selection_beta  Beta for difference-selection Beta-Bernoulli prior
- * @param difference_prior_type      Prior family for inclusion probabilities (e.g. "Beta-Bernoulli")
- * @param iter                       Number of post-warmup iterations
- * @param warmup                     Number of warmup iterations
- * @param na_impute                  Enable missing-data imputation
- * @param missing_data_indices       (person, variable) pairs of missing entries
- * @param is_ordinal_variable        1 = ordinal, 0 = Blume-Capel
- * @param baseline_category          Reference categories for Blume-Capel variables
- * @param difference_selection       Enable group-difference indicator updates
- * @param main_difference_selection  Enable main-effect difference selection
- * @param main_effect_indices        Start/end row indices per variable (V x 2)
- * @param pairwise_effect_indices    Row index per variable pair (V x V)
- * @param target_accept              Target acceptance rate for NUTS dual averaging
- * @param nuts_max_depth             Maximum NUTS tree depth
- * @param learn_mass_matrix          Enable mass-matrix adaptation during warmup
- * @param projection                 Group contrast matrix (G x (G-1))
- * @param group_membership           Group label per observation
- * @param group_indices              Group start/end indices per group (G x 2)
- * @param interaction_index_matrix   Edge-pair index matrix
- * @param inclusion_probability      Prior inclusion probabilities (V x V)
- * @param rng                        Random number generator
- * @param update_method              Sampler type (adaptive_metropolis, nuts)
- * @param pm                         Progress manager for user feedback
- * @param interaction_prior          Prior for the baseline pairwise interaction parameters
- * @param difference_prior           Prior for the group-difference parameters
- * @param threshold_prior            Prior for the threshold (main effect) parameters
- * @param difference_edge_prior      Indicator prior for difference selection;
- *                                   for Stochastic-Block, governs off-diagonal
- *                                   (pairwise) inclusions and exposes block
- *                                   allocations via has_allocations()
- * @return bgmCompareOutput containing posterior samples and diagnostics
+ * @param main_effects             Main-effect matrix (n_main_rows x G)
+ * @param pairwise_effects         Pairwise-effect matrix (n_pair_rows x G)
+ * @param main_effect_indices      Start/end row indices per variable (V x 2)
+ * @param pairwise_effect_indices  Row index per variable pair (V x V)
+ * @param inclusion_indicator      Difference inclusion indicators (V x V)
+ * @param projection               Group contrast matrix (G x (G-1))
+ * @param[in,out] observations     Integer observation matrix (n x V)
+ * @param[in,out] observations_group  Per-group observations (see split_observations_by_group())
+ * @param[in,out] residual_matrices   Per-group residual matrices (see compute_residual_matrices())
+ * @param num_groups               Number of groups (G)
+ * @param group_membership         Group label per observation
+ * @param group_indices            Group start/end rows (G x 2)
+ * @param[in,out] counts_per_category  Category counts per group
+ * @param[in,out] blume_capel_stats    Blume-Capel statistics per group
+ * @param[in,out] pairwise_stats       Pairwise sufficient statistics per group
+ * @param num_categories           Number of categories per variable
+ * @param missing_data_indices     (person, variable) pairs of missing entries
+ * @param is_ordinal_variable      1 = ordinal, 0 = Blume-Capel
+ * @param baseline_category        Reference categories for Blume-Capel variables
+ * @param rng                      Random number generator
  */
-
-bgmCompareOutput run_gibbs_sampler_bgmCompare(
-    int chain_id,
-    arma::imat observations,
+void impute_missing_bgmcompare(
+    const arma::mat& main_effects,
+    const arma::mat& pairwise_effects,
+    const arma::imat& main_effect_indices,
+    const arma::imat& pairwise_effect_indices,
+    const arma::imat& inclusion_indicator,
+    const arma::mat& projection,
+    arma::imat& observations,
+    std::vector<arma::mat>& observations_group,
+    std::vector<arma::mat>& residual_matrices,
     const int num_groups,
+    const arma::ivec& group_membership,
+    const arma::imat& group_indices,
     std::vector<arma::imat>& counts_per_category,
     std::vector<arma::imat>& blume_capel_stats,
     std::vector<arma::mat>& pairwise_stats,
     const arma::ivec& num_categories,
-    const arma::mat& pairwise_scaling_factors,
-    const double difference_selection_alpha,
-    const double difference_selection_beta,
-    const std::string& difference_prior_type,
-    const int iter,
-    const int warmup,
-    const bool na_impute,
     const arma::imat& missing_data_indices,
     const arma::uvec& is_ordinal_variable,
     const arma::ivec& baseline_category,
-    const bool difference_selection,
-    const bool main_difference_selection,
+    SafeRNG& rng
+);
+
+/**
+ * One random-walk Metropolis sweep over the main effects.
+ *
+ * Updates the baseline column and, for variables with active differences,
+ * the group-difference columns. Feeds the acceptance probabilities to
+ * `metropolis_adapt`.
+ *
+ * @param[in,out] main_effects     Main-effect matrix (n_main_rows x G)
+ * @param main_effect_indices      Start/end row indices per variable (V x 2)
+ * @param inclusion_indicator      Difference inclusion indicators (V x V)
+ * @param projection               Group contrast matrix (G x (G-1))
+ * @param num_categories           Number of categories per variable
+ * @param num_groups               Number of groups (G)
+ * @param residual_matrices        Per-group residual matrices (n_g x V)
+ * @param counts_per_category      Category counts per group
+ * @param blume_capel_stats        Blume-Capel statistics per group
+ * @param is_ordinal_variable      1 = ordinal, 0 = Blume-Capel
+ * @param baseline_category        Reference categories for Blume-Capel variables
+ * @param iteration                Current iteration (for adaptation)
+ * @param metropolis_adapt         Proposal-SD adaptation controller
+ * @param rng                      Random number generator
+ * @param[in,out] proposal_sd_main Proposal SDs (same shape as main_effects)
+ * @param difference_prior         Prior on the group differences
+ * @param threshold_prior          Prior on the baseline main effects
+ * @param[in,out] accept_prob_sum  Incremented by each acceptance probability
+ * @param[in,out] num_updated      Incremented by the number of updates
+ */
+void update_main_effects_metropolis_bgmcompare(
+    arma::mat& main_effects,
+    const arma::imat& main_effect_indices,
+    const arma::imat& inclusion_indicator,
+    const arma::mat& projection,
+    const arma::ivec& num_categories,
+    const int num_groups,
+    const std::vector<arma::mat>& residual_matrices,
+    const std::vector<arma::imat>& counts_per_category,
+    const std::vector<arma::imat>& blume_capel_stats,
+    const arma::uvec& is_ordinal_variable,
+    const arma::ivec& baseline_category,
+    const int iteration,
+    MetropolisAdaptationController& metropolis_adapt,
+    SafeRNG& rng,
+    arma::mat& proposal_sd_main,
+    const BaseParameterPrior& difference_prior,
+    const BaseParameterPrior& threshold_prior,
+    double& accept_prob_sum,
+    int& num_updated
+);
+
+/**
+ * One random-walk Metropolis sweep over the pairwise effects.
+ *
+ * Updates the baseline column and, for pairs with active differences, the
+ * group-difference columns. Feeds the acceptance probabilities to
+ * `metropolis_adapt`.
+ *
+ * @param main_effects             Main-effect matrix (n_main_rows x G)
+ * @param[in,out] pairwise_effects Pairwise-effect matrix (n_pair_rows x G)
+ * @param main_effect_indices      Start/end row indices per variable (V x 2)
+ * @param pairwise_effect_indices  Row index per variable pair (V x V)
+ * @param inclusion_indicator      Difference inclusion indicators (V x V)
+ * @param projection               Group contrast matrix (G x (G-1))
+ * @param num_categories           Number of categories per variable
+ * @param observations_group       Per-group observations as double (n_g x V)
+ * @param num_groups               Number of groups (G)
+ * @param[in,out] residual_matrices  Per-group residual matrices (n_g x V),
+ *                                 kept current on acceptance
+ * @param pairwise_stats           Pairwise sufficient statistics per group
+ * @param is_ordinal_variable      1 = ordinal, 0 = Blume-Capel
+ * @param baseline_category        Reference categories for Blume-Capel variables
+ * @param pairwise_scaling_factors Per-pair scaling factors for the interaction prior
+ * @param iteration                Current iteration (for adaptation)
+ * @param metropolis_adapt         Proposal-SD adaptation controller
+ * @param rng                      Random number generator
+ * @param[in,out] proposal_sd_pair Proposal SDs (same shape as pairwise_effects)
+ * @param interaction_prior        Prior on the baseline interactions
+ * @param difference_prior         Prior on the group differences
+ * @param[in,out] accept_prob_sum  Incremented by each acceptance probability
+ * @param[in,out] num_updated      Incremented by the number of updates
+ */
+void update_pairwise_effects_metropolis_bgmcompare(
+    arma::mat& main_effects,
+    arma::mat& pairwise_effects,
     const arma::imat& main_effect_indices,
     const arma::imat& pairwise_effect_indices,
-    const double target_accept,
-    const int nuts_max_depth,
-    const bool learn_mass_matrix,
+    const arma::imat& inclusion_indicator,
     const arma::mat& projection,
-    const arma::ivec& group_membership,
-    const arma::imat& group_indices,
-    const arma::imat& interaction_index_matrix,
-    arma::mat inclusion_probability,
+    const arma::ivec& num_categories,
+    const std::vector<arma::mat>& observations_group,
+    const int num_groups,
+    std::vector<arma::mat>& residual_matrices,
+    const std::vector<arma::mat>& pairwise_stats,
+    const arma::uvec& is_ordinal_variable,
+    const arma::ivec& baseline_category,
+    const arma::mat& pairwise_scaling_factors,
+    const int iteration,
+    MetropolisAdaptationController& metropolis_adapt,
+    SafeRNG& rng,
+    arma::mat& proposal_sd_pair,
+    const BaseParameterPrior& interaction_prior,
+    const BaseParameterPrior& difference_prior,
+    double& accept_prob_sum,
+    int& num_updated
+);
+
+/**
+ * Robbins-Monro proposal-SD tuning for main and pairwise effects.
+ *
+ * A no-op outside the schedule's proposal-SD adaptation window (Stage 3b).
+ * Each tuned parameter also takes one Metropolis step.
+ *
+ * @param[in,out] proposal_sd_main_effects      Main-effect proposal SDs
+ * @param[in,out] proposal_sd_pairwise_effects  Pairwise-effect proposal SDs
+ * @param[in,out] main_effects     Main-effect matrix (n_main_rows x G)
+ * @param[in,out] pairwise_effects Pairwise-effect matrix (n_pair_rows x G)
+ * @param main_effect_indices      Start/end row indices per variable (V x 2)
+ * @param pairwise_effect_indices  Row index per variable pair (V x V)
+ * @param inclusion_indicator      Difference inclusion indicators (V x V)
+ * @param projection               Group contrast matrix (G x (G-1))
+ * @param num_categories           Number of categories per variable
+ * @param observations_group       Per-group observations as double (n_g x V)
+ * @param num_groups               Number of groups (G)
+ * @param[in,out] residual_matrices  Per-group residual matrices (n_g x V),
+ *                                 kept current on acceptance
+ * @param counts_per_category      Category counts per group
+ * @param blume_capel_stats        Blume-Capel statistics per group
+ * @param pairwise_stats           Pairwise sufficient statistics per group
+ * @param is_ordinal_variable      1 = ordinal, 0 = Blume-Capel
+ * @param baseline_category        Reference categories for Blume-Capel variables
+ * @param pairwise_scaling_factors Per-pair scaling factors for the interaction prior
+ * @param iteration                Current iteration
+ * @param rng                      Random number generator
+ * @param sched                    Warmup schedule
+ * @param interaction_prior        Prior on the baseline interactions
+ * @param difference_prior         Prior on the group differences
+ * @param threshold_prior          Prior on the baseline main effects
+ * @param target_accept            Target acceptance probability
+ * @param rm_decay                 Robbins-Monro decay rate
+ */
+void tune_proposal_sd_bgmcompare(
+    arma::mat& proposal_sd_main_effects,
+    arma::mat& proposal_sd_pairwise_effects,
+    arma::mat& main_effects,
+    arma::mat& pairwise_effects,
+    const arma::imat& main_effect_indices,
+    const arma::imat& pairwise_effect_indices,
+    const arma::imat& inclusion_indicator,
+    const arma::mat& projection,
+    const arma::ivec& num_categories,
+    const std::vector<arma::mat>& observations_group,
+    int num_groups,
+    std::vector<arma::mat>& residual_matrices,
+    const std::vector<arma::imat>& counts_per_category,
+    const std::vector<arma::imat>& blume_capel_stats,
+    const std::vector<arma::mat>& pairwise_stats,
+    const arma::uvec& is_ordinal_variable,
+    const arma::ivec& baseline_category,
+    const arma::mat& pairwise_scaling_factors,
+    int iteration,
     SafeRNG& rng,
-    const UpdateMethod update_method,
-    ProgressManager& pm,
+    const WarmupSchedule& sched,
     const BaseParameterPrior& interaction_prior,
     const BaseParameterPrior& difference_prior,
     const BaseParameterPrior& threshold_prior,
-    BaseEdgePrior& difference_edge_prior
-);
\ No newline at end of file
+    double target_accept = 0.44,
+    double rm_decay = 0.75
+);
+
+/**
+ * Metropolis-Hastings add/delete moves on the difference indicators.
+ *
+ * Main-effect differences (diagonal) are toggled only with
+ * `main_difference_selection`; pairwise differences are visited in the
+ * order of the rows of `index`.
+ *
+ * @param inclusion_probability_difference  Prior inclusion probabilities (V x V)
+ * @param index                    Shuffled pair table (num_pair x 3)
+ * @param[in,out] main_effects     Main-effect matrix (n_main_rows x G)
+ * @param[in,out] pairwise_effects Pairwise-effect matrix (n_pair_rows x G)
+ * @param main_effect_indices      Start/end row indices per variable (V x 2)
+ * @param pairwise_effect_indices  Row index per variable pair (V x V)
+ * @param projection               Group contrast matrix (G x (G-1))
+ * @param observations_group       Per-group observations as double (n_g x V)
+ * @param num_groups               Number of groups (G)
+ * @param[in,out] residual_matrices  Per-group residual matrices (n_g x V),
+ *                                 kept current on acceptance
+ * @param num_categories           Number of categories per variable
+ * @param[in,out] inclusion_indicator  Difference inclusion indicators (V x V)
+ * @param is_ordinal_variable      1 = ordinal, 0 = Blume-Capel
+ * @param baseline_category        Reference categories for Blume-Capel variables
+ * @param proposal_sd_main         Main-effect proposal SDs
+ * @param pairwise_scaling_factors Per-pair scaling factors for the difference prior
+ * @param proposal_sd_pairwise     Pairwise-effect proposal SDs
+ * @param counts_per_category      Category counts per group
+ * @param blume_capel_stats        Blume-Capel statistics per group
+ * @param pairwise_stats           Pairwise sufficient statistics per group
+ * @param main_difference_selection  Also toggle main-effect differences
+ * @param rng                      Random number generator
+ * @param difference_prior         Prior on the group differences
+ */
+void update_indicator_differences_metropolis_bgmcompare(
+    const arma::mat& inclusion_probability_difference,
+    const arma::imat& index,
+    arma::mat& main_effects,
+    arma::mat& pairwise_effects,
+    const arma::imat& main_effect_indices,
+    const arma::imat& pairwise_effect_indices,
+    const arma::mat& projection,
+    const std::vector<arma::mat>& observations_group,
+    const int num_groups,
+    std::vector<arma::mat>& residual_matrices,
+    const arma::imat& num_categories,
+    arma::imat& inclusion_indicator,
+    const arma::uvec& is_ordinal_variable,
+    const arma::ivec& baseline_category,
+    const arma::mat& proposal_sd_main,
+    const arma::mat& pairwise_scaling_factors,
+    const arma::mat& proposal_sd_pairwise,
+    const std::vector<arma::imat>& counts_per_category,
+    const std::vector<arma::imat>& blume_capel_stats,
+    const std::vector<arma::mat>& pairwise_stats,
+    const bool main_difference_selection,
+    SafeRNG& rng,
+    const BaseParameterPrior& difference_prior
+);
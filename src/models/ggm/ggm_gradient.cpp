@@ -23,6 +23,17 @@ void GGMGradientEngine::rebuild(
     interaction_prior_ = &interaction_prior;
     diagonal_prior_ = &diagonal_prior;
     delta_ = determinant_tilt;
+
+    // Size the workspace containers; the per-column matrices take their
+    // shape on first use and keep it while the graph does.
+    fm_.Nq.resize(p_);
+    fm_.R_diag.resize(p_);
+    fm_.givens_rotations.resize(p_);
+    fm_.Q_full.resize(p_);
+    fm_.R_full.resize(p_);
+    P_.set_size(p_, p_);
+    Phi_bar_.set_size(p_, p_);
+    adjoint_scratch_.resize(4 * p_ * p_);
 }
 
 // =====================================================================
@@ -49,6 +60,21 @@ void GGMGradientEngine::build_Aq(
     }
 }
 
+void GGMGradientEngine::build_AqT(
+    const arma::mat& Phi,
+    const ColumnConstraints& col,
+    size_t q,
+    arma::mat& AqT)
+{
+    AqT.zeros(q, col.m_q);
+    for (size_t r = 0; r < col.m_q; ++r) {
+        size_t i = col.excluded_indices[r];
+        for (size_t l = 0; l <= i; ++l) {
+            AqT(l, r) = Phi(l, i);
+        }
+    }
+}
+
 // =====================================================================
 // givens_qr
 // =====================================================================
@@ -64,6 +90,12 @@ void GGMGradientEngine::build_Aq(
 //   G = [[c, s], [-s, c]]  applied to rows (r1, r2) of W from the left.
 //   Q accumulates G^T on columns.
 // R diagonal entries are always positive by construction.
+//
+// A_q^T has the staircase pattern of the excluded rows: column r is zero
+// below row excluded_indices[r], and the rotations of earlier columns never
+// fill it in. Each column therefore starts its sweep just below its last
+// nonzero pair; the rotations skipped that way act on two exact zeros and
+// would have been skipped anyway, so the factorization is unchanged.
 
 void GGMGradientEngine::givens_qr(
     const arma::mat& M,
@@ -72,15 +104,28 @@ void GGMGradientEngine::givens_qr(
     arma::vec& R_diag,
     std::vector<GivensRotation>& rots)
 {
-    size_t n = M.n_rows;
-    size_t m = M.n_cols;
     R = M;            // working copy, will become R
+    givens_qr_inplace(R, Q, R_diag, rots);
+}
+
+void GGMGradientEngine::givens_qr_inplace(
+    arma::mat& R,
+    arma::mat& Q,
+    arma::vec& R_diag,
+    std::vector<GivensRotation>& rots)
+{
+    size_t n = R.n_rows;
+    size_t m = R.n_cols;
     Q.eye(n, n);      // accumulate Q
-    rots.clear();
+    rots.clear();     // keeps its capacity
 
     for (size_t j = 0; j < m; ++j) {
         if (j + 1 < n) {
-            for (size_t i = n - 1; i > j; --i) {
+            size_t start = n - 1;
+            while (start > j + 1 && R(start, j) == 0.0 && R(start - 1, j) == 0.0) {
+                --start;
+            }
+            for (size_t i = start; i > j; --i) {
                 size_t r1 = i - 1;
                 size_t r2 = i;
                 double a = R(r1, j);
@@ -124,6 +169,17 @@ void GGMGradientEngine::givens_qr(
 
 ForwardMapResult GGMGradientEngine::forward_map(const arma::vec& theta) const {
     ForwardMapResult result;
+    forward_map_into(theta, result);
+    return result;
+}
+
+const ForwardMapResult& GGMGradientEngine::forward_map_workspace(const arma::vec& theta) const {
+    forward_map_into(theta, fm_);
+    return fm_;
+}
+
+void GGMGradientEngine::forward_map_into(const arma::vec& theta,
+                                         ForwardMapResult& result) const {
     result.Phi.zeros(p_, p_);
     result.psi.set_size(p_);
     result.Nq.resize(p_);
@@ -132,8 +188,6 @@ ForwardMapResult GGMGradientEngine::forward_map(const arma::vec& theta) const {
     result.Q_full.resize(p_);
     result.R_full.resize(p_);
 
-    arma::mat Aq_buf;  // reusable buffer for A_q
-
     for (size_t q = 0; q < p_; ++q) {
         const auto& col = structure_->columns[q];
         size_t offset = structure_->theta_offsets[q];
@@ -146,12 +200,7 @@ ForwardMapResult GGMGradientEngine::forward_map(const arma::vec& theta) const {
             continue;
         }
 
-        // Extract f_q from theta
         size_t d_q = col.d_q;
-        arma::vec f_q;
-        if (d_q > 0) {
-            f_q = theta.subvec(offset, offset + d_q - 1);
-        }
 
         // psi_q is after f_q
         double psi_q = theta(offset + d_q);
@@ -163,38 +212,34 @@ ForwardMapResult GGMGradientEngine::forward_map(const arma::vec& theta) const {
 
         if (m_q == 0 && d_q == q) {
             // No constraints: x_q = f_q directly (N_q = I)
-            result.Nq[q] = arma::eye(q, q);
+            result.Nq[q].eye(q, q);
             result.R_diag[q].reset();
             result.givens_rotations[q].clear();
             for (size_t k = 0; k < d_q; ++k) {
-                result.Phi(k, q) = f_q(k);
+                result.Phi(k, q) = theta(offset + k);
             }
         } else if (d_q == 0) {
             // Fully constrained: x_q = 0
             // Givens QR for R_diag (Jacobian) and stored rotations
             if (m_q > 0) {
-                build_Aq(result.Phi, col, q, Aq_buf);
-                givens_qr(Aq_buf.t(),
-                          result.Q_full[q], result.R_full[q],
-                          result.R_diag[q], result.givens_rotations[q]);
+                build_AqT(result.Phi, col, q, result.R_full[q]);
+                givens_qr_inplace(result.R_full[q], result.Q_full[q],
+                                  result.R_diag[q], result.givens_rotations[q]);
             }
             result.Nq[q].reset();
             // x_q stays zero (already zeroed)
         } else {
             // General case: build A_q, Givens QR, null space
-            build_Aq(result.Phi, col, q, Aq_buf);
-            givens_qr(Aq_buf.t(),
-                      result.Q_full[q], result.R_full[q],
-                      result.R_diag[q], result.givens_rotations[q]);
+            build_AqT(result.Phi, col, q, result.R_full[q]);
+            givens_qr_inplace(result.R_full[q], result.Q_full[q],
+                              result.R_diag[q], result.givens_rotations[q]);
 
             // N_q = last d_q columns of Q
             result.Nq[q] = result.Q_full[q].cols(m_q, q - 1);
 
-            // x_q = N_q f_q
-            arma::vec x_q = result.Nq[q] * f_q;
-            for (size_t k = 0; k < q; ++k) {
-                result.Phi(k, q) = x_q(k);
-            }
+            // x_q = N_q f_q, written straight into column q of Phi
+            arma::vec x_q(result.Phi.colptr(q), q, false, true);
+            x_q = result.Nq[q] * theta.subvec(offset, offset + d_q - 1);
         }
     }
 
@@ -217,8 +262,43 @@ ForwardMapResult GGMGradientEngine::forward_map(const arma::vec& theta) const {
 
     // K = Phi^T Phi
     result.K = result.Phi.t() * result.Phi;
+}
 
-    return result;
+// =====================================================================
+// theta_from_phi
+// =====================================================================
+
+void GGMGradientEngine::theta_from_phi(
+    const GraphConstraintStructure& structure,
+    const arma::mat& Phi,
+    arma::vec& theta) const
+{
+    const size_t p = structure.p;
+    theta.set_size(structure.active_dim);
+    fm_.R_diag.resize(p);
+    fm_.givens_rotations.resize(p);
+    fm_.Q_full.resize(p);
+    fm_.R_full.resize(p);
+
+    for (size_t q = 0; q < p; ++q) {
+        const auto& col = structure.columns[q];
+        size_t offset = structure.theta_offsets[q];
+
+        // psi_q = log(phi_qq)
+        theta(offset + col.d_q) = std::log(Phi(q, q));
+
+        if (q == 0 || col.d_q == 0) continue;
+
+        // f_q = N_q^T x_q with N_q the last d_q columns of Q from the
+        // Givens QR of A_q^T
+        build_AqT(Phi, col, q, fm_.R_full[q]);
+        givens_qr_inplace(fm_.R_full[q], fm_.Q_full[q],
+                          fm_.R_diag[q], fm_.givens_rotations[q]);
+        const arma::mat Nq(fm_.Q_full[q].colptr(col.m_q), q, col.d_q, false, true);
+        const arma::vec x_q(const_cast<double*>(Phi.colptr(q)), q, false, true);
+        arma::vec f_q(theta.memptr() + offset, col.d_q, false, true);
+        f_q = Nq.t() * x_q;
+    }
 }
 
 // =====================================================================
@@ -245,7 +325,7 @@ std::pair<double, arma::vec> GGMGradientEngine::logp_and_gradient(
     const arma::vec& theta) const
 {
     // --- Forward pass: theta -> Phi, K via null-space constraints ---
-    ForwardMapResult fm = forward_map(theta);
+    const ForwardMapResult& fm = forward_map_workspace(theta);
     const arma::mat& Phi = fm.Phi;
     const arma::mat& K = fm.K;
     const arma::mat& S = *suf_stat_;
@@ -262,7 +342,8 @@ std::pair<double, arma::vec> GGMGradientEngine::logp_and_gradient(
     // P = Phi * S — reused for value and gradient.
     // Phi is upper triangular; trimatu dispatches to BLAS dtrmm,
     // halving the FLOP count vs dense gemm.
-    arma::mat P = arma::trimatu(Phi) * S;
+    P_ = arma::trimatu(Phi) * S;
+    const arma::mat& P = P_;
 
     // --- Log-posterior value ---
     double log_det_K = 2.0 * arma::accu(fm.psi);
@@ -304,7 +385,8 @@ std::pair<double, arma::vec> GGMGradientEngine::logp_and_gradient(
     // Diagonal prior: d/dPhi [log p(K_ii/2)]
     //   = (1/2) * grad(K_ii/2) * dK_ii/dPhi
     //   = (1/2) * grad(K_ii/2) * 2 Phi(:,i) = grad(K_ii/2) * Phi(:,i).
-    arma::mat Phi_bar = -P;
+    arma::mat& Phi_bar = Phi_bar_;
+    Phi_bar = -P;
     for (size_t i = 0; i < p_; ++i) {
         double dg = diagonal_prior_->grad(0.5 * K(i, i));
         Phi_bar.col(i).head(i + 1) += dg * Phi.col(i).head(i + 1);
@@ -348,14 +430,14 @@ std::pair<double, arma::vec> GGMGradientEngine::logp_and_gradient(
         if (q == 0) continue;
 
         // --- f_q gradient via N_q ---
-        arma::vec x_bar = Phi_bar.col(q).head(q);
+        // Column q of Phi_bar is final here: the cross-column adjoint
+        // below only adds to columns i < q.
+        const arma::vec x_bar(Phi_bar.colptr(q), q, false, true);
 
         if (d_q > 0) {
             const arma::mat& Nq = fm.Nq[q];
-            arma::vec f_bar = Nq.t() * x_bar;
-            for (size_t k = 0; k < d_q; ++k) {
-                gradient(offset + k) = f_bar(k);
-            }
+            arma::vec f_bar(gradient.memptr() + offset, d_q, false, true);
+            f_bar = Nq.t() * x_bar;
         }
 
         // --- Cross-column adjoint (reverse-Givens) ---
@@ -365,9 +447,15 @@ std::pair<double, arma::vec> GGMGradientEngine::logp_and_gradient(
         const auto& rotations = fm.givens_rotations[q];
         size_t n_rot = rotations.size();
 
-        // Initialize W_bar (R_bar) and Q_bar with seed adjoints.
-        arma::mat W_bar(q, m_q, arma::fill::zeros);
-        arma::mat Q_bar(q, q, arma::fill::zeros);
+        // Initialize W_bar (R_bar) and Q_bar with seed adjoints. All four
+        // reverse-pass matrices live in adjoint_scratch_.
+        double* scratch = adjoint_scratch_.data();
+        arma::mat W_bar(scratch, q, m_q, false, true);
+        arma::mat Q_bar(scratch + p_ * p_, q, q, false, true);
+        arma::mat W_work(scratch + 2 * p_ * p_, q, m_q, false, true);
+        arma::mat Q_work(scratch + 3 * p_ * p_, q, q, false, true);
+        W_bar.zeros();
+        Q_bar.zeros();
 
         size_t rank = std::min(m_q, q);
         const arma::mat& R = fm.R_full[q];
@@ -376,16 +464,16 @@ std::pair<double, arma::vec> GGMGradientEngine::logp_and_gradient(
         }
 
         if (d_q > 0) {
-            arma::vec f_q = theta.subvec(offset, offset + d_q - 1);
             for (size_t k = 0; k < d_q; ++k) {
+                const double f_qk = theta(offset + k);
                 for (size_t l = 0; l < q; ++l) {
-                    Q_bar(l, m_q + k) = x_bar(l) * f_q(k);
+                    Q_bar(l, m_q + k) = x_bar(l) * f_qk;
                 }
             }
         }
 
-        arma::mat Q_work = fm.Q_full[q];
-        arma::mat W_work = fm.R_full[q];
+        Q_work = fm.Q_full[q];
+        W_work = fm.R_full[q];
 
         for (size_t k = n_rot; k-- > 0; ) {
             const auto& rot = rotations[k];
@@ -57,8 +57,12 @@ struct ForwardMapResult {
  * reverse-mode differentiation through stored Givens rotations,
  * giving an exact analytic gradient for all constraint dimensions.
  *
- * To avoid per-leapfrog-step allocation, all workspace matrices are
- * pre-allocated and reused. Call rebuild() when the graph changes.
+ * To avoid per-leapfrog-step allocation, the engine owns a persistent
+ * workspace: the per-column Q, R, N_q and rotation buffers of the forward
+ * map and the reverse-Givens scratch of the backward pass keep their size
+ * (and memory) for as long as the graph is unchanged, so a leapfrog step
+ * only writes into them. Call rebuild() when the graph changes; buffers
+ * whose shape the new graph keeps are reused as they are.
  */
 class GGMGradientEngine {
 public:
@@ -95,6 +99,28 @@ public:
      */
     ForwardMapResult forward_map(const arma::vec& theta) const;
 
+    /**
+     * Forward map into the engine's workspace.
+     *
+     * Same result as forward_map(), without allocating once the workspace
+     * has its shape. The reference stays valid until the next call of
+     * forward_map_workspace(), logp_and_gradient() or theta_from_phi().
+     */
+    const ForwardMapResult& forward_map_workspace(const arma::vec& theta) const;
+
+    /**
+     * Inverse map: theta of an upper-triangular Cholesky factor Phi that
+     * satisfies the graph constraints (psi_q = log phi_qq, f_q = N_q' x_q).
+     * Uses the engine's workspace for the per-column Givens QR.
+     *
+     * @param structure  Constraint structure of Phi's graph
+     * @param Phi        Upper-triangular Cholesky factor (p x p)
+     * @param theta      Output: active theta vector
+     */
+    void theta_from_phi(const GraphConstraintStructure& structure,
+                        const arma::mat& Phi,
+                        arma::vec& theta) const;
+
     /**
      * Combined log-posterior and gradient evaluation.
      *
@@ -126,11 +152,28 @@ public:
         arma::vec& R_diag,
         std::vector<GivensRotation>& rots);
 
+    /**
+     * givens_qr() on R in place: R holds M on entry and the R factor on
+     * exit. Q, R_diag and rots are written into their existing memory when
+     * their sizes match.
+     */
+    static void givens_qr_inplace(
+        arma::mat& R,
+        arma::mat& Q,
+        arma::vec& R_diag,
+        std::vector<GivensRotation>& rots);
+
     static void build_Aq(const arma::mat& Phi,
                          const ColumnConstraints& col,
                          size_t q,
                          arma::mat& Aq);
 
+    /// A_q^T (q x m_q) written directly, as taken by givens_qr_inplace().
+    static void build_AqT(const arma::mat& Phi,
+                          const ColumnConstraints& col,
+                          size_t q,
+                          arma::mat& AqT);
+
 private:
     const GraphConstraintStructure* structure_ = nullptr;
     size_t n_ = 0;
@@ -141,4 +184,16 @@ private:
     // Determinant-tilt exponent: adds delta_ * log|K| to the (unnormalised)
     // log-prior. delta_ = 0 recovers the untilted target.
     double delta_ = 0.0;
+
+    /// Fill `result`, reusing its buffers.
+    void forward_map_into(const arma::vec& theta, ForwardMapResult& result) const;
+
+    // Persistent workspace (see class comment). Mutable because the
+    // evaluation entry points are const; each engine belongs to one chain.
+    mutable ForwardMapResult fm_;
+    /// P = Phi S and the Phi adjoint of the backward pass (p x p).
+    mutable arma::mat P_, Phi_bar_;
+    /// Backing memory for the per-column W_bar, Q_bar, W_work and Q_work
+    /// matrices of the reverse-Givens pass, each at most p x p.
+    mutable std::vector<double> adjoint_scratch_;
 };
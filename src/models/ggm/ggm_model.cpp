@@ -1,9 +1,16 @@
+#include <cmath>
+#include <limits>
+#include <vector>
 #include "models/ggm/ggm_model.h"
 #include "rng/rng_utils.h"
 #include "math/explog_macros.h"
 #include "math/cholupdate.h"
+#include "mcmc/execution/chain_profile.h"
+#include "mcmc/execution/sampler_state.h"
 #include "mcmc/execution/step_result.h"
 #include "mcmc/execution/warmup_schedule.h"
+#include "utils/r_matrix_view.h"
+#include "mrf_simulation.h"
 
 // =====================================================================
 // NUTS gradient support
@@ -20,39 +27,10 @@ void GGMModel::ensure_constraint_structure() {
 void GGMModel::recompute_theta() const {
     if (theta_valid_) return;
 
-    // Build constraint structure (const-safe: structure is already built
-    // by ensure_constraint_structure before any gradient call)
-    const auto& cs = constraint_structure_;
-    theta_.set_size(cs.active_dim);
-
-    arma::mat Aq_buf;
-
-    for (size_t q = 0; q < p_; ++q) {
-        const auto& col = cs.columns[q];
-        size_t offset = cs.theta_offsets[q];
-
-        // psi_q = log(phi_qq)
-        double psi_q = std::log(cholesky_of_precision_(q, q));
-        theta_(offset + col.d_q) = psi_q;
-
-        if (q == 0 || col.d_q == 0) continue;
-
-        // Build A_q, compute null-space basis N_q via Givens QR
-        arma::mat Q_tmp, R_tmp;
-        arma::vec R_diag;
-        std::vector<GivensRotation> rots_tmp;
-        GGMGradientEngine::build_Aq(cholesky_of_precision_, col, q, Aq_buf);
-        GGMGradientEngine::givens_qr(Aq_buf.t(), Q_tmp, R_tmp, R_diag, rots_tmp);
-        arma::mat Nq = Q_tmp.cols(col.m_q, q - 1);
-
-        // f_q = N_q^T x_q
-        arma::vec x_q = cholesky_of_precision_.col(q).head(q);
-        arma::vec f_q = Nq.t() * x_q;
-
-        for (size_t k = 0; k < col.d_q; ++k) {
-            theta_(offset + k) = f_q(k);
-        }
-    }
+    // Constraint structure is already built by ensure_constraint_structure
+    // before any caller gets here; the engine's workspace holds the
+    // per-column Givens QR.
+    gradient_engine_.theta_from_phi(constraint_structure_, cholesky_of_precision_, theta_);
 
     theta_valid_ = true;
 }
@@ -70,6 +48,9 @@ size_t GGMModel::full_parameter_dimension() const {
 }
 
 arma::vec GGMModel::get_vectorized_parameters() const {
+    // theta comes from the dense factor; const_cast is safe for the same
+    // reason as below, it only refreshes caches of K
+    const_cast<GGMModel*>(this)->leave_sparse_mode();
     // Ensure the constraint structure is built so we can compute theta
     if (constraint_dirty_) {
         // const_cast is safe: ensure_constraint_structure only modifies
@@ -81,6 +62,7 @@ arma::vec GGMModel::get_vectorized_parameters() const {
 }
 
 arma::vec GGMModel::get_full_vectorized_parameters() const {
+    const_cast<GGMModel*>(this)->leave_sparse_mode();
     if (constraint_dirty_) {
         const_cast<GGMModel*>(this)->ensure_constraint_structure();
     }
@@ -102,9 +84,12 @@ void GGMModel::set_vectorized_parameters(const arma::vec& parameters) {
     ensure_constraint_structure();
 
     // Run forward map: theta -> Phi -> K
-    ForwardMapResult fm = gradient_engine_.forward_map(parameters);
+    const ForwardMapResult& fm = gradient_engine_.forward_map_workspace(parameters);
 
-    // Update internal state
+    // Update internal state; the sparse factor, if any, is refactored at
+    // the next sweep
+    sparse_active_ = false;
+    sparse_pattern_stale_ = true;
     precision_matrix_ = fm.K;
     cholesky_of_precision_ = fm.Phi;
     bool ok = arma::solve(inv_cholesky_of_precision_, arma::trimatu(cholesky_of_precision_),
@@ -123,6 +108,7 @@ void GGMModel::set_vectorized_parameters(const arma::vec& parameters) {
 std::pair<double, arma::vec> GGMModel::logp_and_gradient(
     const arma::vec& parameters)
 {
+    BGMS_PROFILE_SCOPE(Gradient);
     ensure_constraint_structure();
     return gradient_engine_.logp_and_gradient(parameters);
 }
@@ -161,8 +147,29 @@ arma::vec GGMModel::get_active_inv_mass() const {
 }
 
 
+arma::uvec GGMModel::get_active_parameter_indices() const {
+    if (constraint_dirty_) {
+        const_cast<GGMModel*>(this)->ensure_constraint_structure();
+    }
+
+    const auto& cs = constraint_structure_;
+    arma::uvec indices(cs.active_dim);
+    cs.for_each_active_full_pair([&](size_t active_idx, size_t full_idx) {
+        indices(active_idx) = full_idx;
+    });
+    return indices;
+}
+
+
 void GGMModel::get_constants(size_t i, size_t j) {
     // GGM stores K directly, so the precision entries are precision_matrix_.
+    if (sparse_active_) {
+        sparse_factor_.inverse_entries(i, j, sigma_ii_, sigma_ij_, sigma_jj_);
+        constants_ = cholesky_helpers::precision_proposal_constants(
+            sigma_ii_, sigma_ij_, sigma_jj_,
+            precision_matrix_(i, j), precision_matrix_(j, j));
+        return;
+    }
     constants_ = cholesky_helpers::precision_proposal_constants(
         cholesky_of_precision_, covariance_matrix_, i, j,
         precision_matrix_(i, j), precision_matrix_(j, j));
@@ -190,6 +197,14 @@ double GGMModel::log_det_ratio_edge(size_t i, size_t j) const {
     // Rank-2 matrix-determinant lemma: log|K_prop| - log|K_curr| where K_prop
     // differs from K_curr at entries (i,j), (j,i), and (j,j). GGM stores K
     // directly, so the precision scalars are precision_matrix_ entries.
+    // In sparse mode the covariance entries are those get_constants(i, j)
+    // computed.
+    if (sparse_active_) {
+        return cholesky_helpers::log_det_ratio_edge_kernel(
+            sigma_ii_, sigma_ij_, sigma_jj_,
+            precision_matrix_(i, j), precision_proposal_(i, j),
+            precision_matrix_(j, j), precision_proposal_(j, j));
+    }
     return cholesky_helpers::log_det_ratio_edge_kernel(
         covariance_matrix_, i, j,
         precision_matrix_(i, j), precision_proposal_(i, j),
@@ -197,6 +212,10 @@ double GGMModel::log_det_ratio_edge(size_t i, size_t j) const {
 }
 
 double GGMModel::log_det_ratio_diag(size_t j) const {
+    if (sparse_active_) {
+        return cholesky_helpers::log_det_ratio_diag_kernel(
+            sigma_jj_, precision_matrix_(j, j), precision_proposal_(j, j));
+    }
     return cholesky_helpers::log_det_ratio_diag_kernel(
         covariance_matrix_, j,
         precision_matrix_(j, j), precision_proposal_(j, j));
@@ -230,8 +249,7 @@ double GGMModel::ggm_edge_move(size_t i, size_t j) {
     double omega_prop_q1q = constants_[2] + constants_[3] * phi_prop;
     double omega_prop_qq  = constrained_diagonal(omega_prop_q1q);
 
-    // form full proposal matrix for Omega
-    precision_proposal_ = precision_matrix_;
+    // Only the changed entries of the proposal are read downstream
     precision_proposal_(i, j) = omega_prop_q1q;
     precision_proposal_(j, i) = omega_prop_q1q;
     precision_proposal_(j, j) = omega_prop_qq;
@@ -283,6 +301,24 @@ void GGMModel::cholesky_update_after_edge(double omega_ij_old, double omega_jj_o
     v2_[0] = omega_ij_old - precision_proposal_(i, j);
     v2_[1] = (omega_jj_old - precision_proposal_(j, j)) / 2;
 
+    if (sparse_active_) {
+        // An entry new to the pattern of L needs a symbolic re-analysis;
+        // otherwise the same update and downdate as below, on the sparse
+        // factor
+        if (!sparse_factor_.contains(i, j)) {
+            sparse_factor_.insert(i, j);
+            sparse_pattern_stale_ = true;
+            refactor_sparse();
+            return;
+        }
+        const double r = 1.0 / std::sqrt(2.0);
+        if (!sparse_factor_.rank_one_update(i, (v1_[0] + v2_[0]) * r, j, (v1_[1] + v2_[1]) * r, 1) ||
+            !sparse_factor_.rank_one_update(i, (v1_[0] - v2_[0]) * r, j, (v1_[1] - v2_[1]) * r, -1)) {
+            refactor_sparse();
+        }
+        return;
+    }
+
     vf1_[i] = v1_[0];
     vf1_[j] = v1_[1];
     vf2_[i] = v2_[0];
@@ -291,21 +327,34 @@ void GGMModel::cholesky_update_after_edge(double omega_ij_old, double omega_jj_o
     // we now have
     // aOmega_prop - (aOmega + vf1 %*% t(vf2) + vf2 %*% t(vf1))
 
-    u1_ = (vf1_ + vf2_) / sqrt(2);
-    u2_ = (vf1_ - vf2_) / sqrt(2);
-
-    // update phi (2x O(p^2))
-    cholesky_update(cholesky_of_precision_, u1_);
-    cholesky_downdate(cholesky_of_precision_, u2_);
-
-    // update inverse — fall back to full recomputation if rank-1
-    // updates have caused numerical drift
-    bool ok = arma::solve(inv_cholesky_of_precision_, arma::trimatu(cholesky_of_precision_),
-                          arma::eye(p_, p_), arma::solve_opts::fast);
-    if (!ok) {
-        refresh_cholesky();
-    } else {
-        covariance_matrix_ = inv_cholesky_of_precision_ * inv_cholesky_of_precision_.t();
+    if (defer_covariance_refresh_) {
+        // Woodbury on the current covariance, before it changes:
+        //   S' = S - Z (C + Z' W)^{-1} Z',  W = [vf1, vf2],  Z = S W,  C = [0 1; 1 0]
+        // with W supported on rows i and j, so Z costs O(p)
+        edge_sigma_v1_ = covariance_matrix_.col(i) * vf1_(i) + covariance_matrix_.col(j) * vf1_(j);
+        edge_sigma_v2_ = covariance_matrix_.col(i) * vf2_(i) + covariance_matrix_.col(j) * vf2_(j);
+        const double g11 = vf1_(i) * edge_sigma_v1_(i) + vf1_(j) * edge_sigma_v1_(j);
+        const double g12 = 1.0 + vf1_(i) * edge_sigma_v2_(i) + vf1_(j) * edge_sigma_v2_(j);
+        const double g22 = vf2_(i) * edge_sigma_v2_(i) + vf2_(j) * edge_sigma_v2_(j);
+        const double det = g11 * g22 - g12 * g12;
+        const double h11 = g22 / det, h12 = -g12 / det, h22 = g11 / det;
+
+        if (apply_rank2_cholesky_update()) {
+            covariance_matrix_ -= h11 * (edge_sigma_v1_ * edge_sigma_v1_.t())
+                                + h12 * (edge_sigma_v1_ * edge_sigma_v2_.t() + edge_sigma_v2_ * edge_sigma_v1_.t())
+                                + h22 * (edge_sigma_v2_ * edge_sigma_v2_.t());
+            ++deferred_updates_;
+        }
+    } else if (apply_rank2_cholesky_update()) {
+        // update inverse — fall back to full recomputation if rank-1
+        // updates have caused numerical drift
+        bool ok = arma::solve(inv_cholesky_of_precision_, arma::trimatu(cholesky_of_precision_),
+                              arma::eye(p_, p_), arma::solve_opts::fast);
+        if (!ok) {
+            refresh_cholesky();
+        } else {
+            covariance_matrix_ = inv_cholesky_of_precision_ * inv_cholesky_of_precision_.t();
+        }
     }
 
     // reset for next iteration
@@ -316,9 +365,30 @@ void GGMModel::cholesky_update_after_edge(double omega_ij_old, double omega_jj_o
 
 }
 
+bool GGMModel::apply_rank2_cholesky_update() {
+    rank2_factors_.col(0) = (vf1_ + vf2_) / sqrt(2);
+    rank2_factors_.col(1) = (vf1_ - vf2_) / sqrt(2);
+
+    // update phi: the update and the downdate in one O(p^2) pass
+    if (cholesky_rank_update(cholesky_of_precision_, rank2_factors_, 1, chol_workspace_)) {
+        return true;
+    }
+    // The downdate lost positive definiteness to rounding: start over
+    refresh_cholesky();
+    return false;
+}
+
 double GGMModel::ggm_diag_move(size_t i) {
-    double logdet_omega = cholesky_helpers::get_log_det(cholesky_of_precision_);
-    double logdet_omega_sub_ii = logdet_omega + MY_LOG(covariance_matrix_(i, i));
+    double logdet_omega, logdet_omega_sub_ii;
+    if (sparse_active_) {
+        // Only the difference of the two enters theta_curr
+        sparse_factor_.inverse_entries(i, i, sigma_ii_, sigma_ij_, sigma_jj_);
+        logdet_omega = 0.0;
+        logdet_omega_sub_ii = MY_LOG(sigma_ii_);
+    } else {
+        logdet_omega = cholesky_helpers::get_log_det(cholesky_of_precision_);
+        logdet_omega_sub_ii = logdet_omega + MY_LOG(covariance_matrix_(i, i));
+    }
 
     size_t e = i * (i + 3) / 2; // parameter index in vectorized form (column-major upper triangle, i==j)
     double proposal_sd = proposal_sds_(e);
@@ -326,7 +396,6 @@ double GGMModel::ggm_diag_move(size_t i) {
     double theta_curr = (logdet_omega - logdet_omega_sub_ii) / 2;
     double theta_prop = rnorm(rng_, theta_curr, proposal_sd);
 
-    precision_proposal_ = precision_matrix_;
     precision_proposal_(i, i) = precision_matrix_(i, i) - MY_EXP(theta_curr) * MY_EXP(theta_curr) + MY_EXP(theta_prop) * MY_EXP(theta_prop);
 
     double ln_alpha = log_density_impl_diag(i);
@@ -359,6 +428,14 @@ void GGMModel::cholesky_update_after_diag(double omega_ii_old, size_t i)
 
     double delta = omega_ii_old - precision_proposal_(i, i);
 
+    if (sparse_active_) {
+        if (!sparse_factor_.rank_one_update(i, std::sqrt(std::abs(delta)), i, 0.0,
+                                            delta > 0 ? -1 : 1)) {
+            refactor_sparse();
+        }
+        return;
+    }
+
     bool s = delta > 0;
     vf1_(i) = std::sqrt(std::abs(delta));
 
@@ -367,6 +444,18 @@ void GGMModel::cholesky_update_after_diag(double omega_ii_old, size_t i)
     else
         cholesky_update(cholesky_of_precision_, vf1_);
 
+    if (defer_covariance_refresh_) {
+        // Sherman-Morrison for K + d e_i e_i', d = -delta; exact refresh in
+        // finish_deferred_sweep()
+        const double d = -delta;
+        block_sigma_col_ = covariance_matrix_.col(i);
+        covariance_matrix_ -= (d / (1.0 + d * block_sigma_col_(i))) *
+                              (block_sigma_col_ * block_sigma_col_.t());
+        ++deferred_updates_;
+        vf1_(i) = 0.0;
+        return;
+    }
+
     // update inverse — fall back to full recomputation if rank-1
     // updates have caused numerical drift
     bool ok = arma::solve(inv_cholesky_of_precision_, arma::trimatu(cholesky_of_precision_),
@@ -382,14 +471,209 @@ void GGMModel::cholesky_update_after_diag(double omega_ii_old, size_t i)
 }
 
 
-void GGMModel::update_edge_indicator_parameter_pair(size_t i, size_t j) {
+size_t GGMModel::collect_column_block(size_t j) {
+    block_rows_.clear();
+    for (size_t i = 0; i < j; ++i) {
+        if (edge_indicators_(i, j) == 1) block_rows_.push_back(i);
+    }
+    return block_rows_.size();
+}
+
+double GGMModel::ggm_column_move(size_t j) {
+    const size_t m = block_rows_.size();
+    const double sigma_jj = covariance_matrix_(j, j);
+
+    // Step each included K(i,j) on the scale of the Roverato move,
+    // 1 / sqrt[(K_{-j}^{-1})_ii] with (K_{-j}^{-1})_ii = S_ii - S_ij^2 / S_jj
+    // (S = covariance). K_{-j} is fixed by the move, so is the scale.
+    double sigma_delta_j = 0.0; // S_{j,block} delta
+    for (size_t k = 0; k < m; ++k) {
+        const size_t i = block_rows_[k];
+        const size_t e = j * (j + 1) / 2 + i;
+        const double sigma_ij = covariance_matrix_(i, j);
+        const double scale = 1.0 / std::sqrt(covariance_matrix_(i, i) - sigma_ij * sigma_ij / sigma_jj);
+        block_delta_(k) = scale * rnorm(rng_, 0.0, proposal_sds_(e));
+        sigma_delta_j += sigma_ij * block_delta_(k);
+    }
+
+    // delta' S_{block,block} delta
+    double quad = 0.0;
+    for (size_t a = 0; a < m; ++a) {
+        const size_t ia = block_rows_[a];
+        double row = 0.0;
+        for (size_t b = 0; b < m; ++b) {
+            row += covariance_matrix_(ia, block_rows_[b]) * block_delta_(b);
+        }
+        quad += block_delta_(a) * row;
+    }
+
+    // Keep the Schur complement K_jj - k' K_{-j}^{-1} k fixed. With
+    // K_{-j}^{-1} k = -S_{-j,j} / S_jj and
+    // K_{-j}^{-1} = S_{-j,-j} - S_{-j,j} S_{j,-j} / S_jj this gives
+    const double omega_jj_curr = precision_matrix_(j, j);
+    const double omega_jj_prop = omega_jj_curr - 2.0 * sigma_delta_j / sigma_jj
+                               + quad - sigma_delta_j * sigma_delta_j / sigma_jj;
+
+    // Likelihood ratio -tr((K' - K) X'X) / 2; |K'| = |K|, so the
+    // log-determinant and determinant-tilt terms vanish.
+    double trace_diff = (omega_jj_prop - omega_jj_curr) * suf_stat_(j, j);
+    double ln_alpha = 0.0;
+    for (size_t k = 0; k < m; ++k) {
+        const size_t i = block_rows_[k];
+        const double omega_ij_curr = precision_matrix_(i, j);
+        const double omega_ij_prop = omega_ij_curr + block_delta_(k);
+        trace_diff += 2.0 * block_delta_(k) * suf_stat_(i, j);
+
+        ln_alpha += interaction_prior_->logp(-0.5 * omega_ij_prop);
+        ln_alpha -= interaction_prior_->logp(-0.5 * omega_ij_curr);
+    }
+    ln_alpha -= trace_diff / 2;
+
+    ln_alpha += diagonal_prior_->logp(0.5 * omega_jj_prop);
+    ln_alpha -= diagonal_prior_->logp(0.5 * omega_jj_curr);
+
+    if (MY_LOG(runif(rng_)) < ln_alpha) {
+        for (size_t k = 0; k < m; ++k) {
+            const size_t i = block_rows_[k];
+            precision_matrix_(i, j) += block_delta_(k);
+            precision_matrix_(j, i) = precision_matrix_(i, j);
+        }
+        precision_matrix_(j, j) = omega_jj_prop;
+
+        cholesky_update_after_column(omega_jj_curr, j);
+    }
+
+    return ln_alpha;
+}
+
+void GGMModel::cholesky_update_after_column(double omega_jj_old, size_t j)
+{
+    // K' - K = e_j u' + u e_j', u = delta on the block rows and
+    // (K'_jj - K_jj) / 2 at j
+    const size_t m = block_rows_.size();
+    for (size_t k = 0; k < m; ++k) {
+        vf2_(block_rows_[k]) = block_delta_(k);
+    }
+    vf2_(j) = (precision_matrix_(j, j) - omega_jj_old) / 2;
+    vf1_(j) = 1.0;
+
+    // Woodbury on the current covariance, before it changes:
+    //   S' = S - Z (C + Z' W)^{-1} Z',  W = [e_j, u],  Z = S W,  C = [0 1; 1 0]
+    block_sigma_col_ = covariance_matrix_.col(j);
+    block_sigma_u_ = block_sigma_col_ * vf2_(j);
+    for (size_t k = 0; k < m; ++k) {
+        block_sigma_u_ += covariance_matrix_.col(block_rows_[k]) * block_delta_(k);
+    }
+    const double g11 = block_sigma_col_(j);
+    const double g12 = 1.0 + block_sigma_u_(j);
+    const double g22 = arma::dot(vf2_, block_sigma_u_);
+    const double det = g11 * g22 - g12 * g12;
+    const double h11 = g22 / det, h12 = -g12 / det, h22 = g11 / det;
+
+    if (apply_rank2_cholesky_update()) {
+        covariance_matrix_ -= h11 * (block_sigma_col_ * block_sigma_col_.t())
+                            + h12 * (block_sigma_col_ * block_sigma_u_.t() + block_sigma_u_ * block_sigma_col_.t())
+                            + h22 * (block_sigma_u_ * block_sigma_u_.t());
+        ++deferred_updates_;
+    }
+
+    // reset for next column
+    for (size_t k = 0; k < m; ++k) {
+        vf2_(block_rows_[k]) = 0.0;
+    }
+    vf1_(j) = 0.0;
+    vf2_(j) = 0.0;
+}
+
+void GGMModel::begin_deferred_sweep() {
+    select_cholesky_factorization();
+    defer_covariance_refresh_ = true;
+    deferred_updates_ = 0;
+}
+
+void GGMModel::finish_deferred_sweep() {
+    defer_covariance_refresh_ = false;
+    if (deferred_updates_ == 0) return;
+    deferred_updates_ = 0;
+    bool ok = arma::solve(inv_cholesky_of_precision_, arma::trimatu(cholesky_of_precision_),
+                          arma::eye(p_, p_), arma::solve_opts::fast);
+    if (!ok) {
+        refresh_cholesky();
+    } else {
+        covariance_matrix_ = inv_cholesky_of_precision_ * inv_cholesky_of_precision_.t();
+    }
+}
+
+
+namespace {
+
+// Largest fraction of included edges, and largest factor size as a fraction
+// of a dense triangle, at which the sweeps use the sparse Cholesky factor.
+constexpr double sparse_cholesky_max_density = 0.1;
+constexpr double sparse_cholesky_max_fill = 0.25;
+
+}  // namespace
+
+void GGMModel::select_cholesky_factorization() {
+    if (!sparse_cholesky_ || !sparse_pattern_stale_) return;
+
+    // The factor covers the graph only, so K must vanish off it
+    size_t num_edges = 0;
+    bool zero_off_graph = true;
+    for (size_t j = 1; j < p_ && zero_off_graph; ++j) {
+        for (size_t i = 0; i < j; ++i) {
+            if (edge_indicators_(i, j) == 1) {
+                ++num_edges;
+            } else if (precision_matrix_(i, j) != 0.0) {
+                zero_off_graph = false;
+                break;
+            }
+        }
+    }
+
+    bool use_sparse = zero_off_graph &&
+        static_cast<double>(num_edges) <= sparse_cholesky_max_density * static_cast<double>(num_pairwise_);
+    if (use_sparse) {
+        ensure_constraint_structure();
+        const GraphConstraintStructure& cs = constraint_structure_;
+        sparse_factor_.analyze(p_, [&cs](size_t q) -> const std::vector<size_t>& {
+            return cs.columns[q].included_indices;
+        });
+        use_sparse = static_cast<double>(sparse_factor_.factor_nonzeros()) <=
+                         sparse_cholesky_max_fill * static_cast<double>(dim_) &&
+                     sparse_factor_.factorize([this](size_t i, size_t j) { return precision_matrix_(i, j); });
+    }
+
+    if (use_sparse) {
+        sparse_active_ = true;
+    } else {
+        leave_sparse_mode();
+    }
+    sparse_pattern_stale_ = false;
+}
+
+void GGMModel::leave_sparse_mode() {
+    if (!sparse_active_) return;
+    sparse_active_ = false;
+    sparse_pattern_stale_ = true;
+    refresh_cholesky();
+}
+
+void GGMModel::refactor_sparse() {
+    if (!sparse_factor_.factorize([this](size_t i, size_t j) { return precision_matrix_(i, j); })) {
+        leave_sparse_mode();
+    }
+}
+
+
+double GGMModel::update_edge_indicator_parameter_pair(size_t i, size_t j) {
 
     size_t e = j * (j + 1) / 2 + i; // parameter index in vectorized form (column-major upper triangle)
     double proposal_sd = proposal_sds_(e);
+    double ln_alpha;
 
     if (edge_indicators_(i, j) == 1) {
         // Propose to turn OFF the edge
-        precision_proposal_ = precision_matrix_;
         precision_proposal_(i, j) = 0.0;
         precision_proposal_(j, i) = 0.0;
 
@@ -397,7 +681,7 @@ void GGMModel::update_edge_indicator_parameter_pair(size_t i, size_t j) {
         get_constants(i, j);
         precision_proposal_(j, j) = constrained_diagonal(0.0);
 
-        double ln_alpha = log_density_impl_edge(i, j);
+        ln_alpha = log_density_impl_edge(i, j);
 
         // Determinant-tilt prior: |K|^delta contributes delta * log_det_ratio
         // to the MH ratio. The rank-2 update at (i,j),(j,j) makes this O(p).
@@ -431,6 +715,8 @@ void GGMModel::update_edge_indicator_parameter_pair(size_t i, size_t j) {
             // Update edge indicator
             edge_indicators_(i, j) = 0;
             edge_indicators_(j, i) = 0;
+            edge_changes_.toggled(i, j, false);
+            sparse_pattern_stale_ = true;
 
             cholesky_update_after_edge(omega_ij_old, omega_jj_old, i, j);
 
@@ -446,12 +732,11 @@ void GGMModel::update_edge_indicator_parameter_pair(size_t i, size_t j) {
         double omega_prop_ij = constants_[3] * epsilon;
         double omega_prop_jj = constrained_diagonal(omega_prop_ij);
 
-        precision_proposal_ = precision_matrix_;
         precision_proposal_(i, j) = omega_prop_ij;
         precision_proposal_(j, i) = omega_prop_ij;
         precision_proposal_(j, j) = omega_prop_jj;
 
-        double ln_alpha = log_density_impl_edge(i, j);
+        ln_alpha = log_density_impl_edge(i, j);
 
         // Determinant-tilt prior: |K|^delta contributes delta * log_det_ratio
         // to the MH ratio.
@@ -487,12 +772,15 @@ void GGMModel::update_edge_indicator_parameter_pair(size_t i, size_t j) {
             // Update edge indicator
             edge_indicators_(i, j) = 1;
             edge_indicators_(j, i) = 1;
+            edge_changes_.toggled(i, j, true);
+            sparse_pattern_stale_ = true;
 
             cholesky_update_after_edge(omega_ij_old, omega_jj_old, i, j);
 
             invalidate_gradient_cache();
         }
     }
+    return std::min(1.0, std::exp(ln_alpha));
 }
 
 void GGMModel::do_one_metropolis_step(int iteration) {
@@ -503,16 +791,33 @@ void GGMModel::do_one_metropolis_step(int iteration) {
     arma::mat accept_prob(dim_, 1, arma::fill::zeros);
     arma::umat index_mask(dim_, 1, arma::fill::zeros);
 
-    // Update off-diagonals (upper triangle)
-    for (size_t i = 0; i < p_ - 1; ++i) {
-        for (size_t j = i + 1; j < p_; ++j) {
-            double ap = update_edge_parameter(i, j);
-            if (edge_indicators_(i, j) == 1) {
+    // Accepted moves update the covariance in O(p^2); one exact refresh
+    // at the end of the sweep
+    begin_deferred_sweep();
+    if (column_block_updates_ && !sparse_active_) {
+        // One joint move per column; every entry of the block shares its
+        // accept probability
+        for (size_t j = 1; j < p_; ++j) {
+            if (collect_column_block(j) == 0) continue;
+            double ap = std::min(1.0, std::exp(ggm_column_move(j)));
+            for (size_t i : block_rows_) {
                 size_t e = j * (j + 1) / 2 + i;
                 accept_prob(e, 0) = ap;
                 index_mask(e, 0) = 1;
             }
         }
+    } else {
+        // Update off-diagonals (upper triangle)
+        for (size_t i = 0; i < p_ - 1; ++i) {
+            for (size_t j = i + 1; j < p_; ++j) {
+                double ap = update_edge_parameter(i, j);
+                if (edge_indicators_(i, j) == 1) {
+                    size_t e = j * (j + 1) / 2 + i;
+                    accept_prob(e, 0) = ap;
+                    index_mask(e, 0) = 1;
+                }
+            }
+        }
     }
 
     // Update diagonals
@@ -523,6 +828,8 @@ void GGMModel::do_one_metropolis_step(int iteration) {
         index_mask(e, 0) = 1;
     }
 
+    finish_deferred_sweep();
+
     if (metropolis_adapter_) {
         metropolis_adapter_->update(index_mask, accept_prob, iteration);
     }
@@ -533,15 +840,51 @@ void GGMModel::init_metropolis_adaptation(const WarmupSchedule& schedule) {
         proposal_sds_, schedule, target_accept_);
 }
 
+void GGMModel::save_state(SamplerState& state) const {
+    state.add("precision_matrix", precision_matrix_);
+    state.add("edge_indicators", arma::conv_to<arma::mat>::from(edge_indicators_));
+    state.add("inclusion_probability", inclusion_probability_);
+    state.add("proposal_sd", proposal_sds_);
+    if (informed_edges_.enabled) {
+        state.add("informed_edge_rates", informed_edges_.flip_rates());
+    }
+    state.edge_selection_active = edge_selection_active_;
+}
+
+void GGMModel::restore_state(const SamplerState& state) {
+    precision_matrix_ = state.block("precision_matrix", p_, p_);
+    edge_indicators_ = arma::conv_to<arma::imat>::from(
+        state.block("edge_indicators", p_, p_));
+    edge_changes_.reset();
+    inclusion_probability_ = state.block("inclusion_probability", p_, p_);
+    proposal_sds_ = state.block("proposal_sd", dim_, 1);
+    if (informed_edges_.enabled && state.has_block("informed_edge_rates")) {
+        informed_edges_.set_flip_rates(state.block("informed_edge_rates", num_pairwise_, 1));
+    }
+    edge_selection_active_ = state.edge_selection_active;
+    sparse_active_ = false;
+    sparse_pattern_stale_ = true;
+    refresh_cholesky();
+    invalidate_gradient_cache();
+}
+
+void GGMModel::simulate_replicate(int num_states, int /*gibbs_iter*/, SafeRNG& rng, arma::mat& out) {
+    out = simulate_ggm(num_states, precision_matrix_, arma::zeros<arma::vec>(p_), rng);
+}
+
 void GGMModel::prepare_iteration() {
     // Shuffle edge visit order for random-scan edge selection.
     // Called unconditionally to keep RNG state consistent.
-    shuffled_edge_order_ = arma_randperm(rng_, num_pairwise_);
+    arma_randperm_into(rng_, shuffled_edge_order_, num_pairwise_);
 }
 
 void GGMModel::update_edge_indicators() {
+    begin_deferred_sweep();
+    const bool drawing = informed_edges_.drawing();
     for (size_t idx = 0; idx < num_pairwise_; ++idx) {
-        size_t flat = shuffled_edge_order_(idx);
+        // As many moves as a sequential sweep; the informed schedule draws
+        // their pairs by weight
+        size_t flat = drawing ? informed_edges_.draw(rng_) : shuffled_edge_order_(idx);
         // Convert flat index to (i, j) upper-triangle pair.
         // flat = 0..(num_pairwise_-1), row-major: (0,1),(0,2),...,(0,p-1),(1,2),...
         size_t i = 0, j = 0;
@@ -555,29 +898,46 @@ void GGMModel::update_edge_indicators() {
             }
             acc += cols_in_row;
         }
-        update_edge_indicator_parameter_pair(i, j);
+        informed_edges_.record(flat, update_edge_indicator_parameter_pair(i, j));
     }
+    finish_deferred_sweep();
 }
 
 void GGMModel::tune_proposal_sd(int iteration, const WarmupSchedule& schedule) {
+    // The weights of the informed edge schedule are learned in warmup only
+    informed_edges_.adapting = informed_edges_.enabled && !schedule.sampling(iteration + 1);
+
     auto rm_weight_opt = schedule.rm_weight_for_proposal_sd(iteration);
     if (!rm_weight_opt) return;
     const double rm_weight = *rm_weight_opt;
     const double target_accept = target_accept_;
 
     // Off-diagonal sweeps
-    for (size_t i = 0; i < p_ - 1; ++i) {
-        for (size_t j = i + 1; j < p_; ++j) {
-            if (edge_indicators_(i, j) == 0) continue;
-
-            // Same proposal/accept/update as the sampling path; only the
-            // Robbins-Monro adaptation of proposal_sds_ differs (it consumes
-            // the raw ln_alpha rather than the min(1,exp()) accept prob).
-            size_t e = j * (j + 1) / 2 + i;
-            double ln_alpha = ggm_edge_move(i, j);
-
-            proposal_sds_(e) = update_proposal_sd_with_robbins_monro(
-                proposal_sds_(e), ln_alpha, rm_weight, target_accept);
+    begin_deferred_sweep();
+    if (column_block_updates_ && !sparse_active_) {
+        for (size_t j = 1; j < p_; ++j) {
+            if (collect_column_block(j) == 0) continue;
+            double ln_alpha = ggm_column_move(j);
+            for (size_t i : block_rows_) {
+                size_t e = j * (j + 1) / 2 + i;
+                proposal_sds_(e) = update_proposal_sd_with_robbins_monro(
+                    proposal_sds_(e), ln_alpha, rm_weight, target_accept);
+            }
+        }
+    } else {
+        for (size_t i = 0; i < p_ - 1; ++i) {
+            for (size_t j = i + 1; j < p_; ++j) {
+                if (edge_indicators_(i, j) == 0) continue;
+
+                // Same proposal/accept/update as the sampling path; only the
+                // Robbins-Monro adaptation of proposal_sds_ differs (it consumes
+                // the raw ln_alpha rather than the min(1,exp()) accept prob).
+                size_t e = j * (j + 1) / 2 + i;
+                double ln_alpha = ggm_edge_move(i, j);
+
+                proposal_sds_(e) = update_proposal_sd_with_robbins_monro(
+                    proposal_sds_(e), ln_alpha, rm_weight, target_accept);
+            }
         }
     }
 
@@ -590,6 +950,8 @@ void GGMModel::tune_proposal_sd(int iteration, const WarmupSchedule& schedule) {
             proposal_sds_(e), ln_alpha, rm_weight, target_accept);
     }
 
+    finish_deferred_sweep();
+
     // Invalidate gradient cache after MH updates
     invalidate_gradient_cache();
 }
@@ -648,53 +1010,127 @@ void GGMModel::initialize_precision_from_mle() {
 // Missing data imputation
 // =============================================================================
 
-void GGMModel::update_suf_stat_for_imputation(int variable, int person, double delta) {
-    // INVARIANT: observations_(person, variable) must still hold x_old when
-    // this function is called. The loop adds 2 * delta * x_old to the (v,v)
-    // entry; the delta^2 correction completes the diagonal update.
-    for (size_t q = 0; q < p_; q++) {
-        suf_stat_(variable, q) += delta * observations_(person, q);
-        suf_stat_(q, variable) += delta * observations_(person, q);
-    }
-    suf_stat_(variable, variable) += delta * delta;
-}
+namespace {
 
-void GGMModel::impute_missing() {
-    if (!has_missing_) return;
+// Relative drift bound (against the largest diagonal entry of X'X) beyond
+// which the incrementally updated X'X is recomputed from the observations.
+constexpr double suf_stat_drift_tolerance = 1e-12;
 
-    const int num_missings = missing_index_.n_rows;
+}  // namespace
+
+void GGMModel::group_missing_by_person() {
+    // Sort the (row, col) pairs by row, then column
+    const arma::uword num_missings = missing_index_.n_rows;
+    const arma::uword p = static_cast<arma::uword>(p_);
+    arma::uvec keys(num_missings);
+    for (arma::uword m = 0; m < num_missings; ++m) {
+        keys(m) = static_cast<arma::uword>(missing_index_(m, 0)) * p +
+                  static_cast<arma::uword>(missing_index_(m, 1));
+    }
+    keys = arma::sort(keys);
+
+    missing_columns_.set_size(num_missings);
+    std::vector<arma::uword> persons, offsets;
+    for (arma::uword m = 0; m < num_missings; ++m) {
+        const arma::uword person = keys(m) / p;
+        if (persons.empty() || persons.back() != person) {
+            persons.push_back(person);
+            offsets.push_back(m);
+        }
+        missing_columns_(m) = keys(m) % p;
+    }
+    offsets.push_back(num_missings);
+    missing_persons_ = arma::uvec(persons);
+    missing_offsets_ = arma::uvec(offsets);
+    suf_stat_drift_ = 0.0;
+}
 
-    for (int miss = 0; miss < num_missings; miss++) {
-        const int person = missing_index_(miss, 0);
-        const int variable = missing_index_(miss, 1);
+void GGMModel::impute_person(arma::uword block) {
+    arma::mat& observations = observations_.mut();
+    const arma::uword person = missing_persons_(block);
+    const arma::uword begin = missing_offsets_(block);
+    const arma::uword num_cells = missing_offsets_(block + 1) - begin;
 
-        // Compute conditional mean: mu = -sum_{k != v} omega_{vk} * x_{ik} / omega_{vv}
+    // Scalar conditional: mu = -sum_{k != v} omega_{vk} x_{ik} / omega_{vv},
+    // variance 1 / omega_{vv}
+    auto impute_cell = [&](arma::uword variable) {
         double conditional_mean = 0.0;
         for (size_t k = 0; k < p_; k++) {
-            if (k != static_cast<size_t>(variable)) {
-                conditional_mean += precision_matrix_(variable, k) * observations_(person, k);
+            if (k != variable) {
+                conditional_mean += precision_matrix_(variable, k) * observations(person, k);
             }
         }
         conditional_mean = -conditional_mean / precision_matrix_(variable, variable);
-
-        // Conditional variance: 1 / omega_{vv}
         double conditional_sd = std::sqrt(1.0 / precision_matrix_(variable, variable));
+        observations(person, variable) = rnorm(rng_, conditional_mean, conditional_sd);
+    };
+
+    if (num_cells == 1) {
+        impute_cell(missing_columns_(begin));
+        return;
+    }
+
+    // Block conditional: x_M | x_O ~ N(-K_MM^{-1} K_MO x_O, K_MM^{-1}).
+    // With K_MM = L L', x_M = L'^{-1} (z - L^{-1} K_MO x_O) for z ~ N(0, I).
+    const arma::uvec cols = missing_columns_.subvec(begin, begin + num_cells - 1);
+    arma::mat chol_mm;
+    if (!arma::chol(chol_mm, precision_matrix_.submat(cols, cols), "lower")) {
+        // Numerically indefinite block: fall back to cell-by-cell Gibbs
+        for (arma::uword c = 0; c < num_cells; ++c) {
+            impute_cell(cols(c));
+        }
+        return;
+    }
+
+    arma::vec x_rest = observations.row(person).t();
+    x_rest.elem(cols).zeros();
+    const arma::vec shift = arma::solve(
+        arma::trimatl(chol_mm), precision_matrix_.rows(cols) * x_rest,
+        arma::solve_opts::fast);
 
-        // Sample new value
-        double x_new = rnorm(rng_, conditional_mean, conditional_sd);
-        double x_old = observations_(person, variable);
-        double delta = x_new - x_old;
+    arma::vec z(num_cells);
+    for (arma::uword c = 0; c < num_cells; ++c) {
+        z(c) = rnorm(rng_, 0.0, 1.0);
+    }
+    const arma::vec x_missing = arma::solve(
+        arma::trimatu(chol_mm.t()), z - shift, arma::solve_opts::fast);
 
-        // Incrementally update suf_stat_ (observations_ still holds x_old)
-        update_suf_stat_for_imputation(variable, person, delta);
+    for (arma::uword c = 0; c < num_cells; ++c) {
+        observations(person, cols(c)) = x_missing(c);
+    }
+}
 
-        // Now update the observation
-        observations_(person, variable) = x_new;
+void GGMModel::update_suf_stat_after_imputation() {
+    const arma::mat& observations = *observations_;
+
+    // The correction costs about 2 m p^2 against n p^2 for the full product
+    if (2 * missing_persons_.n_elem < observations.n_rows) {
+        imputed_rows_new_ = observations.rows(missing_persons_);
+        suf_stat_ += imputed_rows_new_.t() * imputed_rows_new_;
+        suf_stat_ -= imputed_rows_old_.t() * imputed_rows_old_;
+
+        // Each product adds at most about eps * sum_i x_ia^2 per entry
+        suf_stat_drift_ += std::numeric_limits<double>::epsilon() *
+            (arma::accu(arma::square(imputed_rows_new_)) +
+             arma::accu(arma::square(imputed_rows_old_)));
+        if (suf_stat_drift_ <=
+            suf_stat_drift_tolerance * arma::max(arma::abs(suf_stat_.diag()))) {
+            return;
+        }
     }
 
-    // Full recompute at end of sweep to eliminate floating-point drift
-    // (matches OMRF pattern; cost is O(np^2), negligible for typical sizes)
-    suf_stat_ = observations_.t() * observations_;
+    suf_stat_ = observations.t() * observations;
+    suf_stat_drift_ = 0.0;
+}
+
+void GGMModel::impute_missing() {
+    if (!has_missing_) return;
+
+    imputed_rows_old_ = observations_->rows(missing_persons_);
+    for (arma::uword block = 0; block < missing_persons_.n_elem; ++block) {
+        impute_person(block);
+    }
+    update_suf_stat_after_imputation();
 }
 
 
@@ -714,7 +1150,7 @@ GGMModel createGGMModelFromR(
 
     if (inputFromR.containsElementNamed("n") && inputFromR.containsElementNamed("suf_stat")) {
         int n = Rcpp::as<int>(inputFromR["n"]);
-        arma::mat suf_stat = Rcpp::as<arma::mat>(inputFromR["suf_stat"]);
+        const arma::mat suf_stat = numeric_matrix_view(inputFromR["suf_stat"]);
         return GGMModel(
             n,
             suf_stat,
@@ -725,7 +1161,8 @@ GGMModel createGGMModelFromR(
             std::move(diagonal_prior)
         );
     } else if (inputFromR.containsElementNamed("X")) {
-        arma::mat X = Rcpp::as<arma::mat>(inputFromR["X"]);
+        // Read X in place; the model copies it only to impute missing values
+        const arma::mat X = numeric_matrix_view(inputFromR["X"]);
         return GGMModel(
             X,
             prior_inclusion_prob,
@@ -2,12 +2,17 @@
 
 #include <array>
 #include <memory>
+#include <vector>
 #include "models/base_model.h"
+#include "models/shared_data.h"
 #include "math/cholesky_helpers.h"
+#include "math/sparse_cholesky.h"
+#include "math/cholupdate.h"
 #include "rng/rng_utils.h"
 #include "models/ggm/graph_constraint_structure.h"
 #include "models/ggm/ggm_gradient.h"
 #include "priors/parameter_prior.h"
+#include "mcmc/samplers/informed_edge_schedule.h"
 #include "mcmc/samplers/metropolis_adaptation.h"
 
 
@@ -61,7 +66,7 @@ public:
                    std::move(diagonal_prior))
     {
         if (na_impute) {
-            observations_ = observations;
+            observations_.mut() = observations;
         }
     }
 
@@ -135,25 +140,52 @@ public:
           vectorized_indicator_parameters_(other.vectorized_indicator_parameters_),
           proposal_sds_(other.proposal_sds_),
           shuffled_edge_order_(other.shuffled_edge_order_),
+          informed_edges_(other.informed_edges_),
           num_pairwise_(other.num_pairwise_),
           rng_(other.rng_),
           observations_(other.observations_),
           has_missing_(other.has_missing_),
           missing_index_(other.missing_index_),
+          missing_persons_(other.missing_persons_),
+          missing_offsets_(other.missing_offsets_),
+          missing_columns_(other.missing_columns_),
+          suf_stat_drift_(other.suf_stat_drift_),
           precision_proposal_(other.precision_proposal_),
+          column_block_updates_(other.column_block_updates_),
+          sparse_cholesky_(other.sparse_cholesky_),
+          sparse_active_(other.sparse_active_),
+          sparse_pattern_stale_(other.sparse_pattern_stale_),
+          sparse_factor_(other.sparse_factor_),
           constraint_structure_(other.constraint_structure_),
           gradient_engine_(other.gradient_engine_),
           constraint_dirty_(other.constraint_dirty_),
           theta_valid_(other.theta_valid_),
           theta_(other.theta_)
-    {}
+    {
+        // Imputation writes to the observations, so each chain needs its own
+        if (has_missing_) observations_.detach();
+    }
 
     /** @return true when edge selection is enabled. */
     bool has_edge_selection()  const override { return edge_selection_; }
+    /** @return true: edge toggles are reported to the edge prior. */
+    bool reports_edge_changes()  const override { return true; }
     /** @return true when missing-data imputation is active. */
     bool has_missing_data()    const override { return has_missing_; }
+    /** @return Observations with the current imputations (empty without na_impute). */
+    const arma::mat& observations() const { return *observations_; }
+    /** @return Sufficient-statistic matrix X'X at the current imputations. */
+    const arma::mat& sufficient_statistic() const { return suf_stat_; }
 
-    /** Impute missing entries from full-conditional normal distributions. */
+    /**
+     * Impute missing entries from their conditional normal distribution.
+     *
+     * The missing entries of a person are drawn jointly given the person's
+     * observed entries. S = X'X then gets a low-rank correction from the
+     * changed rows only, and is recomputed in full once the accumulated
+     * rounding-error bound of these corrections exceeds a small fraction
+     * of its diagonal.
+     */
     void impute_missing() override;
 
     /**
@@ -163,13 +195,14 @@ public:
      * @throws std::logic_error if the model was constructed without na_impute
      */
     void set_missing_data(const arma::imat& missing_index) {
-        if (observations_.n_elem == 0) {
+        if (observations_->n_elem == 0) {
             throw std::logic_error(
                 "set_missing_data() called but observations_ is empty. "
                 "The model must be constructed with na_impute=true to retain observations.");
         }
         missing_index_ = missing_index;
         has_missing_ = (missing_index.n_rows > 0 && missing_index.n_cols == 2);
+        if (has_missing_) group_missing_by_person();
     }
 
     /**
@@ -208,6 +241,41 @@ public:
         constraint_dirty_ = true;
     }
 
+    /**
+     * Switch the off-diagonal Metropolis updates between edge-by-edge moves
+     * (default) and column-blocked moves (see ggm_column_move). Both target
+     * the same posterior; the blocked sweep refreshes the Cholesky factor and
+     * covariance once per column instead of once per edge.
+     */
+    void set_column_block_updates(bool active) {
+        column_block_updates_ = active;
+    }
+
+    /**
+     * Let the Metropolis and edge-indicator sweeps work on a sparse
+     * Cholesky factor of K while the graph is sparse (see
+     * select_cholesky_factorization). The sweeps then read the few entries
+     * of the covariance each move needs from sparse triangular solves and
+     * skip the dense factor, inverse and covariance, whose O(p^2) storage
+     * and updates dominate for large sparse graphs. Column-blocked moves
+     * fall back to edge-by-edge moves while the sparse factor is in use.
+     */
+    void set_sparse_cholesky(bool active) {
+        sparse_cholesky_ = active;
+        sparse_pattern_stale_ = true;
+    }
+
+    /**
+     * Draw the pairs of each sampling sweep of the edge indicators in
+     * proportion to how often their flips were accepted in warmup (see
+     * InformedEdgeSchedule). The warmup sweeps are sequential and teach
+     * the weights.
+     */
+    void set_informed_edge_updates(bool enabled) {
+        informed_edges_.enabled = enabled;
+        informed_edges_.resize(enabled ? num_pairwise_ : 0);
+    }
+
     /** Shuffle edge visit order (random scan). */
     void prepare_iteration() override;
 
@@ -289,11 +357,11 @@ public:
     size_t storage_dimension() const override { return dim_; }
 
     /**
-     * Set random seed for reproducibility.
-     * @param seed  Integer seed value
+     * Replace the random number generator.
+     * @param rng  Engine to copy into the model
      */
-    void set_seed(int seed) override {
-        rng_ = SafeRNG(seed);
+    void set_rng(const SafeRNG& rng) override {
+        rng_ = rng;
     }
 
     /**
@@ -333,6 +401,15 @@ public:
         return vectorized_indicator_parameters_;
     }
 
+    /** Pack the upper triangle of the edge-indicator matrix (same order). */
+    void pack_indicator_parameters(IndicatorBitWriter& out) override {
+        for (size_t i = 0; i < p_; ++i) {
+            for (size_t j = i; j < p_; ++j) {
+                out.push(edge_indicators_(i, j) != 0);
+            }
+        }
+    }
+
     /** @return Reference to the model's random number generator. */
     SafeRNG& get_rng() override { return rng_; }
 
@@ -365,6 +442,12 @@ public:
      */
     arma::vec get_active_inv_mass() const override;
 
+    /**
+     * @return Full-vector slot of each active theta entry, following the
+     *         same scatter as get_full_vectorized_parameters().
+     */
+    arma::uvec get_active_parameter_indices() const override;
+
     // GGMModel uses the theta-space (free-element Cholesky) NUTS path
     // exclusively. RATTLE projection (project_position/project_momentum,
     // full-position get/set, full-space gradient) is not implemented;
@@ -377,6 +460,24 @@ public:
         return std::make_unique<GGMModel>(*this);
     }
 
+    /** Give this clone its own copy of the observations. */
+    void replicate_shared_data() override { observations_.detach(); }
+
+    /**
+     * Save the precision matrix, edge indicators, inclusion probabilities
+     * and proposal SDs.
+     */
+    void save_state(SamplerState& state) const override;
+
+    /**
+     * Restore a save_state() state; refactors the precision matrix and
+     * marks the NUTS gradient caches stale.
+     */
+    void restore_state(const SamplerState& state) override;
+
+    /** Replicate of the data from simulate_ggm() at the current precision (zero means). */
+    void simulate_replicate(int num_states, int gibbs_iter, SafeRNG& rng, arma::mat& out) override;
+
 private:
 
     // Robbins-Monro target acceptance rate for adaptive-Metropolis
@@ -445,30 +546,110 @@ private:
 
     /// Shuffled edge visit order for random-scan edge selection.
     arma::uvec shuffled_edge_order_;
+    /// Learned pair weights of the informed edge schedule.
+    InformedEdgeSchedule informed_edges_;
     /// Number of unique off-diagonal pairs: p(p-1)/2.
     size_t num_pairwise_ = 0;
     /// Random number generator.
     SafeRNG rng_;
 
     /// Raw observation matrix (n x p), only populated when na_impute=true.
-    arma::mat observations_;
+    /// Shared by the chain clones unless they impute.
+    SharedData<arma::mat> observations_;
     /// Whether missing-data imputation is active.
     bool has_missing_ = false;
     /// M x 2 matrix of 0-based (row, col) indices of missing entries.
     arma::imat missing_index_;
+    /// Rows with missing entries, in increasing order. The missing columns
+    /// of row missing_persons_(b) are missing_columns_(missing_offsets_(b))
+    /// up to missing_offsets_(b + 1) - 1.
+    arma::uvec missing_persons_;
+    arma::uvec missing_offsets_;
+    arma::uvec missing_columns_;
+    /// Rows missing_persons_ of the observations before and after a sweep.
+    arma::mat imputed_rows_old_, imputed_rows_new_;
+    /// Bound on the rounding error the incremental updates have added to
+    /// suf_stat_ since it was last computed from the observations.
+    double suf_stat_drift_ = 0.0;
+
+    /** Build missing_persons_, missing_offsets_ and missing_columns_. */
+    void group_missing_by_person();
 
     /**
-     * Incrementally adjust S = X'X after replacing one observation value.
+     * Draw the missing entries of one person jointly from their
+     * conditional normal given the person's other entries.
      *
-     * @param variable  Column index of the changed variable
-     * @param person    Row index of the changed observation
-     * @param delta     Change in value (new - old)
+     * @param block  Index into missing_persons_
+     */
+    void impute_person(arma::uword block);
+
+    /**
+     * Bring suf_stat_ up to date after a sweep changed rows missing_persons_
+     * (old values in imputed_rows_old_): a low-rank correction, or a full
+     * X'X when many rows changed or the drift bound is exceeded.
      */
-    void update_suf_stat_for_imputation(int variable, int person, double delta);
+    void update_suf_stat_after_imputation();
 
-    /// Scratch matrix for proposed precision values.
+    /// Scratch matrix for proposed precision values. Only the entries a move
+    /// changes ((i,j), (j,i), (j,j) or (i,i)) are written and read; the rest
+    /// are stale.
     arma::mat precision_proposal_;
 
+    /// Whether do_one_metropolis_step/tune_proposal_sd use column blocks.
+    bool column_block_updates_ = false;
+    /// Whether the sweeps may use sparse_factor_ (set_sparse_cholesky).
+    bool sparse_cholesky_ = false;
+    /// Whether sparse_factor_ holds the factor of K. The dense
+    /// cholesky_of_precision_, inv_cholesky_of_precision_ and
+    /// covariance_matrix_ are then stale until leave_sparse_mode().
+    bool sparse_active_ = false;
+    /// Whether the edge set changed since the factorization was chosen.
+    bool sparse_pattern_stale_ = true;
+    /// Sparse Cholesky factor of K over the pattern of the graph.
+    SparseCholesky sparse_factor_;
+    /// Covariance entries (i,i), (i,j), (j,j) of the current move, from
+    /// sparse_factor_; read by the log-determinant ratios in sparse mode.
+    double sigma_ii_ = 0.0, sigma_ij_ = 0.0, sigma_jj_ = 0.0;
+
+    /**
+     * With set_sparse_cholesky() on and the edge set changed since the last
+     * call, choose between the dense and the sparse factorization: the
+     * sparse factor is used when at most a tenth of the edges are included,
+     * K is zero off the graph, and the fill-reducing ordering keeps the
+     * factor below a quarter of a dense triangle.
+     */
+    void select_cholesky_factorization();
+
+    /**
+     * Stop using the sparse factor: recompute the dense factor, inverse
+     * and covariance from precision_matrix_. No-op in dense mode.
+     */
+    void leave_sparse_mode();
+
+    /**
+     * Recompute sparse_factor_ from precision_matrix_ after its update
+     * failed or its pattern grew; leaves sparse mode if K is not positive
+     * definite in floating point.
+     */
+    void refactor_sparse();
+    /// Set during a Metropolis or edge-indicator sweep: accepted moves
+    /// update the covariance by Woodbury or Sherman-Morrison instead of a
+    /// triangular solve, and finish_deferred_sweep() recomputes it exactly
+    /// at the end.
+    bool defer_covariance_refresh_ = false;
+    /// Accepted moves since the sweep began; no refresh is needed without.
+    size_t deferred_updates_ = 0;
+    /// Rows i < j of the included edges in the current column block.
+    std::vector<size_t> block_rows_;
+    /// Proposed changes to K(i,j) for the rows in block_rows_.
+    arma::vec block_delta_ = arma::zeros<arma::vec>(p_);
+    /// Column j of the covariance and Sigma u for the Woodbury update.
+    arma::vec block_sigma_col_ = arma::zeros<arma::vec>(p_);
+    arma::vec block_sigma_u_ = arma::zeros<arma::vec>(p_);
+    /// Sigma vf1 and Sigma vf2 for the Woodbury update after an edge move.
+    arma::vec edge_sigma_v1_ = arma::zeros<arma::vec>(p_);
+    arma::vec edge_sigma_v2_ = arma::zeros<arma::vec>(p_);
+
     /**
      * Workspace for conditional precision reparameterization.
      *
@@ -485,15 +666,23 @@ private:
      * Work vectors for rank-2 Cholesky update.
      *
      * A symmetric rank-2 update  A + vf1*vf2' + vf2*vf1'  is decomposed
-     * into two rank-1 updates via  u1 = (vf1+vf2)/sqrt(2),
-     * u2 = (vf1-vf2)/sqrt(2).
+     * into an update and a downdate, the columns u1 = (vf1+vf2)/sqrt(2) and
+     * u2 = (vf1-vf2)/sqrt(2) of rank2_factors_, applied in one pass by
+     * cholesky_rank_update().
      */
     arma::vec v1_ = {0, -1};
     arma::vec v2_ = {0, 0};
     arma::vec vf1_ = arma::zeros<arma::vec>(p_);
     arma::vec vf2_ = arma::zeros<arma::vec>(p_);
-    arma::vec u1_ = arma::zeros<arma::vec>(p_);
-    arma::vec u2_ = arma::zeros<arma::vec>(p_);
+    arma::mat rank2_factors_ = arma::zeros<arma::mat>(p_, 2);
+    CholeskyUpdateWorkspace chol_workspace_;
+
+    /**
+     * Apply K' = K + vf1*vf2' + vf2*vf1' to the Cholesky factor (one-pass
+     * rank-2 update) and refresh a failed factor from precision_matrix_.
+     * @return false if the factor was recomputed from scratch
+     */
+    bool apply_rank2_cholesky_update();
 
     /**
      * Propose a new off-diagonal precision entry via a normal perturbation
@@ -531,6 +720,48 @@ private:
     double ggm_edge_move(size_t i, size_t j);
     double ggm_diag_move(size_t i);
 
+    /**
+     * Collect the included edges (i, j), i < j, of column j into
+     * block_rows_.
+     *
+     * @return Number of rows in the block.
+     */
+    size_t collect_column_block(size_t j);
+
+    /**
+     * Joint MH move for all entries K(i,j) in block_rows_, with K(j,j)
+     * slaved so that the Schur complement K(j,j) - k' K_{-j}^{-1} k stays
+     * fixed. That generalizes the Roverato edge move: each K(i,j) takes a
+     * normal step with sd proposal_sd(i,j) / sqrt[(K_{-j}^{-1})_ii], a
+     * scale the move does not change, so the proposal is symmetric, and
+     * |K| is invariant, so the log-determinant (and determinant tilt)
+     * cancel. The change to K is e_j u' + u e_j' and costs one rank-2
+     * Cholesky update on acceptance. Returns the RAW ln_alpha.
+     *
+     * @param j  Column index (j >= 1), with block_rows_ already collected
+     */
+    double ggm_column_move(size_t j);
+
+    /**
+     * Update the Cholesky factor, and the covariance by Woodbury, after an
+     * accepted column move. block_delta_ and the new K(j,j) must be in
+     * place; omega_jj_old is the previous K(j,j).
+     */
+    void cholesky_update_after_column(double omega_jj_old, size_t j);
+
+    /**
+     * Start a sweep of moves whose covariance updates are deferred (see
+     * defer_covariance_refresh_).
+     */
+    void begin_deferred_sweep();
+
+    /**
+     * End a deferred sweep: if any move was accepted, recompute the inverse
+     * Cholesky factor and covariance from the updated Cholesky factor,
+     * discarding Woodbury rounding.
+     */
+    void finish_deferred_sweep();
+
     /**
      * Metropolis-Hastings add-delete move for an edge indicator.
      *
@@ -540,8 +771,9 @@ private:
      *
      * @param i  Row index (i < j)
      * @param j  Column index
+     * @return Acceptance probability (for the informed edge schedule)
      */
-    void update_edge_indicator_parameter_pair(size_t i, size_t j);
+    double update_edge_indicator_parameter_pair(size_t i, size_t j);
 
     /**
      * Precompute reparameterization constants for the (i, j) element.
@@ -612,10 +844,12 @@ private:
 
 
     /**
-     * Update the Cholesky factor after changing an off-diagonal element.
+     * Update the Cholesky factor and covariance after changing an
+     * off-diagonal element.
      *
-     * Decomposes the rank-2 change into two rank-1 updates and
-     * recomputes the inverse Cholesky factor and covariance matrix.
+     * Applies the rank-2 change to the Cholesky factor in one pass. Within
+     * a deferred sweep the covariance follows by a rank-2 Woodbury update,
+     * O(p^2); otherwise it is recomputed from the new factor.
      *
      * @param omega_ij_old  Previous value of omega(i,j)
      * @param omega_jj_old  Previous value of omega(j,j)
@@ -6,6 +6,7 @@
 // cache in mixed_mrf_model.cpp.
 #include <RcppArmadillo.h>
 #include "models/mixed/mixed_mrf_model.h"
+#include "mcmc/execution/chain_profile.h"
 #include "utils/variable_helpers.h"
 #include "math/explog_macros.h"
 
@@ -91,19 +92,16 @@ void MixedMRFModel::ensure_gradient_cache() {
             // Factor 4: K = σ, and the log-PL has edge (i,j) in two conditionals,
             // giving d/dK [4K·(x^Tx)] = 4·(x^Tx)
             grad_obs_cache_(loc) = 4.0 * arma::dot(
-                discrete_observations_dbl_.col(i),
-                discrete_observations_dbl_.col(j)
+                data_->discrete_observations_dbl.col(i),
+                data_->discrete_observations_dbl.col(j)
             );
         }
     }
 
     // No precomputed observed stats for means or cross effects — those depend on
-    // continuous_observations_ combined with current parameters, so they
+    // the continuous observations combined with current parameters, so they
     // are computed fresh each logp_and_gradient call.
 
-    // Cache transpose of discrete observations for vectorized pairwise gradient
-    discrete_observations_dbl_t_ = discrete_observations_dbl_.t();
-
     gradient_cache_valid_ = true;
 }
 
@@ -113,6 +111,13 @@ void MixedMRFModel::invalidate_gradient_cache() {
 }
 
 
+void MixedMRFModel::prepare_gradient_data() {
+    const arma::mat& x_t = data_->discrete_observations_dbl_t;
+    if(x_t.n_rows == p_ && x_t.n_cols == n_) return;
+    data_.mut().discrete_observations_dbl_t = data_->discrete_observations_dbl.t();
+}
+
+
 // =============================================================================
 // Unvectorize NUTS parameters into temporaries
 // =============================================================================
@@ -187,6 +192,8 @@ void MixedMRFModel::unvectorize_nuts_to_temps(
 std::pair<double, arma::vec> MixedMRFModel::logp_and_gradient(
     const arma::vec& parameters)
 {
+    BGMS_PROFILE_SCOPE(Gradient);
+    prepare_gradient_data();
     ensure_gradient_cache();
     ensure_constraint_structure();
 
@@ -228,10 +235,10 @@ std::pair<double, arma::vec> MixedMRFModel::logp_and_gradient(
     // --- Derived quantities ---
     // Conditional mean: M_i = μ_y' + 2 x_i' A_xy Σ_yy  (n x q)
     arma::mat temp_cond_mean = arma::repmat(temp_main_continuous.t(), n_, 1)
-                             + 2.0 * discrete_observations_dbl_ * temp_pairwise_cross * temp_covariance;
+                             + 2.0 * data_->discrete_observations_dbl * temp_pairwise_cross * temp_covariance;
 
     // Residual: D = Y - M  (n x q)
-    arma::mat D = continuous_observations_ - temp_cond_mean;
+    arma::mat D = data_->continuous_observations - temp_cond_mean;
 
     // Marginal PL effective discrete interaction matrix
     //   M = A_xx + 2 A_xy Σ_yy A_xy'
@@ -262,8 +269,8 @@ std::pair<double, arma::vec> MixedMRFModel::logp_and_gradient(
         arma::vec rest;
         // Marginal: Θ-based rest + A_xy μ_y bias
         double precision_ss = temp_marginal(s, s);
-        rest = 2.0 * (discrete_observations_dbl_ * temp_marginal.col(s)
-                    - discrete_observations_dbl_.col(s) * precision_ss)
+        rest = 2.0 * (data_->discrete_observations_dbl * temp_marginal.col(s)
+                    - data_->discrete_observations_dbl.col(s) * precision_ss)
              + 2.0 * arma::dot(temp_pairwise_cross.row(s), temp_main_continuous);
 
         if(is_ordinal_variable_(s)) {
@@ -283,26 +290,26 @@ std::pair<double, arma::vec> MixedMRFModel::logp_and_gradient(
             bound = arma::max(bound, arma::zeros<arma::vec>(bound.n_elem));
 
             // Fill-in-place using persistent per-chain scratch.
-            compute_logZ_and_probs_ordinal_into(
-                main_param, rest, bound, C_s, logz_out_, logz_scratch_
+            logz_kernels_[s].ordinal_moments(
+                main_param, rest, bound, C_s, logz_moments_, logz_scratch_, nullptr
             );
 
             // log pseudo-posterior contribution
-            logp -= arma::accu(logz_out_.log_Z);
+            logp -= logz_moments_.log_Z_sum;
 
             // Main-effect gradient: ∂/∂main_effects_discrete_{s,c} = count_c - sum_i prob(c)
             for(int c = 0; c < C_s; ++c) {
-                grad(main_effects_discrete_offset + c) -= arma::accu(logz_out_.probs.col(c + 1));
+                grad(main_effects_discrete_offset + c) -= logz_moments_.prob_sums(c + 1);
             }
 
             // Expected value E_s[c+1|rest] per observation
             arma::vec weights = arma::regspace<arma::vec>(1, C_s);
-            arma::vec E = logz_out_.probs.cols(1, C_s) * weights;
+            const arma::vec& E = logz_moments_.E;
 
             // Pairwise discrete gradient: sum_i x_{i,t} * (x_{i,s}+1 - E_s)
             // (uses pre-transposed discrete observations for BLAS efficiency)
             // Factor 2: chain rule d/dK = 2 × d/dσ
-            arma::vec pw_grad = discrete_observations_dbl_t_ * E;
+            arma::vec pw_grad = data_->discrete_observations_dbl_t * E;
             for(size_t t = 0; t < p_; ++t) {
                 if(edge_indicators_(s, t) == 0 || s == t) continue;
                 int loc = (s < t) ? disc_index_cache_(s, t) : disc_index_cache_(t, s);
@@ -320,17 +327,17 @@ std::pair<double, arma::vec> MixedMRFModel::logp_and_gradient(
             // Cross-contribution (a=t): from rest_s → pairwise_effects_cross_t for each t≠s
 
             arma::vec weights_sq = arma::square(weights);
-            arma::vec E_sq = logz_out_.probs.cols(1, C_s) * weights_sq;
+            double sum_E_sq = arma::dot(logz_moments_.prob_sums.tail(C_s), weights_sq);
 
-            arma::vec diff_pw = discrete_observations_dbl_t_ *
-                (discrete_observations_dbl_.col(s) - E);
+            arma::vec diff_pw = data_->discrete_observations_dbl_t *
+                (data_->discrete_observations_dbl.col(s) - E);
             diff_pw(s) = 0.0;
 
             double diff_diag = arma::dot(
-                discrete_observations_dbl_.col(s),
-                discrete_observations_dbl_.col(s)) - arma::accu(E_sq);
+                data_->discrete_observations_dbl.col(s),
+                data_->discrete_observations_dbl.col(s)) - sum_E_sq;
 
-            double sum_obs_minus_E = arma::accu(discrete_observations_dbl_.col(s)) - arma::accu(E);
+            double sum_obs_minus_E = arma::accu(data_->discrete_observations_dbl.col(s)) - arma::accu(E);
 
             // Accumulate Θ̄ for precision gradient coupling
             for(size_t t = 0; t < p_; ++t) {
@@ -381,27 +388,26 @@ std::pair<double, arma::vec> MixedMRFModel::logp_and_gradient(
             double effective_quad = quad_eff;
             effective_quad += temp_marginal(s, s);
 
-            arma::vec bc_bound;
-            compute_logZ_and_probs_blume_capel_into(
-                rest, lin_eff, effective_quad, ref, C_s, bc_bound,
-                logz_out_, logz_scratch_
+            logz_kernels_[s].blume_capel_moments(
+                rest, lin_eff, effective_quad, ref, C_s,
+                logz_moments_, logz_scratch_, nullptr
             );
 
-            logp -= arma::accu(logz_out_.log_Z);
+            logp -= logz_moments_.log_Z_sum;
 
             arma::vec score = arma::regspace<arma::vec>(0, C_s) - static_cast<double>(ref);
             arma::vec sq_score = arma::square(score);
 
             // Main-effect gradient
-            grad(main_effects_discrete_offset)     -= arma::accu(logz_out_.probs * score);
-            grad(main_effects_discrete_offset + 1) -= arma::accu(logz_out_.probs * sq_score);
+            grad(main_effects_discrete_offset)     -= arma::dot(logz_moments_.prob_sums, score);
+            grad(main_effects_discrete_offset + 1) -= arma::dot(logz_moments_.prob_sums, sq_score);
 
             // Expected score per person
-            arma::vec E = logz_out_.probs * score;
+            const arma::vec& E = logz_moments_.E;
 
             // Pairwise discrete gradient
             // Factor 2: chain rule d/dK = 2 × d/dσ
-            arma::vec pw_grad = discrete_observations_dbl_t_ * E;
+            arma::vec pw_grad = data_->discrete_observations_dbl_t * E;
             for(size_t t = 0; t < p_; ++t) {
                 if(edge_indicators_(s, t) == 0 || s == t) continue;
                 int loc = (s < t) ? disc_index_cache_(s, t) : disc_index_cache_(t, s);
@@ -409,17 +415,17 @@ std::pair<double, arma::vec> MixedMRFModel::logp_and_gradient(
             }
 
             // Pairwise_cross gradient from marginal OMRF (same structure as ordinal)
-            arma::vec E_sq = logz_out_.probs * sq_score;
+            double sum_E_sq = arma::dot(logz_moments_.prob_sums, sq_score);
 
-            arma::vec diff_pw = discrete_observations_dbl_t_ *
-                (discrete_observations_dbl_.col(s) - E);
+            arma::vec diff_pw = data_->discrete_observations_dbl_t *
+                (data_->discrete_observations_dbl.col(s) - E);
             diff_pw(s) = 0.0;
 
             double diff_diag = arma::dot(
-                discrete_observations_dbl_.col(s),
-                discrete_observations_dbl_.col(s)) - arma::accu(E_sq);
+                data_->discrete_observations_dbl.col(s),
+                data_->discrete_observations_dbl.col(s)) - sum_E_sq;
 
-            double sum_obs_minus_E = arma::accu(discrete_observations_dbl_.col(s)) - arma::accu(E);
+            double sum_obs_minus_E = arma::accu(data_->discrete_observations_dbl.col(s)) - arma::accu(E);
 
             // Accumulate Θ̄ for precision gradient coupling
             for(size_t t = 0; t < p_; ++t) {
@@ -465,15 +471,15 @@ std::pair<double, arma::vec> MixedMRFModel::logp_and_gradient(
         int C_s = num_categories_(s);
         arma::vec rest;
         double precision_ss = temp_marginal(s, s);
-        rest = 2.0 * (discrete_observations_dbl_ * temp_marginal.col(s)
-                    - discrete_observations_dbl_.col(s) * precision_ss)
+        rest = 2.0 * (data_->discrete_observations_dbl * temp_marginal.col(s)
+                    - data_->discrete_observations_dbl.col(s) * precision_ss)
              + 2.0 * arma::dot(temp_pairwise_cross.row(s), temp_main_continuous);
         // Marginal self-interaction quadratic contribution
         logp += precision_ss * arma::dot(
-            discrete_observations_dbl_.col(s),
-            discrete_observations_dbl_.col(s));
+            data_->discrete_observations_dbl.col(s),
+            data_->discrete_observations_dbl.col(s));
         // Numerator: dot(x_s, rest) + main-effect sums
-        logp += arma::dot(discrete_observations_dbl_.col(s), rest);
+        logp += arma::dot(data_->discrete_observations_dbl.col(s), rest);
 
         if(is_ordinal_variable_(s)) {
             for(int c = 1; c <= C_s; ++c) {
@@ -514,7 +520,7 @@ std::pair<double, arma::vec> MixedMRFModel::logp_and_gradient(
     //   = trace(Θ D' · 2 x_s [Σ_yy]_{j,:})
     //   = 2 [x_s' D Θ Σ_yy]_j
     //   = 2 [x_s' D]_j    (since Θ Σ_yy = I)
-    arma::mat grad_pairwise_effects_cross_ggm = 2.0 * discrete_observations_dbl_t_ * D;  // p x q
+    arma::mat grad_pairwise_effects_cross_ggm = 2.0 * data_->discrete_observations_dbl_t * D;  // p x q
 
     for(size_t i = 0; i < p_; ++i) {
         for(size_t j = 0; j < q_; ++j) {
@@ -528,55 +534,42 @@ std::pair<double, arma::vec> MixedMRFModel::logp_and_gradient(
     // Part 3: Prior log-densities and gradient contributions
     // =========================================================================
 
+    // Each prior is evaluated once, over all of its terms (see PriorBatch)
+    PriorBatch threshold_terms(num_main_);
+    PriorBatch interaction_terms(num_pairwise_xx_ + num_cross_);
+    PriorBatch means_terms(q_);
+
     // --- main_effects_discrete_ priors ---
     main_effects_discrete_offset = 0;
     for(size_t s = 0; s < p_; ++s) {
-        if(is_ordinal_variable_(s)) {
-            int C_s = num_categories_(s);
-            for(int c = 0; c < C_s; ++c) {
-                double val = temp_main_discrete(s, c);
-                logp += threshold_prior_->logp(val);
-                grad(main_effects_discrete_offset + c) += threshold_prior_->grad(val);
-            }
-            main_effects_discrete_offset += C_s;
-        } else {
-            for(int k = 0; k < 2; ++k) {
-                double val = temp_main_discrete(s, k);
-                logp += threshold_prior_->logp(val);
-                grad(main_effects_discrete_offset + k) += threshold_prior_->grad(val);
-            }
-            main_effects_discrete_offset += 2;
+        const int num_terms = is_ordinal_variable_(s) ? num_categories_(s) : 2;
+        for(int c = 0; c < num_terms; ++c) {
+            threshold_terms.add(temp_main_discrete(s, c), main_effects_discrete_offset + c);
         }
+        main_effects_discrete_offset += num_terms;
     }
+    logp += threshold_terms.evaluate(*threshold_prior_, grad);
 
-    // --- pairwise_effects_discrete_ priors ---
+    // --- pairwise_effects_discrete_ and pairwise_effects_cross_ priors ---
     for(size_t i = 0; i < p_ - 1; ++i) {
         for(size_t j = i + 1; j < p_; ++j) {
             if(edge_indicators_(i, j) == 0) continue;
-            int loc = disc_index_cache_(i, j);
-            double val = temp_pairwise_discrete(i, j);
-            logp += interaction_prior_->logp(val);
-            grad(loc) += interaction_prior_->grad(val);
+            interaction_terms.add(temp_pairwise_discrete(i, j), disc_index_cache_(i, j));
         }
     }
-
-    // --- main_effects_continuous_ priors: Normal(0, 1) ---
-    for(size_t j = 0; j < q_; ++j) {
-        double val = temp_main_continuous(j);
-        logp += means_prior_->logp(val);
-        grad(main_effects_continuous_grad_offset_ + j) += means_prior_->grad(val);
-    }
-
-    // --- pairwise_effects_cross_ priors ---
     for(size_t i = 0; i < p_; ++i) {
         for(size_t j = 0; j < q_; ++j) {
             if(edge_indicators_(i, p_ + j) == 0) continue;
-            int loc = cross_index_cache_(i, j);
-            double val = temp_pairwise_cross(i, j);
-            logp += interaction_prior_->logp(val);
-            grad(loc) += interaction_prior_->grad(val);
+            interaction_terms.add(temp_pairwise_cross(i, j), cross_index_cache_(i, j));
         }
     }
+    logp += interaction_terms.evaluate(*interaction_prior_, grad);
+
+    // --- main_effects_continuous_ priors: Normal(0, 1) ---
+    for(size_t j = 0; j < q_; ++j) {
+        means_terms.add(temp_main_continuous(j), main_effects_continuous_grad_offset_ + j);
+    }
+    logp += means_terms.evaluate(*means_prior_, grad);
 
     // =========================================================================
     // Part 4: Precision gradient via Cholesky parameterization
@@ -595,7 +588,7 @@ std::pair<double, arma::vec> MixedMRFModel::logp_and_gradient(
     // ∂ℓ/∂Σ_{ab} from GGM conditional = 2 [A_xy^T X^T D Ω]_{ab}
     // Mapping: ∂ℓ/∂Ω += −Σ (∂ℓ/∂Σ) Σ = −2 Σ A_xy^T X^T D
     Omega_bar -= 2.0 * temp_covariance * temp_pairwise_cross.t()
-               * discrete_observations_dbl_t_ * D;
+               * data_->discrete_observations_dbl_t * D;
 
     // --- Phase 2b: Marginal PL coupling through M ---
     // M = A_xx + 2 A_xy Σ A_xy^T depends on Σ
@@ -609,11 +602,11 @@ std::pair<double, arma::vec> MixedMRFModel::logp_and_gradient(
     // Prior on the partial-association diagonal: -K_yy_{jj} = Theta_{jj}/2.
     //   logp uses 0.5 * Theta_jj.
     //   d/dTheta_jj log p(Theta_jj/2) = 0.5 * grad(Theta_jj/2).
+    PriorBatch diagonal_terms(q_);
     for(size_t j = 0; j < q_; ++j) {
-        double half_kjj = 0.5 * temp_precision(j, j);
-        logp += diagonal_prior_->logp(half_kjj);
-        Omega_bar(j, j) += 0.5 * diagonal_prior_->grad(half_kjj);
+        diagonal_terms.add(0.5 * temp_precision(j, j), j * q_ + j);
     }
+    logp += diagonal_terms.evaluate(*diagonal_prior_, Omega_bar, 0.5);
     // Interaction prior on off-diagonal Kyy_{ij} = -Ω_{ij}/2 (upper triangle only).
     // Gated on edge_indicators_: inactive edges have K_yy_{ij} = 0 (point mass)
     // and contribute no slab density, matching the GGM convention at
@@ -622,14 +615,14 @@ std::pair<double, arma::vec> MixedMRFModel::logp_and_gradient(
     // Ω̄ + Ω̄ᵀ in Phase 4 handles the lower triangle automatically.
     // The prior is on Kyy_{ij}, so we evaluate at -Ω_{ij}/2 and apply
     // chain rule: ∂logπ/∂Ω_{ij} = ∂logπ/∂Kyy_{ij} · (-1/2).
+    PriorBatch kyy_terms(q_ * (q_ - 1) / 2);
     for(size_t i = 0; i < q_ - 1; ++i) {
         for(size_t j = i + 1; j < q_; ++j) {
             if(edge_indicators_(p_ + i, p_ + j) == 0) continue;
-            double kyy_val = -0.5 * temp_precision(i, j);
-            logp += interaction_prior_->logp(kyy_val);
-            Omega_bar(i, j) += -0.5 * interaction_prior_->grad(kyy_val);
+            kyy_terms.add(-0.5 * temp_precision(i, j), j * q_ + i);
         }
     }
+    logp += kyy_terms.evaluate(*interaction_prior_, Omega_bar, -0.5);
 
     // --- Phase 4: Map Ω̄ → R̄ → position gradient ---
     // R̄ = R (Ω̄ + Ω̄^T)
@@ -739,6 +732,8 @@ std::pair<double, arma::vec> MixedMRFModel::logp_and_gradient(
 std::pair<double, arma::vec> MixedMRFModel::logp_and_gradient_full(
     const arma::vec& x)
 {
+    BGMS_PROFILE_SCOPE(Gradient);
+    prepare_gradient_data();
     ensure_constraint_structure();
     const size_t full_dim = full_parameter_dimension();
 
@@ -812,8 +807,8 @@ std::pair<double, arma::vec> MixedMRFModel::logp_and_gradient_full(
 
     // --- Derived quantities ---
     arma::mat temp_cond_mean = arma::repmat(temp_main_continuous.t(), n_, 1)
-                             + 2.0 * discrete_observations_dbl_ * temp_pairwise_cross * temp_covariance;
-    arma::mat D = continuous_observations_ - temp_cond_mean;
+                             + 2.0 * data_->discrete_observations_dbl * temp_pairwise_cross * temp_covariance;
+    arma::mat D = data_->continuous_observations - temp_cond_mean;
 
     arma::mat temp_marginal;
     temp_marginal = temp_pairwise_discrete + 2.0 * temp_pairwise_cross * temp_covariance * temp_pairwise_cross.t();
@@ -870,8 +865,8 @@ std::pair<double, arma::vec> MixedMRFModel::logp_and_gradient_full(
     for(size_t i = 0; i < p_ - 1; ++i) {
         for(size_t j = i + 1; j < p_; ++j) {
             grad(kxx_idx(i, j)) = 4.0 * arma::dot(
-                discrete_observations_dbl_.col(i),
-                discrete_observations_dbl_.col(j));
+                data_->discrete_observations_dbl.col(i),
+                data_->discrete_observations_dbl.col(j));
         }
     }
 
@@ -883,8 +878,8 @@ std::pair<double, arma::vec> MixedMRFModel::logp_and_gradient_full(
         // Rest score
         arma::vec rest;
         double precision_ss = temp_marginal(s, s);
-        rest = 2.0 * (discrete_observations_dbl_ * temp_marginal.col(s)
-                    - discrete_observations_dbl_.col(s) * precision_ss)
+        rest = 2.0 * (data_->discrete_observations_dbl * temp_marginal.col(s)
+                    - data_->discrete_observations_dbl.col(s) * precision_ss)
              + 2.0 * arma::dot(temp_pairwise_cross.row(s), temp_main_continuous);
 
         if(is_ordinal_variable_(s)) {
@@ -898,22 +893,22 @@ std::pair<double, arma::vec> MixedMRFModel::logp_and_gradient_full(
             arma::vec bound = main_param(C_s - 1) + static_cast<double>(C_s) * rest;
             bound = arma::max(bound, arma::zeros<arma::vec>(bound.n_elem));
 
-            compute_logZ_and_probs_ordinal_into(
-                main_param, rest, bound, C_s, logz_out_, logz_scratch_
+            logz_kernels_[s].ordinal_moments(
+                main_param, rest, bound, C_s, logz_moments_, logz_scratch_, nullptr
             );
 
-            logp -= arma::accu(logz_out_.log_Z);
+            logp -= logz_moments_.log_Z_sum;
 
             // Main-effect gradient
             for(int c = 0; c < C_s; ++c) {
-                grad(main_effects_discrete_offset + c) -= arma::accu(logz_out_.probs.col(c + 1));
+                grad(main_effects_discrete_offset + c) -= logz_moments_.prob_sums(c + 1);
             }
 
             arma::vec weights = arma::regspace<arma::vec>(1, C_s);
-            arma::vec E = logz_out_.probs.cols(1, C_s) * weights;
+            const arma::vec& E = logz_moments_.E;
 
             // Pairwise discrete gradient (ALL edges, no gating)
-            arma::vec pw_grad = discrete_observations_dbl_t_ * E;
+            arma::vec pw_grad = data_->discrete_observations_dbl_t * E;
             for(size_t t = 0; t < p_; ++t) {
                 if(s == t) continue;
                 size_t loc = (s < t) ? kxx_idx(s, t) : kxx_idx(t, s);
@@ -921,17 +916,17 @@ std::pair<double, arma::vec> MixedMRFModel::logp_and_gradient_full(
             }
 
             arma::vec weights_sq = arma::square(weights);
-            arma::vec E_sq = logz_out_.probs.cols(1, C_s) * weights_sq;
+            double sum_E_sq = arma::dot(logz_moments_.prob_sums.tail(C_s), weights_sq);
 
-            arma::vec diff_pw = discrete_observations_dbl_t_ *
-                (discrete_observations_dbl_.col(s) - E);
+            arma::vec diff_pw = data_->discrete_observations_dbl_t *
+                (data_->discrete_observations_dbl.col(s) - E);
             diff_pw(s) = 0.0;
 
             double diff_diag = arma::dot(
-                discrete_observations_dbl_.col(s),
-                discrete_observations_dbl_.col(s)) - arma::accu(E_sq);
+                data_->discrete_observations_dbl.col(s),
+                data_->discrete_observations_dbl.col(s)) - sum_E_sq;
 
-            double sum_obs_minus_E = arma::accu(discrete_observations_dbl_.col(s)) - arma::accu(E);
+            double sum_obs_minus_E = arma::accu(data_->discrete_observations_dbl.col(s)) - arma::accu(E);
 
             for(size_t t = 0; t < p_; ++t) {
                 if(t != s) Theta_bar(s, t) += 2.0 * diff_pw(t);
@@ -968,40 +963,39 @@ std::pair<double, arma::vec> MixedMRFModel::logp_and_gradient_full(
             double effective_quad = quad_eff;
             effective_quad += temp_marginal(s, s);
 
-            arma::vec bc_bound;
-            compute_logZ_and_probs_blume_capel_into(
-                rest, lin_eff, effective_quad, ref, C_s, bc_bound,
-                logz_out_, logz_scratch_
+            logz_kernels_[s].blume_capel_moments(
+                rest, lin_eff, effective_quad, ref, C_s,
+                logz_moments_, logz_scratch_, nullptr
             );
 
-            logp -= arma::accu(logz_out_.log_Z);
+            logp -= logz_moments_.log_Z_sum;
 
             arma::vec score = arma::regspace<arma::vec>(0, C_s) - static_cast<double>(ref);
             arma::vec sq_score = arma::square(score);
 
-            grad(main_effects_discrete_offset)     -= arma::accu(logz_out_.probs * score);
-            grad(main_effects_discrete_offset + 1) -= arma::accu(logz_out_.probs * sq_score);
+            grad(main_effects_discrete_offset)     -= arma::dot(logz_moments_.prob_sums, score);
+            grad(main_effects_discrete_offset + 1) -= arma::dot(logz_moments_.prob_sums, sq_score);
 
-            arma::vec E = logz_out_.probs * score;
+            const arma::vec& E = logz_moments_.E;
 
-            arma::vec pw_grad = discrete_observations_dbl_t_ * E;
+            arma::vec pw_grad = data_->discrete_observations_dbl_t * E;
             for(size_t t = 0; t < p_; ++t) {
                 if(s == t) continue;
                 size_t loc = (s < t) ? kxx_idx(s, t) : kxx_idx(t, s);
                 grad(loc) -= 2.0 * pw_grad(t);
             }
 
-            arma::vec E_sq = logz_out_.probs * sq_score;
+            double sum_E_sq = arma::dot(logz_moments_.prob_sums, sq_score);
 
-            arma::vec diff_pw = discrete_observations_dbl_t_ *
-                (discrete_observations_dbl_.col(s) - E);
+            arma::vec diff_pw = data_->discrete_observations_dbl_t *
+                (data_->discrete_observations_dbl.col(s) - E);
             diff_pw(s) = 0.0;
 
             double diff_diag = arma::dot(
-                discrete_observations_dbl_.col(s),
-                discrete_observations_dbl_.col(s)) - arma::accu(E_sq);
+                data_->discrete_observations_dbl.col(s),
+                data_->discrete_observations_dbl.col(s)) - sum_E_sq;
 
-            double sum_obs_minus_E = arma::accu(discrete_observations_dbl_.col(s)) - arma::accu(E);
+            double sum_obs_minus_E = arma::accu(data_->discrete_observations_dbl.col(s)) - arma::accu(E);
 
             for(size_t t = 0; t < p_; ++t) {
                 if(t != s) Theta_bar(s, t) += 2.0 * diff_pw(t);
@@ -1038,13 +1032,13 @@ std::pair<double, arma::vec> MixedMRFModel::logp_and_gradient_full(
         int C_s = num_categories_(s);
         arma::vec rest;
         double precision_ss = temp_marginal(s, s);
-        rest = 2.0 * (discrete_observations_dbl_ * temp_marginal.col(s)
-                    - discrete_observations_dbl_.col(s) * precision_ss)
+        rest = 2.0 * (data_->discrete_observations_dbl * temp_marginal.col(s)
+                    - data_->discrete_observations_dbl.col(s) * precision_ss)
              + 2.0 * arma::dot(temp_pairwise_cross.row(s), temp_main_continuous);
         logp += precision_ss * arma::dot(
-            discrete_observations_dbl_.col(s),
-            discrete_observations_dbl_.col(s));
-        logp += arma::dot(discrete_observations_dbl_.col(s), rest);
+            data_->discrete_observations_dbl.col(s),
+            data_->discrete_observations_dbl.col(s));
+        logp += arma::dot(data_->discrete_observations_dbl.col(s), rest);
 
         if(is_ordinal_variable_(s)) {
             for(int c = 1; c <= C_s; ++c) {
@@ -1072,7 +1066,7 @@ std::pair<double, arma::vec> MixedMRFModel::logp_and_gradient_full(
         grad(mean_offset + j) += grad_mean_ggm(j);
     }
 
-    arma::mat grad_cross_ggm = 2.0 * discrete_observations_dbl_t_ * D;
+    arma::mat grad_cross_ggm = 2.0 * data_->discrete_observations_dbl_t * D;
     for(size_t i = 0; i < p_; ++i) {
         for(size_t j = 0; j < q_; ++j) {
             grad(kxy_idx(i, j)) += grad_cross_ggm(i, j);
@@ -1083,55 +1077,44 @@ std::pair<double, arma::vec> MixedMRFModel::logp_and_gradient_full(
     // Part 3: Priors
     // =========================================================================
 
+    // Each prior is evaluated once, over all of its terms (see PriorBatch)
+    PriorBatch threshold_terms(num_main_);
+    PriorBatch interaction_terms(num_pairwise_xx_ + num_cross_);
+    PriorBatch means_terms(q_);
+
     // Main effects priors
     main_effects_discrete_offset = 0;
     for(size_t s = 0; s < p_; ++s) {
-        if(is_ordinal_variable_(s)) {
-            int C_s = num_categories_(s);
-            for(int c = 0; c < C_s; ++c) {
-                double val = temp_main_discrete(s, c);
-                logp += threshold_prior_->logp(val);
-                grad(main_effects_discrete_offset + c) += threshold_prior_->grad(val);
-            }
-            main_effects_discrete_offset += C_s;
-        } else {
-            for(int k = 0; k < 2; ++k) {
-                double val = temp_main_discrete(s, k);
-                logp += threshold_prior_->logp(val);
-                grad(main_effects_discrete_offset + k) += threshold_prior_->grad(val);
-            }
-            main_effects_discrete_offset += 2;
+        const int num_terms = is_ordinal_variable_(s) ? num_categories_(s) : 2;
+        for(int c = 0; c < num_terms; ++c) {
+            threshold_terms.add(temp_main_discrete(s, c), main_effects_discrete_offset + c);
         }
+        main_effects_discrete_offset += num_terms;
     }
+    logp += threshold_terms.evaluate(*threshold_prior_, grad);
 
-    // Kxx priors. Gated on edge_indicators_: inactive edges have K_xx_{ij} = 0
-    // (point mass) and contribute no slab density. Matches the GGM convention.
+    // Kxx and Kxy priors. Gated on edge_indicators_: inactive edges have
+    // K_{ij} = 0 (point mass) and contribute no slab density. Matches the
+    // GGM convention.
     for(size_t i = 0; i < p_ - 1; ++i) {
         for(size_t j = i + 1; j < p_; ++j) {
             if(edge_indicators_(i, j) == 0) continue;
-            double val = temp_pairwise_discrete(i, j);
-            logp += interaction_prior_->logp(val);
-            grad(kxx_idx(i, j)) += interaction_prior_->grad(val);
+            interaction_terms.add(temp_pairwise_discrete(i, j), kxx_idx(i, j));
         }
     }
-
-    // Continuous mean priors: Normal(0, 1)
-    for(size_t j = 0; j < q_; ++j) {
-        double val = temp_main_continuous(j);
-        logp += means_prior_->logp(val);
-        grad(mean_offset + j) += means_prior_->grad(val);
-    }
-
-    // Kxy priors. Gated on edge_indicators_: inactive edges have K_xy_{ij} = 0
-    // (point mass) and contribute no slab density.
     for(size_t i = 0; i < p_; ++i) {
         for(size_t j = 0; j < q_; ++j) {
             if(edge_indicators_(i, p_ + j) == 0) continue;
-            double val = temp_pairwise_cross(i, j);
-            logp += interaction_prior_->logp(val);
-            grad(kxy_idx(i, j)) += interaction_prior_->grad(val);
+            interaction_terms.add(temp_pairwise_cross(i, j), kxy_idx(i, j));
         }
     }
+    logp += interaction_terms.evaluate(*interaction_prior_, grad);
+
+    // Continuous mean priors: Normal(0, 1)
+    for(size_t j = 0; j < q_; ++j) {
+        means_terms.add(temp_main_continuous(j), mean_offset + j);
+    }
+    logp += means_terms.evaluate(*means_prior_, grad);
 
     // =========================================================================
     // Part 4: Precision gradient via Cholesky parameterization
@@ -1141,31 +1124,31 @@ std::pair<double, arma::vec> MixedMRFModel::logp_and_gradient_full(
                         - 0.5 * D.t() * D;
 
     Omega_bar -= 2.0 * temp_covariance * temp_pairwise_cross.t()
-               * discrete_observations_dbl_t_ * D;
+               * data_->discrete_observations_dbl_t * D;
 
     Omega_bar -= 2.0 * temp_covariance * temp_pairwise_cross.t()
                * Theta_bar * temp_pairwise_cross * temp_covariance;
 
     // Prior on the partial-association diagonal: -K_yy_{jj} = Theta_{jj}/2.
     //   d/dTheta_jj log p(Theta_jj/2) = 0.5 * grad(Theta_jj/2).
+    PriorBatch diagonal_terms(q_);
     for(size_t j = 0; j < q_; ++j) {
-        double half_kjj = 0.5 * temp_precision(j, j);
-        logp += diagonal_prior_->logp(half_kjj);
-        Omega_bar(j, j) += 0.5 * diagonal_prior_->grad(half_kjj);
+        diagonal_terms.add(0.5 * temp_precision(j, j), j * q_ + j);
     }
+    logp += diagonal_terms.evaluate(*diagonal_prior_, Omega_bar, 0.5);
     // Interaction prior on off-diagonal Kyy_{ij} = -Ω_{ij}/2.
     // Gated on edge_indicators_: inactive edges have K_yy_{ij} = 0 (point mass)
     // and contribute no slab density, matching the GGM convention at
     // ggm_gradient.cpp where the slab is summed over included_indices only.
     // Chain rule: ∂logπ/∂Ω_{ij} = ∂logπ/∂Kyy_{ij} · (-1/2)
+    PriorBatch kyy_terms(q_ * (q_ - 1) / 2);
     for(size_t i = 0; i < q_ - 1; ++i) {
         for(size_t j = i + 1; j < q_; ++j) {
             if(edge_indicators_(p_ + i, p_ + j) == 0) continue;
-            double kyy_val = -0.5 * temp_precision(i, j);
-            logp += interaction_prior_->logp(kyy_val);
-            Omega_bar(i, j) += -0.5 * interaction_prior_->grad(kyy_val);
+            kyy_terms.add(-0.5 * temp_precision(i, j), j * q_ + i);
         }
     }
+    logp += kyy_terms.evaluate(*interaction_prior_, Omega_bar, -0.5);
 
     // R̄ = R (Ω̄ + Ω̄ᵀ)
     arma::mat Omega_bar_sym = Omega_bar + Omega_bar.t();
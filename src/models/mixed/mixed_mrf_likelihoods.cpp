@@ -5,6 +5,7 @@
 // (discrete block). Consumed by the gradient and Metropolis update bodies in the
 // sibling translation units.
 #include <RcppArmadillo.h>
+#include <utility>
 #include "models/mixed/mixed_mrf_model.h"
 #include "utils/variable_helpers.h"
 #include "math/explog_macros.h"
@@ -29,15 +30,18 @@ double MixedMRFModel::log_marginal_omrf(int s) const {
 
     // Rest score: 2 · M · x minus self-interaction, plus cross-bias.
     // Factor 2 from x'Mx derivative.
+    // Built in place in the workspace, in the same operation order.
     double precision_ss = marginal_interactions_(s, s);
-    arma::vec rest = 2.0 * (discrete_observations_dbl_ * marginal_interactions_.col(s)
-                          - discrete_observations_dbl_.col(s) * precision_ss)
-                   + 2.0 * arma::dot(pairwise_effects_cross_.row(s), main_effects_continuous_);
+    arma::vec& rest = mh_workspace_.rest;
+    rest = data_->discrete_observations_dbl * marginal_interactions_.col(s);
+    rest -= data_->discrete_observations_dbl.col(s) * precision_ss;
+    rest *= 2.0;
+    rest += 2.0 * arma::dot(pairwise_effects_cross_.row(s), main_effects_continuous_);
 
     // Numerator: dot(x_s, rest) + precision_ss * dot(x_s, x_s) + main effects
-    double numer = arma::dot(discrete_observations_dbl_.col(s), rest)
-                 + precision_ss * arma::dot(discrete_observations_dbl_.col(s),
-                                        discrete_observations_dbl_.col(s));
+    double numer = arma::dot(data_->discrete_observations_dbl.col(s), rest)
+                 + precision_ss * arma::dot(data_->discrete_observations_dbl.col(s),
+                                        data_->discrete_observations_dbl.col(s));
 
     if(is_ordinal_variable_(s)) {
         for(int c = 1; c <= C_s; ++c) {
@@ -50,8 +54,9 @@ double MixedMRFModel::log_marginal_omrf(int s) const {
             main_param(c) = main_effects_discrete_(s, c) + static_cast<double>((c + 1) * (c + 1)) * precision_ss;
         }
 
-        arma::vec bound = static_cast<double>(C_s) * rest;
-        arma::vec denom = compute_denom_ordinal(rest, main_param, bound);
+        arma::vec& bound = mh_workspace_.bound;
+        bound = static_cast<double>(C_s) * rest;
+        arma::vec denom = logz_kernels_[s].ordinal_denom(rest, main_param, bound);
 
         return numer - arma::accu(bound + ARMA_MY_LOG(denom));
     } else {
@@ -65,8 +70,8 @@ double MixedMRFModel::log_marginal_omrf(int s) const {
         int ref = baseline_category_(s);
         double effective_beta = beta + precision_ss;
 
-        arma::vec bound;
-        arma::vec denom = compute_denom_blume_capel(
+        arma::vec& bound = mh_workspace_.bound;
+        arma::vec denom = logz_kernels_[s].blume_capel_denom(
             rest, alpha, effective_beta, ref, C_s, bound
         );
 
@@ -75,6 +80,61 @@ double MixedMRFModel::log_marginal_omrf(int s) const {
 }
 
 
+// =============================================================================
+// log_marginal_omrf_shifted
+// =============================================================================
+// log_marginal_omrf(s) after moving M_{s,partner} by delta, through the
+// moments kernel so the expected scores E_s come along for the surrogate
+// gradient of the delayed-acceptance moves. M is linear in A_xx, so the
+// move only shifts the rest score by 2 delta x_partner and M_ss stays put.
+// =============================================================================
+
+double MixedMRFModel::log_marginal_omrf_shifted(int s, int partner, double delta,
+                                                arma::vec& expected_score) const {
+    int C_s = num_categories_(s);
+    const arma::mat& x = data_->discrete_observations_dbl;
+
+    double precision_ss = marginal_interactions_(s, s);
+    arma::vec& rest = mh_workspace_.rest;
+    rest = x * marginal_interactions_.col(s);
+    rest -= x.col(s) * precision_ss;
+    rest *= 2.0;
+    rest += 2.0 * arma::dot(pairwise_effects_cross_.row(s), main_effects_continuous_);
+    if(delta != 0.0) {
+        rest += (2.0 * delta) * x.col(partner);
+    }
+
+    double numer = arma::dot(x.col(s), rest) + precision_ss * arma::dot(x.col(s), x.col(s));
+
+    if(is_ordinal_variable_(s)) {
+        arma::vec main_param(C_s);
+        for(int c = 1; c <= C_s; ++c) {
+            numer += static_cast<double>(counts_per_category_(c, s)) * main_effects_discrete_(s, c - 1);
+            main_param(c - 1) = main_effects_discrete_(s, c - 1) + static_cast<double>(c * c) * precision_ss;
+        }
+
+        arma::vec& bound = mh_workspace_.bound;
+        bound = static_cast<double>(C_s) * rest;
+        logz_kernels_[s].ordinal_moments(
+            main_param, rest, bound, C_s, logz_moments_, logz_scratch_, nullptr
+        );
+    } else {
+        double alpha = main_effects_discrete_(s, 0);
+        double beta = main_effects_discrete_(s, 1);
+        numer += alpha * static_cast<double>(blume_capel_stats_(0, s))
+               + beta * static_cast<double>(blume_capel_stats_(1, s));
+
+        logz_kernels_[s].blume_capel_moments(
+            rest, alpha, beta + precision_ss, baseline_category_(s), C_s,
+            logz_moments_, logz_scratch_, nullptr
+        );
+    }
+
+    std::swap(expected_score, logz_moments_.E);
+    return numer - logz_moments_.log_Z_sum;
+}
+
+
 // =============================================================================
 // log_conditional_ggm
 // =============================================================================
@@ -86,10 +146,13 @@ double MixedMRFModel::log_marginal_omrf(int s) const {
 // =============================================================================
 
 double MixedMRFModel::log_conditional_ggm() const {
-    arma::mat D = continuous_observations_ - conditional_mean_;
+    arma::mat& D = mh_workspace_.residual;
+    arma::mat& DA = mh_workspace_.residual_precision;
+    D = data_->continuous_observations - conditional_mean_;
+    DA = D * pairwise_effects_continuous_;
 
-    // Quadratic form: trace(Precision D'D)
-    double quad_sum = arma::accu((D * (-2.0 * pairwise_effects_continuous_)) % D);
+    // Quadratic form: trace(Precision D'D), Precision = -2 A_yy
+    double quad_sum = -2.0 * arma::accu(DA % D);
 
     return static_cast<double>(n_) / 2.0 *
            (-static_cast<double>(q_) * MY_LOG(2.0 * arma::datum::pi)
@@ -6,6 +6,7 @@
 // cholesky_update_after_precision_* helpers. The load-bearing std::abs sign convention
 // in the det-ratio helpers must be preserved (see architecture.md, Numerical Considerations).
 #include <RcppArmadillo.h>
+#include <algorithm>
 #include <utility>
 #include "models/mixed/mixed_mrf_model.h"
 #include "rng/rng_utils.h"
@@ -20,26 +21,27 @@ namespace {
 // indicator) temporarily set pairwise_effects_continuous_, covariance_continuous_,
 // and marginal_interactions_ to proposed values, sum the OMRF marginals, then
 // must restore the accepted state regardless of the accept/reject outcome. This
-// snapshots those three fields on construction and restores them on scope exit,
-// replacing the open-coded save / mutate / recompute / restore dance.
+// snapshots those three fields into the workspace on construction and swaps
+// them back on scope exit, so neither side gives up its memory.
 struct ProposedContinuousState {
     arma::mat& pairwise;
     arma::mat& covariance;
     arma::mat& marginal;
-    arma::mat pairwise_saved;
-    arma::mat covariance_saved;
-    arma::mat marginal_saved;
+    MixedMHWorkspace& ws;
 
     ProposedContinuousState(arma::mat& pairwise_ref, arma::mat& covariance_ref,
-                            arma::mat& marginal_ref)
+                            arma::mat& marginal_ref, MixedMHWorkspace& workspace)
         : pairwise(pairwise_ref), covariance(covariance_ref), marginal(marginal_ref),
-          pairwise_saved(pairwise_ref), covariance_saved(covariance_ref),
-          marginal_saved(marginal_ref) {}
+          ws(workspace) {
+        ws.pairwise_saved = pairwise;
+        ws.covariance_saved = covariance;
+        ws.marginal_saved = marginal;
+    }
 
     ~ProposedContinuousState() {
-        pairwise = std::move(pairwise_saved);
-        covariance = std::move(covariance_saved);
-        marginal = std::move(marginal_saved);
+        pairwise.swap(ws.pairwise_saved);
+        covariance.swap(ws.covariance_saved);
+        marginal.swap(ws.marginal_saved);
     }
 
     ProposedContinuousState(const ProposedContinuousState&) = delete;
@@ -90,6 +92,41 @@ double MixedMRFModel::update_main_effect(int s, int c, std::optional<double> rm_
 }
 
 
+// =============================================================================
+// update_main_effect_block
+// =============================================================================
+// Joint MH update of all main effects of discrete variable s, proposed by
+// block_main_. The accept/reject uses log_marginal_omrf(s) plus the
+// threshold prior of every parameter in the block.
+// =============================================================================
+
+double MixedMRFModel::update_main_effect_block(int s, int iteration) {
+    const int size = is_ordinal_variable_(s) ? num_categories_(s) : 2;
+    const arma::span block(0, size - 1);
+    const arma::vec current = main_effects_discrete_(s, block).t();
+    const arma::vec proposed = block_main_.propose(s, current, rng_);
+
+    auto log_prior = [&](const arma::vec& theta) {
+        double lp = 0.0;
+        for(int k = 0; k < size; ++k) lp += threshold_prior_->logp(theta(k));
+        return lp;
+    };
+
+    double ll_curr = log_marginal_omrf(s) + log_prior(current);
+    main_effects_discrete_(s, block) = proposed.t();
+    double ll_prop = log_marginal_omrf(s) + log_prior(proposed);
+
+    double ln_alpha = ll_prop - ll_curr;
+    if(MY_LOG(runif(rng_)) >= ln_alpha) {
+        main_effects_discrete_(s, block) = current.t();  // reject
+    }
+
+    const double accept_prob = std::min(1.0, std::exp(ln_alpha));
+    block_main_.adapt(s, main_effects_discrete_(s, block).t(), accept_prob, iteration);
+    return accept_prob;
+}
+
+
 // =============================================================================
 // update_continuous_mean
 // =============================================================================
@@ -108,7 +145,7 @@ double MixedMRFModel::update_continuous_mean(int j, std::optional<double> rm_wei
         ll_curr += log_marginal_omrf(s);
 
     // Set proposed value and refresh conditional_mean_
-    arma::mat cond_mean_saved = conditional_mean_;
+    mh_workspace_.cond_mean_saved = conditional_mean_;
     main_effects_continuous_(j) = proposed;
     recompute_conditional_mean();
 
@@ -120,7 +157,7 @@ double MixedMRFModel::update_continuous_mean(int j, std::optional<double> rm_wei
 
     if(MY_LOG(runif(rng_)) >= ln_alpha) {
         main_effects_continuous_(j) = current_val;  // reject
-        conditional_mean_ = std::move(cond_mean_saved);
+        conditional_mean_.swap(mh_workspace_.cond_mean_saved);
     }
 
     if (rm_weight) {
@@ -143,6 +180,19 @@ double MixedMRFModel::update_pairwise_discrete(int i, int j, std::optional<doubl
     double current_val = pairwise_effects_discrete_(i, j);
     double proposed = rnorm(rng_, current_val, proposal_sd_pairwise_discrete_(i, j));
 
+    if(delayed_acceptance_.enabled && !rm_weight) {
+        double log_prior_ratio = interaction_prior_->logp(proposed)
+                               - interaction_prior_->logp(current_val);
+        double accept_prob;
+        if(delayed_acceptance_test_discrete(i, j, proposed - current_val, log_prior_ratio,
+                                            accept_prob)) {
+            pairwise_effects_discrete_(i, j) = proposed;
+            pairwise_effects_discrete_(j, i) = proposed;
+            recompute_marginal_interactions();
+        }
+        return accept_prob;
+    }
+
     // Current log-posterior
     double ll_curr = log_marginal_omrf(i) + log_marginal_omrf(j)
                    + interaction_prior_->logp(current_val);
@@ -170,6 +220,55 @@ double MixedMRFModel::update_pairwise_discrete(int i, int j, std::optional<doubl
 }
 
 
+// =============================================================================
+// delayed_acceptance_test_discrete
+// =============================================================================
+// Both stages of a delayed-acceptance move of pairwise_effects_discrete_(i, j)
+// (see DelayedAcceptance). The surrogate gradient is the derivative of
+// log_marginal_omrf(i) + log_marginal_omrf(j) in the effect,
+//   4 x_i'x_j - 2 x_j'E_i - 2 x_i'E_j,
+// and the proposed marginals are priced by shifting the rest scores, so no
+// marginal-interaction refresh is needed to evaluate the move.
+// =============================================================================
+
+bool MixedMRFModel::delayed_acceptance_test_discrete(int i, int j, double delta,
+                                                     double log_other, double& accept_prob) {
+    DelayedAcceptance& da = delayed_acceptance_;
+    MixedMHWorkspace& ws = mh_workspace_;
+    const arma::mat& x = data_->discrete_observations_dbl;
+    da.record_proposal();
+    accept_prob = 0.0;
+
+    auto gradient = [&](const arma::vec& score_i, const arma::vec& score_j) {
+        return 4.0 * arma::dot(x.col(i), x.col(j))
+             - 2.0 * arma::dot(x.col(j), score_i)
+             - 2.0 * arma::dot(x.col(i), score_j);
+    };
+
+    // Stage 1: quadratic surrogate around the current state
+    double ll_curr = log_marginal_omrf_shifted(i, j, 0.0, ws.score_i)
+                   + log_marginal_omrf_shifted(j, i, 0.0, ws.score_j);
+    double gradient_current = gradient(ws.score_i, ws.score_j);
+    double forward = da.surrogate(i, j, gradient_current, delta) + log_other;
+    if(MY_LOG(runif(rng_)) >= forward) return false;
+    da.record_first_stage_accept();
+
+    // Stage 2: exact ratio, and the surrogate of the reverse move
+    double ll_prop = log_marginal_omrf_shifted(i, j, delta, ws.score_prop_i)
+                   + log_marginal_omrf_shifted(j, i, delta, ws.score_prop_j);
+    double gradient_proposed = gradient(ws.score_prop_i, ws.score_prop_j);
+    double reverse = da.surrogate(i, j, gradient_proposed, -delta) - log_other;
+    da.learn(i, j, gradient_current, gradient_proposed, delta);
+
+    double ln_alpha = DelayedAcceptance::second_stage_log_ratio(
+        ll_prop - ll_curr + log_other, forward, reverse);
+    accept_prob = std::min(1.0, std::exp(ln_alpha));
+    if(MY_LOG(runif(rng_)) >= ln_alpha) return false;
+    da.record_second_stage_accept();
+    return true;
+}
+
+
 // =============================================================================
 // Rank-1 precision proposal helpers (permutation-free)
 // =============================================================================
@@ -209,8 +308,12 @@ double MixedMRFModel::precision_constrained_diagonal(double x) const {
 // matrix determinant lemma for the log-det part and Woodbury for the
 // quadratic-form part.  Assumes precision_proposal_ is filled.
 //
-// TODO: replace the O(npq + nq²) quadratic-form computation with
-// an O(nq) rank-2 shortcut.
+// The quadratic form is priced from the residual cache in O(nq). With
+// Yc = Y - μ_y', B = X A_xy and E = D Ω, the proposal gives
+//   D' = Yc - 2 B Σ'   and   D' Ω' = Yc Ω' - 2 B = E + Yc ΔΩ,
+// and ΔΩ touches columns i and j only. Writing Σ' - Σ as a rank-2 (or
+// rank-1) outer-product sum turns D' into D plus the matching corrections
+// in B, so tr(D' Ω' D'^T) - tr(D Ω D^T) needs only matrix-vector products.
 // =============================================================================
 
 double MixedMRFModel::log_det_ratio_yy_edge(int i, int j) const {
@@ -231,12 +334,14 @@ double MixedMRFModel::log_det_ratio_yy_diag(int i) const {
 }
 
 
-double MixedMRFModel::log_ggm_ratio_edge(int i, int j, arma::mat& cov_prop_out) const {
+double MixedMRFModel::log_ggm_ratio_edge(int i, int j) {
     size_t ui = static_cast<size_t>(i);
     size_t uj = static_cast<size_t>(j);
+    MixedMHWorkspace& ws = mh_workspace_;
 
-    // Current precision (positive-definite)
-    arma::mat precision_curr = -2.0 * pairwise_effects_continuous_;
+    // Current precision (positive-definite) at the changed entries
+    const double precision_ij = -2.0 * pairwise_effects_continuous_(ui, uj);
+    const double precision_jj = -2.0 * pairwise_effects_continuous_(uj, uj);
 
     // --- Log-determinant ratio via matrix determinant lemma ---
     // ΔΩ has 3 nonzero entries: (i,j), (j,i), (j,j).
@@ -244,8 +349,8 @@ double MixedMRFModel::log_ggm_ratio_edge(int i, int j, arma::mat& cov_prop_out)
     // drive the Woodbury covariance update below, so they are kept here; the
     // log-det ratio itself is the canonical rank-2 det-lemma in
     // log_det_ratio_yy_edge (recomputes the identical Ui/Uj internally).
-    double Ui = precision_curr(ui, uj) - precision_proposal_(ui, uj);
-    double Uj = (precision_curr(uj, uj) - precision_proposal_(uj, uj)) / 2.0;
+    double Ui = precision_ij - precision_proposal_(ui, uj);
+    double Uj = (precision_jj - precision_proposal_(uj, uj)) / 2.0;
 
     double logdet_ratio = log_det_ratio_yy_edge(i, j);
 
@@ -253,8 +358,10 @@ double MixedMRFModel::log_ggm_ratio_edge(int i, int j, arma::mat& cov_prop_out)
     // ΔΩ = vf1 vf2' + vf2 vf1' where vf1 = [0,...,-1,...] (j-th),
     //   vf2 = [0,...,Ui,...,Uj,...] (i-th and j-th).
     // s1 = Σ vf1 = -Σ[:,j], s2 = Σ vf2 = Ui*Σ[:,i] + Uj*Σ[:,j]
-    arma::vec s1 = -covariance_continuous_.col(uj);
-    arma::vec s2 = Ui * covariance_continuous_.col(ui) + Uj * covariance_continuous_.col(uj);
+    arma::vec& s1 = ws.s1;
+    arma::vec& s2 = ws.s2;
+    s1 = -covariance_continuous_.col(uj);
+    s2 = Ui * covariance_continuous_.col(ui) + Uj * covariance_continuous_.col(uj);
 
     // 2×2 core matrix T = I + [vf2,vf1]' [s1,s2]
     // T = [1 + vf2's1,  vf2's2;  vf1's1,  1 + vf1's2]
@@ -273,25 +380,40 @@ double MixedMRFModel::log_ggm_ratio_edge(int i, int j, arma::mat& cov_prop_out)
 
     // Σ' = Σ - [s1,s2] T^{-1} [s2',s1']
     //     = Σ - (inv_t11*s1 + inv_t21*s2)*s2' - (inv_t12*s1 + inv_t22*s2)*s1'
-    arma::vec w1 = inv_t11 * s1 + inv_t21 * s2;  // coefficient for s2' row
-    arma::vec w2 = inv_t12 * s1 + inv_t22 * s2;  // coefficient for s1' row
-    arma::mat cov_prop = covariance_continuous_ - w1 * s2.t() - w2 * s1.t();
-
-    // --- Proposed conditional mean ---
-    // M' = μ_y' + 2 X A_xy Σ'
-    arma::mat cond_mean_prop = arma::repmat(main_effects_continuous_.t(), n_, 1) +
-                               2.0 * discrete_observations_dbl_ * pairwise_effects_cross_ * cov_prop;
-
-    // --- Quadratic form difference ---
-    arma::mat D_curr = continuous_observations_ - conditional_mean_;
-    arma::mat D_prop = continuous_observations_ - cond_mean_prop;
-
-    double quad_curr = arma::accu((D_curr * precision_curr) % D_curr);
-    double quad_prop = arma::accu((D_prop * precision_proposal_) % D_prop);
+    // The two outer products are applied element-wise, without temporaries.
+    arma::vec& w1 = ws.w1;
+    arma::vec& w2 = ws.w2;
+    w1 = inv_t11 * s1 + inv_t21 * s2;  // coefficient for s2' row
+    w2 = inv_t12 * s1 + inv_t22 * s2;  // coefficient for s1' row
+    arma::mat& cov_prop = ws.cov_prop;
+    for(size_t c = 0; c < q_; ++c)
+        for(size_t r = 0; r < q_; ++r)
+            cov_prop(r, c) = covariance_continuous_(r, c) - w1(r) * s2(c) - w2(r) * s1(c);
+
+    // --- Quadratic form difference (rank-2 corrections) ---
+    // D' = D + 2 b1 s2' + 2 b2 s1' with b1 = B w1, b2 = B w2, and
+    // D' Ω' = E + F where F has columns fi (at i) and fj (at j).
+    ensure_residual_cache();
+    const double dij = precision_proposal_(ui, uj) - precision_ij;
+    const double djj = precision_proposal_(uj, uj) - precision_jj;
+    ws.yc_i = data_->continuous_observations.col(ui) - main_effects_continuous_(ui);
+    ws.yc_j = data_->continuous_observations.col(uj) - main_effects_continuous_(uj);
+    ws.fi = dij * ws.yc_j;
+    ws.fj = dij * ws.yc_i + djj * ws.yc_j;
+
+    ws.b1 = cross_projection_ * w1;
+    ws.b2 = cross_projection_ * w2;
+    ws.e1 = residual_precision_ * s1;
+    ws.e2 = residual_precision_ * s2;
+
+    double quad_diff =
+        arma::dot(ws.fi, residual_continuous_.col(ui)) +
+        arma::dot(ws.fj, residual_continuous_.col(uj)) +
+        2.0 * (arma::dot(ws.b1, ws.e2) + s2(ui) * arma::dot(ws.fi, ws.b1) + s2(uj) * arma::dot(ws.fj, ws.b1)) +
+        2.0 * (arma::dot(ws.b2, ws.e1) + s1(ui) * arma::dot(ws.fi, ws.b2) + s1(uj) * arma::dot(ws.fj, ws.b2));
 
     double n = static_cast<double>(n_);
-    cov_prop_out = std::move(cov_prop);
-    return n / 2.0 * logdet_ratio - (quad_prop - quad_curr) / 2.0;
+    return n / 2.0 * logdet_ratio - quad_diff / 2.0;
 }
 
 
@@ -302,8 +424,9 @@ double MixedMRFModel::log_ggm_ratio_edge(int i, int j, arma::mat& cov_prop_out)
 // Same structure as log_ggm_ratio_edge but simpler (Ui = 0).
 // =============================================================================
 
-double MixedMRFModel::log_ggm_ratio_diag(int i, arma::mat& cov_prop_out) const {
+double MixedMRFModel::log_ggm_ratio_diag(int i) {
     size_t ui = static_cast<size_t>(i);
+    MixedMHWorkspace& ws = mh_workspace_;
 
     // Current precision diagonal
     double precision_ii = -2.0 * pairwise_effects_continuous_(ui, ui);
@@ -318,26 +441,42 @@ double MixedMRFModel::log_ggm_ratio_diag(int i, arma::mat& cov_prop_out) const {
 
     // --- Proposed covariance via Sherman-Morrison (rank-1 special case) ---
     // ΔΩ = -2Uj * e_i e_i', so Σ' = Σ + 2Uj * Σ[:,i] Σ[i,:]' / (1 - 2Uj * Σ(i,i))
-    arma::vec s = covariance_continuous_.col(ui);
+    arma::vec& s = ws.s1;
+    s = covariance_continuous_.col(ui);
     double denom = 1.0 - 2.0 * Uj * covariance_continuous_(ui, ui);
-    arma::mat cov_prop = covariance_continuous_ + (2.0 * Uj / denom) * s * s.t();
-
-    // --- Proposed conditional mean ---
-    arma::mat cond_mean_prop = arma::repmat(main_effects_continuous_.t(), n_, 1) +
-                               2.0 * discrete_observations_dbl_ * pairwise_effects_cross_ * cov_prop;
+    const double c = 2.0 * Uj / denom;
+    arma::mat& cov_prop = ws.cov_prop;
+    for(size_t col = 0; col < q_; ++col)
+        for(size_t row = 0; row < q_; ++row)
+            cov_prop(row, col) = covariance_continuous_(row, col) + c * s(row) * s(col);
+
+    // --- Quadratic form difference (rank-1 correction) ---
+    // D' = D - 2c bs s' with bs = B s, and D' Ω' = E + F where F has the
+    // single column fi = d * Yc[:, i].
+    ensure_residual_cache();
+    const double d = precision_proposal_(ui, ui) - precision_ii;
+    ws.fi = d * (data_->continuous_observations.col(ui) - main_effects_continuous_(ui));
+    ws.b1 = cross_projection_ * s;
+    ws.e1 = residual_precision_ * s;
+
+    double quad_diff =
+        arma::dot(ws.fi, residual_continuous_.col(ui)) -
+        2.0 * c * (arma::dot(ws.b1, ws.e1) + s(ui) * arma::dot(ws.fi, ws.b1));
 
-    // --- Quadratic form difference ---
-    arma::mat D_curr = continuous_observations_ - conditional_mean_;
-    arma::mat D_prop = continuous_observations_ - cond_mean_prop;
+    double n = static_cast<double>(n_);
+    return n / 2.0 * logdet_ratio - quad_diff / 2.0;
+}
 
-    // Precision for quadratic form: only diagonal changed
-    arma::mat precision_curr = -2.0 * pairwise_effects_continuous_;
-    double quad_curr = arma::accu((D_curr * precision_curr) % D_curr);
-    double quad_prop = arma::accu((D_prop * precision_proposal_) % D_prop);
 
-    double n = static_cast<double>(n_);
-    cov_prop_out = std::move(cov_prop);
-    return n / 2.0 * logdet_ratio - (quad_prop - quad_curr) / 2.0;
+double MixedMRFModel::log_ggm_ratio(int i, int j, double precision_ij, double precision_jj) {
+    precision_proposal_ = -2.0 * pairwise_effects_continuous_;
+    precision_proposal_(j, j) = precision_jj;
+    if(i == j) {
+        return log_ggm_ratio_diag(j);
+    }
+    precision_proposal_(i, j) = precision_ij;
+    precision_proposal_(j, i) = precision_ij;
+    return log_ggm_ratio_edge(i, j);
 }
 
 
@@ -345,7 +484,8 @@ double MixedMRFModel::log_ggm_ratio_diag(int i, arma::mat& cov_prop_out) const {
 // cholesky_update_after_precision_edge
 // =============================================================================
 // Rank-2 Cholesky update after accepting an off-diagonal precision change.
-// Decomposes ΔΩ = vf1*vf2' + vf2*vf1' into two rank-1 ops.
+// Decomposes ΔΩ = vf1*vf2' + vf2*vf1' into an update and a downdate,
+// applied in one pass over the factor by cholesky_rank_update().
 // Then recomputes inv_cholesky_of_precision_ and covariance_continuous_.
 // =============================================================================
 
@@ -360,17 +500,18 @@ void MixedMRFModel::cholesky_update_after_precision_edge(
     cont_vf2_[i] = cont_v2_[0];
     cont_vf2_[j] = cont_v2_[1];
 
-    cont_u1_ = (cont_vf1_ + cont_vf2_) / std::sqrt(2.0);
-    cont_u2_ = (cont_vf1_ - cont_vf2_) / std::sqrt(2.0);
+    cont_rank2_factors_.col(0) = (cont_vf1_ + cont_vf2_) / std::sqrt(2.0);
+    cont_rank2_factors_.col(1) = (cont_vf1_ - cont_vf2_) / std::sqrt(2.0);
 
-    cholesky_update(cholesky_of_precision_, cont_u1_);
-    cholesky_downdate(cholesky_of_precision_, cont_u2_);
+    const bool updated = cholesky_rank_update(
+        cholesky_of_precision_, cont_rank2_factors_, 1, cont_chol_workspace_);
 
     // Update the inverse Cholesky; if the rank-2 update has drifted into
     // ill-conditioning, rebuild the decomposition from scratch (mirrors
     // GGMModel's drift-guard). pairwise_effects_continuous_ already holds the
     // accepted value here, so the rebuild reconstructs the accepted state.
-    if (arma::inv(inv_cholesky_of_precision_, arma::trimatu(cholesky_of_precision_))) {
+    if (updated &&
+        arma::inv(inv_cholesky_of_precision_, arma::trimatu(cholesky_of_precision_))) {
         covariance_continuous_ = inv_cholesky_of_precision_ * inv_cholesky_of_precision_.t();
         log_det_precision_ = cholesky_helpers::get_log_det(cholesky_of_precision_);
     } else {
@@ -451,8 +592,7 @@ double MixedMRFModel::update_pairwise_effects_continuous_offdiag(int i, int j, s
     precision_proposal_(j, i) = theta_prop_ij;
     precision_proposal_(j, j) = theta_prop_jj;
 
-    arma::mat cov_prop;
-    double ln_alpha = log_ggm_ratio_edge(i, j, cov_prop);
+    double ln_alpha = log_ggm_ratio_edge(i, j);
 
     // Determinant-tilt prior on the Kyy block: |Kyy|^delta contributes
     //   delta * (log|Kyy_prop| - log|Kyy_curr|)
@@ -463,7 +603,7 @@ double MixedMRFModel::update_pairwise_effects_continuous_offdiag(int i, int j, s
 
     // OMRF ratio with proposed continuous interactions. The marginal
     // interactions M = A_xx + 2 A_xy Σ A_xy^T depend on Σ; when Kyy changes,
-    // Σ changes too, so we must use Σ' (cov_prop) for the proposed-state
+    // Σ changes too, so we must use Σ' (mh_workspace_.cov_prop) for the proposed-state
     // recomputation, not the cached covariance_continuous_.
     for(size_t s = 0; s < p_; ++s)
         ln_alpha -= log_marginal_omrf(s);
@@ -472,11 +612,12 @@ double MixedMRFModel::update_pairwise_effects_continuous_offdiag(int i, int j, s
         // Evaluate the proposed-state OMRF marginals under (Kyy', Σ'); the guard
         // restores the continuous fields when the block exits.
         ProposedContinuousState proposed_state(
-            pairwise_effects_continuous_, covariance_continuous_, marginal_interactions_);
+            pairwise_effects_continuous_, covariance_continuous_, marginal_interactions_,
+            mh_workspace_);
         pairwise_effects_continuous_(i, j) = -0.5 * theta_prop_ij;
         pairwise_effects_continuous_(j, i) = -0.5 * theta_prop_ij;
         pairwise_effects_continuous_(j, j) = -0.5 * theta_prop_jj;
-        covariance_continuous_ = cov_prop;
+        covariance_continuous_ = mh_workspace_.cov_prop;
         recompute_marginal_interactions();
         for(size_t s = 0; s < p_; ++s)
             ln_alpha += log_marginal_omrf(s);
@@ -544,15 +685,14 @@ double MixedMRFModel::update_pairwise_effects_continuous_diag(int i, std::option
     precision_proposal_ = -2.0 * pairwise_effects_continuous_;
     precision_proposal_(i, i) = theta_ii_prop;
 
-    arma::mat cov_prop;
-    double ln_alpha = log_ggm_ratio_diag(i, cov_prop);
+    double ln_alpha = log_ggm_ratio_diag(i);
 
     // Determinant-tilt prior: rank-1 lemma, O(1) via the cached covariance.
     if (determinant_tilt_yy_ != 0.0) {
         ln_alpha += determinant_tilt_yy_ * log_det_ratio_yy_diag(i);
     }
 
-    // OMRF ratio with proposed continuous interactions. Use Σ' (cov_prop) for
+    // OMRF ratio with proposed continuous interactions. Use Σ' (mh_workspace_.cov_prop) for
     // the proposed-state marginal_interactions, not the cached Σ.
     for(size_t s = 0; s < p_; ++s)
         ln_alpha -= log_marginal_omrf(s);
@@ -561,9 +701,10 @@ double MixedMRFModel::update_pairwise_effects_continuous_diag(int i, std::option
         // Evaluate the proposed-state OMRF marginals under (Kyy', Σ'); the guard
         // restores the continuous fields when the block exits.
         ProposedContinuousState proposed_state(
-            pairwise_effects_continuous_, covariance_continuous_, marginal_interactions_);
+            pairwise_effects_continuous_, covariance_continuous_, marginal_interactions_,
+            mh_workspace_);
         pairwise_effects_continuous_(i, i) = -0.5 * theta_ii_prop;
-        covariance_continuous_ = cov_prop;
+        covariance_continuous_ = mh_workspace_.cov_prop;
         recompute_marginal_interactions();
         for(size_t s = 0; s < p_; ++s)
             ln_alpha += log_marginal_omrf(s);
@@ -615,8 +756,8 @@ double MixedMRFModel::update_pairwise_cross(int i, int j, std::optional<double>
         ll_curr += log_marginal_omrf(s);
 
     // Set proposed value and refresh caches
-    arma::mat cond_mean_saved = conditional_mean_;
-    arma::mat marginal_saved = marginal_interactions_;
+    mh_workspace_.cond_mean_saved = conditional_mean_;
+    mh_workspace_.marginal_saved = marginal_interactions_;
     pairwise_effects_cross_(i, j) = proposed;
     recompute_conditional_mean();
     recompute_marginal_interactions();
@@ -630,8 +771,8 @@ double MixedMRFModel::update_pairwise_cross(int i, int j, std::optional<double>
 
     if(MY_LOG(runif(rng_)) >= ln_alpha) {
         pairwise_effects_cross_(i, j) = current_val;  // reject
-        conditional_mean_ = std::move(cond_mean_saved);
-        marginal_interactions_ = std::move(marginal_saved);
+        conditional_mean_.swap(mh_workspace_.cond_mean_saved);
+        marginal_interactions_.swap(mh_workspace_.marginal_saved);
     }
 
     if (rm_weight) {
@@ -650,7 +791,7 @@ double MixedMRFModel::update_pairwise_cross(int i, int j, std::optional<double>
 //   Delete (G=1→0): set k = 0, accept with reverse terms.
 // =============================================================================
 
-void MixedMRFModel::update_edge_indicator_discrete(int i, int j) {
+double MixedMRFModel::update_edge_indicator_discrete(int i, int j) {
     double k_curr = pairwise_effects_discrete_(i, j);
     double prop_sd = proposal_sd_pairwise_discrete_(i, j);
 
@@ -664,6 +805,30 @@ void MixedMRFModel::update_edge_indicator_discrete(int i, int j) {
         k_prop = 0.0;
     }
 
+    if(delayed_acceptance_.enabled) {
+        double log_other = 0.0;
+        if(g_prop == 1) {
+            log_other += interaction_prior_->logp(k_prop);
+            log_other -= R::dnorm(k_prop, k_curr, prop_sd, true);
+            log_other += MY_LOG(inclusion_probability_(i, j))
+                       - MY_LOG(1.0 - inclusion_probability_(i, j));
+        } else {
+            log_other -= interaction_prior_->logp(k_curr);
+            log_other += R::dnorm(k_curr, k_prop, prop_sd, true);
+            log_other -= MY_LOG(inclusion_probability_(i, j))
+                       - MY_LOG(1.0 - inclusion_probability_(i, j));
+        }
+        double accept_prob;
+        if(delayed_acceptance_test_discrete(i, j, k_prop - k_curr, log_other, accept_prob)) {
+            pairwise_effects_discrete_(i, j) = k_prop;
+            pairwise_effects_discrete_(j, i) = k_prop;
+            set_gxx(i, j, g_prop);
+            constraint_dirty_ = true;
+            recompute_marginal_interactions();
+        }
+        return accept_prob;
+    }
+
     // --- Likelihood ratio ---
     double ll_curr = log_marginal_omrf(i) + log_marginal_omrf(j);
 
@@ -703,6 +868,7 @@ void MixedMRFModel::update_edge_indicator_discrete(int i, int j) {
         constraint_dirty_ = true;
         recompute_marginal_interactions();
     }
+    return std::min(1.0, std::exp(ln_alpha));
 }
 
 
@@ -716,7 +882,7 @@ void MixedMRFModel::update_edge_indicator_discrete(int i, int j) {
 //   Delete (G=1→0): set precision_ij = 0, constrain diagonal.
 // =============================================================================
 
-void MixedMRFModel::update_edge_indicator_continuous(int i, int j) {
+double MixedMRFModel::update_edge_indicator_continuous(int i, int j) {
     get_precision_constants(i, j);
 
     int g_curr = gyy(i, j);
@@ -742,15 +908,14 @@ void MixedMRFModel::update_edge_indicator_continuous(int i, int j) {
     precision_proposal_(j, j) = theta_prop_jj;
 
     // --- Likelihood ratio ---
-    arma::mat cov_prop;
-    double ln_alpha = log_ggm_ratio_edge(i, j, cov_prop);
+    double ln_alpha = log_ggm_ratio_edge(i, j);
 
     // Determinant-tilt prior: see update_pairwise_effects_continuous_offdiag.
     if (determinant_tilt_yy_ != 0.0) {
         ln_alpha += determinant_tilt_yy_ * log_det_ratio_yy_edge(i, j);
     }
 
-    // OMRF ratio with proposed continuous interactions. Use Σ' (cov_prop) for
+    // OMRF ratio with proposed continuous interactions. Use Σ' (mh_workspace_.cov_prop) for
     // the proposed-state marginal_interactions, not the cached Σ.
     for(size_t s = 0; s < p_; ++s)
         ln_alpha -= log_marginal_omrf(s);
@@ -759,11 +924,12 @@ void MixedMRFModel::update_edge_indicator_continuous(int i, int j) {
         // Evaluate the proposed-state OMRF marginals under (Kyy', Σ'); the guard
         // restores the continuous fields when the block exits.
         ProposedContinuousState proposed_state(
-            pairwise_effects_continuous_, covariance_continuous_, marginal_interactions_);
+            pairwise_effects_continuous_, covariance_continuous_, marginal_interactions_,
+            mh_workspace_);
         pairwise_effects_continuous_(i, j) = -0.5 * theta_prop_ij;
         pairwise_effects_continuous_(j, i) = -0.5 * theta_prop_ij;
         pairwise_effects_continuous_(j, j) = -0.5 * theta_prop_jj;
-        covariance_continuous_ = cov_prop;
+        covariance_continuous_ = mh_workspace_.cov_prop;
         recompute_marginal_interactions();
         for(size_t s = 0; s < p_; ++s)
             ln_alpha += log_marginal_omrf(s);
@@ -818,6 +984,7 @@ void MixedMRFModel::update_edge_indicator_continuous(int i, int j) {
         recompute_conditional_mean();
         recompute_marginal_interactions();
     }
+    return std::min(1.0, std::exp(ln_alpha));
 }
 
 
@@ -829,7 +996,7 @@ void MixedMRFModel::update_edge_indicator_continuous(int i, int j) {
 //   Delete (G=1→0): set k = 0.
 // =============================================================================
 
-void MixedMRFModel::update_edge_indicator_cross(int i, int j) {
+double MixedMRFModel::update_edge_indicator_cross(int i, int j) {
     double k_curr = pairwise_effects_cross_(i, j);
     double prop_sd = proposal_sd_pairwise_cross_(i, j);
 
@@ -848,8 +1015,8 @@ void MixedMRFModel::update_edge_indicator_cross(int i, int j) {
     for(size_t s = 0; s < p_; ++s)
         ll_curr += log_marginal_omrf(s);
 
-    arma::mat cond_mean_saved = conditional_mean_;
-    arma::mat marginal_saved = marginal_interactions_;
+    mh_workspace_.cond_mean_saved = conditional_mean_;
+    mh_workspace_.marginal_saved = marginal_interactions_;
     pairwise_effects_cross_(i, j) = k_prop;
     recompute_conditional_mean();
     recompute_marginal_interactions();
@@ -860,8 +1027,8 @@ void MixedMRFModel::update_edge_indicator_cross(int i, int j) {
 
     // Restore
     pairwise_effects_cross_(i, j) = k_curr;
-    conditional_mean_ = std::move(cond_mean_saved);
-    marginal_interactions_ = std::move(marginal_saved);
+    conditional_mean_.swap(mh_workspace_.cond_mean_saved);
+    marginal_interactions_.swap(mh_workspace_.marginal_saved);
 
     double ln_alpha = ll_prop - ll_curr;
 
@@ -886,4 +1053,5 @@ void MixedMRFModel::update_edge_indicator_cross(int i, int j) {
         recompute_conditional_mean();
         recompute_marginal_interactions();
     }
+    return std::min(1.0, std::exp(ln_alpha));
 }
@@ -8,8 +8,11 @@
 #include <RcppArmadillo.h>
 #include "models/mixed/mixed_mrf_model.h"
 #include "math/explog_macros.h"
+#include "math/lbfgs.h"
 #include "rng/rng_utils.h"
+#include "mcmc/execution/sampler_state.h"
 #include "mcmc/execution/warmup_schedule.h"
+#include "mrf_simulation.h"
 
 
 // =============================================================================
@@ -34,8 +37,6 @@ MixedMRFModel::MixedMRFModel(
     n_(discrete_observations.n_rows),
     p_(discrete_observations.n_cols),
     q_(continuous_observations.n_cols),
-    discrete_observations_(discrete_observations),
-    continuous_observations_(continuous_observations),
     num_categories_(num_categories),
     is_ordinal_variable_(is_ordinal_variable),
     baseline_category_(baseline_category),
@@ -58,16 +59,24 @@ MixedMRFModel::MixedMRFModel(
 
     max_cats_ = num_categories_.max();
 
+    // Specialised log-normalizer kernels for small category counts
+    logz_kernels_.resize(p_);
+    for(size_t s = 0; s < p_; ++s) {
+        logz_kernels_[s] = select_logz_kernels(num_categories_(s));
+    }
+
     // Center Blume-Capel observations at baseline category so that all
     // downstream code operates in a shifted coordinate system where the
     // reference corresponds to zero (same convention as OMRFModel).
+    ObservationData& data = data_.mut();
+    data.discrete_observations = discrete_observations;
+    data.continuous_observations = continuous_observations;
     for(size_t s = 0; s < p_; ++s) {
         if(!is_ordinal_variable_(s)) {
-            discrete_observations_.col(s) -= baseline_category_(s);
+            data.discrete_observations.col(s) -= baseline_category_(s);
         }
     }
-    discrete_observations_dbl_ = arma::conv_to<arma::mat>::from(discrete_observations_);
-    discrete_observations_dbl_t_ = discrete_observations_dbl_.t();
+    data.discrete_observations_dbl = arma::conv_to<arma::mat>::from(data.discrete_observations);
 
     // Compute sufficient statistics
     compute_sufficient_statistics();
@@ -96,8 +105,8 @@ MixedMRFModel::MixedMRFModel(
     precision_proposal_ = arma::mat(q_, q_, arma::fill::none);
     cont_vf1_ = arma::zeros<arma::vec>(q_);
     cont_vf2_ = arma::zeros<arma::vec>(q_);
-    cont_u1_ = arma::zeros<arma::vec>(q_);
-    cont_u2_ = arma::zeros<arma::vec>(q_);
+    cont_rank2_factors_ = arma::zeros<arma::mat>(q_, 2);
+    mh_workspace_.prepare(n_, p_, q_, max_cats_);
 
     // Initialize conditional mean: M = μ_y' + 2 X cross_int Sigma_yy
     //   With cross_int = 0 and precision = I, this reduces to 0.
@@ -132,6 +141,10 @@ MixedMRFModel::MixedMRFModel(const MixedMRFModel& other)
     : BaseModel(other),
       target_accept_(other.target_accept_),
       determinant_tilt_yy_(other.determinant_tilt_yy_),
+      delayed_acceptance_(other.delayed_acceptance_),
+      block_main_(other.block_main_),
+      informed_edges_(other.informed_edges_),
+      initial_inv_mass_(other.initial_inv_mass_),
       n_(other.n_),
       p_(other.p_),
       q_(other.q_),
@@ -140,9 +153,7 @@ MixedMRFModel::MixedMRFModel(const MixedMRFModel& other)
       num_pairwise_yy_(other.num_pairwise_yy_),
       num_cross_(other.num_cross_),
       num_cholesky_(other.num_cholesky_),
-      discrete_observations_(other.discrete_observations_),
-      discrete_observations_dbl_(other.discrete_observations_dbl_),
-      continuous_observations_(other.continuous_observations_),
+      data_(other.data_),
       num_categories_(other.num_categories_),
       max_cats_(other.max_cats_),
       is_ordinal_variable_(other.is_ordinal_variable_),
@@ -182,10 +193,10 @@ MixedMRFModel::MixedMRFModel(const MixedMRFModel& other)
       cont_v2_(other.cont_v2_),
       cont_vf1_(other.cont_vf1_),
       cont_vf2_(other.cont_vf2_),
-      cont_u1_(other.cont_u1_),
-      cont_u2_(other.cont_u2_),
-      discrete_observations_dbl_t_(other.discrete_observations_dbl_t_),
+      cont_rank2_factors_(other.cont_rank2_factors_),
+      mh_workspace_(other.mh_workspace_),
       gradient_cache_valid_(false),
+      logz_kernels_(other.logz_kernels_),
       chol_constraint_structure_(other.chol_constraint_structure_),
       excluded_kxx_indices_(other.excluded_kxx_indices_),
       excluded_kxy_indices_(other.excluded_kxy_indices_),
@@ -193,11 +204,14 @@ MixedMRFModel::MixedMRFModel(const MixedMRFModel& other)
       constraint_dirty_(other.constraint_dirty_),
       has_sparse_graph_(other.has_sparse_graph_),
       pcg_lambda_cache_(other.pcg_lambda_cache_),
+      projection_workspace_(other.projection_workspace_),
       rng_(other.rng_),
       edge_order_xx_(other.edge_order_xx_),
       edge_order_yy_(other.edge_order_yy_),
       edge_order_xy_(other.edge_order_xy_)
 {
+    // Imputation writes to the observations, so each chain needs its own
+    if(has_missing_) data_.detach();
 }
 
 
@@ -211,7 +225,7 @@ void MixedMRFModel::compute_sufficient_statistics() {
     for(size_t s = 0; s < p_; ++s) {
         if(is_ordinal_variable_(s)) {
             for(size_t i = 0; i < n_; ++i) {
-                int cat = discrete_observations_(i, s);
+                int cat = data_->discrete_observations(i, s);
                 if(cat >= 0 && cat <= num_categories_(s)) {
                     counts_per_category_(cat, s)++;
                 }
@@ -224,7 +238,7 @@ void MixedMRFModel::compute_sufficient_statistics() {
     for(size_t s = 0; s < p_; ++s) {
         if(!is_ordinal_variable_(s)) {
             for(size_t i = 0; i < n_; ++i) {
-                int val = discrete_observations_(i, s);  // already centered
+                int val = data_->discrete_observations(i, s);  // already centered
                 blume_capel_stats_(0, s) += val;
                 blume_capel_stats_(1, s) += val * val;
             }
@@ -251,9 +265,21 @@ size_t MixedMRFModel::count_num_main_effects() const {
 // =============================================================================
 
 void MixedMRFModel::recompute_conditional_mean() {
-    // M = μ_y' + 2 X A_xy Σ_yy
-    conditional_mean_ = arma::repmat(main_effects_continuous_.t(), n_, 1) +
-                        2.0 * discrete_observations_dbl_ * pairwise_effects_cross_ * covariance_continuous_;
+    // M = μ_y' + 2 X A_xy Σ_yy, written in place through the workspace
+    arma::mat& cross_covariance = mh_workspace_.cross_covariance;
+    cross_covariance = pairwise_effects_cross_ * covariance_continuous_;
+    conditional_mean_ = 2.0 * data_->discrete_observations_dbl * cross_covariance;
+    for(size_t j = 0; j < q_; ++j)
+        conditional_mean_.col(j) += main_effects_continuous_(j);
+    residual_cache_valid_ = false;
+}
+
+void MixedMRFModel::ensure_residual_cache() {
+    if(residual_cache_valid_) return;
+    cross_projection_ = data_->discrete_observations_dbl * pairwise_effects_cross_;
+    residual_continuous_ = data_->continuous_observations - conditional_mean_;
+    residual_precision_ = residual_continuous_ * (-2.0 * pairwise_effects_continuous_);
+    residual_cache_valid_ = true;
 }
 
 void MixedMRFModel::recompute_pairwise_effects_continuous_decomposition() {
@@ -270,8 +296,10 @@ void MixedMRFModel::recompute_marginal_interactions() {
     //   M = A_xx + 2 A_xy Σ_yy A_xy'
     // The log-marginal has x'Mx, so the x_s-conditional rest score carries
     // a factor 2 on M.col(s) (consumed at the call site in log_marginal_omrf).
-    marginal_interactions_ = pairwise_effects_discrete_
-                           + 2.0 * pairwise_effects_cross_ * covariance_continuous_ * pairwise_effects_cross_.t();
+    arma::mat& cross_covariance = mh_workspace_.cross_covariance;
+    cross_covariance = pairwise_effects_cross_ * covariance_continuous_;
+    marginal_interactions_ = 2.0 * cross_covariance * pairwise_effects_cross_.t();
+    marginal_interactions_ += pairwise_effects_discrete_;
 }
 
 
@@ -323,6 +351,7 @@ void MixedMRFModel::ensure_constraint_structure() {
     // --- Cholesky block offset ---
     chol_block_offset_ = num_main_ + num_pairwise_xx_ + q_ + num_cross_;
 
+    projection_workspace_.reset(q_);
     constraint_dirty_ = false;
 }
 
@@ -412,6 +441,81 @@ void MixedMRFModel::set_full_position(const arma::vec& x) {
 
 void MixedMRFModel::reset_projection_cache() {
     pcg_lambda_cache_.reset();
+    projection_workspace_.jacobian_valid = false;
+    projection_workspace_.preconditioner_valid = false;
+}
+
+
+void MixedMRFModel::initialize_from_pseudo_mle() {
+    // Edge selection is not active yet, so the NUTS vector has the full
+    // layout; hold the excluded discrete and cross edges at zero.
+    arma::vec is_free(full_parameter_dimension(), arma::fill::ones);
+    size_t idx = num_main_;
+    for(size_t i = 0; i < p_ - 1; ++i) {
+        for(size_t j = i + 1; j < p_; ++j) {
+            if(gxx(i, j) == 0) is_free(idx) = 0.0;
+            idx++;
+        }
+    }
+    idx += q_;
+    for(size_t i = 0; i < p_; ++i) {
+        for(size_t j = 0; j < q_; ++j) {
+            if(gxy(i, j) == 0) is_free(idx) = 0.0;
+            idx++;
+        }
+    }
+
+    auto objective = [this, &is_free](const arma::vec& parameters) {
+        auto [logp, gradient] = logp_and_gradient(parameters);
+        gradient %= is_free;
+        return std::make_pair(logp, std::move(gradient));
+    };
+    const LBFGSResult mode = lbfgs_maximize(objective, get_vectorized_parameters());
+    if(!std::isfinite(mode.value)) return;
+    set_vectorized_parameters(mode.x);
+    if(has_constraints()) {
+        arma::vec x = get_full_position();
+        project_position(x);
+        set_full_position(x);
+    }
+    constraint_dirty_ = true;
+    invalidate_gradient_cache();
+
+    initial_inv_mass_ = inverse_curvature(
+        hessian_diagonal(objective, mode.x, mode.gradient));
+
+    // A random-walk proposal SD of 2.4 conditional SDs accepts about 44%.
+    // The precision block is proposed on other coordinates and keeps its SDs.
+    constexpr double proposal_scale = 2.4;
+    auto proposal_sd = [&](size_t k) {
+        return proposal_scale * std::sqrt(initial_inv_mass_(k));
+    };
+    idx = 0;
+    for(size_t s = 0; s < p_; ++s) {
+        const int num_main = is_ordinal_variable_(s) ? num_categories_(s) : 2;
+        for(int c = 0; c < num_main; ++c) {
+            proposal_sd_main_discrete_(s, c) = proposal_sd(idx++);
+        }
+    }
+    if(block_main_.enabled) set_block_main_effects(true);
+    for(size_t i = 0; i < p_ - 1; ++i) {
+        for(size_t j = i + 1; j < p_; ++j) {
+            if(is_free(idx)) {
+                proposal_sd_pairwise_discrete_(i, j) = proposal_sd(idx);
+                proposal_sd_pairwise_discrete_(j, i) = proposal_sd_pairwise_discrete_(i, j);
+            }
+            idx++;
+        }
+    }
+    for(size_t j = 0; j < q_; ++j) {
+        proposal_sd_main_continuous_(j, 0) = proposal_sd(idx++);
+    }
+    for(size_t i = 0; i < p_; ++i) {
+        for(size_t j = 0; j < q_; ++j) {
+            if(is_free(idx)) proposal_sd_pairwise_cross_(i, j) = proposal_sd(idx);
+            idx++;
+        }
+    }
 }
 
 
@@ -424,6 +528,18 @@ void MixedMRFModel::reset_projection_cache() {
 //            (same algorithm as GGMModel::project_position)
 // =============================================================================
 
+void MixedMRFModel::unpack_cholesky_block(const arma::vec& x, arma::mat& Phi) const {
+    const auto& cs = chol_constraint_structure_;
+    Phi.zeros(q_, q_);
+    for(size_t col = 0; col < q_; ++col) {
+        size_t offset = chol_block_offset_ + cs.full_theta_offsets[col];
+        for(size_t i = 0; i < col; ++i) {
+            Phi(i, col) = x(offset + i);
+        }
+        Phi(col, col) = std::exp(x(offset + col));
+    }
+}
+
 void MixedMRFModel::project_position(arma::vec& x) const {
     arma::vec ones(x.n_elem, arma::fill::ones);
     project_position(x, ones);
@@ -431,6 +547,7 @@ void MixedMRFModel::project_position(arma::vec& x) const {
 
 void MixedMRFModel::project_position(arma::vec& x,
                                       const arma::vec& inv_mass_diag) const {
+    BGMS_PROFILE_SCOPE(ProjectPosition);
     if(constraint_dirty_) {
         const_cast<MixedMRFModel*>(this)->ensure_constraint_structure();
     }
@@ -445,18 +562,10 @@ void MixedMRFModel::project_position(arma::vec& x,
 
     // --- Phase 2: Cholesky constraints (Gyy block) ---
     const auto& cs = chol_constraint_structure_;
+    auto& ws = projection_workspace_;
 
     // Build working Phi from the Cholesky block of x
-    arma::mat Phi(q_, q_, arma::fill::zeros);
-    for(size_t col = 0; col < q_; ++col) {
-        size_t offset = chol_block_offset_ + cs.full_theta_offsets[col];
-        for(size_t i = 0; i < col; ++i) {
-            Phi(i, col) = x(offset + i);
-        }
-        Phi(col, col) = std::exp(x(offset + col));
-    }
-
-    arma::mat Aq_buf;
+    unpack_cholesky_block(x, ws.Phi);
 
     for(size_t col = 1; col < q_; ++col) {
         const auto& cc = cs.columns[col];
@@ -464,38 +573,32 @@ void MixedMRFModel::project_position(arma::vec& x,
 
         size_t offset = chol_block_offset_ + cs.full_theta_offsets[col];
 
-        // Build A_q from working Phi (earlier columns finalized)
-        GGMGradientEngine::build_Aq(Phi, cc, col, Aq_buf);
+        // Build A_q from working Phi (earlier columns finalized), and keep
+        // it with G_q for the momentum projection at the projected point
+        arma::mat& Aq = ws.Aq[col];
+        arma::mat& G = ws.Gq[col];
+        GGMGradientEngine::build_Aq(ws.Phi, cc, col, Aq);
 
         // Current off-diagonal entries for column col
-        arma::vec x_q(col);
-        for(size_t i = 0; i < col; ++i) {
-            x_q(i) = x(offset + i);
-        }
+        ws.x_q = x.subvec(offset, offset + col - 1);
+        ws.inv_mass_q = inv_mass_diag.subvec(offset, offset + col - 1);
 
         // SHAKE: x_q -= M_q^{-1} A_q^T (A_q M_q^{-1} A_q^T)^{-1} (A_q x_q)
-        arma::vec Aq_xq = Aq_buf * x_q;
+        ws.rhs_q = Aq * ws.x_q;
+        ws.Aq_scaled = Aq;
+        ws.Aq_scaled.each_row() %= ws.inv_mass_q.t();
+        G = ws.Aq_scaled * Aq.t();
+        arma::solve(ws.lambda_q, G, ws.rhs_q, arma::solve_opts::likely_sympd);
 
-        arma::vec inv_mass_q(col);
-        for(size_t i = 0; i < col; ++i) {
-            inv_mass_q(i) = inv_mass_diag(offset + i);
-        }
-
-        arma::mat Aq_scaled = Aq_buf;
-        Aq_scaled.each_row() %= inv_mass_q.t();
-        arma::mat G = Aq_scaled * Aq_buf.t();
-        arma::vec lambda = arma::solve(G, Aq_xq,
-                                       arma::solve_opts::likely_sympd);
-
-        arma::vec correction = Aq_buf.t() * lambda;
-        x_q -= inv_mass_q % correction;
+        ws.x_q -= ws.inv_mass_q % (Aq.t() * ws.lambda_q);
 
         // Write back
         for(size_t i = 0; i < col; ++i) {
-            x(offset + i) = x_q(i);
-            Phi(i, col) = x_q(i);
+            x(offset + i) = ws.x_q(i);
+            ws.Phi(i, col) = ws.x_q(i);
         }
     }
+    ws.set_key(x, inv_mass_diag, chol_block_offset_, num_cholesky_);
 }
 
 
@@ -515,6 +618,7 @@ void MixedMRFModel::project_momentum(arma::vec& r, const arma::vec& x) const {
 
 void MixedMRFModel::project_momentum(arma::vec& r, const arma::vec& x,
                                       const arma::vec& inv_mass_diag) const {
+    BGMS_PROFILE_SCOPE(ProjectMomentum);
     if(constraint_dirty_) {
         const_cast<MixedMRFModel*>(this)->ensure_constraint_structure();
     }
@@ -529,52 +633,57 @@ void MixedMRFModel::project_momentum(arma::vec& r, const arma::vec& x,
 
     // --- Phase 2: Cholesky constraints (Gyy block) via PCG ---
     const auto& cs = chol_constraint_structure_;
+    auto& ws = projection_workspace_;
 
-    // Enumerate constraints
-    struct Con { size_t i, q, off_i, off_q; };
-    std::vector<Con> cons;
-    for(size_t col = 1; col < q_; ++col) {
-        const auto& cc = cs.columns[col];
-        size_t off_q = chol_block_offset_ + cs.full_theta_offsets[col];
-        for(size_t e = 0; e < cc.m_q; ++e) {
-            size_t i = cc.excluded_indices[e];
-            cons.push_back({i, col, chol_block_offset_ + cs.full_theta_offsets[i], off_q});
+    // Enumerate constraints (fixed until the constraint structure changes)
+    if(!ws.constraints_valid) {
+        ws.constraints.clear();
+        for(size_t col = 1; col < q_; ++col) {
+            const auto& cc = cs.columns[col];
+            size_t off_q = chol_block_offset_ + cs.full_theta_offsets[col];
+            ws.block_offset[col] = ws.constraints.size();
+            for(size_t e = 0; e < cc.m_q; ++e) {
+                size_t i = cc.excluded_indices[e];
+                ws.constraints.push_back(
+                    {i, col, chol_block_offset_ + cs.full_theta_offsets[i], off_q});
+            }
         }
+        ws.constraints_valid = true;
     }
+    const auto& cons = ws.constraints;
     size_t m = cons.size();
     if(m == 0) return;
 
     // Unpack x -> Phi
-    arma::mat Phi(q_, q_, arma::fill::zeros);
-    for(size_t col = 0; col < q_; ++col) {
-        size_t offset = chol_block_offset_ + cs.full_theta_offsets[col];
-        for(size_t i = 0; i < col; ++i) {
-            Phi(i, col) = x(offset + i);
-        }
-        Phi(col, col) = std::exp(x(offset + col));
-    }
+    unpack_cholesky_block(x, ws.Phi);
+    const arma::mat& Phi = ws.Phi;
 
-    size_t d = x.n_elem;
-
-    // --- Build block-diagonal preconditioner ---
-    struct PrecBlock { arma::mat Gq_inv; size_t offset; size_t size; };
-    std::vector<PrecBlock> prec_blocks;
-    prec_blocks.reserve(q_);
-    arma::mat Aq_buf;
-
-    {
-        size_t block_offset = 0;
+    // A_q and A_q M_q^{-1} A_q^T: left by project_position() when x is the
+    // point it projected to, otherwise rebuilt here
+    if(!ws.jacobian_valid ||
+       !ws.matches(x, inv_mass_diag, chol_block_offset_, num_cholesky_)) {
         for(size_t col = 1; col < q_; ++col) {
             const auto& cc = cs.columns[col];
             if(cc.m_q == 0) continue;
 
             size_t off_q = chol_block_offset_ + cs.full_theta_offsets[col];
-            GGMGradientEngine::build_Aq(Phi, cc, col, Aq_buf);
+            GGMGradientEngine::build_Aq(Phi, cc, col, ws.Aq[col]);
 
-            arma::mat Aq_scaled = Aq_buf;
+            ws.Aq_scaled = ws.Aq[col];
             for(size_t l = 0; l < col; ++l)
-                Aq_scaled.col(l) *= inv_mass_diag(off_q + l);
-            arma::mat Gq = Aq_scaled * Aq_buf.t();
+                ws.Aq_scaled.col(l) *= inv_mass_diag(off_q + l);
+            ws.Gq[col] = ws.Aq_scaled * ws.Aq[col].t();
+        }
+        ws.set_key(x, inv_mass_diag, chol_block_offset_, num_cholesky_);
+    }
+
+    // --- Block-diagonal preconditioner, kept for the next call at x ---
+    if(!ws.preconditioner_valid) {
+        for(size_t col = 1; col < q_; ++col) {
+            const auto& cc = cs.columns[col];
+            if(cc.m_q == 0) continue;
+
+            arma::mat Gq = ws.Gq[col];
 
             // Diagonal correction: Type 2 self-interaction
             for(size_t e = 0; e < cc.m_q; ++e) {
@@ -591,7 +700,7 @@ void MixedMRFModel::project_momentum(arma::vec& r, const arma::vec& x,
             // Robust inversion: NUTS leapfrog can transiently push Phi
             // diagonals near zero, making Gq nearly singular. Apply a small
             // Tikhonov ridge if direct inversion fails.
-            arma::mat Gq_inv;
+            arma::mat& Gq_inv = ws.Gq_inv[col];
             bool ok = arma::inv_sympd(Gq_inv, Gq);
             if (!ok) {
                 double ridge = 1e-10 * arma::trace(Gq) /
@@ -603,20 +712,23 @@ void MixedMRFModel::project_momentum(arma::vec& r, const arma::vec& x,
                     Gq_inv = arma::pinv(Gq_reg);
                 }
             }
-            prec_blocks.push_back({Gq_inv, block_offset, cc.m_q});
-            block_offset += cc.m_q;
         }
+        ws.preconditioner_valid = true;
     }
 
     auto apply_precond = [&](const arma::vec& v, arma::vec& z) {
-        for(const auto& blk : prec_blocks) {
-            z.subvec(blk.offset, blk.offset + blk.size - 1) =
-                blk.Gq_inv * v.subvec(blk.offset, blk.offset + blk.size - 1);
+        for(size_t col = 1; col < q_; ++col) {
+            const size_t size = cs.columns[col].m_q;
+            if(size == 0) continue;
+            const size_t offset = ws.block_offset[col];
+            z.subvec(offset, offset + size - 1) =
+                ws.Gq_inv[col] * v.subvec(offset, offset + size - 1);
         }
     };
 
     // --- Sparse Jacobian operations ---
-    arma::vec scratch(d);
+    arma::vec& scratch = ws.scratch;
+    scratch.set_size(x.n_elem);
 
     auto Jt_mul = [&](const arma::vec& dv) {
         scratch.zeros();
@@ -651,28 +763,33 @@ void MixedMRFModel::project_momentum(arma::vec& r, const arma::vec& x,
     };
 
     // --- RHS: b = J M^{-1} r ---
-    arma::vec b(m);
+    arma::vec& b = ws.b;
+    b.set_size(m);
     {
         scratch = inv_mass_diag % r;
         J_mul(b);
     }
 
     // --- Preconditioned CG ---
-    arma::vec lambda(m);
-    arma::vec cg_r(m);
+    arma::vec& lambda = ws.lambda;
+    arma::vec& cg_r = ws.cg_r;
+    cg_r.set_size(m);
     if(pcg_lambda_cache_.n_elem == m) {
         lambda = pcg_lambda_cache_;
         G_mul(lambda, cg_r);
         cg_r = b - cg_r;
     } else {
-        lambda.zeros();
+        lambda.zeros(m);
         cg_r = b;
     }
-    arma::vec z(m);
+    arma::vec& z = ws.z;
+    z.set_size(m);
     apply_precond(cg_r, z);
-    arma::vec cg_d = z;
+    arma::vec& cg_d = ws.cg_d;
+    cg_d = z;
     double rz = arma::dot(cg_r, z);
-    arma::vec Ad(m);
+    arma::vec& Ad = ws.Ad;
+    Ad.set_size(m);
 
     const double tol = 1e-26;
     const size_t max_iter = m;
@@ -1045,13 +1162,31 @@ arma::ivec MixedMRFModel::get_vectorized_indicator_parameters() {
     return out;
 }
 
+void MixedMRFModel::pack_indicator_parameters(IndicatorBitWriter& out) {
+    for(size_t i = 0; i < p_ - 1; ++i) {
+        for(size_t j = i + 1; j < p_; ++j) {
+            out.push(gxx(i, j) != 0);
+        }
+    }
+    for(size_t i = 0; i < q_ - 1; ++i) {
+        for(size_t j = i + 1; j < q_; ++j) {
+            out.push(gyy(i, j) != 0);
+        }
+    }
+    for(size_t i = 0; i < p_; ++i) {
+        for(size_t j = 0; j < q_; ++j) {
+            out.push(gxy(i, j) != 0);
+        }
+    }
+}
+
 
 // =============================================================================
 // Infrastructure
 // =============================================================================
 
-void MixedMRFModel::set_seed(int seed) {
-    rng_ = SafeRNG(seed);
+void MixedMRFModel::set_rng(const SafeRNG& rng) {
+    rng_ = rng;
 }
 
 std::unique_ptr<BaseModel> MixedMRFModel::clone() const {
@@ -1059,6 +1194,96 @@ std::unique_ptr<BaseModel> MixedMRFModel::clone() const {
 }
 
 
+void MixedMRFModel::save_state(SamplerState& state) const {
+    state.add("main_effects_discrete", main_effects_discrete_);
+    state.add("main_effects_continuous", main_effects_continuous_);
+    state.add("pairwise_effects_discrete", pairwise_effects_discrete_);
+    state.add("pairwise_effects_continuous", pairwise_effects_continuous_);
+    state.add("pairwise_effects_cross", pairwise_effects_cross_);
+    state.add("edge_indicators", arma::conv_to<arma::mat>::from(edge_indicators_));
+    state.add("inclusion_probability", inclusion_probability_);
+    state.add("proposal_sd_main_discrete", proposal_sd_main_discrete_);
+    state.add("proposal_sd_main_continuous", proposal_sd_main_continuous_);
+    state.add("proposal_sd_pairwise_discrete", proposal_sd_pairwise_discrete_);
+    state.add("proposal_sd_pairwise_continuous", proposal_sd_pairwise_continuous_);
+    state.add("proposal_sd_pairwise_cross", proposal_sd_pairwise_cross_);
+    if (delayed_acceptance_.enabled) {
+        state.add("surrogate_curvature", delayed_acceptance_.curvature());
+        state.add("delayed_acceptance", delayed_acceptance_.statistics());
+    }
+    if (block_main_.enabled) {
+        state.add("block_proposal_main", block_main_.state());
+    }
+    if (informed_edges_.enabled) {
+        state.add("informed_edge_rates", informed_edges_.flip_rates());
+    }
+    state.edge_selection_active = edge_selection_active_;
+}
+
+
+void MixedMRFModel::restore_state(const SamplerState& state) {
+    // Same dimensions as the block being replaced
+    auto restore = [&state](const char* name, arma::mat& block) {
+        block = state.block(name, block.n_rows, block.n_cols);
+    };
+
+    restore("main_effects_discrete", main_effects_discrete_);
+    main_effects_continuous_ = state.block("main_effects_continuous", q_, 1);
+    restore("pairwise_effects_discrete", pairwise_effects_discrete_);
+    restore("pairwise_effects_continuous", pairwise_effects_continuous_);
+    restore("pairwise_effects_cross", pairwise_effects_cross_);
+    edge_indicators_ = arma::conv_to<arma::imat>::from(
+        state.block("edge_indicators", p_ + q_, p_ + q_));
+    edge_changes_.reset();
+    restore("inclusion_probability", inclusion_probability_);
+    restore("proposal_sd_main_discrete", proposal_sd_main_discrete_);
+    restore("proposal_sd_main_continuous", proposal_sd_main_continuous_);
+    restore("proposal_sd_pairwise_discrete", proposal_sd_pairwise_discrete_);
+    restore("proposal_sd_pairwise_continuous", proposal_sd_pairwise_continuous_);
+    restore("proposal_sd_pairwise_cross", proposal_sd_pairwise_cross_);
+    if (delayed_acceptance_.enabled && state.has_block("surrogate_curvature")) {
+        delayed_acceptance_.set_curvature(state.block("surrogate_curvature", p_, p_));
+    }
+    if (block_main_.enabled) {
+        // A state saved without blocks starts them from its proposal SDs
+        set_block_main_effects(true);
+        if (state.has_block("block_proposal_main")) {
+            block_main_.restore(state.block("block_proposal_main", p_, block_main_.state_columns()));
+        }
+    }
+    if (informed_edges_.enabled && state.has_block("informed_edge_rates")) {
+        informed_edges_.set_flip_rates(state.block(
+            "informed_edge_rates", informed_edges_.flip_rates().n_elem, 1));
+    }
+    edge_selection_active_ = state.edge_selection_active;
+
+    recompute_pairwise_effects_continuous_decomposition();
+    recompute_conditional_mean();
+    recompute_marginal_interactions();
+    constraint_dirty_ = true;
+    invalidate_gradient_cache();
+}
+
+
+void MixedMRFModel::simulate_replicate(int num_states, int gibbs_iter, SafeRNG& rng,
+                                       arma::mat& out) {
+    // The kernel centres every discrete variable at its baseline category
+    std::vector<std::string> variable_type(p_);
+    arma::ivec baseline = baseline_category_;
+    for (size_t s = 0; s < p_; ++s) {
+        variable_type[s] = is_ordinal_variable_(s) ? "ordinal" : "blume-capel";
+        if (is_ordinal_variable_(s)) baseline(s) = 0;
+    }
+    arma::imat x(num_states, p_);
+    arma::mat y(num_states, q_);
+    simulate_mixed_mrf_vectorized(
+        num_states, pairwise_effects_discrete_, pairwise_effects_cross_,
+        pairwise_effects_continuous_, main_effects_discrete_, main_effects_continuous_,
+        num_categories_, variable_type, baseline, gibbs_iter, rng, x, y);
+    out = arma::join_rows(arma::conv_to<arma::mat>::from(x), y);
+}
+
+
 // =============================================================================
 // Missing data imputation
 // =============================================================================
@@ -1073,6 +1298,7 @@ void MixedMRFModel::set_missing_data(const arma::imat& missing_discrete,
 
 void MixedMRFModel::impute_missing() {
     if(!has_missing_) return;
+    ObservationData& data = data_.mut();
 
     // --- Phase 1: Impute discrete entries ---
     const int num_disc_missing = missing_index_discrete_.n_rows;
@@ -1088,10 +1314,10 @@ void MixedMRFModel::impute_missing() {
             // A_xx diagonal is zero, so no self-interaction subtraction needed
             double rest_v = 0.0;
             for(size_t t = 0; t < p_; t++) {
-                rest_v += 2.0 * discrete_observations_dbl_(person, t) * pairwise_effects_discrete_(t, variable);
+                rest_v += 2.0 * data.discrete_observations_dbl(person, t) * pairwise_effects_discrete_(t, variable);
             }
             for(size_t j = 0; j < q_; j++) {
-                rest_v += 2.0 * continuous_observations_(person, j) * pairwise_effects_cross_(variable, j);
+                rest_v += 2.0 * data.continuous_observations(person, j) * pairwise_effects_cross_(variable, j);
             }
 
             double cumsum = 0.0;
@@ -1133,11 +1359,11 @@ void MixedMRFModel::impute_missing() {
             if(!is_ordinal_variable_(variable)) {
                 new_value -= baseline_category_(variable);
             }
-            const int old_value = discrete_observations_(person, variable);
+            const int old_value = data.discrete_observations(person, variable);
 
             if(new_value != old_value) {
-                discrete_observations_(person, variable) = new_value;
-                discrete_observations_dbl_(person, variable) =
+                data.discrete_observations(person, variable) = new_value;
+                data.discrete_observations_dbl(person, variable) =
                     static_cast<double>(new_value);
 
                 if(is_ordinal_variable_(variable)) {
@@ -1152,6 +1378,11 @@ void MixedMRFModel::impute_missing() {
         }
     }
 
+    // Keep the transpose used by the pairwise gradient current, if built
+    if(num_disc_missing > 0 && !data.discrete_observations_dbl_t.is_empty()) {
+        data.discrete_observations_dbl_t = data.discrete_observations_dbl.t();
+    }
+
     // --- Phase 2: Refresh conditional_mean_ (depends on discrete data) ---
     if(num_disc_missing > 0 && missing_index_continuous_.n_rows > 0) {
         recompute_conditional_mean();
@@ -1171,19 +1402,20 @@ void MixedMRFModel::impute_missing() {
             for(size_t k = 0; k < q_; k++) {
                 if(k != static_cast<size_t>(variable)) {
                     cond_mean -= (pairwise_effects_continuous_(variable, k) / pairwise_effects_continuous_(variable, variable)) *
-                        (continuous_observations_(person, k) -
+                        (data.continuous_observations(person, k) -
                          conditional_mean_(person, k));
                 }
             }
             double cond_sd = std::sqrt(1.0 / precision_jj);
 
-            continuous_observations_(person, variable) =
+            data.continuous_observations(person, variable) =
                 rnorm(rng_, cond_mean, cond_sd);
         }
     }
 
-    // Invalidate gradient cache (observations changed)
+    // Invalidate gradient and residual caches (observations changed)
     invalidate_gradient_cache();
+    residual_cache_valid_ = false;
 }
 
 
@@ -1194,21 +1426,32 @@ void MixedMRFModel::impute_missing() {
 void MixedMRFModel::do_one_metropolis_step(int iteration) {
     // Per-slot accept-probability and visit-mask matrices for the five
     // proposal-SD storages. Only entries we actually visit get mask=1; the
-    // adapter only RM-updates those slots.
-    arma::mat  ar_main_disc  = arma::zeros<arma::mat >(p_, max_cats_);
-    arma::umat mask_main_disc= arma::zeros<arma::umat>(p_, max_cats_);
-    arma::mat  ar_main_cont  = arma::zeros<arma::mat >(q_, 1);
-    arma::umat mask_main_cont= arma::zeros<arma::umat>(q_, 1);
-    arma::mat  ar_pair_disc  = arma::zeros<arma::mat >(p_, p_);
-    arma::umat mask_pair_disc= arma::zeros<arma::umat>(p_, p_);
-    arma::mat  ar_pair_cont  = arma::zeros<arma::mat >(q_, q_);
-    arma::umat mask_pair_cont= arma::zeros<arma::umat>(q_, q_);
-    arma::mat  ar_pair_cross = arma::zeros<arma::mat >(p_, q_);
-    arma::umat mask_pair_cross= arma::zeros<arma::umat>(p_, q_);
+    // adapter only RM-updates those slots. The matrices live in the
+    // per-chain workspace and are cleared, not reallocated, each sweep.
+    MixedMHWorkspace& ws = mh_workspace_;
+    ws.prepare(n_, p_, q_, max_cats_);
+    arma::mat&  ar_main_disc   = ws.ar_main_disc;
+    arma::umat& mask_main_disc = ws.mask_main_disc;
+    arma::mat&  ar_main_cont   = ws.ar_main_cont;
+    arma::umat& mask_main_cont = ws.mask_main_cont;
+    arma::mat&  ar_pair_disc   = ws.ar_pair_disc;
+    arma::umat& mask_pair_disc = ws.mask_pair_disc;
+    arma::mat&  ar_pair_cont   = ws.ar_pair_cont;
+    arma::umat& mask_pair_cont = ws.mask_pair_cont;
+    arma::mat&  ar_pair_cross  = ws.ar_pair_cross;
+    arma::umat& mask_pair_cross= ws.mask_pair_cross;
+    ar_main_disc.zeros();   mask_main_disc.zeros();
+    ar_main_cont.zeros();   mask_main_cont.zeros();
+    ar_pair_disc.zeros();   mask_pair_disc.zeros();
+    ar_pair_cont.zeros();   mask_pair_cont.zeros();
+    ar_pair_cross.zeros();  mask_pair_cross.zeros();
 
     // Step 1: main effects (ordinal thresholds or BC α/β)
     for(size_t s = 0; s < p_; ++s) {
-        if(is_ordinal_variable_(s)) {
+        if(block_main_.enabled) {
+            // Adapted by block_main_, not by the per-slot controller
+            update_main_effect_block(s, iteration);
+        } else if(is_ordinal_variable_(s)) {
             for(int c = 0; c < num_categories_(s); ++c) {
                 ar_main_disc(s, c) = update_main_effect(s, c, std::nullopt);
                 mask_main_disc(s, c) = 1;
@@ -1281,6 +1524,17 @@ void MixedMRFModel::init_metropolis_adaptation(const WarmupSchedule& schedule) {
         proposal_sd_pairwise_continuous_, schedule, target_accept_);
     mh_adapter_pairwise_cross_ = std::make_unique<MetropolisAdaptationController>(
         proposal_sd_pairwise_cross_, schedule, target_accept_);
+    block_main_.set_warmup(schedule.total_warmup);
+}
+
+void MixedMRFModel::set_block_main_effects(bool enabled) {
+    block_main_.enabled = enabled;
+    if(!enabled) return;
+    arma::uvec block_sizes(p_);
+    for(size_t s = 0; s < p_; ++s) {
+        block_sizes(s) = is_ordinal_variable_(s) ? num_categories_(s) : 2;
+    }
+    block_main_.resize(block_sizes, proposal_sd_main_discrete_);
 }
 
 void MixedMRFModel::sweep_within_model_mh(std::optional<double> rm_weight) {
@@ -1330,57 +1584,84 @@ void MixedMRFModel::update_edge_indicators() {
 
     invalidate_gradient_cache();
 
+    if(informed_edges_.drawing()) {
+        // As many moves as a sequential sweep, on edges drawn by weight
+        const size_t num_edges = num_pairwise_xx_ + num_pairwise_yy_ + num_cross_;
+        for(size_t e = 0; e < num_edges; ++e) {
+            update_edge_indicator_at(informed_edges_.draw(rng_));
+        }
+        return;
+    }
+
     // Discrete-discrete edges (shuffled order)
     for(size_t e = 0; e < num_pairwise_xx_; ++e) {
-        size_t idx = edge_order_xx_(e);
+        size_t edge = edge_order_xx_(e);
+        informed_edges_.record(edge, update_edge_indicator_at(edge));
+    }
+
+    // Continuous-continuous edges (shuffled order)
+    for(size_t e = 0; e < num_pairwise_yy_; ++e) {
+        size_t edge = num_pairwise_xx_ + edge_order_yy_(e);
+        informed_edges_.record(edge, update_edge_indicator_at(edge));
+    }
+
+    // Cross edges (shuffled order)
+    for(size_t e = 0; e < num_cross_; ++e) {
+        size_t edge = num_pairwise_xx_ + num_pairwise_yy_ + edge_order_xy_(e);
+        informed_edges_.record(edge, update_edge_indicator_at(edge));
+    }
+}
+
+
+double MixedMRFModel::update_edge_indicator_at(size_t edge) {
+    if(edge < num_pairwise_xx_) {
         // Decode upper-triangle index to (i, j)
         size_t i = 0, j = 1;
         size_t count = 0;
         for(i = 0; i < p_ - 1; ++i) {
             size_t row_len = p_ - 1 - i;
-            if(count + row_len > idx) {
-                j = i + 1 + (idx - count);
+            if(count + row_len > edge) {
+                j = i + 1 + (edge - count);
                 break;
             }
             count += row_len;
         }
-        update_edge_indicator_discrete(i, j);
+        return update_edge_indicator_discrete(i, j);
     }
+    edge -= num_pairwise_xx_;
 
-    // Continuous-continuous edges (shuffled order)
-    for(size_t e = 0; e < num_pairwise_yy_; ++e) {
-        size_t idx = edge_order_yy_(e);
+    if(edge < num_pairwise_yy_) {
         size_t i = 0, j = 1;
         size_t count = 0;
         for(i = 0; i < q_ - 1; ++i) {
             size_t row_len = q_ - 1 - i;
-            if(count + row_len > idx) {
-                j = i + 1 + (idx - count);
+            if(count + row_len > edge) {
+                j = i + 1 + (edge - count);
                 break;
             }
             count += row_len;
         }
-        update_edge_indicator_continuous(i, j);
+        return update_edge_indicator_continuous(i, j);
     }
+    edge -= num_pairwise_yy_;
 
-    // Cross edges (shuffled order)
-    for(size_t e = 0; e < num_cross_; ++e) {
-        size_t idx = edge_order_xy_(e);
-        size_t i = idx / q_;
-        size_t j = idx % q_;
-        update_edge_indicator_cross(i, j);
-    }
+    return update_edge_indicator_cross(edge / q_, edge % q_);
 }
 
 void MixedMRFModel::prepare_iteration() {
     // Shuffle edge-update order to avoid order bias.
     // Always called, even when edge selection is off, to keep RNG consistent.
-    edge_order_xx_ = arma_randperm(rng_, num_pairwise_xx_);
-    edge_order_yy_ = arma_randperm(rng_, num_pairwise_yy_);
-    edge_order_xy_ = arma_randperm(rng_, num_cross_);
+    arma_randperm_into(rng_, edge_order_xx_, num_pairwise_xx_);
+    arma_randperm_into(rng_, edge_order_yy_, num_pairwise_yy_);
+    arma_randperm_into(rng_, edge_order_xy_, num_cross_);
 }
 
 void MixedMRFModel::tune_proposal_sd(int iteration, const WarmupSchedule& schedule) {
+    // The surrogate curvature is learned until the last warmup iteration
+    delayed_acceptance_.adapting = !schedule.sampling(iteration + 1);
+    // So are the weights of the informed edge schedule
+    informed_edges_.adapting = informed_edges_.enabled && !schedule.sampling(iteration + 1);
+
     auto rm_weight_opt = schedule.rm_weight_for_proposal_sd(iteration);
     if (!rm_weight_opt) return;
     // Stage-3b sweep: re-run every within-model MH proposal with RM
@@ -3,15 +3,22 @@
 #include <array>
 #include <memory>
 #include <optional>
+#include <vector>
 #include "models/base_model.h"
+#include "models/shared_data.h"
 #include "models/ggm/graph_constraint_structure.h"
 #include "models/ggm/ggm_gradient.h"
+#include "models/mixed/mixed_mrf_projection.h"
+#include "models/mixed/mixed_mrf_workspace.h"
 #include "math/cholesky_helpers.h"
 #include "math/cholupdate.h"
 #include "rng/rng_utils.h"
 #include "priors/parameter_prior.h"
+#include "mcmc/samplers/delayed_acceptance.h"
+#include "mcmc/samplers/informed_edge_schedule.h"
 #include "mcmc/samplers/metropolis_adaptation.h"
 #include "utils/variable_helpers.h"
+#include "utils/variable_kernels.h"
 
 /**
  * MixedMRFModel - Mixed Markov Random Field Model
@@ -90,6 +97,8 @@ public:
 
     /** @return true when edge selection is enabled. */
     bool has_edge_selection() const override { return edge_selection_; }
+    /** @return true: edge toggles are reported to the edge prior. */
+    bool reports_edge_changes() const override { return true; }
     /** @return true when missing-data imputation is active. */
     bool has_missing_data() const override { return has_missing_; }
     /** @return true when edge selection or a sparse graph requires RATTLE projection. */
@@ -113,6 +122,14 @@ public:
      */
     void do_one_metropolis_step(int iteration = -1) override;
 
+    /**
+     * Log-likelihood ratio of the continuous block for moving precision
+     * entries (i, j) and (j, j) to `precision_ij` and `precision_jj` (only
+     * (j, j) when i == j), priced as the precision updates price their
+     * proposals. Leaves the state unchanged.
+     */
+    double log_ggm_ratio(int i, int j, double precision_ij, double precision_jj);
+
     /**
      * Set the Robbins-Monro target acceptance rate used by the
      * adaptive-Metropolis updates of this mixed model. Honoured by the
@@ -135,6 +152,62 @@ public:
         determinant_tilt_yy_ = delta;
     }
 
+    /**
+     * Screen the discrete-discrete pairwise and edge-indicator proposals
+     * with a quadratic surrogate before the exact ratio (see
+     * DelayedAcceptance). A proposal rejected at the first stage skips the
+     * proposed marginal OMRF terms and the marginal-interaction refreshes.
+     * The stage-3b tuning sweeps keep the single-stage test.
+     */
+    void set_delayed_acceptance(bool enabled) {
+        delayed_acceptance_.enabled = enabled;
+        delayed_acceptance_.resize(p_);
+    }
+
+    /**
+     * Draw the edges of each sampling sweep of the indicators, over all
+     * three edge types, in proportion to how often their flips were
+     * accepted in warmup (see InformedEdgeSchedule). The warmup sweeps
+     * are sequential and teach the weights.
+     */
+    void set_informed_edge_updates(bool enabled) {
+        informed_edges_.enabled = enabled;
+        informed_edges_.resize(enabled ? get_num_pairwise() : 0);
+    }
+
+    /**
+     * Update the main effects of each discrete variable (all thresholds,
+     * or both Blume-Capel parameters) in one joint Metropolis move of
+     * do_one_metropolis_step(), with a proposal covariance learned in
+     * warmup (see BlockMetropolisAdaptation): two marginal OMRF terms per
+     * variable and sweep instead of two per parameter. The stage-3b
+     * tuning sweeps keep the per-parameter moves.
+     */
+    void set_block_main_effects(bool enabled);
+
+    /**
+     * Move the parameters to the mode of the log-pseudoposterior by L-BFGS
+     * on logp_and_gradient(), before warmup (see
+     * OMRFModel::initialize_from_pseudo_mle). The inverse curvature there
+     * seeds the NUTS/HMC inverse mass diagonal and the Metropolis proposal
+     * SDs of the discrete and cross blocks and the continuous means.
+     * Excluded discrete and cross edges stay at zero; with constraints, the
+     * precision is projected back onto the graph.
+     */
+    void initialize_from_pseudo_mle();
+
+    /** @return Inverse mass set by initialize_from_pseudo_mle(), or empty. */
+    arma::vec initial_inv_mass() const override { return initial_inv_mass_; }
+
+    /**
+     * Build the p x n transpose of the discrete observations that the
+     * gradient paths multiply with. Metropolis sweeps never read it, so the
+     * constructor leaves it out; sample_mixed() calls this before the chains
+     * are cloned under a gradient sampler, so the chains share one copy.
+     * The gradient entry points call it too, as a no-op once it exists.
+     */
+    void prepare_gradient_data();
+
     /**
      * Construct Robbins-Monro adaptation controllers for the per-iteration
      * MH proposal SDs. Called once by MetropolisSampler before warmup; under
@@ -212,6 +285,9 @@ public:
     /** Get vectorized edge indicators (Gxx upper-tri, Gyy upper-tri, Gxy full). */
     arma::ivec get_vectorized_indicator_parameters() override;
 
+    /** Pack edge indicators (same order) without building the vector. */
+    void pack_indicator_parameters(IndicatorBitWriter& out) override;
+
     /** Get active subset of inverse mass diagonal (includes Cholesky block). */
     arma::vec get_active_inv_mass() const override;
 
@@ -248,15 +324,37 @@ public:
     // Infrastructure
     // =========================================================================
 
-    /** Set random seed for reproducibility. */
-    void set_seed(int seed) override;
+    /** Replace the random number generator. */
+    void set_rng(const SafeRNG& rng) override;
 
     /** Clone the model for parallel execution. */
     std::unique_ptr<BaseModel> clone() const override;
 
+    /** Give this clone its own copy of the observations. */
+    void replicate_shared_data() override { data_.detach(); }
+
     /** @return Reference to the model's random number generator. */
     SafeRNG& get_rng() override { return rng_; }
 
+    /**
+     * Save the five parameter blocks, edge indicators, inclusion
+     * probabilities and the five proposal-SD blocks.
+     */
+    void save_state(SamplerState& state) const override;
+
+    /**
+     * Restore a save_state() state; recomputes the precision decomposition,
+     * conditional mean and marginal interactions, and marks the constraint
+     * and gradient caches stale.
+     */
+    void restore_state(const SamplerState& state) override;
+
+    /**
+     * Replicate of the data from simulate_mixed_mrf_vectorized() at the
+     * current parameters: the discrete scores, then the continuous variables.
+     */
+    void simulate_replicate(int num_states, int gibbs_iter, SafeRNG& rng, arma::mat& out) override;
+
     /** @return Current edge-indicator matrix ((p+q) × (p+q)). */
     const arma::imat& get_edge_indicators() const override {
         return edge_indicators_;
@@ -290,8 +388,8 @@ public:
     /**
      * Register missing-data locations for discrete and continuous sub-matrices.
      *
-     * @param missing_discrete  M_d x 2 matrix of 0-based (row, col) indices into discrete_observations_
-     * @param missing_continuous M_c x 2 matrix of 0-based (row, col) indices into continuous_observations_
+     * @param missing_discrete  M_d x 2 matrix of 0-based (row, col) indices into the discrete observations
+     * @param missing_continuous M_c x 2 matrix of 0-based (row, col) indices into the continuous observations
      */
     void set_missing_data(const arma::imat& missing_discrete,
                           const arma::imat& missing_continuous);
@@ -308,6 +406,19 @@ private:
     // are not yet adjusted.
     double determinant_tilt_yy_ = 0.0;
 
+    // Two-stage discrete pairwise and edge moves (see set_delayed_acceptance)
+    DelayedAcceptance delayed_acceptance_;
+
+    // Joint main-effect proposals per discrete variable (see set_block_main_effects)
+    BlockMetropolisAdaptation block_main_;
+
+    // Learned pair weights of the edge sweep (see set_informed_edge_updates)
+    InformedEdgeSchedule informed_edges_;
+
+    // Inverse curvature at the pseudo-MLE (see initialize_from_pseudo_mle;
+    // empty = identity)
+    arma::vec initial_inv_mass_;
+
     /// Per-iteration adaptation controllers (MH mode only — under NUTS these
     /// stay null and the stage-3b path in tune_proposal_sd is used instead).
     /// One adapter per proposal-SD storage; off-diag and diag of the continuous
@@ -335,9 +446,14 @@ private:
     // Data
     // =========================================================================
 
-    arma::imat discrete_observations_;   ///< Discrete observations (n x p), BC columns centered
-    arma::mat discrete_observations_dbl_; ///< Double version (post-centering)
-    arma::mat continuous_observations_;  ///< Continuous observations (n x q)
+    /// Observations, shared by the chain clones (copied only to impute)
+    struct ObservationData {
+        arma::imat discrete_observations;    ///< Discrete observations (n x p), BC columns centered
+        arma::mat discrete_observations_dbl; ///< Double version (post-centering)
+        arma::mat discrete_observations_dbl_t; ///< p x n transpose (gradient only, see prepare_gradient_data)
+        arma::mat continuous_observations;   ///< Continuous observations (n x q)
+    };
+    SharedData<ObservationData> data_;
     arma::ivec num_categories_;         ///< Categories per discrete variable (p-vector)
     int max_cats_;                      ///< max(num_categories)
     arma::uvec is_ordinal_variable_;    ///< 1 = ordinal, 0 = Blume-Capel (p-vector)
@@ -411,6 +527,14 @@ private:
     arma::mat marginal_interactions_;                       ///< p x p marginal PL interaction matrix
     arma::mat conditional_mean_;            ///< n x q conditional mean
 
+    // Residual cache for the precision proposals, rebuilt lazily by
+    // ensure_residual_cache() after conditional_mean_ or the observations
+    // change. Lets log_ggm_ratio_* price a proposal in O(nq).
+    arma::mat cross_projection_;            ///< n x q X A_xy
+    arma::mat residual_continuous_;         ///< n x q D = Y - conditional_mean_
+    arma::mat residual_precision_;          ///< n x q D Precision
+    bool residual_cache_valid_ = false;
+
     // Rank-1 Cholesky update workspace
     std::array<double, 6> cont_constants_{};  ///< Reparameterization constants
     arma::mat precision_proposal_;        ///< q x q scratch for proposed precision
@@ -420,14 +544,17 @@ private:
     arma::vec cont_v2_ = {0, 0};
     arma::vec cont_vf1_;                      ///< q-vector, zeroed between uses
     arma::vec cont_vf2_;                      ///< q-vector, zeroed between uses
-    arma::vec cont_u1_;                       ///< q-vector workspace
-    arma::vec cont_u2_;                       ///< q-vector workspace
+    arma::mat cont_rank2_factors_;            ///< q x 2: update and downdate vectors
+    CholeskyUpdateWorkspace cont_chol_workspace_; ///< rotations of cholesky_rank_update()
+
+    // Per-chain buffers for the MH sweep and its proposals. Mutable because
+    // the const likelihood terms write their rest scores into it.
+    mutable MixedMHWorkspace mh_workspace_;
 
     // =========================================================================
     // Gradient cache (populated by ensure_gradient_cache)
     // =========================================================================
 
-    arma::mat discrete_observations_dbl_t_; ///< p x n transpose (BLAS gradient)
     arma::vec grad_obs_cache_;          ///< Cached observed-data gradient component
     arma::imat disc_index_cache_;        ///< p x p map from (i,j) to gradient index
     arma::imat cross_index_cache_;        ///< p x q map from (i,j) to gradient index
@@ -435,10 +562,11 @@ private:
     int chol_grad_offset_ = 0;          ///< Offset of Cholesky block in gradient vector
     bool gradient_cache_valid_ = false; ///< Whether gradient cache is current
 
-    // Per-chain scratch for compute_logZ_and_probs_*_into. Reused across
+    // Per-chain scratch for compute_logZ_moments_*_tiled. Reused across
     // every call to logp_and_gradient and across every variable inside it.
-    mutable LogZAndProbs logz_out_;
-    mutable LogZScratch  logz_scratch_;
+    mutable LogZMoments logz_moments_;
+    mutable LogZScratch logz_scratch_;
+    std::vector<LogZKernels> logz_kernels_; ///< Log-normalizer kernels per discrete variable
 
     // =========================================================================
     // RATTLE constraint structure
@@ -458,6 +586,8 @@ private:
     bool has_sparse_graph_ = false;
     /// PCG warm-start cache for RATTLE momentum projection.
     mutable arma::vec pcg_lambda_cache_;
+    /// Jacobian factors and buffers shared by the RATTLE projections.
+    mutable RattleProjectionWorkspace projection_workspace_;
 
     // =========================================================================
     // RNG and edge-update order
@@ -475,12 +605,15 @@ private:
     /** Count total main-effect parameters across all discrete variables. */
     size_t count_num_main_effects() const;
 
-    /** Compute category counts and BC sufficient statistics from discrete_observations_. */
+    /** Compute category counts and BC sufficient statistics from the discrete observations. */
     void compute_sufficient_statistics();
 
     /** Recompute conditional_mean_ from main_effects_continuous_, pairwise_effects_cross_, covariance_continuous_. */
     void recompute_conditional_mean();
 
+    /** Rebuild cross_projection_, residual_continuous_, residual_precision_ if stale. */
+    void ensure_residual_cache();
+
     /** Recompute cholesky_of_precision_, inv_cholesky_of_precision_, covariance_continuous_, log_det_precision_ from pairwise_effects_continuous_. */
     void recompute_pairwise_effects_continuous_decomposition();
 
@@ -490,6 +623,9 @@ private:
     /** Rebuild Cholesky constraint structure and excluded-edge index lists. */
     void ensure_constraint_structure();
 
+    /** Unpack the Cholesky block (Block 5) of a full position into a q x q Phi. */
+    void unpack_cholesky_block(const arma::vec& x, arma::mat& Phi) const;
+
     // =========================================================================
     // Gradient helpers (implemented in mixed_mrf_gradient.cpp)
     // =========================================================================
@@ -516,6 +652,14 @@ private:
     /** Marginal OMRF pseudolikelihood for discrete variable s, using marginal_interactions_. */
     double log_marginal_omrf(int s) const;
 
+    /**
+     * log_marginal_omrf(s) with marginal_interactions_(s, partner) moved by
+     * delta (0 = current state), from the moments kernel; the expected
+     * scores of s are swapped into `expected_score`.
+     */
+    double log_marginal_omrf_shifted(int s, int partner, double delta,
+                                     arma::vec& expected_score) const;
+
     /** Conditional GGM log-likelihood: log f(y | x), using cached decomposition. */
     double log_conditional_ggm() const;
 
@@ -534,15 +678,16 @@ private:
 
     // Log-likelihood ratio for a proposed off-diagonal precision change (rank-2).
     // Assumes precision_proposal_ is already filled by the caller. Writes the
-    // proposed covariance Σ' (computed via Woodbury) to cov_prop_out so callers
-    // can use it to recompute marginal_interactions_ for the OMRF likelihood
-    // ratio at the proposed Kyy.
-    double log_ggm_ratio_edge(int i, int j, arma::mat& cov_prop_out) const;
+    // proposed covariance Σ' (computed via Woodbury) to mh_workspace_.cov_prop
+    // so callers can use it to recompute marginal_interactions_ for the OMRF
+    // likelihood ratio at the proposed Kyy.
+    double log_ggm_ratio_edge(int i, int j);
 
     // Log-likelihood ratio for a proposed diagonal precision change (rank-1).
     // Assumes precision_proposal_ is already filled by the caller. Writes the
-    // proposed covariance Σ' (computed via Sherman-Morrison) to cov_prop_out.
-    double log_ggm_ratio_diag(int i, arma::mat& cov_prop_out) const;
+    // proposed covariance Σ' (computed via Sherman-Morrison) to
+    // mh_workspace_.cov_prop.
+    double log_ggm_ratio_diag(int i);
 
     // log|Kyy_prop| - log|Kyy_curr| for a rank-2 off-diagonal proposal at
     // (i, j), via the matrix-determinant lemma in O(q). Reads
@@ -594,12 +739,29 @@ private:
     /** Update one main-effect: main_effects_discrete_(s, c). Ordinal threshold or BC α/β. */
     double update_main_effect(int s, int c, std::optional<double> rm_weight);
 
+    /**
+     * Update all main effects of discrete variable s jointly
+     * (set_block_main_effects); `iteration` drives the proposal adaptation.
+     */
+    double update_main_effect_block(int s, int iteration);
+
     /** Update one continuous mean: main_effects_continuous_(j). */
     double update_continuous_mean(int j, std::optional<double> rm_weight);
 
     /** Update one discrete interaction: pairwise_effects_discrete_(i, j). Symmetric. */
     double update_pairwise_discrete(int i, int j, std::optional<double> rm_weight);
 
+    /**
+     * Two-stage test of moving pairwise_effects_discrete_(i, j) by `delta`;
+     * `log_other` holds the prior, proposal and inclusion-odds terms. Sets
+     * `accept_prob` to the second-stage acceptance probability, or 0 when
+     * the first stage rejects. Leaves the state unchanged.
+     *
+     * @return Whether the move is accepted
+     */
+    bool delayed_acceptance_test_discrete(int i, int j, double delta, double log_other,
+                                          double& accept_prob);
+
     /** Update one off-diagonal precision element. Cholesky-based. */
     double update_pairwise_effects_continuous_offdiag(int i, int j, std::optional<double> rm_weight);
 
@@ -611,14 +773,23 @@ private:
 
     // --- Edge-indicator update sweeps ---
 
+    // Each returns its acceptance probability (for the informed edge schedule)
+
     /** Metropolis-Hastings add-delete move for one discrete-discrete edge. */
-    void update_edge_indicator_discrete(int i, int j);
+    double update_edge_indicator_discrete(int i, int j);
 
     /** Metropolis-Hastings add-delete move for one continuous-continuous edge. */
-    void update_edge_indicator_continuous(int i, int j);
+    double update_edge_indicator_continuous(int i, int j);
 
     /** Metropolis-Hastings add-delete move for one cross-type edge. */
-    void update_edge_indicator_cross(int i, int j);
+    double update_edge_indicator_cross(int i, int j);
+
+    /**
+     * Add-delete move for edge `edge` of the informed edge schedule, which
+     * numbers the discrete-discrete pairs first, then the
+     * continuous-continuous pairs, then the cross pairs.
+     */
+    double update_edge_indicator_at(size_t edge);
 
     // =========================================================================
     // Edge-indicator accessor helpers
@@ -628,15 +799,21 @@ private:
     int gyy(int i, int j) const { return edge_indicators_(p_ + i, p_ + j); }
     int gxy(int i, int j) const { return edge_indicators_(i, p_ + j); }
 
+    // The setters report a switched indicator to the edge prior
     void set_gxx(int i, int j, int val) {
+        if (edge_indicators_(i, j) != val) edge_changes_.toggled(i, j, val != 0);
         edge_indicators_(i, j) = val;
         edge_indicators_(j, i) = val;
     }
     void set_gyy(int i, int j, int val) {
+        if (edge_indicators_(p_ + i, p_ + j) != val) {
+            edge_changes_.toggled(p_ + i, p_ + j, val != 0);
+        }
         edge_indicators_(p_ + i, p_ + j) = val;
         edge_indicators_(p_ + j, p_ + i) = val;
     }
     void set_gxy(int i, int j, int val) {
+        if (edge_indicators_(i, p_ + j) != val) edge_changes_.toggled(i, p_ + j, val != 0);
         edge_indicators_(i, p_ + j) = val;
     }
 };
@@ -0,0 +1,96 @@
+#pragma once
+
+/**
+ * @file mixed_mrf_projection.h
+ * @brief Reusable buffers and factors for the RATTLE projections of
+ *        MixedMRFModel.
+ */
+
+#include <RcppArmadillo.h>
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+
+/**
+ * RattleProjectionWorkspace - Per-chain state of the Gyy-block projections
+ *
+ * A constrained leapfrog step projects the momentum at its start point,
+ * the position once, and the momentum again at the projected end point,
+ * where the next step starts. The constraint Jacobian depends on the
+ * Cholesky block of the position only, so the factors built at one point
+ * serve every later projection at that point:
+ *
+ *   - project_position() leaves, per constrained column q, A_q and
+ *     G_q = A_q M_q^{-1} A_q' of the projected point;
+ *   - project_momentum() at that point only adds the self-interaction
+ *     terms and inverts, and keeps the inverted preconditioner blocks for
+ *     the next momentum projection at the same point.
+ *
+ * The factors are keyed by the Cholesky block of the position and of the
+ * inverse mass diagonal they were built for, compared entry by entry.
+ * Owned by the model (one per chain, copied with it), like
+ * MixedMHWorkspace; reset() when the constraint structure changes.
+ */
+class RattleProjectionWorkspace {
+public:
+    /// Zero-constraint on K(i, q), i < q: its rows i and q of the Cholesky
+    /// block start at off_i and off_q in the full position.
+    struct Constraint { std::size_t i, q, off_i, off_q; };
+
+    /// Drop the cached factors and constraints, and size for q columns.
+    void reset(std::size_t q) {
+        Aq.assign(q, arma::mat());
+        Gq.assign(q, arma::mat());
+        Gq_inv.assign(q, arma::mat());
+        block_offset.assign(q, 0);
+        constraints.clear();
+        constraints_valid = false;
+        jacobian_valid = false;
+        preconditioner_valid = false;
+        key_x_.reset();
+        key_inv_mass_.reset();
+    }
+
+    /// Whether the factors were built for this Cholesky block of x and of
+    /// the inverse mass (length `size` from `offset`).
+    bool matches(const arma::vec& x, const arma::vec& inv_mass,
+                 std::size_t offset, std::size_t size) const {
+        return key_x_.n_elem == size && key_inv_mass_.n_elem == size &&
+               std::equal(key_x_.begin(), key_x_.end(), x.begin() + offset) &&
+               std::equal(key_inv_mass_.begin(), key_inv_mass_.end(),
+                          inv_mass.begin() + offset);
+    }
+
+    /// Record the point the freshly built Jacobian factors belong to.
+    void set_key(const arma::vec& x, const arma::vec& inv_mass,
+                 std::size_t offset, std::size_t size) {
+        key_x_.set_size(size);
+        key_inv_mass_.set_size(size);
+        std::copy(x.begin() + offset, x.begin() + offset + size, key_x_.begin());
+        std::copy(inv_mass.begin() + offset, inv_mass.begin() + offset + size,
+                  key_inv_mass_.begin());
+        jacobian_valid = true;
+        preconditioner_valid = false;
+    }
+
+    arma::mat Phi;                      ///< Working Cholesky factor (q x q)
+    std::vector<arma::mat> Aq;          ///< Constraint matrix of each column
+    std::vector<arma::mat> Gq;          ///< A_q M_q^{-1} A_q' of each column
+    std::vector<arma::mat> Gq_inv;      ///< Momentum preconditioner block of each column
+    std::vector<std::size_t> block_offset; ///< First constraint of each column
+    bool jacobian_valid = false;        ///< Aq and Gq match the key
+    bool preconditioner_valid = false;  ///< Gq_inv matches the key
+
+    std::vector<Constraint> constraints; ///< All Gyy constraints, column by column
+    bool constraints_valid = false;
+
+    // Scratch of the position projection and the momentum PCG
+    arma::mat Aq_scaled;
+    arma::vec x_q, inv_mass_q, rhs_q, lambda_q;
+    arma::vec scratch, b, lambda, cg_r, z, cg_d, Ad;
+
+private:
+    arma::vec key_x_;
+    arma::vec key_inv_mass_;
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+/**
+ * @file mixed_mrf_workspace.h
+ * @brief Reusable buffers for the MixedMRFModel Metropolis sweep.
+ */
+
+#include <RcppArmadillo.h>
+#include "mcmc/execution/chain_profile.h"
+
+
+/**
+ * MixedMHWorkspace - Per-chain buffers for MixedMRFModel MH updates
+ *
+ * Owned by the model (one per chain, copied with it), in the spirit of
+ * LogZScratch. prepare() sizes every buffer once; afterwards the sweep
+ * accept-rate/mask matrices, the Woodbury vectors and proposed covariance
+ * of the precision proposals, the proposal snapshots, and the rest scores
+ * of log_marginal_omrf are only ever assigned same-sized expressions, which
+ * Armadillo writes in place. Snapshots are restored by swap() rather than
+ * move so both sides keep their memory.
+ *
+ * prepare() counts the buffers it had to (re)size and adds the count to
+ * the chain profile's per-iteration workspace allocations; in steady state
+ * that count is zero.
+ */
+class MixedMHWorkspace {
+public:
+    /**
+     * Size every buffer for n persons, p discrete and q continuous
+     * variables with up to max_cats categories. Buffers that already have
+     * the right size are left untouched.
+     */
+    void prepare(arma::uword n, arma::uword p, arma::uword q, arma::uword max_cats) {
+        last_allocations_ = 0;
+
+        fit(ar_main_disc, p, max_cats);
+        fit(mask_main_disc, p, max_cats);
+        fit(ar_main_cont, q, 1);
+        fit(mask_main_cont, q, 1);
+        fit(ar_pair_disc, p, p);
+        fit(mask_pair_disc, p, p);
+        fit(ar_pair_cont, q, q);
+        fit(mask_pair_cont, q, q);
+        fit(ar_pair_cross, p, q);
+        fit(mask_pair_cross, p, q);
+
+        fit(cov_prop, q, q);
+        fit(s1, q);
+        fit(s2, q);
+        fit(w1, q);
+        fit(w2, q);
+        fit(yc_i, n);
+        fit(yc_j, n);
+        fit(fi, n);
+        fit(fj, n);
+        fit(b1, n);
+        fit(b2, n);
+        fit(e1, n);
+        fit(e2, n);
+
+        fit(pairwise_saved, q, q);
+        fit(covariance_saved, q, q);
+        fit(marginal_saved, p, p);
+        fit(cond_mean_saved, n, q);
+
+        fit(cross_covariance, p, q);
+        fit(residual, n, q);
+        fit(residual_precision, n, q);
+        fit(rest, n);
+        fit(bound, n);
+        fit(score_i, n);
+        fit(score_j, n);
+        fit(score_prop_i, n);
+        fit(score_prop_j, n);
+
+        profile_workspace_allocations(last_allocations_);
+    }
+
+    /** @return Buffer (re)allocations made by the most recent prepare(). */
+    int last_allocations() const { return last_allocations_; }
+
+    // Sweep accept rates and visit masks, one pair per proposal-SD storage
+    arma::mat  ar_main_disc, ar_main_cont, ar_pair_disc, ar_pair_cont, ar_pair_cross;
+    arma::umat mask_main_disc, mask_main_cont, mask_pair_disc, mask_pair_cont, mask_pair_cross;
+
+    // Precision proposals: proposed covariance, Woodbury vectors (q), and
+    // the rank-2 residual corrections (n)
+    arma::mat cov_prop;
+    arma::vec s1, s2, w1, w2;
+    arma::vec yc_i, yc_j, fi, fj, b1, b2, e1, e2;
+
+    // Accepted state saved around the evaluation of a proposed state
+    arma::mat pairwise_saved, covariance_saved, marginal_saved, cond_mean_saved;
+
+    // A_xy Σ (p x q), shared by the conditional-mean and marginal-interaction
+    // refreshes; residual D and D A_yy for log_conditional_ggm; rest scores
+    // and bounds for log_marginal_omrf
+    arma::mat cross_covariance, residual, residual_precision;
+    arma::vec rest, bound;
+
+    // Expected scores of the two variables of a delayed-acceptance move, at
+    // the current and the proposed state
+    arma::vec score_i, score_j, score_prop_i, score_prop_j;
+
+private:
+    template <typename M>
+    void fit(M& m, arma::uword rows, arma::uword cols) {
+        if (m.n_rows != rows || m.n_cols != cols) {
+            m.set_size(rows, cols);
+            ++last_allocations_;
+        }
+    }
+
+    void fit(arma::vec& v, arma::uword len) {
+        if (v.n_elem != len) {
+            v.set_size(len);
+            ++last_allocations_;
+        }
+    }
+
+    int last_allocations_ = 0;
+};
@@ -0,0 +1,36 @@
+// Stubs for builds without the CUDA backend (see omrf_gpu_backend.h); with
+// BGMS_USE_CUDA the definitions come from omrf_gpu_kernels.cu.
+#include "models/omrf/omrf_gpu_backend.h"
+
+#ifndef BGMS_USE_CUDA
+
+#include <stdexcept>
+
+struct OMRFGpuBackend::Impl {};
+
+
+bool omrf_gpu_backend_compiled() {
+    return false;
+}
+
+
+OMRFGpuBackend::OMRFGpuBackend(const std::int8_t*, int, int, const int*, const int*, const int*) {
+    throw std::runtime_error(
+        "bgms was built without GPU support; reinstall it with BGMS_CUDA=1 "
+        "and the CUDA toolkit on the path to use gradient_backend = \"gpu\".");
+}
+
+
+OMRFGpuBackend::OMRFGpuBackend(const OMRFGpuBackend&) {
+    throw std::runtime_error("bgms was built without GPU support.");
+}
+
+
+OMRFGpuBackend::~OMRFGpuBackend() = default;
+
+
+void OMRFGpuBackend::evaluate(const double*, int, const double*, double*, double*, double*) {
+    throw std::runtime_error("bgms was built without GPU support.");
+}
+
+#endif
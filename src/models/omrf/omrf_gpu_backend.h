@@ -0,0 +1,72 @@
+#pragma once
+
+/**
+ * @file omrf_gpu_backend.h
+ * @brief Optional CUDA backend for the OMRF pseudolikelihood gradient.
+ *
+ * For very large n the per-variable normalizers, category probabilities,
+ * expected scores and the X^T E product of OMRFModel::logp_and_gradient()
+ * are dense and independent over persons. OMRFGpuBackend keeps the scores
+ * on the device and evaluates that pipeline there, so only the parameters
+ * go to the device and the per-variable reductions come back on each
+ * gradient call.
+ *
+ * The device code (omrf_gpu_kernels.cu) is compiled when configure finds
+ * nvcc and BGMS_CUDA is set (see configure); other builds compile stubs
+ * that refuse to construct a backend. This header has no Armadillo or R
+ * dependency so nvcc can compile against it.
+ *
+ * All reductions are of fixed shape (blocks of persons, tree within a
+ * block, blocks summed in order), so results do not depend on scheduling.
+ */
+
+#include <cstdint>
+#include <memory>
+
+
+/** @return Whether this build contains the CUDA backend. */
+bool omrf_gpu_backend_compiled();
+
+
+class OMRFGpuBackend {
+public:
+    /**
+     * Upload the scores and variable layout.
+     *
+     * @param scores             n x p scores, column-major, as the model
+     *                           stores them (Blume-Capel scores centered)
+     * @param n                  Number of persons
+     * @param p                  Number of variables
+     * @param num_categories     Highest category of each variable (p)
+     * @param is_ordinal         1 for ordinal, 0 for Blume-Capel (p)
+     * @param baseline_category  Blume-Capel reference category (p)
+     * @throws std::runtime_error without a CUDA build or device
+     */
+    OMRFGpuBackend(const std::int8_t* scores, int n, int p,
+                   const int* num_categories, const int* is_ordinal,
+                   const int* baseline_category);
+
+    /** Share the device scores; the copy gets its own buffers and stream. */
+    OMRFGpuBackend(const OMRFGpuBackend& other);
+    OMRFGpuBackend& operator=(const OMRFGpuBackend&) = delete;
+    ~OMRFGpuBackend();
+
+    /**
+     * Evaluate the data part of the gradient.
+     *
+     * @param main_effects  p x main_cols main effects, column-major
+     * @param main_cols     Columns of main_effects
+     * @param pairwise      p x p pairwise effects (zero diagonal)
+     * @param log_z_sum     Output (p): sum over persons of each log-normalizer
+     * @param prob_sums     Output ((max_cats + 1) x p): sum over persons of
+     *                      each category probability
+     * @param cross         Output (p x p): cross(j, v) = sum_i x_ij E_iv, with
+     *                      E_iv the expected score of person i on variable v
+     */
+    void evaluate(const double* main_effects, int main_cols, const double* pairwise,
+                  double* log_z_sum, double* prob_sums, double* cross);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
@@ -0,0 +1,280 @@
+// CUDA implementation of OMRFGpuBackend (see omrf_gpu_backend.h). Compiled
+// only when configure enables the GPU backend.
+#include "models/omrf/omrf_gpu_backend.h"
+
+#include <cuda_runtime.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+// Persons per block; a power of two for the tree reductions
+constexpr int block_rows = 256;
+
+void check_cuda(cudaError_t status, const char* what) {
+    if (status != cudaSuccess) {
+        throw std::runtime_error(std::string("GPU gradient backend: ") + what + ": " +
+                                 cudaGetErrorString(status));
+    }
+}
+
+template <typename T>
+T* device_alloc(std::size_t count) {
+    void* ptr = nullptr;
+    check_cuda(cudaMalloc(&ptr, std::max<std::size_t>(count, 1) * sizeof(T)), "cudaMalloc");
+    return static_cast<T*>(ptr);
+}
+
+
+// Scores and variable layout, shared by the backends of all chains
+struct DeviceScores {
+    int n = 0;
+    int p = 0;
+    int max_cats = 0;
+    std::int8_t* scores = nullptr;      // n x p, column-major
+    int* num_categories = nullptr;
+    int* is_ordinal = nullptr;
+    int* baseline = nullptr;
+
+    DeviceScores() = default;
+    DeviceScores(const DeviceScores&) = delete;
+    DeviceScores& operator=(const DeviceScores&) = delete;
+    ~DeviceScores() {
+        cudaFree(scores);
+        cudaFree(num_categories);
+        cudaFree(is_ordinal);
+        cudaFree(baseline);
+    }
+};
+
+
+// Fixed-shape tree sum over the threads of a block
+__device__ double block_sum(double* shared, double value) {
+    shared[threadIdx.x] = value;
+    __syncthreads();
+    for (int stride = blockDim.x / 2; stride > 0; stride >>= 1) {
+        if (threadIdx.x < stride) shared[threadIdx.x] += shared[threadIdx.x + stride];
+        __syncthreads();
+    }
+    const double total = shared[0];
+    __syncthreads();
+    return total;
+}
+
+
+// Exponent of category c: ordinal mu_c + c r (0 for c = 0), Blume-Capel
+// alpha s + beta s^2 + s r with s = c - ref
+__device__ inline double category_exponent(int c, bool ordinal, int ref, int v, int p,
+                                           const double* main, double rest) {
+    if (ordinal) {
+        return c == 0 ? 0.0 : main[static_cast<std::size_t>(c - 1) * p + v] + c * rest;
+    }
+    const double s = static_cast<double>(c - ref);
+    return main[v] * s + main[p + v] * s * s + s * rest;
+}
+
+
+// One block per (person block, variable): rest scores, log-normalizers,
+// expected scores, and the block's sums of the log-normalizer and of each
+// category probability.
+__global__ void moments_kernel(const std::int8_t* scores,
+                               int n, int p, int max_cats,
+                               const int* num_categories, const int* is_ordinal,
+                               const int* baseline, const double* main,
+                               const double* pairwise, double* E,
+                               double* partial_log_z, double* partial_probs) {
+    __shared__ double shared[block_rows];
+    const int v = blockIdx.y;
+    const int i = blockIdx.x * blockDim.x + threadIdx.x;
+    const bool active = i < n;
+    const int K = num_categories[v];
+    const bool ordinal = is_ordinal[v] != 0;
+    const int ref = ordinal ? 0 : baseline[v];
+
+    double rest = 0.0;
+    if (active) {
+        const double* w = pairwise + static_cast<std::size_t>(v) * p;
+        for (int u = 0; u < p; ++u) {
+            rest += scores[static_cast<std::size_t>(u) * n + i] * w[u];
+        }
+        rest *= 2.0;
+    }
+
+    double shift = -INFINITY;
+    for (int c = 0; c <= K; ++c) {
+        shift = fmax(shift, category_exponent(c, ordinal, ref, v, p, main, rest));
+    }
+    double den = 0.0, num = 0.0;
+    for (int c = 0; c <= K; ++c) {
+        const double e = exp(category_exponent(c, ordinal, ref, v, p, main, rest) - shift);
+        den += e;
+        num += (c - ref) * e;
+    }
+    if (active) E[static_cast<std::size_t>(v) * n + i] = num / den;
+
+    const int num_blocks = gridDim.x;
+    const double log_z = active ? shift + log(den) : 0.0;
+    const double log_z_total = block_sum(shared, log_z);
+    if (threadIdx.x == 0) partial_log_z[static_cast<std::size_t>(v) * num_blocks + blockIdx.x] = log_z_total;
+
+    // K is the same for every thread of the block, so all reach each sum
+    for (int c = 0; c <= K; ++c) {
+        const double prob = active
+            ? exp(category_exponent(c, ordinal, ref, v, p, main, rest) - shift) / den : 0.0;
+        const double total = block_sum(shared, prob);
+        if (threadIdx.x == 0) {
+            partial_probs[(static_cast<std::size_t>(v) * (max_cats + 1) + c) * num_blocks + blockIdx.x] = total;
+        }
+    }
+}
+
+
+// Sum the block partials of each slot in block order
+__global__ void reduce_partials_kernel(const double* partials, int num_slots, int num_blocks,
+                                       double* out) {
+    const int slot = blockIdx.x * blockDim.x + threadIdx.x;
+    if (slot >= num_slots) return;
+    const double* row = partials + static_cast<std::size_t>(slot) * num_blocks;
+    double total = 0.0;
+    for (int b = 0; b < num_blocks; ++b) total += row[b];
+    out[slot] = total;
+}
+
+
+// One block per (j, v): cross(j, v) = sum_i x_ij E_iv, each thread over a
+// fixed stride of persons, then a tree sum
+__global__ void cross_kernel(const std::int8_t* scores, const double* E, int n, int p,
+                             double* cross) {
+    __shared__ double shared[block_rows];
+    const int j = blockIdx.x;
+    const int v = blockIdx.y;
+    const std::int8_t* x = scores + static_cast<std::size_t>(j) * n;
+    const double* e = E + static_cast<std::size_t>(v) * n;
+    double sum = 0.0;
+    for (int i = threadIdx.x; i < n; i += blockDim.x) sum += x[i] * e[i];
+    const double total = block_sum(shared, sum);
+    if (threadIdx.x == 0) cross[static_cast<std::size_t>(v) * p + j] = total;
+}
+
+}  // namespace
+
+
+struct OMRFGpuBackend::Impl {
+    std::shared_ptr<const DeviceScores> data;
+    cudaStream_t stream = nullptr;
+    int num_blocks = 0;
+    int main_cols = 0;
+    double* main = nullptr;             // p x main_cols
+    double* pairwise = nullptr;         // p x p
+    double* E = nullptr;                // n x p expected scores
+    double* partial_log_z = nullptr;    // num_blocks x p
+    double* partial_probs = nullptr;    // num_blocks x (max_cats + 1) x p
+    double* log_z_sum = nullptr;        // p
+    double* prob_sums = nullptr;        // (max_cats + 1) x p
+    double* cross = nullptr;            // p x p
+
+    explicit Impl(std::shared_ptr<const DeviceScores> scores) : data(std::move(scores)) {
+        const int n = data->n, p = data->p, slots = data->max_cats + 1;
+        num_blocks = (n + block_rows - 1) / block_rows;
+        check_cuda(cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking), "cudaStreamCreate");
+        pairwise = device_alloc<double>(static_cast<std::size_t>(p) * p);
+        E = device_alloc<double>(static_cast<std::size_t>(n) * p);
+        partial_log_z = device_alloc<double>(static_cast<std::size_t>(num_blocks) * p);
+        partial_probs = device_alloc<double>(static_cast<std::size_t>(num_blocks) * slots * p);
+        log_z_sum = device_alloc<double>(p);
+        prob_sums = device_alloc<double>(static_cast<std::size_t>(slots) * p);
+        cross = device_alloc<double>(static_cast<std::size_t>(p) * p);
+        // Slots above a variable's highest category are never written
+        check_cuda(cudaMemset(partial_probs, 0, sizeof(double) * num_blocks * slots * p),
+                   "cudaMemset");
+    }
+
+    ~Impl() {
+        for (double* buffer : {main, pairwise, E, partial_log_z, partial_probs,
+                               log_z_sum, prob_sums, cross}) {
+            cudaFree(buffer);
+        }
+        if (stream != nullptr) cudaStreamDestroy(stream);
+    }
+};
+
+
+bool omrf_gpu_backend_compiled() {
+    return true;
+}
+
+
+OMRFGpuBackend::OMRFGpuBackend(const std::int8_t* scores, int n, int p,
+                               const int* num_categories, const int* is_ordinal,
+                               const int* baseline_category) {
+    int device_count = 0;
+    if (cudaGetDeviceCount(&device_count) != cudaSuccess || device_count == 0) {
+        throw std::runtime_error("GPU gradient backend: no CUDA device available.");
+    }
+
+    auto data = std::make_shared<DeviceScores>();
+    data->n = n;
+    data->p = p;
+    data->max_cats = *std::max_element(num_categories, num_categories + p);
+    const std::size_t cells = static_cast<std::size_t>(n) * p;
+    data->scores = device_alloc<std::int8_t>(cells);
+    data->num_categories = device_alloc<int>(p);
+    data->is_ordinal = device_alloc<int>(p);
+    data->baseline = device_alloc<int>(p);
+    check_cuda(cudaMemcpy(data->scores, scores, cells, cudaMemcpyHostToDevice), "upload scores");
+    check_cuda(cudaMemcpy(data->num_categories, num_categories, p * sizeof(int),
+                          cudaMemcpyHostToDevice), "upload layout");
+    check_cuda(cudaMemcpy(data->is_ordinal, is_ordinal, p * sizeof(int),
+                          cudaMemcpyHostToDevice), "upload layout");
+    check_cuda(cudaMemcpy(data->baseline, baseline_category, p * sizeof(int),
+                          cudaMemcpyHostToDevice), "upload layout");
+
+    impl_ = std::make_unique<Impl>(std::move(data));
+}
+
+
+OMRFGpuBackend::OMRFGpuBackend(const OMRFGpuBackend& other)
+    : impl_(std::make_unique<Impl>(other.impl_->data)) {}
+
+
+OMRFGpuBackend::~OMRFGpuBackend() = default;
+
+
+void OMRFGpuBackend::evaluate(const double* main_effects, int main_cols, const double* pairwise,
+                              double* log_z_sum, double* prob_sums, double* cross) {
+    Impl& w = *impl_;
+    const DeviceScores& d = *w.data;
+    const int p = d.p, slots = d.max_cats + 1;
+
+    if (main_cols != w.main_cols) {
+        cudaFree(w.main);
+        w.main = device_alloc<double>(static_cast<std::size_t>(p) * main_cols);
+        w.main_cols = main_cols;
+    }
+    check_cuda(cudaMemcpyAsync(w.main, main_effects, sizeof(double) * p * main_cols,
+                               cudaMemcpyHostToDevice, w.stream), "upload main effects");
+    check_cuda(cudaMemcpyAsync(w.pairwise, pairwise, sizeof(double) * p * p,
+                               cudaMemcpyHostToDevice, w.stream), "upload pairwise effects");
+
+    moments_kernel<<<dim3(w.num_blocks, p), block_rows, 0, w.stream>>>(
+        d.scores, d.n, p, d.max_cats, d.num_categories, d.is_ordinal, d.baseline,
+        w.main, w.pairwise, w.E, w.partial_log_z, w.partial_probs);
+    reduce_partials_kernel<<<(p + block_rows - 1) / block_rows, block_rows, 0, w.stream>>>(
+        w.partial_log_z, p, w.num_blocks, w.log_z_sum);
+    reduce_partials_kernel<<<(slots * p + block_rows - 1) / block_rows, block_rows, 0, w.stream>>>(
+        w.partial_probs, slots * p, w.num_blocks, w.prob_sums);
+    cross_kernel<<<dim3(p, p), block_rows, 0, w.stream>>>(d.scores, w.E, d.n, p, w.cross);
+    check_cuda(cudaGetLastError(), "kernel launch");
+
+    check_cuda(cudaMemcpyAsync(log_z_sum, w.log_z_sum, sizeof(double) * p,
+                               cudaMemcpyDeviceToHost, w.stream), "download normalizers");
+    check_cuda(cudaMemcpyAsync(prob_sums, w.prob_sums, sizeof(double) * slots * p,
+                               cudaMemcpyDeviceToHost, w.stream), "download probabilities");
+    check_cuda(cudaMemcpyAsync(cross, w.cross, sizeof(double) * p * p,
+                               cudaMemcpyDeviceToHost, w.stream), "download cross products");
+    check_cuda(cudaStreamSynchronize(w.stream), "synchronize");
+}
@@ -1,21 +1,61 @@
 #include <RcppArmadillo.h>
+#include <algorithm>
+#include <string>
+#include <utility>
 #include "models/omrf/omrf_model.h"
+#include "rng/polya_gamma.h"
 #include "rng/rng_utils.h"
 #include "mcmc/algorithms/hmc.h"
 #include "mcmc/algorithms/nuts.h"
 #include "mcmc/algorithms/metropolis.h"
+#include "mcmc/execution/chain_profile.h"
+#include "mcmc/execution/sampler_state.h"
 #include "mcmc/execution/step_result.h"
 #include "mcmc/samplers/metropolis_adaptation.h"
 #include "mcmc/execution/chain_runner.h"
+#include "math/categorical.h"
 #include "math/explog_macros.h"
+#include "math/lbfgs.h"
+#include "math/score_file.h"
+#include "mrf_simulation.h"
 #include "utils/common_helpers.h"
 #include "utils/variable_helpers.h"
+#include "utils/parallel_helpers.h"
 
 
 // =============================================================================
 // Constructor
 // =============================================================================
 
+// Center observations for Blume-Capel variables (x - baseline) so that
+// ALL downstream code — sufficient statistics, residuals, gradients,
+// log-pseudoposterior, imputation — operates in the same coordinate
+// system. For ordinal variables baseline=0, so this is a no-op.
+static arma::ivec blume_capel_centers(const arma::uvec& is_ordinal_variable,
+                                      const arma::ivec& baseline_category) {
+    arma::ivec center(is_ordinal_variable.n_elem, arma::fill::zeros);
+    for (arma::uword v = 0; v < is_ordinal_variable.n_elem; ++v) {
+        if (!is_ordinal_variable(v)) {
+            center(v) = baseline_category(v);
+        }
+    }
+    return center;
+}
+
+
+// Pack the (already validated) scores of an R matrix straight from R's
+// memory. bgm() passes a double matrix, which an integer view would first
+// copy in full and keep next to the packed scores while the model is built.
+static CompactScores compact_scores_from_r(SEXP x, const arma::ivec& shift) {
+    if (!Rf_isMatrix(x)) Rcpp::stop("The observations must be a matrix.");
+    const arma::uword n = Rf_nrows(x);
+    const arma::uword p = Rf_ncols(x);
+    if (TYPEOF(x) == INTSXP) return CompactScores(INTEGER(x), n, p, shift);
+    if (TYPEOF(x) == REALSXP) return CompactScores(REAL(x), n, p, shift);
+    Rcpp::stop("The observations must be an integer or double matrix.");
+}
+
+
 OMRFModel::OMRFModel(
     const arma::imat& observations,
     const arma::ivec& num_categories,
@@ -27,9 +67,27 @@ OMRFModel::OMRFModel(
     std::unique_ptr<BaseParameterPrior> threshold_prior,
     bool edge_selection
 ) :
-    n_(observations.n_rows),
-    p_(observations.n_cols),
-    observations_(observations),
+    OMRFModel(
+        CompactScores(observations, blume_capel_centers(is_ordinal_variable, baseline_category)),
+        num_categories, inclusion_probability, initial_edge_indicators,
+        is_ordinal_variable, baseline_category, std::move(interaction_prior),
+        std::move(threshold_prior), edge_selection)
+{}
+
+
+OMRFModel::OMRFModel(
+    CompactScores observations,
+    const arma::ivec& num_categories,
+    const arma::mat& inclusion_probability,
+    const arma::imat& initial_edge_indicators,
+    const arma::uvec& is_ordinal_variable,
+    const arma::ivec& baseline_category,
+    std::unique_ptr<BaseParameterPrior> interaction_prior,
+    std::unique_ptr<BaseParameterPrior> threshold_prior,
+    bool edge_selection
+) :
+    n_(observations.n_rows()),
+    p_(observations.n_cols()),
     num_categories_(num_categories),
     is_ordinal_variable_(is_ordinal_variable),
     baseline_category_(baseline_category),
@@ -61,17 +119,33 @@ OMRFModel::OMRFModel(
     // Initialize mass matrix
     inv_mass_ = arma::ones<arma::vec>(num_main_ + num_pairwise_);
 
-    // Center observations for Blume-Capel variables (x - baseline) so that
-    // ALL downstream code — sufficient statistics, residuals, gradients,
-    // log-pseudoposterior, imputation — operates in the same coordinate
-    // system. For ordinal variables baseline=0, so this is a no-op.
+    // Offsets of each variable's main effects in the parameter vector
+    main_offsets_.resize(p_);
+    int main_offset = 0;
     for (size_t v = 0; v < p_; ++v) {
-        if (!is_ordinal_variable_(v)) {
-            observations_.col(v) -= baseline_category_(v);
-        }
+        main_offsets_[v] = main_offset;
+        main_offset += is_ordinal_variable_(v) ? num_categories_(v) : 2;
+    }
+    logz_workspaces_.resize(1);
+    matching_arenas_.resize(1);
+
+    // Specialised log-normalizer kernels for small category counts
+    logz_kernels_.resize(p_);
+    for (size_t v = 0; v < p_; ++v) {
+        logz_kernels_[v] = select_logz_kernels(num_categories_(v));
     }
-    observations_double_ = arma::conv_to<arma::mat>::from(observations_);
-    observations_double_t_ = observations_double_.t();
+
+    // Log-normalizer cache (filled lazily by current_log_normalizer)
+    log_normalizer_.zeros(p_);
+    log_normalizer_valid_.zeros(p_);
+    pending_partner_.set_size(p_);
+    pending_partner_.fill(-1);
+    pending_delta_.zeros(p_);
+    pending_log_normalizer_.zeros(p_);
+    expected_score_valid_.zeros(p_);
+    pending_expected_valid_.zeros(p_);
+
+    data_.mut().observations = std::move(observations);
 
     // Compute sufficient statistics
     compute_sufficient_statistics();
@@ -81,6 +155,7 @@ OMRFModel::OMRFModel(
 
     // Build interaction index
     build_interaction_index();
+    rebuild_active_neighbours();
 }
 
 
@@ -94,9 +169,8 @@ OMRFModel::OMRFModel(const OMRFModel& other)
       target_accept_(other.target_accept_),
       n_(other.n_),
       p_(other.p_),
-      observations_(other.observations_),
-      observations_double_(other.observations_double_),
-      observations_double_t_(other.observations_double_t_),
+      data_(other.data_),
+      pattern_compressed_(other.pattern_compressed_),
       num_categories_(other.num_categories_),
       is_ordinal_variable_(other.is_ordinal_variable_),
       baseline_category_(other.baseline_category_),
@@ -113,20 +187,50 @@ OMRFModel::OMRFModel(const OMRFModel& other)
       pairwise_scaling_factors_(other.pairwise_scaling_factors_),
       edge_selection_(other.edge_selection_),
       edge_selection_active_(other.edge_selection_active_),
+      inverse_temperature_(other.inverse_temperature_),
+      matching_edge_updates_(other.matching_edge_updates_),
       num_main_(other.num_main_),
       num_pairwise_(other.num_pairwise_),
       proposal_sd_main_(other.proposal_sd_main_),
       proposal_sd_pairwise_(other.proposal_sd_pairwise_),
+      block_main_(other.block_main_),
       rng_(other.rng_),
       inv_mass_(other.inv_mass_),
+      initial_inv_mass_(other.initial_inv_mass_),
       has_missing_(other.has_missing_),
       missing_index_(other.missing_index_),
+      missing_persons_(other.missing_persons_),
       grad_obs_cache_(other.grad_obs_cache_),
+      active_scaling_factors_(other.active_scaling_factors_),
       index_matrix_cache_(other.index_matrix_cache_),
       gradient_cache_valid_(other.gradient_cache_valid_),
+      logz_workspaces_(other.logz_workspaces_.size()),
+      matching_arenas_(other.matching_arenas_.size()),
+      gradient_threads_(other.gradient_threads_),
+      main_offsets_(other.main_offsets_),
+      logz_kernels_(other.logz_kernels_),
+      active_neighbours_(other.active_neighbours_),
+      num_active_edges_(other.num_active_edges_),
+      sparse_gradient_max_density_(other.sparse_gradient_max_density_),
+      log_normalizer_(other.log_normalizer_),
+      log_normalizer_valid_(other.log_normalizer_valid_),
+      pending_partner_(other.pending_partner_),
+      pending_delta_(other.pending_delta_),
+      pending_log_normalizer_(other.pending_log_normalizer_),
+      delayed_acceptance_(other.delayed_acceptance_),
+      expected_score_(other.expected_score_),
+      expected_score_valid_(other.expected_score_valid_),
+      pending_expected_score_(other.pending_expected_score_),
+      pending_expected_valid_(other.pending_expected_valid_),
       interaction_index_(other.interaction_index_),
-      shuffled_edge_order_(other.shuffled_edge_order_)
+      shuffled_edge_order_(other.shuffled_edge_order_),
+      informed_edges_(other.informed_edges_),
+      subsample_size_(other.subsample_size_),
+      subsample_refresh_(other.subsample_refresh_)
 {
+    // Imputation writes to the observations, so each chain needs its own
+    if (has_missing_) data_.detach();
+    if (other.gpu_backend_) gpu_backend_ = std::make_unique<OMRFGpuBackend>(*other.gpu_backend_);
 }
 
 
@@ -142,7 +246,7 @@ void OMRFModel::compute_sufficient_statistics() {
     for (size_t v = 0; v < p_; ++v) {
         if (is_ordinal_variable_(v)) {
             for (size_t i = 0; i < n_; ++i) {
-                int cat = observations_(i, v);
+                int cat = data_->observations(i, v);
                 if (cat >= 0 && cat <= num_categories_(v)) {
                     counts_per_category_(cat, v)++;
                 }
@@ -155,16 +259,15 @@ void OMRFModel::compute_sufficient_statistics() {
     for (size_t v = 0; v < p_; ++v) {
         if (!is_ordinal_variable_(v)) {
             for (size_t i = 0; i < n_; ++i) {
-                int s = observations_(i, v);         // already centered
+                int s = data_->observations(i, v);         // already centered
                 blume_capel_stats_(0, v) += s;       // linear
                 blume_capel_stats_(1, v) += s * s;   // quadratic
             }
         }
     }
 
-    // Pairwise statistics (X^T X) - use pre-computed transformed observations
-    arma::mat ps = observations_double_.t() * observations_double_;
-    pairwise_stats_ = arma::conv_to<arma::imat>::from(ps);
+    // Pairwise statistics (X^T X), widened a row panel at a time
+    pairwise_stats_ = arma::conv_to<arma::imat>::from(data_->observations.gram());
 }
 
 
@@ -195,14 +298,74 @@ void OMRFModel::build_interaction_index() {
 }
 
 
+void OMRFModel::rebuild_active_neighbours() {
+    active_neighbours_.assign(p_, std::vector<int>());
+    num_active_edges_ = 0;
+    for (size_t v1 = 0; v1 < p_; ++v1) {
+        for (size_t v2 = 0; v2 < p_; ++v2) {
+            if (v1 == v2 || edge_indicators_(v1, v2) == 0) continue;
+            active_neighbours_[v1].push_back(static_cast<int>(v2));
+            if (v1 < v2) num_active_edges_++;
+        }
+    }
+}
+
+
+void OMRFModel::set_active_edge(int var1, int var2, bool included) {
+    for (int var : {var1, var2}) {
+        const int other = (var == var1) ? var2 : var1;
+        std::vector<int>& neighbours = active_neighbours_[var];
+        auto it = std::lower_bound(neighbours.begin(), neighbours.end(), other);
+        const bool present = (it != neighbours.end() && *it == other);
+        if (included && !present) {
+            neighbours.insert(it, other);
+        } else if (!included && present) {
+            neighbours.erase(it);
+        }
+    }
+    if (included) {
+        num_active_edges_++;
+    } else {
+        num_active_edges_--;
+    }
+}
+
+
+void OMRFModel::set_edge_indicators(const arma::imat& edge_indicators) {
+    edge_indicators_ = edge_indicators;
+    edge_changes_.reset();
+    rebuild_active_neighbours();
+    invalidate_gradient_cache();
+}
+
+
 void OMRFModel::update_residual_matrix() {
-    residual_matrix_ = 2.0 * observations_double_ * pairwise_effects_;
+    data_->observations.mul(pairwise_effects_, 2.0, residual_matrix_, residual_panel_);
+    invalidate_log_normalizers();
 }
 
 
 void OMRFModel::update_residual_columns(int var1, int var2, double delta) {
-    residual_matrix_.col(var1) += 2.0 * delta * observations_double_.col(var2);
-    residual_matrix_.col(var2) += 2.0 * delta * observations_double_.col(var1);
+    data_->observations.add_scaled(var2, 2.0 * delta, residual_matrix_.colptr(var1));
+    data_->observations.add_scaled(var1, 2.0 * delta, residual_matrix_.colptr(var2));
+
+    // The pending values were computed on exactly these updated columns
+    for (int var : {var1, var2}) {
+        const int partner = (var == var1) ? var2 : var1;
+        if (pending_partner_(var) == partner && pending_delta_(var) == delta) {
+            log_normalizer_(var) = pending_log_normalizer_(var);
+            log_normalizer_valid_(var) = 1;
+            if (pending_expected_valid_(var)) {
+                std::swap(expected_score_[var], pending_expected_score_[var]);
+            }
+            expected_score_valid_(var) = pending_expected_valid_(var);
+        } else {
+            log_normalizer_valid_(var) = 0;
+            expected_score_valid_(var) = 0;
+        }
+        pending_partner_(var) = -1;
+        pending_expected_valid_(var) = 0;
+    }
 }
 
 
@@ -231,8 +394,8 @@ size_t OMRFModel::parameter_dimension() const {
 }
 
 
-void OMRFModel::set_seed(int seed) {
-    rng_ = SafeRNG(seed);
+void OMRFModel::set_rng(const SafeRNG& rng) {
+    rng_ = rng;
 }
 
 
@@ -241,15 +404,79 @@ std::unique_ptr<BaseModel> OMRFModel::clone() const {
 }
 
 
+void OMRFModel::save_position(SamplerState& state) const {
+    state.add("main_effects", main_effects_);
+    state.add("pairwise_effects", pairwise_effects_);
+    state.add("edge_indicators", arma::conv_to<arma::mat>::from(edge_indicators_));
+    state.add("inclusion_probability", inclusion_probability_);
+}
+
+
+void OMRFModel::restore_position(const SamplerState& state) {
+    main_effects_ = state.block("main_effects", main_effects_.n_rows, main_effects_.n_cols);
+    set_edge_indicators(arma::conv_to<arma::imat>::from(
+        state.block("edge_indicators", p_, p_)));
+    set_pairwise_effects(state.block("pairwise_effects", p_, p_));
+    inclusion_probability_ = state.block("inclusion_probability", p_, p_);
+}
+
+
+void OMRFModel::save_state(SamplerState& state) const {
+    save_position(state);
+    state.add("proposal_sd_main", proposal_sd_main_);
+    state.add("proposal_sd_pairwise", proposal_sd_pairwise_);
+    if (delayed_acceptance_.enabled) {
+        state.add("surrogate_curvature", delayed_acceptance_.curvature());
+        state.add("delayed_acceptance", delayed_acceptance_.statistics());
+    }
+    if (block_main_.enabled) {
+        state.add("block_proposal_main", block_main_.state());
+    }
+    if (informed_edges_.enabled) {
+        state.add("informed_edge_rates", informed_edges_.flip_rates());
+    }
+    state.edge_selection_active = edge_selection_active_;
+}
+
+
+void OMRFModel::restore_state(const SamplerState& state) {
+    restore_position(state);
+    proposal_sd_main_ = state.block(
+        "proposal_sd_main", proposal_sd_main_.n_rows, proposal_sd_main_.n_cols);
+    proposal_sd_pairwise_ = state.block("proposal_sd_pairwise", p_, p_);
+    if (delayed_acceptance_.enabled && state.has_block("surrogate_curvature")) {
+        delayed_acceptance_.set_curvature(state.block("surrogate_curvature", p_, p_));
+    }
+    if (block_main_.enabled) {
+        // A state saved without blocks starts them from its proposal SDs
+        set_block_main_effects(true);
+        if (state.has_block("block_proposal_main")) {
+            block_main_.restore(state.block(
+                "block_proposal_main", p_, block_main_.state_columns()));
+        }
+    }
+    if (informed_edges_.enabled && state.has_block("informed_edge_rates")) {
+        informed_edges_.set_flip_rates(state.block("informed_edge_rates", num_pairwise_, 1));
+    }
+    edge_selection_active_ = state.edge_selection_active;
+}
+
+
 void OMRFModel::init_metropolis_adaptation(const WarmupSchedule& schedule) {
     metropolis_main_adapter_ = std::make_unique<MetropolisAdaptationController>(
         proposal_sd_main_, schedule, target_accept_);
     metropolis_pairwise_adapter_ = std::make_unique<MetropolisAdaptationController>(
         proposal_sd_pairwise_, schedule, target_accept_);
+    block_main_.set_warmup(schedule.total_warmup);
 }
 
 
 void OMRFModel::tune_proposal_sd(int iteration, const WarmupSchedule& schedule) {
+    // The surrogate curvature is learned until the last warmup iteration
+    delayed_acceptance_.adapting = !schedule.sampling(iteration + 1);
+    // So are the weights of the informed edge schedule
+    informed_edges_.adapting = informed_edges_.enabled && !schedule.sampling(iteration + 1);
+
     auto rm_weight_opt = schedule.rm_weight_for_proposal_sd(iteration);
     if (!rm_weight_opt) return;
     const double rm_weight = *rm_weight_opt;
@@ -274,9 +501,7 @@ void OMRFModel::tune_proposal_sd(int iteration, const WarmupSchedule& schedule)
             pairwise_effects_(variable2, variable1) = value;
 
             if (current != value) {
-                double delta = value - current;
-                residual_matrix_.col(variable1) += 2.0 * observations_double_.col(variable2) * delta;
-                residual_matrix_.col(variable2) += 2.0 * observations_double_.col(variable1) * delta;
+                update_residual_columns(variable1, variable2, value - current);
             }
 
             proposal_sd = update_proposal_sd_with_robbins_monro(
@@ -371,6 +596,16 @@ void OMRFModel::unvectorize_to_temps(
     arma::mat& temp_main,
     arma::mat& temp_pairwise,
     arma::mat& temp_residual
+) const {
+    unvectorize_to_temps(parameters, temp_main, temp_pairwise);
+    data_->observations.mul(temp_pairwise, 2.0, temp_residual, residual_panel_);
+}
+
+
+void OMRFModel::unvectorize_to_temps(
+    const arma::vec& parameters,
+    arma::mat& temp_main,
+    arma::mat& temp_pairwise
 ) const {
     int offset = 0;
     for (size_t v = 0; v < p_; ++v) {
@@ -393,8 +628,6 @@ void OMRFModel::unvectorize_to_temps(
             }
         }
     }
-
-    temp_residual = 2.0 * observations_double_ * temp_pairwise;
 }
 
 
@@ -449,6 +682,15 @@ arma::ivec OMRFModel::get_vectorized_indicator_parameters() {
 }
 
 
+void OMRFModel::pack_indicator_parameters(IndicatorBitWriter& out) {
+    for (size_t v1 = 0; v1 < p_ - 1; ++v1) {
+        for (size_t v2 = v1 + 1; v2 < p_; ++v2) {
+            out.push(edge_indicators_(v1, v2) != 0);
+        }
+    }
+}
+
+
 arma::vec OMRFModel::get_active_inv_mass() const {
     if (!edge_selection_active_) {
         return inv_mass_;
@@ -484,6 +726,31 @@ arma::vec OMRFModel::get_active_inv_mass() const {
 }
 
 
+arma::uvec OMRFModel::get_active_parameter_indices() const {
+    if (!edge_selection_active_) {
+        return BaseModel::get_active_parameter_indices();
+    }
+
+    std::vector<arma::uword> indices;
+    indices.reserve(num_main_ + num_pairwise_);
+    for (size_t i = 0; i < num_main_; ++i) {
+        indices.push_back(i);
+    }
+
+    arma::uword offset_full = num_main_;
+    for (size_t v1 = 0; v1 < p_ - 1; ++v1) {
+        for (size_t v2 = v1 + 1; v2 < p_; ++v2) {
+            if (edge_indicators_(v1, v2) == 1) {
+                indices.push_back(offset_full);
+            }
+            offset_full++;
+        }
+    }
+
+    return arma::uvec(indices);
+}
+
+
 void OMRFModel::vectorize_parameters_into(arma::vec& param_vec) const {
     // Count active parameters
     int num_active = 0;
@@ -575,91 +842,230 @@ void OMRFModel::get_active_inv_mass_into(arma::vec& active_inv_mass) const {
 
 double OMRFModel::log_pseudoposterior_main_component(int variable, int category, int parameter) const {
     double log_posterior = 0.0;
-
-    const int num_cats = num_categories_(variable);
-    arma::vec bound = num_cats * residual_matrix_.col(variable);
+    double log_prior;
 
     if (is_ordinal_variable_(variable)) {
         const double value = main_effects_(variable, category);
         log_posterior += value * counts_per_category_(category + 1, variable);
-        log_posterior += threshold_prior_->logp(value);
-
-        arma::vec residual_score = residual_matrix_.col(variable);
-        arma::vec main_effect_param = main_effects_.row(variable).cols(0, num_cats - 1).t();
-
-        arma::vec denom = compute_denom_ordinal(residual_score, main_effect_param, bound);
-        log_posterior -= arma::accu(bound + ARMA_MY_LOG(denom));
+        log_prior = threshold_prior_->logp(value);
     } else {
         const double value = main_effects_(variable, parameter);
-        const double linear_main_effect = main_effects_(variable, 0);
-        const double quadratic_main_effect = main_effects_(variable, 1);
-        const int ref = baseline_category_(variable);
-
         log_posterior += value * blume_capel_stats_(parameter, variable);
-        log_posterior += threshold_prior_->logp(value);
+        log_prior = threshold_prior_->logp(value);
+    }
+    log_posterior += log_prior;
 
-        arma::vec residual_score = residual_matrix_.col(variable);
-        arma::vec denom(n_, arma::fill::zeros);
+    log_posterior -= column_log_normalizer(variable);
 
-        denom = compute_denom_blume_capel(
-            residual_score, linear_main_effect, quadratic_main_effect, ref, num_cats, bound
-        );
+    return tempered(log_posterior, log_prior);
+}
 
-        log_posterior -= arma::accu(bound + ARMA_MY_LOG(denom));
-    }
 
-    return log_posterior;
+double OMRFModel::log_pseudolikelihood() const {
+    double log_pl = 0.0;
+    for (size_t variable = 0; variable < p_; ++variable) {
+        if (is_ordinal_variable_(variable)) {
+            for (int cat = 0; cat < num_categories_(variable); cat++) {
+                log_pl += main_effects_(variable, cat) * counts_per_category_(cat + 1, variable);
+            }
+        } else {
+            log_pl += main_effects_(variable, 0) * blume_capel_stats_(0, variable);
+            log_pl += main_effects_(variable, 1) * blume_capel_stats_(1, variable);
+        }
+        log_pl -= current_log_normalizer(variable);
+    }
+    for (size_t var1 = 0; var1 + 1 < p_; ++var1) {
+        for (size_t var2 = var1 + 1; var2 < p_; ++var2) {
+            if (edge_indicators_(var1, var2) == 0) continue;
+            log_pl += 4.0 * pairwise_effects_(var1, var2) * pairwise_stats_(var1, var2);
+        }
+    }
+    return log_pl;
 }
 
 
-double OMRFModel::compute_log_likelihood_ratio_for_variable(
-    int variable,
-    const arma::ivec& interacting_score,
-    double proposed_state,
-    double current_state
-) const {
-    // Convert interaction score vector to double precision
-    arma::vec interaction = arma::conv_to<arma::vec>::from(interacting_score);
-
-    const int num_persons = static_cast<int>(n_);
-    const int num_cats = num_categories_(variable);
+void OMRFModel::simulate_replicate(int num_states, int gibbs_iter, SafeRNG& rng, arma::mat& out) {
+    std::vector<std::string> variable_type(p_);
+    for (size_t v = 0; v < p_; ++v) {
+        variable_type[v] = is_ordinal_variable_(v) ? "ordinal" : "blume-capel";
+    }
+    out = arma::conv_to<arma::mat>::from(simulate_mrf(
+        num_states, static_cast<int>(p_), num_categories_, pairwise_effects_,
+        main_effects_, variable_type, baseline_category_, gibbs_iter, rng));
+}
 
-    // Compute adjusted linear predictors without the current interaction
-    arma::vec residual_score = residual_matrix_.col(variable) - 2.0 * interaction * current_state;
-    arma::vec bounds = residual_score * num_cats;
 
-    arma::vec denom_current = arma::zeros(num_persons);
-    arma::vec denom_proposed = arma::zeros(num_persons);
+double OMRFModel::log_normalizer_sum(int variable, const arma::vec& residual_score,
+                                     ScratchArena* arena) const {
+    ScratchArena& scratch = arena ? *arena : scratch_;
+    ScratchArena::Frame frame(scratch);
+    const int num_cats = num_categories_(variable);
+    arma::vec bound = scratch.vec(residual_score.n_elem);
+    bound = num_cats * residual_score;
+    arma::vec denom;
 
     if (is_ordinal_variable_(variable)) {
         arma::vec main_param = main_effects_.row(variable).cols(0, num_cats - 1).t();
-
-        denom_current += compute_denom_ordinal(
-            residual_score + 2.0 * interaction * current_state, main_param, bounds
+        denom = logz_kernels_[variable].ordinal_denom(residual_score, main_param, bound);
+    } else {
+        denom = logz_kernels_[variable].blume_capel_denom(
+            residual_score, main_effects_(variable, 0), main_effects_(variable, 1),
+            baseline_category_(variable), num_cats, bound
         );
-        denom_proposed += compute_denom_ordinal(
-            residual_score + 2.0 * interaction * proposed_state, main_param, bounds
+    }
+
+    if (pattern_compressed_) {
+        return arma::dot(data_->pattern_weights, bound + ARMA_MY_LOG(denom));
+    }
+    return arma::accu(bound + ARMA_MY_LOG(denom));
+}
+
+
+arma::vec OMRFModel::log_normalizer_terms(int variable, const arma::vec& residual_score,
+                                          const arma::mat& main_effects) const {
+    const int num_cats = num_categories_(variable);
+    arma::vec bound = num_cats * residual_score;
+    arma::vec denom;
+
+    if (is_ordinal_variable_(variable)) {
+        arma::vec main_param = main_effects.row(variable).cols(0, num_cats - 1).t();
+        denom = logz_kernels_[variable].ordinal_denom(residual_score, main_param, bound);
+    } else {
+        denom = logz_kernels_[variable].blume_capel_denom(
+            residual_score, main_effects(variable, 0), main_effects(variable, 1),
+            baseline_category_(variable), num_cats, bound
         );
+    }
+    return bound + ARMA_MY_LOG(denom);
+}
+
+
+double OMRFModel::column_log_normalizer(int variable, ScratchArena* arena) const {
+    if (!batch_rows_.is_empty()) {
+        return subsampled_log_normalizer(variable, batch_residual(variable));
+    }
+    // A view of the column, where residual_matrix_.col() would copy it
+    const arma::vec residual_score(
+        const_cast<double*>(residual_matrix_.colptr(variable)), residual_matrix_.n_rows, false, true);
+    return log_normalizer_sum(variable, residual_score, arena);
+}
+
+
+double OMRFModel::subsampled_log_normalizer(int variable, const arma::vec& batch_residual) const {
+    const arma::vec terms = log_normalizer_terms(variable, batch_residual, main_effects_);
+    const double scale = static_cast<double>(n_) / static_cast<double>(batch_rows_.n_elem);
+    return reference_log_z_(variable) +
+           scale * (arma::accu(terms) - batch_reference_log_z_sum_(variable));
+}
+
+
+arma::vec OMRFModel::batch_residual(int variable) const {
+    const arma::uword m = batch_rows_.n_elem;
+    const double* column = residual_matrix_.colptr(variable);
+    arma::vec out(m);
+    for (arma::uword k = 0; k < m; ++k) {
+        out(k) = column[batch_rows_(k)];
+    }
+    return out;
+}
+
+
+double OMRFModel::current_log_normalizer(int variable, ScratchArena* arena) const {
+    if (!log_normalizer_valid_(variable)) {
+        log_normalizer_(variable) = column_log_normalizer(variable, arena);
+        log_normalizer_valid_(variable) = 1;
+    }
+    return log_normalizer_(variable);
+}
+
+
+double OMRFModel::proposed_log_normalizer(int variable, int partner, double delta,
+                                          ScratchArena* arena) const {
+    // Same expression as update_residual_columns, so an accepted pending
+    // value equals a fresh evaluation on the updated column.
+    double value;
+    if (!batch_rows_.is_empty()) {
+        arma::vec residual_score = batch_residual(variable);
+        residual_score += (2.0 * delta) * batch_observations_.col(partner);
+        value = subsampled_log_normalizer(variable, residual_score);
     } else {
-        const int ref_cat = baseline_category_(variable);
+        ScratchArena& scratch = arena ? *arena : scratch_;
+        ScratchArena::Frame frame(scratch);
+        arma::vec residual_score = scratch.vec(residual_matrix_.n_rows);
+        residual_score = residual_matrix_.col(variable);
+        data_->observations.add_scaled(partner, 2.0 * delta, residual_score.memptr());
+        value = log_normalizer_sum(variable, residual_score, &scratch);
+    }
+
+    pending_partner_(variable) = partner;
+    pending_delta_(variable) = delta;
+    pending_log_normalizer_(variable) = value;
+    pending_expected_valid_(variable) = 0;
+    return value;
+}
 
-        denom_current = compute_denom_blume_capel(
-            residual_score + 2.0 * interaction * current_state, main_effects_(variable, 0),
-            main_effects_(variable, 1), ref_cat, num_cats, bounds
-        );
-        double log_ratio = arma::accu(ARMA_MY_LOG(denom_current) + bounds);
 
-        denom_proposed = compute_denom_blume_capel(
-            residual_score + 2.0 * interaction * proposed_state, main_effects_(variable, 0),
-            main_effects_(variable, 1), ref_cat, num_cats, bounds
+const arma::vec& OMRFModel::current_expected_score(int variable) const {
+    if (!expected_score_valid_(variable)) {
+        const arma::vec* weights = pattern_compressed_ ? &data_->pattern_weights : nullptr;
+        LogZWorkspace& workspace = logz_workspaces_[0];
+        compute_variable_moments(
+            variable, main_effects_, residual_matrix_.col(variable), workspace, weights
         );
-        log_ratio -= arma::accu(ARMA_MY_LOG(denom_proposed) + bounds);
+        if (!log_normalizer_valid_(variable)) {
+            log_normalizer_(variable) = workspace.moments.log_Z_sum;
+            log_normalizer_valid_(variable) = 1;
+        }
+        std::swap(expected_score_[variable], workspace.moments.E);
+        expected_score_valid_(variable) = 1;
+    }
+    return expected_score_[variable];
+}
+
+
+double OMRFModel::proposed_log_normalizer_and_score(int variable, int partner, double delta) const {
+    arma::vec residual_score = residual_matrix_.col(variable);
+    data_->observations.add_scaled(partner, 2.0 * delta, residual_score.memptr());
+
+    const arma::vec* weights = pattern_compressed_ ? &data_->pattern_weights : nullptr;
+    LogZWorkspace& workspace = logz_workspaces_[0];
+    compute_variable_moments(variable, main_effects_, residual_score, workspace, weights);
+    std::swap(pending_expected_score_[variable], workspace.moments.E);
+
+    pending_partner_(variable) = partner;
+    pending_delta_(variable) = delta;
+    pending_log_normalizer_(variable) = workspace.moments.log_Z_sum;
+    pending_expected_valid_(variable) = 1;
+    return workspace.moments.log_Z_sum;
+}
+
+
+double OMRFModel::pairwise_log_likelihood_gradient(int var1, int var2, const arma::vec& score1,
+                                                   const arma::vec& score2) const {
+    return 4.0 * pairwise_stats_(var1, var2)
+         - 2.0 * data_->observations.dot(var2, score1)
+         - 2.0 * data_->observations.dot(var1, score2);
+}
+
 
-        return log_ratio;
+arma::vec OMRFModel::get_log_normalizers() const {
+    arma::vec out(p_);
+    for (size_t v = 0; v < p_; ++v) {
+        out(v) = current_log_normalizer(v);
     }
+    return out;
+}
 
+
+double OMRFModel::compute_log_likelihood_ratio_for_variable(
+    int variable,
+    int partner,
+    double delta,
+    ScratchArena* arena
+) const {
     // Accumulated log-likelihood difference across persons
-    return arma::accu(ARMA_MY_LOG(denom_current) - ARMA_MY_LOG(denom_proposed));
+    return current_log_normalizer(variable, arena) -
+           proposed_log_normalizer(variable, partner, delta, arena);
 }
 
 
@@ -667,64 +1073,43 @@ double OMRFModel::log_pseudolikelihood_ratio_interaction(
     int variable1,
     int variable2,
     double proposed_state,
-    double current_state
+    double current_state,
+    ScratchArena* arena
 ) const {
     double log_ratio = 0.0;
     const double delta = proposed_state - current_state;
 
-    arma::ivec score1 = observations_.col(variable1);
-    arma::ivec score2 = observations_.col(variable2);
-
     log_ratio += 4.0 * pairwise_stats_(variable1, variable2) * delta;
 
-    log_ratio += compute_log_likelihood_ratio_for_variable(
-        variable1, score2, proposed_state, current_state
-    );
-
-    log_ratio += compute_log_likelihood_ratio_for_variable(
-        variable2, score1, proposed_state, current_state
-    );
+    log_ratio += compute_log_likelihood_ratio_for_variable(variable1, variable2, delta, arena);
+    log_ratio += compute_log_likelihood_ratio_for_variable(variable2, variable1, delta, arena);
 
     return log_ratio;
 }
 
 
 double OMRFModel::log_pseudoposterior_pairwise_at_delta(int var1, int var2, double delta) const {
-    const int num_observations = static_cast<int>(n_);
     const double proposed_value = pairwise_effects_(var1, var2) + delta;
 
     double log_pseudo_posterior = 4.0 * proposed_value * pairwise_stats_(var1, var2);
 
-    const arma::vec& obs_var1 = observations_double_.col(var1);
-    const arma::vec& obs_var2 = observations_double_.col(var2);
-
-    for (int var : {var1, var2}) {
-        int num_cats = num_categories_(var);
-        const arma::vec& obs_other = (var == var1) ? obs_var2 : obs_var1;
-
-        arma::vec residual_score = residual_matrix_.col(var) + 2.0 * obs_other * delta;
-        arma::vec denominator = arma::zeros(num_observations);
-        arma::vec bound = num_cats * residual_score;
-
-        if (is_ordinal_variable_(var)) {
-            arma::vec main_effect_param = main_effects_.row(var).cols(0, num_cats - 1).t();
-            denominator += compute_denom_ordinal(residual_score, main_effect_param, bound);
-        } else {
-            const int ref = baseline_category_(var);
-            denominator = compute_denom_blume_capel(
-                residual_score, main_effects_(var, 0), main_effects_(var, 1), ref, num_cats, bound
-            );
-        }
-
-        log_pseudo_posterior -= arma::accu(ARMA_MY_LOG(denominator));
-        log_pseudo_posterior -= arma::accu(bound);
+    // delta == 0 is the current state (metropolis_step evaluates it after
+    // the proposal), so only the proposed side is computed from scratch.
+    if (delta == 0.0) {
+        log_pseudo_posterior -= current_log_normalizer(var1);
+        log_pseudo_posterior -= current_log_normalizer(var2);
+    } else {
+        log_pseudo_posterior -= proposed_log_normalizer(var1, var2, delta);
+        log_pseudo_posterior -= proposed_log_normalizer(var2, var1, delta);
     }
 
+    double log_prior = 0.0;
     if (edge_indicators_(var1, var2) == 1) {
-        log_pseudo_posterior += interaction_prior_->logp(proposed_value, pairwise_scaling_factors_(var1, var2));
+        log_prior = interaction_prior_->logp(proposed_value, pairwise_scaling_factors_(var1, var2));
+        log_pseudo_posterior += log_prior;
     }
 
-    return log_pseudo_posterior;
+    return tempered(log_pseudo_posterior, log_prior);
 }
 
 
@@ -751,6 +1136,17 @@ void OMRFModel::ensure_gradient_cache() {
         }
     }
 
+    // Prior scale factors of the active pairwise effects, in gradient order
+    active_scaling_factors_.set_size(num_active);
+    for (int i = 0; i < num_variables - 1; i++) {
+        for (int j = i + 1; j < num_variables; j++) {
+            if (edge_indicators_(i, j) == 1) {
+                active_scaling_factors_(index_matrix_cache_(i, j) - num_main) =
+                    pairwise_scaling_factors_(i, j);
+            }
+        }
+    }
+
     // Allocate gradient vector (main + active pairwise only)
     grad_obs_cache_.set_size(num_main + num_active);
     grad_obs_cache_.zeros();
@@ -783,144 +1179,331 @@ void OMRFModel::ensure_gradient_cache() {
     gradient_cache_valid_ = true;
 }
 
-std::pair<double, arma::vec> OMRFModel::logp_and_gradient(const arma::vec& parameters) {
-    ensure_gradient_cache();
-
-    arma::mat temp_main(main_effects_.n_rows, main_effects_.n_cols, arma::fill::none);
-    arma::mat temp_pairwise(p_, p_, arma::fill::zeros);
-    arma::mat temp_residual;
-    unvectorize_to_temps(parameters, temp_main, temp_pairwise, temp_residual);
-
-    const int num_variables = static_cast<int>(p_);
-
-    double log_pp = 0.0;
-    arma::vec gradient = grad_obs_cache_;
+void OMRFModel::set_gradient_threads(int num_threads) {
+    gradient_threads_ = std::max(1, num_threads);
+    logz_workspaces_.resize(gradient_threads_);
+    matching_arenas_.resize(gradient_threads_);
+}
 
-    // ---- Main effects: priors + sufficient statistics ----
-    for (int variable = 0; variable < num_variables; variable++) {
-        if (is_ordinal_variable_(variable)) {
-            const int num_cats = num_categories_(variable);
-            for (int cat = 0; cat < num_cats; cat++) {
-                double value = temp_main(variable, cat);
-                log_pp += counts_per_category_(cat + 1, variable) * value;
-                log_pp += threshold_prior_->logp(value);
-            }
-        } else {
-            double value = temp_main(variable, 0);
-            log_pp += threshold_prior_->logp(value);
-            log_pp += blume_capel_stats_(0, variable) * value;
+void OMRFModel::compute_variable_moments(
+    int variable,
+    const arma::mat& main_effects,
+    const arma::vec& residual_score,
+    LogZWorkspace& workspace,
+    const arma::vec* weights
+) const {
+    const int num_cats = num_categories_(variable);
 
-            value = temp_main(variable, 1);
-            log_pp += threshold_prior_->logp(value);
-            log_pp += blume_capel_stats_(1, variable) * value;
-        }
+    // Person-tiled: only the reductions and E leave the kernel, using
+    // persistent per-block scratch (no per-call heap allocations).
+    if (is_ordinal_variable_(variable)) {
+        arma::vec main_param = main_effects.row(variable).cols(0, num_cats - 1).t();
+        arma::vec bound = num_cats * residual_score;
+        logz_kernels_[variable].ordinal_moments(
+            main_param, residual_score, bound, num_cats,
+            workspace.moments, workspace.scratch, weights
+        );
+    } else {
+        logz_kernels_[variable].blume_capel_moments(
+            residual_score, main_effects(variable, 0), main_effects(variable, 1),
+            baseline_category_(variable), num_cats,
+            workspace.moments, workspace.scratch, weights
+        );
     }
+}
 
-    // ---- Pairwise effects: priors + sufficient statistics ----
-    for (int var1 = 0; var1 < num_variables - 1; var1++) {
-        for (int var2 = var1 + 1; var2 < num_variables; var2++) {
-            if (edge_indicators_(var1, var2) == 0) continue;
 
-            double value = temp_pairwise(var1, var2);
-            log_pp += 4.0 * pairwise_stats_(var1, var2) * value;
-            log_pp += interaction_prior_->logp(value, pairwise_scaling_factors_(var1, var2));
-        }
+void OMRFModel::accumulate_variable_gradient(
+    int variable,
+    const arma::mat& temp_main,
+    const arma::mat& temp_residual,
+    LogZWorkspace& workspace,
+    arma::vec& gradient,
+    double* expected
+) {
+    const int num_cats = num_categories_(variable);
+    const arma::vec residual_score(
+        const_cast<double*>(temp_residual.colptr(variable)), temp_residual.n_rows, false, true);
+    LogZMoments& moments = workspace.moments;
+    // With compressed patterns E comes back weighted, so X^T E below is
+    // still the full-data sum
+    const arma::vec* weights = pattern_compressed_ ? &data_->pattern_weights : nullptr;
+
+    compute_variable_moments(variable, temp_main, residual_score, workspace, weights);
+
+    // Subsampled: temp_residual holds the batch rows, and the moments
+    // become control-variate estimates of the full-data sums
+    const bool subsampled = !batch_rows_.is_empty();
+    if (subsampled) {
+        const double scale = static_cast<double>(n_) / static_cast<double>(batch_rows_.n_elem);
+        moments.log_Z_sum = reference_log_z_(variable) +
+            scale * (moments.log_Z_sum - batch_reference_log_z_sum_(variable));
+        moments.prob_sums = reference_prob_sums_.col(variable).head(num_cats + 1) +
+            scale * (moments.prob_sums - batch_reference_prob_sums_.col(variable).head(num_cats + 1));
+        const arma::vec cross = batch_observations_.t() * moments.E;
+        pairwise_grad_buffer_.col(variable) = reference_cross_.col(variable) +
+            scale * (cross - batch_reference_cross_.col(variable));
     }
 
-    // ---- Per-variable: joint computation of log-normalizer and gradient ----
-    int offset = 0;
-    for (int variable = 0; variable < num_variables; variable++) {
-        const int num_cats = num_categories_(variable);
-        arma::vec residual_score = temp_residual.col(variable);
-        arma::vec bound = num_cats * residual_score;
-
-        if (is_ordinal_variable_(variable)) {
-            arma::vec main_param = temp_main.row(variable).cols(0, num_cats - 1).t();
-
-            // Fill-in-place: persistent per-chain scratch reused across variables
-            // and iterations, eliminating per-call heap allocations.
-            compute_logZ_and_probs_ordinal_into(
-                main_param, residual_score, bound, num_cats,
-                logz_out_, logz_scratch_
-            );
-
-            // Use log_Z for log-pseudoposterior
-            log_pp -= arma::accu(logz_out_.log_Z);
-
-            // Use probs for gradient
-            for (int cat = 0; cat < num_cats; cat++) {
-                gradient(offset + cat) -= arma::accu(logz_out_.probs.col(cat + 1));
-            }
-
-            // Pairwise gradient contributions (vectorized using BLAS)
-            arma::vec weights = arma::regspace<arma::vec>(1, num_cats);
-            arma::vec E = logz_out_.probs.cols(1, num_cats) * weights;
-            arma::vec pw_grad = observations_double_t_ * E;
-            for (int j = 0; j < num_variables; j++) {
-                if (edge_indicators_(variable, j) == 0 || variable == j) continue;
-                int location = (variable < j) ? index_matrix_cache_(variable, j) : index_matrix_cache_(j, variable);
-                gradient(location) -= 2.0 * pw_grad(j);
-            }
-            offset += num_cats;
-        } else {
-            const int ref = baseline_category_(variable);
-            const double lin_eff = temp_main(variable, 0);
-            const double quad_eff = temp_main(variable, 1);
-
-            // Fill-in-place Blume-Capel
-            compute_logZ_and_probs_blume_capel_into(
-                residual_score, lin_eff, quad_eff, ref, num_cats, bound,
-                logz_out_, logz_scratch_
-            );
+    // Use log_Z for log-pseudoposterior
+    logz_sum_buffer_(variable) = moments.log_Z_sum;
 
-            // Use log_Z for log-pseudoposterior
-            log_pp -= arma::accu(logz_out_.log_Z);
+    // Use probs for gradient
+    subtract_expected_main_statistics(variable, moments.prob_sums, gradient);
 
-            // Use probs for gradient
-            arma::vec score = arma::regspace<arma::vec>(0, num_cats) - static_cast<double>(ref);
-            arma::vec sq_score = arma::square(score);
+    if (subsampled) return;
 
-            gradient(offset)     -= arma::accu(logz_out_.probs * score);
-            gradient(offset + 1) -= arma::accu(logz_out_.probs * sq_score);
+    // Batched chains keep E; the caller forms X^T E for all of them at once
+    if (expected) {
+        std::copy(moments.E.begin(), moments.E.end(), expected);
+        return;
+    }
 
-            // Pairwise gradient contributions (vectorized using BLAS)
-            arma::vec E = logz_out_.probs * score;
-            arma::vec pw_grad = observations_double_t_ * E;
-            for (int j = 0; j < num_variables; j++) {
-                if (edge_indicators_(variable, j) == 0 || variable == j) continue;
-                int location = (variable < j) ? index_matrix_cache_(variable, j) : index_matrix_cache_(j, variable);
-                gradient(location) -= 2.0 * pw_grad(j);
-            }
-            offset += 2;
+    // Pairwise gradient contributions: one dot product per included
+    // neighbour on sparse graphs, otherwise the full product via BLAS
+    if (use_sparse_gradient_) {
+        for (int j : active_neighbours_[variable]) {
+            pairwise_grad_buffer_(j, variable) = data_->observations.dot(j, moments.E);
         }
+    } else {
+        data_->observations.tmul(moments.E, pairwise_grad_buffer_.colptr(variable));
     }
+}
 
-    // ---- Priors: gradient contributions ----
-    offset = 0;
+void OMRFModel::subtract_expected_main_statistics(
+    int variable,
+    const arma::vec& prob_sums,
+    arma::vec& gradient
+) const {
+    const int num_cats = num_categories_(variable);
+    const int offset = main_offsets_[variable];
+    if (is_ordinal_variable_(variable)) {
+        for (int cat = 0; cat < num_cats; cat++) {
+            gradient(offset + cat) -= prob_sums(cat + 1);
+        }
+    } else {
+        const int ref = baseline_category_(variable);
+        arma::vec score = arma::regspace<arma::vec>(0, num_cats) - static_cast<double>(ref);
+
+        gradient(offset)     -= arma::dot(prob_sums, score);
+        gradient(offset + 1) -= arma::dot(prob_sums, arma::square(score));
+    }
+}
+
+std::pair<double, arma::vec> OMRFModel::logp_and_gradient(const arma::vec& parameters) {
+    BGMS_PROFILE_SCOPE(Gradient);
+    ensure_gradient_cache();
+
+    // The unpacked parameters and the residual scores live for this call
+    // only: they come from the chain's arena
+    const bool subsampled = !batch_rows_.is_empty();
+    const bool on_device = gpu_backend_ != nullptr;
+    ScratchArena::Frame frame(scratch_);
+    arma::mat temp_main = scratch_.mat(main_effects_.n_rows, main_effects_.n_cols);
+    arma::mat temp_pairwise = scratch_.mat(p_, p_);
+    temp_pairwise.zeros();
+    arma::mat temp_residual = (subsampled || on_device)
+        ? arma::mat()
+        : scratch_.mat(data_->observations.n_rows(), p_);
+    if (subsampled) {
+        // Residual scores of the batch rows only
+        unvectorize_to_temps(parameters, temp_main, temp_pairwise);
+        temp_residual = 2.0 * batch_observations_ * temp_pairwise;
+    } else if (on_device) {
+        // The device computes the residual scores itself
+        unvectorize_to_temps(parameters, temp_main, temp_pairwise);
+    } else {
+        unvectorize_to_temps(parameters, temp_main, temp_pairwise, temp_residual);
+    }
+
+    const int num_variables = static_cast<int>(p_);
+
+    GradientTerms terms = gradient_terms(parameters, temp_main, temp_pairwise);
+    arma::vec& gradient = terms.gradient;
+
+    // ---- Per-variable: joint computation of log-normalizer and gradient ----
+    // Each block of variables fills its own slots of logz_sum_buffer_ and
+    // pairwise_grad_buffer_; the reductions below run over the slots in a
+    // fixed order, so the result does not depend on the number of blocks.
+    logz_sum_buffer_.set_size(p_);
+    pairwise_grad_buffer_.set_size(p_, p_);
+    use_sparse_gradient_ = num_pairwise_ > 0 &&
+        static_cast<double>(num_active_edges_) <=
+            sparse_gradient_max_density_ * static_cast<double>(num_pairwise_);
+    const bool fill_batch_reference = subsampled && !batch_reference_moments_valid_;
+    if (on_device) {
+        gpu_prob_sums_.set_size(num_categories_.max() + 1, p_);
+        gpu_backend_->evaluate(
+            temp_main.memptr(), static_cast<int>(temp_main.n_cols), temp_pairwise.memptr(),
+            logz_sum_buffer_.memptr(), gpu_prob_sums_.memptr(), pairwise_grad_buffer_.memptr()
+        );
+        for (int variable = 0; variable < num_variables; variable++) {
+            subtract_expected_main_statistics(
+                variable, gpu_prob_sums_.col(variable).head(num_categories_(variable) + 1), gradient
+            );
+        }
+    } else {
+        const int num_blocks = std::min(gradient_threads_, num_variables);
+        parallel_for_blocks(num_blocks, [&](int block) {
+            int begin, end;
+            block_range(num_variables, num_blocks, block, begin, end);
+            for (int variable = begin; variable < end; variable++) {
+                if (fill_batch_reference) {
+                    compute_batch_reference_moments(variable, logz_workspaces_[block]);
+                }
+                accumulate_variable_gradient(
+                    variable, temp_main, temp_residual, logz_workspaces_[block], gradient
+                );
+            }
+        });
+    }
+    if (fill_batch_reference) batch_reference_moments_valid_ = true;
+
+    return finish_gradient(terms);
+}
+
+
+OMRFModel::GradientTerms OMRFModel::gradient_terms(
+    const arma::vec& parameters,
+    const arma::mat& temp_main,
+    const arma::mat& temp_pairwise
+) const {
+    const int num_variables = static_cast<int>(p_);
+    GradientTerms terms;
+    terms.gradient = grad_obs_cache_;
+
+    // ---- Priors: one batched call each ----
+    // The parameter vector holds the main effects first, then the active
+    // pairwise effects in the order of index_matrix_cache_.
+    terms.num_active = parameters.n_elem - num_main_;
+    terms.log_prior = threshold_prior_->logp_and_grad(
+        parameters.head(num_main_), arma::vec(), terms.main_prior_grad);
+    if (terms.num_active > 0) {
+        terms.log_prior += interaction_prior_->logp_and_grad(
+            parameters.tail(terms.num_active), active_scaling_factors_, terms.pairwise_prior_grad);
+    }
+    double log_pp = terms.log_prior;
+
+    // ---- Main effects: sufficient statistics ----
     for (int variable = 0; variable < num_variables; variable++) {
         if (is_ordinal_variable_(variable)) {
             const int num_cats = num_categories_(variable);
             for (int cat = 0; cat < num_cats; cat++) {
-                gradient(offset + cat) += threshold_prior_->grad(temp_main(variable, cat));
+                log_pp += counts_per_category_(cat + 1, variable) * temp_main(variable, cat);
             }
-            offset += num_cats;
         } else {
-            for (int k = 0; k < 2; k++) {
-                gradient(offset + k) += threshold_prior_->grad(temp_main(variable, k));
-            }
-            offset += 2;
+            log_pp += blume_capel_stats_(0, variable) * temp_main(variable, 0);
+            log_pp += blume_capel_stats_(1, variable) * temp_main(variable, 1);
         }
     }
-    for (int i = 0; i < num_variables - 1; i++) {
-        for (int j = i + 1; j < num_variables; j++) {
-            if (edge_indicators_(i, j) == 0) continue;
-            int location = index_matrix_cache_(i, j);
-            const double effect = temp_pairwise(i, j);
-            gradient(location) += interaction_prior_->grad(effect, pairwise_scaling_factors_(i, j));
+
+    // ---- Pairwise effects: sufficient statistics ----
+    for (int var1 = 0; var1 < num_variables - 1; var1++) {
+        for (int var2 = var1 + 1; var2 < num_variables; var2++) {
+            if (edge_indicators_(var1, var2) == 0) continue;
+            log_pp += 4.0 * pairwise_stats_(var1, var2) * temp_pairwise(var1, var2);
+        }
+    }
+
+    terms.log_pp = log_pp;
+    return terms;
+}
+
+
+std::pair<double, arma::vec> OMRFModel::finish_gradient(GradientTerms& terms) const {
+    const int num_variables = static_cast<int>(p_);
+    arma::vec& gradient = terms.gradient;
+
+    double log_pp = terms.log_pp - tree_sum(logz_sum_buffer_.memptr(), p_);
+    for (int variable = 0; variable < num_variables; variable++) {
+        for (int j : active_neighbours_[variable]) {
+            int location = (variable < j) ? index_matrix_cache_(variable, j) : index_matrix_cache_(j, variable);
+            gradient(location) -= 2.0 * pairwise_grad_buffer_(j, variable);
+        }
+    }
+
+    // ---- Tempering: so far the gradient is the pseudolikelihood's ----
+    log_pp = tempered(log_pp, terms.log_prior);
+    if (inverse_temperature_ != 1.0) gradient *= inverse_temperature_;
+
+    // ---- Priors: gradient contributions ----
+    gradient.head(num_main_) += terms.main_prior_grad;
+    if (terms.num_active > 0) gradient.tail(terms.num_active) += terms.pairwise_prior_grad;
+
+    return {log_pp, std::move(gradient)};
+}
+
+
+void OMRFModel::logp_and_gradient_batch(
+    const std::vector<BaseModel*>& models,
+    const std::vector<arma::vec>& parameters,
+    std::vector<std::pair<double, arma::vec>>& results
+) {
+    // The shared products need every chain on these observations, on the
+    // host and over all rows
+    std::vector<OMRFModel*> chains;
+    chains.reserve(models.size());
+    for (BaseModel* model : models) {
+        auto* chain = dynamic_cast<OMRFModel*>(model);
+        if (!chain || &*chain->data_ != &*data_ || chain->gpu_backend_ ||
+            !chain->batch_rows_.is_empty()) {
+            BaseModel::logp_and_gradient_batch(models, parameters, results);
+            return;
         }
+        chains.push_back(chain);
     }
+    BGMS_PROFILE_SCOPE(Gradient);
 
-    return {log_pp, gradient};
+    const arma::uword num_chains = chains.size();
+    const arma::uword n = data_->observations.n_rows();
+    const int num_variables = static_cast<int>(p_);
+    results.resize(num_chains);
+
+    // Residual scores of every chain from one product X [P_1 ... P_B]
+    std::vector<arma::mat> temp_main(num_chains);
+    lockstep_pairwise_.zeros(p_, p_ * num_chains);
+    for (arma::uword k = 0; k < num_chains; ++k) {
+        OMRFModel& chain = *chains[k];
+        chain.ensure_gradient_cache();
+        temp_main[k].zeros(chain.main_effects_.n_rows, chain.main_effects_.n_cols);
+        arma::mat temp_pairwise(lockstep_pairwise_.colptr(k * p_), p_, p_, false, true);
+        chain.unvectorize_to_temps(parameters[k], temp_main[k], temp_pairwise);
+    }
+    data_->observations.mul(lockstep_pairwise_, 2.0, lockstep_residual_, residual_panel_);
+
+    // Per-variable moments of every chain, as in logp_and_gradient(), each
+    // keeping its expected scores for the shared product
+    std::vector<GradientTerms> terms(num_chains);
+    lockstep_expected_.set_size(n, p_ * num_chains);
+    for (arma::uword k = 0; k < num_chains; ++k) {
+        OMRFModel& chain = *chains[k];
+        const arma::mat temp_pairwise(lockstep_pairwise_.colptr(k * p_), p_, p_, false, true);
+        const arma::mat temp_residual(lockstep_residual_.colptr(k * p_), n, p_, false, true);
+        double* expected = lockstep_expected_.colptr(k * p_);
+        terms[k] = chain.gradient_terms(parameters[k], temp_main[k], temp_pairwise);
+        arma::vec& gradient = terms[k].gradient;
+
+        chain.logz_sum_buffer_.set_size(p_);
+        const int num_blocks = std::min(chain.gradient_threads_, num_variables);
+        parallel_for_blocks(num_blocks, [&](int block) {
+            int begin, end;
+            block_range(num_variables, num_blocks, block, begin, end);
+            for (int variable = begin; variable < end; variable++) {
+                chain.accumulate_variable_gradient(
+                    variable, temp_main[k], temp_residual, chain.logz_workspaces_[block],
+                    gradient, expected + variable * n
+                );
+            }
+        });
+    }
+
+    // Pairwise gradients of every chain from one product X^T [E_1 ... E_B]
+    data_->observations.tmul(lockstep_expected_, lockstep_cross_, lockstep_panel_);
+    for (arma::uword k = 0; k < num_chains; ++k) {
+        OMRFModel& chain = *chains[k];
+        chain.pairwise_grad_buffer_ = lockstep_cross_.cols(k * p_, (k + 1) * p_ - 1);
+        results[k] = chain.finish_gradient(terms[k]);
+    }
 }
 
 
@@ -944,16 +1527,74 @@ double OMRFModel::update_main_effect_parameter(int variable, int category, int p
 
     StepResult result = metropolis_step(current, proposal_sd, log_post, rng_);
     current = result.state[0];
+    log_normalizer_valid_(variable) = 0;
+    expected_score_valid_(variable) = 0;
     return result.accept_prob;
 }
 
 
+double OMRFModel::update_main_effect_block(int variable, int iteration) {
+    const bool ordinal = is_ordinal_variable_(variable);
+    const int size = ordinal ? num_categories_(variable) : 2;
+    const arma::span block(0, size - 1);
+    const arma::vec current = main_effects_(variable, block).t();
+    const arma::vec proposed = block_main_.propose(variable, current, rng_);
+
+    // Linear terms and priors of the block; the log-normalizer is the only
+    // O(n) part, and that of the current state is cached
+    auto log_post = [&](const arma::vec& theta, double log_normalizer) {
+        double log_prior = 0.0;
+        double log_posterior = -log_normalizer;
+        for (int k = 0; k < size; ++k) {
+            const double statistic = ordinal
+                ? counts_per_category_(k + 1, variable)
+                : blume_capel_stats_(k, variable);
+            log_posterior += theta(k) * statistic;
+            log_prior += threshold_prior_->logp(theta(k));
+        }
+        return tempered(log_posterior + log_prior, log_prior);
+    };
+
+    const double current_log_normalizer_value = current_log_normalizer(variable);
+    main_effects_(variable, block) = proposed.t();
+    const double proposed_log_normalizer_value = column_log_normalizer(variable);
+    const double log_ratio = log_post(proposed, proposed_log_normalizer_value) -
+                             log_post(current, current_log_normalizer_value);
+
+    if (MY_LOG(runif(rng_)) < log_ratio) {
+        log_normalizer_(variable) = proposed_log_normalizer_value;
+        log_normalizer_valid_(variable) = 1;
+        expected_score_valid_(variable) = 0;
+    } else {
+        main_effects_(variable, block) = current.t();
+    }
+    const double accept_prob = log_ratio < 0.0 ? MY_EXP(log_ratio) : 1.0;
+    block_main_.adapt(variable, main_effects_(variable, block).t(), accept_prob, iteration);
+    return accept_prob;
+}
+
+
 double OMRFModel::update_pairwise_effect(int var1, int var2) {
     if (edge_indicators_(var1, var2) == 0) return 1.0;
 
     double current_value = pairwise_effects_(var1, var2);
     double proposal_sd = proposal_sd_pairwise_(var1, var2);
 
+    if (uses_delayed_acceptance()) {
+        const double proposed = rnorm(rng_, current_value, proposal_sd);
+        const double delta = proposed - current_value;
+        const double sf = pairwise_scaling_factors_(var1, var2);
+        const double log_prior_ratio = interaction_prior_->logp(proposed, sf) -
+                                       interaction_prior_->logp(current_value, sf);
+        double accept_prob;
+        if (delayed_acceptance_test(var1, var2, delta, log_prior_ratio, accept_prob)) {
+            pairwise_effects_(var1, var2) = proposed;
+            pairwise_effects_(var2, var1) = proposed;
+            update_residual_columns(var1, var2, delta);
+        }
+        return accept_prob;
+    }
+
     auto log_post = [&](double theta) {
         double delta = theta - current_value;
         return log_pseudoposterior_pairwise_at_delta(var1, var2, delta);
@@ -966,16 +1607,14 @@ double OMRFModel::update_pairwise_effect(int var1, int var2) {
     pairwise_effects_(var2, var1) = value;
 
     if (current_value != value) {
-        double delta = value - current_value;
-        residual_matrix_.col(var1) += 2.0 * observations_double_.col(var2) * delta;
-        residual_matrix_.col(var2) += 2.0 * observations_double_.col(var1) * delta;
+        update_residual_columns(var1, var2, value - current_value);
     }
 
     return result.accept_prob;
 }
 
 
-void OMRFModel::update_edge_indicator(int var1, int var2) {
+double OMRFModel::update_edge_indicator(int var1, int var2) {
     const double current_state = pairwise_effects_(var1, var2);
 
     const bool proposing_addition = (edge_indicators_(var1, var2) == 0);
@@ -983,9 +1622,43 @@ void OMRFModel::update_edge_indicator(int var1, int var2) {
         ? rnorm(rng_, current_state, proposal_sd_pairwise_(var1, var2))
         : 0.0;
 
+    bool accept;
+    double accept_prob;
+    if (uses_delayed_acceptance()) {
+        accept = delayed_acceptance_test(
+            var1, var2, proposed_state - current_state,
+            edge_indicator_log_prior_ratio(var1, var2, proposed_state), accept_prob);
+    } else {
+        const double log_accept = edge_indicator_log_accept(var1, var2, proposed_state);
+        accept_prob = std::min(1.0, MY_EXP(log_accept));
+        accept = MY_LOG(runif(rng_)) < log_accept;
+    }
+    if (accept) {
+        flip_edge_indicator(var1, var2, proposed_state);
+        set_active_edge(var1, var2, edge_indicators_(var1, var2) == 1);
+        edge_changes_.toggled(var1, var2, edge_indicators_(var1, var2) == 1);
+    }
+    return accept_prob;
+}
+
+
+double OMRFModel::edge_indicator_log_accept(int var1, int var2, double proposed_state,
+                                            ScratchArena* arena) const {
+    const double current_state = pairwise_effects_(var1, var2);
+
     double log_accept = log_pseudolikelihood_ratio_interaction(
-        var1, var2, proposed_state, current_state
+        var1, var2, proposed_state, current_state, arena
     );
+    if (inverse_temperature_ != 1.0) log_accept *= inverse_temperature_;
+
+    return log_accept + edge_indicator_log_prior_ratio(var1, var2, proposed_state);
+}
+
+
+double OMRFModel::edge_indicator_log_prior_ratio(int var1, int var2, double proposed_state) const {
+    const double current_state = pairwise_effects_(var1, var2);
+    const bool proposing_addition = (edge_indicators_(var1, var2) == 0);
+    double log_accept = 0.0;
 
     const double inclusion_probability_ij = inclusion_probability_(var1, var2);
     const double sd = proposal_sd_pairwise_(var1, var2);
@@ -1001,17 +1674,191 @@ void OMRFModel::update_edge_indicator(int var1, int var2) {
         log_accept -= MY_LOG(inclusion_probability_ij) - MY_LOG(1.0 - inclusion_probability_ij);
     }
 
-    if (MY_LOG(runif(rng_)) < log_accept) {
-        const int updated_indicator = 1 - edge_indicators_(var1, var2);
-        edge_indicators_(var1, var2) = updated_indicator;
-        edge_indicators_(var2, var1) = updated_indicator;
+    return log_accept;
+}
+
+
+bool OMRFModel::delayed_acceptance_test(int var1, int var2, double delta, double log_other,
+                                        double& accept_prob) {
+    DelayedAcceptance& da = delayed_acceptance_;
+    const double beta = inverse_temperature_;
+    da.record_proposal();
+    accept_prob = 0.0;
+
+    // Stage 1: quadratic surrogate around the current state
+    const double gradient_current = pairwise_log_likelihood_gradient(
+        var1, var2, current_expected_score(var1), current_expected_score(var2));
+    const double forward = beta * da.surrogate(var1, var2, gradient_current, delta) + log_other;
+    if (MY_LOG(runif(rng_)) >= forward) return false;
+    da.record_first_stage_accept();
+
+    // Stage 2: exact ratio, and the surrogate of the reverse move
+    double log_ratio = 4.0 * pairwise_stats_(var1, var2) * delta;
+    log_ratio += current_log_normalizer(var1) - proposed_log_normalizer_and_score(var1, var2, delta);
+    log_ratio += current_log_normalizer(var2) - proposed_log_normalizer_and_score(var2, var1, delta);
+    log_ratio = beta * log_ratio + log_other;
+
+    const double gradient_proposed = pairwise_log_likelihood_gradient(
+        var1, var2, pending_expected_score_[var1], pending_expected_score_[var2]);
+    const double reverse = beta * da.surrogate(var1, var2, gradient_proposed, -delta) - log_other;
+    da.learn(var1, var2, gradient_current, gradient_proposed, delta);
+
+    const double log_alpha = DelayedAcceptance::second_stage_log_ratio(log_ratio, forward, reverse);
+    accept_prob = std::min(1.0, MY_EXP(log_alpha));
+    if (MY_LOG(runif(rng_)) >= log_alpha) return false;
+    da.record_second_stage_accept();
+    return true;
+}
+
+
+void OMRFModel::set_delayed_acceptance(bool enabled) {
+    delayed_acceptance_.enabled = enabled;
+    delayed_acceptance_.resize(p_);
+    expected_score_.assign(enabled ? p_ : 0, arma::vec());
+    pending_expected_score_.assign(enabled ? p_ : 0, arma::vec());
+    expected_score_valid_.zeros(p_);
+    pending_expected_valid_.zeros(p_);
+}
+
+
+void OMRFModel::set_block_main_effects(bool enabled) {
+    block_main_.enabled = enabled;
+    if (!enabled) return;
+    arma::uvec block_sizes(p_);
+    for (size_t v = 0; v < p_; ++v) {
+        block_sizes(v) = is_ordinal_variable_(v) ? num_categories_(v) : 2;
+    }
+    block_main_.resize(block_sizes, proposal_sd_main_);
+}
 
-        pairwise_effects_(var1, var2) = proposed_state;
-        pairwise_effects_(var2, var1) = proposed_state;
 
-        const double delta = proposed_state - current_state;
-        residual_matrix_.col(var1) += 2.0 * observations_double_.col(var2) * delta;
-        residual_matrix_.col(var2) += 2.0 * observations_double_.col(var1) * delta;
+void OMRFModel::initialize_from_pseudo_mle() {
+    auto objective = [this](const arma::vec& parameters) {
+        return logp_and_gradient(parameters);
+    };
+    const LBFGSResult mode = lbfgs_maximize(objective, get_vectorized_parameters());
+    if (!std::isfinite(mode.value)) return;
+    set_vectorized_parameters(mode.x);
+
+    // Inverse curvature of the active parameters, spread over the full
+    // vector (main effects, then every pair); excluded pairs keep 1.
+    const arma::vec active_inv_mass = inverse_curvature(
+        hessian_diagonal(objective, mode.x, mode.gradient));
+    initial_inv_mass_.ones(num_main_ + num_pairwise_);
+    initial_inv_mass_.head(num_main_) = active_inv_mass.head(num_main_);
+
+    // A random-walk proposal SD of 2.4 conditional SDs accepts about 44%.
+    constexpr double proposal_scale = 2.4;
+    int offset = 0;
+    for (size_t v = 0; v < p_; ++v) {
+        const int num_main = is_ordinal_variable_(v) ? num_categories_(v) : 2;
+        for (int c = 0; c < num_main; ++c) {
+            proposal_sd_main_(v, c) = proposal_scale * std::sqrt(active_inv_mass(offset++));
+        }
+    }
+    if (block_main_.enabled) set_block_main_effects(true);
+    size_t offset_full = num_main_;
+    for (size_t v1 = 0; v1 < p_ - 1; ++v1) {
+        for (size_t v2 = v1 + 1; v2 < p_; ++v2) {
+            if (edge_indicators_(v1, v2) == 1) {
+                const double inv_mass = active_inv_mass(offset++);
+                initial_inv_mass_(offset_full) = inv_mass;
+                proposal_sd_pairwise_(v1, v2) = proposal_scale * std::sqrt(inv_mass);
+                proposal_sd_pairwise_(v2, v1) = proposal_sd_pairwise_(v1, v2);
+            }
+            offset_full++;
+        }
+    }
+}
+
+
+void OMRFModel::flip_edge_indicator(int var1, int var2, double proposed_state) {
+    const double current_state = pairwise_effects_(var1, var2);
+    const int updated_indicator = 1 - edge_indicators_(var1, var2);
+    edge_indicators_(var1, var2) = updated_indicator;
+    edge_indicators_(var2, var1) = updated_indicator;
+
+    pairwise_effects_(var1, var2) = proposed_state;
+    pairwise_effects_(var2, var1) = proposed_state;
+
+    update_residual_columns(var1, var2, proposed_state - current_state);
+}
+
+
+void OMRFModel::update_edge_indicators_by_matching() {
+    const int num_pairs = static_cast<int>(num_pairwise_);
+    edge_normals_.set_size(num_pairs);
+    edge_uniforms_.set_size(num_pairs);
+    rnorm_fill(rng_, edge_normals_.memptr(), num_pairs);
+    runif_fill(rng_, edge_uniforms_.memptr(), num_pairs);
+
+    // Level of each scan position: one past the last matching that holds
+    // an earlier pair with a shared variable
+    variable_level_.assign(p_, 0);
+    edge_level_.resize(num_pairs);
+    std::vector<int>& level = edge_level_;
+    int num_matchings = 0;
+    for (int pos = 0; pos < num_pairs; ++pos) {
+        const int idx = shuffled_edge_order_(pos);
+        const int var1 = interaction_index_(idx, 1);
+        const int var2 = interaction_index_(idx, 2);
+        const int m = std::max(variable_level_[var1], variable_level_[var2]);
+        level[pos] = m;
+        variable_level_[var1] = variable_level_[var2] = m + 1;
+        num_matchings = std::max(num_matchings, m + 1);
+    }
+
+    // Group the scan positions by matching, in scan order within each
+    matching_start_.assign(num_matchings + 1, 0);
+    for (int pos = 0; pos < num_pairs; ++pos) matching_start_[level[pos] + 1]++;
+    for (int m = 0; m < num_matchings; ++m) matching_start_[m + 1] += matching_start_[m];
+    matching_pairs_.resize(num_pairs);
+    variable_level_.assign(num_matchings, 0);   // reused as fill cursor
+    for (int pos = 0; pos < num_pairs; ++pos) {
+        const int m = level[pos];
+        matching_pairs_[matching_start_[m] + variable_level_[m]++] = pos;
+    }
+    edge_flipped_.assign(num_pairs, 0);
+
+    for (int m = 0; m < num_matchings; ++m) {
+        const int begin = matching_start_[m];
+        const int size = matching_start_[m + 1] - begin;
+        const int num_blocks = std::min(gradient_threads_, size);
+
+        // The pairs of a matching share no variable, so each writes only
+        // its own rows and columns
+        parallel_for_blocks(num_blocks, [&](int block) {
+            int first, last;
+            block_range(size, num_blocks, block, first, last);
+            for (int k = begin + first; k < begin + last; ++k) {
+                const int pos = matching_pairs_[k];
+                const int idx = shuffled_edge_order_(pos);
+                const int var1 = interaction_index_(idx, 1);
+                const int var2 = interaction_index_(idx, 2);
+                const double current_state = pairwise_effects_(var1, var2);
+                const double proposed_state = edge_indicators_(var1, var2) == 0
+                    ? current_state + proposal_sd_pairwise_(var1, var2) * edge_normals_(pos)
+                    : 0.0;
+                if (MY_LOG(edge_uniforms_(pos)) <
+                        edge_indicator_log_accept(var1, var2, proposed_state,
+                                                  &matching_arenas_[block])) {
+                    flip_edge_indicator(var1, var2, proposed_state);
+                    edge_flipped_[pos] = 1;
+                }
+            }
+        });
+
+        // The active set and the edge prior are shared, so they are
+        // updated after the matching
+        for (int k = begin; k < begin + size; ++k) {
+            const int pos = matching_pairs_[k];
+            if (!edge_flipped_[pos]) continue;
+            const int idx = shuffled_edge_order_(pos);
+            const int var1 = interaction_index_(idx, 1);
+            const int var2 = interaction_index_(idx, 2);
+            set_active_edge(var1, var2, edge_indicators_(var1, var2) == 1);
+            edge_changes_.toggled(var1, var2, edge_indicators_(var1, var2) == 1);
+        }
     }
 }
 
@@ -1053,7 +1900,11 @@ void OMRFModel::do_one_metropolis_step(int iteration) {
         proposal_sd_main_.n_rows, proposal_sd_main_.n_cols);
 
     for (size_t v = 0; v < p_; ++v) {
-        if (is_ordinal_variable_(v)) {
+        if (block_main_.enabled) {
+            double ap = update_main_effect_block(v, iteration);
+            sum_accept += ap;
+            ++n_accept;
+        } else if (is_ordinal_variable_(v)) {
             int num_cats = num_categories_(v);
             for (int c = 0; c < num_cats; ++c) {
                 double ap = update_main_effect_parameter(v, c, -1);
@@ -1071,7 +1922,7 @@ void OMRFModel::do_one_metropolis_step(int iteration) {
         }
     }
 
-    if (metropolis_main_adapter_) {
+    if (metropolis_main_adapter_ && !block_main_.enabled) {
         metropolis_main_adapter_->update(index_mask_main, accept_prob_main, iteration);
     }
 
@@ -1083,18 +1934,327 @@ void OMRFModel::do_one_metropolis_step(int iteration) {
 }
 
 
+// =============================================================================
+// Pólya-Gamma Gibbs sweep
+// =============================================================================
+
+bool OMRFModel::supports_polya_gamma() const {
+    for (size_t v = 0; v < p_; ++v) {
+        if (!is_ordinal_variable_(v) || num_categories_(v) != 1) return false;
+    }
+    return threshold_prior_->has_gaussian_augmentation() &&
+           interaction_prior_->has_gaussian_augmentation();
+}
+
+
+void OMRFModel::do_one_polya_gamma_step() {
+    if (!supports_polya_gamma()) {
+        throw std::runtime_error(
+            "The Polya-Gamma sampler needs binary variables and normal, Cauchy or "
+            "beta-prime (whole alpha + beta) priors.");
+    }
+    if (pattern_compressed_ || uses_subsampling() || inverse_temperature_ != 1.0) {
+        throw std::runtime_error(
+            "The Polya-Gamma sampler cannot be combined with compressed patterns, "
+            "subsampling or tempering.");
+    }
+    ScratchArena::Frame frame(scratch_);
+    const int num_variables = static_cast<int>(p_);
+
+    // --- omega_iv ~ PG(1, main_v + r_iv) ---
+    // The streams are seeded serially from rng_, so the draws do not depend
+    // on the number of threads.
+    omega_streams_.clear();
+    omega_streams_.reserve(p_);
+    for (size_t v = 0; v < p_; ++v) omega_streams_.emplace_back(rng_);
+    arma::mat omega = scratch_.mat(n_, p_);
+    const int num_blocks = std::min(gradient_threads_, num_variables);
+    parallel_for_blocks(num_blocks, [&](int block) {
+        int begin, end;
+        block_range(num_variables, num_blocks, block, begin, end);
+        for (int v = begin; v < end; ++v) {
+            double* column = omega.colptr(v);
+            const double* residual = residual_matrix_.colptr(v);
+            const double main = main_effects_(v, 0);
+            for (size_t i = 0; i < n_; ++i) column[i] = main + residual[i];
+            rpolya_gamma_fill(omega_streams_[v], column, column, n_);
+        }
+    });
+
+    // --- Prior latent variables, at the current state ---
+    arma::vec main_linear = scratch_.vec(p_);
+    arma::vec main_precision = scratch_.vec(p_);
+    for (size_t v = 0; v < p_; ++v) {
+        threshold_prior_->draw_gaussian_augmentation(
+            main_effects_(v, 0), 1.0, rng_, main_linear(v), main_precision(v));
+    }
+    arma::mat prior_linear = scratch_.mat(p_, p_);
+    arma::mat prior_precision = scratch_.mat(p_, p_);
+    for (size_t v1 = 0; v1 + 1 < p_; ++v1) {
+        for (size_t v2 = v1 + 1; v2 < p_; ++v2) {
+            if (edge_indicators_(v1, v2) == 0) continue;
+            interaction_prior_->draw_gaussian_augmentation(
+                pairwise_effects_(v1, v2), pairwise_scaling_factors_(v1, v2), rng_,
+                prior_linear(v1, v2), prior_precision(v1, v2));
+            prior_linear(v2, v1) = prior_linear(v1, v2);
+            prior_precision(v2, v1) = prior_precision(v1, v2);
+        }
+    }
+
+    // --- Blocks, with omega and the prior latents held fixed ---
+    pending_partner_.fill(-1);
+    pending_expected_valid_.zeros();
+    for (int v = 0; v < num_variables; ++v) {
+        update_polya_gamma_block(v, omega, main_linear, main_precision,
+                                 prior_linear, prior_precision);
+    }
+
+    invalidate_gradient_cache();
+}
+
+
+void OMRFModel::update_polya_gamma_block(int variable, const arma::mat& omega,
+                                         const arma::vec& main_linear,
+                                         const arma::vec& main_precision,
+                                         const arma::mat& prior_linear,
+                                         const arma::mat& prior_precision) {
+    ScratchArena::Frame frame(scratch_);
+    const CompactScores& x = data_->observations;
+    const std::vector<int>& neighbours = active_neighbours_[variable];
+    const arma::uword k = neighbours.size();
+    auto omega_col = [&](int v) {
+        return arma::vec(const_cast<double*>(omega.colptr(v)), n_, false, true);
+    };
+    const arma::vec omega_v = omega_col(variable);
+
+    // Given omega the pseudolikelihood is Gaussian in beta = (main_v,
+    // theta_vw for w in N): psi_iv = main_v + sum_w 2 theta_vw x_iw, and
+    // psi_iw of each neighbour w moves by 2 theta_vw x_iv. Precision P and
+    // linear term b of exp(b' beta - beta' P beta / 2):
+    arma::mat precision = scratch_.mat(k + 1, k + 1);
+    arma::vec linear = scratch_.vec(k + 1);
+    arma::mat gram = scratch_.mat(k, k);
+    arma::mat panel = scratch_.mat(std::min<arma::uword>(256, n_), k);
+    arma::vec weighted = scratch_.vec(n_);
+
+    x.weighted_gram(neighbours, omega_v.memptr(), gram, panel);
+    precision(0, 0) = arma::accu(omega_v) + main_precision(variable);
+    linear(0) = counts_per_category_(1, variable) - 0.5 * static_cast<double>(n_) +
+                main_linear(variable);
+    for (arma::uword j = 0; j < k; ++j) {
+        const int w = neighbours[j];
+        const arma::vec omega_w = omega_col(w);
+        precision(0, j + 1) = precision(j + 1, 0) = 2.0 * x.dot(w, omega_v);
+        for (arma::uword l = 0; l < k; ++l) precision(j + 1, l + 1) = 4.0 * gram(j, l);
+
+        // The neighbour's term, at its current psi minus 2 theta_vw x_v
+        const double c = x.dot(variable, omega_w);
+        weighted = omega_w % (residual_matrix_.col(w) + main_effects_(w, 0));
+        const double d = x.dot(variable, weighted) - 2.0 * pairwise_effects_(variable, w) * c;
+        precision(j + 1, j + 1) += 4.0 * c + prior_precision(variable, w);
+        linear(j + 1) = 4.0 * pairwise_stats_(variable, w) - pairwise_stats_(w, w) -
+                        pairwise_stats_(variable, variable) - 2.0 * d +
+                        prior_linear(variable, w);
+    }
+
+    // beta = L'^{-1} (L^{-1} b + z) for P = L L' and z ~ N(0, I)
+    arma::mat chol_lower = scratch_.mat(k + 1, k + 1);
+    if (!arma::chol(chol_lower, precision, "lower")) return;
+    arma::vec z = scratch_.vec(k + 1);
+    rnorm_fill(rng_, z.memptr(), k + 1);
+    const arma::vec shifted = arma::solve(
+        arma::trimatl(chol_lower), linear, arma::solve_opts::fast) + z;
+    const arma::vec beta = arma::solve(
+        arma::trimatu(chol_lower.t()), shifted, arma::solve_opts::fast);
+
+    main_effects_(variable, 0) = beta(0);
+    for (arma::uword j = 0; j < k; ++j) {
+        const int w = neighbours[j];
+        const double delta = beta(j + 1) - pairwise_effects_(variable, w);
+        pairwise_effects_(variable, w) = pairwise_effects_(w, variable) = beta(j + 1);
+        update_residual_columns(variable, w, delta);
+    }
+    log_normalizer_valid_(variable) = 0;
+    expected_score_valid_(variable) = 0;
+}
+
+
 void OMRFModel::prepare_iteration() {
     // Shuffle edge order unconditionally to advance the RNG state consistently.
-    shuffled_edge_order_ = arma_randperm(rng_, num_pairwise_);
+    arma_randperm_into(rng_, shuffled_edge_order_, num_pairwise_);
+
+    if (uses_subsampling()) {
+        if (subsample_iteration_ % subsample_refresh_ == 0) {
+            refresh_subsample_reference();
+        }
+        ++subsample_iteration_;
+        draw_subsample_batch();
+    }
+}
+
+
+// =============================================================================
+// Subsampled pseudolikelihood
+// =============================================================================
+
+void OMRFModel::set_subsampling(int batch_size, int refresh_every) {
+    if (batch_size > 0 && (pattern_compressed_ || has_missing_)) {
+        Rcpp::stop("Subsampling cannot be combined with compressed patterns or missing-data imputation");
+    }
+    subsample_size_ = std::max(0, batch_size);
+    subsample_refresh_ = std::max(1, refresh_every);
+    subsample_iteration_ = 0;
+    batch_rows_.reset();
+    invalidate_log_normalizers();
+}
+
+
+void OMRFModel::set_gradient_backend(const std::string& backend) {
+    if (backend == "cpu") {
+        gpu_backend_.reset();
+        return;
+    }
+    if (backend != "gpu") {
+        Rcpp::stop("Unknown gradient backend: '%s'", backend.c_str());
+    }
+    if (pattern_compressed_ || has_missing_ || subsample_size_ > 0) {
+        Rcpp::stop("The GPU gradient backend cannot be combined with compressed patterns, "
+                   "missing-data imputation or subsampling");
+    }
+    if (data_->observations.bytes_per_score() != 1) {
+        Rcpp::stop("The GPU gradient backend needs category scores in [-128, 127]");
+    }
+
+    // The device holds the scores as stored: one byte each, column-major
+    std::vector<std::int8_t> scores(n_ * p_);
+    for (size_t v = 0; v < p_; ++v) {
+        for (size_t i = 0; i < n_; ++i) {
+            scores[v * n_ + i] = static_cast<std::int8_t>(data_->observations(i, v));
+        }
+    }
+    const std::vector<int> num_categories(num_categories_.begin(), num_categories_.end());
+    const std::vector<int> is_ordinal(is_ordinal_variable_.begin(), is_ordinal_variable_.end());
+    const std::vector<int> baseline(baseline_category_.begin(), baseline_category_.end());
+    try {
+        gpu_backend_ = std::make_unique<OMRFGpuBackend>(
+            scores.data(), static_cast<int>(n_), static_cast<int>(p_),
+            num_categories.data(), is_ordinal.data(), baseline.data());
+    } catch (const std::exception& e) {
+        Rcpp::stop(e.what());
+    }
+}
+
+
+void OMRFModel::refresh_subsample_reference() {
+    // The exact path must run on all rows
+    batch_rows_.reset();
+
+    reference_main_ = main_effects_;
+    reference_pairwise_ = pairwise_effects_;
+    reference_log_z_.set_size(p_);
+    reference_prob_sums_.zeros(num_categories_.max() + 1, p_);
+    reference_cross_.set_size(p_, p_);
+
+    const int num_variables = static_cast<int>(p_);
+    const int num_blocks = std::min(gradient_threads_, num_variables);
+    parallel_for_blocks(num_blocks, [&](int block) {
+        int begin, end;
+        block_range(num_variables, num_blocks, block, begin, end);
+        LogZWorkspace& workspace = logz_workspaces_[block];
+        for (int variable = begin; variable < end; variable++) {
+            compute_variable_moments(
+                variable, reference_main_, residual_matrix_.col(variable), workspace, nullptr
+            );
+            const int num_cats = num_categories_(variable);
+            reference_log_z_(variable) = workspace.moments.log_Z_sum;
+            reference_prob_sums_.col(variable).head(num_cats + 1) = workspace.moments.prob_sums;
+            data_->observations.tmul(workspace.moments.E, reference_cross_.colptr(variable));
+        }
+    });
+}
+
+
+void OMRFModel::draw_subsample_batch() {
+    const arma::uword m = static_cast<arma::uword>(subsample_size_);
+
+    // Partial Fisher-Yates: the first m entries of the pool become a
+    // uniform sample without replacement
+    if (row_pool_.n_elem != n_) row_pool_ = arma::regspace<arma::uvec>(0, n_ - 1);
+    for (arma::uword k = 0; k < m; ++k) {
+        const arma::uword remaining = n_ - k;
+        const arma::uword j = k + std::min(
+            static_cast<arma::uword>(runif(rng_) * remaining), remaining - 1);
+        std::swap(row_pool_(k), row_pool_(j));
+    }
+    batch_rows_ = arma::sort(row_pool_.head(m));
+
+    batch_observations_.set_size(m, p_);
+    for (size_t v = 0; v < p_; ++v) {
+        for (arma::uword k = 0; k < m; ++k) {
+            batch_observations_(k, v) = data_->observations(batch_rows_(k), v);
+        }
+    }
+
+    batch_reference_residual_ = 2.0 * batch_observations_ * reference_pairwise_;
+    batch_reference_log_z_.set_size(m, p_);
+    batch_reference_log_z_sum_.set_size(p_);
+    for (size_t v = 0; v < p_; ++v) {
+        batch_reference_log_z_.col(v) =
+            log_normalizer_terms(v, batch_reference_residual_.col(v), reference_main_);
+        batch_reference_log_z_sum_(v) = arma::accu(batch_reference_log_z_.col(v));
+    }
+
+    batch_reference_prob_sums_.zeros(num_categories_.max() + 1, p_);
+    batch_reference_cross_.set_size(p_, p_);
+    batch_reference_moments_valid_ = false;
+    invalidate_log_normalizers();
+}
+
+
+void OMRFModel::compute_batch_reference_moments(int variable, LogZWorkspace& workspace) {
+    compute_variable_moments(
+        variable, reference_main_, batch_reference_residual_.col(variable), workspace, nullptr
+    );
+    const int num_cats = num_categories_(variable);
+    batch_reference_prob_sums_.col(variable).head(num_cats + 1) = workspace.moments.prob_sums;
+    batch_reference_cross_.col(variable) = batch_observations_.t() * workspace.moments.E;
+}
+
+
+double OMRFModel::subsample_variance() const {
+    if (batch_rows_.is_empty()) return std::numeric_limits<double>::quiet_NaN();
+
+    const arma::uword m = batch_rows_.n_elem;
+    arma::vec difference(m, arma::fill::zeros);
+    for (size_t v = 0; v < p_; ++v) {
+        difference += log_normalizer_terms(v, batch_residual(v), main_effects_) -
+                      batch_reference_log_z_.col(v);
+    }
+    if (m < 2) return 0.0;
+    const double n = static_cast<double>(n_);
+    const double fraction = static_cast<double>(m) / n;
+    return n * n * (1.0 - fraction) * arma::var(difference) / static_cast<double>(m);
 }
 
 
 void OMRFModel::update_edge_indicators() {
+    if (matching_edge_updates_) {
+        update_edge_indicators_by_matching();
+        return;
+    }
+    if (informed_edges_.drawing()) {
+        // As many moves as a sequential sweep, on pairs drawn by weight
+        for (size_t i = 0; i < num_pairwise_; ++i) {
+            const arma::uword idx = informed_edges_.draw(rng_);
+            update_edge_indicator(interaction_index_(idx, 1), interaction_index_(idx, 2));
+        }
+        return;
+    }
     for (size_t i = 0; i < num_pairwise_; ++i) {
         int idx = shuffled_edge_order_(i);
         int var1 = interaction_index_(idx, 1);
         int var2 = interaction_index_(idx, 2);
-        update_edge_indicator(var1, var2);
+        informed_edges_.record(idx, update_edge_indicator(var1, var2));
     }
 }
 
@@ -1102,96 +2262,334 @@ void OMRFModel::update_edge_indicators() {
 
 void OMRFModel::impute_missing() {
     if (!has_missing_) return;
+    ObservationData& data = data_.mut();
 
-    const int num_variables = p_;
-    const int num_missings = missing_index_.n_rows;
-    const int max_num_categories = num_categories_.max();
-
-    arma::vec category_probabilities(max_num_categories + 1);
+    for (size_t variable = 0; variable < p_; variable++) {
+        const arma::uvec& persons = missing_persons_[variable];
+        const arma::uword m = persons.n_elem;
+        if (m == 0) continue;
 
-    for (int miss = 0; miss < num_missings; miss++) {
-        const int person = missing_index_(miss, 0);
-        const int variable = missing_index_(miss, 1);
-
-        const double residual_score = residual_matrix_(person, variable);
         const int num_cats = num_categories_(variable);
         const bool is_ordinal = is_ordinal_variable_(variable);
+        const int ref = is_ordinal ? 0 : baseline_category_(variable);
 
-        double cumsum = 0.0;
-
-        if (is_ordinal) {
-            cumsum = 1.0;
-            category_probabilities[0] = cumsum;
-            for (int cat = 0; cat < num_cats; cat++) {
-                const int score = cat + 1;
-                const double exponent = main_effects_(variable, cat) + score * residual_score;
-                cumsum += MY_EXP(exponent);
-                category_probabilities[score] = cumsum;
-            }
-        } else {
-            const int ref = baseline_category_(variable);
-            cumsum = 0.0;
-
-            for (int cat = 0; cat <= num_cats; cat++) {
-                const int score = cat - ref;
-                const double exponent =
-                    main_effects_(variable, 0) * score +
-                    main_effects_(variable, 1) * score * score +
-                    score * residual_score;
-                cumsum += MY_EXP(exponent);
-                category_probabilities[cat] = cumsum;
+        // Exponents, one column per missing cell; row c is category c
+        impute_weights_.set_size(num_cats + 1, m);
+        for (arma::uword k = 0; k < m; k++) {
+            const double residual_score = residual_matrix_(persons[k], variable);
+            double* exponent = impute_weights_.colptr(k);
+            if (is_ordinal) {
+                exponent[0] = 0.0;
+                for (int cat = 0; cat < num_cats; cat++) {
+                    const int score = cat + 1;
+                    exponent[score] = main_effects_(variable, cat) + score * residual_score;
+                }
+            } else {
+                for (int cat = 0; cat <= num_cats; cat++) {
+                    const int score = cat - ref;
+                    exponent[cat] =
+                        main_effects_(variable, 0) * score +
+                        main_effects_(variable, 1) * score * score +
+                        score * residual_score;
+                }
             }
         }
-
-        // Sample from categorical distribution via inverse transform
-        const double u = runif(rng_) * cumsum;
-        int sampled_score = 0;
-        while (u > category_probabilities[sampled_score]) {
-            sampled_score++;
-        }
-
-        int new_value = sampled_score;
-        if (!is_ordinal)
-            new_value -= baseline_category_(variable);
-        const int old_value = observations_(person, variable);
-
-        if (new_value != old_value) {
-            observations_(person, variable) = new_value;
-            observations_double_(person, variable) = static_cast<double>(new_value);
+        impute_uniforms_.set_size(m);
+        runif_fill(rng_, impute_uniforms_.memptr(), m);
+        sample_categorical_exp_columns(impute_weights_, impute_uniforms_, impute_draws_);
+
+        arma::uvec changed_rows(m);
+        arma::vec changed_delta(m);
+        arma::uword num_changed = 0;
+
+        for (arma::uword k = 0; k < m; k++) {
+            const arma::uword person = persons[k];
+            const int new_value = static_cast<int>(impute_draws_[k]) - ref;
+            const int old_value = data.observations(person, variable);
+            if (new_value == old_value) continue;
+
+            data.observations.set(person, variable, new_value);
+
+            // X^T X changes in row and column `variable` only. A row with a
+            // missing entry is never merged into a pattern, so its weight is 1.
+            const int change = new_value - old_value;
+            for (size_t t = 0; t < p_; ++t) {
+                if (t == variable) continue;
+                const int product = change * data.observations(person, t);
+                pairwise_stats_(variable, t) += product;
+                pairwise_stats_(t, variable) += product;
+            }
+            pairwise_stats_(variable, variable) += new_value * new_value - old_value * old_value;
 
             if (is_ordinal) {
                 counts_per_category_(old_value, variable)--;
                 counts_per_category_(new_value, variable)++;
             } else {
-                const int delta = new_value - old_value;
-                const int delta_sq = new_value * new_value - old_value * old_value;
-                blume_capel_stats_(0, variable) += delta;
-                blume_capel_stats_(1, variable) += delta_sq;
+                blume_capel_stats_(0, variable) += new_value - old_value;
+                blume_capel_stats_(1, variable) += new_value * new_value - old_value * old_value;
             }
 
-            // Incrementally update residuals across all variables
-            for (int var = 0; var < num_variables; var++) {
-                const double delta_score = 2.0 * (new_value - old_value) * pairwise_effects_(var, variable);
-                residual_matrix_(person, var) += delta_score;
-            }
+            changed_rows[num_changed] = person;
+            changed_delta[num_changed] = 2.0 * (new_value - old_value);
+            num_changed++;
         }
-    }
 
-    // Recompute pairwise sufficient statistics
-    arma::mat ps = observations_double_.t() * observations_double_;
-    pairwise_stats_ = arma::conv_to<arma::imat>::from(ps);
-
-    // Update cached transpose so gradients use current imputed values
-    observations_double_t_ = observations_double_.t();
+        // Residuals of the changed rows, all variables at once
+        if (num_changed > 0) {
+            const arma::uvec changed = changed_rows.head(num_changed);
+            residual_matrix_.rows(changed) +=
+                changed_delta.head(num_changed) * pairwise_effects_.row(variable);
+        }
+    }
 
     // Sufficient statistics changed; gradient cache must be rebuilt
     invalidate_gradient_cache();
+    invalidate_log_normalizers();
 }
 
 
 void OMRFModel::set_missing_data(const arma::imat& missing_index) {
+    if (pattern_compressed_) {
+        Rcpp::stop("set_missing_data() must be called before compress_patterns()");
+    }
     missing_index_ = missing_index;
     has_missing_ = (missing_index.n_rows > 0 && missing_index.n_cols == 2);
+    group_missing_by_variable();
+}
+
+
+void OMRFModel::group_missing_by_variable() {
+    missing_persons_.assign(p_, arma::uvec());
+    if (!has_missing_) return;
+
+    std::vector<std::vector<arma::uword>> persons(p_);
+    for (arma::uword m = 0; m < missing_index_.n_rows; ++m) {
+        persons[missing_index_(m, 1)].push_back(missing_index_(m, 0));
+    }
+    for (size_t v = 0; v < p_; ++v) {
+        missing_persons_[v] = arma::uvec(persons[v]);
+    }
+}
+
+
+void OMRFModel::compress_patterns() {
+    if (pattern_compressed_ || n_ == 0) return;
+
+    // Rows with a missing entry are imputed one by one, so they never share
+    // a pattern with other rows.
+    std::vector<char> keep_separate(n_, 0);
+    if (has_missing_) {
+        for (arma::uword m = 0; m < missing_index_.n_rows; ++m) {
+            keep_separate[missing_index_(m, 0)] = 1;
+        }
+    }
+
+    auto row_less = [&](arma::uword a, arma::uword b) {
+        for (size_t v = 0; v < p_; ++v) {
+            if (data_->observations(a, v) != data_->observations(b, v)) {
+                return data_->observations(a, v) < data_->observations(b, v);
+            }
+        }
+        return false;
+    };
+
+    std::vector<arma::uword> order(n_);
+    for (size_t i = 0; i < n_; ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), row_less);
+
+    // Walk rows in sorted order; identical rows are adjacent
+    std::vector<arma::uword> representative;
+    std::vector<double> weight;
+    std::vector<arma::uword> pattern_of(n_);
+    long last_shared = -1;
+    for (arma::uword row : order) {
+        const bool same_as_last = last_shared >= 0 && !keep_separate[row] &&
+            !row_less(representative[last_shared], row) &&
+            !row_less(row, representative[last_shared]);
+        if (same_as_last) {
+            weight[last_shared] += 1.0;
+            pattern_of[row] = last_shared;
+        } else {
+            pattern_of[row] = representative.size();
+            if (!keep_separate[row]) last_shared = static_cast<long>(representative.size());
+            representative.push_back(row);
+            weight.push_back(1.0);
+        }
+    }
+
+    arma::imat patterns(representative.size(), p_);
+    for (size_t u = 0; u < representative.size(); ++u) {
+        patterns.row(u) = data_->observations.row(representative[u]);
+    }
+    for (arma::uword m = 0; m < missing_index_.n_rows; ++m) {
+        missing_index_(m, 0) = pattern_of[missing_index_(m, 0)];
+    }
+    group_missing_by_variable();
+
+    // Sufficient statistics were computed on the full data and are unchanged
+    ObservationData& data = data_.mut();
+    data.observations = CompactScores(patterns);
+    data.pattern_weights = arma::vec(weight);
+    n_ = patterns.n_rows;
+    pattern_compressed_ = true;
+
+    update_residual_matrix();
+    invalidate_gradient_cache();
+}
+
+
+// =============================================================================
+// Data updates
+// =============================================================================
+
+void OMRFModel::check_data_update_supported() const {
+    if (pattern_compressed_) {
+        throw std::invalid_argument("Observations cannot be added or removed after compress_patterns().");
+    }
+    if (has_missing_) {
+        throw std::invalid_argument("Observations cannot be added or removed with missing-data imputation.");
+    }
+    if (subsample_size_ > 0) {
+        throw std::invalid_argument("Observations cannot be added or removed with a subsampled pseudolikelihood.");
+    }
+    if (gpu_backend_) {
+        throw std::invalid_argument("Observations cannot be added or removed with the GPU gradient backend.");
+    }
+}
+
+
+void OMRFModel::invalidate_data_caches() {
+    invalidate_log_normalizers();
+    pending_partner_.fill(-1);
+    pending_expected_valid_.zeros();
+    invalidate_gradient_cache();
+}
+
+
+void OMRFModel::accumulate_sufficient_statistics(const arma::imat& centered_rows, int sign) {
+    for (size_t v = 0; v < p_; ++v) {
+        for (arma::uword i = 0; i < centered_rows.n_rows; ++i) {
+            const int s = centered_rows(i, v);
+            if (is_ordinal_variable_(v)) {
+                counts_per_category_(s, v) += sign;
+            } else {
+                blume_capel_stats_(0, v) += sign * s;
+                blume_capel_stats_(1, v) += sign * s * s;
+            }
+        }
+    }
+    const arma::mat rows_double = arma::conv_to<arma::mat>::from(centered_rows);
+    pairwise_stats_ += sign * arma::conv_to<arma::imat>::from(rows_double.t() * rows_double);
+}
+
+
+arma::imat OMRFModel::center_new_observations(const arma::imat& rows) const {
+    check_data_update_supported();
+    if (rows.n_cols != p_) {
+        throw std::invalid_argument("New observations must have one column per variable.");
+    }
+    arma::imat centered = rows;
+    for (size_t v = 0; v < p_; ++v) {
+        if (rows.n_rows > 0 &&
+            (rows.col(v).min() < 0 || rows.col(v).max() > num_categories_(v))) {
+            throw std::invalid_argument(
+                "New observations of variable " + std::to_string(v + 1) +
+                " lie outside its categories.");
+        }
+        if (!is_ordinal_variable_(v)) centered.col(v) -= baseline_category_(v);
+    }
+    return centered;
+}
+
+
+void OMRFModel::add_observation_state(const arma::imat& centered) {
+    accumulate_sufficient_statistics(centered, 1);
+
+    // Residual rows 2 X_new B, with the same panel product as the full data
+    arma::mat new_residuals;
+    CompactScores(centered).mul(pairwise_effects_, 2.0, new_residuals, residual_panel_);
+    residual_matrix_.insert_rows(residual_matrix_.n_rows, new_residuals);
+    n_ += centered.n_rows;
+}
+
+
+arma::uvec OMRFModel::observations_to_keep(const arma::uvec& rows) const {
+    check_data_update_supported();
+    std::vector<char> drop(n_, 0);
+    for (arma::uword r : rows) {
+        if (r >= n_ || drop[r]) {
+            throw std::invalid_argument("Rows to remove must be distinct rows of the data.");
+        }
+        drop[r] = 1;
+    }
+    if (rows.n_elem > 0 && rows.n_elem == n_) {
+        throw std::invalid_argument("At least one observation must remain.");
+    }
+
+    arma::uvec keep(n_ - rows.n_elem);
+    arma::uword next = 0;
+    for (size_t i = 0; i < n_; ++i) {
+        if (!drop[i]) keep(next++) = i;
+    }
+    return keep;
+}
+
+
+void OMRFModel::drop_observation_state(const arma::uvec& rows, const arma::uvec& keep) {
+    arma::imat removed(rows.n_elem, p_);
+    for (arma::uword k = 0; k < rows.n_elem; ++k) {
+        removed.row(k) = data_->observations.row(rows(k));
+    }
+    accumulate_sufficient_statistics(removed, -1);
+    residual_matrix_ = residual_matrix_.rows(keep);
+    n_ = keep.n_elem;
+}
+
+
+const OMRFModel& OMRFModel::updated_clone(const BaseModel& updated, size_t n) const {
+    const auto* source = dynamic_cast<const OMRFModel*>(&updated);
+    if (source == nullptr || source->p_ != p_ || source->data_->observations.n_rows() != n) {
+        throw std::invalid_argument("The updated model is not a clone holding the same update.");
+    }
+    return *source;
+}
+
+
+void OMRFModel::append_observations(const arma::imat& rows) {
+    const arma::imat centered = center_new_observations(rows);
+    if (centered.n_rows == 0) return;
+    add_observation_state(centered);
+    data_.mut().observations.append_rows(centered);
+    invalidate_data_caches();
+}
+
+
+void OMRFModel::append_observations(const arma::imat& rows, const BaseModel& updated) {
+    const arma::imat centered = center_new_observations(rows);
+    if (centered.n_rows == 0) return;
+    const OMRFModel& source = updated_clone(updated, n_ + centered.n_rows);
+    add_observation_state(centered);
+    data_.share(source.data_);
+    invalidate_data_caches();
+}
+
+
+void OMRFModel::remove_observations(const arma::uvec& rows) {
+    const arma::uvec keep = observations_to_keep(rows);
+    if (rows.n_elem == 0) return;
+    drop_observation_state(rows, keep);
+    data_.mut().observations.keep_rows(keep);
+    invalidate_data_caches();
+}
+
+
+void OMRFModel::remove_observations(const arma::uvec& rows, const BaseModel& updated) {
+    const arma::uvec keep = observations_to_keep(rows);
+    if (rows.n_elem == 0) return;
+    const OMRFModel& source = updated_clone(updated, keep.n_elem);
+    drop_observation_state(rows, keep);
+    data_.share(source.data_);
+    invalidate_data_caches();
 }
 
 
@@ -1207,13 +2605,33 @@ OMRFModel createOMRFModelFromR(
     std::unique_ptr<BaseParameterPrior> threshold_prior,
     bool edge_selection
 ) {
-    arma::imat observations = Rcpp::as<arma::imat>(inputFromR["observations"]);
     arma::ivec num_categories = Rcpp::as<arma::ivec>(inputFromR["num_categories"]);
     arma::uvec is_ordinal_variable = Rcpp::as<arma::uvec>(inputFromR["is_ordinal_variable"]);
     arma::ivec baseline_category = Rcpp::as<arma::ivec>(inputFromR["baseline_category"]);
 
+    if (inputFromR.containsElementNamed("observation_file")) {
+        // Mapped scores are read as stored, so they cannot be centered
+        if (arma::any(blume_capel_centers(is_ordinal_variable, baseline_category) != 0)) {
+            Rcpp::stop("Score files hold ordinal variables only.");
+        }
+        const std::string path = Rcpp::as<std::string>(inputFromR["observation_file"]);
+        return OMRFModel(
+            CompactScores(std::make_shared<const MappedScoreFile>(path)),
+            num_categories,
+            inclusion_probability,
+            initial_edge_indicators,
+            is_ordinal_variable,
+            baseline_category,
+            std::move(interaction_prior),
+            std::move(threshold_prior),
+            edge_selection
+        );
+    }
+
     return OMRFModel(
-        observations,
+        compact_scores_from_r(
+            inputFromR["observations"],
+            blume_capel_centers(is_ordinal_variable, baseline_category)),
         num_categories,
         inclusion_probability,
         initial_edge_indicators,
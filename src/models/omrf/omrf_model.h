@@ -2,12 +2,19 @@
 
 #include <memory>
 #include <functional>
+#include <vector>
 #include "models/base_model.h"
+#include "models/shared_data.h"
+#include "models/omrf/omrf_gpu_backend.h"
+#include "math/compact_scores.h"
+#include "mcmc/samplers/delayed_acceptance.h"
+#include "mcmc/samplers/informed_edge_schedule.h"
 #include "mcmc/samplers/metropolis_adaptation.h"
 #include "rng/rng_utils.h"
 #include "mcmc/execution/step_result.h"
 #include "utils/common_helpers.h"
 #include "utils/variable_helpers.h"
+#include "utils/variable_kernels.h"
 #include "priors/parameter_prior.h"
 
 /**
@@ -53,6 +60,24 @@ public:
         bool edge_selection
     );
 
+    /**
+     * Constructor from packed scores, Blume-Capel columns already centered
+     * at their baseline category: for instance a memory-mapped score file
+     * (see MappedScoreFile), which is read in place. The other parameters
+     * are as above.
+     */
+    OMRFModel(
+        CompactScores observations,
+        const arma::ivec& num_categories,
+        const arma::mat& inclusion_probability,
+        const arma::imat& initial_edge_indicators,
+        const arma::uvec& is_ordinal_variable,
+        const arma::ivec& baseline_category,
+        std::unique_ptr<BaseParameterPrior> interaction_prior,
+        std::unique_ptr<BaseParameterPrior> threshold_prior,
+        bool edge_selection
+    );
+
     /**
      * Copy constructor for cloning (required for parallel chains)
      */
@@ -64,6 +89,8 @@ public:
 
     /** @return true when edge selection is enabled. */
     bool has_edge_selection() const override { return edge_selection_; }
+    /** @return true: edge toggles are reported to the edge prior. */
+    bool reports_edge_changes() const override { return true; }
     /** @return true when missing-data imputation is active. */
     bool has_missing_data() const override { return has_missing_; }
 
@@ -72,12 +99,47 @@ public:
      */
     std::pair<double, arma::vec> logp_and_gradient(const arma::vec& parameters) override;
 
+    /**
+     * logp_and_gradient() of several OMRF chains at once. When every model
+     * shares this model's observations and evaluates its gradient on the
+     * host over all rows, the residual scores of all chains come from one
+     * product X [P_1 ... P_B], and their pairwise gradients from one
+     * product X^T [E_1 ... E_B] of the expected scores, so the data are
+     * streamed twice for the batch instead of twice per chain. Otherwise
+     * every model is evaluated on its own. The per-variable moments are
+     * those of logp_and_gradient(); only the rounding of the two products
+     * differs.
+     */
+    void logp_and_gradient_batch(
+        const std::vector<BaseModel*>& models,
+        const std::vector<arma::vec>& parameters,
+        std::vector<std::pair<double, arma::vec>>& results) override;
+
+    bool supports_batched_gradient() const override { return true; }
+
     /**
      * Perform one adaptive Metropolis step (updates all parameters)
      * @param iteration  Current iteration (for Robbins-Monro adaptation)
      */
     void do_one_metropolis_step(int iteration = -1) override;
 
+    /**
+     * @return true when every variable is binary and both priors have a
+     *         Gaussian augmentation (see BaseParameterPrior).
+     */
+    bool supports_polya_gamma() const override;
+
+    /**
+     * One Pólya-Gamma Gibbs sweep. Draws omega_iv ~ PG(1, main_v + r_iv)
+     * for every person and variable, on one lane stream per variable, and
+     * the latent variables of the priors; the pseudolikelihood is then
+     * Gaussian in the parameters, and each variable's main effect and the
+     * pairwise effects of its included edges are drawn jointly from their
+     * full conditional, variable by variable. Not for compressed patterns,
+     * subsampling or a tempered pseudolikelihood.
+     */
+    void do_one_polya_gamma_step() override;
+
     /**
      * @return Mean Metropolis acceptance probability over the most recent
      *         do_one_metropolis_step() sweep. NaN before the first step.
@@ -96,6 +158,14 @@ public:
         target_accept_ = target;
     }
 
+    /**
+     * Set the number of threads used by logp_and_gradient(). Variables are
+     * split into contiguous blocks that are evaluated in parallel; the
+     * per-variable results are reduced in variable order, so the value and
+     * gradient are bit-identical for every thread count.
+     */
+    void set_gradient_threads(int num_threads) override;
+
     /**
      * Initialize Metropolis adaptation controllers for proposal-SD tuning
      * Must be called before warmup begins (e.g., by MetropolisSampler on first step)
@@ -114,9 +184,9 @@ public:
     size_t parameter_dimension() const override;
 
     /**
-     * Set random seed for reproducibility
+     * Replace the random number generator
      */
-    void set_seed(int seed) override;
+    void set_rng(const SafeRNG& rng) override;
 
     /**
      * Get vectorized parameters (main effects + active pairwise effects)
@@ -133,14 +203,66 @@ public:
      */
     arma::ivec get_vectorized_indicator_parameters() override;
 
+    /**
+     * Pack edge indicators (same order) without building the vector
+     */
+    void pack_indicator_parameters(IndicatorBitWriter& out) override;
+
     /**
      * Clone the model for parallel execution.
      */
     std::unique_ptr<BaseModel> clone() const override;
 
+    /** Give this clone its own copy of the observations. */
+    void replicate_shared_data() override { data_.detach(); }
+
+    /**
+     * Append observation rows (raw category scores, Blume-Capel columns not
+     * yet centered). Adds their category counts, Blume-Capel sums and
+     * X'X contribution, and computes their residual rows; the existing
+     * rows are not revisited. Not for compressed patterns, missing-data
+     * imputation or subsampling.
+     *
+     * @throws std::invalid_argument on a wrong column count or a score
+     *         outside a variable's range
+     */
+    void append_observations(const arma::imat& rows) override;
+
+    /**
+     * Drop observation rows, subtracting their contribution from the
+     * sufficient statistics. Same restrictions as append_observations().
+     *
+     * @throws std::invalid_argument on an out-of-range or repeated row
+     */
+    void remove_observations(const arma::uvec& rows) override;
+
+    /** Append `rows`, sharing the data block `updated` appended them to. */
+    void append_observations(const arma::imat& rows, const BaseModel& updated) override;
+
+    /** Drop `rows`, sharing the data block `updated` dropped them from. */
+    void remove_observations(const arma::uvec& rows, const BaseModel& updated) override;
+
     /** @return Reference to the model's random number generator. */
     SafeRNG& get_rng() override { return rng_; }
 
+    /**
+     * Save main and pairwise effects, edge indicators, inclusion
+     * probabilities and proposal SDs.
+     */
+    void save_state(SamplerState& state) const override;
+
+    /**
+     * Restore a save_state() state; rebuilds the residual matrix and the
+     * active-neighbour lists.
+     */
+    void restore_state(const SamplerState& state) override;
+
+    /** Save main and pairwise effects, edge indicators and inclusion probabilities. */
+    void save_position(SamplerState& state) const override;
+
+    /** Restore a save_position() state; the proposal SDs, surrogate, blocks and informed rates stay. */
+    void restore_position(const SamplerState& state) override;
+
     // =========================================================================
     // OMRF-specific methods
     // =========================================================================
@@ -156,20 +278,157 @@ public:
     void prepare_iteration() override;
 
     /**
-     * Update edge indicators via Metropolis-Hastings
+     * Update edge indicators via Metropolis-Hastings, one pair at a time in
+     * shuffled order, or matching by matching (see
+     * set_matching_edge_updates()).
      */
     void update_edge_indicators() override;
 
+    /**
+     * Update the edge indicators of pairs without a shared variable
+     * concurrently, on the gradient threads.
+     *
+     * An edge move of (i, j) reads and writes only the residual columns
+     * and log-normalizers of i and j, so the moves of pairs without a
+     * shared variable commute. Each pair goes into the first matching after
+     * those of the earlier pairs (in the shuffled order) that share one of
+     * its variables; scanning the matchings in order is then the same scan
+     * as pair by pair. The proposals and uniforms of all pairs are drawn up
+     * front, so the draws do not depend on the number of threads, but they
+     * differ from the pair-by-pair schedule for the same seed.
+     */
+    void set_matching_edge_updates(bool enabled) { matching_edge_updates_ = enabled; }
+
+    /**
+     * Draw the pairs of each sampling sweep of the edge indicators in
+     * proportion to how often their flips were accepted in warmup (see
+     * InformedEdgeSchedule), instead of visiting every pair once. The
+     * warmup sweeps are sequential and teach the weights.
+     */
+    void set_informed_edge_updates(bool enabled) {
+        informed_edges_.enabled = enabled;
+        informed_edges_.resize(enabled ? num_pairwise_ : 0);
+    }
+
+    /**
+     * Screen the pairwise and edge-indicator proposals with a quadratic
+     * surrogate before paying for the exact ratio (see DelayedAcceptance).
+     * The surrogate gradient comes from the expected scores of the two
+     * variables at the current state, cached with their log-normalizers,
+     * so a proposal rejected at the first stage costs two dot products
+     * instead of two log-normalizer sums. Not used with subsampling, by
+     * the matching edge updates, or by the stage-3b tuning sweeps.
+     */
+    void set_delayed_acceptance(bool enabled);
+
+    /**
+     * Update the main effects of a variable (all thresholds, or both
+     * Blume-Capel parameters) in one joint Metropolis move of
+     * do_one_metropolis_step(), with a proposal covariance learned in
+     * warmup (see BlockMetropolisAdaptation). The current log-normalizer
+     * is cached, so a variable costs one log-normalizer sum per sweep
+     * instead of two per parameter.
+     */
+    void set_block_main_effects(bool enabled);
+
+    /**
+     * Move the parameters to the mode of the log-pseudoposterior by L-BFGS
+     * on logp_and_gradient(), before warmup. The inverse of the curvature
+     * there (finite differences of the gradient, one gradient per
+     * parameter) seeds the NUTS/HMC inverse mass diagonal through
+     * initial_inv_mass(), and 2.4 times its square root the Metropolis
+     * proposal SDs. Excluded edges stay at zero.
+     */
+    void initialize_from_pseudo_mle();
+
     /**
      * Impute missing values (if any)
+     *
+     * Visits the variables in order and redraws all missing cells of one
+     * variable as a block: given the other variables those cells are
+     * independent, so this is the same Gibbs scan as one cell at a time
+     * (missing_index_ lists the cells variable by variable). Category
+     * weights use the vectorized exp, uniforms come from one bulk fill, and
+     * the residuals of the changed rows are updated in one rank-one step.
      */
     void impute_missing() override;
 
+    /** @return true: the pseudolikelihood can be tempered. */
+    bool supports_tempering() const override { return true; }
+
+    /**
+     * Temper the pseudolikelihood in the Metropolis, edge-indicator and
+     * gradient updates by `beta`; the threshold and interaction priors and
+     * the edge-inclusion odds stay untempered.
+     */
+    void set_temperature(double beta) override { inverse_temperature_ = beta; }
+
+    /**
+     * @return Sum over variables of the log conditional likelihoods at the
+     *         current state (temperature 1)
+     */
+    double log_pseudolikelihood() const override;
+
+    /** Replicate of the scores from simulate_mrf() at the current parameters. */
+    void simulate_replicate(int num_states, int gibbs_iter, SafeRNG& rng, arma::mat& out) override;
+
     /**
      * Set missing data information
      */
     void set_missing_data(const arma::imat& missing_index);
 
+    /**
+     * Collapse identical observation rows into unique response patterns
+     * with multiplicity weights, so the pseudolikelihood costs scale with
+     * the number of patterns instead of n. Rows with missing entries stay
+     * separate so they can be imputed individually; call after
+     * set_missing_data().
+     */
+    void compress_patterns();
+
+    /**
+     * Estimate the pseudolikelihood from a random subset of the rows.
+     *
+     * Each iteration draws `batch_size` rows without replacement, and
+     * every log-normalizer sum over the rows becomes the control-variate
+     * estimate
+     *
+     *   sum_i t_i(theta) ~ sum_i t_i(theta_ref)
+     *                      + (n / m) sum_{i in batch} (t_i(theta) - t_i(theta_ref)),
+     *
+     * unbiased for any reference state theta_ref. Its variance is small
+     * while theta stays near theta_ref, so the reference moves to the
+     * current state every `refresh_every` iterations, at the cost of one
+     * full pass. The Metropolis updates and logp_and_gradient() both use
+     * the estimate; the residual columns are still kept for all rows.
+     * A `batch_size` of 0 or at least n keeps the exact pseudolikelihood.
+     * Not for compressed patterns or missing-data imputation.
+     */
+    void set_subsampling(int batch_size, int refresh_every);
+
+    bool uses_subsampling() const override {
+        return subsample_size_ > 0 && static_cast<size_t>(subsample_size_) < n_;
+    }
+
+    /**
+     * Where logp_and_gradient() evaluates the data part of the gradient:
+     * "cpu" (default) or "gpu" (see OMRFGpuBackend). The GPU backend keeps
+     * the scores on the device and replaces the per-variable normalizers
+     * and X^T E; the priors, the Metropolis updates and the residual
+     * matrix stay on the host. Each chain's clone gets its own device
+     * buffers and shares the device scores. Not for compressed patterns,
+     * missing-data imputation or subsampling, and the data cannot be
+     * updated afterwards.
+     */
+    void set_gradient_backend(const std::string& backend);
+
+    /**
+     * Variance of the subsampled log-pseudolikelihood at the current state,
+     * n^2 (1 - m/n) s^2 / m, with s^2 the batch variance of the row
+     * differences sum_v (t_iv(theta) - t_iv(theta_ref)).
+     */
+    double subsample_variance() const override;
+
     // =========================================================================
     // Accessors
     // =========================================================================
@@ -184,22 +443,33 @@ public:
     arma::mat& get_inclusion_probability() override { return inclusion_probability_; }
     /** @return Residual matrix X * pairwise_effects (n x p). */
     const arma::mat& get_residual_matrix() const { return residual_matrix_; }
+    /** @return Per-variable log-normalizer sums at the current state (stale cache entries are recomputed). */
+    arma::vec get_log_normalizers() const;
 
     /**
      * Replace all main-effect parameters.
      * @param main_effects  New main-effect matrix (p x max_cats)
      */
-    void set_main_effects(const arma::mat& main_effects) { main_effects_ = main_effects; }
+    void set_main_effects(const arma::mat& main_effects) {
+        main_effects_ = main_effects;
+        invalidate_log_normalizers();
+    }
     /**
      * Replace all pairwise effects and update residuals.
      * @param pairwise_effects  New pairwise interaction matrix (p x p)
      */
     void set_pairwise_effects(const arma::mat& pairwise_effects);
     /**
-     * Replace all edge indicators.
+     * Replace all edge indicators and rebuild the active-neighbour lists.
      * @param edge_indicators  New edge-indicator matrix (p x p)
      */
-    void set_edge_indicators(const arma::imat& edge_indicators) { edge_indicators_ = edge_indicators; }
+    void set_edge_indicators(const arma::imat& edge_indicators);
+    /**
+     * Set the edge density above which logp_and_gradient uses the dense
+     * X^T E product instead of per-neighbour dot products.
+     * @param density  Fraction of included edges in [0, 1]
+     */
+    void set_sparse_gradient_max_density(double density) { sparse_gradient_max_density_ = density; }
 
     /** @return Number of variables (p) as int. */
     int get_num_variables() const override { return static_cast<int>(p_); }
@@ -207,7 +477,7 @@ public:
     int get_num_pairwise() const override { return static_cast<int>(num_pairwise_); }
     /** @return Number of variables (p). */
     size_t num_variables() const { return p_; }
-    /** @return Number of observations (n). */
+    /** @return Number of stored rows (unique response patterns after compress_patterns()). */
     size_t num_observations() const { return n_; }
     /** @return Total number of main-effect parameters across all variables. */
     size_t num_main_effects() const { return num_main_; }
@@ -226,6 +496,8 @@ public:
     void set_inv_mass(const arma::vec& inv_mass) override { inv_mass_ = inv_mass; }
     /** @return Current inverse mass matrix diagonal. */
     const arma::vec& get_inv_mass() const override { return inv_mass_; }
+    /** @return Inverse mass set by initialize_from_pseudo_mle(), or empty. */
+    arma::vec initial_inv_mass() const override { return initial_inv_mass_; }
 
     /**
      * Get full dimension (main + ALL pairwise, regardless of edge indicators)
@@ -248,7 +520,10 @@ public:
      * Set per-pair scaling factors for the Cauchy prior.
      * @param sf  Scaling factor matrix (p x p)
      */
-    void set_pairwise_scaling_factors(const arma::mat& sf) { pairwise_scaling_factors_ = sf; }
+    void set_pairwise_scaling_factors(const arma::mat& sf) {
+        pairwise_scaling_factors_ = sf;
+        invalidate_gradient_cache();
+    }
 
     /**
      * Enable or disable edge-selection proposals.
@@ -275,9 +550,13 @@ private:
     // Data
     size_t n_;                          ///< Number of observations
     size_t p_;                          ///< Number of variables
-    arma::imat observations_;           ///< Categorical observations (n x p)
-    arma::mat observations_double_;     ///< Observations as double (for efficient matrix ops)
-    arma::mat observations_double_t_;   ///< Transposed observations (for BLAS pairwise gradient)
+    /// Observations, shared by the chain clones (copied only to impute)
+    struct ObservationData {
+        CompactScores observations;      ///< Category scores (n x p), BC columns centered
+        arma::vec pattern_weights;       ///< Multiplicity of each row after compress_patterns()
+    };
+    SharedData<ObservationData> data_;
+    bool pattern_compressed_ = false;   ///< Rows are unique response patterns with weights
     arma::ivec num_categories_;         ///< Categories per variable
     arma::uvec is_ordinal_variable_;    ///< 1 = ordinal, 0 = Blume-Capel
     arma::ivec baseline_category_;      ///< Reference category for Blume-Capel
@@ -287,6 +566,7 @@ private:
     arma::imat blume_capel_stats_;      ///< [linear_sum, quadratic_sum] for BC vars (2 x p)
     arma::imat pairwise_stats_;         ///< X^T X
     arma::mat residual_matrix_;         ///< X * pairwise_effects (n x p)
+    mutable arma::mat residual_panel_;  ///< Widened rows of X for the X * pairwise products
 
     // Parameters
     arma::mat main_effects_;            ///< Main effect parameters (p x max_cats)
@@ -301,6 +581,8 @@ private:
 
     // Model configuration
     bool edge_selection_;               ///< Enable edge selection
+    double inverse_temperature_ = 1.0;  ///< Power of the pseudolikelihood (tempered replicas)
+    bool matching_edge_updates_ = false; ///< Update the edge indicators matching by matching
     bool edge_selection_active_;        ///< Currently in edge selection phase
 
     // Dimension tracking
@@ -314,6 +596,7 @@ private:
     // Metropolis adaptation controllers (created by init_metropolis_adaptation)
     std::unique_ptr<MetropolisAdaptationController> metropolis_main_adapter_;      ///< Main-effect adapter
     std::unique_ptr<MetropolisAdaptationController> metropolis_pairwise_adapter_;  ///< Pairwise-effect adapter
+    BlockMetropolisAdaptation block_main_;  ///< Joint main-effect proposals (set_block_main_effects)
 
     // RNG
     SafeRNG rng_;                       ///< Per-chain random number generator
@@ -321,26 +604,121 @@ private:
     // NUTS settings
     double step_size_;                  ///< Current step size for gradient-based samplers
     arma::vec inv_mass_;                ///< Inverse mass diagonal
+    arma::vec initial_inv_mass_;        ///< Inverse curvature at the pseudo-MLE (empty = identity)
 
     // Missing data handling
     bool has_missing_;                  ///< Whether the data contains missing values
     arma::imat missing_index_;          ///< (row, col) indices of missing entries
+    std::vector<arma::uvec> missing_persons_; ///< Rows with a missing entry, per variable, in missing_index_ order
+    arma::mat impute_weights_;          ///< Cumulative category weights, one column per missing cell
+    arma::vec impute_uniforms_;         ///< Uniforms for one variable's missing cells
+    arma::uvec impute_draws_;           ///< Sampled category of each missing cell
 
     // Cached gradient components
     arma::vec grad_obs_cache_;          ///< Cached observed-data gradient
+    arma::vec active_scaling_factors_;  ///< Prior scale factors of the active pairwise effects
     arma::imat index_matrix_cache_;     ///< Cached parameter index map
     bool gradient_cache_valid_;         ///< Whether the gradient cache is current
 
-    // Per-chain scratch for compute_logZ_and_probs_*_into. Reused across
-    // every call to logp_and_gradient and across every variable inside it.
-    // After the first few calls the buffers stabilise at max size and no
-    // further heap allocations happen on the hot path.
-    mutable LogZAndProbs logz_out_;
-    mutable LogZScratch  logz_scratch_;
+    // Per-block scratch for compute_logZ_and_probs_*_into, one entry per
+    // gradient thread. Reused across every call to logp_and_gradient and
+    // across every variable inside a block. After the first few calls the
+    // buffers stabilise at max size and no further heap allocations happen
+    // on the hot path.
+    mutable std::vector<LogZWorkspace> logz_workspaces_;
+
+    // Scratch arenas of the matching edge sweep, one per gradient thread:
+    // its threads evaluate edge moves at the same time, so they cannot
+    // share the chain's arena.
+    mutable std::vector<ScratchArena> matching_arenas_;
+
+    // Within-chain gradient parallelism (set via set_gradient_threads)
+    int gradient_threads_ = 1;          ///< Threads used by logp_and_gradient
+    std::vector<int> main_offsets_;     ///< Offset of each variable's main effects in the parameter vector
+    std::vector<LogZKernels> logz_kernels_; ///< Log-normalizer kernels per variable, by category count
+    arma::vec logz_sum_buffer_;         ///< Per-variable sum of log-normalizers (p)
+    arma::mat pairwise_grad_buffer_;    ///< Per-variable X^T E columns (p x p)
+
+    // Buffers of logp_and_gradient_batch(), on the model it is called on:
+    // chain k owns columns k p to (k + 1) p - 1 of each.
+    arma::mat lockstep_pairwise_;       ///< Pairwise effects of every chain (p x B p)
+    arma::mat lockstep_residual_;       ///< Residual scores of every chain (n x B p)
+    arma::mat lockstep_expected_;       ///< Expected scores of every chain (n x B p)
+    arma::mat lockstep_cross_;          ///< X^T E of every chain (p x B p)
+    arma::mat lockstep_panel_;          ///< Widened rows of X for the X^T E product
+
+    // Active set for the pairwise gradient. With few included edges the
+    // gradient takes one dot product per included neighbour instead of the
+    // full p x n by n product; above the density threshold it uses BLAS.
+    std::vector<std::vector<int>> active_neighbours_; ///< Included neighbours per variable (ascending)
+    size_t num_active_edges_ = 0;       ///< Number of included edges
+    double sparse_gradient_max_density_ = 0.3; ///< Max edge density for the sparse path
+    bool use_sparse_gradient_ = false;  ///< Path chosen for the current logp_and_gradient call
+
+    // Per-variable sum over persons of the current log-normalizer,
+    // sum_i (bound_i + log denom_i), kept in step with residual_matrix_ and
+    // main_effects_ so pairwise and edge-indicator proposals only evaluate
+    // the proposed side. Entries are recomputed lazily when invalidated.
+    mutable arma::vec log_normalizer_;          ///< Cached current log-normalizer sums (p)
+    mutable arma::uvec log_normalizer_valid_;   ///< 1 = log_normalizer_ entry is current
+    // Most recent proposed-side evaluation per variable: the partner
+    // variable and delta it was computed for, and its value. Adopted by
+    // update_residual_columns() when the same move is accepted.
+    mutable arma::ivec pending_partner_;        ///< Partner variable of the pending value (-1 = none)
+    mutable arma::vec pending_delta_;           ///< Pairwise delta of the pending value
+    mutable arma::vec pending_log_normalizer_;  ///< Pending proposed log-normalizer sums (p)
+
+    // Delayed acceptance (set_delayed_acceptance). The expected scores E of
+    // each variable live next to its log-normalizer: valid only while the
+    // log-normalizer is, and adopted from the pending evaluation the same way.
+    DelayedAcceptance delayed_acceptance_;
+    mutable std::vector<arma::vec> expected_score_;          ///< Current E per variable
+    mutable arma::uvec expected_score_valid_;                ///< 1 = expected_score_ entry is current
+    mutable std::vector<arma::vec> pending_expected_score_;  ///< E of the pending evaluation
+    mutable arma::uvec pending_expected_valid_;              ///< 1 = pending value came with E
 
     // Interaction indexing (for edge updates)
     arma::imat interaction_index_;      ///< Maps edge pair to index
     arma::uvec shuffled_edge_order_;    ///< Pre-shuffled order (set in prepare_iteration)
+    InformedEdgeSchedule informed_edges_;  ///< Learned pair weights (set_informed_edge_updates)
+
+    // Subsampled pseudolikelihood (set_subsampling). Rows of the batch
+    // matrices follow batch_rows_; the reference moments for the gradient
+    // are filled by the first logp_and_gradient call on a batch.
+    int subsample_size_ = 0;            ///< Rows per batch (0 = exact)
+    int subsample_refresh_ = 100;       ///< Iterations between reference refreshes
+    int subsample_iteration_ = 0;       ///< Iterations since the first batch
+    arma::uvec row_pool_;               ///< Row permutation, partially reshuffled per batch
+    arma::uvec batch_rows_;             ///< Rows of the current batch (ascending; empty = exact)
+    arma::mat batch_observations_;      ///< Scores of the batch rows (m x p)
+    arma::mat reference_main_;          ///< Main effects at the reference state
+    arma::mat reference_pairwise_;      ///< Pairwise effects at the reference state
+    arma::vec reference_log_z_;         ///< Full-data log-normalizer sums at the reference (p)
+    arma::mat reference_prob_sums_;     ///< Full-data category probability sums at the reference (max_cats+1 x p)
+    arma::mat reference_cross_;         ///< Full-data X^T E at the reference, one column per variable (p x p)
+    arma::mat batch_reference_residual_; ///< Residual scores of the batch at the reference (m x p)
+    arma::mat batch_reference_log_z_;   ///< Per-row log-normalizers of the batch at the reference (m x p)
+    arma::vec batch_reference_log_z_sum_; ///< Column sums of batch_reference_log_z_ (p)
+    arma::mat batch_reference_prob_sums_; ///< Batch probability sums at the reference (max_cats+1 x p)
+    arma::mat batch_reference_cross_;   ///< Batch X^T E at the reference (p x p)
+    bool batch_reference_moments_valid_ = false; ///< Batch reference moments are filled
+
+    // Device evaluation of the gradient (set_gradient_backend)
+    std::unique_ptr<OMRFGpuBackend> gpu_backend_;  ///< Null on the CPU backend
+    arma::mat gpu_prob_sums_;           ///< Category probability sums from the device (max_cats+1 x p)
+
+    // Scratch of the matching edge schedule (update_edge_indicators_by_matching)
+    arma::vec edge_normals_;            ///< Standard-normal proposal draw per pair, in scan order
+    arma::vec edge_uniforms_;           ///< Acceptance uniform per pair, in scan order
+    std::vector<int> variable_level_;   ///< Next matching each variable may join
+    std::vector<int> edge_level_;       ///< Matching of each scan position
+    std::vector<int> matching_start_;   ///< Offset of each matching in matching_pairs_
+    std::vector<int> matching_pairs_;   ///< Scan positions, grouped by matching
+    std::vector<char> edge_flipped_;    ///< Whether the move at a scan position was accepted
+
+    // Lane streams of the Pólya-Gamma draws, one per variable, seeded from
+    // rng_ in variable order at the start of every sweep
+    std::vector<XoshiroLanes> omega_streams_;
 
     // =========================================================================
     // Private helper methods
@@ -351,6 +729,50 @@ private:
      */
     void compute_sufficient_statistics();
 
+    /**
+     * Add (sign = 1) or subtract (sign = -1) the sufficient statistics of
+     * centered observation rows.
+     */
+    void accumulate_sufficient_statistics(const arma::imat& centered_rows, int sign);
+
+    /**
+     * Refuse a data update the model cannot apply row by row.
+     */
+    void check_data_update_supported() const;
+
+    /**
+     * Check new observation rows and center their Blume-Capel columns.
+     */
+    arma::imat center_new_observations(const arma::imat& rows) const;
+
+    /**
+     * Add the sufficient statistics and residual rows of centered new
+     * rows; the data block itself is left to the caller.
+     */
+    void add_observation_state(const arma::imat& centered);
+
+    /**
+     * Check rows to drop and return the rows that remain.
+     */
+    arma::uvec observations_to_keep(const arma::uvec& rows) const;
+
+    /**
+     * Subtract the sufficient statistics of the dropped rows and keep the
+     * residual rows `keep`; reads the rows from the current data block.
+     */
+    void drop_observation_state(const arma::uvec& rows, const arma::uvec& keep);
+
+    /**
+     * The OMRF clone another chain updated, checked to hold `n` rows.
+     */
+    const OMRFModel& updated_clone(const BaseModel& updated, size_t n) const;
+
+    /**
+     * Drop every cache that sums over the observations (log-normalizers,
+     * expected scores, pending evaluations, the gradient cache).
+     */
+    void invalidate_data_caches();
+
     /**
      * Count total number of main effect parameters
      */
@@ -367,10 +789,147 @@ private:
     void update_residual_matrix();
 
     /**
-     * Incrementally update two residual columns after a single pairwise effect change
+     * Group the missing persons of missing_index_ by variable into missing_persons_
+     */
+    void group_missing_by_variable();
+
+    /**
+     * Incrementally update two residual columns after a single pairwise effect
+     * change. The cached log-normalizers of var1 and var2 take over the
+     * pending proposed values when they were evaluated for this same move,
+     * and are invalidated otherwise.
      */
     void update_residual_columns(int var1, int var2, double delta);
 
+    /**
+     * Mark every cached log-normalizer as stale
+     */
+    void invalidate_log_normalizers() const {
+        log_normalizer_valid_.zeros();
+        expected_score_valid_.zeros();
+    }
+
+    /**
+     * Sum over persons of a variable's log-normalizer for a given residual
+     * score vector and the current main effects.
+     *
+     * The log-normalizer functions below take scratch memory from `arena`
+     * (nullptr = the chain's arena); the threads of the matching edge sweep
+     * pass arenas of their own.
+     */
+    double log_normalizer_sum(int variable, const arma::vec& residual_score,
+                              ScratchArena* arena = nullptr) const;
+
+    /**
+     * Per-person log-normalizers of a variable, bound + log(denom), for a
+     * residual score vector and the main effects `main_effects`.
+     */
+    arma::vec log_normalizer_terms(int variable, const arma::vec& residual_score,
+                                   const arma::mat& main_effects) const;
+
+    /**
+     * Log-normalizer sum of a variable's current residual column: exact, or
+     * the subsampled estimate (see set_subsampling()).
+     */
+    double column_log_normalizer(int variable, ScratchArena* arena = nullptr) const;
+
+    /**
+     * Control-variate estimate of a variable's log-normalizer sum from the
+     * residual scores of the batch rows.
+     */
+    double subsampled_log_normalizer(int variable, const arma::vec& batch_residual) const;
+
+    /** @return The batch rows of a variable's current residual column. */
+    arma::vec batch_residual(int variable) const;
+
+    /**
+     * Move the reference to the current state: full-data log-normalizer
+     * sums, probability sums and X^T E columns, in one pass over the rows.
+     */
+    void refresh_subsample_reference();
+
+    /**
+     * Draw the rows of the next batch and evaluate the reference on them.
+     */
+    void draw_subsample_batch();
+
+    /**
+     * Batch probability sums and X^T E at the reference, for the
+     * control variates of the gradient.
+     */
+    void compute_batch_reference_moments(int variable, LogZWorkspace& workspace);
+
+    /**
+     * Log-normalizer moments of a variable (log_Z_sum, prob_sums, E) into
+     * `workspace.moments`, for a residual score vector and main effects.
+     */
+    void compute_variable_moments(
+        int variable,
+        const arma::mat& main_effects,
+        const arma::vec& residual_score,
+        LogZWorkspace& workspace,
+        const arma::vec* weights
+    ) const;
+
+    /**
+     * Cached log-normalizer sum at the current state (recomputed if stale)
+     */
+    double current_log_normalizer(int variable, ScratchArena* arena = nullptr) const;
+
+    /**
+     * Log-normalizer sum after changing pairwise effect (variable, partner)
+     * by delta. Recorded as the variable's pending value.
+     */
+    double proposed_log_normalizer(int variable, int partner, double delta,
+                                   ScratchArena* arena = nullptr) const;
+
+    /**
+     * Expected scores E of a variable at the current state (recomputed,
+     * with the log-normalizer if that is stale too, from the moments kernel)
+     */
+    const arma::vec& current_expected_score(int variable) const;
+
+    /**
+     * proposed_log_normalizer() from the moments kernel, which also records
+     * the expected scores of the proposed state with the pending value.
+     */
+    double proposed_log_normalizer_and_score(int variable, int partner, double delta) const;
+
+    /**
+     * Derivative of the log-pseudolikelihood in pairwise effect (var1, var2)
+     * given the expected scores of both variables:
+     * 4 s_12 - 2 x_2'E_1 - 2 x_1'E_2.
+     */
+    double pairwise_log_likelihood_gradient(int var1, int var2, const arma::vec& score1,
+                                            const arma::vec& score2) const;
+
+    /** @return Whether the pairwise and edge moves use delayed acceptance now. */
+    bool uses_delayed_acceptance() const {
+        return delayed_acceptance_.enabled && batch_rows_.is_empty();
+    }
+
+    /**
+     * Two-stage test of moving pairwise effect (var1, var2) by `delta`.
+     * `log_other` holds the log prior, proposal and inclusion-odds terms of
+     * the move. Sets `accept_prob` to the second-stage acceptance
+     * probability, or 0 when the first stage rejects, so its mean is the
+     * overall acceptance rate.
+     *
+     * @return Whether the move is accepted
+     */
+    bool delayed_acceptance_test(int var1, int var2, double delta, double log_other,
+                                 double& accept_prob);
+
+    /**
+     * Rebuild active_neighbours_ and num_active_edges_ from edge_indicators_
+     */
+    void rebuild_active_neighbours();
+
+    /**
+     * Add or remove edge (var1, var2) in the active-neighbour lists
+     */
+    void set_active_edge(int var1, int var2, bool included);
+
     /**
      * Invalidate gradient cache (call after parameter changes)
      */
@@ -381,6 +940,55 @@ private:
      */
     void ensure_gradient_cache();
 
+    /**
+     * Per-variable part of logp_and_gradient: log-normalizer, main-effect
+     * expected statistics and the X^T E column for the pairwise gradient.
+     * Writes only to the variable's own main-effect gradient slots and
+     * buffer entries, so distinct variables can run concurrently.
+     */
+    void accumulate_variable_gradient(
+        int variable,
+        const arma::mat& temp_main,
+        const arma::mat& temp_residual,
+        LogZWorkspace& workspace,
+        arma::vec& gradient,
+        double* expected = nullptr
+    );
+
+    /**
+     * The parts of a logp_and_gradient() evaluation that do not pass over
+     * the observations, kept while the per-variable moments are summed.
+     */
+    struct GradientTerms {
+        double log_pp = 0.0;           ///< Log-prior plus the sufficient-statistic terms
+        double log_prior = 0.0;        ///< Log-prior of the parameters
+        arma::vec gradient;            ///< Observed statistics; the moments subtract from it
+        arma::vec main_prior_grad;     ///< Prior gradient of the main effects
+        arma::vec pairwise_prior_grad; ///< Prior gradient of the active pairwise effects
+        arma::uword num_active = 0;    ///< Number of active pairwise effects
+    };
+
+    /**
+     * Priors and sufficient-statistic terms of logp_and_gradient() at the
+     * unpacked parameters. Needs a valid gradient cache.
+     */
+    GradientTerms gradient_terms(const arma::vec& parameters, const arma::mat& temp_main,
+                                 const arma::mat& temp_pairwise) const;
+
+    /**
+     * Finish a logp_and_gradient() evaluation from its terms and the
+     * per-variable sums in logz_sum_buffer_ and pairwise_grad_buffer_:
+     * log-normalizers, pairwise gradient, tempering and prior gradients.
+     */
+    std::pair<double, arma::vec> finish_gradient(GradientTerms& terms) const;
+
+    /**
+     * Subtract the expected main-effect statistics of a variable, from its
+     * summed category probabilities, from its gradient slots.
+     */
+    void subtract_expected_main_statistics(int variable, const arma::vec& prob_sums,
+                                           arma::vec& gradient) const;
+
     // -------------------------------------------------------------------------
     // Log-posterior components
     // -------------------------------------------------------------------------
@@ -391,13 +999,14 @@ private:
     double log_pseudoposterior_main_component(int variable, int category, int parameter) const;
 
     /**
-     * Log-likelihood ratio for variable update
+     * Log-likelihood ratio for variable update: current minus proposed
+     * log-normalizer after changing pairwise effect (variable, partner) by delta
      */
     double compute_log_likelihood_ratio_for_variable(
         int variable,
-        const arma::ivec& interacting_score,
-        double proposed_state,
-        double current_state
+        int partner,
+        double delta,
+        ScratchArena* arena = nullptr
     ) const;
 
     /**
@@ -407,7 +1016,8 @@ private:
         int variable1,
         int variable2,
         double proposed_state,
-        double current_state
+        double current_state,
+        ScratchArena* arena = nullptr
     ) const;
 
     /**
@@ -416,6 +1026,17 @@ private:
      */
     double log_pseudoposterior_pairwise_at_delta(int var1, int var2, double delta) const;
 
+    /**
+     * Temper a log-pseudoposterior: scale its pseudolikelihood part by
+     * inverse_temperature_. Returns `log_posterior` itself at temperature 1.
+     * @param log_posterior  Untempered log-pseudoposterior
+     * @param log_prior      Its prior part
+     */
+    double tempered(double log_posterior, double log_prior) const {
+        if (inverse_temperature_ == 1.0) return log_posterior;
+        return inverse_temperature_ * (log_posterior - log_prior) + log_prior;
+    }
+
     // -------------------------------------------------------------------------
     // Parameter vectorization
     // -------------------------------------------------------------------------
@@ -446,6 +1067,16 @@ private:
         arma::mat& temp_residual
     ) const;
 
+    /**
+     * Unvectorize a parameter vector into temporary main/pairwise matrices
+     * only.
+     */
+    void unvectorize_to_temps(
+        const arma::vec& parameters,
+        arma::mat& temp_main,
+        arma::mat& temp_pairwise
+    ) const;
+
     /**
      * Extract active inverse mass (only for included edges)
      */
@@ -456,6 +1087,12 @@ private:
      */
     void get_active_inv_mass_into(arma::vec& active_inv_mass) const;
 
+    /**
+     * Full-vector positions of the active parameters (main effects, then
+     * included edges)
+     */
+    arma::uvec get_active_parameter_indices() const override;
+
     // -------------------------------------------------------------------------
     // Metropolis updates
     // -------------------------------------------------------------------------
@@ -466,6 +1103,29 @@ private:
      */
     double update_main_effect_parameter(int variable, int category, int parameter);
 
+    /**
+     * Update all main effects of a variable jointly via Metropolis
+     * (set_block_main_effects)
+     * @param iteration  Warmup iteration, for the proposal adaptation
+     * @return acceptance probability
+     */
+    double update_main_effect_block(int variable, int iteration);
+
+    /**
+     * Draw the main effect of a binary variable and the pairwise effects of
+     * its included edges from their Gaussian full conditional given the
+     * Pólya-Gamma draws (see do_one_polya_gamma_step()).
+     *
+     * @param omega            PG draws, one column per variable (n x p)
+     * @param main_linear      Prior linear terms of the main effects (p)
+     * @param main_precision   Prior precisions of the main effects (p)
+     * @param prior_linear     Prior linear terms of the included pairwise effects (p x p)
+     * @param prior_precision  Prior precisions of the included pairwise effects (p x p)
+     */
+    void update_polya_gamma_block(int variable, const arma::mat& omega,
+                                  const arma::vec& main_linear, const arma::vec& main_precision,
+                                  const arma::mat& prior_linear, const arma::mat& prior_precision);
+
     /**
      * Update single pairwise effect via Metropolis
      * @return acceptance probability (for Metropolis adaptation)
@@ -474,13 +1134,42 @@ private:
 
     /**
      * Update single edge indicator (spike-and-slab)
+     * @return acceptance probability (for the informed edge schedule)
+     */
+    double update_edge_indicator(int var1, int var2);
+
+    /**
+     * Log acceptance ratio of the move of edge (var1, var2) to
+     * `proposed_state` (0 to delete the edge, the proposed effect to add it).
+     */
+    double edge_indicator_log_accept(int var1, int var2, double proposed_state,
+                                     ScratchArena* arena = nullptr) const;
+
+    /**
+     * Prior, proposal and inclusion-odds terms of edge_indicator_log_accept()
+     * (everything but the tempered pseudolikelihood ratio).
+     */
+    double edge_indicator_log_prior_ratio(int var1, int var2, double proposed_state) const;
+
+    /**
+     * Accept the move of edge (var1, var2): flip the indicator and set the
+     * effect to `proposed_state`. Touches only the rows and columns of
+     * var1 and var2; the caller updates the active set.
+     */
+    void flip_edge_indicator(int var1, int var2, double proposed_state);
+
+    /**
+     * One scan of the edge indicators, matching by matching (see
+     * set_matching_edge_updates())
      */
-    void update_edge_indicator(int var1, int var2);
+    void update_edge_indicators_by_matching();
 };
 
 
 /**
- * Factory function to create OMRFModel from R inputs
+ * Factory function to create OMRFModel from R inputs. With an
+ * `observation_file` element, the observations are read in place from
+ * that score file instead of from `observations`.
  */
 OMRFModel createOMRFModelFromR(
     const Rcpp::List& inputFromR,
@@ -0,0 +1,66 @@
+#pragma once
+
+/**
+ * @file shared_data.h
+ * @brief Copy-on-write holder for data that chain clones share.
+ *
+ * run_mcmc_sampler() clones the model once per chain. The observations
+ * (and their double and transposed copies) are the same in every chain,
+ * so a model keeps them in a SharedData block: copying the model copies
+ * the pointer, and memory grows with the number of chains only for
+ * parameters, residuals and scratch.
+ *
+ * Writes go through mut(), which first gives this model its own copy when
+ * the block is shared. A model that writes to its data while sampling
+ * (missing-data imputation) calls detach() in its copy constructor, so
+ * every chain imputes into its own block and the running chains never
+ * race on the reference count.
+ */
+
+#include <memory>
+#include <utility>
+
+
+/**
+ * SharedData - Shared, immutable-by-default block of model data
+ *
+ * @tparam T  Aggregate of the shared members
+ */
+template <typename T>
+class SharedData {
+public:
+    SharedData() : ptr_(std::make_shared<T>()) {}
+    explicit SharedData(T value) : ptr_(std::make_shared<T>(std::move(value))) {}
+
+    const T& operator*() const { return *ptr_; }
+    const T* operator->() const { return ptr_.get(); }
+
+    /**
+     * Writable access, copying the block first if another model shares it.
+     * Call only from the thread that owns this model.
+     */
+    T& mut() {
+        detach();
+        // The block was created non-const by make_shared<T>.
+        return const_cast<T&>(*ptr_);
+    }
+
+    /** Give this model its own copy of the block if it is shared. */
+    void detach() {
+        if (ptr_.use_count() > 1) {
+            ptr_ = std::make_shared<T>(*ptr_);
+        }
+    }
+
+    /**
+     * Drop this model's block and hold the one of `other` instead, e.g.
+     * after `other` has written an update every clone should see.
+     */
+    void share(const SharedData& other) { ptr_ = other.ptr_; }
+
+    /** @return Whether another model holds the same block. */
+    bool is_shared() const { return ptr_.use_count() > 1; }
+
+private:
+    std::shared_ptr<const T> ptr_;
+};
@@ -1,6 +1,8 @@
 // [[Rcpp::depends(RcppArmadillo)]]
 #include <RcppArmadillo.h>
 #include "utils/variable_helpers.h"
+#include <string>
+#include <vector>
 using namespace Rcpp;
 
 
@@ -63,6 +65,254 @@ Rcpp::List compute_conditional_ggm(
 }
 
 
+// ============================================================================
+//   Shared Helpers
+// ============================================================================
+
+namespace {
+
+// Running mean and standard deviation of a matrix-valued quantity over
+// posterior draws (Welford). The standard deviation uses the n - 1
+// denominator, like R's sd(), and is NA for a single draw.
+struct DrawMoments {
+  arma::mat mean;
+  arma::mat m2;
+  int count = 0;
+
+  void add(const arma::mat& x) {
+    if (count == 0) {
+      mean.zeros(x.n_rows, x.n_cols);
+      m2.zeros(x.n_rows, x.n_cols);
+    }
+    count++;
+    arma::mat delta = x - mean;
+    mean += delta / count;
+    m2 += delta % (x - mean);
+  }
+
+  Rcpp::List result() const {
+    arma::mat sd;
+    if (count > 1) {
+      sd = arma::sqrt(m2 / (count - 1));
+    } else {
+      sd.set_size(mean.n_rows, mean.n_cols);
+      sd.fill(NA_REAL);
+    }
+    return Rcpp::List::create(
+      Rcpp::Named("mean") = mean,
+      Rcpp::Named("sd") = sd
+    );
+  }
+};
+
+
+// Per-variable type flags, read once instead of once per use.
+std::vector<char> blume_capel_flags(const Rcpp::StringVector& variable_type) {
+  std::vector<char> is_blume_capel(variable_type.size());
+  for (R_xlen_t v = 0; v < variable_type.size(); v++) {
+    is_blume_capel[v] = (std::string(variable_type[v]) == "blume-capel");
+  }
+  return is_blume_capel;
+}
+
+
+// Observations as doubles, centered by the baseline category where the
+// rest score uses it.
+//
+// @param center  Per-variable flag: subtract baseline_category.
+arma::mat centered_observations(
+    const arma::imat& observations,
+    const arma::ivec& baseline_category,
+    const std::vector<char>& center) {
+  arma::mat x = arma::conv_to<arma::mat>::from(observations);
+  for (arma::uword v = 0; v < x.n_cols; v++) {
+    if (center[v]) x.col(v) -= static_cast<double>(baseline_category[v]);
+  }
+  return x;
+}
+
+
+// Conditional category probabilities of one discrete variable given the
+// rest scores of all persons.
+arma::mat discrete_conditional_probs(
+    const arma::vec& rest_scores,
+    int variable,
+    const arma::mat& main,
+    int num_categories,
+    bool is_blume_capel,
+    int baseline_category) {
+
+  if (is_blume_capel) {
+    arma::vec bound;  // Will be computed inside
+    return compute_probs_blume_capel(
+      rest_scores,
+      main(variable, 0),
+      main(variable, 1),
+      baseline_category,
+      num_categories,
+      bound
+    );
+  }
+
+  // Regular ordinal variable
+  arma::vec main_param = main.row(variable).head(num_categories).t();
+
+  // Compute bounds for numerical stability: max exponent per person
+  arma::vec bound(rest_scores.n_elem, arma::fill::zeros);
+  for (int c = 0; c < num_categories; c++) {
+    bound = arma::max(bound, main_param[c] + (c + 1) * rest_scores);
+  }
+
+  return compute_probs_ordinal(main_param, rest_scores, bound, num_categories);
+}
+
+
+// Symmetric p x p matrix from its strict lower triangle in column-major
+// order (the layout of the pairwise samples).
+arma::mat symmetric_from_lower(const arma::rowvec& values, int p) {
+  arma::mat m(p, p, arma::fill::zeros);
+  int idx = 0;
+  for (int col = 0; col < p; col++) {
+    for (int row = col + 1; row < p; row++) {
+      m(row, col) = values[idx];
+      m(col, row) = values[idx];
+      idx++;
+    }
+  }
+  return m;
+}
+
+
+// Main-effect matrix (variables x max parameters) from its flat layout:
+// num_categories entries per ordinal variable, two per Blume-Capel variable.
+arma::mat main_from_flat(
+    const arma::rowvec& values,
+    const arma::ivec& param_counts) {
+  arma::mat main(param_counts.n_elem, arma::max(param_counts), arma::fill::zeros);
+  int idx = 0;
+  for (arma::uword v = 0; v < param_counts.n_elem; v++) {
+    for (int c = 0; c < param_counts[v]; c++) {
+      main(v, c) = values[idx++];
+    }
+  }
+  return main;
+}
+
+
+// Conditional probabilities of the predicted variables of an OMRF for one
+// parameter set. The rest scores of all predicted variables come from a
+// single product of the centered observations with the pairwise columns.
+std::vector<arma::mat> omrf_conditionals(
+    const arma::mat& x_centered,
+    const arma::uvec& predict_vars,
+    const arma::mat& pairwise,
+    const arma::mat& main,
+    const arma::ivec& num_categories,
+    const std::vector<char>& is_blume_capel,
+    const arma::ivec& baseline_category) {
+
+  // Skip the variable we're predicting
+  arma::mat pairwise_offdiag = pairwise;
+  pairwise_offdiag.diag().zeros();
+  const arma::mat rest = 2.0 * x_centered * pairwise_offdiag.cols(predict_vars);
+
+  std::vector<arma::mat> out(predict_vars.n_elem);
+  for (arma::uword pv = 0; pv < predict_vars.n_elem; pv++) {
+    const int variable = predict_vars[pv];
+    out[pv] = discrete_conditional_probs(
+      rest.col(pv), variable, main, num_categories[variable],
+      is_blume_capel[variable], baseline_category[variable]
+    );
+  }
+  return out;
+}
+
+
+// Conditional distributions of the predicted variables of a mixed MRF for
+// one parameter set. Rest scores and linear predictors are products of the
+// centered discrete data and the continuous data with the interaction
+// columns of all predicted variables at once.
+//
+// @return One matrix per predicted variable: n x (num_cats + 1)
+//   probabilities for discrete, n x 2 (mean, sd) for continuous.
+std::vector<arma::mat> mixed_conditionals(
+    const arma::mat& x_centered,
+    const arma::mat& y_observations,
+    const arma::ivec& predict_vars,
+    const arma::mat& pairwise_disc,
+    const arma::mat& pairwise_cross,
+    const arma::mat& pairwise_cont,
+    const arma::mat& mux,
+    const arma::vec& muy,
+    const arma::ivec& num_categories,
+    const std::vector<char>& is_blume_capel,
+    const arma::ivec& baseline_category) {
+
+  const int n = x_centered.n_rows;
+  const int p = x_centered.n_cols;
+
+  std::vector<arma::uword> disc_vars, cont_vars;
+  for (arma::uword pv = 0; pv < predict_vars.n_elem; pv++) {
+    if (predict_vars[pv] < p) {
+      disc_vars.push_back(predict_vars[pv]);
+    } else {
+      cont_vars.push_back(predict_vars[pv] - p);
+    }
+  }
+  const arma::uvec disc(disc_vars);
+  const arma::uvec cont(cont_vars);
+
+  // Discrete: rest scores from discrete neighbours (centered by baseline)
+  // and from the continuous variables, both with a factor of 2.
+  arma::mat disc_rest;
+  if (!disc.is_empty()) {
+    arma::mat pairwise_disc_offdiag = pairwise_disc;
+    pairwise_disc_offdiag.diag().zeros();
+    disc_rest = 2.0 * x_centered * pairwise_disc_offdiag.cols(disc);
+    if (y_observations.n_cols > 0) {
+      disc_rest += 2.0 * y_observations * pairwise_cross.rows(disc).t();
+    }
+  }
+
+  // Continuous: the precision is -2 * pairwise_cont; the linear predictor
+  // sums the other continuous variables (centered by their means) and the
+  // centered discrete variables, each with a factor of 2.
+  arma::mat cont_lp;
+  if (!cont.is_empty()) {
+    arma::mat y_centered = y_observations;
+    y_centered.each_row() -= muy.t();
+    arma::mat pairwise_cont_offdiag = pairwise_cont;
+    pairwise_cont_offdiag.diag().zeros();
+    cont_lp = 2.0 * y_centered * pairwise_cont_offdiag.cols(cont);
+    if (p > 0) {
+      cont_lp += 2.0 * x_centered * pairwise_cross.cols(cont);
+    }
+  }
+
+  std::vector<arma::mat> out(predict_vars.n_elem);
+  arma::uword d = 0, c = 0;
+  for (arma::uword pv = 0; pv < predict_vars.n_elem; pv++) {
+    if (predict_vars[pv] < p) {
+      const int s = predict_vars[pv];
+      out[pv] = discrete_conditional_probs(
+        disc_rest.col(d++), s, mux, num_categories[s],
+        is_blume_capel[s], baseline_category[s]
+      );
+    } else {
+      const int j = predict_vars[pv] - p;
+      const double cond_var = 1.0 / (-2.0 * pairwise_cont(j, j));
+      arma::mat res(n, 2);
+      res.col(0) = muy(j) + cond_var * cont_lp.col(c++);
+      res.col(1).fill(std::sqrt(cond_var));
+      out[pv] = res;
+    }
+  }
+  return out;
+}
+
+} // namespace
+
+
 // ============================================================================
 //   OMRF Conditional Prediction
 // ============================================================================
@@ -80,81 +330,88 @@ Rcpp::List compute_conditional_probs(
     Rcpp::StringVector variable_type, // "ordinal" or "blume-capel" per variable
     arma::ivec baseline_category      // baseline for blume-capel variables
 ) {
-  int no_persons = observations.n_rows;
-  int num_variables = observations.n_cols;
-  int num_predict_vars = predict_vars.n_elem;
-
-  // Output is a list of probability matrices, one per predict variable
-  Rcpp::List result(num_predict_vars);
+  const std::vector<char> is_blume_capel = blume_capel_flags(variable_type);
+  const arma::mat x_centered =
+    centered_observations(observations, baseline_category, is_blume_capel);
 
-  for(int pv = 0; pv < num_predict_vars; pv++) {
-    int variable = predict_vars[pv];
-    int n_cats = num_categories[variable] + 1;  // Include category 0
+  const std::vector<arma::mat> probs = omrf_conditionals(
+    x_centered, arma::conv_to<arma::uvec>::from(predict_vars),
+    pairwise, main, num_categories, is_blume_capel, baseline_category
+  );
 
-    // Compute rest scores for all persons at once (vectorized)
-    arma::vec rest_scores(no_persons, arma::fill::zeros);
-
-    for(int vertex = 0; vertex < num_variables; vertex++) {
-      if(vertex == variable) continue;  // Skip the variable we're predicting
-
-      arma::vec obs_col = arma::conv_to<arma::vec>::from(observations.col(vertex));
-
-      if(std::string(variable_type[vertex]) != "blume-capel") {
-        rest_scores += 2.0 * obs_col * pairwise(vertex, variable);
-      } else {
-        int ref = baseline_category[vertex];
-        rest_scores += 2.0 * (obs_col - double(ref)) * pairwise(vertex, variable);
-      }
-    }
+  // Output is a list of probability matrices, one per predict variable
+  Rcpp::List result(probs.size());
+  for (std::size_t pv = 0; pv < probs.size(); pv++) {
+    result[pv] = Rcpp::wrap(probs[pv]);
+  }
+  return result;
+}
 
-    // Use numerically stable probability computation
-    arma::mat probs;
-
-    if(std::string(variable_type[variable]) == "blume-capel") {
-      int ref = baseline_category[variable];
-      double lin_eff = main(variable, 0);
-      double quad_eff = main(variable, 1);
-      arma::vec bound;  // Will be computed inside
-
-      probs = compute_probs_blume_capel(
-        rest_scores,
-        lin_eff,
-        quad_eff,
-        ref,
-        num_categories[variable],
-        bound
-      );
-    } else {
-      // Regular ordinal variable
-      // Extract main effect parameters for this variable
-      arma::vec main_param = main.row(variable).head(num_categories[variable]).t();
-
-      // Compute bounds for numerical stability: max exponent per person
-      arma::vec bound(no_persons, arma::fill::zeros);
-      for(int c = 0; c < num_categories[variable]; c++) {
-        arma::vec exps = main_param[c] + (c + 1) * rest_scores;
-        bound = arma::max(bound, exps);
-      }
 
-      probs = compute_probs_ordinal(
-        main_param,
-        rest_scores,
-        bound,
-        num_categories[variable]
-      );
-    }
+// Posterior predictive conditional probabilities of an OMRF over many
+// posterior draws at once.
+//
+// The observations and type flags are prepared once; each draw then costs
+// one n x p x |predict_vars| product for its rest scores. Probabilities are
+// averaged over the draws in C++ instead of being returned per draw.
+//
+// @param observations      n x p matrix of observed data
+// @param predict_vars      0-based indices of variables to predict
+// @param pairwise_samples  ndraws_total x p*(p-1)/2 pairwise samples
+//                          (column-major lower triangle)
+// @param main_samples      ndraws_total x n_main flat main-effect samples
+// @param draw_indices      1-based rows of the samples to use
+// @param num_categories    Number of categories per variable
+// @param variable_type     "ordinal" or "blume-capel" per variable
+// @param baseline_category Baseline for blume-capel variables
+//
+// @return List with one element per predicted variable, each a list with
+//   "mean" and "sd": n x (num_cats + 1) matrices of the posterior mean and
+//   standard deviation of the probabilities across draws.
+// [[Rcpp::export]]
+Rcpp::List compute_conditional_probs_draws(
+    const arma::imat& observations,
+    const arma::ivec& predict_vars,
+    const arma::mat& pairwise_samples,
+    const arma::mat& main_samples,
+    const arma::ivec& draw_indices,
+    const arma::ivec& num_categories,
+    const Rcpp::StringVector& variable_type,
+    const arma::ivec& baseline_category
+) {
+  const int num_variables = observations.n_cols;
+  const std::vector<char> is_blume_capel = blume_capel_flags(variable_type);
+  const arma::mat x_centered =
+    centered_observations(observations, baseline_category, is_blume_capel);
+  const arma::uvec predict = arma::conv_to<arma::uvec>::from(predict_vars);
+
+  arma::ivec param_counts(num_variables);
+  for (int v = 0; v < num_variables; v++) {
+    param_counts[v] = is_blume_capel[v] ? 2 : num_categories[v];
+  }
 
-    // Convert arma::mat to Rcpp::NumericMatrix
-    Rcpp::NumericMatrix prob_mat(no_persons, n_cats);
-    for(int i = 0; i < no_persons; i++) {
-      for(int c = 0; c < n_cats; c++) {
-        prob_mat(i, c) = probs(i, c);
-      }
+  std::vector<DrawMoments> moments(predict.n_elem);
+  for (arma::uword i = 0; i < draw_indices.n_elem; i++) {
+    const int row = draw_indices[i] - 1;
+    const arma::mat pairwise =
+      symmetric_from_lower(pairwise_samples.row(row), num_variables);
+    const arma::mat main = main_from_flat(main_samples.row(row), param_counts);
+
+    const std::vector<arma::mat> probs = omrf_conditionals(
+      x_centered, predict, pairwise, main,
+      num_categories, is_blume_capel, baseline_category
+    );
+    for (arma::uword pv = 0; pv < predict.n_elem; pv++) {
+      moments[pv].add(probs[pv]);
     }
 
-    result[pv] = prob_mat;
+    if ((i + 1) % 100 == 0) Rcpp::checkUserInterrupt();
   }
 
+  Rcpp::List result(predict.n_elem);
+  for (arma::uword pv = 0; pv < predict.n_elem; pv++) {
+    result[pv] = moments[pv].result();
+  }
   return result;
 }
 
@@ -200,103 +457,116 @@ Rcpp::List compute_conditional_mixed(
     const Rcpp::StringVector& variable_type,
     const arma::ivec& baseline_category
 ) {
-  int n = x_observations.n_rows;
-  int p = x_observations.n_cols;
-  int q = y_observations.n_cols;
-  int num_predict_vars = predict_vars.n_elem;
+  const std::vector<char> is_blume_capel = blume_capel_flags(variable_type);
+  const arma::mat x_centered = centered_observations(
+    x_observations, baseline_category,
+    std::vector<char>(x_observations.n_cols, 1));
+
+  const std::vector<arma::mat> preds = mixed_conditionals(
+    x_centered, y_observations, predict_vars,
+    pairwise_disc, pairwise_cross, pairwise_cont, mux, muy,
+    num_categories, is_blume_capel, baseline_category
+  );
+
+  Rcpp::List result(preds.size());
+  for (std::size_t pv = 0; pv < preds.size(); pv++) {
+    result[pv] = Rcpp::wrap(preds[pv]);
+  }
+  return result;
+}
 
-  // Convert discrete to double (centered for rest-score computation)
-  arma::mat x_dbl = arma::conv_to<arma::mat>::from(x_observations);
 
-  Rcpp::List result(num_predict_vars);
+// Posterior predictive conditional distributions of a mixed MRF over many
+// posterior draws at once.
+//
+// Takes the per-component sample matrices of split_mixed_raw_samples() (the
+// layout of run_mixed_simulation_parallel()) and averages the per-draw
+// predictions of compute_conditional_mixed() in C++.
+//
+// @param x_observations   n x p integer matrix of discrete data.
+// @param y_observations   n x q numeric matrix of continuous data.
+// @param predict_vars     0-based indices into the combined (p+q) variable list.
+// @param mux_samples      ndraws_total x n_mux
+// @param disc_samples     ndraws_total x p*(p-1)/2
+// @param muy_samples      ndraws_total x q
+// @param cont_samples     ndraws_total x q*(q+1)/2
+// @param cross_samples    ndraws_total x p*q
+// @param draw_indices     1-based rows of the samples to use
+// @param num_categories   p-vector: categories per discrete variable.
+// @param variable_type    p-vector: "ordinal" or "blume-capel".
+// @param baseline_category p-vector.
+//
+// @return List with one element per predicted variable, each a list with
+//   "mean" and "sd" matrices shaped as in compute_conditional_mixed().
+// [[Rcpp::export]]
+Rcpp::List compute_conditional_mixed_draws(
+    const arma::imat& x_observations,
+    const arma::mat& y_observations,
+    const arma::ivec& predict_vars,
+    const arma::mat& mux_samples,
+    const arma::mat& disc_samples,
+    const arma::mat& muy_samples,
+    const arma::mat& cont_samples,
+    const arma::mat& cross_samples,
+    const arma::ivec& draw_indices,
+    const arma::ivec& num_categories,
+    const Rcpp::StringVector& variable_type,
+    const arma::ivec& baseline_category
+) {
+  const int p = x_observations.n_cols;
+  const int q = y_observations.n_cols;
+  const std::vector<char> is_blume_capel = blume_capel_flags(variable_type);
+  const arma::mat x_centered = centered_observations(
+    x_observations, baseline_category, std::vector<char>(p, 1));
+
+  arma::ivec mux_param_counts(p);
+  for (int s = 0; s < p; s++) {
+    mux_param_counts[s] = is_blume_capel[s] ? 2 : num_categories[s];
+  }
 
-  for (int pv = 0; pv < num_predict_vars; pv++) {
-    int var_idx = predict_vars[pv];
-
-    if (var_idx < p) {
-      // --- Discrete variable: P(x_s = c | x_{-s}, y) ---
-      int s = var_idx;
-      int Cs = num_categories[s];
-
-      // Rest score from discrete neighbours (centered by baseline)
-      arma::vec rest_discrete(n, arma::fill::zeros);
-      for (int k = 0; k < p; k++) {
-        if (k == s) continue;
-        arma::vec obs_k = x_dbl.col(k);
-        double ref_k = static_cast<double>(baseline_category[k]);
-        rest_discrete += 2.0 * (obs_k - ref_k) * pairwise_disc(k, s);
+  std::vector<DrawMoments> moments(predict_vars.n_elem);
+  for (arma::uword i = 0; i < draw_indices.n_elem; i++) {
+    const int row = draw_indices[i] - 1;
+
+    const arma::mat mux = main_from_flat(mux_samples.row(row), mux_param_counts);
+    const arma::mat pairwise_disc = symmetric_from_lower(disc_samples.row(row), p);
+    const arma::vec muy = muy_samples.row(row).t();
+
+    // Continuous interactions: column-major lower triangle with diagonal
+    arma::mat pairwise_cont(q, q);
+    int idx = 0;
+    for (int col = 0; col < q; col++) {
+      for (int r = col; r < q; r++) {
+        pairwise_cont(r, col) = cont_samples(row, idx);
+        pairwise_cont(col, r) = cont_samples(row, idx);
+        idx++;
       }
+    }
 
-      // Rest score from continuous (factor of 2)
-      arma::vec rest_continuous(n, arma::fill::zeros);
+    // Cross interactions (p x q, row-major)
+    arma::mat pairwise_cross(p, q);
+    idx = 0;
+    for (int s = 0; s < p; s++) {
       for (int j = 0; j < q; j++) {
-        rest_continuous += 2.0 * pairwise_cross(s, j) * y_observations.col(j);
-      }
-
-      arma::vec rest_scores = rest_discrete + rest_continuous;
-
-      arma::mat probs;
-      if (std::string(variable_type[s]) == "blume-capel") {
-        int ref = baseline_category[s];
-        double lin_eff = mux(s, 0);
-        double quad_eff = mux(s, 1);
-        arma::vec bound;
-        probs = compute_probs_blume_capel(
-          rest_scores, lin_eff, quad_eff, ref, Cs, bound
-        );
-      } else {
-        arma::vec main_param = mux.row(s).head(Cs).t();
-        arma::vec bound(n, arma::fill::zeros);
-        for (int c = 0; c < Cs; c++) {
-          arma::vec exps = main_param[c] + (c + 1) * rest_scores;
-          bound = arma::max(bound, exps);
-        }
-        probs = compute_probs_ordinal(main_param, rest_scores, bound, Cs);
-      }
-
-      Rcpp::NumericMatrix prob_mat(n, Cs + 1);
-      for (int i = 0; i < n; i++) {
-        for (int c = 0; c <= Cs; c++) {
-          prob_mat(i, c) = probs(i, c);
-        }
-      }
-      result[pv] = prob_mat;
-
-    } else {
-      // --- Continuous variable: y_j | y_{-j}, x ---
-      int j = var_idx - p;
-
-      // Continuous interaction matrix is negative-definite: precision = -2 * pairwise_cont
-      double precision_jj = -2.0 * pairwise_cont(j, j);
-      double cond_var = 1.0 / precision_jj;
-      double cond_sd = std::sqrt(cond_var);
-
-      // Contribution from other continuous variables:
-      // -sum_{k != j} precision[j,k] * (y_k - muy_k)
-      arma::vec lp_continuous(n, arma::fill::zeros);
-      for (int k = 0; k < q; k++) {
-        if (k == j) continue;
-        lp_continuous += 2.0 * pairwise_cont(j, k) * (y_observations.col(k) - muy(k));
+        pairwise_cross(s, j) = cross_samples(row, idx++);
       }
+    }
 
-      // Contribution from discrete variables (factor of 2):
-      // sum_s 2 * cross_interaction(s, j) * x_s_centered
-      arma::vec lp_discrete(n, arma::fill::zeros);
-      for (int s = 0; s < p; s++) {
-        double ref_s = static_cast<double>(baseline_category[s]);
-        lp_discrete += 2.0 * pairwise_cross(s, j) * (x_dbl.col(s) - ref_s);
-      }
-
-      arma::vec cond_means = muy(j) + cond_var * (lp_continuous + lp_discrete);
-
-      Rcpp::NumericMatrix out(n, 2);
-      for (int i = 0; i < n; i++) {
-        out(i, 0) = cond_means[i];
-        out(i, 1) = cond_sd;
-      }
-      result[pv] = out;
+    const std::vector<arma::mat> preds = mixed_conditionals(
+      x_centered, y_observations, predict_vars,
+      pairwise_disc, pairwise_cross, pairwise_cont, mux, muy,
+      num_categories, is_blume_capel, baseline_category
+    );
+    for (arma::uword pv = 0; pv < predict_vars.n_elem; pv++) {
+      moments[pv].add(preds[pv]);
     }
+
+    if ((i + 1) % 100 == 0) Rcpp::checkUserInterrupt();
   }
 
+  Rcpp::List result(predict_vars.n_elem);
+  for (arma::uword pv = 0; pv < predict_vars.n_elem; pv++) {
+    result[pv] = moments[pv].result();
+  }
   return result;
-}
\ No newline at end of file
+}
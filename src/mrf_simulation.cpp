@@ -1,10 +1,12 @@
 // [[Rcpp::depends(RcppParallel, RcppArmadillo, dqrng, BH)]]
 #include <RcppArmadillo.h>
 #include <RcppParallel.h>
-#include <tbb/global_control.h>
+#include "mrf_simulation.h"
+#include "math/categorical.h"
 #include "math/explog_macros.h"
 #include "rng/rng_utils.h"
 #include "utils/progress_manager.h"
+#include "utils/task_arena.h"
 #include <vector>
 #include <string>
 
@@ -16,11 +18,242 @@ using namespace RcppParallel;
 //   MRF Simulation Core Functions (Thread-Safe)
 // ============================================================================
 
+namespace {
+
+// An edge of the pairwise graph, seen from one of its endpoints. weight is
+// twice the interaction, the factor the rest score carries.
+struct MRFNeighbour {
+  int variable;
+  double weight;
+};
+
+
+// Neighbours of every variable: the variables it has a nonzero interaction
+// with, in increasing order.
+std::vector<std::vector<MRFNeighbour>> mrf_neighbours(
+    const arma::mat& pairwise) {
+  const int p = pairwise.n_cols;
+  std::vector<std::vector<MRFNeighbour>> neighbours(p);
+  for (int v = 0; v < p; v++) {
+    for (int u = 0; u < p; u++) {
+      if (u != v && pairwise(u, v) != 0.0) {
+        neighbours[v].push_back({u, 2.0 * pairwise(u, v)});
+      }
+    }
+  }
+  return neighbours;
+}
+
+
+// Random (uniform) starting values, drawn variable by variable.
+arma::imat initial_mrf_state(
+    int num_states,
+    int num_variables,
+    const arma::ivec& num_categories,
+    SafeRNG& rng) {
+
+  arma::imat observations(num_states, num_variables);
+  for (int variable = 0; variable < num_variables; variable++) {
+    const double cumsum = num_categories[variable] + 1.0;
+    for (int person = 0; person < num_states; person++) {
+      const double u = cumsum * runif(rng);
+      int score = 0;
+      while (score < num_categories[variable] && u > score + 1.0) {
+        score++;
+      }
+      observations(person, variable) = score;
+    }
+  }
+  return observations;
+}
+
+
+// Draw one category of a variable from its full conditional.
+//
+// @param rest_score     Sum over the other variables of
+//                       2 * (x_u - ref_u) * pairwise(u, variable).
+// @param probabilities  Scratch space of at least num_categories + 1.
+inline int draw_mrf_category(
+    int variable,
+    double rest_score,
+    const arma::ivec& num_categories,
+    const arma::mat& main,
+    bool is_blume_capel,
+    int ref,
+    arma::vec& probabilities,
+    SafeRNG& rng) {
+
+  double cumsum;
+  if (is_blume_capel) {
+    cumsum = 0.0;
+    for (int category = 0; category <= num_categories[variable]; category++) {
+      const int s = category - ref;
+      // Linear term
+      double exponent = main(variable, 0) * s;
+      // Quadratic term
+      exponent += main(variable, 1) * s * s;
+      // Pairwise effects
+      exponent += rest_score * s;
+      cumsum += MY_EXP(exponent);
+      probabilities[category] = cumsum;
+    }
+  } else {
+    // Ordinal: baseline category 0 has probability 1 (unnormalized)
+    cumsum = 1.0;
+    probabilities[0] = cumsum;
+    for (int category = 0; category < num_categories[variable]; category++) {
+      double exponent = main(variable, category);
+      exponent += (category + 1) * rest_score;
+      cumsum += MY_EXP(exponent);
+      probabilities[category + 1] = cumsum;
+    }
+  }
+
+  const double u = cumsum * runif(rng);
+  return categorical_from_cumulative(
+    probabilities.memptr(), num_categories[variable] + 1, u);
+}
+
+
+// Rest scores of all persons for all variables:
+// rest(i, v) = sum_u 2 * (x_iu - ref_u) * pairwise(u, v).
+arma::mat mrf_rest_scores(
+    const arma::imat& observations,
+    const arma::mat& pairwise,
+    const arma::ivec& baseline_category) {
+  arma::mat centered = arma::conv_to<arma::mat>::from(observations);
+  centered.each_row() -= arma::conv_to<arma::rowvec>::from(baseline_category.t());
+  return 2.0 * centered * pairwise;
+}
+
+
+// Greedy coloring of the pairwise graph. Variables that share a color
+// have no interaction with each other, so they are conditionally
+// independent given the remaining variables.
+//
+// @return Variables of each color, in increasing order.
+std::vector<std::vector<int>> color_mrf_graph(
+    const std::vector<std::vector<MRFNeighbour>>& neighbours) {
+  const int p = neighbours.size();
+  std::vector<int> color(p, -1);
+  std::vector<std::vector<int>> classes;
+  std::vector<char> taken;
+  for (int v = 0; v < p; v++) {
+    taken.assign(classes.size() + 1, 0);
+    for (const MRFNeighbour& nb : neighbours[v]) {
+      if (color[nb.variable] >= 0) taken[color[nb.variable]] = 1;
+    }
+    int c = 0;
+    while (taken[c]) c++;
+    if (c == static_cast<int>(classes.size())) classes.emplace_back();
+    color[v] = c;
+    classes[c].push_back(v);
+  }
+  return classes;
+}
+
+
+// Samples the variables of one color class, each with its own RNG stream.
+// Only the class's own columns of observations and delta are written.
+struct ColorClassWorker : public RcppParallel::Worker {
+  const std::vector<int>& variables;
+  const arma::mat& rest;
+  const arma::ivec& num_categories;
+  const arma::mat& main;
+  const std::vector<char>& is_blume_capel;
+  const arma::ivec& baseline_category;
+  std::vector<SafeRNG>& variable_rngs;
+  arma::imat& observations;
+  arma::mat& delta;
+
+  ColorClassWorker(
+    const std::vector<int>& variables,
+    const arma::mat& rest,
+    const arma::ivec& num_categories,
+    const arma::mat& main,
+    const std::vector<char>& is_blume_capel,
+    const arma::ivec& baseline_category,
+    std::vector<SafeRNG>& variable_rngs,
+    arma::imat& observations,
+    arma::mat& delta
+  ) :
+    variables(variables),
+    rest(rest),
+    num_categories(num_categories),
+    main(main),
+    is_blume_capel(is_blume_capel),
+    baseline_category(baseline_category),
+    variable_rngs(variable_rngs),
+    observations(observations),
+    delta(delta)
+  {}
+
+  void operator()(std::size_t begin, std::size_t end) {
+    arma::vec probabilities(arma::max(num_categories) + 1);
+    for (std::size_t k = begin; k < end; ++k) {
+      const int variable = variables[k];
+      SafeRNG& rng = variable_rngs[variable];
+      const double* rest_col = rest.colptr(variable);
+      int* obs_col = observations.colptr(variable);
+      double* delta_col = delta.colptr(variable);
+      for (arma::uword person = 0; person < observations.n_rows; person++) {
+        const int score = draw_mrf_category(
+          variable, rest_col[person], num_categories, main,
+          is_blume_capel[variable], baseline_category[variable],
+          probabilities, rng
+        );
+        delta_col[person] = score - obs_col[person];
+        obs_col[person] = score;
+      }
+    }
+  }
+};
+
+
+// Folds the changes of one color class into the rest scores of the
+// variables they interact with. Each variable's column is owned by one task.
+struct ColorClassRestWorker : public RcppParallel::Worker {
+  const std::vector<char>& in_class;
+  const std::vector<std::vector<MRFNeighbour>>& neighbours;
+  const arma::mat& delta;
+  arma::mat& rest;
+
+  ColorClassRestWorker(
+    const std::vector<char>& in_class,
+    const std::vector<std::vector<MRFNeighbour>>& neighbours,
+    const arma::mat& delta,
+    arma::mat& rest
+  ) :
+    in_class(in_class),
+    neighbours(neighbours),
+    delta(delta),
+    rest(rest)
+  {}
+
+  void operator()(std::size_t begin, std::size_t end) {
+    for (std::size_t u = begin; u < end; ++u) {
+      for (const MRFNeighbour& nb : neighbours[u]) {
+        if (in_class[nb.variable]) {
+          rest.col(u) += nb.weight * delta.col(nb.variable);
+        }
+      }
+    }
+  }
+};
+
+} // namespace
+
+
 // Function: simulate_mrf
 //
 // Simulates observations from a Markov Random Field using Gibbs sampling.
 // Supports both ordinal and Blume-Capel variable types.
 //
+// Each sweep updates one variable at a time for all persons at once: the
+// rest scores of all persons are kept in a num_states x num_variables
+// matrix, and after a variable's column is redrawn only the columns of its
+// neighbours in the pairwise graph are adjusted.
+//
 // Inputs:
 //  - num_states: Number of observations to simulate.
 //  - num_variables: Number of variables in the MRF.
@@ -51,90 +284,113 @@ arma::imat simulate_mrf(
     int iter,
     SafeRNG& rng) {
 
-  arma::imat observations(num_states, num_variables);
-  int max_num_categories = arma::max(num_categories);
-  arma::vec probabilities(max_num_categories + 1);
-  double exponent = 0.0;
-  double rest_score = 0.0;
-  double cumsum = 0.0;
-  double u = 0.0;
-  int score = 0;
+  arma::vec probabilities(arma::max(num_categories) + 1);
 
   // Copy pairwise and zero diagonal to prevent accidental self-interactions
   arma::mat pairwise_safe = pairwise;
   pairwise_safe.diag().zeros();
 
-  // Random (uniform) starting values
-  for(int variable = 0; variable < num_variables; variable++) {
-    for(int person = 0; person < num_states; person++) {
-      cumsum = 1.0;
-      probabilities[0] = 1.0;
-      for(int category = 0; category < num_categories[variable]; category++) {
-        cumsum += 1;
-        probabilities[category + 1] = cumsum;
-      }
+  std::vector<char> is_blume_capel(num_variables);
+  for (int v = 0; v < num_variables; v++) {
+    is_blume_capel[v] = (variable_type[v] == "blume-capel");
+  }
+  const auto neighbours = mrf_neighbours(pairwise_safe);
 
-      u = cumsum * runif(rng);
+  arma::imat observations = initial_mrf_state(
+    num_states, num_variables, num_categories, rng);
+  arma::mat rest = mrf_rest_scores(observations, pairwise_safe, baseline_category);
+  arma::vec delta(num_states);
 
-      score = 0;
-      while (score < num_categories[variable] && u > probabilities[score]) {
-        score++;
+  // Gibbs sampling iterations
+  for (int iteration = 0; iteration < iter; iteration++) {
+    for (int variable = 0; variable < num_variables; variable++) {
+      const double* rest_col = rest.colptr(variable);
+      int* obs_col = observations.colptr(variable);
+      for (int person = 0; person < num_states; person++) {
+        const int score = draw_mrf_category(
+          variable, rest_col[person], num_categories, main,
+          is_blume_capel[variable], baseline_category[variable],
+          probabilities, rng
+        );
+        delta[person] = score - obs_col[person];
+        obs_col[person] = score;
+      }
+      for (const MRFNeighbour& nb : neighbours[variable]) {
+        rest.col(nb.variable) += nb.weight * delta;
       }
-      observations(person, variable) = score;
     }
   }
 
-  // Gibbs sampling iterations
-  for(int iteration = 0; iteration < iter; iteration++) {
-    for(int variable = 0; variable < num_variables; variable++) {
-      for(int person = 0; person < num_states; person++) {
-        // Compute rest score using centered parameterization
-        // For ordinal variables with baseline_category=0, this is equivalent to obs * pairwise
-        rest_score = 0.0;
-        for(int vertex = 0; vertex < num_variables; vertex++) {
-          int obs = observations(person, vertex);
-          int ref = baseline_category[vertex];
-          rest_score += 2.0 * (obs - ref) * pairwise_safe(vertex, variable);
-        }
+  return observations;
+}
 
-        if(variable_type[variable] == "blume-capel") {
-          cumsum = 0.0;
-          int ref = baseline_category[variable];
-          for(int category = 0; category <= num_categories[variable]; category++) {
-            const int s = category - ref;
-            // Linear term
-            exponent = main(variable, 0) * s;
-            // Quadratic term
-            exponent += main(variable, 1) * s * s;
-            // Pairwise effects
-            exponent += rest_score * s;
-            cumsum += MY_EXP(exponent);
-            probabilities[category] = cumsum;
-          }
-        } else {
-          // Ordinal: baseline category 0 has probability 1 (unnormalized)
-          cumsum = 1.0;
-          probabilities[0] = cumsum;
-          for(int category = 0; category < num_categories[variable]; category++) {
-            exponent = main(variable, category);
-            exponent += (category + 1) * rest_score;
-            cumsum += MY_EXP(exponent);
-            probabilities[category + 1] = cumsum;
-          }
-        }
 
-        u = cumsum * runif(rng);
+// Function: simulate_mrf_colored
+//
+// Gibbs sampler for the same model as simulate_mrf() that sweeps over the
+// color classes of the pairwise graph instead of over single variables.
+// Variables in a class do not interact, so they are redrawn in parallel;
+// the rest scores of their neighbours are then updated in one pass.
+//
+// Each variable draws from its own RNG stream, stream 1 + variable of
+// rng_streams(seed, ...) (stream 0 draws the starting values),
+// so the result does not depend on the number of threads. It is a different
+// chain than simulate_mrf() for the same seed.
+//
+// Inputs are those of simulate_mrf(), with seed in place of rng and
+// nThreads the maximum number of threads.
+arma::imat simulate_mrf_colored(
+    int num_states,
+    int num_variables,
+    const arma::ivec& num_categories,
+    const arma::mat& pairwise,
+    const arma::mat& main,
+    const std::vector<std::string>& variable_type,
+    const arma::ivec& baseline_category,
+    int iter,
+    int seed,
+    int nThreads) {
 
-        // Sample category with bounds protection
-        score = 0;
-        int max_score = num_categories[variable];
-        while (score < max_score && u > probabilities[score]) {
-          score++;
-        }
-        observations(person, variable) = score;
+  arma::mat pairwise_safe = pairwise;
+  pairwise_safe.diag().zeros();
+
+  // Stream 0 draws the initial state, stream 1 + v the updates of variable v
+  std::vector<SafeRNG> variable_rngs = rng_streams(seed, num_variables + 1);
+  SafeRNG init_rng = variable_rngs.front();
+  variable_rngs.erase(variable_rngs.begin());
+
+  std::vector<char> is_blume_capel(num_variables);
+  for (int v = 0; v < num_variables; v++) {
+    is_blume_capel[v] = (variable_type[v] == "blume-capel");
+  }
+  const auto neighbours = mrf_neighbours(pairwise_safe);
+  const auto classes = color_mrf_graph(neighbours);
+
+  arma::imat observations = initial_mrf_state(
+    num_states, num_variables, num_categories, init_rng);
+  arma::mat rest = mrf_rest_scores(observations, pairwise_safe, baseline_category);
+  arma::mat delta(num_states, num_variables);
+
+  std::vector<std::vector<char>> in_class(classes.size(),
+                                          std::vector<char>(num_variables, 0));
+  for (std::size_t c = 0; c < classes.size(); c++) {
+    for (int v : classes[c]) in_class[c][v] = 1;
+  }
+
+  run_in_arena(nThreads, [&] {
+    for (int iteration = 0; iteration < iter; iteration++) {
+      for (std::size_t c = 0; c < classes.size(); c++) {
+        ColorClassWorker sampler(
+          classes[c], rest, num_categories, main, is_blume_capel,
+          baseline_category, variable_rngs, observations, delta
+        );
+        parallel_for_tasks(classes[c].size(), sampler);
+
+        ColorClassRestWorker updater(in_class[c], neighbours, delta, rest);
+        parallel_for_tasks(static_cast<std::size_t>(num_variables), updater);
       }
     }
-  }
+  });
 
   return observations;
 }
@@ -144,6 +400,9 @@ arma::imat simulate_mrf(
 //   R Interface for mrfSampler()
 // ============================================================================
 
+// With colored = TRUE, both entry points use simulate_mrf_colored() on
+// up to nThreads threads; otherwise the sequential simulate_mrf().
+
 // [[Rcpp::export]]
 IntegerMatrix sample_omrf_gibbs(int num_states,
                                 int num_variables,
@@ -151,9 +410,9 @@ IntegerMatrix sample_omrf_gibbs(int num_states,
                                 NumericMatrix pairwise,
                                 NumericMatrix main,
                                 int iter,
-                                int seed) {
-
-  SafeRNG rng(seed);
+                                int seed,
+                                bool colored = false,
+                                int nThreads = 1) {
 
   // Convert inputs to arma types
   arma::ivec num_categories_arma = Rcpp::as<arma::ivec>(num_categories);
@@ -165,17 +424,34 @@ IntegerMatrix sample_omrf_gibbs(int num_states,
   arma::ivec baseline_category_arma(num_variables, arma::fill::zeros);
 
   // Simulate observations
-  arma::imat result = simulate_mrf(
-    num_states,
-    num_variables,
-    num_categories_arma,
-    pairwise_arma,
-    main_arma,
-    variable_type,
-    baseline_category_arma,
-    iter,
-    rng
-  );
+  arma::imat result;
+  if (colored) {
+    result = simulate_mrf_colored(
+      num_states,
+      num_variables,
+      num_categories_arma,
+      pairwise_arma,
+      main_arma,
+      variable_type,
+      baseline_category_arma,
+      iter,
+      seed,
+      nThreads
+    );
+  } else {
+    SafeRNG rng(seed);
+    result = simulate_mrf(
+      num_states,
+      num_variables,
+      num_categories_arma,
+      pairwise_arma,
+      main_arma,
+      variable_type,
+      baseline_category_arma,
+      iter,
+      rng
+    );
+  }
 
   // Check for user interrupt periodically (only in non-parallel context)
   Rcpp::checkUserInterrupt();
@@ -192,9 +468,9 @@ IntegerMatrix sample_bcomrf_gibbs(int num_states,
                                   StringVector variable_type_r,
                                   IntegerVector baseline_category,
                                   int iter,
-                                  int seed) {
-
-  SafeRNG rng(seed);
+                                  int seed,
+                                  bool colored = false,
+                                  int nThreads = 1) {
 
   // Convert inputs to arma/std types
   arma::ivec num_categories_arma = Rcpp::as<arma::ivec>(num_categories);
@@ -212,17 +488,34 @@ IntegerMatrix sample_bcomrf_gibbs(int num_states,
   }
 
   // Simulate observations
-  arma::imat result = simulate_mrf(
-    num_states,
-    num_variables,
-    num_categories_arma,
-    pairwise_arma,
-    main_arma,
-    variable_type,
-    baseline_category_arma,
-    iter,
-    rng
-  );
+  arma::imat result;
+  if (colored) {
+    result = simulate_mrf_colored(
+      num_states,
+      num_variables,
+      num_categories_arma,
+      pairwise_arma,
+      main_arma,
+      variable_type,
+      baseline_category_arma,
+      iter,
+      seed,
+      nThreads
+    );
+  } else {
+    SafeRNG rng(seed);
+    result = simulate_mrf(
+      num_states,
+      num_variables,
+      num_categories_arma,
+      pairwise_arma,
+      main_arma,
+      variable_type,
+      baseline_category_arma,
+      iter,
+      rng
+    );
+  }
 
   // Check for user interrupt (only in non-parallel context)
   Rcpp::checkUserInterrupt();
@@ -235,46 +528,67 @@ IntegerMatrix sample_bcomrf_gibbs(int num_states,
 //   GGM Simulation (Direct Multivariate Normal Sampling)
 // ============================================================================
 
-// Simulate observations from a Gaussian Graphical Model.
+// Simulate observations from a Gaussian Graphical Model into given storage.
 //
 // Given a precision matrix Omega, draws num_states observations from
-// N(means, Omega^{-1}) using the Cholesky factorization of the covariance.
+// N(means, Omega^{-1}) using the Cholesky factor of the precision itself,
+// so the covariance is never formed.
 //
 // Algorithm:
-//   1. Compute Sigma = Omega^{-1} via arma::inv_sympd.
-//   2. Cholesky decompose: L = chol(Sigma, "lower") so Sigma = L L'.
-//   3. Draw Z ~ N(0, I) of size (num_states x p).
-//   4. Return X = ones * means' + Z * L'.
+//   1. Cholesky decompose: U = chol(Omega) so Omega = U' U, and hence
+//      Sigma = U^{-1} U^{-T}.
+//   2. Fill Z ~ N(0, I) of size (p x num_states) in one block, one column
+//      per observation, from the XoshiroLanes stream seeded by rng.
+//   3. Solve U X' = Z over the whole block (one triangular solve with
+//      num_states right-hand sides), giving rows of X with covariance Sigma.
+//   4. Write X + ones * means' into out.
 //
 // @param num_states   Number of observations to simulate.
 // @param precision    p x p positive-definite precision matrix (Omega).
 // @param means        p-vector of variable means (can be all zeros).
 // @param rng          Thread-safe random number generator.
+// @param out          num_states x p destination, typically a view over
+//                     preallocated memory.
 //
-// @return num_states x p matrix of simulated continuous observations.
-arma::mat simulate_ggm(
+// Throws std::runtime_error if the precision is not positive definite.
+void simulate_ggm_into(
     int num_states,
     const arma::mat& precision,
     const arma::vec& means,
-    SafeRNG& rng) {
+    SafeRNG& rng,
+    arma::mat& out) {
 
   int p = precision.n_cols;
 
-  // Covariance = inverse of precision
-  arma::mat sigma = arma::inv_sympd(precision);
+  arma::mat U;
+  if (!arma::chol(U, precision)) {
+    throw std::runtime_error("precision matrix is not positive definite");
+  }
 
-  // Lower Cholesky: sigma = L * L'
-  arma::mat L = arma::chol(sigma, "lower");
+  arma::mat Z(p, num_states);
+  rnorm_fill_lanes(rng, Z.memptr(), Z.n_elem);
 
-  // Draw standard normal matrix: num_states x p
-  arma::mat Z = arma_rnorm_mat(rng, num_states, p);
+  out = arma::solve(arma::trimatu(U), Z).t();
+  out.each_row() += means.t();
+}
 
-  // Transform: X = Z * L' (each row is one observation)
-  arma::mat X = Z * L.t();
 
-  // Add means
-  X.each_row() += means.t();
+// Simulate observations from a Gaussian Graphical Model.
+//
+// @param num_states   Number of observations to simulate.
+// @param precision    p x p positive-definite precision matrix (Omega).
+// @param means        p-vector of variable means (can be all zeros).
+// @param rng          Thread-safe random number generator.
+//
+// @return num_states x p matrix of simulated continuous observations.
+arma::mat simulate_ggm(
+    int num_states,
+    const arma::mat& precision,
+    const arma::vec& means,
+    SafeRNG& rng) {
 
+  arma::mat X(num_states, precision.n_cols);
+  simulate_ggm_into(num_states, precision, means, rng, X);
   return X;
 }
 
@@ -376,7 +690,6 @@ public:
   {}
 
   void operator()(std::size_t begin, std::size_t end) {
-    bool is_main = (begin == 0);
     for (std::size_t i = begin; i < end; ++i) {
       if (pm.shouldExit()) return;
 
@@ -430,7 +743,7 @@ public:
       }
 
       results[i] = result;
-      if (is_main) pm.update(0);
+      pm.update(0);
     }
   }
 };
@@ -491,11 +804,8 @@ Rcpp::List run_simulation_parallel(
     }
   }
 
-  // Prepare one independent RNG per draw
-  std::vector<SafeRNG> draw_rngs(ndraws);
-  for (int d = 0; d < ndraws; d++) {
-    draw_rngs[d] = SafeRNG(seed + d);
-  }
+  // Prepare one independent RNG stream per draw
+  const std::vector<SafeRNG> draw_rngs = rng_streams(seed, ndraws);
 
   // Prepare results storage
   std::vector<SimulationResult> results(ndraws);
@@ -518,11 +828,11 @@ Rcpp::List run_simulation_parallel(
     results
   );
 
-  {
-    tbb::global_control control(
-      tbb::global_control::max_allowed_parallelism, nThreads);
-    parallelFor(0, ndraws, worker);
-  }
+  pm.run_with_reporter([&] {
+    run_in_arena(nThreads, [&] {
+      parallel_for_tasks(static_cast<std::size_t>(ndraws), worker);
+    });
+  });
   pm.finish();
 
   // Convert results to R list
@@ -543,16 +853,11 @@ Rcpp::List run_simulation_parallel(
 //   Parallel GGM Simulation for simulate.bgms() with Posterior Draws
 // ============================================================================
 
-// Structure to hold GGM simulation results
-struct GGMSimulationResult {
-  arma::mat observations;
-  int draw_index;
-  bool error;
-  std::string error_msg;
-};
-
-
-// Worker class for parallel GGM simulation across posterior draws
+// Worker class for parallel GGM simulation across posterior draws.
+//
+// Each draw writes its num_states x p block straight into the slice of the
+// preallocated output array; nothing is allocated per draw beyond the
+// precision, its factor and the normal block.
 class GGMSimulationWorker : public RcppParallel::Worker {
 public:
   const arma::mat& pairwise_samples;
@@ -563,7 +868,8 @@ public:
   const arma::vec& means;
   const std::vector<SafeRNG>& draw_rngs;
   ProgressManager& pm;
-  std::vector<GGMSimulationResult>& results;
+  double* output;
+  std::vector<std::string>& errors;
 
   GGMSimulationWorker(
     const arma::mat& pairwise_samples,
@@ -574,7 +880,8 @@ public:
     const arma::vec& means,
     const std::vector<SafeRNG>& draw_rngs,
     ProgressManager& pm,
-    std::vector<GGMSimulationResult>& results
+    double* output,
+    std::vector<std::string>& errors
   ) :
     pairwise_samples(pairwise_samples),
     main_samples(main_samples),
@@ -584,18 +891,17 @@ public:
     means(means),
     draw_rngs(draw_rngs),
     pm(pm),
-    results(results)
+    output(output),
+    errors(errors)
   {}
 
   void operator()(std::size_t begin, std::size_t end) {
-    bool is_main = (begin == 0);
+    const std::size_t slice_size =
+      static_cast<std::size_t>(num_states) * num_variables;
+
     for (std::size_t i = begin; i < end; ++i) {
       if (pm.shouldExit()) return;
 
-      GGMSimulationResult result;
-      result.draw_index = draw_indices[i];
-      result.error = false;
-
       try {
         SafeRNG rng = draw_rngs[i];
 
@@ -613,23 +919,17 @@ public:
           precision(v, v) = main_samples(draw_indices[i] - 1, v);
         }
 
-        result.observations = simulate_ggm(
-          num_states,
-          precision,
-          means,
-          rng
-        );
+        arma::mat slice(output + i * slice_size, num_states, num_variables,
+                        false, true);
+        simulate_ggm_into(num_states, precision, means, rng, slice);
 
       } catch (const std::exception& e) {
-        result.error = true;
-        result.error_msg = e.what();
+        errors[i] = e.what();
       } catch (...) {
-        result.error = true;
-        result.error_msg = "Unknown error";
+        errors[i] = "Unknown error";
       }
 
-      results[i] = result;
-      if (is_main) pm.update(0);
+      pm.update(0);
     }
   }
 };
@@ -637,6 +937,9 @@ public:
 
 // Run parallel GGM simulations across posterior draws.
 //
+// The output array is allocated on the main thread before the workers
+// start; each worker fills its draws' slices in place.
+//
 // @param pairwise_samples  Matrix of off-diagonal precision samples (ndraws x p*(p-1)/2)
 // @param main_samples      Matrix of diagonal precision samples (ndraws x p)
 // @param draw_indices      1-based indices of which draws to use
@@ -647,9 +950,10 @@ public:
 // @param seed              Random seed
 // @param progress_type     Progress bar type (0=none, 1=total, 2=per-chain)
 //
-// @return List of simulation results (each is a numeric matrix n x p)
+// @return num_states x p x ndraws numeric array; slice i holds the
+//   observations simulated from draw_indices[i]
 // [[Rcpp::export]]
-Rcpp::List run_ggm_simulation_parallel(
+Rcpp::NumericVector run_ggm_simulation_parallel(
     const arma::mat& pairwise_samples,
     const arma::mat& main_samples,
     const arma::ivec& draw_indices,
@@ -662,13 +966,15 @@ Rcpp::List run_ggm_simulation_parallel(
 
   int ndraws = draw_indices.n_elem;
 
-  // Prepare one independent RNG per draw
-  std::vector<SafeRNG> draw_rngs(ndraws);
-  for (int d = 0; d < ndraws; d++) {
-    draw_rngs[d] = SafeRNG(seed + d);
-  }
+  // Prepare one independent RNG stream per draw
+  const std::vector<SafeRNG> draw_rngs = rng_streams(seed, ndraws);
+
+  Rcpp::NumericVector output(Rcpp::no_init(
+    static_cast<R_xlen_t>(num_states) * num_variables * ndraws));
+  output.attr("dim") = Rcpp::IntegerVector::create(
+    num_states, num_variables, ndraws);
 
-  std::vector<GGMSimulationResult> results(ndraws);
+  std::vector<std::string> errors(ndraws);
   ProgressManager pm(1, ndraws, 0, 50, progress_type);
 
   GGMSimulationWorker worker(
@@ -680,23 +986,22 @@ Rcpp::List run_ggm_simulation_parallel(
     means,
     draw_rngs,
     pm,
-    results
+    output.begin(),
+    errors
   );
 
-  {
-    tbb::global_control control(
-      tbb::global_control::max_allowed_parallelism, nThreads);
-    parallelFor(0, ndraws, worker);
-  }
+  pm.run_with_reporter([&] {
+    run_in_arena(nThreads, [&] {
+      parallel_for_tasks(static_cast<std::size_t>(ndraws), worker);
+    });
+  });
   pm.finish();
 
-  Rcpp::List output(ndraws);
   for (int i = 0; i < ndraws; i++) {
-    if (results[i].error) {
+    if (!errors[i].empty()) {
       Rcpp::stop("Error in GGM simulation draw %d: %s",
-                 results[i].draw_index, results[i].error_msg.c_str());
+                 draw_indices[i], errors[i].c_str());
     }
-    output[i] = Rcpp::wrap(results[i].observations);
   }
 
   return output;
@@ -757,6 +1062,9 @@ void simulate_mixed_mrf(
   arma::mat disc_safe = pairwise_disc;
   disc_safe.diag().zeros();
 
+  // Log-probabilities of one discrete variable's categories
+  std::vector<double> log_probs(p > 0 ? num_categories.max() + 1 : 0);
+
   // Generate each observation independently
   for (int obs = 0; obs < num_states; obs++) {
     // Initialize discrete variables uniformly
@@ -801,50 +1109,20 @@ void simulate_mixed_mrf(
           double alpha = mux(s, 0);
           double beta  = mux(s, 1);
 
-          // Compute log-probabilities for categories 0..Cs
-          arma::vec log_probs(Cs + 1);
-          double max_lp = -std::numeric_limits<double>::infinity();
+          // Log-probabilities for categories 0..Cs
           for (int c = 0; c <= Cs; c++) {
             int d = c - ref;
-            log_probs(c) = alpha * d + beta * d * d + d * rest;
-            if (log_probs(c) > max_lp) max_lp = log_probs(c);
-          }
-
-          // Stabilize and convert to cumulative probabilities
-          double cumsum = 0.0;
-          arma::vec cum_probs(Cs + 1);
-          for (int c = 0; c <= Cs; c++) {
-            cumsum += std::exp(log_probs(c) - max_lp);
-            cum_probs(c) = cumsum;
+            log_probs[c] = alpha * d + beta * d * d + d * rest;
           }
-
-          // Sample
-          double u = runif(rng) * cumsum;
-          int sampled = 0;
-          while (sampled < Cs && u > cum_probs(sampled)) sampled++;
-          x_current(s) = sampled;
+          x_current(s) = sample_categorical_log(log_probs.data(), Cs + 1, runif(rng));
 
         } else {
           // Ordinal: category 0 is reference with log-prob = 0
-          arma::vec log_probs(Cs + 1);
-          log_probs(0) = 0.0;
-          double max_lp = 0.0;
+          log_probs[0] = 0.0;
           for (int c = 1; c <= Cs; c++) {
-            log_probs(c) = mux(s, c - 1) + c * rest;
-            if (log_probs(c) > max_lp) max_lp = log_probs(c);
+            log_probs[c] = mux(s, c - 1) + c * rest;
           }
-
-          double cumsum = 0.0;
-          arma::vec cum_probs(Cs + 1);
-          for (int c = 0; c <= Cs; c++) {
-            cumsum += std::exp(log_probs(c) - max_lp);
-            cum_probs(c) = cumsum;
-          }
-
-          double u = runif(rng) * cumsum;
-          int sampled = 0;
-          while (sampled < Cs && u > cum_probs(sampled)) sampled++;
-          x_current(s) = sampled;
+          x_current(s) = sample_categorical_log(log_probs.data(), Cs + 1, runif(rng));
         }
       }
 
@@ -872,10 +1150,107 @@ void simulate_mixed_mrf(
 }
 
 
+// Simulate observations from a mixed MRF with the same block Gibbs sampler
+// as simulate_mixed_mrf(), run for all observations at once.
+//
+// The observations are independent chains, so each update can be made for
+// all of them together: a discrete variable is redrawn one column at a
+// time, as in simulate_mrf(), and the continuous block in one multivariate
+// normal step. The state carried between updates is
+//   - rest:  n x p discrete rest scores, 2 (x - ref) pairwise_disc; after
+//            a column is redrawn only the columns of its neighbours change,
+//   - cross: n x p continuous part of the rest scores, 2 y pairwise_cross',
+//            one product after each continuous step,
+// and the continuous step draws y = muy' + 2 (x - ref) cross_sigma + Z L'
+// with the Cholesky factor L of the conditional covariance computed once.
+//
+// Same inputs and outputs as simulate_mixed_mrf(). It targets the same
+// distribution but consumes the random numbers in a different order, so
+// the sample for a given seed differs.
+void simulate_mixed_mrf_vectorized(
+    int num_states,
+    const arma::mat& pairwise_disc,
+    const arma::mat& pairwise_cross,
+    const arma::mat& pairwise_cont,
+    const arma::mat& mux,
+    const arma::vec& muy,
+    const arma::ivec& num_categories,
+    const std::vector<std::string>& variable_type,
+    const arma::ivec& baseline_category,
+    int iter,
+    SafeRNG& rng,
+    arma::imat& x_out,
+    arma::mat& y_out) {
+
+  const int p = pairwise_disc.n_rows;
+  const int q = pairwise_cont.n_rows;
+
+  // Conditional covariance of y given x and its Cholesky factor
+  const arma::mat Sigma_y = arma::inv_sympd(-2.0 * pairwise_cont);
+  const arma::mat L_Sigma = arma::chol(Sigma_y, "lower");
+  const arma::mat mean_shift = 2.0 * pairwise_cross * Sigma_y;  // p x q
+
+  arma::mat disc_safe = pairwise_disc;
+  disc_safe.diag().zeros();
+  const auto neighbours = mrf_neighbours(disc_safe);
+
+  std::vector<char> is_blume_capel(p);
+  for (int s = 0; s < p; s++) {
+    is_blume_capel[s] = (variable_type[s] == "blume-capel");
+  }
+  const arma::rowvec baseline = arma::conv_to<arma::rowvec>::from(baseline_category.t());
+
+  // Discrete start uniform, continuous from N(muy, Sigma_y)
+  x_out = initial_mrf_state(num_states, p, num_categories, rng);
+  arma::mat z(q, num_states);
+  rnorm_fill_lanes(rng, z.memptr(), z.n_elem);
+  y_out = (L_Sigma * z).t();
+  y_out.each_row() += muy.t();
+
+  arma::mat x_centered = arma::conv_to<arma::mat>::from(x_out);
+  x_centered.each_row() -= baseline;
+  arma::mat rest = 2.0 * x_centered * disc_safe;
+  arma::mat cross = 2.0 * y_out * pairwise_cross.t();
+
+  arma::vec probabilities(p > 0 ? arma::max(num_categories) + 1 : 1);
+  arma::vec delta(num_states);
+
+  for (int it = 0; it < iter; it++) {
+    // --- Discrete variables, one column at a time ---
+    for (int s = 0; s < p; s++) {
+      const double* rest_col = rest.colptr(s);
+      const double* cross_col = cross.colptr(s);
+      int* x_col = x_out.colptr(s);
+      double* centered_col = x_centered.colptr(s);
+      for (int person = 0; person < num_states; person++) {
+        const int score = draw_mrf_category(
+          s, rest_col[person] + cross_col[person], num_categories, mux,
+          is_blume_capel[s], baseline_category[s], probabilities, rng
+        );
+        delta[person] = score - x_col[person];
+        x_col[person] = score;
+        centered_col[person] = score - baseline_category[s];
+      }
+      for (const MRFNeighbour& nb : neighbours[s]) {
+        rest.col(nb.variable) += nb.weight * delta;
+      }
+    }
+
+    // --- Continuous block for all observations ---
+    rnorm_fill_lanes(rng, z.memptr(), z.n_elem);
+    y_out = x_centered * mean_shift + (L_Sigma * z).t();
+    y_out.each_row() += muy.t();
+    cross = 2.0 * y_out * pairwise_cross.t();
+  }
+}
+
+
 // ============================================================================
 //   R Interface for Mixed MRF Simulation (standalone)
 // ============================================================================
 
+// With vectorized = TRUE, simulate_mixed_mrf_vectorized() is used.
+
 // [[Rcpp::export]]
 Rcpp::List sample_mixed_mrf_gibbs(
     int num_states,
@@ -888,7 +1263,8 @@ Rcpp::List sample_mixed_mrf_gibbs(
     Rcpp::StringVector variable_type_r,
     IntegerVector baseline_category_r,
     int iter,
-    int seed) {
+    int seed,
+    bool vectorized = false) {
 
   SafeRNG rng(seed);
 
@@ -915,7 +1291,8 @@ Rcpp::List sample_mixed_mrf_gibbs(
   arma::imat x_out(num_states, p);
   arma::mat y_out(num_states, q);
 
-  simulate_mixed_mrf(
+  const auto simulate = vectorized ? simulate_mixed_mrf_vectorized : simulate_mixed_mrf;
+  simulate(
     num_states, pairwise_disc, pairwise_cross, pairwise_cont, mux, muy,
     num_categories, variable_type, baseline_category,
     iter, rng, x_out, y_out
@@ -959,6 +1336,7 @@ public:
   const std::vector<std::string>& variable_type;
   const arma::ivec& baseline_category;
   const int iter;
+  const bool vectorized;
   const arma::ivec& mux_param_counts;
 
   const std::vector<SafeRNG>& draw_rngs;
@@ -978,6 +1356,7 @@ public:
     const std::vector<std::string>& variable_type,
     const arma::ivec& baseline_category,
     int iter,
+    bool vectorized,
     const arma::ivec& mux_param_counts,
     const std::vector<SafeRNG>& draw_rngs,
     ProgressManager& pm,
@@ -995,6 +1374,7 @@ public:
     variable_type(variable_type),
     baseline_category(baseline_category),
     iter(iter),
+    vectorized(vectorized),
     mux_param_counts(mux_param_counts),
     draw_rngs(draw_rngs),
     pm(pm),
@@ -1002,7 +1382,6 @@ public:
   {}
 
   void operator()(std::size_t begin, std::size_t end) {
-    bool is_main = (begin == 0);
     for (std::size_t i = begin; i < end; i++) {
       if (pm.shouldExit()) return;
 
@@ -1071,7 +1450,8 @@ public:
         result.x_observations.set_size(num_states, p);
         result.y_observations.set_size(num_states, q);
 
-        simulate_mixed_mrf(
+        const auto simulate = vectorized ? simulate_mixed_mrf_vectorized : simulate_mixed_mrf;
+        simulate(
           num_states, pairwise_disc, pairwise_cross, pairwise_cont, mux, muy,
           num_categories, variable_type, baseline_category,
           iter, rng,
@@ -1087,7 +1467,7 @@ public:
       }
 
       results[i] = result;
-      if (is_main) pm.update(0);
+      pm.update(0);
     }
   }
 };
@@ -1114,6 +1494,8 @@ public:
 // @param nThreads        Number of threads
 // @param seed            Random seed
 // @param progress_type   Progress bar type
+// @param vectorized      Use simulate_mixed_mrf_vectorized() instead of
+//                        the per-observation simulate_mixed_mrf()
 //
 // @return List of lists, each containing "x" (integer matrix) and "y" (numeric matrix).
 // [[Rcpp::export]]
@@ -1133,7 +1515,8 @@ Rcpp::List run_mixed_simulation_parallel(
     int iter,
     int nThreads,
     int seed,
-    int progress_type) {
+    int progress_type,
+    bool vectorized = false) {
 
   int ndraws = draw_indices.n_elem;
 
@@ -1156,10 +1539,7 @@ Rcpp::List run_mixed_simulation_parallel(
     }
   }
 
-  std::vector<SafeRNG> draw_rngs(ndraws);
-  for (int d = 0; d < ndraws; d++) {
-    draw_rngs[d] = SafeRNG(seed + d);
-  }
+  const std::vector<SafeRNG> draw_rngs = rng_streams(seed, ndraws);
 
   std::vector<MixedSimulationResult> results(ndraws);
   ProgressManager pm(1, ndraws, 0, 50, progress_type);
@@ -1168,14 +1548,14 @@ Rcpp::List run_mixed_simulation_parallel(
     mux_samples, disc_samples, muy_samples, cont_samples, cross_samples,
     draw_indices, num_states, p, q,
     num_categories, variable_type, baseline_category_safe,
-    iter, mux_param_counts, draw_rngs, pm, results
+    iter, vectorized, mux_param_counts, draw_rngs, pm, results
   );
 
-  {
-    tbb::global_control control(
-      tbb::global_control::max_allowed_parallelism, nThreads);
-    parallelFor(0, ndraws, worker);
-  }
+  pm.run_with_reporter([&] {
+    run_in_arena(nThreads, [&] {
+      parallel_for_tasks(static_cast<std::size_t>(ndraws), worker);
+    });
+  });
   pm.finish();
 
   Rcpp::List output(ndraws);
@@ -0,0 +1,90 @@
+#pragma once
+
+/**
+ * @file mrf_simulation.h
+ * @brief Simulation kernels of mrf_simulation.cpp, for use inside the
+ *        samplers (see PredictiveChecks).
+ *
+ * The kernels draw from the RNG they are given, so a chain that simulates
+ * from its own stream stays reproducible. Parameters are in the layout of
+ * the models: main effects variables x max_categories (thresholds, or the
+ * linear and quadratic Blume-Capel terms in columns 0 and 1), pairwise
+ * matrices symmetric with the diagonal ignored.
+ */
+
+#include <RcppArmadillo.h>
+#include <string>
+#include <vector>
+#include "rng/rng_utils.h"
+
+
+/**
+ * Gibbs sampler for an ordinal / Blume-Capel MRF.
+ *
+ * @param iter  Gibbs sweeps from a random starting state
+ * @return num_states x num_variables matrix of category scores
+ */
+arma::imat simulate_mrf(
+    int num_states,
+    int num_variables,
+    const arma::ivec& num_categories,
+    const arma::mat& pairwise,
+    const arma::mat& main,
+    const std::vector<std::string>& variable_type,
+    const arma::ivec& baseline_category,
+    int iter,
+    SafeRNG& rng);
+
+
+/**
+ * Exact draws from a Gaussian graphical model.
+ *
+ * @throws std::runtime_error if the precision is not positive definite
+ * @return num_states x p matrix of observations
+ */
+arma::mat simulate_ggm(
+    int num_states,
+    const arma::mat& precision,
+    const arma::vec& means,
+    SafeRNG& rng);
+
+
+/**
+ * Block Gibbs sampler for a mixed MRF: the discrete variables into `x_out`
+ * (num_states x p), the continuous ones into `y_out` (num_states x q).
+ */
+void simulate_mixed_mrf(
+    int num_states,
+    const arma::mat& pairwise_disc,
+    const arma::mat& pairwise_cross,
+    const arma::mat& pairwise_cont,
+    const arma::mat& mux,
+    const arma::vec& muy,
+    const arma::ivec& num_categories,
+    const std::vector<std::string>& variable_type,
+    const arma::ivec& baseline_category,
+    int iter,
+    SafeRNG& rng,
+    arma::imat& x_out,
+    arma::mat& y_out);
+
+
+/**
+ * simulate_mixed_mrf() for all observations at once: each discrete
+ * variable is redrawn column-wise and the continuous block in one
+ * multivariate normal step. Same distribution, different draws per seed.
+ */
+void simulate_mixed_mrf_vectorized(
+    int num_states,
+    const arma::mat& pairwise_disc,
+    const arma::mat& pairwise_cross,
+    const arma::mat& pairwise_cont,
+    const arma::mat& mux,
+    const arma::vec& muy,
+    const arma::ivec& num_categories,
+    const std::vector<std::string>& variable_type,
+    const arma::ivec& baseline_category,
+    int iter,
+    SafeRNG& rng,
+    arma::imat& x_out,
+    arma::mat& y_out);
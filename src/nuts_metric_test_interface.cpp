@@ -0,0 +1,67 @@
+// nuts_metric_test_interface.cpp - test-only interface
+//
+// Exposes LinearMetric as matrices so tests/testthat can check the dense and
+// low-rank factorizations (A A^T = Sigma, A^{-1} A = I, pull_back = A^T) and
+// their restriction to a subset of the parameters.
+#include <RcppArmadillo.h>
+
+#include "mcmc/algorithms/nuts_metric.h"
+
+namespace {
+
+// Applies `map` to each column of the d x d identity.
+template <typename Map>
+arma::mat as_matrix(arma::uword dim, Map map) {
+    arma::mat out(dim, dim);
+    arma::vec e(dim);
+    for (arma::uword k = 0; k < dim; ++k) {
+        e.zeros();
+        e(k) = 1.0;
+        out.col(k) = map(e);
+    }
+    return out;
+}
+
+Rcpp::List metric_matrices(const LinearMetric& metric, arma::uword dim) {
+    return Rcpp::List::create(
+        Rcpp::Named("A") = as_matrix(dim, [&](const arma::vec& y) {
+            return metric.to_position(y);
+        }),
+        Rcpp::Named("A_inv") = as_matrix(dim, [&](const arma::vec& theta) {
+            return metric.to_latent(theta);
+        }),
+        Rcpp::Named("A_t") = as_matrix(dim, [&](const arma::vec& grad) {
+            return metric.pull_back(grad);
+        })
+    );
+}
+
+}  // namespace
+
+// Builds the metric the warmup would fit to covariance `cov`: the dense
+// Cholesky factor, or the diagonal plus the rank-`rank` factor of
+// low_rank_covariance_factor(). `active` holds 0-based indices for
+// LinearMetric::restrict().
+//
+// [[Rcpp::export]]
+Rcpp::List test_nuts_metric(
+    const arma::mat& cov,
+    const std::string& metric,
+    const int rank,
+    const arma::uvec& active
+) {
+    LinearMetric m;
+    arma::mat factor;
+    if (metric_kind_from_string(metric) == MetricKind::Dense) {
+        m.set_dense(cov);
+    } else {
+        factor = low_rank_covariance_factor(cov, rank);
+        m.set_low_rank(cov.diag(), factor);
+    }
+
+    return Rcpp::List::create(
+        Rcpp::Named("full") = metric_matrices(m, cov.n_rows),
+        Rcpp::Named("restricted") = metric_matrices(m.restrict(active), active.n_elem),
+        Rcpp::Named("factor") = factor
+    );
+}
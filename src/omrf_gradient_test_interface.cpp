@@ -0,0 +1,249 @@
+// omrf_gradient_test_interface.cpp - test-only interface
+//
+// Exposes OMRFModel::logp_and_gradient with a configurable number of
+// gradient threads or the GPU backend, and lets tests force the dense or
+// sparse pairwise gradient path. Used by tests/testthat to check that the
+// within-chain parallel gradient returns the same value and gradient as
+// the serial one, that the GPU gradient agrees with the CPU one (also over
+// repeated calls and in a copied model), that the sparse active-set path
+// agrees with the dense one, and that the batched gradient of several
+// chains agrees with their own evaluations.
+#include <RcppArmadillo.h>
+#include <memory>
+#include <vector>
+
+#include "models/omrf/omrf_model.h"
+#include "priors/parameter_prior.h"
+
+// Build an OMRF model with all edges included, optionally collapse
+// duplicate response patterns, then evaluate the log-pseudoposterior and
+// its gradient at `parameters` using `num_threads` gradient threads or,
+// with gradient_backend = "gpu", the CUDA backend.
+//
+// [[Rcpp::export]]
+Rcpp::List test_omrf_logp_and_gradient(
+    const arma::imat& observations,
+    const arma::ivec& num_categories,
+    const arma::uvec& is_ordinal,
+    const arma::ivec& baseline_category,
+    const arma::vec& parameters,
+    const int num_threads = 1,
+    const bool compress = false,
+    const std::string& gradient_backend = "cpu"
+) {
+    const int p = static_cast<int>(observations.n_cols);
+
+    arma::mat  incl_prob = 0.5 * arma::ones<arma::mat>(p, p);
+    arma::imat edges     = arma::ones<arma::imat>(p, p);
+    edges.diag().zeros();
+
+    auto interaction_prior = create_parameter_prior("cauchy", 2.5, NA_REAL, NA_REAL);
+    auto threshold_prior   = create_parameter_prior("beta-prime", 1.0, 0.5, 0.5);
+
+    OMRFModel model(
+        observations, num_categories, incl_prob, edges,
+        is_ordinal, baseline_category,
+        std::move(interaction_prior), std::move(threshold_prior),
+        /*edge_selection=*/false);
+
+    if (parameters.n_elem != model.parameter_dimension()) {
+        Rcpp::stop("parameters must have length %d", static_cast<int>(model.parameter_dimension()));
+    }
+
+    if (compress) {
+        model.compress_patterns();
+    }
+    model.set_gradient_threads(num_threads);
+    model.set_gradient_backend(gradient_backend);
+    auto result = model.logp_and_gradient(parameters);
+
+    return Rcpp::List::create(
+        Rcpp::Named("value")    = result.first,
+        Rcpp::Named("gradient") = result.second,
+        Rcpp::Named("num_rows") = static_cast<int>(model.num_observations())
+    );
+}
+
+
+// Build an OMRF model with the given edge indicators and evaluate the
+// log-pseudoposterior and its gradient at `parameters` twice: once forcing
+// the dense X^T E product and once forcing the per-neighbour sparse path.
+//
+// [[Rcpp::export]]
+Rcpp::List test_omrf_sparse_gradient(
+    const arma::imat& observations,
+    const arma::ivec& num_categories,
+    const arma::uvec& is_ordinal,
+    const arma::ivec& baseline_category,
+    const arma::imat& edge_indicators,
+    const arma::vec& parameters
+) {
+    const int p = static_cast<int>(observations.n_cols);
+
+    arma::mat incl_prob = 0.5 * arma::ones<arma::mat>(p, p);
+
+    auto interaction_prior = create_parameter_prior("cauchy", 2.5, NA_REAL, NA_REAL);
+    auto threshold_prior   = create_parameter_prior("beta-prime", 1.0, 0.5, 0.5);
+
+    OMRFModel model(
+        observations, num_categories, incl_prob, edge_indicators,
+        is_ordinal, baseline_category,
+        std::move(interaction_prior), std::move(threshold_prior),
+        /*edge_selection=*/true);
+
+    if (parameters.n_elem != model.parameter_dimension()) {
+        Rcpp::stop("parameters must have length %d", static_cast<int>(model.parameter_dimension()));
+    }
+
+    model.set_sparse_gradient_max_density(-1.0);
+    auto dense = model.logp_and_gradient(parameters);
+    model.set_sparse_gradient_max_density(2.0);
+    auto sparse = model.logp_and_gradient(parameters);
+
+    return Rcpp::List::create(
+        Rcpp::Named("dense_value")     = dense.first,
+        Rcpp::Named("dense_gradient")  = dense.second,
+        Rcpp::Named("sparse_value")    = sparse.first,
+        Rcpp::Named("sparse_gradient") = sparse.second
+    );
+}
+
+
+// Evaluate the log-pseudoposterior and its gradient at each column of
+// `parameter_sets` three ways: on the CPU, with the GPU backend, and with
+// the GPU backend of a copy of that model (the copy shares the device
+// scores but has its own buffers and stream). Every point reuses the
+// device buffers of the previous one. Without the CUDA backend this stops
+// with the error set_gradient_backend() raises.
+//
+// [[Rcpp::export]]
+Rcpp::List test_omrf_gpu_gradient(
+    const arma::imat& observations,
+    const arma::ivec& num_categories,
+    const arma::uvec& is_ordinal,
+    const arma::ivec& baseline_category,
+    const arma::mat& parameter_sets
+) {
+    const int p = static_cast<int>(observations.n_cols);
+
+    arma::mat  incl_prob = 0.5 * arma::ones<arma::mat>(p, p);
+    arma::imat edges     = arma::ones<arma::imat>(p, p);
+    edges.diag().zeros();
+
+    OMRFModel cpu(
+        observations, num_categories, incl_prob, edges,
+        is_ordinal, baseline_category,
+        create_parameter_prior("cauchy", 2.5, NA_REAL, NA_REAL),
+        create_parameter_prior("beta-prime", 1.0, 0.5, 0.5),
+        /*edge_selection=*/false);
+
+    if (parameter_sets.n_rows != cpu.parameter_dimension()) {
+        Rcpp::stop("parameter_sets must have %d rows", static_cast<int>(cpu.parameter_dimension()));
+    }
+
+    OMRFModel gpu(cpu);
+    gpu.set_gradient_backend("gpu");
+    OMRFModel gpu_copy(gpu);
+
+    const arma::uword num_points = parameter_sets.n_cols;
+    arma::vec value_cpu(num_points), value_gpu(num_points), value_copy(num_points);
+    arma::mat gradient_cpu(parameter_sets.n_rows, num_points);
+    arma::mat gradient_gpu(parameter_sets.n_rows, num_points);
+    arma::mat gradient_copy(parameter_sets.n_rows, num_points);
+
+    for (arma::uword k = 0; k < num_points; ++k) {
+        const arma::vec parameters = parameter_sets.col(k);
+        auto on_cpu = cpu.logp_and_gradient(parameters);
+        auto on_gpu = gpu.logp_and_gradient(parameters);
+        auto on_copy = gpu_copy.logp_and_gradient(parameters);
+        value_cpu(k) = on_cpu.first;
+        value_gpu(k) = on_gpu.first;
+        value_copy(k) = on_copy.first;
+        gradient_cpu.col(k) = on_cpu.second;
+        gradient_gpu.col(k) = on_gpu.second;
+        gradient_copy.col(k) = on_copy.second;
+    }
+
+    return Rcpp::List::create(
+        Rcpp::Named("value_cpu")     = value_cpu,
+        Rcpp::Named("value_gpu")     = value_gpu,
+        Rcpp::Named("value_copy")    = value_copy,
+        Rcpp::Named("gradient_cpu")  = gradient_cpu,
+        Rcpp::Named("gradient_gpu")  = gradient_gpu,
+        Rcpp::Named("gradient_copy") = gradient_copy
+    );
+}
+
+
+// Evaluate the log-pseudoposterior and its gradient of one chain per
+// column of `parameter_sets`, each chain a copy of one model that shares
+// its observations: first every chain on its own, then all of them in one
+// logp_and_gradient_batch() call on the first chain, twice, so the second
+// call reuses the batch buffers.
+//
+// [[Rcpp::export]]
+Rcpp::List test_omrf_batched_gradient(
+    const arma::imat& observations,
+    const arma::ivec& num_categories,
+    const arma::uvec& is_ordinal,
+    const arma::ivec& baseline_category,
+    const arma::mat& parameter_sets,
+    const int num_threads = 1,
+    const bool compress = false
+) {
+    const int p = static_cast<int>(observations.n_cols);
+
+    arma::mat  incl_prob = 0.5 * arma::ones<arma::mat>(p, p);
+    arma::imat edges     = arma::ones<arma::imat>(p, p);
+    edges.diag().zeros();
+
+    OMRFModel model(
+        observations, num_categories, incl_prob, edges,
+        is_ordinal, baseline_category,
+        create_parameter_prior("cauchy", 2.5, NA_REAL, NA_REAL),
+        create_parameter_prior("beta-prime", 1.0, 0.5, 0.5),
+        /*edge_selection=*/false);
+
+    if (parameter_sets.n_rows != model.parameter_dimension()) {
+        Rcpp::stop("parameter_sets must have %d rows", static_cast<int>(model.parameter_dimension()));
+    }
+    if (compress) {
+        model.compress_patterns();
+    }
+    model.set_gradient_threads(num_threads);
+
+    const arma::uword num_chains = parameter_sets.n_cols;
+    std::vector<std::unique_ptr<OMRFModel>> chains;
+    std::vector<BaseModel*> batch;
+    std::vector<arma::vec> parameters;
+    for (arma::uword k = 0; k < num_chains; ++k) {
+        chains.push_back(std::make_unique<OMRFModel>(model));
+        batch.push_back(chains.back().get());
+        parameters.push_back(parameter_sets.col(k));
+    }
+
+    arma::vec value_separate(num_chains), value_batched(num_chains);
+    arma::mat gradient_separate(parameter_sets.n_rows, num_chains);
+    arma::mat gradient_batched(parameter_sets.n_rows, num_chains);
+    for (arma::uword k = 0; k < num_chains; ++k) {
+        auto result = chains[k]->logp_and_gradient(parameters[k]);
+        value_separate(k) = result.first;
+        gradient_separate.col(k) = result.second;
+    }
+
+    std::vector<std::pair<double, arma::vec>> results;
+    for (int call = 0; call < 2; ++call) {
+        chains.front()->logp_and_gradient_batch(batch, parameters, results);
+    }
+    for (arma::uword k = 0; k < num_chains; ++k) {
+        value_batched(k) = results[k].first;
+        gradient_batched.col(k) = results[k].second;
+    }
+
+    return Rcpp::List::create(
+        Rcpp::Named("value_separate")    = value_separate,
+        Rcpp::Named("value_batched")     = value_batched,
+        Rcpp::Named("gradient_separate") = gradient_separate,
+        Rcpp::Named("gradient_batched")  = gradient_batched
+    );
+}
@@ -0,0 +1,151 @@
+// omrf_imputation_test_interface.cpp - test-only interface
+//
+// Exposes a harness to verify that OMRFModel::impute_missing(), which
+// redraws the missing cells of one variable as a block, draws what the
+// per-cell Gibbs scan it replaced does from the same seed. Used by
+// tests/testthat.
+#include <RcppArmadillo.h>
+
+#include "math/explog_macros.h"
+#include "models/omrf/omrf_model.h"
+#include "priors/parameter_prior.h"
+#include "rng/rng_utils.h"
+
+namespace {
+
+OMRFModel build_imputation_model(
+    const arma::imat& observations,
+    const arma::ivec& num_categories,
+    const arma::uvec& is_ordinal,
+    const arma::ivec& baseline_category,
+    const arma::mat& main_effects,
+    const arma::mat& pairwise_effects
+) {
+    const int p = static_cast<int>(observations.n_cols);
+    arma::mat  incl_prob = 0.5 * arma::ones<arma::mat>(p, p);
+    arma::imat edges     = arma::ones<arma::imat>(p, p);
+    edges.diag().zeros();
+
+    OMRFModel model(
+        observations, num_categories, incl_prob, edges,
+        is_ordinal, baseline_category,
+        create_parameter_prior("cauchy", 2.5, NA_REAL, NA_REAL),
+        create_parameter_prior("beta-prime", 1.0, 0.5, 0.5),
+        /*edge_selection=*/false);
+    model.set_main_effects(main_effects);
+    model.set_pairwise_effects(pairwise_effects);
+    return model;
+}
+
+} // namespace
+
+// Run `sweeps` imputation sweeps on an OMRF model with the cells of
+// `missing_index` (0-based person, variable rows, ordered by variable as
+// bgm() passes them) missing, next to the per-cell scan: one uniform per
+// cell in `missing_index` order, inverse-transform sampling from running
+// sums, and the residuals updated after every changed cell. Both draw from
+// `seed`. Returns both residual matrices after the last sweep, the imputed
+// values of the scan (cells x sweeps, raw categories), and the
+// log-pseudoposterior and gradient of the imputed model next to those of a
+// model built from the scan's completed data.
+//
+// [[Rcpp::export]]
+Rcpp::List test_omrf_impute_missing(
+    const arma::imat& observations,
+    const arma::imat& missing_index,
+    const arma::ivec& num_categories,
+    const arma::uvec& is_ordinal,
+    const arma::ivec& baseline_category,
+    const arma::mat& main_effects,
+    const arma::mat& pairwise_effects,
+    const int sweeps,
+    const int seed
+) {
+    const int num_variables = static_cast<int>(observations.n_cols);
+    const int num_missings = static_cast<int>(missing_index.n_rows);
+
+    OMRFModel model = build_imputation_model(
+        observations, num_categories, is_ordinal, baseline_category,
+        main_effects, pairwise_effects);
+    model.set_missing_data(missing_index);
+    model.set_rng(SafeRNG(seed));
+
+    // The scan works on the centered scores the model keeps
+    arma::imat scores = observations;
+    for (int v = 0; v < num_variables; ++v) {
+        if (!is_ordinal(v)) scores.col(v) -= baseline_category(v);
+    }
+    arma::mat residual = model.get_residual_matrix();
+    arma::vec category_probabilities(num_categories.max() + 1);
+    arma::imat imputed(num_missings, sweeps);
+    SafeRNG rng(seed);
+
+    for (int sweep = 0; sweep < sweeps; ++sweep) {
+        model.impute_missing();
+
+        for (int miss = 0; miss < num_missings; ++miss) {
+            const int person = missing_index(miss, 0);
+            const int variable = missing_index(miss, 1);
+            const double residual_score = residual(person, variable);
+            const int num_cats = num_categories(variable);
+            const int ref = is_ordinal(variable) ? 0 : baseline_category(variable);
+
+            double cumsum = 0.0;
+            if (is_ordinal(variable)) {
+                cumsum = 1.0;
+                category_probabilities[0] = cumsum;
+                for (int cat = 0; cat < num_cats; cat++) {
+                    const int score = cat + 1;
+                    cumsum += MY_EXP(main_effects(variable, cat) + score * residual_score);
+                    category_probabilities[score] = cumsum;
+                }
+            } else {
+                for (int cat = 0; cat <= num_cats; cat++) {
+                    const int score = cat - ref;
+                    cumsum += MY_EXP(
+                        main_effects(variable, 0) * score +
+                        main_effects(variable, 1) * score * score +
+                        score * residual_score);
+                    category_probabilities[cat] = cumsum;
+                }
+            }
+
+            const double u = runif(rng) * cumsum;
+            int sampled = 0;
+            while (u > category_probabilities[sampled]) sampled++;
+
+            const int new_value = sampled - ref;
+            const int old_value = scores(person, variable);
+            imputed(miss, sweep) = sampled;
+            if (new_value == old_value) continue;
+
+            scores(person, variable) = new_value;
+            for (int var = 0; var < num_variables; var++) {
+                residual(person, var) +=
+                    2.0 * (new_value - old_value) * pairwise_effects(var, variable);
+            }
+        }
+    }
+
+    arma::imat completed = scores;
+    for (int v = 0; v < num_variables; ++v) {
+        if (!is_ordinal(v)) completed.col(v) += baseline_category(v);
+    }
+    OMRFModel rebuilt = build_imputation_model(
+        completed, num_categories, is_ordinal, baseline_category,
+        main_effects, pairwise_effects);
+
+    const arma::vec parameters = model.get_vectorized_parameters();
+    auto imputed_result = model.logp_and_gradient(parameters);
+    auto rebuilt_result = rebuilt.logp_and_gradient(parameters);
+
+    return Rcpp::List::create(
+        Rcpp::Named("residual_block") = model.get_residual_matrix(),
+        Rcpp::Named("residual_scan")  = residual,
+        Rcpp::Named("imputed_scan")   = imputed,
+        Rcpp::Named("logp_block")     = imputed_result.first,
+        Rcpp::Named("logp_scan")      = rebuilt_result.first,
+        Rcpp::Named("gradient_block") = imputed_result.second,
+        Rcpp::Named("gradient_scan")  = rebuilt_result.second
+    );
+}
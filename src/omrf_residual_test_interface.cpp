@@ -46,7 +46,7 @@ Rcpp::List test_omrf_residual_invariant(
         std::move(interaction_prior), std::move(threshold_prior),
         /*edge_selection=*/false);
 
-    model.set_seed(seed);
+    model.set_rng(SafeRNG(seed));
     model.set_metropolis_target_accept(target_accept);
     model.set_pairwise_effects(pairwise);  // residual now exactly 2*X*pairwise
 
@@ -1,8 +1,12 @@
 // Test interface for the polymorphic parameter prior classes.
 //
-// Exposes logp, grad, and scaled variants to R for unit testing.
+// Exposes logp, grad, and scaled variants to R for unit testing, and the
+// toggle-driven edge-prior counts.
 
 #include <RcppArmadillo.h>
+#include <algorithm>
+#include "math/categorical.h"
+#include "priors/edge_prior.h"
 #include "priors/parameter_prior.h"
 #include "models/ggm/graph_constraint_structure.h"
 #include "models/ggm/ggm_gradient.h"
@@ -44,6 +48,31 @@ Rcpp::List test_scale_prior(
 }
 
 
+// Batched logp_and_grad() of a parameter prior ("cauchy", "normal",
+// "beta-prime") or scale prior ("gamma"); `scale_factors` may be empty.
+// [[Rcpp::export]]
+Rcpp::List test_parameter_prior_batch(
+    const std::string& type,
+    const arma::vec& x,
+    const arma::vec& scale_factors,
+    double scale = 1.0,
+    double alpha = 0.5,
+    double beta = 0.5
+) {
+    auto prior = (type == "gamma")
+        ? create_scale_prior(type, alpha, beta)
+        : create_parameter_prior(type, scale, alpha, beta);
+
+    arma::vec grad;
+    const double logp = prior->logp_and_grad(x, scale_factors, grad);
+
+    return Rcpp::List::create(
+        Rcpp::Named("logp") = logp,
+        Rcpp::Named("grad") = Rcpp::NumericVector(grad.begin(), grad.end())
+    );
+}
+
+
 // [[Rcpp::export]]
 Rcpp::List ggm_test_logp_and_gradient_prior(
     const arma::vec& theta,
@@ -77,3 +106,233 @@ Rcpp::List ggm_test_logp_and_gradient_prior(
     );
 }
 
+
+
+// An edge prior ("Beta-Bernoulli" or "Stochastic-Block") that keeps its
+// counts from reported toggles, next to the same prior recounting the
+// indicators at every update. Both draw from `seed` and see the same random
+// toggles between updates; returns the inclusion probabilities and
+// allocations (empty for Beta-Bernoulli) of each after the last update.
+// [[Rcpp::export]]
+Rcpp::List test_edge_prior_toggles(
+    const std::string& type,
+    int p,
+    int num_updates,
+    int toggles_per_update,
+    int seed
+) {
+    const EdgePrior prior_type = edge_prior_from_string(type);
+    auto tracked = create_edge_prior(prior_type);
+    auto recounted = create_edge_prior(prior_type);
+    tracked->edge_reporting(true);
+
+    SafeRNG rng_tracked(seed), rng_recounted(seed), rng_toggles(seed + 1);
+    arma::imat indicators(p, p, arma::fill::zeros);
+    arma::mat prob_tracked(p, p, arma::fill::value(0.5));
+    arma::mat prob_recounted(p, p, arma::fill::value(0.5));
+    const int num_pairwise = p * (p - 1) / 2;
+
+    for (int u = 0; u < num_updates; ++u) {
+        for (int t = 0; t < toggles_per_update; ++t) {
+            const int i = std::min(p - 1, static_cast<int>(runif(rng_toggles) * p));
+            const int j = std::min(p - 1, static_cast<int>(runif(rng_toggles) * p));
+            if (i == j) continue;
+            const int value = 1 - indicators(i, j);
+            indicators(i, j) = indicators(j, i) = value;
+            tracked->edge_toggled(i, j, value == 1);
+        }
+        tracked->update(indicators, prob_tracked, p, num_pairwise, rng_tracked);
+        recounted->update(indicators, prob_recounted, p, num_pairwise, rng_recounted);
+    }
+
+    return Rcpp::List::create(
+        Rcpp::Named("prob_tracked") = prob_tracked,
+        Rcpp::Named("prob_recounted") = prob_recounted,
+        Rcpp::Named("allocations_tracked") = Rcpp::wrap(tracked->get_allocations()),
+        Rcpp::Named("allocations_recounted") = Rcpp::wrap(recounted->get_allocations())
+    );
+}
+
+
+
+namespace {
+
+// The MFM-SBM updates as they were before MFMSBMSampler kept its counts:
+// cluster sizes are retabulated for every node and each candidate cluster
+// is priced by rescanning the node's indicators.
+arma::uvec reference_cluster_sizes(const arma::uvec& allocations) {
+    arma::uvec sizes(allocations.max() + 1, arma::fill::zeros);
+    for (arma::uword i = 0; i < allocations.n_elem; ++i) sizes(allocations(i))++;
+    return sizes;
+}
+
+int reference_edge(const arma::imat& indicators, arma::uword i, arma::uword j) {
+    return i < j ? indicators(i, j) : indicators(j, i);
+}
+
+void reference_sbm_allocations(
+    arma::uvec& allocations, arma::mat& block_probs,
+    const arma::imat& indicators, const arma::vec& log_Vn,
+    double alpha, double beta, double alpha_between, double beta_between,
+    double dirichlet_alpha, SafeRNG& rng
+) {
+    const arma::uword p = allocations.n_elem;
+    const arma::uvec order = arma_randperm(rng, p);
+
+    for (arma::uword idx = 0; idx < p; ++idx) {
+        const arma::uword node = order(idx);
+        const arma::uword old = allocations(node);
+        arma::uvec members = reference_cluster_sizes(allocations);
+        const arma::uword no_clusters = members.n_elem;
+        const bool singleton = members(old) == 1;
+        members(old)--;
+
+        arma::vec cluster_prob(no_clusters + 1);
+        for (arma::uword c = 0; c < no_clusters; ++c) {
+            if (singleton && c == old) {
+                cluster_prob(c) = 0.0;
+                continue;
+            }
+            double loglike = 0.0;
+            for (arma::uword j = 0; j < p; ++j) {
+                if (j == node) continue;
+                const double q = block_probs(allocations(j), c);
+                loglike += reference_edge(indicators, node, j) ? MY_LOG(q) : MY_LOG(1 - q);
+            }
+            cluster_prob(c) = (dirichlet_alpha + static_cast<double>(members(c))) *
+                MY_EXP(loglike);
+        }
+
+        double logmarg = 0.0;
+        for (arma::uword k = 0; k < no_clusters; ++k) {
+            if (members(k) == 0) continue;
+            int edges = 0;
+            for (arma::uword j = 0; j < p; ++j) {
+                if (j != node && allocations(j) == k) edges += reference_edge(indicators, node, j);
+            }
+            const int size = static_cast<int>(members(k));
+            for (int m = 0; m < edges; ++m) logmarg += MY_LOG(alpha_between + m);
+            for (int m = 0; m < size - edges; ++m) logmarg += MY_LOG(beta_between + m);
+            for (int m = 0; m < size; ++m) logmarg -= MY_LOG(alpha_between + beta_between + m);
+        }
+        const double log_Vn_ratio = singleton
+            ? log_Vn(no_clusters - 1) - log_Vn(no_clusters - 2)
+            : log_Vn(no_clusters) - log_Vn(no_clusters - 1);
+        cluster_prob(no_clusters) = dirichlet_alpha * MY_EXP(logmarg) * MY_EXP(log_Vn_ratio);
+
+        const arma::uword cluster = sample_categorical(
+            cluster_prob.memptr(), static_cast<int>(cluster_prob.n_elem), runif(rng));
+
+        if (singleton) {
+            if (cluster == no_clusters) continue;
+            allocations(node) = cluster;
+            for (arma::uword i = 0; i < p; ++i) {
+                if (allocations(i) > old) allocations(i) -= 1;
+            }
+            block_probs.shed_row(old);
+            block_probs.shed_col(old);
+        } else {
+            allocations(node) = cluster;
+            if (cluster == no_clusters) {
+                block_probs.resize(no_clusters + 1, no_clusters + 1);
+                for (arma::uword i = 0; i < no_clusters; ++i) {
+                    block_probs(no_clusters, i) = rbeta(rng, alpha_between, beta_between);
+                    block_probs(i, no_clusters) = block_probs(no_clusters, i);
+                }
+                block_probs(no_clusters, no_clusters) = rbeta(rng, alpha, beta);
+            }
+        }
+    }
+}
+
+arma::mat reference_sbm_block_probs(
+    const arma::uvec& allocations, const arma::imat& indicators,
+    double alpha, double beta, double alpha_between, double beta_between,
+    SafeRNG& rng
+) {
+    const arma::uword p = allocations.n_elem;
+    const arma::uvec sizes = reference_cluster_sizes(allocations);
+    const arma::uword no_clusters = sizes.n_elem;
+    arma::mat block_probs(no_clusters, no_clusters);
+
+    for (arma::uword r = 0; r < no_clusters; ++r) {
+        for (arma::uword s = r; s < no_clusters; ++s) {
+            double sumG = 0.0;
+            for (arma::uword i = 0; i + 1 < p; ++i) {
+                for (arma::uword j = i + 1; j < p; ++j) {
+                    const arma::uword a = allocations(i), b = allocations(j);
+                    if ((a == r && b == s) || (a == s && b == r)) sumG += indicators(i, j);
+                }
+            }
+            const double size_r = static_cast<double>(sizes(r));
+            if (r == s) {
+                const double size = size_r * (size_r - 1) / 2;
+                block_probs(r, s) = rbeta(rng, sumG + alpha, size - sumG + beta);
+            } else {
+                const double size = static_cast<double>(sizes(s)) * size_r;
+                block_probs(r, s) = rbeta(rng, sumG + alpha_between, size - sumG + beta_between);
+            }
+            block_probs(s, r) = block_probs(r, s);
+        }
+    }
+    return block_probs;
+}
+
+} // namespace
+
+
+// MFMSBMSampler next to the rescanning reference above, both started from
+// `allocations` (0-based, no empty cluster) and the same block probabilities
+// and drawing from `seed`. Each sweep reallocates every variable, then
+// redraws the block probabilities; returns the allocations after every
+// sweep (p x num_sweeps, 0-based) and the final block probabilities of each.
+// [[Rcpp::export]]
+Rcpp::List test_sbm_allocations(
+    const arma::imat& indicators,
+    const arma::uvec& allocations,
+    int num_sweeps,
+    int seed,
+    double dirichlet_alpha = 1.0,
+    double lambda = 1.0,
+    double alpha = 1.0,
+    double beta = 1.0,
+    double alpha_between = 1.0,
+    double beta_between = 1.0
+) {
+    const arma::uword p = allocations.n_elem;
+    const arma::vec log_Vn = compute_Vn_mfm_sbm(p, dirichlet_alpha, p + 10, lambda);
+
+    SafeRNG rng_start(seed + 1);
+    const arma::mat start_probs = reference_sbm_block_probs(
+        allocations, indicators, alpha, beta, alpha_between, beta_between, rng_start);
+
+    MFMSBMSampler sampler(alpha, beta, alpha_between, beta_between, dirichlet_alpha);
+    sampler.set_allocations(allocations);
+    sampler.set_block_probs(start_probs);
+    sampler.count_edges(indicators);
+    arma::uvec reference_allocations = allocations;
+    arma::mat reference_probs = start_probs;
+
+    SafeRNG rng_sampler(seed), rng_reference(seed);
+    arma::umat trace_sampler(p, num_sweeps), trace_reference(p, num_sweeps);
+    for (int s = 0; s < num_sweeps; ++s) {
+        sampler.sample_allocations(indicators, log_Vn, rng_sampler);
+        sampler.sample_block_probs(rng_sampler);
+        trace_sampler.col(s) = sampler.allocations();
+
+        reference_sbm_allocations(
+            reference_allocations, reference_probs, indicators, log_Vn,
+            alpha, beta, alpha_between, beta_between, dirichlet_alpha, rng_reference);
+        reference_probs = reference_sbm_block_probs(
+            reference_allocations, indicators,
+            alpha, beta, alpha_between, beta_between, rng_reference);
+        trace_reference.col(s) = reference_allocations;
+    }
+
+    return Rcpp::List::create(
+        Rcpp::Named("allocations_sampler") = Rcpp::wrap(arma::conv_to<arma::imat>::from(trace_sampler)),
+        Rcpp::Named("allocations_reference") = Rcpp::wrap(arma::conv_to<arma::imat>::from(trace_reference)),
+        Rcpp::Named("probs_sampler") = sampler.block_probs(),
+        Rcpp::Named("probs_reference") = reference_probs
+    );
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+/**
+ * @file edge_change_listener.h
+ * @brief Notifications of edge-indicator changes, from a model to its edge prior.
+ */
+
+
+/**
+ * EdgeChangeListener - receives the edge toggles of a model
+ *
+ * A model with edge selection reports every accepted add or delete move
+ * through edge_toggled(), so that an edge prior can keep its edge counts
+ * current in O(1) per toggle instead of rescanning the indicator matrix.
+ * Any other change to the indicators (a restored state, a swap of
+ * replicas) is reported as edges_reset(), after which the listener
+ * recounts. Toggles are reported from the thread that owns the chain.
+ */
+class EdgeChangeListener {
+public:
+    virtual ~EdgeChangeListener() = default;
+
+    /** Edge (i, j), i != j, was switched to `included`. */
+    virtual void edge_toggled(int i, int j, bool included) = 0;
+
+    /** The indicators changed other than by reported toggles. */
+    virtual void edges_reset() = 0;
+
+    /**
+     * A model started (true) or stopped (false) reporting to this
+     * listener. Starting implies edges_reset().
+     */
+    virtual void edge_reporting(bool active) = 0;
+};
+
+
+/**
+ * EdgeChangeLink - a model's non-owning link to its listener
+ *
+ * Copies start unlinked, so a model cloned for another chain does not
+ * report to the original chain's prior.
+ */
+class EdgeChangeLink {
+public:
+    EdgeChangeLink() = default;
+    EdgeChangeLink(const EdgeChangeLink&) {}
+    EdgeChangeLink& operator=(const EdgeChangeLink&) { return *this; }
+
+    /** Link to `listener`, or unlink with nullptr. */
+    void attach(EdgeChangeListener* listener) {
+        if (listener_) listener_->edge_reporting(false);
+        listener_ = listener;
+        if (listener_) listener_->edge_reporting(true);
+    }
+
+    void toggled(int i, int j, bool included) const {
+        if (listener_) listener_->edge_toggled(i, j, included);
+    }
+
+    void reset() const {
+        if (listener_) listener_->edges_reset();
+    }
+
+private:
+    EdgeChangeListener* listener_ = nullptr;
+};
@@ -2,8 +2,10 @@
 
 #include <memory>
 #include <RcppArmadillo.h>
+#include "mcmc/execution/sampler_state.h"
 #include "rng/rng_utils.h"
 #include "utils/common_helpers.h"
+#include "priors/edge_change_listener.h"
 #include "sbm_edge_prior.h"
 #include "sbm_edge_prior_interface.h"
 
@@ -18,9 +20,21 @@
  * The MCMC runner calls update() after each edge indicator update, passing
  * the current edge indicators and inclusion probability matrix. The edge
  * prior modifies inclusion_probability in place.
+ *
+ * A prior is also an EdgeChangeListener. While a model reports to it, the
+ * counts a prior keeps (included edges, block tallies) are updated from the
+ * toggles through count_toggle() and update() does not rescan the
+ * indicators; otherwise, and after edges_reset(), the prior recounts from
+ * the matrix it is given. Copies are not attached to a model.
  */
-class BaseEdgePrior {
+class BaseEdgePrior : public EdgeChangeListener {
 public:
+    BaseEdgePrior() = default;
+    BaseEdgePrior(const BaseEdgePrior&) : EdgeChangeListener() {}
+    BaseEdgePrior& operator=(const BaseEdgePrior&) {
+        reporting_ = counts_current_ = false;
+        return *this;
+    }
     virtual ~BaseEdgePrior() = default;
 
     virtual void update(
@@ -33,8 +47,49 @@ public:
 
     virtual std::unique_ptr<BaseEdgePrior> clone() const = 0;
 
+    /**
+     * @return true if this prior keeps cluster allocations the runner
+     *         should store. Unlike has_allocations(), this holds before the
+     *         first update(), so it can size the allocation trace up front.
+     */
+    virtual bool tracks_allocations() const { return false; }
     virtual bool has_allocations() const { return false; }
     virtual arma::ivec get_allocations() const { return arma::ivec(); }
+
+    /** Save the prior's own sampler state into `state`. Default no-op. */
+    virtual void save_state(SamplerState& /*state*/) const {}
+    /** Continue from a state written by save_state(). Default no-op. */
+    virtual void restore_state(const SamplerState& /*state*/) {}
+
+    void edge_toggled(int i, int j, bool included) final {
+        if (counts_current_) count_toggle(i, j, included);
+    }
+    void edges_reset() final { counts_current_ = false; }
+    void edge_reporting(bool active) final {
+        reporting_ = active;
+        counts_current_ = false;
+    }
+
+protected:
+    /**
+     * @return true if the counts kept through count_toggle() match the
+     *         indicators; otherwise recount them in update() and call
+     *         edge_counts_recounted().
+     */
+    bool edge_counts_current() const { return counts_current_; }
+
+    /** The counts were rebuilt from the indicators. */
+    void edge_counts_recounted() { counts_current_ = reporting_; }
+
+    /** The counts no longer match, e.g. after restoring allocations. */
+    void invalidate_edge_counts() { counts_current_ = false; }
+
+    /** Apply one toggle of edge (i, j) to the counts. Default no-op. */
+    virtual void count_toggle(int /*i*/, int /*j*/, bool /*included*/) {}
+
+private:
+    bool reporting_ = false;       ///< A model reports its toggles to this prior
+    bool counts_current_ = false;  ///< The counts match the indicators
 };
 
 
@@ -63,7 +118,8 @@ public:
  * Beta-Bernoulli edge prior.
  *
  * Draws a shared inclusion probability from Beta(alpha + #included,
- * beta + #excluded) and assigns it to all edges.
+ * beta + #excluded) and assigns it to all edges. The number of included
+ * edges is kept from the reported toggles.
  */
 class BetaBernoulliEdgePrior : public BaseEdgePrior {
 public:
@@ -77,24 +133,25 @@ public:
         int num_pairwise,
         SafeRNG& rng
     ) override {
-        int num_edges_included = 0;
-        for (int i = 0; i < num_variables - 1; i++) {
-            for (int j = i + 1; j < num_variables; j++) {
-                num_edges_included += edge_indicators(i, j);
+        if (!edge_counts_current()) {
+            num_edges_included_ = 0;
+            for (int i = 0; i < num_variables - 1; i++) {
+                for (int j = i + 1; j < num_variables; j++) {
+                    num_edges_included_ += edge_indicators(i, j);
+                }
             }
+            edge_counts_recounted();
         }
 
         double prob = rbeta(rng,
-            alpha_ + num_edges_included,
-            beta_ + num_pairwise - num_edges_included
+            alpha_ + num_edges_included_,
+            beta_ + num_pairwise - num_edges_included_
         );
 
-        for (int i = 0; i < num_variables - 1; i++) {
-            for (int j = i + 1; j < num_variables; j++) {
-                inclusion_probability(i, j) = prob;
-                inclusion_probability(j, i) = prob;
-            }
-        }
+        // Every off-diagonal entry; the diagonal is kept
+        const arma::vec diagonal = inclusion_probability.diag();
+        inclusion_probability.fill(prob);
+        inclusion_probability.diag() = diagonal;
     }
 
     std::unique_ptr<BaseEdgePrior> clone() const override {
@@ -102,17 +159,22 @@ public:
     }
 
 private:
+    void count_toggle(int /*i*/, int /*j*/, bool included) override {
+        num_edges_included_ += included ? 1 : -1;
+    }
+
     double alpha_;
     double beta_;
+    int num_edges_included_ = 0;
 };
 
 
 /**
  * Stochastic Block Model (MFM-SBM) edge prior.
  *
- * Maintains cluster allocations and block-level inclusion probabilities.
- * Each edge's inclusion probability depends on its endpoints' cluster
- * assignments.
+ * Maintains cluster allocations and block-level inclusion probabilities
+ * through an MFMSBMSampler. Each edge's inclusion probability depends on
+ * its endpoints' cluster assignments.
  */
 class StochasticBlockEdgePrior : public BaseEdgePrior {
 public:
@@ -129,7 +191,10 @@ public:
         beta_bernoulli_beta_between_(beta_bernoulli_beta_between),
         dirichlet_alpha_(dirichlet_alpha),
         lambda_(lambda),
-        initialized_(false)
+        initialized_(false),
+        sampler_(beta_bernoulli_alpha, beta_bernoulli_beta,
+                 beta_bernoulli_alpha_between, beta_bernoulli_beta_between,
+                 dirichlet_alpha)
     {}
 
     /**
@@ -142,28 +207,18 @@ public:
         int num_variables,
         SafeRNG& rng
     ) {
-        cluster_allocations_.set_size(num_variables);
-        cluster_allocations_[0] = 0;
-        cluster_allocations_[1] = 1;
+        arma::uvec cluster_allocations(num_variables);
+        cluster_allocations[0] = 0;
+        cluster_allocations[1] = 1;
         for (int i = 2; i < num_variables; i++) {
-            cluster_allocations_[i] = (runif(rng) > 0.5) ? 1 : 0;
+            cluster_allocations[i] = (runif(rng) > 0.5) ? 1 : 0;
         }
 
-        cluster_prob_ = block_probs_mfm_sbm(
-            cluster_allocations_,
-            arma::conv_to<arma::umat>::from(edge_indicators),
-            num_variables,
-            beta_bernoulli_alpha_, beta_bernoulli_beta_,
-            beta_bernoulli_alpha_between_, beta_bernoulli_beta_between_,
-            rng
-        );
-
-        for (int i = 0; i < num_variables - 1; i++) {
-            for (int j = i + 1; j < num_variables; j++) {
-                inclusion_probability(i, j) = cluster_prob_(cluster_allocations_[i], cluster_allocations_[j]);
-                inclusion_probability(j, i) = inclusion_probability(i, j);
-            }
-        }
+        sampler_.set_allocations(cluster_allocations);
+        sampler_.count_edges(edge_indicators);
+        edge_counts_recounted();
+        sampler_.sample_block_probs(rng);
+        fill_inclusion_probability(inclusion_probability, num_variables);
 
         log_Vn_ = compute_Vn_mfm_sbm(
             num_variables, dirichlet_alpha_, num_variables + 10, lambda_);
@@ -180,41 +235,79 @@ public:
     ) override {
         if (!initialized_) {
             initialize(edge_indicators, inclusion_probability, num_variables, rng);
+        } else if (!edge_counts_current()) {
+            // Without reported toggles, recount the block edges; the sweep
+            // keeps them current as nodes move.
+            sampler_.count_edges(edge_indicators);
+            edge_counts_recounted();
         }
 
-        cluster_allocations_ = block_allocations_mfm_sbm(
-            cluster_allocations_, num_variables, log_Vn_, cluster_prob_,
-            arma::conv_to<arma::umat>::from(edge_indicators), dirichlet_alpha_,
-            beta_bernoulli_alpha_, beta_bernoulli_beta_,
-            beta_bernoulli_alpha_between_, beta_bernoulli_beta_between_, rng
-        );
-
-        cluster_prob_ = block_probs_mfm_sbm(
-            cluster_allocations_,
-            arma::conv_to<arma::umat>::from(edge_indicators), num_variables,
-            beta_bernoulli_alpha_, beta_bernoulli_beta_,
-            beta_bernoulli_alpha_between_, beta_bernoulli_beta_between_, rng
-        );
-
-        for (int i = 0; i < num_variables - 1; i++) {
-            for (int j = i + 1; j < num_variables; j++) {
-                inclusion_probability(i, j) = cluster_prob_(cluster_allocations_[i], cluster_allocations_[j]);
-                inclusion_probability(j, i) = inclusion_probability(i, j);
-            }
-        }
+        sampler_.sample_allocations(edge_indicators, log_Vn_, rng);
+        sampler_.sample_block_probs(rng);
+        fill_inclusion_probability(inclusion_probability, num_variables);
     }
 
     std::unique_ptr<BaseEdgePrior> clone() const override {
         return std::make_unique<StochasticBlockEdgePrior>(*this);
     }
 
+    bool tracks_allocations() const override { return true; }
     bool has_allocations() const override { return initialized_; }
 
     arma::ivec get_allocations() const override {
-        return arma::conv_to<arma::ivec>::from(cluster_allocations_) + 1; // 1-based
+        return arma::conv_to<arma::ivec>::from(sampler_.allocations()) + 1; // 1-based
+    }
+
+    /** Save the allocations and block probabilities once initialized. */
+    void save_state(SamplerState& state) const override {
+        if (!initialized_) return;
+        state.allocations = sampler_.allocations();
+        state.block_probs = sampler_.block_probs();
+    }
+
+    /**
+     * Continue from saved allocations and block probabilities instead of
+     * drawing a fresh starting partition. A state without allocations
+     * leaves the prior to initialize on its first update().
+     *
+     * @throws std::invalid_argument if the block probabilities do not
+     *         match the number of clusters
+     */
+    void restore_state(const SamplerState& state) override {
+        if (state.allocations.n_elem == 0) return;
+
+        const arma::uword no_clusters = state.allocations.max() + 1;
+        if (state.block_probs.n_rows != no_clusters ||
+            state.block_probs.n_cols != no_clusters) {
+            throw std::invalid_argument(
+                "warm_start: `block_probs` must be K x K for the K clusters in `allocations`.");
+        }
+
+        const int num_variables = static_cast<int>(state.allocations.n_elem);
+        sampler_.set_allocations(state.allocations);
+        sampler_.set_block_probs(state.block_probs);
+        invalidate_edge_counts();
+        log_Vn_ = compute_Vn_mfm_sbm(
+            num_variables, dirichlet_alpha_, num_variables + 10, lambda_);
+        initialized_ = true;
     }
 
 private:
+    void count_toggle(int i, int j, bool included) override {
+        sampler_.toggle_edge(i, j, included);
+    }
+
+    void fill_inclusion_probability(arma::mat& inclusion_probability, int num_variables) const {
+        const arma::uvec& allocations = sampler_.allocations();
+        const arma::mat& block_probs = sampler_.block_probs();
+        for (int i = 0; i < num_variables - 1; i++) {
+            for (int j = i + 1; j < num_variables; j++) {
+                inclusion_probability(i, j) = block_probs(allocations[i], allocations[j]);
+                inclusion_probability(j, i) = inclusion_probability(i, j);
+            }
+        }
+    }
+
     double beta_bernoulli_alpha_;
     double beta_bernoulli_beta_;
     double beta_bernoulli_alpha_between_;
@@ -223,8 +316,7 @@ private:
     double lambda_;
 
     bool initialized_;
-    arma::uvec cluster_allocations_;
-    arma::mat cluster_prob_;
+    MFMSBMSampler sampler_;
     arma::vec log_Vn_;
 };
 
@@ -2,8 +2,13 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 #include <cmath>
+#include <RcppArmadillo.h>
 #include <Rmath.h>
+#include <stdexcept>
+#include "rng/polya_gamma.h"
+#include "rng/rng_utils.h"
 
 
 // =============================================================================
@@ -13,6 +18,10 @@
 // its own hyperparameters and provides logp/grad evaluated at a point x.
 //
 // Used for interaction parameters, threshold parameters, and continuous means.
+//
+// The gradients evaluate every prior term of the model at once through
+// logp_and_grad(): one virtual call per prior, after which the concrete
+// (final) prior runs a plain loop over the values.
 // =============================================================================
 class BaseParameterPrior {
 public:
@@ -48,6 +57,52 @@ public:
         return grad(x);
     }
 
+    /**
+     * Batched log-density and gradient.
+     *
+     * @param x      Values to evaluate the prior at
+     * @param scale  Per-value scale factors (as in logp(x, scale_factor)),
+     *               or empty for none
+     * @param grad   Output: d/dx log p at each value (resized to x)
+     * @return Sum of the log-densities
+     *
+     * Default: one scalar logp() and grad() call per value.
+     */
+    virtual double logp_and_grad(const arma::vec& x, const arma::vec& scale,
+                                 arma::vec& grad) const {
+        grad.set_size(x.n_elem);
+        double sum = 0.0;
+        for (arma::uword k = 0; k < x.n_elem; ++k) {
+            const double sf = scale.is_empty() ? 1.0 : scale[k];
+            sum += logp(x[k], sf);
+            grad[k] = this->grad(x[k], sf);
+        }
+        return sum;
+    }
+
+    /**
+     * @return true when draw_gaussian_augmentation() is implemented, so the
+     *         Pólya-Gamma Gibbs sampler can use this prior.
+     */
+    virtual bool has_gaussian_augmentation() const { return false; }
+
+    /**
+     * Draw the latent variable of a Gaussian augmentation given x: under
+     * it the prior of x is the factor exp(linear * x - precision * x^2 / 2),
+     * so a Gaussian full conditional of x stays Gaussian.
+     *
+     * @param x             Current value
+     * @param scale_factor  As in logp(x, scale_factor)
+     * @param rng           Random number generator
+     * @param linear        Receives the linear coefficient
+     * @param precision     Receives the precision
+     */
+    virtual void draw_gaussian_augmentation(double x, double scale_factor, SafeRNG& rng,
+                                            double& linear, double& precision) const {
+        (void)x; (void)scale_factor; (void)rng; (void)linear; (void)precision;
+        throw std::runtime_error("draw_gaussian_augmentation not implemented for this prior");
+    }
+
     /** Deep copy for parallel chains. */
     virtual std::unique_ptr<BaseParameterPrior> clone() const = 0;
 };
@@ -79,6 +134,33 @@ public:
         return -2.0 * x / (s2 + x * x);
     }
 
+    // log p(x) = -log(pi) - log(s) - log1p((x / s)^2)
+    double logp_and_grad(const arma::vec& x, const arma::vec& scale,
+                         arma::vec& grad) const override {
+        grad.set_size(x.n_elem);
+        const bool scaled = !scale.is_empty();
+        double sum = -static_cast<double>(x.n_elem) * 2.0 * M_LN_SQRT_PI;
+        for (arma::uword k = 0; k < x.n_elem; ++k) {
+            const double s = scaled ? scale_ * scale[k] : scale_;
+            const double s2 = s * s;
+            const double x2 = x[k] * x[k];
+            sum -= std::log(s) + std::log1p(x2 / s2);
+            grad[k] = -2.0 * x[k] / (s2 + x2);
+        }
+        return sum;
+    }
+
+    // Cauchy(0, s) is N(0, s^2 / lambda) with lambda ~ Gamma(1/2, rate 1/2);
+    // given x, lambda ~ Gamma(1, rate (1 + x^2 / s^2) / 2)
+    bool has_gaussian_augmentation() const override { return true; }
+
+    void draw_gaussian_augmentation(double x, double scale_factor, SafeRNG& rng,
+                                    double& linear, double& precision) const override {
+        const double s2 = scale_ * scale_factor * scale_ * scale_factor;
+        linear = 0.0;
+        precision = rexp(rng, 0.5 * (1.0 + x * x / s2)) / s2;
+    }
+
     std::unique_ptr<BaseParameterPrior> clone() const override {
         return std::make_unique<CauchyPrior>(*this);
     }
@@ -114,6 +196,32 @@ public:
         return -x / s2;
     }
 
+    // log p(x) = -log(sqrt(2 pi)) - log(s) - x^2 / (2 s^2)
+    double logp_and_grad(const arma::vec& x, const arma::vec& scale,
+                         arma::vec& grad) const override {
+        grad.set_size(x.n_elem);
+        const bool scaled = !scale.is_empty();
+        double sum = -static_cast<double>(x.n_elem) * M_LN_SQRT_2PI;
+        for (arma::uword k = 0; k < x.n_elem; ++k) {
+            const double s = scaled ? scale_ * scale[k] : scale_;
+            const double inv_s2 = 1.0 / (s * s);
+            sum -= std::log(s) + 0.5 * x[k] * x[k] * inv_s2;
+            grad[k] = -x[k] * inv_s2;
+        }
+        return sum;
+    }
+
+    // Already Gaussian: nothing to draw
+    bool has_gaussian_augmentation() const override { return true; }
+
+    void draw_gaussian_augmentation(double x, double scale_factor, SafeRNG& rng,
+                                    double& linear, double& precision) const override {
+        (void)x; (void)rng;
+        const double s = scale_ * scale_factor;
+        linear = 0.0;
+        precision = 1.0 / (s * s);
+    }
+
     std::unique_ptr<BaseParameterPrior> clone() const override {
         return std::make_unique<NormalPrior>(*this);
     }
@@ -144,6 +252,37 @@ public:
         return alpha_ - (alpha_ + beta_) * p;
     }
 
+    // No scale parameter: `scale` is ignored, as in logp(x, scale_factor)
+    double logp_and_grad(const arma::vec& x, const arma::vec& scale,
+                         arma::vec& grad) const override {
+        (void)scale;
+        grad.set_size(x.n_elem);
+        const double total = alpha_ + beta_;
+        double sum = 0.0;
+        for (arma::uword k = 0; k < x.n_elem; ++k) {
+            sum += x[k] * alpha_ - std::log1p(std::exp(x[k])) * total;
+            grad[k] = alpha_ - total / (1.0 + std::exp(-x[k]));
+        }
+        return sum;
+    }
+
+    // exp(alpha x) / (1 + exp(x))^b, b = alpha + beta, is a Pólya-Gamma
+    // mixture with linear term alpha - b / 2 and omega ~ PG(b, x) given x.
+    // PG(b, x) is a sum of b PG(1, x) draws, so b must be a whole number.
+    bool has_gaussian_augmentation() const override {
+        const double total = alpha_ + beta_;
+        return total >= 1.0 && total == std::floor(total);
+    }
+
+    void draw_gaussian_augmentation(double x, double scale_factor, SafeRNG& rng,
+                                    double& linear, double& precision) const override {
+        (void)scale_factor;
+        const int total = static_cast<int>(alpha_ + beta_);
+        linear = 0.5 * (alpha_ - beta_);
+        precision = 0.0;
+        for (int k = 0; k < total; ++k) precision += rpolya_gamma(rng.eng, x);
+    }
+
     std::unique_ptr<BaseParameterPrior> clone() const override {
         return std::make_unique<BetaPrimePrior>(*this);
     }
@@ -174,6 +313,20 @@ public:
         return (shape_ - 1.0) / x - rate_;
     }
 
+    // No scale parameter: `scale` is ignored, as in logp(x, scale_factor)
+    double logp_and_grad(const arma::vec& x, const arma::vec& scale,
+                         arma::vec& grad) const override {
+        (void)scale;
+        grad.set_size(x.n_elem);
+        const double gamma_scale = 1.0 / rate_;
+        double sum = 0.0;
+        for (arma::uword k = 0; k < x.n_elem; ++k) {
+            sum += R::dgamma(x[k], shape_, gamma_scale, true);
+            grad[k] = (shape_ - 1.0) / x[k] - rate_;
+        }
+        return sum;
+    }
+
     std::unique_ptr<BaseParameterPrior> clone() const override {
         return std::make_unique<GammaScalePrior>(*this);
     }
@@ -184,6 +337,67 @@ private:
 };
 
 
+// =============================================================================
+// PriorBatch — prior terms gathered for one logp_and_grad() call
+//
+// For gradients whose parameters are not contiguous in the gradient vector:
+// add() records each value with the gradient entry it belongs to, and
+// evaluate() runs the prior over all of them at once and scatters the
+// gradient back.
+// =============================================================================
+class PriorBatch {
+public:
+    explicit PriorBatch(size_t capacity = 0) {
+        values_.reserve(capacity);
+        scales_.reserve(capacity);
+        index_.reserve(capacity);
+    }
+
+    /** Add a term at `value`, whose gradient goes to entry `index`. */
+    void add(double value, arma::uword index) {
+        values_.push_back(value);
+        index_.push_back(index);
+    }
+
+    /** Add a term with a scale factor (see BaseParameterPrior::logp). */
+    void add(double value, arma::uword index, double scale_factor) {
+        scales_.resize(values_.size(), 1.0);
+        add(value, index);
+        scales_.push_back(scale_factor);
+    }
+
+    /**
+     * Evaluate the prior at every added value.
+     *
+     * @param prior     Prior of all terms
+     * @param gradient  Gradient (vector or matrix, linear indices); entry
+     *                  index(k) gains weight * d/dx log p(value(k))
+     * @param weight    Chain-rule factor of the gradient
+     * @return Sum of the log-densities
+     */
+    double evaluate(const BaseParameterPrior& prior, arma::mat& gradient,
+                    double weight = 1.0) {
+        if (values_.empty()) return 0.0;
+        const arma::uword n = values_.size();
+        if (!scales_.empty()) scales_.resize(n, 1.0);
+        const arma::vec x(values_.data(), n, false, true);
+        const arma::vec scale = scales_.empty()
+            ? arma::vec() : arma::vec(scales_.data(), n, false, true);
+        const double logp = prior.logp_and_grad(x, scale, grad_);
+        for (arma::uword k = 0; k < n; ++k) {
+            gradient(index_[k]) += weight * grad_[k];
+        }
+        return logp;
+    }
+
+private:
+    std::vector<double> values_;
+    std::vector<double> scales_;
+    std::vector<arma::uword> index_;
+    arma::vec grad_;
+};
+
+
 // =============================================================================
 // Factory functions
 // =============================================================================
@@ -1,6 +1,8 @@
 #include <RcppArmadillo.h>
 #include "rng/rng_utils.h"
+#include "math/categorical.h"
 #include "math/explog_macros.h"
+#include "priors/sbm_edge_prior.h"
 
 // ----------------------------------------------------------------------------|
 // The c++ code below is based on the R code accompanying the paper:
@@ -9,381 +11,277 @@
 //  Statistical Association, 114:526, 893-905, DOI:10.1080/01621459.2018.1458618
 // ----------------------------------------------------------------------------|
 
-// ----------------------------------------------------------------------------|
-// A c++ version of table
-// ----------------------------------------------------------------------------|
-arma::uvec table_cpp(arma::uvec x) {
-  arma::uword n = x.n_elem;
-  arma::uword m = arma::max(x);
-  arma::uvec counts(m+1,arma::fill::zeros);
+MFMSBMSampler::MFMSBMSampler(double beta_bernoulli_alpha,
+                             double beta_bernoulli_beta,
+                             double beta_bernoulli_alpha_between,
+                             double beta_bernoulli_beta_between,
+                             double dirichlet_alpha)
+  : beta_bernoulli_alpha_(beta_bernoulli_alpha),
+    beta_bernoulli_beta_(beta_bernoulli_beta),
+    beta_bernoulli_alpha_between_(beta_bernoulli_alpha_between),
+    beta_bernoulli_beta_between_(beta_bernoulli_beta_between),
+    dirichlet_alpha_(dirichlet_alpha) {}
 
-  for (arma::uword i = 0; i < n; i++) {
-    counts(x(i))++;
-  }
 
-  return counts;
+void MFMSBMSampler::set_allocations(const arma::uvec& cluster_assign) {
+  cluster_assign_ = cluster_assign;
 }
 
 
-// ----------------------------------------------------------------------------|
-// Add a row and column to a matrix (and fill with beta variables)
-// Modified to support separate within/between cluster hyperparameters
-// ----------------------------------------------------------------------------|
-arma::mat add_row_col_block_prob_matrix(arma::mat X,
-                                        double beta_alpha,
-                                        double beta_beta,
-                                        SafeRNG& rng,
-                                        double beta_bernoulli_alpha_between,
-                                        double beta_bernoulli_beta_between) {
-  arma::uword dim = X.n_rows;
-  arma::mat Y(dim+1,dim+1,arma::fill::zeros);
-
-  for(arma::uword r = 0; r < dim; r++) {
-    for(arma::uword c = 0; c < dim; c++) {
-      Y(r, c) = X(r, c);
+void MFMSBMSampler::set_block_probs(const arma::mat& block_probs) {
+  block_probs_ = block_probs;
+  log_probs_ = ARMA_MY_LOG(block_probs_);
+  log1m_probs_ = ARMA_MY_LOG(1.0 - block_probs_);
+}
+
+
+void MFMSBMSampler::count_edges(const arma::imat& indicator) {
+  const arma::uword no_variables = cluster_assign_.n_elem;
+  const arma::uword no_clusters = cluster_assign_.max() + 1;
+
+  cluster_size_.zeros(no_clusters);
+  for (arma::uword i = 0; i < no_variables; i++) {
+    cluster_size_(cluster_assign_(i))++;
+  }
+
+  block_edges_.zeros(no_clusters, no_clusters);
+  node_cluster_edges_.zeros(no_variables, no_clusters);
+  for (arma::uword node1 = 0; node1 + 1 < no_variables; node1++) {
+    const arma::uword r = cluster_assign_(node1);
+    for (arma::uword node2 = node1 + 1; node2 < no_variables; node2++) {
+      if (indicator(node1, node2) != 0) {
+        const arma::uword s = cluster_assign_(node2);
+        block_edges_(r, s)++;
+        if (r != s) block_edges_(s, r)++;
+        node_cluster_edges_(node1, s)++;
+        node_cluster_edges_(node2, r)++;
+      }
     }
   }
 
-  // Add new row and column for the new cluster
-  for(arma::uword i = 0; i < dim; i++) {
-    // Between-cluster edge probabilities (new cluster to existing clusters)
-    Y(dim, i) = rbeta(rng, beta_bernoulli_alpha_between, beta_bernoulli_beta_between);
-    Y(i, dim) = Y(dim, i);
+  if (log_alpha_sum_.n_elem != no_variables) {
+    build_marginal_tables(no_variables);
   }
+}
 
-  // Within-cluster edge probability (diagonal element for new cluster)
-  Y(dim, dim) = rbeta(rng, beta_alpha, beta_beta);
 
-  return Y;
+void MFMSBMSampler::build_marginal_tables(arma::uword p) {
+  // Gamma(z + n) / Gamma(z) = prod_{m=0}^{n-1} (z + m) for integer n, so
+  // log B(a + G, b + N - G) / B(a, b) is a difference of these prefix sums.
+  log_alpha_sum_.set_size(p);
+  log_beta_sum_.set_size(p);
+  log_alpha_beta_sum_.set_size(p);
+  log_alpha_sum_(0) = log_beta_sum_(0) = log_alpha_beta_sum_(0) = 0.0;
+  for (arma::uword n = 1; n < p; n++) {
+    const double m = static_cast<double>(n - 1);
+    log_alpha_sum_(n) = log_alpha_sum_(n - 1) + MY_LOG(beta_bernoulli_alpha_between_ + m);
+    log_beta_sum_(n) = log_beta_sum_(n - 1) + MY_LOG(beta_bernoulli_beta_between_ + m);
+    log_alpha_beta_sum_(n) = log_alpha_beta_sum_(n - 1) +
+      MY_LOG(beta_bernoulli_alpha_between_ + beta_bernoulli_beta_between_ + m);
+  }
 }
 
 
-
-// Function: log_likelihood_mfm_sbm
-//
-// Computes the log-likelihood contribution for a single node under the
-// Mixture of Finite Mixtures Stochastic Block Model (MFM-SBM). Evaluates
-// the probability of observed edges between the node and all other nodes
-// given their cluster assignments and cluster connection probabilities.
-//
-// Inputs:
-//  - cluster_assign: Vector of cluster assignments for all nodes.
-//  - cluster_probs: Matrix of edge probabilities between clusters.
-//  - indicator: Upper-triangular matrix of edge indicators (1 = edge present).
-//  - node: Index of the node whose contribution is computed.
-//  - no_variables: Total number of nodes in the network.
-//
-// Returns:
-//  - Log-likelihood contribution for the specified node.
-double log_likelihood_mfm_sbm(arma::uvec cluster_assign,
-                              arma::mat cluster_probs,
-                              arma::umat indicator,
-                              arma::uword node,
-                              arma::uword no_variables) {
-  double output = 0;
-
-  for(arma::uword j = 0; j < no_variables; j++) {
-    if(j != node) {
-      if(j < node) {
-        output += indicator(j, node) *
-          MY_LOG(cluster_probs(cluster_assign(j), cluster_assign(node)));
-        output += (1 - indicator(j, node)) *
-          MY_LOG(1 - cluster_probs(cluster_assign(j), cluster_assign(node)));
-      } else {
-        output += indicator(node, j) *
-          MY_LOG(cluster_probs(cluster_assign(node), cluster_assign(j)));
-        output += (1 - indicator(node, j)) *
-          MY_LOG(1 - cluster_probs(cluster_assign(node), cluster_assign(j)));
-      }
-    }
+void MFMSBMSampler::toggle_edge(arma::uword i, arma::uword j, bool included) {
+  const arma::uword r = cluster_assign_(i);
+  const arma::uword s = cluster_assign_(j);
+  if (included) {
+    block_edges_(r, s)++;
+    if (r != s) block_edges_(s, r)++;
+    node_cluster_edges_(i, s)++;
+    node_cluster_edges_(j, r)++;
+  } else {
+    block_edges_(r, s)--;
+    if (r != s) block_edges_(s, r)--;
+    node_cluster_edges_(i, s)--;
+    node_cluster_edges_(j, r)--;
   }
+}
+
 
-  return output;
+void MFMSBMSampler::tally_node(arma::uword node) {
+  node_edges_ = node_cluster_edges_.row(node).t();
+  node_members_ = cluster_size_;
+  node_members_(cluster_assign_(node))--;
 }
 
-// Function: log_marginal_mfm_sbm
-//
-// Computes the log-marginal likelihood contribution for a single node under
-// the MFM-SBM after integrating out cluster connection probabilities. Used
-// when proposing a new cluster for the node, so all interactions are
-// between-cluster. Uses Beta-Bernoulli conjugacy.
-//
-// Inputs:
-//  - cluster_assign: Vector of cluster assignments for all nodes.
-//  - indicator: Upper-triangular matrix of edge indicators (1 = edge present).
-//  - node: Index of the node whose contribution is computed.
-//  - no_variables: Total number of nodes in the network.
-//  - beta_bernoulli_alpha_between: Alpha hyperparameter for between-cluster edges.
-//  - beta_bernoulli_beta_between: Beta hyperparameter for between-cluster edges.
-//
-// Returns:
-//  - Log-marginal likelihood contribution for the specified node.
-double log_marginal_mfm_sbm(arma::uvec cluster_assign,
-                            arma::umat indicator,
-                            arma::uword node,
-                            arma::uword no_variables,
-                            double beta_bernoulli_alpha_between,
-                            double beta_bernoulli_beta_between) {
-
-  arma::uvec indices = arma::regspace<arma::uvec>(0, no_variables-1); // vector of variables indices [0, 1, ..., no_variables-1]
-  arma::uvec select_variables = indices(arma::find(indices != node)); // vector of variables indices excluding 'node'
-  arma::uvec cluster_assign_wo_node = cluster_assign(select_variables); // vector of cluster labels for all variables but excluding 'node'
-  arma::uvec indicator_node = indicator.col(node); // column of indicator matrix corresponding to 'node'
-  arma::vec gamma_node = arma::conv_to<arma::vec>::from(indicator_node(select_variables)); // selecting only indicators between 'node' and the remaining variables (thus excluding indicator of node with itself -- that is indicator[node,node])
-  arma::uvec table_cluster = table_cpp(cluster_assign_wo_node); // frequency table of clusters excluding node
-
-  double output = 0;
-  for(arma::uword i = 0; i < table_cluster.n_elem; i++){
-    if(table_cluster(i) > 0){ // if the cluster is empty -- table_cluster(i) = 0 == then it is the previous cluster of 'node' where 'node' was the only member - a singleton, thus skip)
-      arma::uvec which_variables_cluster_i = arma::find(cluster_assign_wo_node == i); // which variables belong to cluster i
-      int sumG = arma::accu(gamma_node(which_variables_cluster_i)); // sum the indicator variables between node and those variables
-      int sumN = static_cast<int>(which_variables_cluster_i.n_elem); // take the size of the group as maximum number of relations
-
-      // Compute log B(alpha + G, beta + N - G) / B(alpha, beta) using the identity
-      // Gamma(z+n)/Gamma(z) = prod_{m=0}^{n-1} (z+m), which holds since sumG and sumN are integers.
-      // This avoids lbeta/lgamma calls and is faster for small cluster sizes.
-      for(int m = 0; m < sumG; m++){
-        output += MY_LOG(beta_bernoulli_alpha_between + m);
-      }
-      for(int m = 0; m < (sumN - sumG); m++){
-        output += MY_LOG(beta_bernoulli_beta_between + m);
-      }
-      for(int m = 0; m < sumN; m++){
-        output -= MY_LOG(beta_bernoulli_alpha_between + beta_bernoulli_beta_between + m);
-      }
-    }
+
+void MFMSBMSampler::move_node(arma::uword node, arma::uword from, arma::uword to,
+                              const arma::imat& indicator) {
+  if (from == to) return;
+  const arma::uword no_variables = cluster_assign_.n_elem;
+
+  const arma::uword no_clusters = cluster_size_.n_elem;
+  for (arma::uword k = 0; k < no_clusters; k++) {
+    const arma::uword edges = node_edges_(k);
+    block_edges_(from, k) -= edges;
+    if (k != from) block_edges_(k, from) -= edges;
+  }
+  for (arma::uword k = 0; k < no_clusters; k++) {
+    const arma::uword edges = node_edges_(k);
+    block_edges_(to, k) += edges;
+    if (k != to) block_edges_(k, to) += edges;
   }
-  return output;
-}
 
-// ----------------------------------------------------------------------------|
-// Helper function to update sumG in sample_block_probs_mfm_sbm()
-// ----------------------------------------------------------------------------|
-inline void update_sumG(double &sumG,
-                        const arma::uvec &cluster_assign,
-                        const arma::umat &indicator,
-                        arma::uword r,
-                        arma::uword s,
-                        arma::uword no_variables) {
-  for(arma::uword node1 = 0; node1 < no_variables - 1; node1++) {
-    if(cluster_assign(node1) == r) {
-      for(arma::uword node2 = node1 + 1; node2 < no_variables; node2++) {
-        if(cluster_assign(node2) == s) {
-          sumG += static_cast<double>(indicator(node1, node2));
-        }
-      }
+  // The neighbours of `node` now reach cluster `to` instead of `from`
+  for (arma::uword j = 0; j < no_variables; j++) {
+    if (j == node) continue;
+    const int edge = j < node ? indicator(j, node) : indicator(node, j);
+    if (edge != 0) {
+      node_cluster_edges_(j, from)--;
+      node_cluster_edges_(j, to)++;
     }
   }
+
+  cluster_size_(from)--;
+  cluster_size_(to)++;
+  cluster_assign_(node) = to;
 }
 
-// ----------------------------------------------------------------------------|
-// Sample the cluster assignment in sample_block_allocations_mfm_sbm()
-// ----------------------------------------------------------------------------|
-arma::uword sample_cluster(arma::vec cluster_prob,
-                           SafeRNG& rng) {
-  arma::vec cum_prob = arma::cumsum(cluster_prob);
-  double u = runif(rng) * arma::max(cum_prob);
-
-  for (arma::uword i = 0; i < cum_prob.n_elem; i++) {
-    if (u <= cum_prob(i)) {
-      return i;
-    }
+
+void MFMSBMSampler::refresh_log_probs(arma::uword k) {
+  for (arma::uword i = 0; i < block_probs_.n_rows; i++) {
+    log_probs_(k, i) = log_probs_(i, k) = MY_LOG(block_probs_(k, i));
+    log1m_probs_(k, i) = log1m_probs_(i, k) = MY_LOG(1 - block_probs_(k, i));
   }
-  return cum_prob.n_elem;
 }
 
-// ----------------------------------------------------------------------------|
-// Sample the block allocations for the MFM - SBM
-// Modified to support separate within/between cluster hyperparameters
-// ----------------------------------------------------------------------------|
-arma::uvec block_allocations_mfm_sbm(arma::uvec cluster_assign,
-                                     arma::uword no_variables,
-                                     arma::vec log_Vn,
-                                     arma::mat block_probs,
-                                     arma::umat indicator,
-                                     arma::uword dirichlet_alpha,
-                                     double beta_bernoulli_alpha,
-                                     double beta_bernoulli_beta,
-                                     double beta_bernoulli_alpha_between,
-                                     double beta_bernoulli_beta_between,
-                                     SafeRNG& rng) {
-
-  arma::uword old;
-  arma::uword cluster;
-  arma::uword no_clusters;
-  double prob;
-  double loglike;
-  double logmarg;
-
-  // Generate a randomized order using Rcpp's sample function
-  arma::uvec indices = arma_randperm(rng, no_variables);
 
-  for (arma::uword idx = 0; idx < no_variables; idx++) {
-    arma::uword node = indices(idx);
-    old = cluster_assign(node);
-
-    arma::uvec cluster_size = table_cpp(cluster_assign);
-    no_clusters = cluster_size.n_elem;
-
-    if (cluster_size(old) == 1) {
-      // Singleton cluster.
-
-      // Cluster sizes without node
-      arma::uvec cluster_size_node = cluster_size;
-
-      // Compute probabilities for sampling process
-      arma::vec cluster_prob(no_clusters + 1);
-      for (arma::uword c = 0; c <= no_clusters; c++) {
-        arma::uvec cluster_assign_tmp = cluster_assign;
-        cluster_assign_tmp(node) = c;
-
-        if (c < no_clusters) {
-          if(c != old){
-            loglike = log_likelihood_mfm_sbm(cluster_assign_tmp,
-                                             block_probs,
-                                             indicator,
-                                             node,
-                                             no_variables);
-
-            prob = (static_cast<double>(dirichlet_alpha) + static_cast<double>(cluster_size_node(c))) *
-              MY_EXP(loglike);
-          }
-          else{ // if old group, the probability is set to 0.0
-            prob = 0.0;
-          }
-
-        } else {
-          logmarg = log_marginal_mfm_sbm(cluster_assign_tmp,
-                                         indicator,
-                                         node,
-                                         no_variables,
-                                         beta_bernoulli_alpha_between,
-                                         beta_bernoulli_beta_between);
-
-          prob = static_cast<double>(dirichlet_alpha) *
-            MY_EXP(logmarg) *
-            MY_EXP(log_Vn(no_clusters - 1) - log_Vn(no_clusters - 2));
-        }
-
-        cluster_prob(c) = prob;
-      }
+void MFMSBMSampler::add_cluster(SafeRNG& rng) {
+  const arma::uword dim = block_probs_.n_rows;
 
-      //Choose the cluster number for node
-      cluster = sample_cluster(cluster_prob, rng);
-
-      //if the sampled cluster is the new added cluster or the old one
-      if (cluster == no_clusters) {
-        cluster_assign(node) = old; // new cluster takes the place of the older singleton but doesn't update probabilities, they are kept the same as the old ones
-      } else { // otherwise remove old (singleton) empty cluster, redefine cluster_assign and block_probs
-        cluster_assign(node) = cluster;
-        for (arma::uword i = 0; i < no_variables; i++) {
-          if (cluster_assign(i) > old) {
-            cluster_assign(i) -= 1;
-          }
-        }
-        // removing row and col index 'old' from block_probs
-        block_probs.shed_row(old);
-        block_probs.shed_col(old);
-      }
-    } else {
-      // Cluster sizes without node
-      arma::uvec cluster_size_node = cluster_size;
-      cluster_size_node(old) -= 1;
-
-      // Compute probabilities for sampling process
-      arma::vec cluster_prob(no_clusters + 1);
-      for (arma::uword c = 0; c <= no_clusters; c++) {
-        arma::uvec cluster_assign_tmp = cluster_assign;
-        cluster_assign_tmp(node) = c;
-        if (c < no_clusters) {
-          loglike = log_likelihood_mfm_sbm(cluster_assign_tmp,
-                                           block_probs,
-                                           indicator,
-                                           node,
-                                           no_variables);
-
-          prob = (static_cast<double>(dirichlet_alpha) + static_cast<double>(cluster_size_node(c))) *
-            MY_EXP(loglike);
-        } else {
-          logmarg = log_marginal_mfm_sbm(cluster_assign_tmp,
-                                         indicator,
-                                         node,
-                                         no_variables,
-                                         beta_bernoulli_alpha_between,
-                                         beta_bernoulli_beta_between);
-
-          prob = static_cast<double>(dirichlet_alpha) *
-            MY_EXP(logmarg) *
-            MY_EXP(log_Vn(no_clusters) - log_Vn(no_clusters-1));
-        }
-
-        cluster_prob(c) = prob;
-      }
+  // resize() keeps the existing entries and zero-fills the new ones
+  block_probs_.resize(dim + 1, dim + 1);
+  log_probs_.resize(dim + 1, dim + 1);
+  log1m_probs_.resize(dim + 1, dim + 1);
+  block_edges_.resize(dim + 1, dim + 1);
+  node_cluster_edges_.resize(node_cluster_edges_.n_rows, dim + 1);
+  cluster_size_.resize(dim + 1);
+
+  // Between-cluster edge probabilities (new cluster to existing clusters)
+  for (arma::uword i = 0; i < dim; i++) {
+    block_probs_(dim, i) = rbeta(rng, beta_bernoulli_alpha_between_, beta_bernoulli_beta_between_);
+    block_probs_(i, dim) = block_probs_(dim, i);
+  }
 
+  // Within-cluster edge probability (diagonal element for new cluster)
+  block_probs_(dim, dim) = rbeta(rng, beta_bernoulli_alpha_, beta_bernoulli_beta_);
 
-      //Choose the cluster number for node
-      cluster = sample_cluster(cluster_prob, rng);
+  refresh_log_probs(dim);
+}
 
-      cluster_assign(node) = cluster;
 
-      if (cluster == no_clusters) {
-        block_probs = add_row_col_block_prob_matrix(block_probs,
-                                                    beta_bernoulli_alpha,
-                                                    beta_bernoulli_beta,
-                                                    rng,
-                                                    beta_bernoulli_alpha_between,
-                                                    beta_bernoulli_beta_between);
-      }
+void MFMSBMSampler::remove_cluster(arma::uword k) {
+  block_probs_.shed_row(k);
+  block_probs_.shed_col(k);
+  log_probs_.shed_row(k);
+  log_probs_.shed_col(k);
+  log1m_probs_.shed_row(k);
+  log1m_probs_.shed_col(k);
+  block_edges_.shed_row(k);
+  block_edges_.shed_col(k);
+  node_cluster_edges_.shed_col(k);
+  cluster_size_.shed_row(k);
+
+  for (arma::uword i = 0; i < cluster_assign_.n_elem; i++) {
+    if (cluster_assign_(i) > k) {
+      cluster_assign_(i) -= 1;
     }
   }
-  return cluster_assign;
-
 }
 
-// ----------------------------------------------------------------------------|
-// Sample the block parameters for the MFM - SBM
-// Modified to support separate within/between cluster hyperparameters
-// ----------------------------------------------------------------------------|
-arma::mat block_probs_mfm_sbm(arma::uvec cluster_assign,
-                              arma::umat indicator,
-                              arma::uword no_variables,
-                              double beta_bernoulli_alpha,
-                              double beta_bernoulli_beta,
-                              double beta_bernoulli_alpha_between,
-                              double beta_bernoulli_beta_between,
-                              SafeRNG& rng) {
 
-  arma::uvec cluster_size = table_cpp(cluster_assign);
-  arma::uword no_clusters = cluster_size.n_elem;
+void MFMSBMSampler::sample_allocations(const arma::imat& indicator,
+                                       const arma::vec& log_Vn,
+                                       SafeRNG& rng) {
+  const arma::uword no_variables = cluster_assign_.n_elem;
+
+  arma_randperm_into(rng, order_, no_variables);
+
+  for (arma::uword idx = 0; idx < no_variables; idx++) {
+    const arma::uword node = order_(idx);
+    const arma::uword old = cluster_assign_(node);
+    const arma::uword no_clusters = cluster_size_.n_elem;
+    const bool singleton = cluster_size_(old) == 1;
+
+    tally_node(node);
+
+    // Existing clusters: edges to each cluster priced with its block
+    // probabilities; a singleton's own cluster is offered as the new one.
+    cluster_prob_.set_size(no_clusters + 1);
+    for (arma::uword c = 0; c < no_clusters; c++) {
+      if (singleton && c == old) {
+        cluster_prob_(c) = 0.0;
+        continue;
+      }
+      double loglike = 0.0;
+      for (arma::uword k = 0; k < no_clusters; k++) {
+        const arma::uword edges = node_edges_(k);
+        const arma::uword non_edges = node_members_(k) - edges;
+        if (edges > 0) loglike += edges * log_probs_(c, k);
+        if (non_edges > 0) loglike += non_edges * log1m_probs_(c, k);
+      }
+      cluster_prob_(c) = (dirichlet_alpha_ + static_cast<double>(node_members_(c))) *
+        MY_EXP(loglike);
+    }
+
+    // New cluster: block probabilities integrated out, all edges between
+    double logmarg = 0.0;
+    for (arma::uword k = 0; k < no_clusters; k++) {
+      const arma::uword members = node_members_(k);
+      if (members == 0) continue;
+      const arma::uword edges = node_edges_(k);
+      logmarg += log_alpha_sum_(edges) + log_beta_sum_(members - edges) -
+        log_alpha_beta_sum_(members);
+    }
+    const double log_Vn_ratio = singleton
+      ? log_Vn(no_clusters - 1) - log_Vn(no_clusters - 2)
+      : log_Vn(no_clusters) - log_Vn(no_clusters - 1);
+    cluster_prob_(no_clusters) = dirichlet_alpha_ * MY_EXP(logmarg) * MY_EXP(log_Vn_ratio);
+
+    const arma::uword cluster = sample_categorical(
+      cluster_prob_.memptr(), static_cast<int>(cluster_prob_.n_elem), runif(rng));
+
+    if (singleton) {
+      // A new cluster takes the place of the old singleton and keeps its
+      // block probabilities; otherwise the emptied cluster is removed.
+      if (cluster == no_clusters) continue;
+      move_node(node, old, cluster, indicator);
+      remove_cluster(old);
+    } else {
+      if (cluster == no_clusters) add_cluster(rng);
+      move_node(node, old, cluster, indicator);
+    }
+  }
+}
 
-  arma::mat block_probs(no_clusters, no_clusters);
-  arma::mat theta(no_variables, no_variables);
 
-  double sumG;
-  double size;
+void MFMSBMSampler::sample_block_probs(SafeRNG& rng) {
+  const arma::uword no_clusters = cluster_size_.n_elem;
+  block_probs_.set_size(no_clusters, no_clusters);
 
-  for(arma::uword r = 0; r < no_clusters; r++) {
-    for(arma::uword s = r; s < no_clusters; s++) {
-      sumG = 0;
+  for (arma::uword r = 0; r < no_clusters; r++) {
+    const double size_r = static_cast<double>(cluster_size_(r));
+    for (arma::uword s = r; s < no_clusters; s++) {
+      const double sumG = static_cast<double>(block_edges_(r, s));
 
-      if(r == s) {
+      if (r == s) {
         // Within-cluster: always use main parameters
-        update_sumG(sumG, cluster_assign, indicator, r, r, no_variables);
-        size = static_cast<double>(cluster_size(r)) * (static_cast<double>(cluster_size(r)) - 1) / 2;
-        block_probs(r, s) = rbeta(rng,
-                    sumG + beta_bernoulli_alpha,
-                    size - sumG + beta_bernoulli_beta);
+        const double size = size_r * (size_r - 1) / 2;
+        block_probs_(r, s) = rbeta(rng,
+                    sumG + beta_bernoulli_alpha_,
+                    size - sumG + beta_bernoulli_beta_);
       } else {
         // Between-cluster: use between parameters
-        update_sumG(sumG, cluster_assign, indicator, r, s, no_variables);
-        update_sumG(sumG, cluster_assign, indicator, s, r, no_variables);
-        size = static_cast<double>(cluster_size(s)) * static_cast<double>(cluster_size(r));
-
-        block_probs(r, s) = rbeta(rng, sumG + beta_bernoulli_alpha_between, size - sumG + beta_bernoulli_beta_between);
+        const double size = static_cast<double>(cluster_size_(s)) * size_r;
+        block_probs_(r, s) = rbeta(rng,
+                    sumG + beta_bernoulli_alpha_between_,
+                    size - sumG + beta_bernoulli_beta_between_);
       }
-      block_probs(s, r) = block_probs(r, s);
+      block_probs_(s, r) = block_probs_(r, s);
     }
   }
 
-  return block_probs;
-}
\ No newline at end of file
+  log_probs_ = ARMA_MY_LOG(block_probs_);
+  log1m_probs_ = ARMA_MY_LOG(1.0 - block_probs_);
+}
@@ -2,12 +2,12 @@
 
 /**
  * @file sbm_edge_prior.h
- * @brief Gibbs samplers for the Mixture of Finite Mixtures
+ * @brief Gibbs sampler for the Mixture of Finite Mixtures
  *        Stochastic Block Model (MFM-SBM) edge prior.
  *
  * Implements the block-allocation and block-probability updates
  * described in Geng, Bhattacharya & Pati (2019, JASA 114:526).
- * Called by StochasticBlockEdgePrior::update() in edge_prior.h.
+ * Owned by StochasticBlockEdgePrior in edge_prior.h.
  */
 
 #include <RcppArmadillo.h>
@@ -15,56 +15,138 @@ struct SafeRNG;
 
 
 /**
- * Sample block allocations for the MFM-SBM.
+ * MFMSBMSampler - Stateful MFM-SBM allocation and block-probability sampler
  *
- * Reassigns each variable to a cluster via a collapsed Gibbs step,
- * integrating over block-level inclusion probabilities.
+ * Keeps the cluster allocations, the block probabilities (with their logs),
+ * the cluster sizes, the number of included edges within and between
+ * every pair of blocks and the number from each variable to each cluster.
+ * count_edges() builds the counts from the indicators; when the model
+ * reports its edge toggles, toggle_edge() keeps them current in O(1) per
+ * toggle instead. A node reassignment in sample_allocations() reads the
+ * node's edges per cluster in O(K) and scores every candidate cluster from
+ * them; a move updates the block counts in O(K) and the neighbours' counts
+ * in O(p). sample_block_probs() then draws from the maintained counts
+ * without another pass over the edges.
  *
- * @param cluster_assign   Current cluster assignment (length p).
- * @param no_variables      Number of variables p.
- * @param log_Vn            Log partition coefficients from compute_Vn_mfm_sbm().
- * @param block_probs       Current block-level inclusion probability matrix.
- * @param indicator         Edge indicator matrix (p x p, upper-triangular).
- * @param dirichlet_alpha   Dirichlet concentration parameter for cluster sizes.
- * @param beta_bernoulli_alpha   Beta-Bernoulli alpha for within-block edges.
- * @param beta_bernoulli_beta    Beta-Bernoulli beta for within-block edges.
- * @param beta_bernoulli_alpha_between  Beta-Bernoulli alpha for between-block edges.
- * @param beta_bernoulli_beta_between   Beta-Bernoulli beta for between-block edges.
- * @param rng               Random number generator.
- * @return Updated cluster assignment vector (length p).
+ * The new-cluster marginal, log B(a + G, b + N - G) / B(a, b), is read
+ * from prefix sums of log(a + m), log(b + m) and log(a + b + m) tabulated
+ * once per number of variables.
  */
-arma::uvec block_allocations_mfm_sbm(arma::uvec cluster_assign,
-                                                arma::uword no_variables,
-                                                arma::vec log_Vn,
-                                                arma::mat block_probs,
-                                                arma::umat indicator,
-                                                arma::uword dirichlet_alpha,
-                                                double beta_bernoulli_alpha,
-                                                double beta_bernoulli_beta,
-                                                double beta_bernoulli_alpha_between,
-                                                double beta_bernoulli_beta_between,
-                                                SafeRNG& rng);
+class MFMSBMSampler {
+public:
+    MFMSBMSampler() = default;
 
-/**
- * Sample block-level inclusion probabilities for the MFM-SBM.
- *
- * Draws within-block probabilities from Beta(alpha + included, beta + excluded)
- * and between-block probabilities from separate Beta hyperparameters.
- *
- * @param cluster_assign   Current cluster assignment (length p).
- * @param indicator         Edge indicator matrix (p x p, upper-triangular).
- * @param no_variables      Number of variables p.
- * @param beta_bernoulli_alpha   Beta-Bernoulli alpha for within-block edges.
- * @param beta_bernoulli_beta    Beta-Bernoulli beta for within-block edges.
- * @param beta_bernoulli_alpha_between  Beta-Bernoulli alpha for between-block edges.
- * @param beta_bernoulli_beta_between   Beta-Bernoulli beta for between-block edges.
- * @return Block-level inclusion probability matrix (K x K).
- */
-arma::mat block_probs_mfm_sbm(arma::uvec cluster_assign,
-                                        arma::umat indicator,
-                                        arma::uword no_variables,
-                                        double beta_bernoulli_alpha,
-                                        double beta_bernoulli_beta,
-                                        double beta_bernoulli_alpha_between,
-                                        double beta_bernoulli_beta_between,
-                                        SafeRNG& rng);
\ No newline at end of file
+    /**
+     * @param beta_bernoulli_alpha          Beta-Bernoulli alpha for within-block edges.
+     * @param beta_bernoulli_beta           Beta-Bernoulli beta for within-block edges.
+     * @param beta_bernoulli_alpha_between  Beta-Bernoulli alpha for between-block edges.
+     * @param beta_bernoulli_beta_between   Beta-Bernoulli beta for between-block edges.
+     * @param dirichlet_alpha               Dirichlet concentration for cluster sizes.
+     */
+    MFMSBMSampler(double beta_bernoulli_alpha,
+                  double beta_bernoulli_beta,
+                  double beta_bernoulli_alpha_between,
+                  double beta_bernoulli_beta_between,
+                  double dirichlet_alpha);
+
+    /**
+     * Start from the given allocations (labels 0, ..., K-1, none empty).
+     * @param cluster_assign  Cluster of each variable (length p).
+     */
+    void set_allocations(const arma::uvec& cluster_assign);
+
+    /**
+     * Start from the given block probabilities (K x K for the K clusters of
+     * the allocations), e.g. to continue a saved chain.
+     * @param block_probs  Block inclusion probabilities
+     */
+    void set_block_probs(const arma::mat& block_probs);
+
+    /**
+     * Recount the cluster sizes and the included edges per block pair and
+     * per variable and cluster.
+     * @param indicator  Edge indicator matrix (p x p; the upper triangle is read).
+     */
+    void count_edges(const arma::imat& indicator);
+
+    /**
+     * Apply one switched edge indicator to the edge counts.
+     * @param i, j      Endpoints of the edge (i != j)
+     * @param included  New state of the edge
+     */
+    void toggle_edge(arma::uword i, arma::uword j, bool included);
+
+    /**
+     * Reassign every variable in random order by a collapsed Gibbs step.
+     *
+     * Requires counts that match the indicators (count_edges(), then
+     * toggle_edge() for every change since); keeps them current as nodes
+     * move.
+     *
+     * @param indicator  Edge indicator matrix (p x p; the upper triangle is read).
+     * @param log_Vn     Log partition coefficients from compute_Vn_mfm_sbm().
+     * @param rng        Random number generator.
+     */
+    void sample_allocations(const arma::imat& indicator,
+                            const arma::vec& log_Vn,
+                            SafeRNG& rng);
+
+    /**
+     * Draw the block probabilities given the allocations and edge counts.
+     *
+     * Within-block probabilities come from Beta(alpha + included,
+     * beta + excluded), between-block ones from the between hyperparameters.
+     *
+     * @param rng  Random number generator.
+     */
+    void sample_block_probs(SafeRNG& rng);
+
+    /** @return Cluster of each variable (0-based). */
+    const arma::uvec& allocations() const { return cluster_assign_; }
+
+    /** @return Block-level inclusion probability matrix (K x K). */
+    const arma::mat& block_probs() const { return block_probs_; }
+
+private:
+    /// Read the edges from `node` to the members of every cluster.
+    void tally_node(arma::uword node);
+
+    /// Move `node` between clusters, updating sizes and edge counts.
+    void move_node(arma::uword node, arma::uword from, arma::uword to,
+                   const arma::imat& indicator);
+
+    /// Append an empty cluster with fresh block probabilities.
+    void add_cluster(SafeRNG& rng);
+
+    /// Drop the empty cluster `k` and relabel the clusters above it.
+    void remove_cluster(arma::uword k);
+
+    /// Recompute the logs of block-probability row and column k.
+    void refresh_log_probs(arma::uword k);
+
+    /// Tabulate the new-cluster marginal prefix sums for p variables.
+    void build_marginal_tables(arma::uword p);
+
+    double beta_bernoulli_alpha_ = 1.0;
+    double beta_bernoulli_beta_ = 1.0;
+    double beta_bernoulli_alpha_between_ = 1.0;
+    double beta_bernoulli_beta_between_ = 1.0;
+    double dirichlet_alpha_ = 1.0;
+
+    arma::uvec cluster_assign_;         ///< Cluster of each variable
+    arma::uvec cluster_size_;           ///< Members per cluster (K)
+    arma::umat block_edges_;            ///< Included edges per block pair (K x K, symmetric)
+    arma::umat node_cluster_edges_;     ///< Included edges from each variable to each cluster (p x K)
+    arma::mat block_probs_;             ///< Block inclusion probabilities (K x K)
+    arma::mat log_probs_;               ///< log(block_probs_)
+    arma::mat log1m_probs_;             ///< log(1 - block_probs_)
+
+    arma::uvec node_edges_;             ///< Edges from the current node per cluster
+    arma::uvec node_members_;           ///< Cluster sizes without the current node
+    arma::vec cluster_prob_;            ///< Candidate weights, K + 1
+    arma::uvec order_;                  ///< Node visiting order
+
+    arma::vec log_alpha_sum_;           ///< sum_{m < n} log(alpha_between + m)
+    arma::vec log_beta_sum_;            ///< sum_{m < n} log(beta_between + m)
+    arma::vec log_alpha_beta_sum_;      ///< sum_{m < n} log(alpha_between + beta_between + m)
+};
@@ -0,0 +1,148 @@
+/**
+ * @file polya_gamma.h
+ * @brief Exact Pólya-Gamma PG(1, z) draws (Polson, Scott and Windle, 2013).
+ *
+ * The logistic likelihood factor of a binary response x is the mixture
+ *
+ *   exp(x psi) / (1 + exp(psi)) = 1/2 E[exp((x - 1/2) psi - omega psi^2 / 2)],
+ *
+ * with omega ~ PG(1, 0), so given omega a logistic regression becomes a
+ * Gaussian one, and omega | psi ~ PG(1, psi). rpolya_gamma() draws it with
+ * Devroye's alternating-series sampler for J*(1, z) = 4 PG(1, 2z): a
+ * proposal that mixes a truncated inverse Gaussian on (0, t] with an
+ * exponential tail on (t, inf), accepted by the partial sums of the series
+ * density. At the truncation point t = 0.64 the proposal is accepted at
+ * least 99.9% of the time, for any z.
+ *
+ * The sampler is templated on the engine so that bulk draws can run on
+ * XoshiroLanes (see rpolya_gamma_fill()), whose state update vectorizes;
+ * the rejection loop itself stays scalar.
+ */
+
+#pragma once
+
+#include <RcppArmadillo.h>
+#include <Rmath.h>
+#include <cmath>
+#include <cstddef>
+#include <boost/random/exponential_distribution.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
+#include "math/log_sum_exp.h"
+#include "rng/rng_utils.h"
+
+namespace polya_gamma_detail {
+
+/// Truncation point of the proposal, Devroye's optimum.
+constexpr double truncation = 0.64;
+
+// Coefficient a_n(x) of the series density of J*(1, 0): the left form on
+// (0, t], the right form on (t, inf).
+inline double series_term(int n, double x) {
+  const double k = n + 0.5;
+  if (x <= truncation) {
+    return M_PI * k * std::pow(2.0 / (M_PI * x), 1.5) * std::exp(-2.0 * k * k / x);
+  }
+  return M_PI * k * std::exp(-0.5 * k * k * M_PI * M_PI * x);
+}
+
+// Inverse Gaussian IG(1/z, 1) truncated to (0, t]. For a mean beyond t,
+// a truncated Levy (z = 0) proposal accepted with exp(-z^2 x / 2);
+// otherwise plain inverse Gaussian draws until one falls below t.
+template <typename Engine>
+double truncated_inverse_gaussian(Engine& eng, double z) {
+  constexpr double t = truncation;
+  boost::random::uniform_real_distribution<double> unif(0.0, 1.0);
+  boost::random::exponential_distribution<double> expo(1.0);
+  if (z < 1.0 / t) {
+    while (true) {
+      double e1, e2;
+      do {
+        e1 = expo(eng);
+        e2 = expo(eng);
+      } while (e1 * e1 > 2.0 * e2 / t);
+      const double x = t / ((1.0 + t * e1) * (1.0 + t * e1));
+      if (unif(eng) <= std::exp(-0.5 * z * z * x)) return x;
+    }
+  }
+  boost::random::normal_distribution<double> norm(0.0, 1.0);
+  const double mu = 1.0 / z;
+  while (true) {
+    const double y = norm(eng);
+    const double my = mu * y * y;
+    double x = mu + 0.5 * mu * my - 0.5 * mu * std::sqrt(4.0 * my + my * my);
+    if (unif(eng) > mu / (mu + x)) x = mu * mu / x;
+    if (x <= t) return x;
+  }
+}
+
+} // namespace polya_gamma_detail
+
+
+/**
+ * Probability that the J*(1, z) proposal takes the exponential tail.
+ *
+ * The tail has mass (pi / 2) exp(-K t) / K, K = pi^2 / 8 + z^2 / 2, and the
+ * inverse-Gaussian part 2 exp(-z) P(IG(1/z, 1) <= t); both are combined
+ * in logs so large z neither overflows nor divides zero by zero.
+ *
+ * @param z  |psi| / 2
+ */
+inline double polya_gamma_tail_probability(double z) {
+  constexpr double t = polya_gamma_detail::truncation;
+  const double K = M_PI * M_PI / 8.0 + 0.5 * z * z;
+  const double log_tail = std::log(M_PI / 2.0) - K * t - std::log(K);
+  const double root_t = std::sqrt(t);
+  const double log_left = std::log(2.0) + log_sum_exp(
+    -z + R::pnorm((t * z - 1.0) / root_t, 0.0, 1.0, true, true),
+    z + R::pnorm(-(t * z + 1.0) / root_t, 0.0, 1.0, true, true));
+  return 1.0 / (1.0 + std::exp(log_left - log_tail));
+}
+
+/**
+ * Draw omega ~ PG(1, psi).
+ *
+ * @param eng  Uniform random bit generator (SafeRNG::eng, XoshiroLanes)
+ * @param psi  Tilting parameter; PG(1, psi) = PG(1, -psi)
+ */
+template <typename Engine>
+double rpolya_gamma(Engine& eng, double psi) {
+  using polya_gamma_detail::series_term;
+  const double z = 0.5 * std::abs(psi);
+  const double K = M_PI * M_PI / 8.0 + 0.5 * z * z;
+  const double p_tail = polya_gamma_tail_probability(z);
+  boost::random::uniform_real_distribution<double> unif(0.0, 1.0);
+  boost::random::exponential_distribution<double> expo(1.0);
+
+  while (true) {
+    const double x = unif(eng) < p_tail
+      ? polya_gamma_detail::truncation + expo(eng) / K
+      : polya_gamma_detail::truncated_inverse_gaussian(eng, z);
+
+    // Accept on an odd partial sum above u, reject on an even one below
+    double s = series_term(0, x);
+    const double u = unif(eng) * s;
+    for (int n = 1;; ++n) {
+      if (n % 2 == 1) {
+        s -= series_term(n, x);
+        if (u <= s) return 0.25 * x;
+      } else {
+        s += series_term(n, x);
+        if (u > s) break;
+      }
+    }
+  }
+}
+
+/**
+ * Fill out[i] ~ PG(1, psi[i]) for i in [0, n).
+ *
+ * @param eng  Uniform random bit generator; a XoshiroLanes for bulk draws
+ * @param psi  n tilting parameters
+ * @param out  Destination of at least n doubles (may alias psi)
+ * @param n    Number of draws
+ */
+template <typename Engine>
+void rpolya_gamma_fill(Engine& eng, const double* psi, double* out, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) out[i] = rpolya_gamma(eng, psi[i]);
+}
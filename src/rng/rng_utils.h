@@ -5,15 +5,27 @@
  * Provides SafeRNG, a seedable wrapper around dqrng's xoshiro256++ engine,
  * and a set of distribution helpers that mirror R's `runif`, `rnorm`, etc.
  * Each model instance owns its own SafeRNG so parallel chains do not share
- * state. Boost.Random distributions are used instead of `<random>` to
+ * state. Chains and simulation draws take their engines from rng_streams(),
+ * which spaces them by xoshiro256++ long jumps instead of seeding each one
+ * separately. Boost.Random distributions are used instead of `<random>` to
  * guarantee identical output across compilers and platforms.
  *
- * Two groups of helpers:
+ * Three groups of helpers:
  *   - **Scalar** (`runif`, `rnorm`, `rbern`, `rbeta`, `rexp`) — return a
  *     single draw.
- *   - **Armadillo** (`arma_rnorm_vec`, `arma_rnorm_mat`, `arma_runif_vec`,
- *     `arma_runif_mat`, `arma_randperm`) — fill vectors/matrices element-
- *     wise through the same scalar primitives.
+ *   - **Bulk, same stream** (`runif_fill`, `rnorm_fill`,
+ *     `arma_randperm_into`, and the Armadillo wrappers `arma_rnorm_vec`,
+ *     `arma_rnorm_mat`, `arma_runif_vec`, `arma_runif_mat`,
+ *     `arma_randperm`) — write a block into caller-owned memory. They are
+ *     bit-compatible with the scalar helpers: a fill of n values equals n
+ *     scalar calls and leaves the engine in the same state, so existing
+ *     seeds reproduce.
+ *   - **Bulk, lane stream** (`runif_fill_lanes`, `rnorm_fill_lanes`) — draw
+ *     through XoshiroLanes, four independent xoshiro256++ streams stepped
+ *     together so the compiler can vectorize the state update. Seeded from
+ *     one draw of the chain's engine; reproducible for a given seed, but a
+ *     different sequence from the scalar helpers. Use them only where no
+ *     earlier output has to be reproduced.
  */
 
 // [[Rcpp::depends(BH)]]
@@ -24,7 +36,13 @@
 // Only include xoshiro.h from dqrng - avoid dqrng_distribution.h which pulls
 // in dqrng_generator.h -> convert_seed.h that has GCC 14 compatibility issues
 #include <xoshiro.h>
+#include <cstdint>
+#include <numeric>
 #include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
 #include <boost/random/uniform_real_distribution.hpp>
 #include <boost/random/normal_distribution.hpp>
 #include <boost/random/exponential_distribution.hpp>
@@ -60,9 +78,74 @@ struct SafeRNG {
   static constexpr result_type max() { return dqrng::xoshiro256plusplus::max(); }
   /// Advance the engine and return the next pseudorandom integer.
   result_type operator()() { return eng(); }
+
+  /// Advance by 2^128 draws: the spacing of sub-streams within a stream.
+  void jump() { eng.jump(); }
+
+  /// Advance by 2^192 draws: the spacing of the streams of rng_streams().
+  void long_jump() { eng.long_jump(); }
+
+  /**
+   * Copy of this engine exactly one jump() ahead.
+   *
+   * Calling split() repeatedly on a stream yields up to 2^64 sub-streams
+   * (e.g. one per thread inside a chain) that do not overlap each other or
+   * the remaining draws of the parent, as long as the parent draws fewer
+   * than 2^128 values and stays jump()-aligned.
+   */
+  SafeRNG split() {
+    jump();
+    return *this;
+  }
+
+  /**
+   * Engine state as text, for saving a chain and continuing it later.
+   * Restoring it with set_state() continues the exact same stream.
+   */
+  std::string state() const {
+    std::ostringstream out;
+    out << eng;
+    return out.str();
+  }
+
+  /**
+   * Restore an engine state written by state().
+   * @throws std::invalid_argument if `text` is not a saved engine state
+   */
+  void set_state(const std::string& text) {
+    std::istringstream in(text);
+    in >> eng;
+    if (in.fail()) {
+      throw std::invalid_argument("Not a saved xoshiro256++ engine state.");
+    }
+  }
 };
 
 
+/**
+ * Non-overlapping RNG streams derived from one seed.
+ *
+ * Stream k is SafeRNG(seed) advanced by k long jumps (2^192 draws each), so
+ * stream 0 is the plain seeded engine and different chains or simulation
+ * draws never share state, whatever thread runs them. Streams are built
+ * incrementally: n streams cost n long jumps.
+ *
+ * @param seed  User-supplied seed
+ * @param n     Number of streams
+ * @return One engine per stream, in order
+ */
+inline std::vector<SafeRNG> rng_streams(int seed, std::size_t n) {
+  std::vector<SafeRNG> streams;
+  streams.reserve(n);
+  SafeRNG rng(seed);
+  for (std::size_t k = 0; k < n; ++k) {
+    if (k > 0) rng.long_jump();
+    streams.push_back(rng);
+  }
+  return streams;
+}
+
+
 // ============================================================
 // Scalar RNG helpers
 // ============================================================
@@ -76,6 +159,21 @@ inline double runif(SafeRNG& rng) {
   return boost::random::uniform_real_distribution<double>(0.0, 1.0)(rng.eng);
 }
 
+/**
+ * Map one 64-bit engine word to [0, 1) the way runif() does.
+ *
+ * Boost's uniform_real_distribution divides the word by 2^64 and redraws
+ * when rounding lands on 1, so word * 2^-64 reproduces it exactly.
+ *
+ * @param word  Raw engine output
+ * @param u     Receives the uniform variate
+ * @return false when the word rounds to 1 and must be redrawn
+ */
+inline bool uniform_from_word(std::uint64_t word, double& u) {
+  u = static_cast<double>(word) * 0x1p-64;
+  return u < 1.0;
+}
+
 /**
  * Draw from Normal(mu, sigma).
  * @param rng    Random number generator
@@ -119,9 +217,44 @@ inline double rexp(SafeRNG& rng, double lambda) {
 }
 
 // ============================================================
-// Armadillo RNG helpers
+// Bulk RNG helpers (same stream as the scalar helpers)
 // ============================================================
 
+/**
+ * Fill contiguous memory with Uniform(0, 1) draws.
+ *
+ * Produces the same sequence as n calls to runif(rng), reading raw engine
+ * words instead of going through the distribution object per draw.
+ *
+ * @param rng  Random number generator
+ * @param out  Destination of at least n doubles
+ * @param n    Number of draws
+ */
+inline void runif_fill(SafeRNG& rng, double* out, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    while (!uniform_from_word(rng.eng(), out[i])) {}
+  }
+}
+
+/**
+ * Fill contiguous memory with Normal(mu, sigma) draws.
+ *
+ * Produces the same sequence as n calls to rnorm(rng, mu, sigma), but
+ * reuses one distribution object across the block.
+ *
+ * @param rng    Random number generator
+ * @param out    Destination of at least n doubles
+ * @param n      Number of draws
+ * @param mu     Mean (default 0)
+ * @param sigma  Standard deviation (default 1)
+ */
+inline void rnorm_fill(SafeRNG& rng, double* out, std::size_t n,
+                       double mu = 0.0, double sigma = 1.0) {
+  boost::random::normal_distribution<double> dist(mu, sigma);
+  for (std::size_t i = 0; i < n; ++i)
+    out[i] = dist(rng.eng);
+}
+
 /**
  * Fill a vector with Normal(mu, sigma) draws.
  * @param rng    Random number generator
@@ -134,8 +267,7 @@ inline arma::vec arma_rnorm_vec(SafeRNG& rng,
                                 arma::uword n,
                                 double mu = 0.0, double sigma = 1.0) {
   arma::vec out(n);
-  for (arma::uword i = 0; i < n; ++i)
-    out[i] = rnorm(rng, mu, sigma);
+  rnorm_fill(rng, out.memptr(), n, mu, sigma);
   return out;
 }
 
@@ -152,11 +284,7 @@ inline arma::mat arma_rnorm_mat(SafeRNG& rng,
                                 arma::uword nrow, arma::uword ncol,
                                 double mu = 0.0, double sigma = 1.0) {
   arma::mat out(nrow, ncol);
-  for (arma::uword j = 0; j < ncol; ++j) {
-    for (arma::uword i = 0; i < nrow; ++i) {
-      out(i, j) = rnorm(rng, mu, sigma);
-    }
-  }
+  rnorm_fill(rng, out.memptr(), out.n_elem, mu, sigma);
   return out;
 }
 
@@ -168,8 +296,7 @@ inline arma::mat arma_rnorm_mat(SafeRNG& rng,
  */
 inline arma::vec arma_runif_vec(SafeRNG& rng, arma::uword n) {
   arma::vec out(n);
-  for (arma::uword i = 0; i < n; ++i)
-    out[i] = runif(rng);
+  runif_fill(rng, out.memptr(), n);
   return out;
 }
 
@@ -183,14 +310,29 @@ inline arma::vec arma_runif_vec(SafeRNG& rng, arma::uword n) {
 inline arma::mat arma_runif_mat(SafeRNG& rng,
                                 arma::uword nrow, arma::uword ncol) {
   arma::mat out(nrow, ncol);
-  for (arma::uword j = 0; j < ncol; ++j) {
-    for (arma::uword i = 0; i < nrow; ++i) {
-      out(i, j) = runif(rng);
-    }
-  }
+  runif_fill(rng, out.memptr(), out.n_elem);
   return out;
 }
 
+/**
+ * Random permutation of 0, 1, ..., n-1 written into a caller-owned vector.
+ *
+ * Fisher–Yates shuffle in place; `out` is only resized when its length is
+ * not n, so a vector reused across iterations keeps its memory. Draws the
+ * same permutation as arma_randperm(). The shuffle goes through
+ * std::shuffle, whose swap sequence is fixed per standard library rather
+ * than by the C++ standard.
+ *
+ * @param rng  Random number generator
+ * @param out  Receives the permuted indices
+ * @param n    Number of elements
+ */
+inline void arma_randperm_into(SafeRNG& rng, arma::uvec& out, arma::uword n) {
+  if (out.n_elem != n) out.set_size(n);
+  std::iota(out.begin(), out.end(), 0);
+  std::shuffle(out.begin(), out.end(), rng.eng);
+}
+
 /**
  * Random permutation of 0, 1, ..., n-1 (like arma::randperm).
  * @param rng  Random number generator
@@ -198,9 +340,153 @@ inline arma::mat arma_runif_mat(SafeRNG& rng,
  * @return Permuted index vector
  */
 inline arma::uvec arma_randperm(SafeRNG& rng, arma::uword n) {
-  arma::uvec out(n);
-  std::iota(out.begin(), out.end(), 0);
-  std::shuffle(out.begin(), out.end(), rng.eng);
+  arma::uvec out;
+  arma_randperm_into(rng, out, n);
   return out;
 }
 
+// ============================================================
+// Bulk RNG helpers (lane stream)
+// ============================================================
+
+/**
+ * XoshiroLanes - Four xoshiro256++ streams stepped in lockstep
+ *
+ * The state is stored lane-minor (s_[k][lane]), so one refill advances all
+ * lanes with the same 64-bit adds, shifts and xors and the compiler can map
+ * the lane loop onto vector registers. Words are served from a buffer of
+ * `block_size` values, lanes interleaved.
+ *
+ * Lane 0 is seeded by expanding one word of the parent engine with
+ * SplitMix64; lane k is lane 0 advanced by k xoshiro256 jumps (2^128 draws
+ * each), so the lanes never overlap. Constructing a XoshiroLanes advances
+ * the parent by exactly one draw.
+ *
+ * Satisfies the UniformRandomBitGenerator interface, so Boost
+ * distributions can draw from it directly.
+ */
+class XoshiroLanes {
+public:
+  static constexpr std::size_t num_lanes = 4;
+  static constexpr std::size_t block_size = 16 * num_lanes;
+
+  using result_type = std::uint64_t;
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return ~result_type(0); }
+
+  explicit XoshiroLanes(SafeRNG& parent) {
+    std::uint64_t x = parent.eng();
+    std::uint64_t state[4];
+    for (auto& w : state) w = splitmix64(x);
+
+    for (std::size_t lane = 0; lane < num_lanes; ++lane) {
+      for (std::size_t k = 0; k < 4; ++k) s_[k][lane] = state[k];
+      jump(state);
+    }
+  }
+
+  /// Next word of the interleaved lane stream.
+  result_type operator()() {
+    if (pos_ == block_size) refill();
+    return buffer_[pos_++];
+  }
+
+private:
+  static std::uint64_t rotl(std::uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+  }
+
+  static std::uint64_t splitmix64(std::uint64_t& x) {
+    std::uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  static void next(std::uint64_t s[4]) {
+    const std::uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+  }
+
+  // Advance a single xoshiro256 state by 2^128 steps.
+  static void jump(std::uint64_t s[4]) {
+    static constexpr std::uint64_t poly[4] = {
+      0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+      0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+    };
+    std::uint64_t acc[4] = {0, 0, 0, 0};
+    for (std::uint64_t word : poly) {
+      for (int b = 0; b < 64; ++b) {
+        if (word & (std::uint64_t(1) << b)) {
+          for (int k = 0; k < 4; ++k) acc[k] ^= s[k];
+        }
+        next(s);
+      }
+    }
+    for (int k = 0; k < 4; ++k) s[k] = acc[k];
+  }
+
+  void refill() {
+    for (std::size_t step = 0; step < block_size / num_lanes; ++step) {
+      std::uint64_t* out = buffer_ + step * num_lanes;
+      for (std::size_t l = 0; l < num_lanes; ++l) {
+        out[l] = rotl(s_[0][l] + s_[3][l], 23) + s_[0][l];
+        const std::uint64_t t = s_[1][l] << 17;
+        s_[2][l] ^= s_[0][l];
+        s_[3][l] ^= s_[1][l];
+        s_[1][l] ^= s_[2][l];
+        s_[0][l] ^= s_[3][l];
+        s_[2][l] ^= t;
+        s_[3][l] = rotl(s_[3][l], 45);
+      }
+    }
+    pos_ = 0;
+  }
+
+  alignas(32) std::uint64_t s_[4][num_lanes];
+  alignas(32) std::uint64_t buffer_[block_size];
+  std::size_t pos_ = block_size;
+};
+
+/**
+ * Fill contiguous memory with Uniform(0, 1) draws from the lane stream.
+ *
+ * Not bit-compatible with runif_fill(); see XoshiroLanes.
+ *
+ * @param rng  Random number generator (advanced by one draw)
+ * @param out  Destination of at least n doubles
+ * @param n    Number of draws
+ */
+inline void runif_fill_lanes(SafeRNG& rng, double* out, std::size_t n) {
+  XoshiroLanes lanes(rng);
+  for (std::size_t i = 0; i < n; ++i) {
+    while (!uniform_from_word(lanes(), out[i])) {}
+  }
+}
+
+/**
+ * Fill contiguous memory with Normal(mu, sigma) draws from the lane stream.
+ *
+ * Uses Boost's ziggurat, as rnorm() does, on XoshiroLanes words, so the
+ * output is portable across platforms. Not bit-compatible with
+ * rnorm_fill().
+ *
+ * @param rng    Random number generator (advanced by one draw)
+ * @param out    Destination of at least n doubles
+ * @param n      Number of draws
+ * @param mu     Mean (default 0)
+ * @param sigma  Standard deviation (default 1)
+ */
+inline void rnorm_fill_lanes(SafeRNG& rng, double* out, std::size_t n,
+                             double mu = 0.0, double sigma = 1.0) {
+  XoshiroLanes lanes(rng);
+  boost::random::normal_distribution<double> dist(mu, sigma);
+  for (std::size_t i = 0; i < n; ++i)
+    out[i] = dist(lanes);
+}
+
@@ -0,0 +1,96 @@
+#include <RcppArmadillo.h>
+#include <chrono>
+#include "rng/polya_gamma.h"
+#include "rng/rng_utils.h"
+
+// Draws from the bulk RNG helpers next to the scalar helpers they must
+// match. `*_scalar` and `*_fill` come from two engines seeded alike, so the
+// same-stream helpers can be compared element-wise; `*_lanes` are the lane
+// stream draws. `next_*` is one scalar uniform drawn after each fill, which
+// checks that the fill left the engine where n scalar calls would have.
+// [[Rcpp::export]]
+Rcpp::List test_rng_fills(const int seed, const int n) {
+  SafeRNG scalar_rng(seed), fill_rng(seed);
+
+  arma::vec unif_scalar(n), unif_fill(n);
+  for (int i = 0; i < n; ++i) unif_scalar[i] = runif(scalar_rng);
+  runif_fill(fill_rng, unif_fill.memptr(), n);
+  const double next_scalar = runif(scalar_rng);
+  const double next_fill = runif(fill_rng);
+
+  arma::uvec perm = arma_randperm(scalar_rng, n);
+  arma::uvec perm_into(3);
+  arma_randperm_into(fill_rng, perm_into, n);
+
+  SafeRNG lane_rng(seed);
+  arma::vec unif_lanes(n), norm_lanes(n);
+  runif_fill_lanes(lane_rng, unif_lanes.memptr(), n);
+  rnorm_fill_lanes(lane_rng, norm_lanes.memptr(), n);
+
+  return Rcpp::List::create(
+    Rcpp::Named("unif_scalar") = Rcpp::NumericVector(unif_scalar.begin(), unif_scalar.end()),
+    Rcpp::Named("unif_fill")   = Rcpp::NumericVector(unif_fill.begin(), unif_fill.end()),
+    Rcpp::Named("next_scalar") = next_scalar,
+    Rcpp::Named("next_fill")   = next_fill,
+    Rcpp::Named("perm")        = Rcpp::IntegerVector(perm.begin(), perm.end()),
+    Rcpp::Named("perm_into")   = Rcpp::IntegerVector(perm_into.begin(), perm_into.end()),
+    Rcpp::Named("unif_lanes")  = Rcpp::NumericVector(unif_lanes.begin(), unif_lanes.end()),
+    Rcpp::Named("norm_lanes")  = Rcpp::NumericVector(norm_lanes.begin(), norm_lanes.end())
+  );
+}
+
+// n draws of PG(1, psi[j]) per column j: the first half from the scalar
+// engine, the second from a lane stream, as the Pólya-Gamma sampler draws.
+// [[Rcpp::export]]
+Rcpp::NumericMatrix test_polya_gamma(const Rcpp::NumericVector& psi, const int n,
+                                     const int seed) {
+  SafeRNG rng(seed);
+  XoshiroLanes lanes(rng);
+  const int half = n / 2;
+  Rcpp::NumericMatrix out(n, psi.size());
+  for (int j = 0; j < psi.size(); ++j) {
+    for (int i = 0; i < half; ++i) out(i, j) = rpolya_gamma(rng.eng, psi[j]);
+    for (int i = half; i < n; ++i) out(i, j) = rpolya_gamma(lanes, psi[j]);
+  }
+  return out;
+}
+
+// Benchmark of the scalar, same-stream bulk and lane-stream fills on a
+// block of n doubles, repeated `reps` times. Returns nanoseconds per draw.
+// Development helper: bgms:::benchmark_rng_fills().
+// [[Rcpp::export]]
+Rcpp::DataFrame benchmark_rng_fills(const int n = 4096, const int reps = 2000) {
+  SafeRNG rng(1);
+  arma::vec y(n);
+  double sink = 0.0;
+
+  auto time_ns = [&](auto&& body) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; ++r) {
+      body();
+      sink += y[r % n];
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() /
+      (static_cast<double>(reps) * n);
+  };
+
+  Rcpp::CharacterVector impl = {"scalar", "fill", "lanes"};
+  Rcpp::NumericVector unif_ns(3), norm_ns(3);
+
+  unif_ns[0] = time_ns([&] { for (int i = 0; i < n; ++i) y[i] = runif(rng); });
+  unif_ns[1] = time_ns([&] { runif_fill(rng, y.memptr(), n); });
+  unif_ns[2] = time_ns([&] { runif_fill_lanes(rng, y.memptr(), n); });
+
+  norm_ns[0] = time_ns([&] { for (int i = 0; i < n; ++i) y[i] = rnorm(rng); });
+  norm_ns[1] = time_ns([&] { rnorm_fill(rng, y.memptr(), n); });
+  norm_ns[2] = time_ns([&] { rnorm_fill_lanes(rng, y.memptr(), n); });
+
+  Rcpp::DataFrame out = Rcpp::DataFrame::create(
+    Rcpp::Named("implementation") = impl,
+    Rcpp::Named("runif_ns")       = unif_ns,
+    Rcpp::Named("rnorm_ns")       = norm_ns
+  );
+  out.attr("checksum") = sink;
+  return out;
+}
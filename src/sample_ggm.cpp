@@ -2,7 +2,6 @@
 #include <memory>
 #include <RcppArmadillo.h>
 #include <RcppParallel.h>
-#include <tbb/global_control.h>
 
 #include "models/ggm/ggm_model.h"
 #include "utils/progress_manager.h"
@@ -11,7 +10,9 @@
 #include "priors/parameter_prior.h"
 #include "mcmc/execution/chain_result.h"
 #include "mcmc/execution/chain_runner.h"
+#include "mcmc/execution/sampler_session.h"
 #include "mcmc/execution/sampler_config.h"
+#include "mcmc/execution/sampler_settings.h"
 
 // [[Rcpp::export]]
 Rcpp::List sample_ggm(
@@ -38,8 +39,13 @@ Rcpp::List sample_ggm(
     const int max_tree_depth = 10,
     const bool na_impute = false,
     const Rcpp::Nullable<Rcpp::IntegerMatrix> missing_index_nullable = R_NilValue,
-    const double delta = 0.0
+    const double delta = 0.0,
+    const Rcpp::Nullable<Rcpp::List> settings = R_NilValue
 ) {
+    // Further sampler settings (see apply_sampler_settings()), plus the
+    // GGM ones: column_updates, sparse_cholesky, edge_update_schedule and
+    // keep_session
+    const SamplerSettings sampler(settings);
 
     // Create parameter priors from R input
     double pairwise_scale = Rcpp::as<double>(inputFromR["pairwise_scale"]);
@@ -77,7 +83,9 @@ Rcpp::List sample_ggm(
     //     between-model MH proposal SDs, which are still 1-D componentwise
     //     RW MH. Hardcode 0.44 there to keep stage-3b RM on the right
     //     fixed point.
-    const double mh_target = (sampler_type == "nuts") ? 0.44 : target_acceptance;
+    const double mh_target =
+      (sampler_type == "nuts" || sampler_type == "nuts-iterative" ||
+       sampler_type == "adaptive-hmc") ? 0.44 : target_acceptance;
     model.set_metropolis_target_accept(mh_target);
 
     // Determinant-tilt prior on |K|: shifts both NUTS and MH targets by
@@ -85,6 +93,18 @@ Rcpp::List sample_ggm(
     // both gradient paths and all four MH ratios in GGMModel.
     model.set_determinant_tilt(delta);
 
+    // Column-blocked off-diagonal MH updates (bgms.ggm_column_updates)
+    model.set_column_block_updates(sampler.get("column_updates", false));
+
+    // Sparse Cholesky factor for sparse graphs (bgms.ggm_sparse_cholesky);
+    // the gradient samplers work on the dense factor
+    model.set_sparse_cholesky(sampler.get("sparse_cholesky", false) &&
+                              sampler_type == "adaptive-metropolis");
+
+    // Edge-indicator moves on pairs drawn by learned weights (bgms.edge_update_schedule)
+    model.set_informed_edge_updates(
+        sampler.get<std::string>("edge_update_schedule", "sequential") == "informed");
+
     // Set up missing data imputation (same pattern as OMRF)
     if (na_impute && missing_index_nullable.isNotNull()) {
         arma::imat missing_index = Rcpp::as<arma::imat>(
@@ -102,6 +122,7 @@ Rcpp::List sample_ggm(
     config.target_acceptance = target_acceptance;
     config.max_tree_depth = max_tree_depth;
     config.na_impute = na_impute;
+    apply_sampler_settings(config, sampler);
 
     // Set up progress manager
     ProgressManager pm(no_chains, no_iter, no_warmup, 50, progress_type, true, progress_callback);
@@ -117,10 +138,15 @@ Rcpp::List sample_ggm(
 
     // Run MCMC using unified infrastructure
     std::vector<ChainResult> results = run_mcmc_sampler(
-        model, *edge_prior_obj, config, no_chains, no_threads, pm);
+        model, *edge_prior_obj, config, no_chains, no_threads, pm,
+        sampler.warm_start(no_chains));
 
     // Convert to R list format
     Rcpp::List output = convert_results_to_list(results);
+    if (sampler.get("keep_session", false)) {
+        output.attr("session") = make_sampler_session(
+            model, *edge_prior_obj, config, no_threads, results);
+    }
 
     pm.finish();
 
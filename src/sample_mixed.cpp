@@ -11,10 +11,13 @@
 #include "priors/parameter_prior.h"
 #include "utils/progress_manager.h"
 #include "utils/common_helpers.h"
+#include "utils/r_matrix_view.h"
 #include "priors/edge_prior.h"
 #include "mcmc/execution/chain_result.h"
 #include "mcmc/execution/chain_runner.h"
+#include "mcmc/execution/sampler_session.h"
 #include "mcmc/execution/sampler_config.h"
+#include "mcmc/execution/sampler_settings.h"
 
 // R-exported function to sample from a Mixed MRF model.
 //
@@ -42,12 +45,21 @@
 // @param beta_bernoulli_beta_between  SBM between-cluster beta
 // @param dirichlet_alpha         Dirichlet alpha for SBM
 // @param lambda                  Lambda for SBM
-// @param sampler_type            Sampler type string ("adaptive-metropolis" or "nuts")
+// @param sampler_type            Sampler type string ("adaptive-metropolis", "nuts",
+//                                "nuts-iterative" or "adaptive-hmc")
 // @param target_acceptance       Target acceptance rate for gradient-based samplers
 // @param max_tree_depth          Maximum tree depth for NUTS
 // @param na_impute               Whether to impute missing data
 // @param missing_index_discrete  Matrix of missing discrete indices (n_miss x 2, 0-based)
 // @param missing_index_continuous Matrix of missing continuous indices (n_miss x 2, 0-based)
+// @param delta                   Determinant-tilt exponent on |Kyy|
+// @param settings                NULL, or the further sampler settings (see
+//                                apply_sampler_settings()), plus the mixed MRF ones:
+//   delayed_acceptance    Screen discrete pairwise and edge proposals with a surrogate first
+//   pseudo_mle_init       Start from the pseudoposterior mode, with the inverse curvature as mass
+//   keep_session          Attach the chains as attr(, "session") for sampler_session_extend()
+//   block_main_effects    Update each discrete variable's main effects in one joint Metropolis move
+//   edge_update_schedule  Edge-indicator moves: "sequential", or "informed" (edges drawn by learned weights)
 //
 // @return List with per-chain results including samples and diagnostics
 // [[Rcpp::export]]
@@ -76,11 +88,16 @@ Rcpp::List sample_mixed_mrf(
     const bool na_impute = false,
     const Rcpp::Nullable<Rcpp::IntegerMatrix> missing_index_discrete_nullable = R_NilValue,
     const Rcpp::Nullable<Rcpp::IntegerMatrix> missing_index_continuous_nullable = R_NilValue,
-    const double delta = 0.0
+    const double delta = 0.0,
+    const Rcpp::Nullable<Rcpp::List> settings = R_NilValue
 ) {
+    const SamplerSettings sampler(settings);
+    const std::vector<SamplerState> warm_start = sampler.warm_start(no_chains);
+
     // Extract model inputs from R list
-    arma::imat discrete_obs = Rcpp::as<arma::imat>(inputFromR["discrete_observations"]);
-    arma::mat continuous_obs = Rcpp::as<arma::mat>(inputFromR["continuous_observations"]);
+    // The observations are read in place; the model keeps its own copy
+    const arma::imat discrete_obs = integer_matrix_view(inputFromR["discrete_observations"]);
+    const arma::mat continuous_obs = numeric_matrix_view(inputFromR["continuous_observations"]);
     arma::ivec num_categories = Rcpp::as<arma::ivec>(inputFromR["num_categories"]);
     arma::uvec is_ordinal = Rcpp::as<arma::uvec>(inputFromR["is_ordinal_variable"]);
     arma::ivec baseline_cat = Rcpp::as<arma::ivec>(inputFromR["baseline_category"]);
@@ -145,15 +162,31 @@ Rcpp::List sample_mixed_mrf(
     //     between-model MH proposal SDs, which are still 1-D componentwise
     //     RW MH. Hardcode 0.44 there to keep stage-3b RM on the right
     //     fixed point.
-    const double mh_target = (sampler_type == "nuts") ? 0.44 : target_acceptance;
+    const double mh_target =
+      (sampler_type == "nuts" || sampler_type == "nuts-iterative" ||
+       sampler_type == "adaptive-hmc") ? 0.44 : target_acceptance;
     model.set_metropolis_target_accept(mh_target);
 
+    // The gradient samplers multiply with the transposed discrete data;
+    // build it once here so the chain clones share it.
+    if(sampler_type != "adaptive-metropolis") {
+        model.prepare_gradient_data();
+    }
+
     // Determinant-tilt prior on |Kyy|: shifts both NUTS and MH targets by
     // delta * log|Kyy|. delta = 0 is the default (untilted). Consumed by
     // both gradient paths and the continuous-block MH ratios in
     // MixedMRFModel.
     model.set_determinant_tilt_yy(delta);
 
+    // Two-stage discrete pairwise and edge moves (bgms.delayed_acceptance)
+    model.set_delayed_acceptance(sampler.get("delayed_acceptance", false));
+    model.set_block_main_effects(sampler.get("block_main_effects", false));
+
+    // Edge-indicator moves on edges drawn by learned weights (bgms.edge_update_schedule)
+    model.set_informed_edge_updates(
+        sampler.get<std::string>("edge_update_schedule", "sequential") == "informed");
+
     // Set up missing data imputation
     if(na_impute) {
         arma::imat missing_disc, missing_cont;
@@ -168,6 +201,12 @@ Rcpp::List sample_mixed_mrf(
         model.set_missing_data(missing_disc, missing_cont);
     }
 
+    // Start at the pseudoposterior mode (bgms.pseudo_mle_init); a warm
+    // start restores its own state instead
+    if(sampler.get("pseudo_mle_init", false) && warm_start.empty()) {
+        model.initialize_from_pseudo_mle();
+    }
+
     // Create edge prior
     EdgePrior edge_prior_enum = edge_prior_from_string(edge_prior);
     auto edge_prior_obj = create_edge_prior(
@@ -187,16 +226,21 @@ Rcpp::List sample_mixed_mrf(
     config.na_impute = na_impute;
     config.target_acceptance = target_acceptance;
     config.max_tree_depth = max_tree_depth;
+    apply_sampler_settings(config, sampler);
 
     // Set up progress manager
     ProgressManager pm(no_chains, no_iter, no_warmup, 50, progress_type, true, progress_callback);
 
     // Run MCMC using unified infrastructure
     std::vector<ChainResult> results = run_mcmc_sampler(
-        model, *edge_prior_obj, config, no_chains, no_threads, pm);
+        model, *edge_prior_obj, config, no_chains, no_threads, pm, warm_start);
 
     // Convert to R list format
     Rcpp::List output = convert_results_to_list(results);
+    if (sampler.get("keep_session", false)) {
+        output.attr("session") = make_sampler_session(
+            model, *edge_prior_obj, config, no_threads, results);
+    }
 
     pm.finish();
 
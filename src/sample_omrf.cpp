@@ -13,7 +13,73 @@
 #include "priors/parameter_prior.h"
 #include "mcmc/execution/chain_result.h"
 #include "mcmc/execution/chain_runner.h"
+#include "mcmc/execution/sampler_session.h"
 #include "mcmc/execution/sampler_config.h"
+#include "mcmc/execution/sampler_settings.h"
+
+namespace {
+
+// Build an OMRF model from the R input list, with the parameter priors it
+// names.
+OMRFModel omrf_model_from_input(
+    const Rcpp::List& inputFromR,
+    const arma::mat& prior_inclusion_prob,
+    const arma::imat& initial_edge_indicators,
+    const bool edge_selection
+) {
+    double pairwise_scale = Rcpp::as<double>(inputFromR["pairwise_scale"]);
+    std::string ipt_str = inputFromR.containsElementNamed("interaction_prior_type")
+        ? Rcpp::as<std::string>(inputFromR["interaction_prior_type"]) : "cauchy";
+    double ia = inputFromR.containsElementNamed("interaction_alpha")
+        ? Rcpp::as<double>(inputFromR["interaction_alpha"]) : NA_REAL;
+    double ib = inputFromR.containsElementNamed("interaction_beta")
+        ? Rcpp::as<double>(inputFromR["interaction_beta"]) : NA_REAL;
+    auto interaction_prior = create_parameter_prior(ipt_str, pairwise_scale, ia, ib);
+
+    std::string tpt_str = inputFromR.containsElementNamed("threshold_prior_type")
+        ? Rcpp::as<std::string>(inputFromR["threshold_prior_type"]) : "beta-prime";
+    double ta = inputFromR.containsElementNamed("main_alpha")
+        ? Rcpp::as<double>(inputFromR["main_alpha"]) : 0.5;
+    double tb = inputFromR.containsElementNamed("main_beta")
+        ? Rcpp::as<double>(inputFromR["main_beta"]) : 0.5;
+    double ts = inputFromR.containsElementNamed("threshold_scale")
+        ? Rcpp::as<double>(inputFromR["threshold_scale"]) : 1.0;
+    auto threshold_prior = create_parameter_prior(tpt_str, ts, ta, tb);
+
+    return createOMRFModelFromR(
+        inputFromR, prior_inclusion_prob, initial_edge_indicators,
+        std::move(interaction_prior), std::move(threshold_prior),
+        edge_selection);
+}
+
+// Forward target_accept to the model's MH proposal-SD tuner.
+//   - Under "adaptive-metropolis": user's target_accept goes through
+//     directly (default 0.44 = componentwise RW MH optimum).
+//   - Under "nuts": user's target_accept (default 0.80) is the
+//     HMC step-size dual-averaging target and should NOT govern the
+//     between-model MH proposal SDs, which are still 1-D componentwise
+//     RW MH. Hardcode 0.44 there to keep stage-3b RM on the right
+//     fixed point.
+void set_metropolis_target(OMRFModel& model, const std::string& sampler_type,
+                           const double target_acceptance) {
+    const double mh_target =
+      (sampler_type == "nuts" || sampler_type == "nuts-iterative" ||
+       sampler_type == "adaptive-hmc" || sampler_type == "sgld" ||
+       sampler_type == "polya-gamma") ? 0.44 : target_acceptance;
+    model.set_metropolis_target_accept(mh_target);
+}
+
+// Set pairwise scaling factors (if provided)
+void set_scaling_factors(OMRFModel& model,
+                         const Rcpp::Nullable<Rcpp::NumericMatrix>& pairwise_scaling_factors_nullable) {
+    if (pairwise_scaling_factors_nullable.isNotNull()) {
+        arma::mat sf = Rcpp::as<arma::mat>(
+            Rcpp::NumericMatrix(pairwise_scaling_factors_nullable.get()));
+        model.set_pairwise_scaling_factors(sf);
+    }
+}
+
+} // namespace
 
 // R-exported function to sample from an OMRF model
 //
@@ -24,7 +90,8 @@
 // @param no_warmup           Number of warmup iterations
 // @param no_chains           Number of parallel chains
 // @param edge_selection      Whether to do edge selection (spike-and-slab)
-// @param sampler_type        "adaptive-metropolis" or "nuts"
+// @param sampler_type        "adaptive-metropolis", "nuts", "nuts-iterative", "adaptive-hmc",
+//                            "sgld" or "polya-gamma"
 // @param seed                Random seed
 // @param no_threads          Number of threads for parallel execution
 // @param progress_type       Progress bar type
@@ -40,6 +107,17 @@
 // @param lambda              Lambda for SBM
 // @param target_acceptance   Target acceptance rate for NUTS (default: 0.8)
 // @param max_tree_depth      Maximum tree depth for NUTS (default: 10)
+// @param pairwise_scaling_factors_nullable Per-pair prior scaling factors, or NULL
+// @param settings            NULL, or the further sampler settings (see
+//                            apply_sampler_settings()), plus the OMRF ones:
+//   compress_patterns     Collapse duplicate response patterns into weighted rows
+//   edge_update_schedule  Edge-indicator moves: "sequential", "matching" (disjoint pairs in parallel) or "informed" (pairs drawn by learned weights)
+//   subsample             NULL, or the batch_size, refresh_every and step_size of the subsampled pseudolikelihood
+//   delayed_acceptance    Screen pairwise and edge proposals with a surrogate first
+//   pseudo_mle_init       Start from the pseudoposterior mode, with the inverse curvature as mass
+//   keep_session          Attach the chains as attr(, "session") for sampler_session_extend()
+//   gradient_backend      Where the full-data gradient is computed: "cpu" or "gpu"
+//   block_main_effects    Update each variable's main effects in one joint Metropolis move
 //
 // @return List with per-chain results including samples and diagnostics
 // [[Rcpp::export]]
@@ -67,51 +145,16 @@ Rcpp::List sample_omrf(
     const double lambda = 1.0,
     const double target_acceptance = 0.8,
     const int max_tree_depth = 10,
-    const Rcpp::Nullable<Rcpp::NumericMatrix> pairwise_scaling_factors_nullable = R_NilValue
+    const Rcpp::Nullable<Rcpp::NumericMatrix> pairwise_scaling_factors_nullable = R_NilValue,
+    const Rcpp::Nullable<Rcpp::List> settings = R_NilValue
 ) {
-    // Create parameter priors from R input
-    double pairwise_scale = Rcpp::as<double>(inputFromR["pairwise_scale"]);
-    std::string ipt_str = inputFromR.containsElementNamed("interaction_prior_type")
-        ? Rcpp::as<std::string>(inputFromR["interaction_prior_type"]) : "cauchy";
-    double ia = inputFromR.containsElementNamed("interaction_alpha")
-        ? Rcpp::as<double>(inputFromR["interaction_alpha"]) : NA_REAL;
-    double ib = inputFromR.containsElementNamed("interaction_beta")
-        ? Rcpp::as<double>(inputFromR["interaction_beta"]) : NA_REAL;
-    auto interaction_prior = create_parameter_prior(ipt_str, pairwise_scale, ia, ib);
+    const SamplerSettings sampler(settings);
+    const std::vector<SamplerState> warm_start = sampler.warm_start(no_chains);
 
-    std::string tpt_str = inputFromR.containsElementNamed("threshold_prior_type")
-        ? Rcpp::as<std::string>(inputFromR["threshold_prior_type"]) : "beta-prime";
-    double ta = inputFromR.containsElementNamed("main_alpha")
-        ? Rcpp::as<double>(inputFromR["main_alpha"]) : 0.5;
-    double tb = inputFromR.containsElementNamed("main_beta")
-        ? Rcpp::as<double>(inputFromR["main_beta"]) : 0.5;
-    double ts = inputFromR.containsElementNamed("threshold_scale")
-        ? Rcpp::as<double>(inputFromR["threshold_scale"]) : 1.0;
-    auto threshold_prior = create_parameter_prior(tpt_str, ts, ta, tb);
-
-    // Create model from R input
-    OMRFModel model = createOMRFModelFromR(
-        inputFromR, prior_inclusion_prob, initial_edge_indicators,
-        std::move(interaction_prior), std::move(threshold_prior),
-        edge_selection);
-
-    // Forward target_accept to the model's MH proposal-SD tuner.
-    //   - Under "adaptive-metropolis": user's target_accept goes through
-    //     directly (default 0.44 = componentwise RW MH optimum).
-    //   - Under "nuts": user's target_accept (default 0.80) is the
-    //     HMC step-size dual-averaging target and should NOT govern the
-    //     between-model MH proposal SDs, which are still 1-D componentwise
-    //     RW MH. Hardcode 0.44 there to keep stage-3b RM on the right
-    //     fixed point.
-    const double mh_target = (sampler_type == "nuts") ? 0.44 : target_acceptance;
-    model.set_metropolis_target_accept(mh_target);
-
-    // Set pairwise scaling factors (if provided)
-    if (pairwise_scaling_factors_nullable.isNotNull()) {
-        arma::mat sf = Rcpp::as<arma::mat>(
-            Rcpp::NumericMatrix(pairwise_scaling_factors_nullable.get()));
-        model.set_pairwise_scaling_factors(sf);
-    }
+    OMRFModel model = omrf_model_from_input(
+        inputFromR, prior_inclusion_prob, initial_edge_indicators, edge_selection);
+    set_metropolis_target(model, sampler_type, target_acceptance);
+    set_scaling_factors(model, pairwise_scaling_factors_nullable);
 
     // Set up missing data imputation
     if (na_impute && missing_index_nullable.isNotNull()) {
@@ -120,6 +163,34 @@ Rcpp::List sample_omrf(
         model.set_missing_data(missing_index);
     }
 
+    // Compress after the missing-data rows are known so they stay separate
+    if (sampler.get("compress_patterns", false)) {
+        model.compress_patterns();
+    }
+
+    const std::string edge_update_schedule =
+        sampler.get<std::string>("edge_update_schedule", "sequential");
+    model.set_matching_edge_updates(edge_update_schedule == "matching");
+    model.set_informed_edge_updates(edge_update_schedule == "informed");
+
+    // Two-stage pairwise and edge moves (bgms.delayed_acceptance)
+    model.set_delayed_acceptance(sampler.get("delayed_acceptance", false));
+    model.set_block_main_effects(sampler.get("block_main_effects", false));
+
+    // Start at the pseudoposterior mode (bgms.pseudo_mle_init); a warm
+    // start restores its own state instead
+    if (sampler.get("pseudo_mle_init", false) && warm_start.empty()) {
+        model.initialize_from_pseudo_mle();
+    }
+
+    // Estimate the pseudolikelihood from row batches (see set_subsampling())
+    if (sampler.has("subsample")) {
+        Rcpp::List subsample(sampler.list("subsample").get());
+        model.set_subsampling(Rcpp::as<int>(subsample["batch_size"]),
+                              Rcpp::as<int>(subsample["refresh_every"]));
+    }
+    model.set_gradient_backend(sampler.get<std::string>("gradient_backend", "cpu"));
+
     // Create edge prior
     EdgePrior edge_prior_enum = edge_prior_from_string(edge_prior);
     auto edge_prior_obj = create_edge_prior(
@@ -139,16 +210,154 @@ Rcpp::List sample_omrf(
     config.target_acceptance = target_acceptance;
     config.max_tree_depth = max_tree_depth;
     config.na_impute = na_impute;
+    apply_sampler_settings(config, sampler);
 
     // Set up progress manager
     ProgressManager pm(no_chains, no_iter, no_warmup, 50, progress_type, true, progress_callback);
 
     // Run MCMC using unified infrastructure
     std::vector<ChainResult> results = run_mcmc_sampler(
-        model, *edge_prior_obj, config, no_chains, no_threads, pm);
+        model, *edge_prior_obj, config, no_chains, no_threads, pm, warm_start);
 
     // Convert to R list format
     Rcpp::List output = convert_results_to_list(results);
+    if (sampler.get("keep_session", false)) {
+        output.attr("session") = make_sampler_session(
+            model, *edge_prior_obj, config, no_threads, results);
+    }
+
+    pm.finish();
+
+    return output;
+}
+
+
+// Whether this build contains the CUDA gradient backend (see
+// OMRFModel::set_gradient_backend())
+// [[Rcpp::export]]
+bool omrf_gpu_backend_available() {
+    return omrf_gpu_backend_compiled();
+}
+
+
+// R-exported function to fit one OMRF spec to many datasets
+//
+// Runs every (dataset, chain) pair as one task on a shared thread pool
+// (see run_mcmc_batch()) and returns the running summaries only. Chain c of
+// dataset d matches chain c of a sample_omrf() run with seed seeds[d].
+//
+// @param inputs              One list per dataset: the inputFromR list of
+//                            sample_omrf(), plus `inclusion_probability` and
+//                            optionally `pairwise_scaling_factors`
+// @param seeds               Random seed of each dataset
+// @param settings            Settings as for sample_omrf(); the batch runner
+//                            reads threads_per_chain, nuts_metric,
+//                            online_summary ("moments" or "coinclusion"),
+//                            compress_patterns and edge_update_schedule
+// (other arguments as for sample_omrf())
+//
+// @return List with one element per dataset, each a list of chains with
+//         chain_id, error, error_msg, userInterrupt and online_summary
+// [[Rcpp::export]]
+Rcpp::List sample_omrf_batch(
+    const Rcpp::List& inputs,
+    const Rcpp::IntegerVector& seeds,
+    const int no_iter,
+    const int no_warmup,
+    const int no_chains,
+    const bool edge_selection,
+    const std::string& sampler_type,
+    const int no_threads,
+    const int progress_type,
+    SEXP progress_callback = R_NilValue,
+    const std::string& edge_prior = "Bernoulli",
+    const double beta_bernoulli_alpha = 1.0,
+    const double beta_bernoulli_beta = 1.0,
+    const double beta_bernoulli_alpha_between = 1.0,
+    const double beta_bernoulli_beta_between = 1.0,
+    const double dirichlet_alpha = 1.0,
+    const double lambda = 1.0,
+    const double target_acceptance = 0.8,
+    const int max_tree_depth = 10,
+    const Rcpp::Nullable<Rcpp::List> settings = R_NilValue
+) {
+    const SamplerSettings sampler(settings);
+    const bool compress_patterns = sampler.get("compress_patterns", false);
+    const std::string edge_update_schedule =
+        sampler.get<std::string>("edge_update_schedule", "sequential");
+    const int num_datasets = inputs.size();
+    if (seeds.size() != num_datasets) {
+        Rcpp::stop("sample_omrf_batch: one seed per dataset is needed");
+    }
+
+    std::vector<std::unique_ptr<BaseModel>> models;
+    std::vector<int> seed_vec(num_datasets);
+    models.reserve(num_datasets);
+    for (int d = 0; d < num_datasets; ++d) {
+        const Rcpp::List input = inputs[d];
+        const arma::mat prior_inclusion_prob =
+            Rcpp::as<arma::mat>(input["inclusion_probability"]);
+        const arma::imat initial_edge_indicators(
+            prior_inclusion_prob.n_rows, prior_inclusion_prob.n_cols, arma::fill::ones);
+
+        auto model = std::make_unique<OMRFModel>(omrf_model_from_input(
+            input, prior_inclusion_prob, initial_edge_indicators, edge_selection));
+        set_metropolis_target(*model, sampler_type, target_acceptance);
+        if (input.containsElementNamed("pairwise_scaling_factors")) {
+            SEXP scaling_factors = input["pairwise_scaling_factors"];
+            set_scaling_factors(*model, Rcpp::Nullable<Rcpp::NumericMatrix>(scaling_factors));
+        }
+        if (compress_patterns) {
+            model->compress_patterns();
+        }
+        model->set_matching_edge_updates(edge_update_schedule == "matching");
+        model->set_informed_edge_updates(edge_update_schedule == "informed");
+        models.push_back(std::move(model));
+        seed_vec[d] = seeds[d];
+    }
+
+    auto edge_prior_obj = create_edge_prior(
+        edge_prior_from_string(edge_prior),
+        beta_bernoulli_alpha, beta_bernoulli_beta,
+        beta_bernoulli_alpha_between, beta_bernoulli_beta_between,
+        dirichlet_alpha, lambda
+    );
+
+    SamplerConfig config;
+    config.sampler_type = sampler_type;
+    config.no_iter = no_iter;
+    config.no_warmup = no_warmup;
+    config.edge_selection = edge_selection;
+    config.target_acceptance = target_acceptance;
+    config.max_tree_depth = max_tree_depth;
+    config.online_summary = "moments";
+    apply_sampler_settings(config, sampler);
+
+    // One progress counter per task
+    const int tasks = num_datasets * no_chains;
+    ProgressManager pm(tasks, no_iter, no_warmup, 50, progress_type, true, progress_callback);
+
+    std::vector<ChainResult> results = run_mcmc_batch(
+        models, *edge_prior_obj, config, seed_vec, no_chains, no_threads, pm);
+
+    Rcpp::List output(num_datasets);
+    for (int d = 0; d < num_datasets; ++d) {
+        Rcpp::List chains(no_chains);
+        for (int c = 0; c < no_chains; ++c) {
+            const ChainResult& chain = results[d * no_chains + c];
+            Rcpp::List chain_list;
+            chain_list["chain_id"] = c + 1;
+            chain_list["error"] = chain.error;
+            if (chain.error) {
+                chain_list["error_msg"] = chain.error_msg;
+            } else {
+                chain_list["userInterrupt"] = chain.userInterrupt;
+                chain_list["online_summary"] = chain.online_summary.to_list();
+            }
+            chains[c] = chain_list;
+        }
+        output[d] = chains;
+    }
 
     pm.finish();
 
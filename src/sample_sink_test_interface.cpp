@@ -0,0 +1,42 @@
+// sample_sink_test_interface.cpp - test-only interface
+//
+// Writes a matrix through ChunkedFileSink so tests/testthat can check that
+// read_sample_file() recovers it for any buffer size.
+#include <RcppArmadillo.h>
+#include <string>
+
+#include "mcmc/execution/sample_sink.h"
+
+// Streams the columns of `draws` to `path`, as doubles or (with
+// `as_integer`) as the indicator element type, holding at most
+// `buffer_bytes` of them in memory.
+//
+// @return Number of draws buffered between writes.
+//
+// [[Rcpp::export]]
+int test_chunked_file_sink(
+    const std::string& path,
+    const arma::mat& draws,
+    const double buffer_bytes,
+    const bool as_integer = false
+) {
+    const size_t bytes = static_cast<size_t>(buffer_bytes);
+    size_t buffered = 0;
+    if (as_integer) {
+        ChunkedFileSink<arma::sword> sink(path, draws.n_rows, bytes);
+        const arma::imat values = arma::conv_to<arma::imat>::from(draws);
+        for (arma::uword c = 0; c < values.n_cols; ++c) {
+            sink.write(values.col(c));
+        }
+        sink.finish();
+        buffered = sink.buffer_columns();
+    } else {
+        ChunkedFileSink<double> sink(path, draws.n_rows, bytes);
+        for (arma::uword c = 0; c < draws.n_cols; ++c) {
+            sink.write(draws.col(c));
+        }
+        sink.finish();
+        buffered = sink.buffer_columns();
+    }
+    return static_cast<int>(buffered);
+}
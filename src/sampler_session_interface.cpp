@@ -0,0 +1,71 @@
+#include <RcppArmadillo.h>
+
+#include "utils/progress_manager.h"
+#include "mcmc/execution/chain_result.h"
+#include "mcmc/execution/chain_runner.h"
+#include "mcmc/execution/sampler_session.h"
+
+
+static SamplerSession& session_from_sexp(SEXP session) {
+    Rcpp::XPtr<SamplerSession> chains(session);
+    if (chains.get() == nullptr) {
+        Rcpp::stop("The sampler session is no longer available.");
+    }
+    return *chains;
+}
+
+
+// Run the chains of a kept sampler session for more draws.
+//
+// @param session            External pointer from a sampler entry point
+//                           called with keep_session = TRUE
+// @param no_iter            Post-warmup iterations per chain
+// @param no_warmup          Warmup iterations before them (0 keeps the tuning)
+// @param progress_type      Progress bar style (0 = none, 1 = total, 2 = per-chain)
+// @param progress_callback  R function called as callback(completed, total), or NULL
+//
+// @return List with per-chain results of the new draws, in the
+//   convert_results_to_list() format
+// [[Rcpp::export]]
+Rcpp::List sampler_session_extend(
+    SEXP session,
+    const int no_iter,
+    const int no_warmup,
+    const int progress_type,
+    SEXP progress_callback = R_NilValue
+) {
+    SamplerSession& chains = session_from_sexp(session);
+
+    ProgressManager pm(chains.num_chains(), no_iter, no_warmup, 50, progress_type, true, progress_callback);
+    std::vector<ChainResult> results = chains.extend(no_iter, no_warmup, pm);
+    Rcpp::List output = convert_results_to_list(results);
+
+    pm.finish();
+
+    return output;
+}
+
+
+// Change the data of a kept sampler session: drop rows, then add rows.
+//
+// @param session  External pointer from a sampler entry point called with
+//                 keep_session = TRUE
+// @param remove   1-based rows to drop, or NULL
+// @param append   Integer matrix of rows to add (coded as the model's
+//                 data), or NULL
+// [[Rcpp::export]]
+void sampler_session_update_data(
+    SEXP session,
+    const Rcpp::Nullable<Rcpp::IntegerVector> remove = R_NilValue,
+    const Rcpp::Nullable<Rcpp::IntegerMatrix> append = R_NilValue
+) {
+    SamplerSession& chains = session_from_sexp(session);
+
+    if (remove.isNotNull()) {
+        arma::uvec rows = Rcpp::as<arma::uvec>(remove.get());
+        chains.remove_observations(rows - 1);
+    }
+    if (append.isNotNull()) {
+        chains.append_observations(Rcpp::as<arma::imat>(append.get()));
+    }
+}
@@ -0,0 +1,64 @@
+// score_file_interface.cpp - Rcpp interface for score files
+//
+// Writing and summarising the memory-mappable score files that bgm() can
+// read observations from (see MappedScoreFile in math/score_file.h).
+#include <RcppArmadillo.h>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include "math/score_file.h"
+
+
+// Write integer scores (all in [0, 127]) to a score file.
+//
+// @param path    File to create (overwritten if it exists)
+// @param scores  Integer matrix (observations x variables)
+//
+// [[Rcpp::export]]
+void write_score_file_cpp(const std::string& path, const Rcpp::IntegerMatrix& scores) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        Rcpp::stop("Cannot open score file for writing: " + path);
+    }
+    char header[MappedScoreFile::header_bytes] = {};
+    const std::int32_t type_code = MappedScoreFile::uint8_type;
+    const std::int64_t n_rows = scores.nrow();
+    const std::int64_t n_cols = scores.ncol();
+    std::memcpy(header, MappedScoreFile::magic, sizeof(MappedScoreFile::magic));
+    std::memcpy(header + 8, &type_code, sizeof(type_code));
+    std::memcpy(header + 16, &n_rows, sizeof(n_rows));
+    std::memcpy(header + 24, &n_cols, sizeof(n_cols));
+    out.write(header, MappedScoreFile::header_bytes);
+
+    // One column at a time, in the column-major order of the file
+    std::string column(static_cast<std::size_t>(n_rows), '\0');
+    for (int j = 0; j < scores.ncol(); ++j) {
+        for (int i = 0; i < scores.nrow(); ++i) {
+            column[i] = static_cast<char>(static_cast<unsigned char>(scores(i, j)));
+        }
+        out.write(column.data(), static_cast<std::streamsize>(column.size()));
+    }
+    out.close();
+    if (out.fail()) {
+        Rcpp::stop("Error writing score file: " + path);
+    }
+}
+
+
+// Dimensions and per-variable score counts of a score file, from one pass
+// over the mapped file.
+//
+// @return List with num_cases, num_variables and counts (128 x variables)
+//
+// [[Rcpp::export]]
+Rcpp::List score_file_summary(const std::string& path) {
+    const MappedScoreFile file(path);
+    const arma::umat counts = file.score_counts();
+    return Rcpp::List::create(
+        Rcpp::Named("num_cases") = static_cast<double>(file.n_rows()),
+        Rcpp::Named("num_variables") = static_cast<int>(file.n_cols()),
+        Rcpp::Named("counts") = arma::conv_to<arma::mat>::from(counts)
+    );
+}
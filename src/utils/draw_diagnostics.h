@@ -0,0 +1,60 @@
+#pragma once
+
+#include <Rcpp.h>
+#include <cstddef>
+#include <vector>
+
+
+// ============================================================================
+//   Per-parameter ESS and Rhat kernels on a view of the draws
+// ============================================================================
+//
+// The kernels behind .compute_ess_cpp() and .compute_rhat_cpp() in
+// mcmc_diagnostics.cpp, for one parameter at a time and without R objects,
+// so that the chain runner's ConvergenceMonitor can evaluate the chains'
+// sample buffers while they are being filled. Both return NA_REAL where the
+// R functions report NA.
+// ============================================================================
+
+
+// --- Draws layout ------------------------------------------------------------
+//
+// Draw (iteration i, chain c, parameter j) is at
+//   chain[c][i * iter_stride + j * param_stride].
+// This covers the [niter x nchains x nparam] array built by combine_chains()
+// as well as a list of per-chain matrices, in either iter x param or the
+// samplers' native param x iter orientation, without copying them.
+
+struct DrawsView {
+  std::vector<const double*> chain;
+  int niter = 0;
+  int nparam = 0;
+  std::ptrdiff_t iter_stride = 1;
+  std::ptrdiff_t param_stride = 0;
+
+  int nchains() const { return static_cast<int>(chain.size()); }
+
+  // Pointer to the niter draws of (c, j), copied into `buf` unless they
+  // are already contiguous.
+  const double* column(int c, int j, std::vector<double>& buf) const {
+    const double* x = chain[c] + j * param_stride;
+    if(iter_stride == 1) return x;
+    buf.resize(niter);
+    for(int i = 0; i < niter; i++) buf[i] = x[i * iter_stride];
+    return buf.data();
+  }
+};
+
+
+// AR order limit of the ESS estimate for niter draws per chain:
+// min(niter - 1, floor(10 * log10(niter))), as in coda.
+int ess_max_order(int niter);
+
+// ESS of parameter j, summed over the chains. `buf` and `centered` are
+// scratch space.
+double draws_ess(const DrawsView& draws, int j, int max_order,
+                 std::vector<double>& buf, std::vector<double>& centered);
+
+// Gelman-Rubin Rhat of parameter j (needs two or more chains). `buf` is
+// scratch space.
+double draws_rhat(const DrawsView& draws, int j, std::vector<double>& buf);
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <RcppArmadillo.h>
+#include <RcppParallel.h>
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include "utils/task_arena.h"
+
+
+// Reproducible reductions
+//
+// The within-chain kernels (OMRF gradient and edge matchings, bgmCompare
+// tiles) give bit-identical results for any number of threads: every
+// parallel task writes to slots of its own on a grid that only depends on
+// the problem size, and the slots are reduced afterwards in a fixed order,
+// serially for per-parameter sums and by tree_sum() for long scalar sums.
+// No sum is ever formed in the order tasks finish.
+
+
+/**
+ * Split the index range [0, n) into `num_blocks` contiguous blocks and
+ * return the half-open range [begin, end) of block `block`.
+ *
+ * Blocks differ in size by at most one element. The partition only
+ * depends on (n, num_blocks), never on which thread runs the block, so
+ * per-block results can be reduced in a fixed order.
+ */
+inline void block_range(int n, int num_blocks, int block, int& begin, int& end) {
+  begin = static_cast<int>((static_cast<long long>(n) * block) / num_blocks);
+  end   = static_cast<int>((static_cast<long long>(n) * (block + 1)) / num_blocks);
+}
+
+
+/// Ranges of at most this many terms are summed left to right by tree_sum().
+constexpr std::size_t kTreeSumLeaf = 8;
+
+
+/**
+ * Sum of values[0], ..., values[n - 1] by a pairwise tree of fixed shape:
+ * a range of more than kTreeSumLeaf terms is split at its midpoint, and
+ * the halves are summed recursively. The shape only depends on n, so the
+ * sum of per-slot partials is the same however the slots were filled. The
+ * rounding error grows with log(n) rather than n.
+ */
+inline double tree_sum(const double* values, std::size_t n) {
+  if(n <= kTreeSumLeaf) {
+    double sum = 0.0;
+    for(std::size_t i = 0; i < n; ++i) sum += values[i];
+    return sum;
+  }
+  const std::size_t half = n / 2;
+  return tree_sum(values, half) + tree_sum(values + half, n - half);
+}
+
+
+/**
+ * RcppParallel worker that runs body(block) for every block in its range.
+ */
+struct BlockWorker : public RcppParallel::Worker {
+  const std::function<void(int)>& body;
+
+  explicit BlockWorker(const std::function<void(int)>& body) : body(body) {}
+
+  void operator()(std::size_t begin, std::size_t end) {
+    for(std::size_t b = begin; b < end; ++b) {
+      body(static_cast<int>(b));
+    }
+  }
+};
+
+
+/**
+ * Run body(0), ..., body(num_blocks - 1), in parallel when num_blocks > 1.
+ *
+ * Each block is scheduled as its own task (grain size 1). When called from
+ * inside a chain-level task the blocks go to the chain runner's arena (see
+ * run_in_arena()), so chains and their kernels share one thread budget.
+ * The body must only write to block-private memory; callers reduce block
+ * results serially afterwards.
+ *
+ * @param num_blocks  Number of independent blocks
+ * @param body        Callable taking the block index
+ */
+inline void parallel_for_blocks(int num_blocks, const std::function<void(int)>& body) {
+  if(num_blocks <= 1) {
+    if(num_blocks == 1) body(0);
+    return;
+  }
+  BlockWorker worker(body);
+  parallel_for_tasks(static_cast<std::size_t>(num_blocks), worker, 1);
+}
@@ -1,13 +1,15 @@
+// RcppArmadillo (through the telemetry) must come before Rcpp.h
+#include "mcmc/execution/telemetry.h"
 #include "utils/progress_manager.h"
 
 ProgressManager::ProgressManager(int nChains_, int nIter_, int nWarmup_, int printEvery_, int progress_type_, bool useUnicode_, SEXP progress_callback)
   : nChains(nChains_), nIter(nIter_ + nWarmup_), nWarmup(nWarmup_), printEvery(printEvery_),
-    progress_type(progress_type_), useUnicode(useUnicode_), progress(nChains_), callback(progress_callback) {
+    progress_type(progress_type_), useUnicode(useUnicode_), progress(nChains_), callback(progress_callback),
+    mainThread(std::this_thread::get_id()) {
 
   // When a callback is provided, suppress the built-in progress display
   if (callback.isNotNull()) progress_type = 0;
 
-  for (size_t i = 0; i < nChains; i++) progress[i] = 0;
   start = Clock::now();
   lastPrint = Clock::now();
 
@@ -54,48 +56,62 @@ ProgressManager::ProgressManager(int nChains_, int nIter_, int nWarmup_, int pri
 }
 
 void ProgressManager::update(size_t chainId) {
-  progress[chainId]++;
+  const size_t count = progress[chainId].value.fetch_add(1, std::memory_order_relaxed) + 1;
 
-  // Only chain 0 actually does the printing/ checking for user interrupts
-  if (chainId != 0 || needsToExit) return;
+  // Worker threads only count; the main thread reports when it runs a chain
+  if (count % printEvery != 0 || std::this_thread::get_id() != mainThread) return;
+  poll();
+}
+
+void ProgressManager::skip(size_t chainId, size_t n) {
+  progress[chainId].value.fetch_add(n, std::memory_order_relaxed);
+}
 
-  if (progress[chainId] % printEvery == 0) {
+ProgressManager::~ProgressManager() = default;
 
-    // Check for user interrupts
-    needsToExit = checkInterrupt();
+void ProgressManager::start_telemetry(const TelemetrySchedule& schedule) {
+  telemetry_ = std::make_unique<TelemetryWriter>(schedule, static_cast<int>(nChains));
+}
 
-    if (needsToExit && progress_type != 0) {
+void ProgressManager::poll() {
+  if (telemetry_) telemetry_->flush();
+  if (needsToExit.load(std::memory_order_relaxed)) return;
+
+  // Check for user interrupts
+  if (checkInterrupt()) {
+    needsToExit.store(true, std::memory_order_relaxed);
+    if (progress_type != 0) {
       // This should be immediately-ish visible to the user
       Rcpp::Rcout << "\nUser interrupt detected. Exiting gracefully. It may take a few seconds before all chains are terminated.\n";
-      return;
     }
+    return;
+  }
 
-    auto now = Clock::now();
-    std::chrono::duration<double> sinceLast = now - lastPrint;
+  auto now = Clock::now();
+  std::chrono::duration<double> sinceLast = now - lastPrint;
 
-    bool has_output = (progress_type != 0) || callback.isNotNull();
+  bool has_output = (progress_type != 0) || callback.isNotNull();
 
-    // Throttle printing to avoid spamming
-    if (has_output && sinceLast.count() >= 0.5) {
-      if (progress_type != 0) {
-        print();
-      }
-      if (callback.isNotNull()) {
-        size_t done = std::reduce(progress.begin(), progress.end());
-        size_t totalWork = nChains * nIter;
-        Rcpp::Function(callback.get())(done, totalWork);
-      }
-      lastPrint = now;
+  // Throttle printing to avoid spamming
+  if (has_output && sinceLast.count() >= 0.5) {
+    if (progress_type != 0) {
+      print();
     }
+    if (callback.isNotNull()) {
+      size_t done = totalProgress();
+      size_t totalWork = nChains * nIter;
+      Rcpp::Function(callback.get())(done, totalWork);
+    }
+    lastPrint = now;
   }
-
 }
 
 void ProgressManager::finish() {
+  if (telemetry_) telemetry_->flush();
 
   if (progress_type == 0 && callback.isNull()) return;
 
-  if (needsToExit) {
+  if (shouldExit()) {
     if (progress_type != 0)
       Rcpp::Rcout << "All chains terminated.\n";
     return;
@@ -103,7 +119,7 @@ void ProgressManager::finish() {
 
   // Mark all chains as complete and print one final time
   for (size_t i = 0; i < nChains; i++)
-    progress[i] = nIter;
+    progress[i].value.store(nIter, std::memory_order_relaxed);
 
   if (progress_type != 0)
     print();
@@ -115,7 +131,7 @@ void ProgressManager::finish() {
 }
 
 bool ProgressManager::shouldExit() const {
-  return needsToExit;
+  return needsToExit.load(std::memory_order_relaxed);
 }
 
 void ProgressManager::checkConsoleWidthChange() {
@@ -283,13 +299,11 @@ void ProgressManager::setupTheme() {
 }
 
 void ProgressManager::print() {
-  std::lock_guard<std::mutex> lock(printMutex);
-
   auto now = Clock::now();
   double elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - start).count();
 
   size_t totalWork = nChains * nIter;
-  size_t done = std::reduce(progress.begin(), progress.end());
+  size_t done = totalProgress();
   double fracTotal = double(done) / totalWork;
   // should actually be the eta of the slowest chain!
   double eta = (fracTotal > 0) ? elapsed / fracTotal - elapsed : 0.0;
@@ -315,8 +329,9 @@ void ProgressManager::print() {
 
     // Print progress for each chain
     for (size_t i = 0; i < nChains; i++) {
-      double frac = double(progress[i]) / nIter;
-      std::string chainProgress = formatProgressBar(i + 1, progress[i], nIter, frac);
+      const size_t current = progressOf(i);
+      double frac = double(current) / nIter;
+      std::string chainProgress = formatProgressBar(i + 1, current, nIter, frac);
       out << chainProgress << "\n";
       // totalChars += chainProgress.length() + 1; // +1 for newline
     }
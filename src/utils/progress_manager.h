@@ -3,15 +3,20 @@
 
 #include <Rcpp.h>
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <exception>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
-#include <mutex>
 #include <string>
 #include <thread>
 #include <vector>
 #include <numeric>
+#include <memory>
+
+struct TelemetrySchedule;
+class TelemetryWriter;
 
 using Clock = std::chrono::steady_clock;
 
@@ -34,27 +39,98 @@ inline bool checkInterrupt() {
  * progress indicators and proper cursor positioning.
  *
  * Key features:
- * - Multi-chain progress tracking with atomic operations
+ * - Multi-chain progress tracking with one cache-line-padded atomic
+ *   counter per chain
  * - RStudio vs terminal environment detection and adaptation
  * - Unicode and classic theming options
  * - ANSI color support with proper visual length calculations
- * - Thread-safe printing with mutex protection
  * - Console width adaptation and change detection
  * - User interrupt checking
  * - Optional R callback for external progress reporting (e.g., JASP),
  *   invoked as callback(completed, total)
+ *
+ * Only the thread that constructed the manager (the R main thread) ever
+ * calls into R: it checks for interrupts, prints and runs the callback.
+ * update() from any other thread just bumps that chain's counter. Parallel
+ * work runs through run_with_reporter(), which moves the work to a helper
+ * thread and keeps the main thread polling the counters; a user interrupt
+ * is signalled to the workers through the atomic flag read by
+ * shouldExit(). When the chains run on the main thread itself, update()
+ * polls every printEvery iterations of whichever chain is running.
+ *
+ * With telemetry started (start_telemetry()), every poll also writes the
+ * records the chains have queued to the telemetry file.
  */
 class ProgressManager {
 
 public:
 
     ProgressManager(int nChains_, int nIter_, int nWarmup_, int printEvery_ = 10, int progress_type = 2, bool useUnicode_ = true, SEXP progress_callback = R_NilValue);
+    ~ProgressManager();
     void update(size_t chainId);
+    /// Count `n` iterations of a chain as done without running them.
+    void skip(size_t chainId, size_t n);
     void finish();
     bool shouldExit() const;
 
+    /**
+     * Open the telemetry file of `schedule`, with one queue per chain.
+     * Must be called from the thread that constructed the manager.
+     * @throws std::runtime_error if the file cannot be opened
+     */
+    void start_telemetry(const TelemetrySchedule& schedule);
+    /** @return The run's telemetry writer, or null when it has none. */
+    TelemetryWriter* telemetry() const { return telemetry_.get(); }
+
+    /**
+     * Run `work` on a helper thread while this thread reports progress
+     *
+     * Must be called from the thread that constructed the manager. The
+     * calling thread polls the chain counters every pollInterval until
+     * `work` returns; an exception thrown by `work` is rethrown here.
+     */
+    template <typename Work>
+    void run_with_reporter(Work&& work) {
+        std::atomic<bool> done{false};
+        std::exception_ptr error;
+        std::thread worker([&] {
+            try {
+                work();
+            } catch (...) {
+                error = std::current_exception();
+            }
+            done.store(true, std::memory_order_release);
+        });
+        while (!done.load(std::memory_order_acquire)) {
+            std::this_thread::sleep_for(pollInterval);
+            poll();
+        }
+        worker.join();
+        if (error) std::rethrow_exception(error);
+    }
+
 private:
 
+    /// Interval between two polls of the main-thread reporter.
+    static constexpr std::chrono::milliseconds pollInterval{50};
+
+    /// Per-chain iteration counter, on its own cache line.
+    struct alignas(64) ChainCounter {
+        std::atomic<size_t> value{0};
+    };
+
+    /// Check for interrupts, then print and call back if due. Main thread only.
+    void poll();
+
+    size_t progressOf(size_t chainId) const {
+        return progress[chainId].value.load(std::memory_order_relaxed);
+    }
+    size_t totalProgress() const {
+        size_t done = 0;
+        for (size_t i = 0; i < nChains; i++) done += progressOf(i);
+        return done;
+    }
+
     void checkConsoleWidthChange();
     size_t getConsoleWidth() const;
     std::string formatProgressBar(size_t chainId, size_t current, size_t total, double fraction, bool isTotal = false) const;
@@ -63,13 +139,13 @@ private:
     void setupTheme();
 
     bool isWarmupPhase() const {
-        for (auto c : progress)
-            if (c < nWarmup)
+        for (size_t i = 0; i < nChains; i++)
+            if (progressOf(i) < nWarmup)
                 return true;
         return false;
     }
     bool isWarmupPhase(const size_t chain_id) const {
-      return progress[chain_id] < nWarmup;
+      return progressOf(chain_id) < nWarmup;
     }
 
     void print();
@@ -85,7 +161,7 @@ private:
     size_t printEvery;                 // Print frequency
     size_t progress_type = 2;          // Progress bar style type (0 = "none", 1 = "total", 2 = "per-chain")
     bool useUnicode = true;            // Use Unicode vs ASCII theme
-    std::vector<size_t> progress;      // Per-chain progress counters
+    std::vector<ChainCounter> progress; // Per-chain progress counters
 
     // internal config parameters/ data
     size_t no_spaces_for_total;     // Spacing for total line alignment
@@ -97,7 +173,7 @@ private:
 
     // Environment and state flags
     bool isRStudio = false;         ///< Whether running in RStudio console
-    bool needsToExit = false;       ///< User interrupt flag
+    std::atomic<bool> needsToExit{false}; ///< User interrupt flag, read by the workers
     bool widthChanged = false;      ///< Console width changed flag
 
     // Visual configuration
@@ -118,11 +194,14 @@ private:
     Clock::time_point start;                   // Start time
     std::chrono::time_point<Clock> lastPrint;  // Last print time
 
-    // Thread synchronization
-    std::mutex printMutex;          // Mutex for thread-safe printing
+    // Thread that may call into R (the constructing thread)
+    std::thread::id mainThread;
 
     // R callback (called as callback(completed, total) at throttled intervals)
     Rcpp::Nullable<Rcpp::Function> callback;
+
+    // Live telemetry, flushed by poll() (null when off)
+    std::unique_ptr<TelemetryWriter> telemetry_;
 };
 
 #endif // PROGRESS_MANAGER_H
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+/**
+ * @file r_matrix_view.h
+ * @brief Armadillo matrices over the memory of R matrices, without a copy.
+ *
+ * Rcpp::as<arma::mat>() copies its argument. The model factories only read
+ * the observations they are given, so they take a non-owning, strict view
+ * of R's memory instead when the storage type matches, and a converting
+ * copy otherwise (e.g. a double matrix of integer scores). A view is valid
+ * as long as the R object is protected, which covers the whole .Call();
+ * being strict, it is never resized away from that memory.
+ */
+
+#include <RcppArmadillo.h>
+#include <type_traits>
+
+namespace r_matrix_view_detail {
+
+template <typename eT>
+arma::Mat<eT> view_or_copy(SEXP x) {
+    if (Rf_isMatrix(x)) {
+        if constexpr (std::is_same_v<eT, double>) {
+            if (TYPEOF(x) == REALSXP) {
+                return arma::Mat<eT>(REAL(x), Rf_nrows(x), Rf_ncols(x), false, true);
+            }
+        } else if constexpr (std::is_same_v<eT, int>) {
+            if (TYPEOF(x) == INTSXP) {
+                return arma::Mat<eT>(INTEGER(x), Rf_nrows(x), Rf_ncols(x), false, true);
+            }
+        }
+    }
+    return Rcpp::as<arma::Mat<eT>>(x);
+}
+
+} // namespace r_matrix_view_detail
+
+
+/// Numeric matrix over R's memory (a copy unless `x` is a double matrix).
+inline arma::mat numeric_matrix_view(SEXP x) {
+    return r_matrix_view_detail::view_or_copy<double>(x);
+}
+
+/// Integer matrix over R's memory (a copy unless `x` is an integer matrix
+/// and Armadillo uses 32-bit integers, as under RcppArmadillo).
+inline arma::imat integer_matrix_view(SEXP x) {
+    return r_matrix_view_detail::view_or_copy<arma::sword>(x);
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+/**
+ * @file scratch_arena.h
+ * @brief Per-chain bump allocator for the short-lived temporaries of a model.
+ */
+
+#include <RcppArmadillo.h>
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+
+/**
+ * ScratchArena - per-chain monotonic memory for Armadillo temporaries
+ *
+ * The hot paths of a model build vectors and matrices that live for one
+ * call: the unpacked parameters and residual scores of a gradient
+ * evaluation, the proposed residual column of an edge move. From the heap
+ * each one is a malloc/free pair, and with many chains on the TBB pool
+ * those calls contend in the allocator. The arena hands them out instead as
+ * non-owning, strict Armadillo views into blocks it owns, by bumping an
+ * offset. A Frame gives back everything taken during its lifetime; reset(),
+ * called by the chain runner before every iteration, rewinds the arena and
+ * merges the blocks the iterations so far needed into one, so that after
+ * the first iterations no call allocates.
+ *
+ * A view is valid until its Frame closes or the arena is reset. Being
+ * strict, it is never resized away from the arena's memory: assigning a
+ * result of another size to it is an error. An arena belongs to one chain
+ * and is used from one thread at a time; copies start empty.
+ */
+class ScratchArena {
+public:
+    ScratchArena() = default;
+    ScratchArena(const ScratchArena&) {}
+    ScratchArena& operator=(const ScratchArena&) { return *this; }
+
+    /** Returns the memory taken during its lifetime when it goes out of scope. */
+    class Frame {
+    public:
+        explicit Frame(ScratchArena& arena)
+            : arena_(arena), block_(arena.block_), used_(arena.used_) {}
+        ~Frame() {
+            arena_.block_ = block_;
+            arena_.used_ = used_;
+        }
+
+        Frame(const Frame&) = delete;
+        Frame& operator=(const Frame&) = delete;
+
+    private:
+        ScratchArena& arena_;
+        std::size_t block_;
+        std::size_t used_;
+    };
+
+    /** @return Uninitialised vector of n elements. */
+    arma::vec vec(arma::uword n) {
+        return arma::vec(take(n), n, false, true);
+    }
+
+    /** @return Uninitialised n_rows x n_cols matrix. */
+    arma::mat mat(arma::uword n_rows, arma::uword n_cols) {
+        return arma::mat(take(n_rows * n_cols), n_rows, n_cols, false, true);
+    }
+
+    /** Rewind, merging the blocks into one of their total size. No Frame may be open. */
+    void reset() {
+        if (blocks_.size() > 1) {
+            const std::size_t total = capacity();
+            blocks_.clear();
+            add_block(total);
+        }
+        block_ = 0;
+        used_ = 0;
+    }
+
+    /** @return Doubles held over all blocks. */
+    std::size_t capacity() const {
+        std::size_t total = 0;
+        for (const Block& block : blocks_) total += block.size;
+        return total;
+    }
+
+private:
+    struct Block {
+        std::unique_ptr<double[]> data;
+        std::size_t size;
+    };
+
+    /// Views start on even offsets, keeping the 16-byte alignment of new[].
+    static constexpr std::size_t alignment = 2;
+    static constexpr std::size_t min_block = 4096;
+
+    double* take(std::size_t n) {
+        n = std::max<std::size_t>(alignment, (n + alignment - 1) / alignment * alignment);
+        while (block_ < blocks_.size() && blocks_[block_].size - used_ < n) {
+            ++block_;
+            used_ = 0;
+        }
+        if (block_ == blocks_.size()) {
+            const std::size_t last = blocks_.empty() ? 0 : blocks_.back().size;
+            add_block(std::max({n, min_block, 2 * last}));
+        }
+        double* out = blocks_[block_].data.get() + used_;
+        used_ += n;
+        return out;
+    }
+
+    void add_block(std::size_t size) {
+        blocks_.push_back(Block{std::unique_ptr<double[]>(new double[size]), size});
+    }
+
+    std::vector<Block> blocks_;
+    std::size_t block_ = 0;  ///< Block the next view is taken from
+    std::size_t used_ = 0;   ///< Doubles taken from that block
+};
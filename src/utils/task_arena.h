@@ -0,0 +1,56 @@
+#pragma once
+
+#include <RcppParallel.h>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#include <algorithm>
+#include <cstddef>
+
+
+/**
+ * Run body() inside a TBB task arena of `num_threads` threads.
+ *
+ * The arena replaces a process-wide tbb::global_control cap. Every loop
+ * started through parallel_for_tasks() in body, including the kernel loops
+ * nested in chain-level tasks, runs in this arena: chain-level and
+ * kernel-level tasks share its threads, and a thread whose chain has
+ * finished steals kernel work from the chains still running. The calling
+ * thread joins the arena and counts towards the budget.
+ *
+ * @param num_threads  Thread budget (<= 0 = all cores)
+ * @param body         Callable without arguments
+ */
+template <typename Body>
+void run_in_arena(int num_threads, Body&& body) {
+  tbb::task_arena arena(num_threads > 0 ? num_threads
+                                        : static_cast<int>(tbb::task_arena::automatic));
+  arena.execute(body);
+}
+
+
+/**
+ * Run worker(begin, end) over chunks of [0, n) in the calling thread's
+ * arena, as RcppParallel::parallelFor does.
+ *
+ * Called outside run_in_arena() the loop uses the default arena (all
+ * cores). The loop is isolated: a thread that waits for its chunks only
+ * picks up chunks of this loop, never an outer task such as another
+ * chain, so a chain never stalls behind a chain its thread took on while
+ * waiting, and chains that wait for each other never share a thread.
+ *
+ * @param n       Number of indices
+ * @param worker  Callable taking a half-open index range (begin, end)
+ * @param grain   Grain size: ranges of up to `grain` indices are not split
+ */
+template <typename Worker>
+void parallel_for_tasks(std::size_t n, Worker& worker, std::size_t grain = 1) {
+  if(n == 0) return;
+  tbb::this_task_arena::isolate([&] {
+    tbb::parallel_for(
+      tbb::blocked_range<std::size_t>(0, n, std::max<std::size_t>(1, grain)),
+      [&worker](const tbb::blocked_range<std::size_t>& range) {
+        worker(range.begin(), range.end());
+      });
+  });
+}
@@ -1,5 +1,7 @@
 #include "utils/variable_helpers.h"
 
+#include <algorithm>
+
 
 // =============================================================================
 // compute_denom_ordinal
@@ -566,3 +568,95 @@ LogZAndProbs compute_logZ_and_probs_blume_capel(
   );
   return out;
 }
+
+
+// =============================================================================
+// compute_logZ_moments_ordinal_tiled
+// =============================================================================
+// The untiled kernel materializes an n x (num_cats+1) probability matrix
+// plus several n-length temporaries per variable, which spill out of cache
+// for large n. Here the same kernel runs on one tile of persons at a time
+// and the tile is reduced immediately, so only E (length n) is written out.
+void compute_logZ_moments_ordinal_tiled(
+    const arma::vec& main_param,
+    const arma::vec& residual_score,
+    const arma::vec& bound,
+    int num_cats,
+    LogZMoments& out,
+    LogZScratch& scratch,
+    const arma::vec* weights
+) {
+  const arma::uword N = residual_score.n_elem;
+
+  out.log_Z_sum = 0.0;
+  out.prob_sums.zeros(num_cats + 1);
+  out.E.set_size(N);
+
+  scratch.score = arma::regspace<arma::vec>(1, num_cats);
+
+  for (arma::uword t0 = 0; t0 < N; t0 += LOGZ_TILE_ROWS) {
+    const arma::uword t1 = std::min(N, t0 + LOGZ_TILE_ROWS) - 1;
+    scratch.r_tile = residual_score.rows(t0, t1);
+    scratch.b_tile = bound.rows(t0, t1);
+
+    compute_logZ_and_probs_ordinal_into(
+      main_param, scratch.r_tile, scratch.b_tile, num_cats,
+      scratch.tile, scratch
+    );
+
+    if (weights) {
+      scratch.w_tile = weights->rows(t0, t1);
+      out.log_Z_sum += arma::dot(scratch.w_tile, scratch.tile.log_Z);
+      out.prob_sums += scratch.tile.probs.t() * scratch.w_tile;
+      out.E.rows(t0, t1) = scratch.w_tile % (scratch.tile.probs.cols(1, num_cats) * scratch.score);
+    } else {
+      out.log_Z_sum += arma::accu(scratch.tile.log_Z);
+      out.prob_sums += arma::sum(scratch.tile.probs, 0).t();
+      out.E.rows(t0, t1) = scratch.tile.probs.cols(1, num_cats) * scratch.score;
+    }
+  }
+}
+
+
+// =============================================================================
+// compute_logZ_moments_blume_capel_tiled
+// =============================================================================
+void compute_logZ_moments_blume_capel_tiled(
+    const arma::vec& residual,
+    const double lin_eff,
+    const double quad_eff,
+    const int ref,
+    const int num_cats,
+    LogZMoments& out,
+    LogZScratch& scratch,
+    const arma::vec* weights
+) {
+  const arma::uword N = residual.n_elem;
+
+  out.log_Z_sum = 0.0;
+  out.prob_sums.zeros(num_cats + 1);
+  out.E.set_size(N);
+
+  scratch.score = arma::regspace<arma::vec>(0, num_cats) - static_cast<double>(ref);
+
+  for (arma::uword t0 = 0; t0 < N; t0 += LOGZ_TILE_ROWS) {
+    const arma::uword t1 = std::min(N, t0 + LOGZ_TILE_ROWS) - 1;
+    scratch.r_tile = residual.rows(t0, t1);
+
+    compute_logZ_and_probs_blume_capel_into(
+      scratch.r_tile, lin_eff, quad_eff, ref, num_cats, scratch.b_tile,
+      scratch.tile, scratch
+    );
+
+    if (weights) {
+      scratch.w_tile = weights->rows(t0, t1);
+      out.log_Z_sum += arma::dot(scratch.w_tile, scratch.tile.log_Z);
+      out.prob_sums += scratch.tile.probs.t() * scratch.w_tile;
+      out.E.rows(t0, t1) = scratch.w_tile % (scratch.tile.probs * scratch.score);
+    } else {
+      out.log_Z_sum += arma::accu(scratch.tile.log_Z);
+      out.prob_sums += arma::sum(scratch.tile.probs, 0).t();
+      out.E.rows(t0, t1) = scratch.tile.probs * scratch.score;
+    }
+  }
+}
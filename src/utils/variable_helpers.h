@@ -36,6 +36,43 @@ struct LogZScratch {
   // Blume-Capel only
   arma::vec cat_vec, centered, theta, exp_theta;
   arma::vec pow_bound_low, pow_bound_high, pow_bound;
+  // Person-tiled kernels: current tile of inputs and outputs
+  arma::vec r_tile, b_tile, w_tile, score;
+  LogZAndProbs tile;
+};
+
+
+/**
+ * Per-variable reductions of the pseudolikelihood normalizer.
+ *
+ * Produced by the person-tiled kernels, which never hold the full
+ * num_persons x (num_cats+1) probability matrix. Everything the gradients
+ * need follows from these: e.g. sum_i E_i = dot(prob_sums, score) and
+ * sum_i E_sq_i = dot(prob_sums, square(score)).
+ */
+struct LogZMoments {
+  /// Sum over persons of the log-normalizer.
+  double log_Z_sum = 0.0;
+  /// Sum over persons of each category probability (num_cats+1).
+  arma::vec prob_sums;
+  /// Expected category score per person (ordinal: c, Blume-Capel: c - ref).
+  arma::vec E;
+};
+
+
+/// Number of persons per tile in the person-tiled kernels. A tile of
+/// probabilities for 10 categories is ~22 KB, so it stays cache resident.
+constexpr arma::uword LOGZ_TILE_ROWS = 256;
+
+
+/**
+ * Output and scratch buffers for one evaluation of a variable's
+ * log-normalizer. Models that evaluate variables on several threads hold
+ * one workspace per block so blocks never share buffers.
+ */
+struct LogZWorkspace {
+  LogZMoments moments;
+  LogZScratch scratch;
 };
 
 
@@ -196,4 +233,42 @@ void compute_logZ_and_probs_blume_capel_into(
     LogZScratch& scratch
 );
 
+/**
+ * Person-tiled log-normalizer and expected scores for an ordinal variable.
+ *
+ * Runs compute_logZ_and_probs_ordinal_into() on LOGZ_TILE_ROWS persons at a
+ * time and reduces each tile while it is still in cache, accumulating
+ * log_Z_sum and prob_sums and writing E = sum_c c * p(c). Per-person values
+ * match the untiled kernel exactly; only the order of the sums differs.
+ *
+ * If `weights` is given, each row stands for weights(i) identical persons
+ * (a compressed response pattern): log_Z_sum and prob_sums are weighted
+ * sums and E(i) is scaled by weights(i), so X^T E stays the full-data sum.
+ */
+void compute_logZ_moments_ordinal_tiled(
+    const arma::vec& main_param,
+    const arma::vec& residual_score,
+    const arma::vec& bound,
+    int num_cats,
+    LogZMoments& out,
+    LogZScratch& scratch,
+    const arma::vec* weights = nullptr
+);
+
+/**
+ * Person-tiled log-normalizer and expected scores for a Blume-Capel
+ * variable. Same contract as compute_logZ_moments_ordinal_tiled(), with
+ * E = sum_c (c - ref) * p(c).
+ */
+void compute_logZ_moments_blume_capel_tiled(
+    const arma::vec& residual,
+    const double lin_eff,
+    const double quad_eff,
+    const int ref,
+    const int num_cats,
+    LogZMoments& out,
+    LogZScratch& scratch,
+    const arma::vec* weights = nullptr
+);
+
 #endif // BGMS_VARIABLE_HELPERS_H
\ No newline at end of file
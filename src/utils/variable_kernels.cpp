@@ -0,0 +1,368 @@
+#include "utils/variable_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace {
+
+constexpr double EXP_BOUND = 709.0;
+
+
+// =============================================================================
+// Ordinal log-normalizer moments, K categories above zero
+// =============================================================================
+// Per tile: exp(r) and exp(-bound) element-wise, then one pass per person
+// over the K categories. A person whose bound leaves the FAST range takes
+// the stabilised direct exponentials of do_safe_block() in
+// compute_logZ_and_probs_ordinal_into(), so tiles never split into runs.
+// K == 1 always takes the clamped form, as the runtime kernel does.
+template <int K>
+void logZ_moments_ordinal_fixed(
+    const arma::vec& main_param,
+    const arma::vec& residual_score,
+    const arma::vec& bound,
+    int /* num_cats */,
+    LogZMoments& out,
+    LogZScratch& scratch,
+    const arma::vec* weights
+) {
+  const arma::uword N = residual_score.n_elem;
+
+  out.log_Z_sum = 0.0;
+  out.prob_sums.zeros(K + 1);
+  out.E.set_size(N);
+
+  scratch.eM = ARMA_MY_EXP(main_param);
+  double eM[K], mp[K];
+  for (int c = 0; c < K; ++c) {
+    eM[c] = scratch.eM[c];
+    mp[c] = main_param[c];
+  }
+  const double FAST_LIM = std::max(0.0, EXP_BOUND - arma::max(arma::abs(main_param)));
+
+  double prob_sums[K + 1] = {};
+
+  for (arma::uword t0 = 0; t0 < N; t0 += LOGZ_TILE_ROWS) {
+    const arma::uword t1 = std::min(N, t0 + LOGZ_TILE_ROWS) - 1;
+    const arma::uword T = t1 - t0 + 1;
+    scratch.r_tile = residual_score.rows(t0, t1);
+    scratch.den.set_size(T);
+    scratch.b_clamp.set_size(T);      // offset added to log(den)
+
+    if constexpr (K == 1) {
+      scratch.b_clamp = arma::clamp(bound.rows(t0, t1), 0.0, arma::datum::inf);
+      scratch.ex      = mp[0] + scratch.r_tile - scratch.b_clamp;
+      scratch.term    = ARMA_MY_EXP(scratch.ex);
+      scratch.eB      = ARMA_MY_EXP(-scratch.b_clamp);
+    } else {
+      scratch.b_tile = bound.rows(t0, t1);
+      scratch.eR     = ARMA_MY_EXP(scratch.r_tile);
+      scratch.eB     = ARMA_MY_EXP(-scratch.b_tile);
+    }
+
+    const double* r  = scratch.r_tile.memptr();
+    const double* bp = scratch.b_tile.memptr();
+    const double* eR = scratch.eR.memptr();
+    const double* eB = scratch.eB.memptr();
+    double* den = scratch.den.memptr();
+    double* off = scratch.b_clamp.memptr();
+
+    for (arma::uword i = 0; i < T; ++i) {
+      double term[K];
+      double d;
+      if constexpr (K == 1) {
+        term[0] = scratch.term[i];
+        d = eB[i] + term[0];
+      } else if (!(bp[i] < -FAST_LIM || bp[i] > FAST_LIM)) {
+        const double e = eB[i];
+        double pw = eR[i];
+        d = e;
+        for (int c = 0; c < K; ++c) {
+          term[c] = eM[c] * pw * e;
+          d += term[c];
+          pw *= eR[i];
+        }
+        off[i] = bp[i];
+      } else {
+        const double bc = std::max(bp[i], 0.0);
+        d = MY_EXP(-bc);
+        for (int c = 0; c < K; ++c) {
+          term[c] = MY_EXP(mp[c] + (c + 1) * r[i] - bc);
+          d += term[c];
+        }
+        off[i] = bc;
+      }
+      den[i] = d;
+
+      const double w = weights ? (*weights)[t0 + i] : 1.0;
+      double p_sum = 0.0, e_sum = 0.0;
+      for (int c = 0; c < K; ++c) {
+        const double p = term[c] / d;
+        prob_sums[c + 1] += w * p;
+        p_sum += p;
+        e_sum += (c + 1) * p;
+      }
+      prob_sums[0] += w * (1.0 - p_sum);
+      out.E[t0 + i] = w * e_sum;
+    }
+
+    scratch.den = ARMA_MY_LOG(scratch.den);
+    const double* log_den = scratch.den.memptr();
+    for (arma::uword i = 0; i < T; ++i) {
+      const double w = weights ? (*weights)[t0 + i] : 1.0;
+      out.log_Z_sum += w * (off[i] + log_den[i]);
+    }
+  }
+
+  for (int c = 0; c <= K; ++c) out.prob_sums[c] = prob_sums[c];
+}
+
+
+// =============================================================================
+// Blume-Capel log-normalizer moments, categories 0..K
+// =============================================================================
+// Same bounds as compute_logZ_and_probs_blume_capel_into(); the bound b and
+// the start of the power chain are formed per person before the tile's
+// exponentials are taken.
+template <int K>
+void logZ_moments_blume_capel_fixed(
+    const arma::vec& residual,
+    const double lin_eff,
+    const double quad_eff,
+    const int ref,
+    int /* num_cats */,
+    LogZMoments& out,
+    LogZScratch& scratch,
+    const arma::vec* weights
+) {
+  const arma::uword N = residual.n_elem;
+
+  out.log_Z_sum = 0.0;
+  out.prob_sums.zeros(K + 1);
+  out.E.set_size(N);
+
+  // theta through the same arma expressions as the runtime kernel
+  scratch.cat_vec = arma::regspace<arma::vec>(0, K);
+  scratch.centered  = scratch.cat_vec - double(ref);
+  scratch.theta     = lin_eff * scratch.centered + quad_eff * arma::square(scratch.centered);
+  scratch.exp_theta = ARMA_MY_EXP(scratch.theta);
+
+  double theta[K + 1], exp_theta[K + 1], centered[K + 1];
+  for (int c = 0; c <= K; ++c) {
+    theta[c]     = scratch.theta[c];
+    exp_theta[c] = scratch.exp_theta[c];
+    centered[c]  = scratch.centered[c];
+  }
+  const double THETA_LIM = std::max(0.0, EXP_BOUND - arma::max(arma::abs(scratch.theta)));
+
+  double prob_sums[K + 1] = {};
+
+  for (arma::uword t0 = 0; t0 < N; t0 += LOGZ_TILE_ROWS) {
+    const arma::uword t1 = std::min(N, t0 + LOGZ_TILE_ROWS) - 1;
+    const arma::uword T = t1 - t0 + 1;
+    scratch.r_tile = residual.rows(t0, t1);
+    scratch.b_tile.set_size(T);
+    scratch.ex.set_size(T);
+    scratch.den.set_size(T);
+
+    const double* r = scratch.r_tile.memptr();
+    double* bp = scratch.b_tile.memptr();
+    double* ex = scratch.ex.memptr();
+    for (arma::uword i = 0; i < T; ++i) {
+      double b = theta[0] + centered[0] * r[i];
+      for (int c = 1; c <= K; ++c) b = std::max(b, theta[c] + centered[c] * r[i]);
+      bp[i] = b;
+      ex[i] = double(-ref) * r[i] - b;
+    }
+
+    scratch.eR      = ARMA_MY_EXP(scratch.r_tile);
+    scratch.pow_buf = ARMA_MY_EXP(scratch.ex);
+    const double* eR  = scratch.eR.memptr();
+    const double* pw0 = scratch.pow_buf.memptr();
+    double* den = scratch.den.memptr();
+
+    for (arma::uword i = 0; i < T; ++i) {
+      const double pow_bound = std::max(std::abs(ex[i]),
+                                        std::abs(double(K - ref) * r[i] - bp[i]));
+      double term[K + 1];
+      double d;
+      if (std::abs(bp[i]) <= EXP_BOUND && pow_bound <= THETA_LIM) {
+        double pw = pw0[i];
+        term[0] = exp_theta[0] * pw;
+        d = term[0];
+        for (int c = 1; c <= K; ++c) {
+          pw *= eR[i];
+          term[c] = exp_theta[c] * pw;
+          d += term[c];
+        }
+      } else {
+        d = 0.0;
+        for (int c = 0; c <= K; ++c) {
+          term[c] = MY_EXP(theta[c] + centered[c] * r[i] - bp[i]);
+          d += term[c];
+        }
+      }
+      den[i] = d;
+
+      const double w = weights ? (*weights)[t0 + i] : 1.0;
+      double e_sum = 0.0;
+      for (int c = 0; c <= K; ++c) {
+        const double p = term[c] / d;
+        prob_sums[c] += w * p;
+        e_sum += centered[c] * p;
+      }
+      out.E[t0 + i] = w * e_sum;
+    }
+
+    scratch.den = ARMA_MY_LOG(scratch.den);
+    const double* log_den = scratch.den.memptr();
+    for (arma::uword i = 0; i < T; ++i) {
+      const double w = weights ? (*weights)[t0 + i] : 1.0;
+      out.log_Z_sum += w * (bp[i] + log_den[i]);
+    }
+  }
+
+  for (int c = 0; c <= K; ++c) out.prob_sums[c] = prob_sums[c];
+}
+
+
+// =============================================================================
+// Ordinal denominator, K >= 2 categories above zero
+// =============================================================================
+template <int K>
+arma::vec denom_ordinal_fixed(
+    const arma::vec& residual,
+    const arma::vec& main_eff,
+    const arma::vec& bound
+) {
+  const arma::uword N = bound.n_elem;
+  arma::vec denom(N, arma::fill::none);
+
+  const arma::vec eM_vec = ARMA_MY_EXP(main_eff);
+  double eM[K], mp[K];
+  for (int c = 0; c < K; ++c) {
+    eM[c] = eM_vec[c];
+    mp[c] = main_eff[c];
+  }
+
+  const arma::vec eR_vec = ARMA_MY_EXP(residual);
+  const arma::vec eB_vec = ARMA_MY_EXP(-bound);
+  const double* r  = residual.memptr();
+  const double* bp = bound.memptr();
+  const double* eR = eR_vec.memptr();
+  const double* eB = eB_vec.memptr();
+
+  for (arma::uword i = 0; i < N; ++i) {
+    double d;
+    if (!(bp[i] < -EXP_BOUND || bp[i] > EXP_BOUND)) {
+      const double e = eB[i];
+      double pw = eR[i];
+      d = e;
+      for (int c = 0; c < K; ++c) {
+        d += eM[c] * pw * e;
+        pw *= eR[i];
+      }
+    } else {
+      d = MY_EXP(-bp[i]);
+      for (int c = 0; c < K; ++c) d += MY_EXP(mp[c] + (c + 1) * r[i] - bp[i]);
+    }
+    denom[i] = d;
+  }
+  return denom;
+}
+
+
+// =============================================================================
+// Blume-Capel denominator, categories 0..K
+// =============================================================================
+template <int K>
+arma::vec denom_blume_capel_fixed(
+    const arma::vec& residual,
+    const double lin_eff,
+    const double quad_eff,
+    const int ref,
+    int /* num_cats */,
+    arma::vec& b
+) {
+  const arma::uword N = residual.n_elem;
+  arma::vec denom(N, arma::fill::none);
+
+  const arma::vec cat = arma::regspace<arma::vec>(0, K);
+  const arma::vec centered_vec = cat - double(ref);
+  const arma::vec theta_vec = lin_eff * centered_vec + quad_eff * arma::square(centered_vec);
+  const arma::vec exp_theta_vec = ARMA_MY_EXP(theta_vec);
+
+  double theta[K + 1], exp_theta[K + 1], centered[K + 1];
+  for (int c = 0; c <= K; ++c) {
+    theta[c]     = theta_vec[c];
+    exp_theta[c] = exp_theta_vec[c];
+    centered[c]  = centered_vec[c];
+  }
+
+  const double* r = residual.memptr();
+  b.set_size(N);
+  arma::vec ex(N, arma::fill::none);
+  for (arma::uword i = 0; i < N; ++i) {
+    double bi = theta[0] + centered[0] * r[i];
+    for (int c = 1; c <= K; ++c) bi = std::max(bi, theta[c] + centered[c] * r[i]);
+    b[i] = bi;
+    ex[i] = double(-ref) * r[i] - bi;
+  }
+
+  const arma::vec eR_vec = ARMA_MY_EXP(residual);
+  const arma::vec pow_vec = ARMA_MY_EXP(ex);
+  const double* eR = eR_vec.memptr();
+  const double* pw0 = pow_vec.memptr();
+
+  for (arma::uword i = 0; i < N; ++i) {
+    const double pow_bound = std::max(std::abs(ex[i]),
+                                      std::abs(double(K - ref) * r[i] - b[i]));
+    double d;
+    if (std::abs(b[i]) <= EXP_BOUND && pow_bound <= EXP_BOUND) {
+      double pw = pw0[i];
+      d = exp_theta[0] * pw;
+      for (int c = 1; c <= K; ++c) {
+        pw *= eR[i];
+        d += exp_theta[c] * pw;
+      }
+    } else {
+      d = 0.0;
+      for (int c = 0; c <= K; ++c) d += MY_EXP(theta[c] + centered[c] * r[i] - b[i]);
+    }
+    denom[i] = d;
+  }
+  return denom;
+}
+
+
+template <int K>
+LogZKernels fixed_kernels() {
+  LogZKernels kernels;
+  kernels.ordinal_moments = logZ_moments_ordinal_fixed<K>;
+  kernels.blume_capel_moments = logZ_moments_blume_capel_fixed<K>;
+  // The runtime binary denominator is already a single vector expression
+  if constexpr (K > 1) kernels.ordinal_denom = denom_ordinal_fixed<K>;
+  kernels.blume_capel_denom = denom_blume_capel_fixed<K>;
+  return kernels;
+}
+
+} // namespace
+
+
+// =============================================================================
+// select_logz_kernels
+// =============================================================================
+LogZKernels select_logz_kernels(int num_cats) {
+  static_assert(LOGZ_MAX_FIXED_CATS == 7, "extend the switch below");
+  switch (num_cats) {
+    case 1: return fixed_kernels<1>();
+    case 2: return fixed_kernels<2>();
+    case 3: return fixed_kernels<3>();
+    case 4: return fixed_kernels<4>();
+    case 5: return fixed_kernels<5>();
+    case 6: return fixed_kernels<6>();
+    case 7: return fixed_kernels<7>();
+    default: return LogZKernels();
+  }
+}
@@ -0,0 +1,58 @@
+#ifndef BGMS_VARIABLE_KERNELS_H
+#define BGMS_VARIABLE_KERNELS_H
+
+#include <RcppArmadillo.h>
+#include "utils/variable_helpers.h"
+
+
+/// Largest category count with a compile-time specialised kernel.
+constexpr int LOGZ_MAX_FIXED_CATS = 7;
+
+
+/**
+ * LogZKernels - Log-normalizer kernels for one variable
+ *
+ * The runtime-count kernels in variable_helpers.h sweep the persons once per
+ * category and keep every intermediate in a person-length buffer. For
+ * num_cats <= LOGZ_MAX_FIXED_CATS, select_logz_kernels() returns versions
+ * instantiated with the category count as a template parameter instead:
+ * the exponentials of a person tile are still taken with the element-wise
+ * kernels, but the category loop then runs once per person with its terms
+ * and accumulators on the stack, and the compiler unrolls it. They use the
+ * same FAST/SAFE bounds as the runtime kernels and agree with them to
+ * rounding. Models select the kernels once per variable at construction.
+ *
+ * The pointers take the arguments of the functions they default to;
+ * the moments kernels take `weights` explicitly (nullptr for none).
+ */
+struct LogZKernels {
+  using OrdinalMoments = void (*)(
+      const arma::vec& main_param, const arma::vec& residual_score,
+      const arma::vec& bound, int num_cats, LogZMoments& out,
+      LogZScratch& scratch, const arma::vec* weights);
+  using BlumeCapelMoments = void (*)(
+      const arma::vec& residual, double lin_eff, double quad_eff, int ref,
+      int num_cats, LogZMoments& out, LogZScratch& scratch,
+      const arma::vec* weights);
+  using OrdinalDenom = arma::vec (*)(
+      const arma::vec& residual, const arma::vec& main_eff,
+      const arma::vec& bound);
+  using BlumeCapelDenom = arma::vec (*)(
+      const arma::vec& residual, double lin_eff, double quad_eff, int ref,
+      int num_cats, arma::vec& b);
+
+  OrdinalMoments ordinal_moments = compute_logZ_moments_ordinal_tiled;
+  BlumeCapelMoments blume_capel_moments = compute_logZ_moments_blume_capel_tiled;
+  OrdinalDenom ordinal_denom = compute_denom_ordinal;
+  BlumeCapelDenom blume_capel_denom = compute_denom_blume_capel;
+};
+
+
+/**
+ * Kernels for a variable with `num_cats` categories above the lowest:
+ * the specialised ones for 1 <= num_cats <= LOGZ_MAX_FIXED_CATS, the
+ * runtime-count ones otherwise.
+ */
+LogZKernels select_logz_kernels(int num_cats);
+
+#endif // BGMS_VARIABLE_KERNELS_H